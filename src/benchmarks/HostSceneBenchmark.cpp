@@ -0,0 +1,397 @@
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "benchmark/benchmark.h"
+#include "HostScene.hpp"
+#include "HostRenderer.hpp"
+#include "StressScene.hpp"
+
+
+namespace
+{
+
+
+// a sphere-ish mesh tessellated into this many triangles per ship
+constexpr unsigned shipRings    = 64;
+constexpr unsigned shipSegments = 128;
+
+constexpr unsigned raysPerIteration = 1 << 16;
+
+
+///
+/// \brief buildFleet
+///
+///        One tessellated mesh and 'count' instances of it laid
+///        out on a grid, the case instancing is meant for
+///
+light::SceneDescription
+buildFleet( unsigned count )
+{
+
+  const float pi = 3.14159265358979323846f;
+
+  std::vector< light::Float3 > vertices;
+  std::vector< std::uint32_t > triangles;
+
+  for ( unsigned ring = 0; ring <= shipRings; ++ring )
+  {
+
+    float theta = pi * ring / shipRings;
+
+    for ( unsigned segment = 0; segment <= shipSegments; ++segment )
+    {
+
+      float phi = 2.0f * pi * segment / shipSegments;
+
+      vertices.push_back( light::Float3 {
+                            std::sin( theta ) * std::cos( phi ) * 2.0f,
+                            std::cos( theta ) * 0.5f,
+                            std::sin( theta ) * std::sin( phi )
+                          } );
+
+    }
+
+  }
+
+  for ( unsigned ring = 0; ring < shipRings; ++ring )
+  {
+
+    for ( unsigned segment = 0; segment < shipSegments; ++segment )
+    {
+
+      std::uint32_t i0 = ring * ( shipSegments + 1 ) + segment;
+      std::uint32_t i1 = i0 + shipSegments + 1;
+
+      triangles.insert( triangles.end( ), { i0, i1, i0 + 1 } );
+      triangles.insert( triangles.end( ), { i0 + 1, i1, i1 + 1 } );
+
+    }
+
+  }
+
+  light::SceneDescription scene;
+
+  std::uint32_t mesh     = scene.addMesh( vertices, { }, triangles );
+  std::uint32_t material = scene.addMaterial( { 0.5f, 0.5f, 0.5f }, 0.3f, { 1.5f, 1.5f, 1.5f } );
+  std::uint32_t ship     = scene.addShape( "ship", { mesh }, material, light::makeTransform( ), light::AccelHint::BVH );
+
+  unsigned side = static_cast< unsigned >( std::ceil( std::sqrt( static_cast< float >( count ) ) ) );
+
+  for ( unsigned i = 1; i < count; ++i )
+  {
+
+    scene.addInstance(
+                      "ship " + std::to_string( i ),
+                      ship,
+                      material,
+                      light::makeTransform(
+                                           { static_cast< float >( i % side ) * 5.0f, 0.0f, static_cast< float >( i / side ) * 3.0f },
+                                           { 1.0f, 1.0f, 1.0f },
+                                           0.1f * static_cast< float >( i ),
+                                           { 0.0f, 1.0f, 0.0f }
+                                           )
+                      );
+
+  }
+
+  return scene;
+
+}
+
+
+} // namespace
+
+
+
+////////////////////////////////////////////////////////////////
+/// \brief BM_FleetBuild
+///
+///        Builds both BVH levels for a fleet of instances.
+///        range( 0 ) - instance count
+////////////////////////////////////////////////////////////////
+static
+void
+BM_FleetBuild( benchmark::State &state )
+{
+
+  light::SceneDescription fleet = buildFleet( static_cast< unsigned >( state.range( 0 ) ) );
+
+  std::size_t bytes = 0;
+
+  for ( auto _ : state )
+  {
+
+    light::HostScene scene( fleet );
+    bytes = scene.getAccelerationBytes( );
+    benchmark::DoNotOptimize( bytes );
+
+  }
+
+  state.counters[ "accelMB" ] = static_cast< double >( bytes ) / ( 1024.0 * 1024.0 );
+
+} // BM_FleetBuild
+
+
+BENCHMARK( BM_FleetBuild )
+  ->ArgName( "instances" )
+  ->Arg( 1 )->Arg( 100 )->Arg( 10000 )
+  ->Unit( benchmark::kMillisecond );
+
+
+
+////////////////////////////////////////////////////////////////
+/// \brief BM_FleetTrace
+///
+///        Closest hit rays fired down onto the fleet.
+///        range( 0 ) - instance count
+////////////////////////////////////////////////////////////////
+static
+void
+BM_FleetTrace( benchmark::State &state )
+{
+
+  unsigned count = static_cast< unsigned >( state.range( 0 ) );
+
+  light::HostScene scene( buildFleet( count ) );
+
+  float side = std::ceil( std::sqrt( static_cast< float >( count ) ) );
+
+  std::uint32_t hash = 1234;
+  unsigned      hits = 0;
+
+  for ( auto _ : state )
+  {
+
+    for ( unsigned i = 0; i < raysPerIteration; ++i )
+    {
+
+      hash = hash * 1664525u + 1013904223u;
+      float u = static_cast< float >( hash >> 8 ) / 16777216.0f;
+      hash = hash * 1664525u + 1013904223u;
+      float v = static_cast< float >( hash >> 8 ) / 16777216.0f;
+
+      light::HostRay ray = {
+        { u * side * 5.0f - 2.0f, 10.0f, v * side * 3.0f - 1.0f },
+        { 0.0f, -1.0f, 0.0f },
+        0.0f,
+        1e30f
+      };
+
+      light::HostHit hit;
+      hits += scene.intersect( ray, &hit ) ? 1 : 0;
+
+    }
+
+    benchmark::DoNotOptimize( hits );
+
+  }
+
+  state.counters[ "rays/s" ] = benchmark::Counter(
+                                                  raysPerIteration,
+                                                  benchmark::Counter::kIsIterationInvariantRate
+                                                  );
+
+} // BM_FleetTrace
+
+
+BENCHMARK( BM_FleetTrace )
+  ->ArgName( "instances" )
+  ->Arg( 1 )->Arg( 100 )->Arg( 10000 )
+  ->Unit( benchmark::kMillisecond );
+
+
+
+////////////////////////////////////////////////////////////////
+/// \brief BM_FleetAnimate
+///
+///        Moves every instance a little and updates the top
+///        level, by refit or by forcing a rebuild each frame.
+///        range( 0 ) - instance count
+///        range( 1 ) - 1 to refit, 0 to rebuild
+///        range( 2 ) - refit threads
+////////////////////////////////////////////////////////////////
+static
+void
+BM_FleetAnimate( benchmark::State &state )
+{
+
+  unsigned count = static_cast< unsigned >( state.range( 0 ) );
+
+  light::HostScene   scene( buildFleet( count ) );
+  light::SceneEditor editor = scene.createSceneEditor( );
+
+  // a threshold of zero rebuilds after every refit
+  scene.setRebuildThreshold( state.range( 1 ) ? 1e30f : 0.0f );
+
+  std::vector< light::Transform > start = scene.getSceneDescription( ).getTransforms( );
+  const std::vector< light::ShapeRecord > &shapes = scene.getSceneDescription( ).getShapes( );
+
+  unsigned frame = 0;
+
+  for ( auto _ : state )
+  {
+
+    state.PauseTiming( );
+
+    ++frame;
+
+    for ( const light::ShapeRecord &shape : shapes )
+    {
+
+      light::Transform moved = start[ shape.transform ];
+      moved.m[ 7 ] += 0.01f * static_cast< float >( ( frame + shape.transform ) % 100 );
+
+      editor.setTransform( shape.transform, moved );
+
+    }
+
+    light::SceneChanges changes = editor.takeChanges( );
+
+    state.ResumeTiming( );
+
+    scene.applySceneChanges( changes, static_cast< unsigned >( state.range( 2 ) ) );
+
+  }
+
+  state.counters[ "costGrowth" ] = scene.getTopLevelCostGrowth( );
+
+} // BM_FleetAnimate
+
+
+BENCHMARK( BM_FleetAnimate )
+  ->ArgNames( { "instances", "refit", "threads" } )
+  ->Args( { 10000,  0, 1 } )
+  ->Args( { 10000,  1, 1 } )
+  ->Args( { 10000,  1, 4 } )
+  ->Args( { 100000, 0, 1 } )
+  ->Args( { 100000, 1, 1 } )
+  ->Args( { 100000, 1, 4 } )
+  ->UseRealTime( )
+  ->Unit( benchmark::kMicrosecond );
+
+
+
+////////////////////////////////////////////////////////////////
+/// \brief stressOptions
+///
+///        Generated scene with 'objects' analytic primitives and
+///        a tenth as many mesh instances. The material count stays
+///        fixed, since each material adds a shape spanning the
+///        whole scene that every ray has to enter.
+////////////////////////////////////////////////////////////////
+static
+light::StressSceneOptions
+stressOptions( std::int64_t objects )
+{
+
+  light::StressSceneOptions options;
+
+  options.spheres       = static_cast< unsigned >( objects * 4 / 10 );
+  options.boxes         = static_cast< unsigned >( objects * 4 / 10 );
+  options.quads         = static_cast< unsigned >( objects * 2 / 10 );
+  options.meshInstances = static_cast< unsigned >( objects / 10 );
+  options.illuminators  = 4;
+  options.seed          = 7;
+
+  return options;
+
+}
+
+
+
+////////////////////////////////////////////////////////////////
+/// \brief BM_StressBuild
+///
+///        Builds both BVH levels of a generated scene.
+///        range( 0 ) - analytic primitive count
+////////////////////////////////////////////////////////////////
+static
+void
+BM_StressBuild( benchmark::State &state )
+{
+
+  light::SceneDescription scene = light::buildStressScene( stressOptions( state.range( 0 ) ) );
+
+  std::size_t bytes = 0;
+
+  for ( auto _ : state )
+  {
+
+    light::HostScene hostScene( scene );
+    bytes = hostScene.getAccelerationBytes( );
+    benchmark::DoNotOptimize( bytes );
+
+  }
+
+  state.counters[ "accelMB" ]    = static_cast< double >( bytes ) / ( 1024.0 * 1024.0 );
+  state.counters[ "geometryMB" ] = static_cast< double >( scene.getMemoryBytes( ) ) / ( 1024.0 * 1024.0 );
+
+} // BM_StressBuild
+
+
+BENCHMARK( BM_StressBuild )
+  ->ArgName( "objects" )
+  ->RangeMultiplier( 10 )->Range( 100, 100000 )
+  ->Unit( benchmark::kMillisecond );
+
+
+
+////////////////////////////////////////////////////////////////
+/// \brief BM_StressRender
+///
+///        Direct lighting of a generated scene on the host.
+///        range( 0 ) - analytic primitive count
+///        range( 1 ) - illuminator count
+////////////////////////////////////////////////////////////////
+static
+void
+BM_StressRender( benchmark::State &state )
+{
+
+  light::StressSceneOptions options = stressOptions( state.range( 0 ) );
+  options.illuminators = static_cast< unsigned >( state.range( 1 ) );
+
+  light::HostScene    scene( light::buildStressScene( options ) );
+  light::HostRenderer renderer( scene, 160, 90 );
+
+  // looking down at the objects from above one corner
+  renderer.setCamera(
+                     light::Float3 { 0.0f, 40.0f, 60.0f },
+                     light::Float3 { 0.8f, 0.0f, 0.0f },
+                     light::Float3 { 0.0f, 0.4f, 0.2f },
+                     light::Float3 { 0.0f, -0.5f, -1.0f }
+                     );
+
+  light::HostRenderSettings settings;
+  settings.numThreads = 1;
+
+  std::uint64_t samples = 0;
+
+  for ( auto _ : state )
+  {
+
+    samples = renderer.render( settings ).samples;
+
+  }
+
+  state.counters[ "samples/s" ] = benchmark::Counter(
+                                                     static_cast< double >( samples ),
+                                                     benchmark::Counter::kIsIterationInvariantRate
+                                                     );
+
+} // BM_StressRender
+
+
+BENCHMARK( BM_StressRender )
+  ->ArgNames( { "objects", "lights" } )
+  ->Args( { 100,   4 } )
+  ->Args( { 1000,  4 } )
+  ->Args( { 10000, 4 } )
+  ->Args( { 1000,  1 } )
+  ->Args( { 1000,  16 } )
+  ->Unit( benchmark::kMillisecond );
+
+
+
+BENCHMARK_MAIN( );
@@ -0,0 +1,466 @@
+#include <cmath>
+#include <vector>
+#include <cstdint>
+#include "benchmark/benchmark.h"
+#include "Sampling.hpp"
+#include "SimdKernels.hpp"
+
+
+namespace
+{
+
+
+// a bounce's worth of samples for a 512x512 image
+constexpr std::size_t sampleCount = 512 * 512;
+
+
+struct Vector
+{
+  float x, y, z;
+};
+
+
+///
+/// \brief The Inputs struct
+///
+///        Uniform numbers, unit normals and view directions on
+///        the normals' side, as separate arrays for the batched
+///        kernels
+///
+struct Inputs
+{
+  std::vector< float > u1, u2, cosMax, alpha;
+  std::vector< float > nx, ny, nz, vx, vy, vz;
+};
+
+
+const Inputs &
+getInputs( )
+{
+
+  static Inputs inputs;
+
+  if ( inputs.u1.empty( ) )
+  {
+
+    std::uint32_t seed = 1u;
+
+    auto rand = [ &seed ]( )
+    {
+
+      seed = seed * 1664525u + 1013904223u;
+
+      return static_cast< float >( seed >> 8 ) / 16777216.0f;
+
+    };
+
+    for ( std::size_t i = 0; i < sampleCount; ++i )
+    {
+
+      inputs.u1.push_back( rand( ) );
+      inputs.u2.push_back( rand( ) );
+      inputs.cosMax.push_back( 0.5f + 0.49f * rand( ) );
+      inputs.alpha.push_back( 0.05f + rand( ) );
+
+      Vector n = sampleUniformSphere< Vector >( rand( ), rand( ) );
+      Vector v = alignToNormal( sampleCosineHemisphere< Vector >( rand( ), rand( ) ), n );
+
+      inputs.nx.push_back( n.x );
+      inputs.ny.push_back( n.y );
+      inputs.nz.push_back( n.z );
+      inputs.vx.push_back( v.x );
+      inputs.vy.push_back( v.y );
+      inputs.vz.push_back( v.z );
+
+    }
+
+  }
+
+  return inputs;
+
+}
+
+
+///
+/// \brief The Outputs struct
+///
+struct Outputs
+{
+  std::vector< float > x, y, z, pdf;
+
+  Outputs( ) : x( sampleCount ), y( sampleCount ), z( sampleCount ), pdf( sampleCount ) {}
+
+  light::SimdVectors vectors( ) { return light::SimdVectors{ x.data( ), y.data( ), z.data( ) }; }
+};
+
+
+light::SimdConstVectors
+normals( const Inputs &inputs )
+{
+
+  return light::SimdConstVectors{ inputs.nx.data( ), inputs.ny.data( ), inputs.nz.data( ) };
+
+}
+
+
+///
+/// \brief crossBasis
+///
+///        The basis Brdf.cu used before orthonormalBasis: two
+///        cross products, a branch and a normalize
+///
+void
+crossBasis(
+           const Vector &n,
+           Vector       &u,
+           Vector       &v
+           )
+{
+
+  u = Vector{ -n.z, 0.0f, n.x }; // n x ( 0, 1, 0 )
+
+  if ( u.x * u.x + u.y * u.y + u.z * u.z < 1e-3f )
+  {
+    u = Vector{ 0.0f, n.z, -n.y }; // n x ( 1, 0, 0 )
+  }
+
+  float scale = 1.0f / std::sqrt( u.x * u.x + u.y * u.y + u.z * u.z );
+
+  u = Vector{ u.x * scale, u.y * scale, u.z * scale };
+  v = Vector{ n.y * u.z - n.z * u.y, n.z * u.x - n.x * u.z, n.x * u.y - n.y * u.x };
+
+}
+
+
+const light::SimdKernels *
+getKernels( benchmark::State &state )
+{
+
+  light::SimdIsa isa = static_cast< light::SimdIsa >( state.range( 0 ) );
+
+  if ( !light::isSimdIsaSupported( isa ) )
+  {
+
+    state.SkipWithError( ( light::toString( isa ) + " isn't supported on this CPU" ).c_str( ) );
+    return nullptr;
+
+  }
+
+  state.SetLabel( light::toString( isa ) );
+
+  return &light::getSimdKernels( isa );
+
+}
+
+
+void
+addSampleRate( benchmark::State &state )
+{
+
+  state.counters[ "samples/s" ] = benchmark::Counter(
+                                                     static_cast< double >( sampleCount ),
+                                                     benchmark::Counter::kIsIterationInvariantRate
+                                                     );
+
+}
+
+
+} // namespace
+
+
+
+////////////////////////////////////////////////////////////////
+/// \brief BM_Basis
+///
+///        Tangents for every normal.
+///
+///        range( 0 ) - 0 for the old cross product basis, 1 for
+///                     orthonormalBasis
+////////////////////////////////////////////////////////////////
+static
+void
+BM_Basis( benchmark::State &state )
+{
+
+  const Inputs &inputs = getInputs( );
+  bool          duff   = state.range( 0 ) != 0;
+
+  state.SetLabel( duff ? "branchless" : "cross products" );
+
+  Outputs tangents;
+
+  for ( auto _ : state )
+  {
+
+    for ( std::size_t i = 0; i < sampleCount; ++i )
+    {
+
+      Vector n = { inputs.nx[ i ], inputs.ny[ i ], inputs.nz[ i ] };
+      Vector b1, b2;
+
+      if ( duff )
+      {
+        orthonormalBasis( n, b1, b2 );
+      }
+      else
+      {
+        crossBasis( n, b1, b2 );
+      }
+
+      tangents.x[ i ] = b1.x + b2.x;
+      tangents.y[ i ] = b1.y + b2.y;
+      tangents.z[ i ] = b1.z + b2.z;
+
+    }
+
+    benchmark::DoNotOptimize( tangents.x.data( ) );
+    benchmark::ClobberMemory( );
+
+  }
+
+  addSampleRate( state );
+
+} // BM_Basis
+
+
+
+////////////////////////////////////////////////////////////////
+/// \brief BM_ScalarCosineHemisphere
+///
+///        One sample at a time, the way the device programs
+///        sample diffuse bounces.
+////////////////////////////////////////////////////////////////
+static
+void
+BM_ScalarCosineHemisphere( benchmark::State &state )
+{
+
+  const Inputs &inputs = getInputs( );
+  Outputs       outputs;
+
+  for ( auto _ : state )
+  {
+
+    for ( std::size_t i = 0; i < sampleCount; ++i )
+    {
+
+      Vector n     = { inputs.nx[ i ], inputs.ny[ i ], inputs.nz[ i ] };
+      Vector local = sampleCosineHemisphere< Vector >( inputs.u1[ i ], inputs.u2[ i ] );
+      Vector w     = alignToNormal( local, n );
+
+      outputs.x[ i ]   = w.x;
+      outputs.y[ i ]   = w.y;
+      outputs.z[ i ]   = w.z;
+      outputs.pdf[ i ] = cosineHemispherePdf( local.z );
+
+    }
+
+    benchmark::DoNotOptimize( outputs.x.data( ) );
+    benchmark::ClobberMemory( );
+
+  }
+
+  addSampleRate( state );
+
+} // BM_ScalarCosineHemisphere
+
+
+
+////////////////////////////////////////////////////////////////
+/// \brief BM_BatchCosineHemisphere
+///
+///        range( 0 ) - SimdIsa
+////////////////////////////////////////////////////////////////
+static
+void
+BM_BatchCosineHemisphere( benchmark::State &state )
+{
+
+  const light::SimdKernels *pKernels = getKernels( state );
+
+  if ( !pKernels )
+  {
+    return;
+  }
+
+  const Inputs &inputs = getInputs( );
+  Outputs       outputs;
+
+  for ( auto _ : state )
+  {
+
+    pKernels->sampleCosineHemisphere(
+                                     inputs.u1.data( ),
+                                     inputs.u2.data( ),
+                                     normals( inputs ),
+                                     sampleCount,
+                                     outputs.vectors( ),
+                                     outputs.pdf.data( )
+                                     );
+
+    benchmark::DoNotOptimize( outputs.x.data( ) );
+    benchmark::ClobberMemory( );
+
+  }
+
+  addSampleRate( state );
+
+} // BM_BatchCosineHemisphere
+
+
+
+////////////////////////////////////////////////////////////////
+/// \brief BM_BatchUniformSphere
+///
+///        range( 0 ) - SimdIsa
+////////////////////////////////////////////////////////////////
+static
+void
+BM_BatchUniformSphere( benchmark::State &state )
+{
+
+  const light::SimdKernels *pKernels = getKernels( state );
+
+  if ( !pKernels )
+  {
+    return;
+  }
+
+  const Inputs &inputs = getInputs( );
+  Outputs       outputs;
+
+  for ( auto _ : state )
+  {
+
+    pKernels->sampleUniformSphere( inputs.u1.data( ), inputs.u2.data( ), sampleCount, outputs.vectors( ) );
+
+    benchmark::DoNotOptimize( outputs.x.data( ) );
+    benchmark::ClobberMemory( );
+
+  }
+
+  addSampleRate( state );
+
+} // BM_BatchUniformSphere
+
+
+
+////////////////////////////////////////////////////////////////
+/// \brief BM_BatchUniformCone
+///
+///        range( 0 ) - SimdIsa
+////////////////////////////////////////////////////////////////
+static
+void
+BM_BatchUniformCone( benchmark::State &state )
+{
+
+  const light::SimdKernels *pKernels = getKernels( state );
+
+  if ( !pKernels )
+  {
+    return;
+  }
+
+  const Inputs &inputs = getInputs( );
+  Outputs       outputs;
+
+  for ( auto _ : state )
+  {
+
+    pKernels->sampleUniformCone(
+                                inputs.u1.data( ),
+                                inputs.u2.data( ),
+                                inputs.cosMax.data( ),
+                                normals( inputs ),
+                                sampleCount,
+                                outputs.vectors( ),
+                                outputs.pdf.data( )
+                                );
+
+    benchmark::DoNotOptimize( outputs.x.data( ) );
+    benchmark::ClobberMemory( );
+
+  }
+
+  addSampleRate( state );
+
+} // BM_BatchUniformCone
+
+
+
+////////////////////////////////////////////////////////////////
+/// \brief BM_BatchGgxVndf
+///
+///        range( 0 ) - SimdIsa
+////////////////////////////////////////////////////////////////
+static
+void
+BM_BatchGgxVndf( benchmark::State &state )
+{
+
+  const light::SimdKernels *pKernels = getKernels( state );
+
+  if ( !pKernels )
+  {
+    return;
+  }
+
+  const Inputs &inputs = getInputs( );
+  Outputs       outputs;
+
+  for ( auto _ : state )
+  {
+
+    pKernels->sampleGgxVndf(
+                            inputs.u1.data( ),
+                            inputs.u2.data( ),
+                            inputs.alpha.data( ),
+                            normals( inputs ),
+                            light::SimdConstVectors{ inputs.vx.data( ), inputs.vy.data( ), inputs.vz.data( ) },
+                            sampleCount,
+                            outputs.vectors( ),
+                            outputs.pdf.data( )
+                            );
+
+    benchmark::DoNotOptimize( outputs.x.data( ) );
+    benchmark::ClobberMemory( );
+
+  }
+
+  addSampleRate( state );
+
+} // BM_BatchGgxVndf
+
+
+BENCHMARK( BM_Basis )
+  ->ArgName( "branchless" )
+  ->DenseRange( 0, 1 )
+  ->Unit( benchmark::kMicrosecond );
+
+BENCHMARK( BM_ScalarCosineHemisphere )
+  ->Unit( benchmark::kMicrosecond );
+
+BENCHMARK( BM_BatchCosineHemisphere )
+  ->ArgName( "isa" )
+  ->DenseRange( static_cast< long >( light::SimdIsa::SCALAR ), static_cast< long >( light::SimdIsa::AVX512 ) )
+  ->Unit( benchmark::kMicrosecond );
+
+BENCHMARK( BM_BatchUniformSphere )
+  ->ArgName( "isa" )
+  ->DenseRange( static_cast< long >( light::SimdIsa::SCALAR ), static_cast< long >( light::SimdIsa::AVX512 ) )
+  ->Unit( benchmark::kMicrosecond );
+
+BENCHMARK( BM_BatchUniformCone )
+  ->ArgName( "isa" )
+  ->DenseRange( static_cast< long >( light::SimdIsa::SCALAR ), static_cast< long >( light::SimdIsa::AVX512 ) )
+  ->Unit( benchmark::kMicrosecond );
+
+BENCHMARK( BM_BatchGgxVndf )
+  ->ArgName( "isa" )
+  ->DenseRange( static_cast< long >( light::SimdIsa::SCALAR ), static_cast< long >( light::SimdIsa::AVX512 ) )
+  ->Unit( benchmark::kMicrosecond );
+
+
+
+BENCHMARK_MAIN( );
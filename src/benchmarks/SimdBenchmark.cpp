@@ -0,0 +1,180 @@
+#include <vector>
+#include <cstdint>
+#include "benchmark/benchmark.h"
+#include "SimdKernels.hpp"
+
+
+namespace
+{
+
+
+// one 1080p frame of RGBA floats
+constexpr std::size_t pixelCount = 1920 * 1080;
+
+
+///
+/// \brief getImage
+/// \return a frame of values in [0, 1.25), so the conversion
+///         clamps some of them
+///
+const std::vector< float > &
+getImage( std::uint32_t seed )
+{
+
+  static std::vector< float > images[ 2 ];
+
+  std::vector< float > &image = images[ seed & 1u ];
+
+  if ( image.empty( ) )
+  {
+
+    image.resize( pixelCount * 4 );
+
+    for ( float &value : image )
+    {
+
+      seed  = seed * 1664525u + 1013904223u;
+      value = static_cast< float >( seed >> 8 ) / 16777216.0f * 1.25f;
+
+    }
+
+  }
+
+  return image;
+
+}
+
+
+///
+/// \brief getKernels
+/// \return the kernels for the instruction set in range( 0 ), or
+///         null after marking the run skipped when the CPU
+///         doesn't have it
+///
+const light::SimdKernels *
+getKernels( benchmark::State &state )
+{
+
+  light::SimdIsa isa = static_cast< light::SimdIsa >( state.range( 0 ) );
+
+  if ( !light::isSimdIsaSupported( isa ) )
+  {
+
+    state.SkipWithError( ( light::toString( isa ) + " isn't supported on this CPU" ).c_str( ) );
+    return nullptr;
+
+  }
+
+  state.SetLabel( light::toString( isa ) );
+
+  return &light::getSimdKernels( isa );
+
+}
+
+
+void
+addPixelRate( benchmark::State &state )
+{
+
+  state.counters[ "pixels/s" ] = benchmark::Counter(
+                                                    static_cast< double >( pixelCount ),
+                                                    benchmark::Counter::kIsIterationInvariantRate
+                                                    );
+
+}
+
+
+} // namespace
+
+
+
+////////////////////////////////////////////////////////////////
+/// \brief BM_RgbaToRgb8
+///
+///        Float framebuffer to 8 bit RGB, the PPM writer's row
+///        conversion, over a whole frame.
+///
+///        range( 0 ) - SimdIsa
+////////////////////////////////////////////////////////////////
+static
+void
+BM_RgbaToRgb8( benchmark::State &state )
+{
+
+  const light::SimdKernels *pKernels = getKernels( state );
+
+  if ( !pKernels )
+  {
+    return;
+  }
+
+  const std::vector< float > &image = getImage( 1u );
+  std::vector< std::uint8_t > bytes( pixelCount * 3 );
+
+  for ( auto _ : state )
+  {
+
+    pKernels->rgbaToRgb8( image.data( ), pixelCount, bytes.data( ) );
+    benchmark::DoNotOptimize( bytes.data( ) );
+    benchmark::ClobberMemory( );
+
+  }
+
+  addPixelRate( state );
+
+} // BM_RgbaToRgb8
+
+
+
+////////////////////////////////////////////////////////////////
+/// \brief BM_SquaredErrors
+///
+///        The image metrics' MSE and relMSE sums over a whole
+///        frame.
+///
+///        range( 0 ) - SimdIsa
+////////////////////////////////////////////////////////////////
+static
+void
+BM_SquaredErrors( benchmark::State &state )
+{
+
+  const light::SimdKernels *pKernels = getKernels( state );
+
+  if ( !pKernels )
+  {
+    return;
+  }
+
+  const std::vector< float > &test      = getImage( 1u );
+  const std::vector< float > &reference = getImage( 2u );
+
+  for ( auto _ : state )
+  {
+
+    float squared, relative;
+    pKernels->squaredErrors( test.data( ), reference.data( ), pixelCount, 0.01f, &squared, &relative );
+
+    benchmark::DoNotOptimize( squared );
+    benchmark::DoNotOptimize( relative );
+
+  }
+
+  addPixelRate( state );
+
+} // BM_SquaredErrors
+
+
+BENCHMARK( BM_RgbaToRgb8 )
+  ->ArgName( "isa" )
+  ->DenseRange( static_cast< long >( light::SimdIsa::SCALAR ), static_cast< long >( light::SimdIsa::AVX512 ) )
+  ->Unit( benchmark::kMicrosecond );
+
+BENCHMARK( BM_SquaredErrors )
+  ->ArgName( "isa" )
+  ->DenseRange( static_cast< long >( light::SimdIsa::SCALAR ), static_cast< long >( light::SimdIsa::AVX512 ) )
+  ->Unit( benchmark::kMicrosecond );
+
+
+
+BENCHMARK_MAIN( );
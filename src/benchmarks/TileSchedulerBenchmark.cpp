@@ -0,0 +1,264 @@
+#include <vector>
+#include <cmath>
+#include <thread>
+#include "benchmark/benchmark.h"
+#include "TileScheduler.hpp"
+#include "TiledFramebuffer.hpp"
+
+
+namespace
+{
+
+
+constexpr unsigned imageWidth  = 1024;
+constexpr unsigned imageHeight = 1024;
+
+// 2048^2 float4 texels (64 MB) so the working set spills out of the last level cache
+constexpr unsigned textureSize = 2048;
+
+// taps per pixel spread over a small footprint around the pixel's texel
+constexpr unsigned tapsPerPixel = 16;
+constexpr unsigned tapRadius    = 6;
+
+
+///
+/// \brief The SyntheticScene struct
+///
+///        Stand-in for BVH nodes and textures: pixels that are
+///        close on screen read overlapping regions of a large
+///        array, which is what makes tile order matter.
+///
+struct SyntheticScene
+{
+
+  std::vector< float > texels;
+
+  SyntheticScene( )
+    : texels( static_cast< std::size_t >( textureSize ) * textureSize * 4 )
+  {
+
+    for ( std::size_t i = 0; i < texels.size( ); ++i )
+    {
+      texels[ i ] = static_cast< float >( i % 251 ) / 251.0f;
+    }
+
+  }
+
+  void shade(
+             unsigned x,
+             unsigned y,
+             float   *pOut
+             ) const
+  {
+
+    unsigned hash = x * 73856093u ^ y * 19349663u;
+
+    float sum[ 4 ] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+    for ( unsigned i = 0; i < tapsPerPixel; ++i )
+    {
+
+      hash = hash * 1664525u + 1013904223u;
+
+      unsigned tx = ( x * 2 + ( ( hash >> 8 )  % ( 2 * tapRadius ) ) ) % textureSize;
+      unsigned ty = ( y * 2 + ( ( hash >> 16 ) % ( 2 * tapRadius ) ) ) % textureSize;
+
+      const float *pTexel = &texels[ ( static_cast< std::size_t >( ty ) * textureSize + tx ) * 4 ];
+
+      for ( unsigned c = 0; c < 4; ++c )
+      {
+        sum[ c ] += std::sqrt( pTexel[ c ] );
+      }
+
+    }
+
+    for ( unsigned c = 0; c < 4; ++c )
+    {
+      pOut[ c ] = sum[ c ] / tapsPerPixel;
+    }
+
+  }
+
+};
+
+
+const SyntheticScene &
+getScene( )
+{
+
+  static SyntheticScene scene;
+  return scene;
+
+}
+
+
+unsigned
+getThreadCount( )
+{
+
+  return std::max( 1u, std::thread::hardware_concurrency( ) );
+
+}
+
+
+} // namespace
+
+
+
+////////////////////////////////////////////////////////////////
+/// \brief BM_TileOrder
+///
+///        Renders the synthetic scene into a tiled framebuffer.
+///        range( 0 ) - light::TileOrder
+///        range( 1 ) - tile size (0 picks one with chooseTileSize)
+////////////////////////////////////////////////////////////////
+static
+void
+BM_TileOrder( benchmark::State &state )
+{
+
+  const SyntheticScene &scene = getScene( );
+
+  light::TileOrder order = static_cast< light::TileOrder >( state.range( 0 ) );
+  unsigned numThreads    = getThreadCount( );
+  unsigned tileSize      = static_cast< unsigned >( state.range( 1 ) );
+
+  if ( tileSize == 0 )
+  {
+
+    tileSize = light::TileScheduler::chooseTileSize(
+                                                     imageWidth,
+                                                     imageHeight,
+                                                     numThreads,
+                                                     4 * sizeof( float )
+                                                     );
+
+  }
+
+  light::TileScheduler   scheduler  ( imageWidth, imageHeight, tileSize, order, 1234 );
+  light::TiledFramebuffer framebuffer( imageWidth, imageHeight, tileSize );
+
+  for ( auto _ : state )
+  {
+
+    scheduler.run(
+                  numThreads,
+                  [ &scene, &framebuffer ]( const light::Tile &tile )
+                  {
+
+                    float *pTile = framebuffer.getTileData( tile );
+
+                    for ( unsigned y = 0; y < tile.height; ++y )
+                    {
+
+                      for ( unsigned x = 0; x < tile.width; ++x )
+                      {
+
+                        scene.shade(
+                                    tile.x + x,
+                                    tile.y + y,
+                                    pTile + ( y * framebuffer.getTileSize( ) + x ) * 4
+                                    );
+
+                      }
+
+                    }
+
+                  }
+                  );
+
+    benchmark::DoNotOptimize( framebuffer.getPixel( 0, 0 ) );
+
+  }
+
+  state.counters[ "tileSize" ] = tileSize;
+  state.counters[ "threads" ]  = numThreads;
+  state.counters[ "pixels/s" ] = benchmark::Counter(
+                                                    static_cast< double >( imageWidth ) * imageHeight,
+                                                    benchmark::Counter::kIsIterationInvariantRate
+                                                    );
+
+} // BM_TileOrder
+
+
+BENCHMARK( BM_TileOrder )
+  ->ArgNames( { "order", "tile" } )
+  ->ArgsProduct( {
+                   {
+                     static_cast< long >( light::TileOrder::SCANLINE ),
+                     static_cast< long >( light::TileOrder::RANDOM ),
+                     static_cast< long >( light::TileOrder::MORTON ),
+                     static_cast< long >( light::TileOrder::HILBERT )
+                   },
+                   { 0, 8, 32, 128 }
+                 } )
+  ->UseRealTime( )
+  ->Unit( benchmark::kMillisecond );
+
+
+
+////////////////////////////////////////////////////////////////
+/// \brief BM_ScanlineFramebuffer
+///
+///        Same Hilbert ordered tiles written into a row-major
+///        buffer for comparison with the tiled layout above.
+///        range( 0 ) - tile size
+////////////////////////////////////////////////////////////////
+static
+void
+BM_ScanlineFramebuffer( benchmark::State &state )
+{
+
+  const SyntheticScene &scene = getScene( );
+
+  unsigned numThreads = getThreadCount( );
+  unsigned tileSize   = static_cast< unsigned >( state.range( 0 ) );
+
+  light::TileScheduler scheduler( imageWidth, imageHeight, tileSize, light::TileOrder::HILBERT );
+  std::vector< float > framebuffer( static_cast< std::size_t >( imageWidth ) * imageHeight * 4 );
+
+  for ( auto _ : state )
+  {
+
+    scheduler.run(
+                  numThreads,
+                  [ &scene, &framebuffer ]( const light::Tile &tile )
+                  {
+
+                    for ( unsigned y = 0; y < tile.height; ++y )
+                    {
+
+                      for ( unsigned x = 0; x < tile.width; ++x )
+                      {
+
+                        std::size_t pixel = static_cast< std::size_t >( tile.y + y ) * imageWidth + tile.x + x;
+                        scene.shade( tile.x + x, tile.y + y, &framebuffer[ pixel * 4 ] );
+
+                      }
+
+                    }
+
+                  }
+                  );
+
+    benchmark::DoNotOptimize( framebuffer.data( ) );
+
+  }
+
+  state.counters[ "tileSize" ] = tileSize;
+  state.counters[ "threads" ]  = numThreads;
+
+} // BM_ScanlineFramebuffer
+
+
+BENCHMARK( BM_ScanlineFramebuffer )
+  ->ArgName( "tile" )
+  ->Arg( 8 )
+  ->Arg( 32 )
+  ->Arg( 128 )
+  ->UseRealTime( )
+  ->Unit( benchmark::kMillisecond );
+
+
+
+BENCHMARK_MAIN( );
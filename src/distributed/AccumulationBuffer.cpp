@@ -0,0 +1,125 @@
+#include "AccumulationBuffer.hpp"
+#include "RenderProtocol.hpp"
+#include "Instrumentation.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+
+namespace light
+{
+
+
+///////////////////////////////////////////////////////////////
+/// \brief AccumulationBuffer::AccumulationBuffer
+///////////////////////////////////////////////////////////////
+AccumulationBuffer::AccumulationBuffer(
+                                       unsigned width,
+                                       unsigned height
+                                       )
+  : width_ ( width )
+  , height_( height )
+  , sums_  ( static_cast< std::size_t >( width ) * height * 4, 0.0 )
+  , counts_( static_cast< std::size_t >( width ) * height, 0 )
+  , memory_( MemoryCategory::FRAMEBUFFERS,
+             sums_.size( ) * sizeof( double ) + counts_.size( ) * sizeof( std::uint64_t ) )
+{}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief AccumulationBuffer::merge
+/// \param result
+///////////////////////////////////////////////////////////////
+void
+AccumulationBuffer::merge( const PartialResult &result )
+{
+
+  const WorkUnit &unit = result.unit;
+
+  if ( unit.x + unit.width > width_ || unit.y + unit.height > height_ )
+  {
+
+    throw std::runtime_error( "Partial result lies outside the accumulation buffer" );
+
+  }
+
+  if ( result.radianceSum.size( ) != static_cast< std::size_t >( unit.width ) * unit.height * 4 )
+  {
+
+    throw std::runtime_error( "Partial result size does not match its work unit" );
+
+  }
+
+  LIGHT_PROFILE_SCOPE( ACCUMULATION );
+
+  for ( unsigned y = 0; y < unit.height; ++y )
+  {
+
+    std::size_t dstPixel = static_cast< std::size_t >( unit.y + y ) * width_ + unit.x;
+    const float *pSrc    = result.radianceSum.data( ) + static_cast< std::size_t >( y ) * unit.width * 4;
+
+    for ( unsigned x = 0; x < unit.width; ++x, ++dstPixel, pSrc += 4 )
+    {
+
+      double *pDst = &sums_[ dstPixel * 4 ];
+
+      pDst[ 0 ] += pSrc[ 0 ];
+      pDst[ 1 ] += pSrc[ 1 ];
+      pDst[ 2 ] += pSrc[ 2 ];
+      pDst[ 3 ] += pSrc[ 3 ];
+
+      counts_[ dstPixel ] += result.samplesPerPixel;
+
+    }
+
+  }
+
+} // AccumulationBuffer::merge
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief AccumulationBuffer::resolve
+/// \param pRgba
+///////////////////////////////////////////////////////////////
+void
+AccumulationBuffer::resolve( std::vector< float > *pRgba ) const
+{
+
+  LIGHT_PROFILE_SCOPE( ACCUMULATION );
+
+  pRgba->resize( sums_.size( ) );
+
+  for ( std::size_t pixel = 0; pixel < counts_.size( ); ++pixel )
+  {
+
+    double scale = counts_[ pixel ] > 0 ? 1.0 / static_cast< double >( counts_[ pixel ] ) : 0.0;
+
+    for ( std::size_t c = 0; c < 4; ++c )
+    {
+
+      ( *pRgba )[ pixel * 4 + c ] = static_cast< float >( sums_[ pixel * 4 + c ] * scale );
+
+    }
+
+  }
+
+} // AccumulationBuffer::resolve
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief AccumulationBuffer::clear
+///////////////////////////////////////////////////////////////
+void
+AccumulationBuffer::clear( )
+{
+
+  std::fill( sums_.begin( ), sums_.end( ), 0.0 );
+  std::fill( counts_.begin( ), counts_.end( ), 0 );
+
+}
+
+
+
+} // namespace light
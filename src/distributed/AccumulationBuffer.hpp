@@ -0,0 +1,80 @@
+#ifndef AccumulationBuffer_hpp
+#define AccumulationBuffer_hpp
+
+
+#include <vector>
+#include <cstdint>
+#include "MemoryAccounting.hpp"
+
+
+namespace light
+{
+
+
+struct PartialResult;
+
+
+/////////////////////////////////////////////
+/// \brief The AccumulationBuffer class
+///
+///        Merges partial renders from any number of workers.
+///        Radiance is summed in double precision alongside a
+///        per-pixel sample count so regions rendered with
+///        different sample totals resolve correctly.
+/////////////////////////////////////////////
+class AccumulationBuffer
+{
+
+public:
+
+  AccumulationBuffer(
+                     unsigned width,
+                     unsigned height
+                     );
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief merge
+  ///
+  ///        Adds a worker's radiance sums and sample counts
+  ///        to the covered pixels
+  ///////////////////////////////////////////////////////////////
+  void merge ( const PartialResult &result );
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief resolve
+  /// \param pRgba row-major RGBA, sums divided by sample counts
+  ///////////////////////////////////////////////////////////////
+  void resolve ( std::vector< float > *pRgba ) const;
+
+
+  void clear ( );
+
+
+  unsigned getWidth  ( ) const { return width_; }
+  unsigned getHeight ( ) const { return height_; }
+
+  std::uint64_t getSampleCount ( unsigned x, unsigned y ) const
+  {
+    return counts_[ static_cast< std::size_t >( y ) * width_ + x ];
+  }
+
+
+private:
+
+  unsigned width_;
+  unsigned height_;
+
+  std::vector< double >        sums_;   // RGBA per pixel
+  std::vector< std::uint64_t > counts_; // samples per pixel
+
+  TrackedMemory memory_;
+
+};
+
+
+} // namespace light
+
+
+#endif // AccumulationBuffer_hpp
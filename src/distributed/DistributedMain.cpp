@@ -0,0 +1,461 @@
+#include "DistributedMain.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <memory>
+#include <sstream>
+#include <iostream>
+#include <stdexcept>
+#include "glm/glm.hpp"
+#include "graphics/Camera.hpp"
+#include "LightBenderConfig.hpp"
+#include "ImageIO.hpp"
+#include "Instrumentation.hpp"
+#include "RenderWorker.hpp"
+#include "RenderCoordinator.hpp"
+#include "OptixWorkerRenderer.hpp"
+#include "Roulette.hpp"
+#include "FastMath.hpp"
+
+#ifdef _WIN32
+#define popen  _popen
+#define pclose _pclose
+#endif
+
+
+namespace light
+{
+
+
+namespace
+{
+
+
+const std::string workerFlag = "--worker";
+const std::string renderFlag = "--render-distributed";
+
+// printed by workers once they are listening
+const std::string workerPortTag = "LIGHTBENDER_WORKER_PORT";
+
+
+struct DistributedOptions
+{
+  std::vector< WorkerAddress > workers;
+  unsigned localWorkers  = 0;
+  unsigned totalFrames   = 64;
+  unsigned tileSize      = 64;
+  unsigned framesPerUnit = 4;
+  float    orbit[ 3 ]    = { 20.0f, 45.0f, -30.0f };
+  std::string output     = "lightBenderDistributed.ppm";
+};
+
+
+std::vector< std::string >
+split(
+      const std::string &text,
+      char               delimiter
+      )
+{
+
+  std::vector< std::string > parts;
+  std::stringstream stream( text );
+  std::string part;
+
+  while ( std::getline( stream, part, delimiter ) )
+  {
+
+    if ( !part.empty( ) )
+    {
+      parts.push_back( part );
+    }
+
+  }
+
+  return parts;
+
+}
+
+
+///
+/// \brief toRoulettePolicy
+///
+///        Only the stateless policies, see RenderSettings
+///
+std::uint32_t
+toRoulettePolicy( const std::string &name )
+{
+
+  if ( name == "albedo" )
+  {
+    return ROULETTE_ALBEDO;
+  }
+
+  if ( name == "throughput" )
+  {
+    return ROULETTE_THROUGHPUT;
+  }
+
+  throw std::runtime_error( "--roulette is albedo or throughput for distributed renders, not " + name );
+
+}
+
+
+std::uint32_t
+toMathPrecision( const std::string &name )
+{
+
+  if ( name == "precise" )
+  {
+    return MATH_PRECISE;
+  }
+
+  if ( name == "fast" )
+  {
+    return MATH_FAST;
+  }
+
+  throw std::runtime_error( "--math is precise or fast, not " + name );
+
+}
+
+
+WorkerAddress
+parseAddress( const std::string &text )
+{
+
+  std::string::size_type colon = text.find_last_of( ':' );
+
+  if ( colon == std::string::npos )
+  {
+
+    throw std::runtime_error( "Worker address must be host:port, got '" + text + "'" );
+
+  }
+
+  WorkerAddress address;
+  address.host = text.substr( 0, colon );
+  address.port = static_cast< unsigned short >( std::stoul( text.substr( colon + 1 ) ) );
+
+  return address;
+
+}
+
+
+///
+/// \brief spawnLocalWorker
+///
+///        Starts this executable in worker mode on a free port
+///        and waits for it to report the port it bound
+///
+WorkerAddress
+spawnLocalWorker(
+                 const std::string    &executable,
+                 std::vector< FILE* > *pProcesses
+                 )
+{
+
+  std::string command = "\"" + executable + "\" " + workerFlag + " 0";
+
+  FILE *pPipe = popen( command.c_str( ), "r" );
+
+  if ( !pPipe )
+  {
+
+    throw std::runtime_error( "Could not start local worker: " + command );
+
+  }
+
+  pProcesses->push_back( pPipe );
+
+  char line[ 256 ];
+
+  while ( std::fgets( line, sizeof( line ), pPipe ) )
+  {
+
+    std::string text( line );
+
+    if ( text.compare( 0, workerPortTag.size( ), workerPortTag ) == 0 )
+    {
+
+      WorkerAddress address;
+      address.host = "127.0.0.1";
+      address.port = static_cast< unsigned short >( std::stoul( text.substr( workerPortTag.size( ) ) ) );
+
+      return address;
+
+    }
+
+  }
+
+  throw std::runtime_error( "Local worker exited before reporting its port" );
+
+}
+
+
+void
+parseOptions(
+             int                 argc,
+             const char        **argv,
+             RenderSettings     *pSettings,
+             DistributedOptions *pOptions
+             )
+{
+
+  for ( int i = 2; i < argc; ++i )
+  {
+
+    std::string flag( argv[ i ] );
+
+    if ( i + 1 >= argc )
+    {
+
+      throw std::runtime_error( "Missing value for " + flag );
+
+    }
+
+    std::string value( argv[ ++i ] );
+
+    if ( flag == "--workers" )
+    {
+
+      for ( const std::string &address : split( value, ',' ) )
+      {
+        pOptions->workers.push_back( parseAddress( address ) );
+      }
+
+    }
+    else if ( flag == "--local-workers" )   { pOptions->localWorkers    = static_cast< unsigned >( std::stoul( value ) ); }
+    else if ( flag == "--frames" )          { pOptions->totalFrames     = static_cast< unsigned >( std::stoul( value ) ); }
+    else if ( flag == "--tile-size" )       { pOptions->tileSize        = static_cast< unsigned >( std::stoul( value ) ); }
+    else if ( flag == "--frames-per-unit" ) { pOptions->framesPerUnit   = static_cast< unsigned >( std::stoul( value ) ); }
+    else if ( flag == "--output" )          { pOptions->output          = value; }
+    else if ( flag == "--scene" )           { pSettings->sceneType      = std::stoi( value ); }
+    else if ( flag == "--model" )           { pSettings->modelFile      = value; }
+    else if ( flag == "--width" )           { pSettings->width          = static_cast< std::uint32_t >( std::stoul( value ) ); }
+    else if ( flag == "--height" )          { pSettings->height         = static_cast< std::uint32_t >( std::stoul( value ) ); }
+    else if ( flag == "--sqrt-samples" )    { pSettings->sqrtSamples    = static_cast< std::uint32_t >( std::stoul( value ) ); }
+    else if ( flag == "--max-bounces" )     { pSettings->maxBounces     = static_cast< std::uint32_t >( std::stoul( value ) ); }
+    else if ( flag == "--first-bounce" )    { pSettings->firstBounce    = static_cast< std::uint32_t >( std::stoul( value ) ); }
+    else if ( flag == "--seed" )            { pSettings->globalSeed     = static_cast< std::uint32_t >( std::stoul( value ) ); }
+    else if ( flag == "--roulette" )        { pSettings->roulettePolicy    = toRoulettePolicy( value ); }
+    else if ( flag == "--min-depth" )       { pSettings->rouletteMinDepth  = static_cast< std::uint32_t >( std::stoul( value ) ); }
+    else if ( flag == "--splits" )          { pSettings->firstBounceSplits = static_cast< std::uint32_t >( std::stoul( value ) ); }
+    else if ( flag == "--math" )            { pSettings->mathPrecision     = toMathPrecision( value ); }
+    else if ( flag == "--orbit" )
+    {
+
+      std::vector< std::string > parts = split( value, ',' );
+
+      if ( parts.size( ) != 3 )
+      {
+        throw std::runtime_error( "--orbit expects zoom,dx,dy" );
+      }
+
+      for ( unsigned c = 0; c < 3; ++c )
+      {
+        pOptions->orbit[ c ] = std::stof( parts[ c ] );
+      }
+
+    }
+    else
+    {
+
+      throw std::runtime_error( "Unknown option " + flag );
+
+    }
+
+  }
+
+  if ( pSettings->firstBounceSplits == 0 )
+  {
+
+    throw std::runtime_error( "--splits needs at least one bounce" );
+
+  }
+
+} // parseOptions
+
+
+void
+setCamera(
+          const DistributedOptions &options,
+          RenderSettings           *pSettings
+          )
+{
+
+  graphics::Camera camera;
+  camera.setAspectRatio( pSettings->width * 1.0f / pSettings->height );
+  camera.updateOrbit( options.orbit[ 0 ], options.orbit[ 1 ], options.orbit[ 2 ] );
+
+  glm::vec3 eye( camera.getEye( ) );
+  glm::vec3 U, V, W;
+
+  camera.buildRayBasisVectors( &U, &V, &W );
+
+  for ( int c = 0; c < 3; ++c )
+  {
+
+    pSettings->eye[ c ] = eye[ c ];
+    pSettings->U  [ c ] = U  [ c ];
+    pSettings->V  [ c ] = V  [ c ];
+    pSettings->W  [ c ] = W  [ c ];
+
+  }
+
+}
+
+
+int
+runWorker(
+          int          argc,
+          const char **argv
+          )
+{
+
+  unsigned short port = 0;
+
+  if ( argc > 2 )
+  {
+    port = static_cast< unsigned short >( std::stoul( argv[ 2 ] ) );
+  }
+
+  RenderWorker worker( std::unique_ptr< WorkerRendererInterface >( new OptixWorkerRenderer( ) ), port );
+
+  // the coordinator reads this line when it spawns local workers
+  std::cout << workerPortTag << " " << worker.getPort( ) << std::endl;
+
+  worker.serve( );
+
+  return EXIT_SUCCESS;
+
+}
+
+
+int
+runCoordinator(
+               int          argc,
+               const char **argv
+               )
+{
+
+  RenderSettings     settings;
+  DistributedOptions options;
+
+  settings.width       = 1280;
+  settings.height      = 720;
+  settings.displayType = 2;
+  settings.pathTracing = true;
+  settings.maxBounces  = 5;
+  settings.globalSeed  = 1234;
+
+  parseOptions( argc, argv, &settings, &options );
+  setCamera( options, &settings );
+
+  std::vector< FILE* >         localProcesses;
+  std::vector< WorkerAddress > localWorkers;
+
+  int result = EXIT_SUCCESS;
+
+  try
+  {
+
+    // spawned in here so a failed spawn still shuts down the
+    // workers started before it
+    for ( unsigned i = 0; i < options.localWorkers; ++i )
+    {
+
+      localWorkers.push_back( spawnLocalWorker( argv[ 0 ], &localProcesses ) );
+      options.workers.push_back( localWorkers.back( ) );
+
+    }
+
+    RenderCoordinator coordinator( options.workers );
+    coordinator.setTileSize     ( options.tileSize );
+    coordinator.setFramesPerUnit( options.framesPerUnit );
+
+    AccumulationBuffer buffer = coordinator.render( settings, options.totalFrames );
+
+    std::vector< float > rgba;
+    buffer.resolve( &rgba );
+
+    writePPM( light::OUTPUT_PATH + options.output, settings.width, settings.height, rgba );
+
+    std::cout << "Saved " << light::OUTPUT_PATH + options.output << std::endl;
+
+#ifdef LIGHT_INSTRUMENTATION
+    writeProfileJson( light::OUTPUT_PATH + options.output + ".profile.json", getProfileSnapshot( ) );
+#endif
+
+  }
+  catch ( const std::exception &e )
+  {
+
+    std::cerr << "ERROR: distributed render failed: " << e.what( ) << std::endl;
+    result = EXIT_FAILURE;
+
+  }
+
+  // only shut down the workers we started; a worker that exited
+  // before reporting its port still has a pipe to close
+  if ( !localWorkers.empty( ) )
+  {
+
+    RenderCoordinator( localWorkers ).shutdownWorkers( );
+
+  }
+
+  for ( FILE *pPipe : localProcesses )
+  {
+    pclose( pPipe );
+  }
+
+  return result;
+
+} // runCoordinator
+
+
+} // namespace
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief isDistributedCommand
+///////////////////////////////////////////////////////////////
+bool
+isDistributedCommand(
+                     int          argc,
+                     const char **argv
+                     )
+{
+
+  return argc > 1 && ( argv[ 1 ] == workerFlag || argv[ 1 ] == renderFlag );
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief runDistributedCommand
+///////////////////////////////////////////////////////////////
+int
+runDistributedCommand(
+                      int          argc,
+                      const char **argv
+                      )
+{
+
+  if ( argv[ 1 ] == workerFlag )
+  {
+
+    return runWorker( argc, argv );
+
+  }
+
+  return runCoordinator( argc, argv );
+
+}
+
+
+
+} // namespace light
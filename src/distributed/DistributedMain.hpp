@@ -0,0 +1,54 @@
+#ifndef DistributedMain_hpp
+#define DistributedMain_hpp
+
+
+namespace light
+{
+
+
+///////////////////////////////////////////////////////////////
+/// \brief isDistributedCommand
+/// \return true if the arguments ask for a worker or a
+///         distributed render instead of the interactive viewer
+///////////////////////////////////////////////////////////////
+bool isDistributedCommand (
+                           int          argc,
+                           const char **argv
+                           );
+
+
+///////////////////////////////////////////////////////////////
+/// \brief runDistributedCommand
+///
+///        --worker [port]
+///            Serves work units until the coordinator shuts it down.
+///
+///        --render-distributed [options]
+///            --workers host:port,...   remote workers
+///            --local-workers N         spawn N workers on this machine
+///            --scene N                 0 basic, 1 advanced, 2 model,
+///                                      3 scene file, 4 stress scene
+///            --model file              mesh, scene description or
+///                                      stress scene options
+///            --width W --height H      image size
+///            --frames N                progressive frames per pixel
+///            --sqrt-samples N          samples per frame (squared)
+///            --max-bounces N --first-bounce N
+///            --tile-size N             work unit edge, 0 for whole image
+///            --frames-per-unit N       frames per work unit
+///            --seed N                  shared random seed
+///            --orbit zoom,dx,dy        camera orbit like the viewer
+///            --output file.ppm
+///
+/// \return process exit code
+///////////////////////////////////////////////////////////////
+int runDistributedCommand (
+                           int          argc,
+                           const char **argv
+                           );
+
+
+} // namespace light
+
+
+#endif // DistributedMain_hpp
@@ -0,0 +1,177 @@
+#include "HostWorkerRenderer.hpp"
+#include <thread>
+#include <algorithm>
+#include <stdexcept>
+#include "HostScene.hpp"
+#include "HostRenderer.hpp"
+#include "BuiltinScenes.hpp"
+#include "StressScene.hpp"
+#include "Trace.hpp"
+
+
+namespace light
+{
+
+
+namespace
+{
+
+
+///
+/// \brief loadScene
+/// \return the description OptixSceneFactory builds for sceneType
+///
+SceneDescription
+loadScene( const RenderSettings &settings )
+{
+
+  switch ( settings.sceneType )
+  {
+
+  case 0:
+    return buildBasicScene( );
+
+  case 1:
+    return buildAdvancedScene( );
+
+  case 2:
+    return buildModelScene( settings.modelFile );
+
+  case 3:
+    return SceneDescription::read( settings.modelFile );
+
+  case 4:
+    return buildStressScene( parseStressSceneOptions( settings.modelFile ) );
+
+  default:
+    throw std::runtime_error( "Unknown scene type " + std::to_string( settings.sceneType ) );
+
+  } // switch
+
+}
+
+
+Float3
+toFloat3( const float *pValues )
+{
+
+  return Float3 { pValues[ 0 ], pValues[ 1 ], pValues[ 2 ] };
+
+}
+
+
+} // namespace
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief HostWorkerRenderer::HostWorkerRenderer
+///////////////////////////////////////////////////////////////
+HostWorkerRenderer::HostWorkerRenderer( unsigned numThreads )
+  : numThreads_( numThreads > 0 ? numThreads : std::max( 1u, std::thread::hardware_concurrency( ) ) )
+{}
+
+
+HostWorkerRenderer::~HostWorkerRenderer( )
+{}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief HostWorkerRenderer::setup
+///////////////////////////////////////////////////////////////
+void
+HostWorkerRenderer::setup( const RenderSettings &settings )
+{
+
+  // only rebuild the scene when the geometry or image size changes
+  if ( !upScene_
+      || settings.sceneType != settings_.sceneType
+      || settings.modelFile != settings_.modelFile )
+  {
+
+    upRenderer_.reset( );
+    upScene_.reset( new HostScene( loadScene( settings ) ) );
+
+  }
+
+  if ( !upRenderer_ || settings.width != settings_.width || settings.height != settings_.height )
+  {
+
+    upRenderer_.reset( new HostRenderer( *upScene_, settings.width, settings.height ) );
+
+  }
+
+  settings_ = settings;
+
+  upRenderer_->setCamera( toFloat3( settings.eye ), toFloat3( settings.U ), toFloat3( settings.V ), toFloat3( settings.W ) );
+
+} // HostWorkerRenderer::setup
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief HostWorkerRenderer::render
+///////////////////////////////////////////////////////////////
+void
+HostWorkerRenderer::render(
+                           const WorkUnit &unit,
+                           PartialResult  *pResult
+                           )
+{
+
+  if ( !upRenderer_ )
+  {
+
+    throw std::runtime_error( "Host worker renderer has not been set up" );
+
+  }
+
+  if ( unit.x + unit.width > settings_.width || unit.y + unit.height > settings_.height )
+  {
+
+    throw std::runtime_error( "Work unit lies outside the rendered image" );
+
+  }
+
+  LIGHT_TRACE_SCOPE( "workUnit", "render" );
+
+  HostRenderSettings hostSettings;
+  hostSettings.sqrtSamples = std::max( 1u, settings_.sqrtSamples );
+  hostSettings.numThreads  = numThreads_;
+
+  pResult->samplesPerPixel = unit.frameCount * hostSettings.sqrtSamples * hostSettings.sqrtSamples;
+  pResult->radianceSum.assign( static_cast< std::size_t >( unit.width ) * unit.height * 4, 0.0f );
+
+  float scale = static_cast< float >( hostSettings.sqrtSamples * hostSettings.sqrtSamples );
+
+  for ( unsigned frame = unit.firstFrame; frame < unit.firstFrame + unit.frameCount; ++frame )
+  {
+
+    hostSettings.seed = settings_.globalSeed ^ ( frame * 0x9e3779b9u );
+
+    // the whole image is rendered and the unit cropped out of it
+    upRenderer_->render( hostSettings );
+
+    std::vector< float > pixels = upRenderer_->getPixels( );
+
+    for ( unsigned y = 0; y < unit.height; ++y )
+    {
+
+      const float *pSrc = pixels.data( ) + ( static_cast< std::size_t >( unit.y + y ) * settings_.width + unit.x ) * 4;
+      float       *pDst = pResult->radianceSum.data( ) + static_cast< std::size_t >( y ) * unit.width * 4;
+
+      for ( unsigned i = 0; i < unit.width * 4; ++i )
+      {
+        pDst[ i ] += pSrc[ i ] * scale;
+      }
+
+    }
+
+  }
+
+} // HostWorkerRenderer::render
+
+
+
+} // namespace light
@@ -0,0 +1,65 @@
+#ifndef HostWorkerRenderer_hpp
+#define HostWorkerRenderer_hpp
+
+
+#include <memory>
+#include "RenderWorker.hpp"
+
+
+namespace light
+{
+
+
+class HostScene;
+class HostRenderer;
+
+
+/////////////////////////////////////////////
+/// \brief The HostWorkerRenderer class
+///
+///        Renders work units on the CPU with HostRenderer, so
+///        progressive renders can run without a GPU. Only the
+///        scene, image size, camera, samples and seed are used;
+///        shading is always HostRenderer's direct lighting.
+///        Each frame gets its own seed from the global seed and
+///        the frame index, so frames split across units match a
+///        single render of the same frames.
+/////////////////////////////////////////////
+class HostWorkerRenderer : public WorkerRendererInterface
+{
+
+public:
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief HostWorkerRenderer
+  /// \param numThreads render threads, 0 for every hardware thread
+  ///////////////////////////////////////////////////////////////
+  explicit
+  HostWorkerRenderer( unsigned numThreads = 0 );
+
+  virtual
+  ~HostWorkerRenderer( );
+
+
+  void setup ( const RenderSettings &settings ) final;
+
+  void render (
+               const WorkUnit &unit,
+               PartialResult  *pResult
+               ) final;
+
+
+private:
+
+  std::unique_ptr< HostScene >    upScene_;
+  std::unique_ptr< HostRenderer > upRenderer_;
+  RenderSettings                  settings_;
+  unsigned                        numThreads_;
+
+};
+
+
+} // namespace light
+
+
+#endif // HostWorkerRenderer_hpp
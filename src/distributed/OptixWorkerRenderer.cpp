@@ -0,0 +1,166 @@
+#include "OptixWorkerRenderer.hpp"
+#include <stdexcept>
+#include "OptixScene.hpp"
+#include "OptixSceneFactory.hpp"
+#include "Roulette.hpp"
+#include "Instrumentation.hpp"
+#include "Trace.hpp"
+
+
+namespace light
+{
+
+
+///////////////////////////////////////////////////////////////
+/// \brief OptixWorkerRenderer::OptixWorkerRenderer
+///////////////////////////////////////////////////////////////
+OptixWorkerRenderer::OptixWorkerRenderer( )
+{}
+
+
+
+OptixWorkerRenderer::~OptixWorkerRenderer( )
+{}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief OptixWorkerRenderer::setup
+/// \param settings
+///////////////////////////////////////////////////////////////
+void
+OptixWorkerRenderer::setup( const RenderSettings &settings )
+{
+
+  // render() restarts the frame count for every unit, so
+  // efficiency roulette would see different moments per tile
+  // and frame range than a single process render
+  if ( settings.roulettePolicy == ROULETTE_EFFICIENCY )
+  {
+
+    throw std::runtime_error( "Distributed renders need a stateless roulette policy (albedo or throughput)" );
+
+  }
+
+  // only rebuild the scene when the geometry or image size changes
+  if ( !upScene_
+      || settings.sceneType != settings_.sceneType
+      || settings.modelFile != settings_.modelFile
+      || settings.width     != settings_.width
+      || settings.height    != settings_.height )
+  {
+
+    upScene_.reset( );
+    upScene_ = createOptixScene(
+                                settings.sceneType,
+                                static_cast< int >( settings.width ),
+                                static_cast< int >( settings.height ),
+                                0,
+                                settings.modelFile
+                                );
+
+  }
+
+  settings_ = settings;
+
+  upScene_->setDisplayType ( settings.displayType );
+  upScene_->setPathTracing ( settings.pathTracing );
+  upScene_->setCameraType  ( settings.cameraType );
+  upScene_->setMaxBounces  ( settings.maxBounces );
+  upScene_->setFirstBounce ( settings.firstBounce );
+  upScene_->setSqrtSamples ( settings.sqrtSamples );
+
+  upScene_->setRoulette(
+                        static_cast< RoulettePolicy >( settings.roulettePolicy ),
+                        settings.rouletteMinDepth
+                        );
+  upScene_->setFirstBounceSplits( settings.firstBounceSplits );
+  upScene_->setMathPrecision( static_cast< MathPrecision >( settings.mathPrecision ) );
+
+  // setCameraType picks a random seed, replace it with the shared one
+  upScene_->setGlobalSeed( settings.globalSeed );
+
+  upScene_->setCamera(
+                      glm::vec3( settings.eye[ 0 ], settings.eye[ 1 ], settings.eye[ 2 ] ),
+                      glm::vec3( settings.U[ 0 ],   settings.U[ 1 ],   settings.U[ 2 ] ),
+                      glm::vec3( settings.V[ 0 ],   settings.V[ 1 ],   settings.V[ 2 ] ),
+                      glm::vec3( settings.W[ 0 ],   settings.W[ 1 ],   settings.W[ 2 ] )
+                      );
+
+} // OptixWorkerRenderer::setup
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief OptixWorkerRenderer::render
+/// \param unit
+/// \param pResult
+///////////////////////////////////////////////////////////////
+void
+OptixWorkerRenderer::render(
+                            const WorkUnit &unit,
+                            PartialResult  *pResult
+                            )
+{
+
+  if ( unit.x + unit.width > settings_.width || unit.y + unit.height > settings_.height )
+  {
+
+    throw std::runtime_error( "Work unit lies outside the rendered image" );
+
+  }
+
+  LIGHT_TRACE_SCOPE( "workUnit", "render" );
+
+  //
+  // frames [firstFrame, firstFrame + frameCount) of the
+  // progressive render, accumulated in the output buffer
+  //
+  upScene_->setFrameOffset( unit.firstFrame );
+  upScene_->resetFrameCount( );
+
+  for ( unsigned frame = 0; frame < unit.frameCount; ++frame )
+  {
+
+    upScene_->renderRegion( unit.x, unit.y, unit.width, unit.height );
+
+  }
+
+  //
+  // the output buffer holds the mean over all samples,
+  // scale back to a sum so the coordinator can weight it
+  //
+  unsigned samples = unit.frameCount * settings_.sqrtSamples * settings_.sqrtSamples;
+  float    scale   = static_cast< float >( samples );
+
+  pResult->samplesPerPixel = samples;
+  pResult->radianceSum.resize( static_cast< std::size_t >( unit.width ) * unit.height * 4 );
+
+  LIGHT_PROFILE_SCOPE( READBACK );
+
+  optix::Buffer buffer = upScene_->getBuffer( );
+
+  const float *pPixels = static_cast< const float* >( buffer->map( ) );
+
+  for ( unsigned y = 0; y < unit.height; ++y )
+  {
+
+    const float *pSrc = pPixels + ( static_cast< std::size_t >( unit.y + y ) * settings_.width + unit.x ) * 4;
+    float       *pDst = pResult->radianceSum.data( ) + static_cast< std::size_t >( y ) * unit.width * 4;
+
+    for ( unsigned i = 0; i < unit.width * 4; ++i )
+    {
+
+      pDst[ i ] = pSrc[ i ] * scale;
+
+    }
+
+  }
+
+  buffer->unmap( );
+
+} // OptixWorkerRenderer::render
+
+
+
+} // namespace light
@@ -0,0 +1,53 @@
+#ifndef OptixWorkerRenderer_hpp
+#define OptixWorkerRenderer_hpp
+
+
+#include <memory>
+#include "RenderWorker.hpp"
+
+
+namespace light
+{
+
+
+class OptixScene;
+
+
+/////////////////////////////////////////////
+/// \brief The OptixWorkerRenderer class
+///
+///        Renders work units with a headless OptiX scene.
+///        Frame offsets keep the random sequence identical to
+///        a single process render of the same frames.
+/////////////////////////////////////////////
+class OptixWorkerRenderer : public WorkerRendererInterface
+{
+
+public:
+
+  OptixWorkerRenderer( );
+
+  virtual
+  ~OptixWorkerRenderer( );
+
+
+  void setup ( const RenderSettings &settings ) final;
+
+  void render (
+               const WorkUnit &unit,
+               PartialResult  *pResult
+               ) final;
+
+
+private:
+
+  std::unique_ptr< OptixScene > upScene_;
+  RenderSettings                settings_;
+
+};
+
+
+} // namespace light
+
+
+#endif // OptixWorkerRenderer_hpp
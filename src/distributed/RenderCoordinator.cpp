@@ -0,0 +1,358 @@
+#include "RenderCoordinator.hpp"
+#include "Socket.hpp"
+#include "TileScheduler.hpp"
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+
+
+namespace light
+{
+
+
+namespace
+{
+
+
+///
+/// \brief The WorkQueue class
+///
+///        Shared pool of outstanding units. Units are only
+///        considered done once their result has been merged.
+///
+class WorkQueue
+{
+
+public:
+
+  explicit
+  WorkQueue( const std::vector< WorkUnit > &units )
+    : pending_    ( units.begin( ), units.end( ) )
+    , outstanding_( units.size( ) )
+  {}
+
+  bool pop( WorkUnit *pUnit )
+  {
+
+    std::lock_guard< std::mutex > lock( mutex_ );
+
+    if ( pending_.empty( ) )
+    {
+      return false;
+    }
+
+    *pUnit = pending_.front( );
+    pending_.pop_front( );
+    return true;
+
+  }
+
+  void requeue( const WorkUnit &unit )
+  {
+
+    std::lock_guard< std::mutex > lock( mutex_ );
+    pending_.push_front( unit );
+
+  }
+
+  void complete( )
+  {
+
+    std::lock_guard< std::mutex > lock( mutex_ );
+    --outstanding_;
+
+  }
+
+  std::size_t getOutstanding( )
+  {
+
+    std::lock_guard< std::mutex > lock( mutex_ );
+    return outstanding_;
+
+  }
+
+
+private:
+
+  std::mutex             mutex_;
+  std::deque< WorkUnit > pending_;
+  std::size_t            outstanding_;
+
+};
+
+
+///
+/// \brief expectResult
+///
+///        Waits for a RESULT reply, turning worker errors into exceptions
+///
+void
+expectResult(
+             TcpSocket                    *pSocket,
+             std::vector< unsigned char > *pPayload
+             )
+{
+
+  MessageType type = receiveMessage( pSocket, pPayload );
+
+  if ( type == MessageType::FAILURE )
+  {
+
+    std::string message;
+    decode( *pPayload, &message );
+
+    throw std::runtime_error( "Worker error: " + message );
+
+  }
+
+  if ( type != MessageType::RESULT )
+  {
+
+    throw std::runtime_error( "Unexpected reply from render worker" );
+
+  }
+
+}
+
+
+///
+/// \brief runWorker
+///
+///        Connection loop for a single worker, run on its own thread
+/// \return false if the worker failed and should not be used again
+///
+bool
+runWorker(
+          const WorkerAddress  &address,
+          const RenderSettings &settings,
+          WorkQueue            *pQueue,
+          AccumulationBuffer   *pBuffer,
+          std::mutex           *pBufferMutex
+          )
+{
+
+  WorkUnit unit;
+  bool     holdingUnit = false;
+
+  try
+  {
+
+    TcpSocket socket = TcpSocket::connect( address.host, address.port );
+
+    std::vector< unsigned char > payload;
+
+    sendMessage( &socket, MessageType::SETUP, encode( settings ) );
+    expectResult( &socket, &payload );
+
+    while ( ( holdingUnit = pQueue->pop( &unit ) ) )
+    {
+
+      sendMessage( &socket, MessageType::WORK, encode( unit ) );
+      expectResult( &socket, &payload );
+
+      PartialResult result;
+      decode( payload, &result );
+
+      {
+        std::lock_guard< std::mutex > lock( *pBufferMutex );
+        pBuffer->merge( result );
+      }
+
+      holdingUnit = false;
+      pQueue->complete( );
+
+    }
+
+  }
+  catch ( const std::exception &e )
+  {
+
+    std::cerr << "Dropping worker " << address.host << ":" << address.port
+              << " - " << e.what( ) << std::endl;
+
+    if ( holdingUnit )
+    {
+
+      pQueue->requeue( unit );
+
+    }
+
+    return false;
+
+  }
+
+  return true;
+
+} // runWorker
+
+
+} // namespace
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief RenderCoordinator::RenderCoordinator
+/// \param workers
+///////////////////////////////////////////////////////////////
+RenderCoordinator::RenderCoordinator( std::vector< WorkerAddress > workers )
+  : workers_      ( std::move( workers ) )
+  , tileSize_     ( 64 )
+  , framesPerUnit_( 4 )
+{
+
+  if ( workers_.empty( ) )
+  {
+
+    throw std::runtime_error( "Distributed rendering requires at least one worker" );
+
+  }
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief RenderCoordinator::render
+/// \param settings
+/// \param totalFrames
+/// \return
+///////////////////////////////////////////////////////////////
+AccumulationBuffer
+RenderCoordinator::render(
+                          const RenderSettings &settings,
+                          unsigned              totalFrames
+                          )
+{
+
+  AccumulationBuffer buffer( settings.width, settings.height );
+  WorkQueue          queue( _buildWorkUnits( settings, totalFrames ) );
+  std::mutex         bufferMutex;
+
+  //
+  // a worker thread exits when the queue is empty or its
+  // connection fails. Units dropped by a failed worker are
+  // requeued, possibly after the others have already exited,
+  // so keep restarting the live workers until every unit is
+  // merged or no worker is left.
+  //
+  std::vector< char > alive( workers_.size( ), 1 );
+
+  while ( queue.getOutstanding( ) > 0 )
+  {
+
+    if ( std::find( alive.begin( ), alive.end( ), 1 ) == alive.end( ) )
+    {
+
+      throw std::runtime_error( "No render worker could complete the remaining work" );
+
+    }
+
+    std::vector< std::thread > threads;
+
+    for ( std::size_t i = 0; i < workers_.size( ); ++i )
+    {
+
+      if ( alive[ i ] )
+      {
+
+        threads.emplace_back( [ this, i, &settings, &queue, &buffer, &bufferMutex, &alive ]
+                              {
+                                alive[ i ] = runWorker( workers_[ i ], settings, &queue, &buffer, &bufferMutex );
+                              } );
+
+      }
+
+    }
+
+    for ( std::thread &thread : threads )
+    {
+      thread.join( );
+    }
+
+  }
+
+  return buffer;
+
+} // RenderCoordinator::render
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief RenderCoordinator::shutdownWorkers
+///////////////////////////////////////////////////////////////
+void
+RenderCoordinator::shutdownWorkers( )
+{
+
+  for ( const WorkerAddress &address : workers_ )
+  {
+
+    try
+    {
+
+      TcpSocket socket = TcpSocket::connect( address.host, address.port );
+      sendMessage( &socket, MessageType::SHUTDOWN );
+
+    }
+    catch ( const std::exception& )
+    {
+      // already gone
+    }
+
+  }
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief RenderCoordinator::_buildWorkUnits
+///
+///        Tiles follow a Hilbert curve so consecutive units share
+///        scene data. The frame range loops outermost so a partial
+///        render always covers the whole image evenly.
+///////////////////////////////////////////////////////////////
+std::vector< WorkUnit >
+RenderCoordinator::_buildWorkUnits(
+                                   const RenderSettings &settings,
+                                   unsigned              totalFrames
+                                   ) const
+{
+
+  unsigned tileSize      = tileSize_ > 0 ? tileSize_ : std::max( settings.width, settings.height );
+  unsigned framesPerUnit = std::max( 1u, framesPerUnit_ );
+
+  TileScheduler scheduler( settings.width, settings.height, tileSize, TileOrder::HILBERT );
+
+  std::vector< WorkUnit > units;
+
+  for ( unsigned frame = 0; frame < totalFrames; frame += framesPerUnit )
+  {
+
+    for ( const Tile &tile : scheduler.getTiles( ) )
+    {
+
+      WorkUnit unit;
+      unit.x          = tile.x;
+      unit.y          = tile.y;
+      unit.width      = tile.width;
+      unit.height     = tile.height;
+      unit.firstFrame = frame;
+      unit.frameCount = std::min( framesPerUnit, totalFrames - frame );
+
+      units.push_back( unit );
+
+    }
+
+  }
+
+  return units;
+
+} // RenderCoordinator::_buildWorkUnits
+
+
+
+} // namespace light
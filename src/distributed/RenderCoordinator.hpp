@@ -0,0 +1,96 @@
+#ifndef RenderCoordinator_hpp
+#define RenderCoordinator_hpp
+
+
+#include <string>
+#include <vector>
+#include "RenderProtocol.hpp"
+#include "AccumulationBuffer.hpp"
+
+
+namespace light
+{
+
+
+struct WorkerAddress
+{
+  std::string    host;
+  unsigned short port;
+};
+
+
+/////////////////////////////////////////////
+/// \brief The RenderCoordinator class
+///
+///        Splits a progressive render into work units (Hilbert
+///        ordered tiles times frame ranges) and hands them out to
+///        remote workers. Each worker pulls its next unit as soon
+///        as it returns the previous one so fast machines end up
+///        doing more of the work. Units from a worker that fails
+///        or disconnects are given to the remaining workers.
+/////////////////////////////////////////////
+class RenderCoordinator
+{
+
+public:
+
+  explicit
+  RenderCoordinator( std::vector< WorkerAddress > workers );
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief setTileSize
+  /// \param tileSize edge length of a work unit's region, 0 sends
+  ///                 the whole image per unit
+  ///////////////////////////////////////////////////////////////
+  void setTileSize ( unsigned tileSize ) { tileSize_ = tileSize; }
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief setFramesPerUnit
+  /// \param framesPerUnit progressive frames rendered per work unit
+  ///////////////////////////////////////////////////////////////
+  void setFramesPerUnit ( unsigned framesPerUnit ) { framesPerUnit_ = framesPerUnit; }
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief render
+  /// \param settings scene, camera and sampling shared by all workers
+  /// \param totalFrames progressive frames to accumulate per pixel
+  /// \return merged radiance from every worker
+  ///
+  ///        Throws if every worker fails before the image is done
+  ///////////////////////////////////////////////////////////////
+  AccumulationBuffer render (
+                             const RenderSettings &settings,
+                             unsigned              totalFrames
+                             );
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief shutdownWorkers
+  ///
+  ///        Asks every reachable worker process to exit
+  ///////////////////////////////////////////////////////////////
+  void shutdownWorkers ( );
+
+
+private:
+
+  std::vector< WorkUnit > _buildWorkUnits (
+                                           const RenderSettings &settings,
+                                           unsigned              totalFrames
+                                           ) const;
+
+  std::vector< WorkerAddress > workers_;
+
+  unsigned tileSize_;
+  unsigned framesPerUnit_;
+
+};
+
+
+} // namespace light
+
+
+#endif // RenderCoordinator_hpp
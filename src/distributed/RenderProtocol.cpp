@@ -0,0 +1,465 @@
+#include "RenderProtocol.hpp"
+#include "Socket.hpp"
+#include <stdexcept>
+#include <cstring>
+#include <type_traits>
+
+
+namespace light
+{
+
+
+namespace
+{
+
+
+constexpr std::uint32_t protocolMagic = 0x4C42524Eu; // "LBRN"
+
+// refuse absurd payloads from a corrupt or foreign stream
+constexpr std::uint64_t maxPayloadBytes = 1ull << 32;
+
+
+///
+/// \brief The WireBits struct
+///
+///        Unsigned integer with the size of a field, used to
+///        shift its bytes out in little-endian order whatever
+///        the host's byte order
+///
+template< std::size_t Bytes > struct WireBits;
+template< > struct WireBits< 1 > { using type = std::uint8_t;  };
+template< > struct WireBits< 2 > { using type = std::uint16_t; };
+template< > struct WireBits< 4 > { using type = std::uint32_t; };
+template< > struct WireBits< 8 > { using type = std::uint64_t; };
+
+
+///
+/// \brief The MessageWriter class
+///
+///        Appends little-endian fixed size fields to a byte buffer
+///
+class MessageWriter
+{
+
+public:
+
+  template< typename T >
+  void write( const T &value )
+  {
+
+    static_assert( std::is_arithmetic< T >::value, "Only arithmetic fields can be written" );
+
+    typename WireBits< sizeof( T ) >::type bits;
+    std::memcpy( &bits, &value, sizeof( T ) );
+
+    for ( std::size_t i = 0; i < sizeof( T ); ++i )
+    {
+      bytes_.push_back( static_cast< unsigned char >( bits >> ( 8 * i ) ) );
+    }
+
+  }
+
+  void write( const std::string &text )
+  {
+
+    write( static_cast< std::uint32_t >( text.size( ) ) );
+    bytes_.insert( bytes_.end( ), text.begin( ), text.end( ) );
+
+  }
+
+  void write( const float *pValues, std::size_t count )
+  {
+
+    bytes_.reserve( bytes_.size( ) + count * sizeof( float ) );
+
+    for ( std::size_t i = 0; i < count; ++i )
+    {
+      write( pValues[ i ] );
+    }
+
+  }
+
+  std::vector< unsigned char > &getBytes( ) { return bytes_; }
+
+
+private:
+
+  std::vector< unsigned char > bytes_;
+
+};
+
+
+///
+/// \brief The MessageReader class
+///
+///        Reads little-endian fields back in the order they were
+///        written and throws on truncated payloads
+///
+class MessageReader
+{
+
+public:
+
+  explicit
+  MessageReader( const std::vector< unsigned char > &bytes )
+    : bytes_ ( bytes )
+    , offset_( 0 )
+  {}
+
+  template< typename T >
+  void read( T *pValue )
+  {
+
+    static_assert( std::is_arithmetic< T >::value, "Only arithmetic fields can be read" );
+
+    _require( sizeof( T ) );
+
+    typename WireBits< sizeof( T ) >::type bits = 0;
+
+    for ( std::size_t i = 0; i < sizeof( T ); ++i )
+    {
+      bits |= static_cast< decltype( bits ) >( bytes_[ offset_ + i ] ) << ( 8 * i );
+    }
+
+    std::memcpy( pValue, &bits, sizeof( T ) );
+    offset_ += sizeof( T );
+
+  }
+
+  void read( std::string *pText )
+  {
+
+    std::uint32_t size;
+    read( &size );
+
+    _require( size );
+    pText->assign( reinterpret_cast< const char* >( bytes_.data( ) + offset_ ), size );
+    offset_ += size;
+
+  }
+
+  void read( float *pValues, std::size_t count )
+  {
+
+    _require( count * sizeof( float ) );
+
+    for ( std::size_t i = 0; i < count; ++i )
+    {
+      read( pValues + i );
+    }
+
+  }
+
+
+private:
+
+  void _require( std::size_t bytes ) const
+  {
+
+    if ( offset_ + bytes > bytes_.size( ) )
+    {
+
+      throw std::runtime_error( "Render message payload is truncated" );
+
+    }
+
+  }
+
+  const std::vector< unsigned char > &bytes_;
+  std::size_t offset_;
+
+};
+
+
+void
+writeUnit(
+          MessageWriter  *pWriter,
+          const WorkUnit &unit
+          )
+{
+
+  pWriter->write( unit.x );
+  pWriter->write( unit.y );
+  pWriter->write( unit.width );
+  pWriter->write( unit.height );
+  pWriter->write( unit.firstFrame );
+  pWriter->write( unit.frameCount );
+
+}
+
+
+void
+readUnit(
+         MessageReader *pReader,
+         WorkUnit      *pUnit
+         )
+{
+
+  pReader->read( &pUnit->x );
+  pReader->read( &pUnit->y );
+  pReader->read( &pUnit->width );
+  pReader->read( &pUnit->height );
+  pReader->read( &pUnit->firstFrame );
+  pReader->read( &pUnit->frameCount );
+
+}
+
+
+} // namespace
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief sendMessage
+/// \param pSocket
+/// \param type
+/// \param payload
+///////////////////////////////////////////////////////////////
+void
+sendMessage(
+            TcpSocket                          *pSocket,
+            MessageType                         type,
+            const std::vector< unsigned char > &payload
+            )
+{
+
+  MessageWriter header;
+  header.write( protocolMagic );
+  header.write( static_cast< std::uint32_t >( type ) );
+  header.write( static_cast< std::uint64_t >( payload.size( ) ) );
+
+  pSocket->sendAll( header.getBytes( ).data( ), header.getBytes( ).size( ) );
+
+  if ( !payload.empty( ) )
+  {
+
+    pSocket->sendAll( payload.data( ), payload.size( ) );
+
+  }
+
+} // sendMessage
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief receiveMessage
+/// \param pSocket
+/// \param pPayload
+/// \return
+///////////////////////////////////////////////////////////////
+MessageType
+receiveMessage(
+               TcpSocket                    *pSocket,
+               std::vector< unsigned char > *pPayload
+               )
+{
+
+  std::vector< unsigned char > headerBytes( sizeof( std::uint32_t ) * 2 + sizeof( std::uint64_t ) );
+  pSocket->receiveAll( headerBytes.data( ), headerBytes.size( ) );
+
+  MessageReader header( headerBytes );
+
+  std::uint32_t magic, type;
+  std::uint64_t size;
+
+  header.read( &magic );
+  header.read( &type );
+  header.read( &size );
+
+  if ( magic != protocolMagic )
+  {
+
+    throw std::runtime_error( "Received a message that is not part of the render protocol" );
+
+  }
+
+  if ( size > maxPayloadBytes )
+  {
+
+    throw std::runtime_error( "Render message payload is too large" );
+
+  }
+
+  pPayload->resize( static_cast< std::size_t >( size ) );
+
+  if ( size > 0 )
+  {
+
+    pSocket->receiveAll( pPayload->data( ), pPayload->size( ) );
+
+  }
+
+  return static_cast< MessageType >( type );
+
+} // receiveMessage
+
+
+
+std::vector< unsigned char >
+encode( const RenderSettings &settings )
+{
+
+  MessageWriter writer;
+
+  writer.write( settings.sceneType );
+  writer.write( settings.modelFile );
+  writer.write( settings.width );
+  writer.write( settings.height );
+  writer.write( settings.eye, 3 );
+  writer.write( settings.U,   3 );
+  writer.write( settings.V,   3 );
+  writer.write( settings.W,   3 );
+  writer.write( settings.displayType );
+  writer.write( settings.cameraType );
+  writer.write( settings.sqrtSamples );
+  writer.write( settings.maxBounces );
+  writer.write( settings.firstBounce );
+  writer.write( settings.globalSeed );
+  writer.write( static_cast< std::uint8_t >( settings.pathTracing ? 1 : 0 ) );
+  writer.write( settings.roulettePolicy );
+  writer.write( settings.rouletteMinDepth );
+  writer.write( settings.firstBounceSplits );
+  writer.write( settings.mathPrecision );
+
+  return std::move( writer.getBytes( ) );
+
+}
+
+
+
+std::vector< unsigned char >
+encode( const WorkUnit &unit )
+{
+
+  MessageWriter writer;
+  writeUnit( &writer, unit );
+  return std::move( writer.getBytes( ) );
+
+}
+
+
+
+std::vector< unsigned char >
+encode( const PartialResult &result )
+{
+
+  MessageWriter writer;
+
+  writeUnit( &writer, result.unit );
+  writer.write( result.samplesPerPixel );
+  writer.write( static_cast< std::uint64_t >( result.radianceSum.size( ) ) );
+  writer.write( result.radianceSum.data( ), result.radianceSum.size( ) );
+
+  return std::move( writer.getBytes( ) );
+
+}
+
+
+
+std::vector< unsigned char >
+encode( const std::string &text )
+{
+
+  MessageWriter writer;
+  writer.write( text );
+  return std::move( writer.getBytes( ) );
+
+}
+
+
+
+void
+decode(
+       const std::vector< unsigned char > &payload,
+       RenderSettings                     *pSettings
+       )
+{
+
+  MessageReader reader( payload );
+
+  std::uint8_t pathTracing;
+
+  reader.read( &pSettings->sceneType );
+  reader.read( &pSettings->modelFile );
+  reader.read( &pSettings->width );
+  reader.read( &pSettings->height );
+  reader.read( pSettings->eye, 3 );
+  reader.read( pSettings->U,   3 );
+  reader.read( pSettings->V,   3 );
+  reader.read( pSettings->W,   3 );
+  reader.read( &pSettings->displayType );
+  reader.read( &pSettings->cameraType );
+  reader.read( &pSettings->sqrtSamples );
+  reader.read( &pSettings->maxBounces );
+  reader.read( &pSettings->firstBounce );
+  reader.read( &pSettings->globalSeed );
+  reader.read( &pathTracing );
+  reader.read( &pSettings->roulettePolicy );
+  reader.read( &pSettings->rouletteMinDepth );
+  reader.read( &pSettings->firstBounceSplits );
+  reader.read( &pSettings->mathPrecision );
+
+  pSettings->pathTracing = ( pathTracing != 0 );
+
+}
+
+
+
+void
+decode(
+       const std::vector< unsigned char > &payload,
+       WorkUnit                           *pUnit
+       )
+{
+
+  MessageReader reader( payload );
+  readUnit( &reader, pUnit );
+
+}
+
+
+
+void
+decode(
+       const std::vector< unsigned char > &payload,
+       PartialResult                      *pResult
+       )
+{
+
+  MessageReader reader( payload );
+
+  std::uint64_t count;
+
+  readUnit( &reader, &pResult->unit );
+  reader.read( &pResult->samplesPerPixel );
+  reader.read( &count );
+
+  if ( count != static_cast< std::uint64_t >( pResult->unit.width ) * pResult->unit.height * 4 )
+  {
+
+    throw std::runtime_error( "Partial result size does not match its work unit" );
+
+  }
+
+  pResult->radianceSum.resize( static_cast< std::size_t >( count ) );
+  reader.read( pResult->radianceSum.data( ), pResult->radianceSum.size( ) );
+
+}
+
+
+
+void
+decode(
+       const std::vector< unsigned char > &payload,
+       std::string                        *pText
+       )
+{
+
+  MessageReader reader( payload );
+  reader.read( pText );
+
+}
+
+
+
+} // namespace light
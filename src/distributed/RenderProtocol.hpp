@@ -0,0 +1,135 @@
+#ifndef RenderProtocol_hpp
+#define RenderProtocol_hpp
+
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+
+namespace light
+{
+
+
+class TcpSocket;
+
+
+enum class MessageType : std::uint32_t
+{
+  SETUP    = 1, // coordinator -> worker : RenderSettings
+  WORK     = 2, // coordinator -> worker : WorkUnit
+  RESULT   = 3, // worker -> coordinator : PartialResult
+  SHUTDOWN = 4, // coordinator -> worker : no payload
+  FAILURE  = 5  // worker -> coordinator : error string
+};
+
+
+///
+/// \brief The RenderSettings struct
+///
+///        Everything a worker needs to build the same scene
+///        and camera as the coordinator. Workers that share
+///        a globalSeed produce the same sample streams as a
+///        single process render.
+///
+struct RenderSettings
+{
+  std::int32_t  sceneType   = 0;
+  std::string   modelFile;
+
+  std::uint32_t width       = 0;
+  std::uint32_t height      = 0;
+
+  float eye[ 3 ] = { 0.0f, 0.0f, 0.0f };
+  float U  [ 3 ] = { 0.0f, 0.0f, 0.0f };
+  float V  [ 3 ] = { 0.0f, 0.0f, 0.0f };
+  float W  [ 3 ] = { 0.0f, 0.0f, 0.0f };
+
+  std::int32_t  displayType = 0;
+  std::int32_t  cameraType  = 0;
+  std::uint32_t sqrtSamples = 1;
+  std::uint32_t maxBounces  = 3;
+  std::uint32_t firstBounce = 0;
+  std::uint32_t globalSeed  = 0;
+  bool          pathTracing = true;
+
+  // path termination, see Roulette.hpp. Work units restart the
+  // frame count, so the per-pixel moments ROULETTE_EFFICIENCY
+  // keeps never build up and workers refuse it.
+  std::uint32_t roulettePolicy    = 1; // ROULETTE_THROUGHPUT
+  std::uint32_t rouletteMinDepth  = 2;
+  std::uint32_t firstBounceSplits = 1;
+
+  std::uint32_t mathPrecision     = 0; // MathPrecision, MATH_PRECISE
+};
+
+
+///
+/// \brief The WorkUnit struct
+///
+///        A screen region rendered for a contiguous
+///        range of progressive frames
+///
+struct WorkUnit
+{
+  std::uint32_t x          = 0;
+  std::uint32_t y          = 0;
+  std::uint32_t width      = 0;
+  std::uint32_t height     = 0;
+  std::uint32_t firstFrame = 0;
+  std::uint32_t frameCount = 0;
+};
+
+
+///
+/// \brief The PartialResult struct
+///
+///        Un-normalized RGBA radiance sums for a work unit so the
+///        coordinator can weight results by sample count
+///
+struct PartialResult
+{
+  WorkUnit             unit;
+  std::uint32_t        samplesPerPixel = 0;
+  std::vector< float > radianceSum; // unit.width * unit.height * 4, row-major
+};
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief sendMessage
+///
+///        Writes a framed message: magic, type, payload size, payload
+///////////////////////////////////////////////////////////////
+void sendMessage (
+                  TcpSocket                          *pSocket,
+                  MessageType                         type,
+                  const std::vector< unsigned char > &payload = std::vector< unsigned char >( )
+                  );
+
+
+///////////////////////////////////////////////////////////////
+/// \brief receiveMessage
+/// \return the message type, payload is written to pPayload
+///////////////////////////////////////////////////////////////
+MessageType receiveMessage (
+                            TcpSocket                    *pSocket,
+                            std::vector< unsigned char > *pPayload
+                            );
+
+
+std::vector< unsigned char > encode ( const RenderSettings &settings );
+std::vector< unsigned char > encode ( const WorkUnit &unit );
+std::vector< unsigned char > encode ( const PartialResult &result );
+std::vector< unsigned char > encode ( const std::string &text );
+
+void decode ( const std::vector< unsigned char > &payload, RenderSettings *pSettings );
+void decode ( const std::vector< unsigned char > &payload, WorkUnit *pUnit );
+void decode ( const std::vector< unsigned char > &payload, PartialResult *pResult );
+void decode ( const std::vector< unsigned char > &payload, std::string *pText );
+
+
+} // namespace light
+
+
+#endif // RenderProtocol_hpp
@@ -0,0 +1,160 @@
+#include "RenderWorker.hpp"
+#include "Socket.hpp"
+#include <iostream>
+#include <stdexcept>
+
+
+namespace light
+{
+
+
+///////////////////////////////////////////////////////////////
+/// \brief RenderWorker::RenderWorker
+///////////////////////////////////////////////////////////////
+RenderWorker::RenderWorker(
+                           std::unique_ptr< WorkerRendererInterface > upRenderer,
+                           unsigned short                             port
+                           )
+  : upRenderer_( std::move( upRenderer ) )
+  , upListener_( new TcpListener( port ) )
+{}
+
+
+
+RenderWorker::~RenderWorker( )
+{}
+
+
+
+unsigned short
+RenderWorker::getPort( ) const
+{
+
+  return upListener_->getPort( );
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief RenderWorker::serve
+///////////////////////////////////////////////////////////////
+void
+RenderWorker::serve( )
+{
+
+  bool running = true;
+
+  while ( running )
+  {
+
+    TcpSocket socket = upListener_->accept( );
+
+    try
+    {
+
+      running = _serveConnection( &socket );
+
+    }
+    catch ( const ConnectionClosedError& )
+    {
+      // coordinator finished its render
+    }
+    catch ( const std::exception &e )
+    {
+
+      // a dropped coordinator shouldn't take the worker down
+      std::cerr << "Render worker connection ended: " << e.what( ) << std::endl;
+
+    }
+
+  }
+
+} // RenderWorker::serve
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief RenderWorker::_serveConnection
+/// \param pSocket
+/// \return
+///////////////////////////////////////////////////////////////
+bool
+RenderWorker::_serveConnection( TcpSocket *pSocket )
+{
+
+  std::vector< unsigned char > payload;
+
+  bool hasSettings = false;
+
+  while ( true )
+  {
+
+    MessageType type = receiveMessage( pSocket, &payload );
+
+    try
+    {
+
+      switch ( type )
+      {
+
+      case MessageType::SETUP:
+      {
+
+        RenderSettings settings;
+        decode( payload, &settings );
+
+        upRenderer_->setup( settings );
+        hasSettings = true;
+
+        sendMessage( pSocket, MessageType::RESULT );
+        break;
+
+      }
+
+      case MessageType::WORK:
+      {
+
+        if ( !hasSettings )
+        {
+
+          throw std::runtime_error( "Work received before render settings" );
+
+        }
+
+        PartialResult result;
+        WorkUnit unit;
+
+        decode( payload, &unit );
+        upRenderer_->render( unit, &result );
+
+        result.unit = unit;
+        sendMessage( pSocket, MessageType::RESULT, encode( result ) );
+        break;
+
+      }
+
+      case MessageType::SHUTDOWN:
+        return false;
+
+      default:
+        throw std::runtime_error( "Unexpected message sent to render worker" );
+
+      } // switch
+
+    }
+    catch ( const std::exception &e )
+    {
+
+      // report the failure so the coordinator can reassign the unit
+      sendMessage( pSocket, MessageType::FAILURE, encode( std::string( e.what( ) ) ) );
+
+    }
+
+  }
+
+} // RenderWorker::_serveConnection
+
+
+
+} // namespace light
@@ -0,0 +1,109 @@
+#ifndef RenderWorker_hpp
+#define RenderWorker_hpp
+
+
+#include <memory>
+#include "RenderProtocol.hpp"
+
+
+namespace light
+{
+
+
+class TcpListener;
+
+
+/////////////////////////////////////////////
+/// \brief The WorkerRendererInterface class
+///
+///        Backend used by a worker to render work units.
+///        Implementations return un-normalized radiance sums.
+/////////////////////////////////////////////
+class WorkerRendererInterface
+{
+
+public:
+
+  virtual
+  ~WorkerRendererInterface( ) {}
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief setup
+  ///
+  ///        Builds the scene and camera described by settings.
+  ///        Called once per coordinator render.
+  ///////////////////////////////////////////////////////////////
+  virtual
+  void setup ( const RenderSettings &settings ) = 0;
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief render
+  /// \param unit region and frame range to render
+  /// \param pResult filled with radiance sums and samples per pixel
+  ///////////////////////////////////////////////////////////////
+  virtual
+  void render (
+               const WorkUnit &unit,
+               PartialResult  *pResult
+               ) = 0;
+
+};
+
+
+
+/////////////////////////////////////////////
+/// \brief The RenderWorker class
+///
+///        Serves work units to a single coordinator
+///        connection at a time
+/////////////////////////////////////////////
+class RenderWorker
+{
+
+public:
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief RenderWorker
+  /// \param upRenderer backend that renders the work units
+  /// \param port port to listen on, 0 picks a free one
+  ///////////////////////////////////////////////////////////////
+  RenderWorker(
+               std::unique_ptr< WorkerRendererInterface > upRenderer,
+               unsigned short                             port = 0
+               );
+
+  ~RenderWorker( );
+
+
+  unsigned short getPort ( ) const;
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief serve
+  ///
+  ///        Accepts coordinator connections and renders work
+  ///        until a SHUTDOWN message arrives
+  ///////////////////////////////////////////////////////////////
+  void serve ( );
+
+
+private:
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief _serveConnection
+  /// \return false once the coordinator asks the worker to exit
+  ///////////////////////////////////////////////////////////////
+  bool _serveConnection ( TcpSocket *pSocket );
+
+  std::unique_ptr< WorkerRendererInterface > upRenderer_;
+  std::unique_ptr< TcpListener >             upListener_;
+
+};
+
+
+} // namespace light
+
+
+#endif // RenderWorker_hpp
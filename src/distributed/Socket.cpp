@@ -0,0 +1,438 @@
+#include "Socket.hpp"
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <netdb.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#endif
+
+
+namespace light
+{
+
+
+namespace
+{
+
+
+#ifdef _WIN32
+
+const SocketHandle invalidSocket = static_cast< SocketHandle >( INVALID_SOCKET );
+
+///
+/// \brief The WinsockInit struct
+///
+///        Starts winsock once for the whole process
+///
+struct WinsockInit
+{
+
+  WinsockInit( )
+  {
+    WSADATA data;
+    WSAStartup( MAKEWORD( 2, 2 ), &data );
+  }
+
+  ~WinsockInit( )
+  {
+    WSACleanup( );
+  }
+
+};
+
+void
+ensureSocketsInitialized( )
+{
+
+  static WinsockInit init;
+
+}
+
+void
+closeHandle( SocketHandle handle )
+{
+
+  closesocket( static_cast< SOCKET >( handle ) );
+
+}
+
+#else
+
+const SocketHandle invalidSocket = -1;
+
+void
+ensureSocketsInitialized( )
+{}
+
+void
+closeHandle( SocketHandle handle )
+{
+
+  ::close( handle );
+
+}
+
+#endif
+
+
+#if defined( MSG_NOSIGNAL )
+constexpr int sendFlags = MSG_NOSIGNAL; // report closed peers as errors instead of SIGPIPE
+#else
+constexpr int sendFlags = 0;
+#endif
+
+
+///
+/// \brief disableNagle
+///
+///        Messages are written header then payload, so don't
+///        let the kernel hold back the small header
+///
+void
+disableNagle( SocketHandle handle )
+{
+
+  int flag = 1;
+  setsockopt(
+             handle,
+             IPPROTO_TCP,
+             TCP_NODELAY,
+             reinterpret_cast< const char* >( &flag ),
+             sizeof( flag )
+             );
+
+#if defined( SO_NOSIGPIPE )
+  setsockopt( handle, SOL_SOCKET, SO_NOSIGPIPE, &flag, sizeof( flag ) );
+#endif
+
+}
+
+
+} // namespace
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief TcpSocket::TcpSocket
+///////////////////////////////////////////////////////////////
+TcpSocket::TcpSocket( )
+  : handle_( invalidSocket )
+{}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief TcpSocket::TcpSocket
+/// \param handle
+///////////////////////////////////////////////////////////////
+TcpSocket::TcpSocket( SocketHandle handle )
+  : handle_( handle )
+{
+
+  disableNagle( handle_ );
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief TcpSocket::~TcpSocket
+///////////////////////////////////////////////////////////////
+TcpSocket::~TcpSocket( )
+{
+
+  close( );
+
+}
+
+
+
+TcpSocket::TcpSocket( TcpSocket &&other )
+  : handle_( other.handle_ )
+{
+
+  other.handle_ = invalidSocket;
+
+}
+
+
+
+TcpSocket &
+TcpSocket::operator=( TcpSocket &&other )
+{
+
+  if ( this != &other )
+  {
+
+    close( );
+    handle_       = other.handle_;
+    other.handle_ = invalidSocket;
+
+  }
+
+  return *this;
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief TcpSocket::connect
+/// \param host
+/// \param port
+/// \return
+///////////////////////////////////////////////////////////////
+TcpSocket
+TcpSocket::connect(
+                   const std::string &host,
+                   unsigned short     port
+                   )
+{
+
+  ensureSocketsInitialized( );
+
+  addrinfo hints;
+  std::memset( &hints, 0, sizeof( hints ) );
+  hints.ai_family   = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+
+  addrinfo *pResults = nullptr;
+
+  if ( getaddrinfo( host.c_str( ), std::to_string( port ).c_str( ), &hints, &pResults ) != 0 )
+  {
+
+    throw std::runtime_error( "Could not resolve host '" + host + "'" );
+
+  }
+
+  SocketHandle handle = invalidSocket;
+
+  for ( addrinfo *pAddr = pResults; pAddr; pAddr = pAddr->ai_next )
+  {
+
+    handle = static_cast< SocketHandle >( socket( pAddr->ai_family, pAddr->ai_socktype, pAddr->ai_protocol ) );
+
+    if ( handle == invalidSocket )
+    {
+      continue;
+    }
+
+    if ( ::connect( handle, pAddr->ai_addr, static_cast< int >( pAddr->ai_addrlen ) ) == 0 )
+    {
+      break;
+    }
+
+    closeHandle( handle );
+    handle = invalidSocket;
+
+  }
+
+  freeaddrinfo( pResults );
+
+  if ( handle == invalidSocket )
+  {
+
+    throw std::runtime_error( "Could not connect to " + host + ":" + std::to_string( port ) );
+
+  }
+
+  return TcpSocket( handle );
+
+} // TcpSocket::connect
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief TcpSocket::sendAll
+/// \param pData
+/// \param bytes
+///////////////////////////////////////////////////////////////
+void
+TcpSocket::sendAll(
+                   const void *pData,
+                   std::size_t bytes
+                   )
+{
+
+  const char *pBytes = static_cast< const char* >( pData );
+
+  while ( bytes > 0 )
+  {
+
+    int chunk = static_cast< int >( std::min< std::size_t >( bytes, 1 << 30 ) );
+    auto sent = ::send( handle_, pBytes, chunk, sendFlags );
+
+    if ( sent <= 0 )
+    {
+
+      throw std::runtime_error( "Socket send failed" );
+
+    }
+
+    pBytes += sent;
+    bytes  -= static_cast< std::size_t >( sent );
+
+  }
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief TcpSocket::receiveAll
+/// \param pData
+/// \param bytes
+///////////////////////////////////////////////////////////////
+void
+TcpSocket::receiveAll(
+                      void       *pData,
+                      std::size_t bytes
+                      )
+{
+
+  char *pBytes = static_cast< char* >( pData );
+
+  while ( bytes > 0 )
+  {
+
+    int chunk     = static_cast< int >( std::min< std::size_t >( bytes, 1 << 30 ) );
+    auto received = ::recv( handle_, pBytes, chunk, 0 );
+
+    if ( received == 0 )
+    {
+
+      throw ConnectionClosedError( );
+
+    }
+
+    if ( received < 0 )
+    {
+
+      throw std::runtime_error( "Socket receive failed" );
+
+    }
+
+    pBytes += received;
+    bytes  -= static_cast< std::size_t >( received );
+
+  }
+
+}
+
+
+
+bool
+TcpSocket::isOpen( ) const
+{
+
+  return handle_ != invalidSocket;
+
+}
+
+
+
+void
+TcpSocket::close( )
+{
+
+  if ( isOpen( ) )
+  {
+
+    closeHandle( handle_ );
+    handle_ = invalidSocket;
+
+  }
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief TcpListener::TcpListener
+/// \param port
+///////////////////////////////////////////////////////////////
+TcpListener::TcpListener( unsigned short port )
+  : handle_( invalidSocket )
+  , port_  ( port )
+{
+
+  ensureSocketsInitialized( );
+
+  handle_ = static_cast< SocketHandle >( socket( AF_INET, SOCK_STREAM, 0 ) );
+
+  if ( handle_ == invalidSocket )
+  {
+
+    throw std::runtime_error( "Could not create listening socket" );
+
+  }
+
+  int reuse = 1;
+  setsockopt( handle_, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast< const char* >( &reuse ), sizeof( reuse ) );
+
+  sockaddr_in address;
+  std::memset( &address, 0, sizeof( address ) );
+  address.sin_family      = AF_INET;
+  address.sin_addr.s_addr = htonl( INADDR_ANY );
+  address.sin_port        = htons( port );
+
+  if ( bind( handle_, reinterpret_cast< sockaddr* >( &address ), sizeof( address ) ) != 0
+      || listen( handle_, 16 ) != 0 )
+  {
+
+    closeHandle( handle_ );
+    throw std::runtime_error( "Could not listen on port " + std::to_string( port ) );
+
+  }
+
+  socklen_t length = sizeof( address );
+  getsockname( handle_, reinterpret_cast< sockaddr* >( &address ), &length );
+
+  port_ = ntohs( address.sin_port );
+
+} // TcpListener::TcpListener
+
+
+
+TcpListener::~TcpListener( )
+{
+
+  closeHandle( handle_ );
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief TcpListener::accept
+/// \return
+///////////////////////////////////////////////////////////////
+TcpSocket
+TcpListener::accept( )
+{
+
+  SocketHandle client = static_cast< SocketHandle >( ::accept( handle_, nullptr, nullptr ) );
+
+  if ( client == invalidSocket )
+  {
+
+    throw std::runtime_error( "Failed to accept connection" );
+
+  }
+
+  return TcpSocket( client );
+
+}
+
+
+
+} // namespace light
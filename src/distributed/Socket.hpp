@@ -0,0 +1,162 @@
+#ifndef Socket_hpp
+#define Socket_hpp
+
+
+#include <string>
+#include <cstddef>
+#include <stdexcept>
+#include <cstdint>
+
+
+namespace light
+{
+
+
+#ifdef _WIN32
+typedef std::uintptr_t SocketHandle;
+#else
+typedef int SocketHandle;
+#endif
+
+
+///
+/// \brief The ConnectionClosedError class
+///
+///        Thrown when the peer closes the connection cleanly
+///
+class ConnectionClosedError : public std::runtime_error
+{
+
+public:
+
+  ConnectionClosedError( )
+    : std::runtime_error( "Connection closed by peer" )
+  {}
+
+};
+
+
+
+/////////////////////////////////////////////
+/// \brief The TcpSocket class
+///
+///        Blocking TCP connection. Errors and closed
+///        connections are reported with std::runtime_error.
+/////////////////////////////////////////////
+class TcpSocket
+{
+
+public:
+
+  TcpSocket( );
+
+  explicit
+  TcpSocket( SocketHandle handle );
+
+  ~TcpSocket( );
+
+  TcpSocket( TcpSocket &&other );
+  TcpSocket &operator=( TcpSocket &&other );
+
+  TcpSocket( const TcpSocket& )            = delete;
+  TcpSocket &operator=( const TcpSocket& ) = delete;
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief connect
+  /// \param host name or address of the remote machine
+  /// \param port remote port
+  ///////////////////////////////////////////////////////////////
+  static
+  TcpSocket connect (
+                     const std::string &host,
+                     unsigned short     port
+                     );
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief sendAll
+  ///
+  ///        Blocks until every byte has been written
+  ///////////////////////////////////////////////////////////////
+  void sendAll (
+                const void *pData,
+                std::size_t bytes
+                );
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief receiveAll
+  ///
+  ///        Blocks until 'bytes' bytes have been read. Throws if
+  ///        the connection closes first.
+  ///////////////////////////////////////////////////////////////
+  void receiveAll (
+                   void       *pData,
+                   std::size_t bytes
+                   );
+
+
+  bool isOpen ( ) const;
+
+  void close ( );
+
+
+private:
+
+  SocketHandle handle_;
+
+};
+
+
+
+/////////////////////////////////////////////
+/// \brief The TcpListener class
+///
+///        Accepts incoming connections on a port
+/////////////////////////////////////////////
+class TcpListener
+{
+
+public:
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief TcpListener
+  /// \param port port to listen on, 0 picks a free one
+  ///////////////////////////////////////////////////////////////
+  explicit
+  TcpListener( unsigned short port = 0 );
+
+  ~TcpListener( );
+
+  TcpListener( const TcpListener& )            = delete;
+  TcpListener &operator=( const TcpListener& ) = delete;
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief getPort
+  /// \return the port actually bound
+  ///////////////////////////////////////////////////////////////
+  unsigned short getPort ( ) const { return port_; }
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief accept
+  ///
+  ///        Blocks until a client connects
+  ///////////////////////////////////////////////////////////////
+  TcpSocket accept ( );
+
+
+private:
+
+  SocketHandle   handle_;
+  unsigned short port_;
+
+};
+
+
+} // namespace light
+
+
+#endif // Socket_hpp
@@ -1,8 +1,80 @@
+#include <cstdlib>
 #include <iostream>
 #include "driver/Driver.hpp"
 #include "world/World.hpp"
 #include "LightBenderIOHandler.hpp"
 #include "LightBenderConfig.hpp"
+#include "DistributedMain.hpp"
+#include "BatchRender.hpp"
+#include "BvhReportCommand.hpp"
+#include "ScalingCommand.hpp"
+#include "CompareCommand.hpp"
+#include "ConvergenceCommand.hpp"
+#include "BenchmarkCompareCommand.hpp"
+#include "Trace.hpp"
+
+
+
+namespace
+{
+
+
+///
+/// \brief The TraceSession struct
+///
+///        LIGHT_TRACE=<file.json> records a timeline of the
+///        whole run, written when main returns
+///
+struct TraceSession
+{
+
+  const char *pFilename;
+
+
+  TraceSession( )
+    : pFilename( std::getenv( "LIGHT_TRACE" ) )
+  {
+
+    if ( pFilename )
+    {
+
+      light::setTraceThreadName( "main" );
+      light::startTrace( );
+
+    }
+
+  }
+
+
+  ~TraceSession( )
+  {
+
+    if ( pFilename )
+    {
+
+      light::stopTrace( );
+
+      try
+      {
+
+        light::writeTraceJson( pFilename );
+
+      }
+      catch ( const std::exception &e )
+      {
+
+        std::cerr << "ERROR: " << e.what( ) << std::endl;
+
+      }
+
+    }
+
+  }
+
+};
+
+
+} // namespace
 
 
 
@@ -26,9 +98,66 @@ main(
                                      light::VERSION_PATCH
                                      );
 
+    TraceSession traceSession;
+
     try
     {
 
+      //
+      // headless worker, distributed render, camera
+      // path batch render, BVH report, host scaling
+      // benchmark, image comparison or convergence
+      // curves, no window needed
+      //
+      if ( light::isDistributedCommand( argc, argv ) )
+      {
+
+        return light::runDistributedCommand( argc, argv );
+
+      }
+
+      if ( light::isBatchCommand( argc, argv ) )
+      {
+
+        return light::runBatchCommand( argc, argv );
+
+      }
+
+      if ( light::isBvhReportCommand( argc, argv ) )
+      {
+
+        return light::runBvhReportCommand( argc, argv );
+
+      }
+
+      if ( light::isScalingCommand( argc, argv ) )
+      {
+
+        return light::runScalingCommand( argc, argv );
+
+      }
+
+      if ( light::isCompareCommand( argc, argv ) )
+      {
+
+        return light::runCompareCommand( argc, argv );
+
+      }
+
+      if ( light::isConvergenceCommand( argc, argv ) )
+      {
+
+        return light::runConvergenceCommand( argc, argv );
+
+      }
+
+      if ( light::isBenchmarkCompareCommand( argc, argv ) )
+      {
+
+        return light::runBenchmarkCompareCommand( argc, argv );
+
+      }
+
       //
       // create world to handle physical updates
       // and ioHandler to interface between the
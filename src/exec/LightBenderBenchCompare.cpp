@@ -0,0 +1,42 @@
+#include <vector>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include "BenchmarkCompareCommand.hpp"
+
+
+
+/////////////////////////////////////////////
+/// \brief main
+///
+///        lightbender-bench-compare baseline.json test.json [test.json ...] [options]
+///
+///        Same as runLightBender --bench-compare without the GPU
+///        dependencies, for nightly performance jobs
+/////////////////////////////////////////////
+int
+main(
+     int          argc, ///< number of arguments
+     const char **argv  ///< array of argument strings
+     )
+{
+
+  std::vector< const char* > args = { argv[ 0 ], "--bench-compare" };
+  args.insert( args.end( ), argv + 1, argv + argc );
+
+  try
+  {
+
+    return light::runBenchmarkCompareCommand( static_cast< int >( args.size( ) ), args.data( ) );
+
+  }
+  catch ( const std::exception &e )
+  {
+
+    std::cerr << "ERROR: " << e.what( ) << std::endl;
+
+  }
+
+  return EXIT_FAILURE;
+
+}
@@ -0,0 +1,42 @@
+#include <vector>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include "CompareCommand.hpp"
+
+
+
+/////////////////////////////////////////////
+/// \brief main
+///
+///        lightbender-compare reference test [test ...] [options]
+///
+///        Same as runLightBender --compare without the GPU
+///        dependencies, for scoring frames on any machine
+/////////////////////////////////////////////
+int
+main(
+     int          argc, ///< number of arguments
+     const char **argv  ///< array of argument strings
+     )
+{
+
+  std::vector< const char* > args = { argv[ 0 ], "--compare" };
+  args.insert( args.end( ), argv + 1, argv + argc );
+
+  try
+  {
+
+    return light::runCompareCommand( static_cast< int >( args.size( ) ), args.data( ) );
+
+  }
+  catch ( const std::exception &e )
+  {
+
+    std::cerr << "ERROR: " << e.what( ) << std::endl;
+
+  }
+
+  return EXIT_FAILURE;
+
+}
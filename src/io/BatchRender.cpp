@@ -0,0 +1,423 @@
+#include "BatchRender.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <memory>
+#include <sstream>
+#include <iostream>
+#include <stdexcept>
+#include "glm/glm.hpp"
+#include "graphics/Camera.hpp"
+#include "LightBenderConfig.hpp"
+#include "CameraPath.hpp"
+#include "ImageIO.hpp"
+#include "Instrumentation.hpp"
+#include "MemoryAccounting.hpp"
+#include "OptixScene.hpp"
+#include "OptixSceneFactory.hpp"
+#include "PathStatistics.hpp"
+
+
+namespace light
+{
+
+
+namespace
+{
+
+
+const std::string batchFlag = "--render-path";
+
+
+struct BatchOptions
+{
+  int         sceneType   = 1;
+  std::string modelFile;
+  unsigned    width       = 1280;
+  unsigned    height      = 720;
+  unsigned    frames      = 64;
+  unsigned    sqrtSamples = 1;
+  unsigned    maxBounces  = 5;
+  unsigned    firstBounce = 0;
+  unsigned    seed        = 1234;
+  unsigned    turntable   = 0;
+  unsigned    views       = 0;
+  unsigned    pathStats   = 0;
+  std::string math        = "precise";
+  std::string roulette    = "efficiency";
+  unsigned    minDepth    = 2;
+  unsigned    splits      = 1;
+  float       orbit[ 3 ]  = { 20.0f, 45.0f, -30.0f };
+  std::string pathFile;
+  std::string output      = "lightBenderPath";
+};
+
+
+void
+parseOptions(
+             int           argc,
+             const char  **argv,
+             BatchOptions *pOptions
+             )
+{
+
+  for ( int i = 2; i < argc; ++i )
+  {
+
+    std::string flag( argv[ i ] );
+
+    if ( i + 1 >= argc )
+    {
+
+      throw std::runtime_error( "Missing value for " + flag );
+
+    }
+
+    std::string value( argv[ ++i ] );
+
+    if      ( flag == "--path" )         { pOptions->pathFile    = value; }
+    else if ( flag == "--turntable" )    { pOptions->turntable   = static_cast< unsigned >( std::stoul( value ) ); }
+    else if ( flag == "--views" )        { pOptions->views       = static_cast< unsigned >( std::stoul( value ) ); }
+    else if ( flag == "--scene" )        { pOptions->sceneType   = std::stoi( value ); }
+    else if ( flag == "--model" )        { pOptions->modelFile   = value; }
+    else if ( flag == "--width" )        { pOptions->width       = static_cast< unsigned >( std::stoul( value ) ); }
+    else if ( flag == "--height" )       { pOptions->height      = static_cast< unsigned >( std::stoul( value ) ); }
+    else if ( flag == "--frames" )       { pOptions->frames      = static_cast< unsigned >( std::stoul( value ) ); }
+    else if ( flag == "--sqrt-samples" ) { pOptions->sqrtSamples = static_cast< unsigned >( std::stoul( value ) ); }
+    else if ( flag == "--max-bounces" )  { pOptions->maxBounces  = static_cast< unsigned >( std::stoul( value ) ); }
+    else if ( flag == "--first-bounce" ) { pOptions->firstBounce = static_cast< unsigned >( std::stoul( value ) ); }
+    else if ( flag == "--seed" )         { pOptions->seed        = static_cast< unsigned >( std::stoul( value ) ); }
+    else if ( flag == "--output" )       { pOptions->output      = value; }
+    else if ( flag == "--path-stats" )   { pOptions->pathStats   = static_cast< unsigned >( std::stoul( value ) ); }
+    else if ( flag == "--math" )         { pOptions->math        = value; }
+    else if ( flag == "--roulette" )     { pOptions->roulette    = value; }
+    else if ( flag == "--min-depth" )    { pOptions->minDepth    = static_cast< unsigned >( std::stoul( value ) ); }
+    else if ( flag == "--splits" )       { pOptions->splits      = static_cast< unsigned >( std::stoul( value ) ); }
+    else if ( flag == "--orbit" )
+    {
+
+      std::stringstream stream( value );
+      std::string part;
+      unsigned c = 0;
+
+      while ( std::getline( stream, part, ',' ) )
+      {
+
+        if ( c >= 3 )
+        {
+          break;
+        }
+
+        pOptions->orbit[ c++ ] = std::stof( part );
+
+      }
+
+      if ( c != 3 )
+      {
+        throw std::runtime_error( "--orbit expects zoom,dx,dy" );
+      }
+
+    }
+    else
+    {
+
+      throw std::runtime_error( "Unknown option " + flag );
+
+    }
+
+  }
+
+  if ( pOptions->math != "precise" && pOptions->math != "fast" )
+  {
+
+    throw std::runtime_error( "--math is precise or fast, not " + pOptions->math );
+
+  }
+
+  if ( pOptions->roulette != "albedo" && pOptions->roulette != "throughput" && pOptions->roulette != "efficiency" )
+  {
+
+    throw std::runtime_error( "--roulette is albedo, throughput or efficiency, not " + pOptions->roulette );
+
+  }
+
+  if ( pOptions->splits == 0 )
+  {
+
+    throw std::runtime_error( "--splits needs at least one bounce" );
+
+  }
+
+  if ( pOptions->pathFile.empty( ) == ( pOptions->turntable == 0 ) )
+  {
+
+    throw std::runtime_error( "Batch renders need exactly one of --path or --turntable" );
+
+  }
+
+  if ( pOptions->width == 0 || pOptions->height == 0 || pOptions->frames == 0 )
+  {
+
+    throw std::runtime_error( "Batch renders need a non-empty image and at least one frame" );
+
+  }
+
+} // parseOptions
+
+
+///
+/// \brief makeOrbitCamera
+///
+///        Camera posed the way the viewer and distributed
+///        renders pose it: orbit deltas from a fresh camera
+///
+void
+makeOrbitCamera(
+                const BatchOptions &options,
+                const OrbitKey     &key,
+                glm::vec3          *pEye,
+                glm::vec3          *pU,
+                glm::vec3          *pV,
+                glm::vec3          *pW
+                )
+{
+
+  graphics::Camera camera;
+  camera.setAspectRatio( options.width * 1.0f / options.height );
+  camera.updateOrbit( key.zoom, key.dx, key.dy );
+
+  *pEye = glm::vec3( camera.getEye( ) );
+  camera.buildRayBasisVectors( pU, pV, pW );
+
+}
+
+
+glm::vec3
+toGlm( Float3 v )
+{
+
+  return glm::vec3( v.x, v.y, v.z );
+
+}
+
+
+std::string
+frameFilename(
+              const std::string &prefix,
+              std::size_t        index
+              )
+{
+
+  char number[ 16 ];
+  std::snprintf( number, sizeof( number ), "_%04u.ppm", static_cast< unsigned >( index ) );
+
+  return light::OUTPUT_PATH + prefix + number;
+
+}
+
+
+RoulettePolicy
+toRoulettePolicy( const std::string &name )
+{
+
+  if ( name == "albedo" )
+  {
+    return ROULETTE_ALBEDO;
+  }
+
+  return name == "throughput" ? ROULETTE_THROUGHPUT : ROULETTE_EFFICIENCY;
+
+}
+
+
+} // namespace
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief isBatchCommand
+///////////////////////////////////////////////////////////////
+bool
+isBatchCommand(
+               int          argc,
+               const char **argv
+               )
+{
+
+  return argc > 1 && argv[ 1 ] == batchFlag;
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief runBatchCommand
+///////////////////////////////////////////////////////////////
+int
+runBatchCommand(
+                int          argc,
+                const char **argv
+                )
+{
+
+  BatchOptions options;
+  parseOptions( argc, argv, &options );
+
+  OrbitKey   start = { 0.0f, options.orbit[ 0 ], options.orbit[ 1 ], options.orbit[ 2 ] };
+  CameraPath path  = options.pathFile.empty( )
+                     ? CameraPath::makeTurntable( start, options.turntable )
+                     : CameraPath::read( options.pathFile );
+
+  std::vector< CameraShot > shots = path.getShots( options.views );
+
+  //
+  // explicit views borrow the orbit camera's field of view
+  //
+  glm::vec3 eye, U, V, W;
+  makeOrbitCamera( options, start, &eye, &U, &V, &W );
+
+  float halfWidth  = glm::length( U ) / glm::length( W );
+  float halfHeight = glm::length( V ) / glm::length( W );
+
+  using Clock = std::chrono::steady_clock;
+
+  Clock::time_point setupStart = Clock::now( );
+
+  //
+  // the scene and its acceleration structure are built once,
+  // every view after this only launches rays
+  //
+  std::unique_ptr< OptixScene > upScene = createOptixScene(
+                                                           options.sceneType,
+                                                           static_cast< int >( options.width ),
+                                                           static_cast< int >( options.height ),
+                                                           0,
+                                                           options.modelFile
+                                                           );
+
+  upScene->setDisplayType ( 2 );
+  upScene->setPathTracing ( true );
+  upScene->setMaxBounces  ( options.maxBounces );
+  upScene->setFirstBounce ( options.firstBounce );
+  upScene->setSqrtSamples ( options.sqrtSamples );
+  upScene->setGlobalSeed  ( options.seed );
+  upScene->setPathStatistics( options.pathStats != 0 );
+  upScene->setMathPrecision ( options.math == "fast" ? MATH_FAST : MATH_PRECISE );
+  upScene->setRoulette      ( toRoulettePolicy( options.roulette ), options.minDepth );
+  upScene->setFirstBounceSplits( options.splits );
+
+  double setupSeconds = std::chrono::duration< double >( Clock::now( ) - setupStart ).count( );
+
+  resetProfile( );
+
+  std::cout << "Scene ready in " << setupSeconds << " s, rendering "
+            << shots.size( ) << " views" << std::endl;
+
+  FrameWriter writer;
+
+  std::size_t pixelFloats = static_cast< std::size_t >( options.width ) * options.height * 4;
+  double      renderSeconds = 0.0;
+
+  // each view restarts the device counts, so they are merged here
+  PathStatistics pathStatistics;
+
+  for ( std::size_t i = 0; i < shots.size( ); ++i )
+  {
+
+    const CameraShot &shot = shots[ i ];
+
+    if ( shot.orbit )
+    {
+
+      makeOrbitCamera( options, shot.key, &eye, &U, &V, &W );
+
+    }
+    else
+    {
+
+      Float3 u, v, w;
+      makeLookAtBasis( shot.view, halfWidth, halfHeight, &u, &v, &w );
+
+      eye = toGlm( shot.view.eye );
+      U   = toGlm( u );
+      V   = toGlm( v );
+      W   = toGlm( w );
+
+    }
+
+    Clock::time_point viewStart = Clock::now( );
+
+    upScene->setCamera( eye, U, V, W );
+    upScene->resetFrameCount( );
+
+    for ( unsigned frame = 0; frame < options.frames; ++frame )
+    {
+
+      upScene->renderRegion( 0, 0, options.width, options.height );
+
+    }
+
+    std::vector< float > rgba;
+
+    {
+
+      LIGHT_PROFILE_SCOPE( READBACK );
+
+      optix::Buffer buffer = upScene->getBuffer( );
+
+      const float *pPixels = static_cast< const float* >( buffer->map( ) );
+      rgba.assign( pPixels, pPixels + pixelFloats );
+      buffer->unmap( );
+
+    }
+
+    if ( options.pathStats != 0 )
+    {
+      pathStatistics.merge( upScene->getPathStatistics( ) );
+    }
+
+    renderSeconds += std::chrono::duration< double >( Clock::now( ) - viewStart ).count( );
+
+    // encoding and disk I/O overlap with the next view
+    writer.submit( frameFilename( options.output, i ), options.width, options.height, std::move( rgba ) );
+
+  }
+
+  writer.wait( );
+
+  std::vector< std::string > errors = writer.getErrors( );
+
+  for ( const std::string &error : errors )
+  {
+
+    std::cerr << "ERROR: " << error << std::endl;
+
+  }
+
+  std::cout << "Rendered " << shots.size( ) << " views in " << renderSeconds << " s ("
+            << ( shots.empty( ) ? 0.0 : renderSeconds / shots.size( ) ) << " s per view), saved to "
+            << frameFilename( options.output, 0 ) << "..." << std::endl;
+
+  if ( options.pathStats != 0 )
+  {
+
+    writePathStatisticsJson( light::OUTPUT_PATH + options.output + "_paths.json", pathStatistics );
+
+  }
+
+  // peaks include building the scene, current is what the loaded scene holds
+  writeMemoryJson( light::OUTPUT_PATH + options.output + "_memory.json", getMemorySnapshot( ) );
+
+#ifdef LIGHT_INSTRUMENTATION
+  writeProfileJson( light::OUTPUT_PATH + options.output + "_profile.json", getProfileSnapshot( ) );
+#endif
+
+  return errors.empty( ) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+} // runBatchCommand
+
+
+
+} // namespace light
@@ -0,0 +1,61 @@
+#ifndef BatchRender_hpp
+#define BatchRender_hpp
+
+
+namespace light
+{
+
+
+///////////////////////////////////////////////////////////////
+/// \brief isBatchCommand
+/// \return true if the arguments ask for a batch render of a
+///         camera path instead of the interactive viewer
+///////////////////////////////////////////////////////////////
+bool isBatchCommand (
+                     int          argc,
+                     const char **argv
+                     );
+
+
+///////////////////////////////////////////////////////////////
+/// \brief runBatchCommand
+///
+///        Loads the scene and builds its acceleration structure
+///        once, then renders every view of a camera path back to
+///        back, handing finished frames to a background writer.
+///
+///        --render-path [options]
+///            --path file               orbit keys or explicit views,
+///                                      see CameraPath
+///            --turntable N             N views one full orbit apart
+///            --views N                 views sampled from orbit keys,
+///                                      0 for one per key
+///            --orbit zoom,dx,dy        turntable start like the viewer
+///            --scene N                 0 basic, 1 advanced, 2 model,
+///                                      3 scene file, 4 stress scene
+///            --model file              mesh, scene description or
+///                                      stress scene options
+///            --width W --height H      image size
+///            --frames N                progressive frames per view
+///            --sqrt-samples N          samples per frame (squared)
+///            --max-bounces N --first-bounce N
+///            --seed N                  random seed shared by all views
+///            --output prefix           frames are saved as prefix_0000.ppm
+///            --path-stats 1            also write prefix_paths.json
+///            --math precise|fast       bsdf math, see FastMath.hpp
+///            --roulette policy         albedo, throughput or efficiency
+///            --min-depth N             bounces before roulette can end paths
+///            --splits N                bounces from each camera ray's first hit
+///
+/// \return process exit code
+///////////////////////////////////////////////////////////////
+int runBatchCommand (
+                     int          argc,
+                     const char **argv
+                     );
+
+
+} // namespace light
+
+
+#endif // BatchRender_hpp
@@ -0,0 +1,291 @@
+#include "BenchmarkCompareCommand.hpp"
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include "BenchmarkComparison.hpp"
+
+
+namespace light
+{
+
+
+namespace
+{
+
+
+const std::string benchmarkCompareFlag = "--bench-compare";
+
+
+struct BenchmarkCommandOptions
+{
+  std::vector< std::string > files; // baseline first
+  BenchmarkCompareOptions    compare;
+  std::string                json;
+};
+
+
+void
+parseOptions(
+             int                      argc,
+             const char             **argv,
+             BenchmarkCommandOptions *pOptions
+             )
+{
+
+  for ( int i = 2; i < argc; ++i )
+  {
+
+    std::string arg( argv[ i ] );
+
+    if ( arg.compare( 0, 2, "--" ) != 0 )
+    {
+
+      pOptions->files.push_back( arg );
+      continue;
+
+    }
+
+    if ( i + 1 >= argc )
+    {
+
+      throw std::runtime_error( "Missing value for " + arg );
+
+    }
+
+    std::string value( argv[ ++i ] );
+
+    if ( arg == "--time" )
+    {
+
+      if ( value != "real" && value != "cpu" )
+      {
+
+        throw std::runtime_error( "--time is real or cpu, not " + value );
+
+      }
+
+      pOptions->compare.cpuTime = value == "cpu";
+
+    }
+    else if ( arg == "--alpha" )      { pOptions->compare.alpha            = std::stod( value ); }
+    else if ( arg == "--threshold" )  { pOptions->compare.threshold        = std::stod( value ); }
+    else if ( arg == "--confidence" ) { pOptions->compare.confidence       = std::stod( value ); }
+    else if ( arg == "--bootstrap" )  { pOptions->compare.bootstrapSamples = static_cast< unsigned >( std::stoul( value ) ); }
+    else if ( arg == "--json" )       { pOptions->json                     = value; }
+    else
+    {
+
+      throw std::runtime_error( "Unknown option " + arg );
+
+    }
+
+  }
+
+  if ( pOptions->files.size( ) < 2 )
+  {
+
+    throw std::runtime_error( "Usage: --bench-compare baseline.json test.json [test.json ...] [options]" );
+
+  }
+
+}
+
+
+const char*
+verdict( const BenchmarkCaseComparison &result )
+{
+
+  if ( result.regression )  { return "REGRESSION"; }
+  if ( !result.significant ) { return "same"; }
+
+  return result.ratio > 1.0 ? "slower" : "faster";
+
+}
+
+
+void
+writeNames(
+           std::ostream                     &json,
+           const std::vector< std::string > &names
+           )
+{
+
+  json << "[";
+
+  for ( std::size_t i = 0; i < names.size( ); ++i )
+  {
+    json << ( i == 0 ? " \"" : ", \"" ) << names[ i ] << "\"";
+  }
+
+  json << ( names.empty( ) ? "]" : " ]" );
+
+}
+
+
+} // namespace
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief isBenchmarkCompareCommand
+///////////////////////////////////////////////////////////////
+bool
+isBenchmarkCompareCommand(
+                          int          argc,
+                          const char **argv
+                          )
+{
+
+  return argc > 1 && argv[ 1 ] == benchmarkCompareFlag;
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief runBenchmarkCompareCommand
+///////////////////////////////////////////////////////////////
+int
+runBenchmarkCompareCommand(
+                           int          argc,
+                           const char **argv
+                           )
+{
+
+  BenchmarkCommandOptions options;
+  parseOptions( argc, argv, &options );
+
+  const BenchmarkCompareOptions &compare = options.compare;
+
+  BenchmarkResults baseline = readBenchmarkResults( options.files[ 0 ], compare.cpuTime );
+
+  std::ostringstream json;
+  json << std::setprecision( 9 );
+
+  json << "{\n";
+  json << "  \"baseline\": \"" << options.files[ 0 ] << "\",\n";
+  json << "  \"time\": \"" << ( compare.cpuTime ? "cpu" : "real" ) << "\",\n";
+  json << "  \"alpha\": " << compare.alpha << ",\n";
+  json << "  \"threshold\": " << compare.threshold << ",\n";
+  json << "  \"comparisons\": [";
+
+  std::size_t regressions = 0;
+  bool        unrepeated  = false;
+
+  for ( std::size_t f = 1; f < options.files.size( ); ++f )
+  {
+
+    const std::string  &name       = options.files[ f ];
+    BenchmarkComparison comparison = compareBenchmarks( baseline, readBenchmarkResults( name, compare.cpuTime ), compare );
+
+    regressions += comparison.getRegressionCount( );
+
+    std::cout << "\n" << options.files[ 0 ] << " -> " << name
+              << " (" << ( compare.cpuTime ? "cpu" : "real" ) << " time, medians)\n";
+    std::cout << "   baseline ns       test ns   change        interval         p  result      case\n";
+
+    json << ( f == 1 ? "\n" : ",\n" )
+         << "    {\n"
+         << "      \"test\": \"" << name << "\",\n"
+         << "      \"cases\": [";
+
+    for ( std::size_t c = 0; c < comparison.cases.size( ); ++c )
+    {
+
+      const BenchmarkCaseComparison &result = comparison.cases[ c ];
+
+      unrepeated = unrepeated || result.baselineCount < 2 || result.testCount < 2;
+
+      char line[ 160 ];
+      std::snprintf(
+                    line,
+                    sizeof( line ),
+                    "%13.6g %13.6g %+7.1f%% [%+6.1f%%, %+6.1f%%] %9.3g  %-10s  ",
+                    result.baselineMedian,
+                    result.testMedian,
+                    ( result.ratio - 1.0 ) * 100.0,
+                    ( result.ratioLow - 1.0 ) * 100.0,
+                    ( result.ratioHigh - 1.0 ) * 100.0,
+                    result.pValue,
+                    verdict( result )
+                    );
+
+      std::cout << line << result.name << "\n";
+
+      json << ( c == 0 ? "\n" : ",\n" )
+           << "        { \"name\": \"" << result.name
+           << "\", \"baselineCount\": " << result.baselineCount
+           << ", \"testCount\": " << result.testCount
+           << ", \"baselineMedian\": " << result.baselineMedian
+           << ", \"testMedian\": " << result.testMedian
+           << ", \"ratio\": " << result.ratio
+           << ", \"ratioLow\": " << result.ratioLow
+           << ", \"ratioHigh\": " << result.ratioHigh
+           << ", \"pValue\": " << result.pValue
+           << ", \"significant\": " << ( result.significant ? "true" : "false" )
+           << ", \"regression\": " << ( result.regression ? "true" : "false" )
+           << " }";
+
+    }
+
+    for ( const std::string &missing : comparison.baselineOnly )
+    {
+      std::cout << "  missing from " << name << ": " << missing << "\n";
+    }
+
+    for ( const std::string &added : comparison.testOnly )
+    {
+      std::cout << "  new in " << name << ": " << added << "\n";
+    }
+
+    json << "\n      ],\n";
+    json << "      \"baselineOnly\": ";
+    writeNames( json, comparison.baselineOnly );
+    json << ",\n      \"testOnly\": ";
+    writeNames( json, comparison.testOnly );
+    json << "\n    }";
+
+  }
+
+  json << "\n  ],\n";
+  json << "  \"regressions\": " << regressions << "\n";
+  json << "}\n";
+
+  if ( unrepeated )
+  {
+    std::cout << "\nSome cases ran once; run with --benchmark_repetitions to test them\n";
+  }
+
+  std::cout << "\n" << regressions << " regression" << ( regressions == 1 ? "" : "s" )
+            << " slower by more than " << compare.threshold * 100.0 << "% at p < " << compare.alpha
+            << std::endl;
+
+  if ( !options.json.empty( ) )
+  {
+
+    std::ofstream file( options.json );
+
+    if ( !file.is_open( ) )
+    {
+
+      throw std::runtime_error( "Could not open file for benchmark comparison: " + options.json );
+
+    }
+
+    file << json.str( );
+
+  }
+
+  return regressions > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+
+} // runBenchmarkCompareCommand
+
+
+
+} // namespace light
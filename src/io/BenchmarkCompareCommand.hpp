@@ -0,0 +1,52 @@
+#ifndef BenchmarkCompareCommand_hpp
+#define BenchmarkCompareCommand_hpp
+
+
+namespace light
+{
+
+
+///////////////////////////////////////////////////////////////
+/// \brief isBenchmarkCompareCommand
+/// \return true if the arguments ask to compare benchmark results
+///         instead of opening the viewer
+///////////////////////////////////////////////////////////////
+bool isBenchmarkCompareCommand (
+                                int          argc,
+                                const char **argv
+                                );
+
+
+///////////////////////////////////////////////////////////////
+/// \brief runBenchmarkCompareCommand
+///
+///        Compares Google Benchmark JSON files case by case
+///        against the first one. Each case's repetitions are
+///        tested with Mann-Whitney U and the ratio of medians gets
+///        a bootstrap confidence interval. Also run by the
+///        standalone lightbender-bench-compare tool.
+///
+///        --bench-compare baseline.json test.json [test.json ...] [options]
+///            --time real|cpu      which time to compare, real by default
+///            --alpha P            significance level, 0.05 by default
+///            --threshold F        slowdown fraction that fails, 0.05 by default
+///            --confidence C       bootstrap interval coverage, 0.95 by default
+///            --bootstrap N        bootstrap resamples, 2000 by default
+///            --json file          also write results as JSON
+///
+///        Results need repetitions to be tested, e.g. from
+///        --benchmark_repetitions=10 --benchmark_out=base.json.
+///
+/// \return EXIT_FAILURE when any case slowed down significantly
+///         by more than the threshold, else EXIT_SUCCESS
+///////////////////////////////////////////////////////////////
+int runBenchmarkCompareCommand (
+                                int          argc,
+                                const char **argv
+                                );
+
+
+} // namespace light
+
+
+#endif // BenchmarkCompareCommand_hpp
@@ -0,0 +1,838 @@
+#include "BenchmarkComparison.hpp"
+#include <cmath>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <stdexcept>
+
+
+namespace light
+{
+
+
+namespace
+{
+
+
+///
+/// \brief The JsonValue struct
+///
+///        Just enough JSON for benchmark output files
+///
+struct JsonValue
+{
+  enum Type { NUL, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT };
+
+  Type        type    = NUL;
+  bool        boolean = false;
+  double      number  = 0.0;
+  std::string string;
+
+  std::vector< JsonValue >   items; // array elements or object values
+  std::vector< std::string > keys;  // object keys, parallel to items
+
+  const JsonValue *find( const std::string &key ) const
+  {
+
+    for ( std::size_t i = 0; i < keys.size( ); ++i )
+    {
+
+      if ( keys[ i ] == key )
+      {
+        return &items[ i ];
+      }
+
+    }
+
+    return nullptr;
+
+  }
+
+};
+
+
+class JsonParser
+{
+
+public:
+
+  explicit
+  JsonParser( const std::string &text )
+    : text_( text )
+    , pos_ ( 0 )
+  {}
+
+
+  JsonValue parse( )
+  {
+
+    JsonValue value = _parseValue( );
+
+    _skipSpace( );
+
+    if ( pos_ != text_.size( ) )
+    {
+      _fail( "unexpected text after the value" );
+    }
+
+    return value;
+
+  }
+
+
+private:
+
+  void _fail( const std::string &message ) const
+  {
+
+    throw std::runtime_error( "Invalid benchmark JSON at offset " + std::to_string( pos_ ) + ": " + message );
+
+  }
+
+
+  void _skipSpace( )
+  {
+
+    while ( pos_ < text_.size( ) && std::isspace( static_cast< unsigned char >( text_[ pos_ ] ) ) )
+    {
+      ++pos_;
+    }
+
+  }
+
+
+  void _expect( char c )
+  {
+
+    _skipSpace( );
+
+    if ( pos_ >= text_.size( ) || text_[ pos_ ] != c )
+    {
+      _fail( std::string( "expected '" ) + c + "'" );
+    }
+
+    ++pos_;
+
+  }
+
+
+  bool _consumeWord( const char *pWord )
+  {
+
+    std::size_t length = std::char_traits< char >::length( pWord );
+
+    if ( text_.compare( pos_, length, pWord ) == 0 )
+    {
+
+      pos_ += length;
+      return true;
+
+    }
+
+    return false;
+
+  }
+
+
+  JsonValue _parseValue( )
+  {
+
+    _skipSpace( );
+
+    if ( pos_ >= text_.size( ) )
+    {
+      _fail( "unexpected end" );
+    }
+
+    JsonValue value;
+    char      c = text_[ pos_ ];
+
+    if ( c == '{' )
+    {
+
+      value.type = JsonValue::OBJECT;
+      ++pos_;
+      _skipSpace( );
+
+      if ( pos_ < text_.size( ) && text_[ pos_ ] == '}' )
+      {
+
+        ++pos_;
+        return value;
+
+      }
+
+      do
+      {
+
+        _skipSpace( );
+        value.keys.push_back( _parseString( ) );
+        _expect( ':' );
+        value.items.push_back( _parseValue( ) );
+        _skipSpace( );
+
+      }
+      while ( pos_ < text_.size( ) && text_[ pos_ ] == ',' && ++pos_ );
+
+      _expect( '}' );
+
+    }
+    else if ( c == '[' )
+    {
+
+      value.type = JsonValue::ARRAY;
+      ++pos_;
+      _skipSpace( );
+
+      if ( pos_ < text_.size( ) && text_[ pos_ ] == ']' )
+      {
+
+        ++pos_;
+        return value;
+
+      }
+
+      do
+      {
+
+        value.items.push_back( _parseValue( ) );
+        _skipSpace( );
+
+      }
+      while ( pos_ < text_.size( ) && text_[ pos_ ] == ',' && ++pos_ );
+
+      _expect( ']' );
+
+    }
+    else if ( c == '"' )
+    {
+
+      value.type   = JsonValue::STRING;
+      value.string = _parseString( );
+
+    }
+    else if ( _consumeWord( "true" ) )
+    {
+
+      value.type    = JsonValue::BOOLEAN;
+      value.boolean = true;
+
+    }
+    else if ( _consumeWord( "false" ) )
+    {
+
+      value.type = JsonValue::BOOLEAN;
+
+    }
+    else if ( _consumeWord( "null" ) )
+    {
+
+      value.type = JsonValue::NUL;
+
+    }
+    else
+    {
+
+      const char *pStart = text_.c_str( ) + pos_;
+      char       *pEnd   = nullptr;
+
+      value.type   = JsonValue::NUMBER;
+      value.number = std::strtod( pStart, &pEnd );
+
+      if ( pEnd == pStart )
+      {
+        _fail( "expected a value" );
+      }
+
+      pos_ += static_cast< std::size_t >( pEnd - pStart );
+
+    }
+
+    return value;
+
+  }
+
+
+  std::string _parseString( )
+  {
+
+    if ( pos_ >= text_.size( ) || text_[ pos_ ] != '"' )
+    {
+      _fail( "expected a string" );
+    }
+
+    ++pos_;
+
+    std::string result;
+
+    while ( pos_ < text_.size( ) && text_[ pos_ ] != '"' )
+    {
+
+      char c = text_[ pos_++ ];
+
+      if ( c != '\\' )
+      {
+
+        result += c;
+        continue;
+
+      }
+
+      if ( pos_ >= text_.size( ) )
+      {
+        break;
+      }
+
+      c = text_[ pos_++ ];
+
+      switch ( c )
+      {
+
+      case 'b': result += '\b'; break;
+      case 'f': result += '\f'; break;
+      case 'n': result += '\n'; break;
+      case 'r': result += '\r'; break;
+      case 't': result += '\t'; break;
+
+      case 'u':
+      {
+
+        if ( pos_ + 4 > text_.size( ) )
+        {
+          _fail( "short unicode escape" );
+        }
+
+        unsigned code = static_cast< unsigned >( std::stoul( text_.substr( pos_, 4 ), nullptr, 16 ) );
+        pos_ += 4;
+
+        // names are ASCII in practice, anything else is kept as UTF-8
+        if ( code < 0x80 )
+        {
+          result += static_cast< char >( code );
+        }
+        else if ( code < 0x800 )
+        {
+
+          result += static_cast< char >( 0xc0 | ( code >> 6 ) );
+          result += static_cast< char >( 0x80 | ( code & 0x3f ) );
+
+        }
+        else
+        {
+
+          result += static_cast< char >( 0xe0 | ( code >> 12 ) );
+          result += static_cast< char >( 0x80 | ( ( code >> 6 ) & 0x3f ) );
+          result += static_cast< char >( 0x80 | ( code & 0x3f ) );
+
+        }
+
+        break;
+
+      }
+
+      default: result += c; break; // quote, backslash and slash
+
+      } // switch
+
+    }
+
+    if ( pos_ >= text_.size( ) )
+    {
+      _fail( "unterminated string" );
+    }
+
+    ++pos_;
+
+    return result;
+
+  }
+
+
+  const std::string &text_;
+  std::size_t        pos_;
+
+};
+
+
+///
+/// \brief toNanoseconds
+/// \return factor from a Google Benchmark time_unit to nanoseconds
+///
+double
+toNanoseconds( const std::string &unit )
+{
+
+  if ( unit.empty( ) || unit == "ns" ) { return 1.0; }
+  if ( unit == "us" )                  { return 1e3; }
+  if ( unit == "ms" )                  { return 1e6; }
+  if ( unit == "s" )                   { return 1e9; }
+
+  throw std::runtime_error( "Unknown benchmark time unit " + unit );
+
+}
+
+
+bool
+endsWith(
+         const std::string &text,
+         const std::string &suffix
+         )
+{
+
+  return text.size( ) >= suffix.size( ) && text.compare( text.size( ) - suffix.size( ), suffix.size( ), suffix ) == 0;
+
+}
+
+
+std::string
+stringMember(
+             const JsonValue   &object,
+             const std::string &key
+             )
+{
+
+  const JsonValue *pValue = object.find( key );
+
+  return pValue && pValue->type == JsonValue::STRING ? pValue->string : std::string( );
+
+}
+
+
+///
+/// \brief isAggregate
+///
+///        Newer Google Benchmark versions mark aggregates with
+///        run_type, older ones only with a name suffix
+///
+bool
+isAggregate( const JsonValue &entry )
+{
+
+  std::string runType = stringMember( entry, "run_type" );
+
+  if ( !runType.empty( ) )
+  {
+    return runType == "aggregate";
+  }
+
+  std::string name = stringMember( entry, "name" );
+
+  return endsWith( name, "_mean" ) || endsWith( name, "_median" )
+         || endsWith( name, "_stddev" ) || endsWith( name, "_cv" );
+
+}
+
+
+double
+median( std::vector< double > values )
+{
+
+  if ( values.empty( ) )
+  {
+    return 0.0;
+  }
+
+  std::size_t half = values.size( ) / 2;
+  std::nth_element( values.begin( ), values.begin( ) + half, values.end( ) );
+
+  double upper = values[ half ];
+
+  if ( values.size( ) % 2 == 1 )
+  {
+    return upper;
+  }
+
+  return 0.5 * ( upper + *std::max_element( values.begin( ), values.begin( ) + half ) );
+
+}
+
+
+///
+/// \brief exactUCdf
+/// \return P(U <= u) for samples of sizes n and m without ties,
+///         counting rank arrangements with the recurrence
+///         f(n, m, u) = f(n - 1, m, u - m) + f(n, m - 1, u)
+///
+double
+exactUCdf(
+          std::size_t n,
+          std::size_t m,
+          std::size_t u
+          )
+{
+
+  // counts[ j ][ v ], rebuilt for each i, holds f(i, j, v)
+  std::size_t                          maxU = n * m;
+  std::vector< std::vector< double > > counts( m + 1, std::vector< double >( maxU + 1, 0.0 ) );
+
+  for ( std::size_t j = 0; j <= m; ++j )
+  {
+    counts[ j ][ 0 ] = 1.0;
+  }
+
+  for ( std::size_t i = 1; i <= n; ++i )
+  {
+
+    std::vector< std::vector< double > > next( m + 1, std::vector< double >( maxU + 1, 0.0 ) );
+    next[ 0 ][ 0 ] = 1.0;
+
+    for ( std::size_t j = 1; j <= m; ++j )
+    {
+
+      for ( std::size_t v = 0; v <= i * j; ++v )
+      {
+        next[ j ][ v ] = ( v >= j ? counts[ j ][ v - j ] : 0.0 ) + next[ j - 1 ][ v ];
+      }
+
+    }
+
+    counts.swap( next );
+
+  }
+
+  double total     = 0.0;
+  double atOrBelow = 0.0;
+
+  for ( std::size_t v = 0; v <= maxU; ++v )
+  {
+
+    total += counts[ m ][ v ];
+
+    if ( v <= u )
+    {
+      atOrBelow += counts[ m ][ v ];
+    }
+
+  }
+
+  return atOrBelow / total;
+
+}
+
+
+///
+/// \brief bootstrapRatio
+///
+///        Percentile bootstrap interval of the ratio of medians,
+///        resampling both sides with a small xorshift generator so
+///        reports are the same on every standard library
+///
+void
+bootstrapRatio(
+               const std::vector< double >   &baseline,
+               const std::vector< double >   &test,
+               const BenchmarkCompareOptions &options,
+               std::uint32_t                  seed,
+               double                        *pLow,
+               double                        *pHigh
+               )
+{
+
+  std::uint32_t state = seed ? seed : 0x9e3779b9u;
+
+  auto next = [ &state ] ( )
+  {
+
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+
+  };
+
+  unsigned              count = std::max( 1u, options.bootstrapSamples );
+  std::vector< double > ratios( count );
+  std::vector< double > a( baseline.size( ) );
+  std::vector< double > b( test.size( ) );
+
+  for ( unsigned r = 0; r < count; ++r )
+  {
+
+    for ( double &value : a )
+    {
+      value = baseline[ next( ) % baseline.size( ) ];
+    }
+
+    for ( double &value : b )
+    {
+      value = test[ next( ) % test.size( ) ];
+    }
+
+    double base = median( a );
+    ratios[ r ] = base > 0.0 ? median( b ) / base : 1.0;
+
+  }
+
+  std::sort( ratios.begin( ), ratios.end( ) );
+
+  double tail = 0.5 * ( 1.0 - std::min( std::max( options.confidence, 0.0 ), 1.0 ) );
+
+  auto quantile = [ &ratios ] ( double q )
+  {
+
+    std::size_t index = static_cast< std::size_t >( std::floor( q * ( ratios.size( ) - 1 ) + 0.5 ) );
+    return ratios[ std::min( index, ratios.size( ) - 1 ) ];
+
+  };
+
+  *pLow  = quantile( tail );
+  *pHigh = quantile( 1.0 - tail );
+
+}
+
+
+} // namespace
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief BenchmarkComparison::getRegressionCount
+///////////////////////////////////////////////////////////////
+std::size_t
+BenchmarkComparison::getRegressionCount( ) const
+{
+
+  return static_cast< std::size_t >( std::count_if(
+                                                   cases.begin( ),
+                                                   cases.end( ),
+                                                   [ ] ( const BenchmarkCaseComparison &c ) { return c.regression; }
+                                                   ) );
+
+} // BenchmarkComparison::getRegressionCount
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief parseBenchmarkResults
+///////////////////////////////////////////////////////////////
+BenchmarkResults
+parseBenchmarkResults(
+                      const std::string &text,
+                      bool               cpuTime
+                      )
+{
+
+  JsonValue root = JsonParser( text ).parse( );
+
+  const JsonValue *pBenchmarks = root.find( "benchmarks" );
+
+  if ( !pBenchmarks || pBenchmarks->type != JsonValue::ARRAY )
+  {
+
+    throw std::runtime_error( "Benchmark JSON has no benchmarks array" );
+
+  }
+
+  const std::string timeKey = cpuTime ? "cpu_time" : "real_time";
+
+  BenchmarkResults results;
+
+  for ( const JsonValue &entry : pBenchmarks->items )
+  {
+
+    const JsonValue *pError = entry.find( "error_occurred" );
+    const JsonValue *pTime  = entry.find( timeKey );
+
+    if ( isAggregate( entry )
+        || ( pError && pError->boolean )
+        || !pTime || pTime->type != JsonValue::NUMBER )
+    {
+      continue;
+    }
+
+    std::string name = stringMember( entry, "run_name" );
+
+    if ( name.empty( ) )
+    {
+      name = stringMember( entry, "name" );
+    }
+
+    results.samples[ name ].push_back( pTime->number * toNanoseconds( stringMember( entry, "time_unit" ) ) );
+
+  }
+
+  return results;
+
+} // parseBenchmarkResults
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief readBenchmarkResults
+///////////////////////////////////////////////////////////////
+BenchmarkResults
+readBenchmarkResults(
+                     const std::string &filename,
+                     bool               cpuTime
+                     )
+{
+
+  std::ifstream file( filename );
+
+  if ( !file.is_open( ) )
+  {
+
+    throw std::runtime_error( "Could not open benchmark results: " + filename );
+
+  }
+
+  std::stringstream text;
+  text << file.rdbuf( );
+
+  return parseBenchmarkResults( text.str( ), cpuTime );
+
+} // readBenchmarkResults
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief mannWhitneyPValue
+///////////////////////////////////////////////////////////////
+double
+mannWhitneyPValue(
+                  const std::vector< double > &a,
+                  const std::vector< double > &b
+                  )
+{
+
+  std::size_t n = a.size( );
+  std::size_t m = b.size( );
+
+  if ( n == 0 || m == 0 )
+  {
+    return 1.0;
+  }
+
+  std::vector< std::pair< double, bool > > pooled; // value, from a
+  pooled.reserve( n + m );
+
+  for ( double value : a ) { pooled.emplace_back( value, true ); }
+  for ( double value : b ) { pooled.emplace_back( value, false ); }
+
+  std::sort( pooled.begin( ), pooled.end( ) );
+
+  // average ranks over ties
+  std::size_t total    = pooled.size( );
+  double      rankSumA = 0.0;
+  double      tieSum   = 0.0;
+  bool        tied     = false;
+
+  for ( std::size_t i = 0; i < total; )
+  {
+
+    std::size_t j = i;
+
+    while ( j < total && pooled[ j ].first == pooled[ i ].first )
+    {
+      ++j;
+    }
+
+    double rank = 0.5 * ( i + 1 + j );
+    double t    = static_cast< double >( j - i );
+
+    for ( std::size_t k = i; k < j; ++k )
+    {
+      rankSumA += pooled[ k ].second ? rank : 0.0;
+    }
+
+    tieSum += t * t * t - t;
+    tied    = tied || t > 1.0;
+    i       = j;
+
+  }
+
+  double uA   = rankSumA - 0.5 * n * ( n + 1 );
+  double uMin = std::min( uA, static_cast< double >( n * m ) - uA );
+
+  // the exact table takes about (n m)^2 / 4 additions
+  if ( !tied && n <= 30 && m <= 30 )
+  {
+
+    return std::min( 1.0, 2.0 * exactUCdf( n, m, static_cast< std::size_t >( uMin ) ) );
+
+  }
+
+  double N     = static_cast< double >( total );
+  double mean  = 0.5 * n * m;
+  double sigma = std::sqrt( n * m / 12.0 * ( ( N + 1.0 ) - tieSum / ( N * ( N - 1.0 ) ) ) );
+
+  if ( sigma <= 0.0 )
+  {
+    return 1.0;
+  }
+
+  double z = std::max( 0.0, std::abs( uA - mean ) - 0.5 ) / sigma;
+
+  return std::min( 1.0, std::erfc( z / std::sqrt( 2.0 ) ) );
+
+} // mannWhitneyPValue
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief compareBenchmarks
+///////////////////////////////////////////////////////////////
+BenchmarkComparison
+compareBenchmarks(
+                  const BenchmarkResults        &baseline,
+                  const BenchmarkResults        &test,
+                  const BenchmarkCompareOptions &options
+                  )
+{
+
+  BenchmarkComparison comparison;
+
+  std::uint32_t caseSeed = options.seed;
+
+  for ( const auto &entry : baseline.samples )
+  {
+
+    auto found = test.samples.find( entry.first );
+
+    if ( found == test.samples.end( ) )
+    {
+
+      comparison.baselineOnly.push_back( entry.first );
+      continue;
+
+    }
+
+    const std::vector< double > &a = entry.second;
+    const std::vector< double > &b = found->second;
+
+    BenchmarkCaseComparison result;
+    result.name           = entry.first;
+    result.baselineCount  = a.size( );
+    result.testCount      = b.size( );
+    result.baselineMedian = median( a );
+    result.testMedian     = median( b );
+    result.ratio          = result.baselineMedian > 0.0 ? result.testMedian / result.baselineMedian : 1.0;
+    result.pValue         = mannWhitneyPValue( a, b );
+    result.significant    = result.pValue < options.alpha;
+    result.regression     = result.significant && result.ratio > 1.0 + options.threshold;
+
+    bootstrapRatio( a, b, options, caseSeed++, &result.ratioLow, &result.ratioHigh );
+
+    comparison.cases.push_back( result );
+
+  }
+
+  for ( const auto &entry : test.samples )
+  {
+
+    if ( baseline.samples.find( entry.first ) == baseline.samples.end( ) )
+    {
+      comparison.testOnly.push_back( entry.first );
+    }
+
+  }
+
+  return comparison;
+
+} // compareBenchmarks
+
+
+
+} // namespace light
@@ -0,0 +1,138 @@
+#ifndef BenchmarkComparison_hpp
+#define BenchmarkComparison_hpp
+
+
+#include <map>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+
+namespace light
+{
+
+
+/////////////////////////////////////////////
+/// \brief The BenchmarkResults struct
+///
+///        Per repetition times of every case in one Google
+///        Benchmark JSON file, in nanoseconds, keyed by the run
+///        name without aggregate suffixes
+/////////////////////////////////////////////
+struct BenchmarkResults
+{
+  std::map< std::string, std::vector< double > > samples;
+};
+
+
+/////////////////////////////////////////////
+/// \brief The BenchmarkCompareOptions struct
+/////////////////////////////////////////////
+struct BenchmarkCompareOptions
+{
+  bool          cpuTime          = false; // else real (wall clock) time
+  double        alpha            = 0.05;  // Mann-Whitney significance level
+  double        threshold        = 0.05;  // slowdowns above this fraction fail
+  double        confidence       = 0.95;  // bootstrap interval coverage
+  unsigned      bootstrapSamples = 2000;
+  std::uint32_t seed             = 1;     // bootstrap resampling, for repeatable reports
+};
+
+
+/////////////////////////////////////////////
+/// \brief The BenchmarkCaseComparison struct
+///
+///        One case present in both files. Ratios are test over
+///        baseline medians, so below 1 is a speedup.
+/////////////////////////////////////////////
+struct BenchmarkCaseComparison
+{
+  std::string name;
+
+  std::size_t baselineCount = 0;
+  std::size_t testCount     = 0;
+
+  double baselineMedian = 0.0; // nanoseconds
+  double testMedian     = 0.0;
+
+  double ratio     = 1.0;
+  double ratioLow  = 1.0; // bootstrap confidence interval
+  double ratioHigh = 1.0;
+
+  double pValue = 1.0; // two-sided Mann-Whitney U
+
+  bool significant = false; // pValue below alpha
+  bool regression  = false; // significant and slower past the threshold
+};
+
+
+/////////////////////////////////////////////
+/// \brief The BenchmarkComparison struct
+/////////////////////////////////////////////
+struct BenchmarkComparison
+{
+  std::vector< BenchmarkCaseComparison > cases;        // sorted by name
+  std::vector< std::string >             baselineOnly; // cases missing from the test
+  std::vector< std::string >             testOnly;     // cases new in the test
+
+  std::size_t getRegressionCount ( ) const;
+};
+
+
+///////////////////////////////////////////////////////////////
+/// \brief parseBenchmarkResults
+///
+///        Reads Google Benchmark JSON output. Only per
+///        repetition entries are kept; mean, median and stddev
+///        aggregates are recomputed from them. Throws on malformed
+///        JSON or a missing benchmarks array.
+/// \param text the whole file
+/// \param cpuTime read cpu_time instead of real_time
+///////////////////////////////////////////////////////////////
+BenchmarkResults parseBenchmarkResults (
+                                        const std::string &text,
+                                        bool               cpuTime
+                                        );
+
+
+///////////////////////////////////////////////////////////////
+/// \brief readBenchmarkResults
+/// \return parseBenchmarkResults of the file, throws if it can't
+///         be read
+///////////////////////////////////////////////////////////////
+BenchmarkResults readBenchmarkResults (
+                                       const std::string &filename,
+                                       bool               cpuTime
+                                       );
+
+
+///////////////////////////////////////////////////////////////
+/// \brief mannWhitneyPValue
+/// \return two-sided p-value of the Mann-Whitney U test that both
+///         samples come from the same distribution. Exact for
+///         small samples without ties, else the normal
+///         approximation with tie and continuity corrections.
+///         1 when either sample is empty.
+///////////////////////////////////////////////////////////////
+double mannWhitneyPValue (
+                          const std::vector< double > &a,
+                          const std::vector< double > &b
+                          );
+
+
+///////////////////////////////////////////////////////////////
+/// \brief compareBenchmarks
+///
+///        Matches cases by name and tests each pair
+///////////////////////////////////////////////////////////////
+BenchmarkComparison compareBenchmarks (
+                                       const BenchmarkResults        &baseline,
+                                       const BenchmarkResults        &test,
+                                       const BenchmarkCompareOptions &options = BenchmarkCompareOptions( )
+                                       );
+
+
+} // namespace light
+
+
+#endif // BenchmarkComparison_hpp
@@ -0,0 +1,222 @@
+#include "BvhReportCommand.hpp"
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include "glm/glm.hpp"
+#include "graphics/Camera.hpp"
+#include "BuiltinScenes.hpp"
+#include "StressScene.hpp"
+#include "BvhReport.hpp"
+#include "HostScene.hpp"
+#include "ImageIO.hpp"
+#include "OptixSceneFactory.hpp"
+
+
+namespace light
+{
+
+
+namespace
+{
+
+
+const std::string reportFlag = "--bvh-report";
+
+
+struct ReportOptions
+{
+  int         sceneType = 1;
+  std::string modelFile;
+  unsigned    leafSize  = 4;
+  unsigned    width     = 320;
+  unsigned    height    = 180;
+  float       scale     = 128.0f;
+  std::string heatmapFile;
+};
+
+
+void
+parseOptions(
+             int            argc,
+             const char   **argv,
+             ReportOptions *pOptions
+             )
+{
+
+  for ( int i = 2; i < argc; ++i )
+  {
+
+    std::string flag( argv[ i ] );
+
+    if ( i + 1 >= argc )
+    {
+
+      throw std::runtime_error( "Missing value for " + flag );
+
+    }
+
+    std::string value( argv[ ++i ] );
+
+    if      ( flag == "--scene" )     { pOptions->sceneType   = std::stoi( value ); }
+    else if ( flag == "--model" )     { pOptions->modelFile   = value; }
+    else if ( flag == "--leaf-size" ) { pOptions->leafSize    = static_cast< unsigned >( std::stoul( value ) ); }
+    else if ( flag == "--width" )     { pOptions->width       = static_cast< unsigned >( std::stoul( value ) ); }
+    else if ( flag == "--height" )    { pOptions->height      = static_cast< unsigned >( std::stoul( value ) ); }
+    else if ( flag == "--scale" )     { pOptions->scale       = std::stof( value ); }
+    else if ( flag == "--heatmap" )   { pOptions->heatmapFile = value; }
+    else
+    {
+
+      throw std::runtime_error( "Unknown option " + flag );
+
+    }
+
+  }
+
+  if ( pOptions->width == 0 || pOptions->height == 0 )
+  {
+
+    throw std::runtime_error( "BVH reports need a non-empty ray grid" );
+
+  }
+
+} // parseOptions
+
+
+SceneDescription
+loadScene( const ReportOptions &options )
+{
+
+  switch ( options.sceneType )
+  {
+
+  case 0:
+    return buildBasicScene( );
+
+  case 1:
+    return buildAdvancedScene( );
+
+  case 2:
+    return buildModelScene( options.modelFile.empty( ) ? getDefaultModelFile( ) : options.modelFile );
+
+  case 3:
+    return SceneDescription::read( options.modelFile );
+
+  case 4:
+    return buildStressScene( parseStressSceneOptions( options.modelFile ) );
+
+  default:
+    throw std::runtime_error( "Unknown scene" );
+
+  } // switch
+
+}
+
+
+Float3
+toFloat3( glm::vec3 v )
+{
+
+  return Float3 { v.x, v.y, v.z };
+
+}
+
+
+double
+perRay(
+       std::uint64_t total,
+       std::size_t   rays
+       )
+{
+
+  return rays > 0 ? static_cast< double >( total ) / rays : 0.0;
+
+}
+
+
+} // namespace
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief isBvhReportCommand
+///////////////////////////////////////////////////////////////
+bool
+isBvhReportCommand(
+                   int          argc,
+                   const char **argv
+                   )
+{
+
+  return argc > 1 && argv[ 1 ] == reportFlag;
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief runBvhReportCommand
+///////////////////////////////////////////////////////////////
+int
+runBvhReportCommand(
+                    int          argc,
+                    const char **argv
+                    )
+{
+
+  ReportOptions options;
+  parseOptions( argc, argv, &options );
+
+  HostScene scene( loadScene( options ), options.leafSize );
+
+  std::cout << formatBvhReport( scene ) << std::endl;
+
+  //
+  // same starting view as the viewer and batch renders
+  //
+  graphics::Camera camera;
+  camera.setAspectRatio( options.width * 1.0f / options.height );
+  camera.updateOrbit( 20.0f, 45.0f, -30.0f );
+
+  glm::vec3 U, V, W;
+  camera.buildRayBasisVectors( &U, &V, &W );
+
+  RayCostReport cost = measureRayCost(
+                                      scene,
+                                      options.width,
+                                      options.height,
+                                      toFloat3( glm::vec3( camera.getEye( ) ) ),
+                                      toFloat3( U ),
+                                      toFloat3( V ),
+                                      toFloat3( W )
+                                      );
+
+  std::cout << "primary rays: " << cost.primaryRays
+            << ", " << perRay( cost.primary.nodes, cost.primaryRays ) << " nodes and "
+            << perRay( cost.primary.tests, cost.primaryRays ) << " tests per ray" << std::endl;
+
+  std::cout << "shadow rays:  " << cost.shadowRays
+            << ", " << perRay( cost.shadow.nodes, cost.shadowRays ) << " nodes and "
+            << perRay( cost.shadow.tests, cost.shadowRays ) << " tests per ray" << std::endl;
+
+  std::cout << "worst pixel:  " << cost.maxPixelNodes << " nodes, "
+            << cost.maxPixelTests << " tests" << std::endl;
+
+  if ( !options.heatmapFile.empty( ) )
+  {
+
+    writePPM( options.heatmapFile, cost.width, cost.height, toCostHeatmap( cost, options.scale ) );
+
+    std::cout << "cost heatmap saved to " << options.heatmapFile << std::endl;
+
+  }
+
+  return EXIT_SUCCESS;
+
+} // runBvhReportCommand
+
+
+
+} // namespace light
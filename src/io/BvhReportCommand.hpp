@@ -0,0 +1,50 @@
+#ifndef BvhReportCommand_hpp
+#define BvhReportCommand_hpp
+
+
+namespace light
+{
+
+
+///////////////////////////////////////////////////////////////
+/// \brief isBvhReportCommand
+/// \return true if the arguments ask for a BVH report instead
+///         of the interactive viewer
+///////////////////////////////////////////////////////////////
+bool isBvhReportCommand (
+                         int          argc,
+                         const char **argv
+                         );
+
+
+///////////////////////////////////////////////////////////////
+/// \brief runBvhReportCommand
+///
+///        Builds the host acceleration structure of a scene and
+///        prints its SAH cost, depth, leaf sizes, sibling overlap
+///        and memory per level, then traces primary and shadow
+///        rays from the viewer's starting camera and reports the
+///        nodes visited and primitives tested. Needs no GPU.
+///
+///        --bvh-report [options]
+///            --scene N                 0 basic, 1 advanced, 2 model,
+///                                      3 scene file, 4 stress scene
+///            --model file              mesh, scene description or
+///                                      stress scene options
+///            --leaf-size N             items per leaf before splitting
+///            --width W --height H      ray grid size
+///            --heatmap file.ppm        also write the cost per pixel
+///            --scale N                 nodes plus tests shown as red
+///
+/// \return process exit code
+///////////////////////////////////////////////////////////////
+int runBvhReportCommand (
+                         int          argc,
+                         const char **argv
+                         );
+
+
+} // namespace light
+
+
+#endif // BvhReportCommand_hpp
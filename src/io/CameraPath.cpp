@@ -0,0 +1,394 @@
+#include "CameraPath.hpp"
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <iterator>
+#include <stdexcept>
+#include "HostMath.hpp"
+
+
+namespace light
+{
+
+
+namespace
+{
+
+
+[[ noreturn ]]
+void
+throwLineError(
+               unsigned           line,
+               const std::string &message
+               )
+{
+
+  throw std::runtime_error( "Camera path line " + std::to_string( line ) + ": " + message );
+
+}
+
+
+float
+lerp(
+     float a,
+     float b,
+     float t
+     )
+{
+
+  return a + ( b - a ) * t;
+
+}
+
+
+} // namespace
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief CameraPath::addOrbitKey
+///////////////////////////////////////////////////////////////
+void
+CameraPath::addOrbitKey( const OrbitKey &key )
+{
+
+  if ( !views_.empty( ) )
+  {
+    throw std::runtime_error( "Camera paths can't mix orbit keys and explicit views" );
+  }
+
+  if ( !orbitKeys_.empty( ) && key.time < orbitKeys_.back( ).time )
+  {
+    throw std::runtime_error( "Orbit keys must be added in increasing time" );
+  }
+
+  orbitKeys_.push_back( key );
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief CameraPath::addView
+///////////////////////////////////////////////////////////////
+void
+CameraPath::addView( const CameraView &view )
+{
+
+  if ( !orbitKeys_.empty( ) )
+  {
+    throw std::runtime_error( "Camera paths can't mix orbit keys and explicit views" );
+  }
+
+  Float3 forward = view.lookAt - view.eye;
+
+  if ( dot( forward, forward ) <= 0.0f || dot( cross( forward, view.up ), cross( forward, view.up ) ) <= 0.0f )
+  {
+    throw std::runtime_error( "Camera view must look somewhere other than its eye or up direction" );
+  }
+
+  views_.push_back( view );
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief CameraPath::getShots
+///////////////////////////////////////////////////////////////
+std::vector< CameraShot >
+CameraPath::getShots( unsigned orbitShots ) const
+{
+
+  std::vector< CameraShot > shots;
+
+  for ( const CameraView &view : views_ )
+  {
+    shots.push_back( CameraShot { false, OrbitKey( ), view } );
+  }
+
+  if ( orbitKeys_.empty( ) )
+  {
+    return shots;
+  }
+
+  if ( orbitShots == 0 )
+  {
+
+    for ( const OrbitKey &key : orbitKeys_ )
+    {
+      shots.push_back( CameraShot { true, key, CameraView( ) } );
+    }
+
+    return shots;
+
+  }
+
+  float start    = orbitKeys_.front( ).time;
+  float duration = orbitKeys_.back( ).time - start;
+
+  for ( unsigned i = 0; i < orbitShots; ++i )
+  {
+
+    float t = orbitShots > 1 ? static_cast< float >( i ) / static_cast< float >( orbitShots - 1 ) : 0.0f;
+    shots.push_back( CameraShot { true, getOrbitKey( start + duration * t ), CameraView( ) } );
+
+  }
+
+  return shots;
+
+} // CameraPath::getShots
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief CameraPath::getOrbitKey
+///////////////////////////////////////////////////////////////
+OrbitKey
+CameraPath::getOrbitKey( float time ) const
+{
+
+  if ( orbitKeys_.empty( ) )
+  {
+    throw std::runtime_error( "Camera path has no orbit keys" );
+  }
+
+  if ( time <= orbitKeys_.front( ).time )
+  {
+    return orbitKeys_.front( );
+  }
+
+  for ( std::size_t i = 1; i < orbitKeys_.size( ); ++i )
+  {
+
+    const OrbitKey &a = orbitKeys_[ i - 1 ];
+    const OrbitKey &b = orbitKeys_[ i ];
+
+    if ( time <= b.time )
+    {
+
+      float t = b.time > a.time ? ( time - a.time ) / ( b.time - a.time ) : 1.0f;
+
+      return OrbitKey {
+        time,
+        lerp( a.zoom, b.zoom, t ),
+        lerp( a.dx,   b.dx,   t ),
+        lerp( a.dy,   b.dy,   t )
+      };
+
+    }
+
+  }
+
+  return orbitKeys_.back( );
+
+} // CameraPath::getOrbitKey
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief CameraPath::makeTurntable
+///////////////////////////////////////////////////////////////
+CameraPath
+CameraPath::makeTurntable(
+                          const OrbitKey &start,
+                          unsigned        views
+                          )
+{
+
+  if ( views == 0 )
+  {
+    throw std::runtime_error( "A turntable needs at least one view" );
+  }
+
+  CameraPath path;
+
+  for ( unsigned i = 0; i < views; ++i )
+  {
+
+    OrbitKey key = start;
+    key.time     = static_cast< float >( i );
+    key.dx       = start.dx + 360.0f * static_cast< float >( i ) / static_cast< float >( views );
+
+    path.addOrbitKey( key );
+
+  }
+
+  return path;
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief CameraPath::parse
+///////////////////////////////////////////////////////////////
+CameraPath
+CameraPath::parse( const std::string &text )
+{
+
+  CameraPath path;
+
+  std::istringstream lines( text );
+  std::string        line;
+  unsigned           lineNumber = 0;
+
+  while ( std::getline( lines, line ) )
+  {
+
+    ++lineNumber;
+
+    std::string::size_type comment = line.find( '#' );
+
+    if ( comment != std::string::npos )
+    {
+      line.erase( comment );
+    }
+
+    std::istringstream stream( line );
+    std::string        kind;
+
+    if ( !( stream >> kind ) )
+    {
+      continue; // blank line
+    }
+
+    std::vector< float > values;
+    std::string          token;
+
+    while ( stream >> token )
+    {
+
+      try
+      {
+
+        std::size_t used = 0;
+        values.push_back( std::stof( token, &used ) );
+
+        if ( used != token.size( ) )
+        {
+          throw std::invalid_argument( token );
+        }
+
+      }
+      catch ( const std::exception& )
+      {
+
+        throwLineError( lineNumber, "'" + token + "' is not a number" );
+
+      }
+
+    }
+
+    try
+    {
+
+      if ( kind == "orbit" )
+      {
+
+        if ( values.size( ) != 4 )
+        {
+          throwLineError( lineNumber, "orbit expects <time> <zoom> <dx> <dy>" );
+        }
+
+        path.addOrbitKey( OrbitKey { values[ 0 ], values[ 1 ], values[ 2 ], values[ 3 ] } );
+
+      }
+      else if ( kind == "view" )
+      {
+
+        if ( values.size( ) != 6 && values.size( ) != 9 )
+        {
+          throwLineError( lineNumber, "view expects <eye xyz> <look-at xyz> [<up xyz>]" );
+        }
+
+        CameraView view;
+        view.eye    = Float3 { values[ 0 ], values[ 1 ], values[ 2 ] };
+        view.lookAt = Float3 { values[ 3 ], values[ 4 ], values[ 5 ] };
+        view.up     = values.size( ) == 9 ? Float3 { values[ 6 ], values[ 7 ], values[ 8 ] } : Float3 { 0.0f, 1.0f, 0.0f };
+
+        path.addView( view );
+
+      }
+      else
+      {
+
+        throwLineError( lineNumber, "unknown entry '" + kind + "'" );
+
+      }
+
+    }
+    catch ( const std::runtime_error &e )
+    {
+
+      std::string message = e.what( );
+
+      // errors from addOrbitKey / addView don't know the line yet
+      if ( message.compare( 0, 16, "Camera path line" ) == 0 )
+      {
+        throw;
+      }
+
+      throwLineError( lineNumber, message );
+
+    }
+
+  }
+
+  if ( path.orbitKeys_.empty( ) && path.views_.empty( ) )
+  {
+    throw std::runtime_error( "Camera path has no views" );
+  }
+
+  return path;
+
+} // CameraPath::parse
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief CameraPath::read
+///////////////////////////////////////////////////////////////
+CameraPath
+CameraPath::read( const std::string &filename )
+{
+
+  std::ifstream file( filename );
+
+  if ( !file.is_open( ) )
+  {
+    throw std::runtime_error( "Could not open camera path: " + filename );
+  }
+
+  return parse( std::string( std::istreambuf_iterator< char >( file ), std::istreambuf_iterator< char >( ) ) );
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief makeLookAtBasis
+///////////////////////////////////////////////////////////////
+void
+makeLookAtBasis(
+                const CameraView &view,
+                float             halfWidth,
+                float             halfHeight,
+                Float3           *pU,
+                Float3           *pV,
+                Float3           *pW
+                )
+{
+
+  Float3 forward = normalize( view.lookAt - view.eye );
+  Float3 right   = normalize( cross( forward, view.up ) );
+  Float3 up      = cross( right, forward );
+
+  *pU = right * halfWidth;
+  *pV = up * halfHeight;
+  *pW = forward;
+
+}
+
+
+} // namespace light
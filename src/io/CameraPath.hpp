@@ -0,0 +1,163 @@
+#ifndef CameraPath_hpp
+#define CameraPath_hpp
+
+
+#include <string>
+#include <vector>
+#include "SceneDescription.hpp"
+
+
+namespace light
+{
+
+
+/////////////////////////////////////////////
+/// \brief The OrbitKey struct
+///
+///        Orbit camera pose at 'time', given the way the
+///        viewer and --orbit give it: zoom and the two orbit
+///        angles applied to a fresh camera
+/////////////////////////////////////////////
+struct OrbitKey
+{
+  float time;
+  float zoom;
+  float dx;
+  float dy;
+};
+
+
+/////////////////////////////////////////////
+/// \brief The CameraView struct
+///
+///        Explicit camera placement
+/////////////////////////////////////////////
+struct CameraView
+{
+  Float3 eye;
+  Float3 lookAt;
+  Float3 up;
+};
+
+
+/////////////////////////////////////////////
+/// \brief The CameraShot struct
+///
+///        One rendered view of a path: an orbit pose or an
+///        explicit view, whichever the path was made of
+/////////////////////////////////////////////
+struct CameraShot
+{
+  bool       orbit;
+  OrbitKey   key;
+  CameraView view;
+};
+
+
+/////////////////////////////////////////////
+/// \brief The CameraPath class
+///
+///        Views for batch renders: orbit keyframes sampled
+///        at evenly spaced times, or a list of explicit
+///        eye / look-at views rendered as given.
+///
+///        Text form, one entry per line, '#' comments:
+///
+///            orbit <time> <zoom> <dx> <dy>
+///            view  <eye xyz> <look-at xyz> [<up xyz>]
+///
+///        A path holds one kind of entry or the other.
+/////////////////////////////////////////////
+class CameraPath
+{
+
+public:
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief addOrbitKey
+  ///
+  ///        Keys must be added in increasing time
+  ///////////////////////////////////////////////////////////////
+  void addOrbitKey ( const OrbitKey &key );
+
+  void addView ( const CameraView &view );
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief getShots
+  /// \param orbitShots views sampled from orbit keys, spread
+  ///        evenly from the first key's time to the last's; 0
+  ///        gives one per key. Explicit views ignore it.
+  ///////////////////////////////////////////////////////////////
+  std::vector< CameraShot > getShots ( unsigned orbitShots = 0 ) const;
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief getOrbitKey
+  /// \return keys interpolated linearly at 'time', clamped to
+  ///         the first and last key
+  ///////////////////////////////////////////////////////////////
+  OrbitKey getOrbitKey ( float time ) const;
+
+
+  const std::vector< OrbitKey >   &getOrbitKeys ( ) const { return orbitKeys_; }
+  const std::vector< CameraView > &getViews     ( ) const { return views_; }
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief makeTurntable
+  /// \return 'views' orbit poses a full turn apart around
+  ///         'start', the last one short of coming back
+  ///////////////////////////////////////////////////////////////
+  static
+  CameraPath makeTurntable (
+                            const OrbitKey &start,
+                            unsigned        views
+                            );
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief parse
+  ///
+  ///        Throws with the line number on malformed input
+  ///////////////////////////////////////////////////////////////
+  static
+  CameraPath parse ( const std::string &text );
+
+  static
+  CameraPath read ( const std::string &filename );
+
+
+private:
+
+  std::vector< OrbitKey >   orbitKeys_;
+  std::vector< CameraView > views_;
+
+};
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief makeLookAtBasis
+///
+///        Pinhole ray basis for an explicit view: W points at
+///        the target with unit length and U, V span the image
+///        plane with the given half extents, matching how an
+///        orbit camera's basis is scaled
+/// \param halfWidth |U| / |W| of the orbit camera
+/// \param halfHeight |V| / |W| of the orbit camera
+///////////////////////////////////////////////////////////////
+void makeLookAtBasis (
+                      const CameraView &view,
+                      float             halfWidth,
+                      float             halfHeight,
+                      Float3           *pU,
+                      Float3           *pV,
+                      Float3           *pW
+                      );
+
+
+} // namespace light
+
+
+#endif // CameraPath_hpp
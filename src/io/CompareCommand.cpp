@@ -0,0 +1,274 @@
+#include "CompareCommand.hpp"
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include "ImageIO.hpp"
+#include "ImageMetrics.hpp"
+
+
+namespace light
+{
+
+
+namespace
+{
+
+
+const std::string compareFlag = "--compare";
+
+
+struct CompareOptions
+{
+  std::string                reference;
+  std::vector< std::string > tests;
+  ImageCompareOptions        metrics;
+  std::string                json;
+  std::string                csv;
+};
+
+
+void
+parseMetrics(
+             const std::string   &value,
+             ImageCompareOptions *pOptions
+             )
+{
+
+  // squared errors are always computed, they cost next to nothing
+  pOptions->ssim = false;
+  pOptions->flip = false;
+
+  std::stringstream list( value );
+  std::string       item;
+
+  while ( std::getline( list, item, ',' ) )
+  {
+
+    if      ( item == "ssim" )                    { pOptions->ssim = true; }
+    else if ( item == "flip" )                    { pOptions->flip = true; }
+    else if ( item != "mse" && item != "relmse" )
+    {
+
+      throw std::runtime_error( "Metrics are mse, relmse, ssim and flip, not " + item );
+
+    }
+
+  }
+
+}
+
+
+void
+parseOptions(
+             int             argc,
+             const char    **argv,
+             CompareOptions *pOptions
+             )
+{
+
+  for ( int i = 2; i < argc; ++i )
+  {
+
+    std::string arg( argv[ i ] );
+
+    if ( arg.compare( 0, 2, "--" ) != 0 )
+    {
+
+      if ( pOptions->reference.empty( ) )
+      {
+        pOptions->reference = arg;
+      }
+      else
+      {
+        pOptions->tests.push_back( arg );
+      }
+
+      continue;
+
+    }
+
+    if ( i + 1 >= argc )
+    {
+
+      throw std::runtime_error( "Missing value for " + arg );
+
+    }
+
+    std::string value( argv[ ++i ] );
+
+    if      ( arg == "--metrics" ) { parseMetrics( value, &pOptions->metrics ); }
+    else if ( arg == "--threads" ) { pOptions->metrics.numThreads      = static_cast< unsigned >( std::stoul( value ) ); }
+    else if ( arg == "--ppd" )     { pOptions->metrics.pixelsPerDegree = std::stof( value ); }
+    else if ( arg == "--json" )    { pOptions->json                    = value; }
+    else if ( arg == "--csv" )     { pOptions->csv                     = value; }
+    else
+    {
+
+      throw std::runtime_error( "Unknown option " + arg );
+
+    }
+
+  }
+
+  if ( pOptions->reference.empty( ) || pOptions->tests.empty( ) )
+  {
+
+    throw std::runtime_error( "Usage: --compare reference test [test ...] [options]" );
+
+  }
+
+}
+
+
+void
+writeText(
+          const std::string &filename,
+          const std::string &text
+          )
+{
+
+  std::ofstream file( filename );
+
+  if ( !file.is_open( ) )
+  {
+
+    throw std::runtime_error( "Could not open file for comparison results: " + filename );
+
+  }
+
+  file << text;
+
+}
+
+
+} // namespace
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief isCompareCommand
+///////////////////////////////////////////////////////////////
+bool
+isCompareCommand(
+                 int          argc,
+                 const char **argv
+                 )
+{
+
+  return argc > 1 && argv[ 1 ] == compareFlag;
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief runCompareCommand
+///////////////////////////////////////////////////////////////
+int
+runCompareCommand(
+                  int          argc,
+                  const char **argv
+                  )
+{
+
+  CompareOptions options;
+  parseOptions( argc, argv, &options );
+
+  ImageComparer comparer( readImage( options.reference ), options.metrics );
+
+  std::ostringstream json;
+  std::ostringstream csv;
+  json << std::setprecision( 9 );
+  csv  << std::setprecision( 9 );
+
+  json << "{\n";
+  json << "  \"reference\": \"" << options.reference << "\",\n";
+  json << "  \"width\": " << comparer.getWidth( ) << ",\n";
+  json << "  \"height\": " << comparer.getHeight( ) << ",\n";
+  json << "  \"images\": [";
+
+  csv << "image,mse,relmse,ssim,flip\n";
+
+  std::cout << "           mse        relMSE     SSIM     FLIP  image\n";
+
+  for ( std::size_t t = 0; t < options.tests.size( ); ++t )
+  {
+
+    const std::string &name    = options.tests[ t ];
+    ImageMetrics       metrics = comparer.compare( readImage( name ) );
+
+    char line[ 128 ];
+    std::snprintf( line, sizeof( line ), "%14.6g %13.6g ", metrics.mse, metrics.relMse );
+    std::cout << line;
+
+    json << ( t == 0 ? "\n" : ",\n" )
+         << "    { \"image\": \"" << name
+         << "\", \"mse\": " << metrics.mse
+         << ", \"relmse\": " << metrics.relMse;
+
+    csv << name << "," << metrics.mse << "," << metrics.relMse << ",";
+
+    if ( options.metrics.ssim )
+    {
+
+      std::snprintf( line, sizeof( line ), "%8.5f ", metrics.ssim );
+      std::cout << line;
+      json << ", \"ssim\": " << metrics.ssim;
+      csv << metrics.ssim;
+
+    }
+    else
+    {
+      std::cout << "       - ";
+    }
+
+    csv << ",";
+
+    if ( options.metrics.flip )
+    {
+
+      std::snprintf( line, sizeof( line ), "%8.5f ", metrics.flip );
+      std::cout << line;
+      json << ", \"flip\": " << metrics.flip;
+      csv << metrics.flip;
+
+    }
+    else
+    {
+      std::cout << "       - ";
+    }
+
+    std::cout << " " << name << "\n";
+    json << " }";
+    csv << "\n";
+
+  }
+
+  json << "\n  ]\n";
+  json << "}\n";
+
+  std::cout << std::flush;
+
+  if ( !options.json.empty( ) )
+  {
+    writeText( options.json, json.str( ) );
+  }
+
+  if ( !options.csv.empty( ) )
+  {
+    writeText( options.csv, csv.str( ) );
+  }
+
+  return EXIT_SUCCESS;
+
+} // runCompareCommand
+
+
+
+} // namespace light
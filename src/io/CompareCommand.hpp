@@ -0,0 +1,49 @@
+#ifndef CompareCommand_hpp
+#define CompareCommand_hpp
+
+
+namespace light
+{
+
+
+///////////////////////////////////////////////////////////////
+/// \brief isCompareCommand
+/// \return true if the arguments ask to score images against
+///         a reference instead of opening the viewer
+///////////////////////////////////////////////////////////////
+bool isCompareCommand (
+                       int          argc,
+                       const char **argv
+                       );
+
+
+///////////////////////////////////////////////////////////////
+/// \brief runCompareCommand
+///
+///        Scores every test image against the reference and
+///        prints MSE, relMSE, SSIM and FLIP for each. The
+///        reference is prepared once, so long lists of frames
+///        from convergence sweeps are cheap. Also run by the
+///        standalone lightbender-compare tool. Needs no GPU.
+///
+///        --compare reference test [test ...] [options]
+///            --metrics mse,relmse,ssim,flip   metrics to compute
+///            --threads N                     defaults to every hardware thread
+///            --ppd N                         FLIP pixels per degree
+///            --json file                     also write results as JSON
+///            --csv file                      also write results as CSV
+///
+///        Images are .ppm, .pgm, .pfm or uncompressed .exr.
+///
+/// \return process exit code
+///////////////////////////////////////////////////////////////
+int runCompareCommand (
+                       int          argc,
+                       const char **argv
+                       );
+
+
+} // namespace light
+
+
+#endif // CompareCommand_hpp
@@ -0,0 +1,361 @@
+#include "Convergence.hpp"
+#include <cmath>
+#include <chrono>
+#include <algorithm>
+#include <stdexcept>
+#include "AccumulationBuffer.hpp"
+#include "Trace.hpp"
+
+
+namespace light
+{
+
+
+namespace
+{
+
+
+///
+/// \brief renderFrame
+///
+///        Adds frame 'frame' of the whole image to the buffer
+///
+void
+renderFrame(
+            WorkerRendererInterface *pRenderer,
+            AccumulationBuffer      *pBuffer,
+            unsigned                 frame
+            )
+{
+
+  WorkUnit unit;
+  unit.width      = pBuffer->getWidth( );
+  unit.height     = pBuffer->getHeight( );
+  unit.firstFrame = frame;
+  unit.frameCount = 1;
+
+  PartialResult result;
+  pRenderer->render( unit, &result );
+  result.unit = unit;
+
+  pBuffer->merge( result );
+
+}
+
+
+Image
+resolveImage( const AccumulationBuffer &buffer )
+{
+
+  Image image;
+  image.width  = buffer.getWidth( );
+  image.height = buffer.getHeight( );
+  buffer.resolve( &image.rgba );
+
+  return image;
+
+}
+
+
+///
+/// \brief lerpLogLog
+/// \return y at x on the line through (x0, y0) and (x1, y1) in
+///         log-log space
+///
+double
+lerpLogLog(
+           double x0,
+           double x1,
+           double y0,
+           double y1,
+           double x
+           )
+{
+
+  const double tiny = 1e-300;
+
+  double lx0 = std::log( std::max( x0, tiny ) );
+  double lx1 = std::log( std::max( x1, tiny ) );
+  double ly0 = std::log( std::max( y0, tiny ) );
+  double ly1 = std::log( std::max( y1, tiny ) );
+
+  double t = lx1 != lx0 ? ( std::log( std::max( x, tiny ) ) - lx0 ) / ( lx1 - lx0 ) : 1.0;
+
+  return std::exp( ly0 + ( ly1 - ly0 ) * t );
+
+}
+
+
+///
+/// \brief relMseAt
+/// \return the curve's relMSE at a render time, clamped to its ends
+///
+double
+relMseAt(
+         const std::vector< ConvergencePoint > &points,
+         double                                 seconds
+         )
+{
+
+  if ( seconds <= points.front( ).seconds )
+  {
+    return points.front( ).metrics.relMse;
+  }
+
+  for ( std::size_t i = 1; i < points.size( ); ++i )
+  {
+
+    if ( seconds <= points[ i ].seconds )
+    {
+
+      return lerpLogLog(
+                        points[ i - 1 ].seconds,
+                        points[ i ].seconds,
+                        points[ i - 1 ].metrics.relMse,
+                        points[ i ].metrics.relMse,
+                        seconds
+                        );
+
+    }
+
+  }
+
+  return points.back( ).metrics.relMse;
+
+}
+
+
+///
+/// \brief timeToReach
+/// \return render time at which the curve's relMSE first falls
+///         to the target, the last time if it never does
+///
+double
+timeToReach(
+            const std::vector< ConvergencePoint > &points,
+            double                                 target
+            )
+{
+
+  if ( points.front( ).metrics.relMse <= target )
+  {
+    return points.front( ).seconds;
+  }
+
+  for ( std::size_t i = 1; i < points.size( ); ++i )
+  {
+
+    if ( points[ i ].metrics.relMse <= target )
+    {
+
+      return lerpLogLog(
+                        points[ i - 1 ].metrics.relMse,
+                        points[ i ].metrics.relMse,
+                        points[ i - 1 ].seconds,
+                        points[ i ].seconds,
+                        target
+                        );
+
+    }
+
+  }
+
+  return points.back( ).seconds;
+
+}
+
+
+} // namespace
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief getLogSpacedCounts
+///////////////////////////////////////////////////////////////
+std::vector< unsigned >
+getLogSpacedCounts(
+                   unsigned maxCount,
+                   unsigned perDecade
+                   )
+{
+
+  std::vector< unsigned > counts;
+
+  if ( maxCount == 0 )
+  {
+    return counts;
+  }
+
+  perDecade = std::max( 1u, perDecade );
+
+  for ( unsigned step = 0; ; ++step )
+  {
+
+    double   value = std::pow( 10.0, static_cast< double >( step ) / perDecade );
+    unsigned count = static_cast< unsigned >( std::min( std::round( value ), static_cast< double >( maxCount ) ) );
+
+    if ( counts.empty( ) || count > counts.back( ) )
+    {
+      counts.push_back( count );
+    }
+
+    if ( count >= maxCount )
+    {
+      break;
+    }
+
+  }
+
+  return counts;
+
+} // getLogSpacedCounts
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief renderAverage
+///////////////////////////////////////////////////////////////
+Image
+renderAverage(
+              WorkerRendererInterface *pRenderer,
+              unsigned                 width,
+              unsigned                 height,
+              unsigned                 frames
+              )
+{
+
+  LIGHT_TRACE_SCOPE( "reference", "render" );
+
+  AccumulationBuffer buffer( width, height );
+
+  for ( unsigned frame = 0; frame < frames; ++frame )
+  {
+    renderFrame( pRenderer, &buffer, frame );
+  }
+
+  return resolveImage( buffer );
+
+} // renderAverage
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief measureConvergence
+///////////////////////////////////////////////////////////////
+std::vector< ConvergencePoint >
+measureConvergence(
+                   WorkerRendererInterface  *pRenderer,
+                   const ImageComparer      &comparer,
+                   const ConvergenceOptions &options
+                   )
+{
+
+  LIGHT_TRACE_SCOPE( "convergence", "render" );
+
+  AccumulationBuffer buffer( comparer.getWidth( ), comparer.getHeight( ) );
+
+  std::vector< unsigned > snapshotFrames = getLogSpacedCounts( options.maxFrames, options.snapshotsPerDecade );
+  std::size_t             nextSnapshot   = 0;
+
+  double nextSnapshotTime = 0.0;
+  double timeStep         = std::pow( 10.0, 1.0 / std::max( 1u, options.snapshotsPerDecade ) );
+
+  std::vector< ConvergencePoint > points;
+
+  double seconds = 0.0;
+
+  for ( unsigned frame = 0; frame < options.maxFrames; ++frame )
+  {
+
+    auto start = std::chrono::steady_clock::now( );
+
+    renderFrame( pRenderer, &buffer, frame );
+
+    seconds += std::chrono::duration< double >( std::chrono::steady_clock::now( ) - start ).count( );
+
+    unsigned frames = frame + 1;
+    bool     last   = frames == options.maxFrames || ( options.maxSeconds > 0.0 && seconds >= options.maxSeconds );
+    bool     score  = last;
+
+    if ( options.snapshotByTime )
+    {
+
+      // each snapshot time is a fixed ratio past the last one
+      if ( seconds >= nextSnapshotTime )
+      {
+
+        score            = true;
+        nextSnapshotTime = std::max( seconds, 1e-9 ) * timeStep;
+
+      }
+
+    }
+    else if ( nextSnapshot < snapshotFrames.size( ) && frames == snapshotFrames[ nextSnapshot ] )
+    {
+
+      score = true;
+      ++nextSnapshot;
+
+    }
+
+    if ( score )
+    {
+
+      ConvergencePoint point;
+      point.frames          = frames;
+      point.samplesPerPixel = buffer.getSampleCount( 0, 0 );
+      point.seconds         = seconds;
+      point.metrics         = comparer.compare( resolveImage( buffer ) );
+
+      points.push_back( point );
+
+    }
+
+    if ( last )
+    {
+      break;
+    }
+
+  }
+
+  return points;
+
+} // measureConvergence
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief compareConvergence
+///////////////////////////////////////////////////////////////
+ConvergenceComparison
+compareConvergence(
+                   const std::vector< ConvergencePoint > &a,
+                   const std::vector< ConvergencePoint > &b
+                   )
+{
+
+  if ( a.empty( ) || b.empty( ) )
+  {
+
+    throw std::runtime_error( "Convergence curves need at least one snapshot to compare" );
+
+  }
+
+  ConvergenceComparison comparison;
+
+  comparison.equalTimeSeconds = std::min( a.back( ).seconds, b.back( ).seconds );
+  comparison.relMseA          = relMseAt( a, comparison.equalTimeSeconds );
+  comparison.relMseB          = relMseAt( b, comparison.equalTimeSeconds );
+
+  comparison.targetRelMse = std::max( a.back( ).metrics.relMse, b.back( ).metrics.relMse );
+  comparison.secondsA     = timeToReach( a, comparison.targetRelMse );
+  comparison.secondsB     = timeToReach( b, comparison.targetRelMse );
+  comparison.speedup      = comparison.secondsB > 0.0 ? comparison.secondsA / comparison.secondsB : 0.0;
+
+  return comparison;
+
+} // compareConvergence
+
+
+
+} // namespace light
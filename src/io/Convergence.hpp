@@ -0,0 +1,121 @@
+#ifndef Convergence_hpp
+#define Convergence_hpp
+
+
+#include <vector>
+#include <cstdint>
+#include "RenderWorker.hpp"
+#include "ImageMetrics.hpp"
+
+
+namespace light
+{
+
+
+/////////////////////////////////////////////
+/// \brief The ConvergenceOptions struct
+///
+///        When a progressive render stops and when its
+///        snapshots are scored. Snapshots are spaced evenly in
+///        log scale, either by frame count or by render time.
+/////////////////////////////////////////////
+struct ConvergenceOptions
+{
+  unsigned maxFrames          = 256;
+  double   maxSeconds         = 0.0;   // stops early when > 0
+  bool     snapshotByTime     = false; // else by frame count
+  unsigned snapshotsPerDecade = 4;
+};
+
+
+/////////////////////////////////////////////
+/// \brief The ConvergencePoint struct
+/////////////////////////////////////////////
+struct ConvergencePoint
+{
+  unsigned      frames          = 0;
+  std::uint64_t samplesPerPixel = 0;
+  double        seconds         = 0.0; // render time only, scoring excluded
+  ImageMetrics  metrics;
+};
+
+
+/////////////////////////////////////////////
+/// \brief The ConvergenceComparison struct
+///
+///        Two convergence curves compared at equal time and at
+///        equal quality, both by relMSE. Values between snapshots
+///        are interpolated linearly in log-log space.
+/////////////////////////////////////////////
+struct ConvergenceComparison
+{
+  double equalTimeSeconds = 0.0; // shorter of the two render times
+  double relMseA          = 0.0; // errors at that time
+  double relMseB          = 0.0;
+
+  double targetRelMse = 0.0; // the higher of the two final errors
+  double secondsA     = 0.0; // time each took to reach it
+  double secondsB     = 0.0;
+
+  double speedup = 0.0; // secondsA / secondsB, above 1 when B is faster
+};
+
+
+///////////////////////////////////////////////////////////////
+/// \brief getLogSpacedCounts
+/// \return 1, then about perDecade counts per power of ten, up to
+///         and including maxCount, without repeats
+///////////////////////////////////////////////////////////////
+std::vector< unsigned > getLogSpacedCounts (
+                                            unsigned maxCount,
+                                            unsigned perDecade
+                                            );
+
+
+///////////////////////////////////////////////////////////////
+/// \brief renderAverage
+///
+///        Renders frames [0, frames) of the whole image one frame
+///        at a time and averages them, for high sample count
+///        references
+/// \param pRenderer already set up with the render settings
+///////////////////////////////////////////////////////////////
+Image renderAverage (
+                     WorkerRendererInterface *pRenderer,
+                     unsigned                 width,
+                     unsigned                 height,
+                     unsigned                 frames
+                     );
+
+
+///////////////////////////////////////////////////////////////
+/// \brief measureConvergence
+///
+///        Renders progressively one frame at a time and scores
+///        the running average against the comparer's reference
+///        at log-spaced frame counts or times. The last frame is
+///        always scored.
+/// \param pRenderer already set up with the render settings
+///////////////////////////////////////////////////////////////
+std::vector< ConvergencePoint > measureConvergence (
+                                                    WorkerRendererInterface  *pRenderer,
+                                                    const ImageComparer      &comparer,
+                                                    const ConvergenceOptions &options
+                                                    );
+
+
+///////////////////////////////////////////////////////////////
+/// \brief compareConvergence
+/// \return equal time and equal quality comparison of two
+///         curves, throws if either is empty
+///////////////////////////////////////////////////////////////
+ConvergenceComparison compareConvergence (
+                                          const std::vector< ConvergencePoint > &a,
+                                          const std::vector< ConvergencePoint > &b
+                                          );
+
+
+} // namespace light
+
+
+#endif // Convergence_hpp
@@ -0,0 +1,516 @@
+#include "ConvergenceCommand.hpp"
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include "glm/glm.hpp"
+#include "graphics/Camera.hpp"
+#include "LightBenderConfig.hpp"
+#include "Convergence.hpp"
+#include "ImageIO.hpp"
+#include "HostWorkerRenderer.hpp"
+#include "OptixWorkerRenderer.hpp"
+#include "OptixSceneFactory.hpp"
+
+
+namespace light
+{
+
+
+namespace
+{
+
+
+const std::string convergenceFlag = "--convergence";
+
+const char *sceneNames[] = { "basic", "advanced", "model", "file", "stress" };
+
+// keeps reference noise independent of the measured frames
+constexpr std::uint32_t referenceSeedOffset = 0x5bd1e995u;
+
+
+struct ConvergenceCommandOptions
+{
+  std::vector< int > scenes          = { 0, 1 };
+  std::string        modelFile;
+  unsigned           width           = 320;
+  unsigned           height          = 180;
+  std::string        backend         = "gpu";
+  unsigned           threads         = 0;
+  std::string        configA;
+  std::string        configB;
+  unsigned           referenceFrames = 4096;
+  unsigned           reuseReference  = 0;
+  std::uint32_t      seed            = 0;
+  std::string        output          = "convergence";
+
+  ConvergenceOptions convergence;
+};
+
+
+std::vector< int >
+parseScenes( const std::string &value )
+{
+
+  std::vector< int > scenes;
+  std::stringstream  list( value );
+  std::string        item;
+
+  while ( std::getline( list, item, ',' ) )
+  {
+
+    int scene = std::stoi( item );
+
+    if ( scene < 0 || scene > 4 )
+    {
+
+      throw std::runtime_error( "Convergence scenes are 0 basic, 1 advanced, 2 model, 3 file or 4 stress" );
+
+    }
+
+    scenes.push_back( scene );
+
+  }
+
+  return scenes;
+
+}
+
+
+void
+parseOptions(
+             int                        argc,
+             const char               **argv,
+             ConvergenceCommandOptions *pOptions
+             )
+{
+
+  for ( int i = 2; i < argc; ++i )
+  {
+
+    std::string flag( argv[ i ] );
+
+    if ( i + 1 >= argc )
+    {
+
+      throw std::runtime_error( "Missing value for " + flag );
+
+    }
+
+    std::string value( argv[ ++i ] );
+
+    if      ( flag == "--scenes" )           { pOptions->scenes          = parseScenes( value ); }
+    else if ( flag == "--model" )            { pOptions->modelFile       = value; }
+    else if ( flag == "--width" )            { pOptions->width           = static_cast< unsigned >( std::stoul( value ) ); }
+    else if ( flag == "--height" )           { pOptions->height          = static_cast< unsigned >( std::stoul( value ) ); }
+    else if ( flag == "--backend" )          { pOptions->backend         = value; }
+    else if ( flag == "--threads" )          { pOptions->threads         = static_cast< unsigned >( std::stoul( value ) ); }
+    else if ( flag == "--config-a" )         { pOptions->configA         = value; }
+    else if ( flag == "--config-b" )         { pOptions->configB         = value; }
+    else if ( flag == "--reference-frames" ) { pOptions->referenceFrames = static_cast< unsigned >( std::stoul( value ) ); }
+    else if ( flag == "--reuse-reference" )  { pOptions->reuseReference  = static_cast< unsigned >( std::stoul( value ) ); }
+    else if ( flag == "--seed" )             { pOptions->seed            = static_cast< std::uint32_t >( std::stoul( value ) ); }
+    else if ( flag == "--output" )           { pOptions->output          = value; }
+    else if ( flag == "--frames" )
+    {
+      pOptions->convergence.maxFrames = static_cast< unsigned >( std::stoul( value ) );
+    }
+    else if ( flag == "--seconds" )
+    {
+      pOptions->convergence.maxSeconds = std::stod( value );
+    }
+    else if ( flag == "--per-decade" )
+    {
+      pOptions->convergence.snapshotsPerDecade = static_cast< unsigned >( std::stoul( value ) );
+    }
+    else if ( flag == "--by" )
+    {
+
+      if ( value != "frames" && value != "time" )
+      {
+
+        throw std::runtime_error( "--by expects frames or time" );
+
+      }
+
+      pOptions->convergence.snapshotByTime = value == "time";
+
+    }
+    else
+    {
+
+      throw std::runtime_error( "Unknown option " + flag );
+
+    }
+
+  }
+
+  if ( pOptions->backend != "gpu" && pOptions->backend != "host" )
+  {
+
+    throw std::runtime_error( "--backend expects gpu or host" );
+
+  }
+
+  if ( pOptions->width == 0 || pOptions->height == 0 || pOptions->scenes.empty( )
+      || pOptions->referenceFrames == 0 || pOptions->convergence.maxFrames == 0 )
+  {
+
+    throw std::runtime_error( "Convergence runs need an image size, a scene, reference frames and frames" );
+
+  }
+
+} // parseOptions
+
+
+///
+/// \brief applyRenderConfig
+///
+///        Sets render settings from comma separated name=value
+///        pairs, "sqrtSamples=2,maxBounces=5"
+///
+void
+applyRenderConfig(
+                  const std::string &spec,
+                  RenderSettings    *pSettings
+                  )
+{
+
+  std::stringstream pairs( spec );
+  std::string       pair;
+
+  while ( std::getline( pairs, pair, ',' ) )
+  {
+
+    if ( pair.empty( ) )
+    {
+      continue;
+    }
+
+    std::size_t equals = pair.find( '=' );
+
+    if ( equals == std::string::npos )
+    {
+
+      throw std::runtime_error( "Render configurations are name=value pairs: " + pair );
+
+    }
+
+    std::string   name  = pair.substr( 0, equals );
+    std::uint32_t value = static_cast< std::uint32_t >( std::stoul( pair.substr( equals + 1 ) ) );
+
+    if      ( name == "sqrtSamples" ) { pSettings->sqrtSamples = value; }
+    else if ( name == "maxBounces" )  { pSettings->maxBounces  = value; }
+    else if ( name == "firstBounce" ) { pSettings->firstBounce = value; }
+    else if ( name == "cameraType" )  { pSettings->cameraType  = static_cast< std::int32_t >( value ); }
+    else if ( name == "displayType" ) { pSettings->displayType = static_cast< std::int32_t >( value ); }
+    else if ( name == "pathTracing" ) { pSettings->pathTracing = value != 0; }
+    else
+    {
+
+      throw std::runtime_error( "Unknown render setting " + name );
+
+    }
+
+  }
+
+}
+
+
+void
+setViewerCamera( RenderSettings *pSettings )
+{
+
+  // same starting view as the viewer and batch renders
+  graphics::Camera camera;
+  camera.setAspectRatio( pSettings->width * 1.0f / pSettings->height );
+  camera.updateOrbit( 20.0f, 45.0f, -30.0f );
+
+  glm::vec3 eye( camera.getEye( ) );
+  glm::vec3 U, V, W;
+
+  camera.buildRayBasisVectors( &U, &V, &W );
+
+  for ( int c = 0; c < 3; ++c )
+  {
+
+    pSettings->eye[ c ] = eye[ c ];
+    pSettings->U  [ c ] = U  [ c ];
+    pSettings->V  [ c ] = V  [ c ];
+    pSettings->W  [ c ] = W  [ c ];
+
+  }
+
+}
+
+
+bool
+fileExists( const std::string &filename )
+{
+
+  return std::ifstream( filename ).good( );
+
+}
+
+
+void
+printCurve(
+           const std::string                     &title,
+           const std::vector< ConvergencePoint > &points
+           )
+{
+
+  std::cout << "\n" << title << "\n";
+  std::cout << " frames       spp    seconds          mse       relMSE     SSIM     FLIP\n";
+
+  for ( const ConvergencePoint &point : points )
+  {
+
+    char line[ 160 ];
+    std::snprintf(
+                  line,
+                  sizeof( line ),
+                  "%7u %9llu %10.4f %12.5g %12.5g %8.5f %8.5f\n",
+                  point.frames,
+                  static_cast< unsigned long long >( point.samplesPerPixel ),
+                  point.seconds,
+                  point.metrics.mse,
+                  point.metrics.relMse,
+                  point.metrics.ssim,
+                  point.metrics.flip
+                  );
+
+    std::cout << line;
+
+  }
+
+}
+
+
+} // namespace
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief isConvergenceCommand
+///////////////////////////////////////////////////////////////
+bool
+isConvergenceCommand(
+                     int          argc,
+                     const char **argv
+                     )
+{
+
+  return argc > 1 && argv[ 1 ] == convergenceFlag;
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief runConvergenceCommand
+///////////////////////////////////////////////////////////////
+int
+runConvergenceCommand(
+                      int          argc,
+                      const char **argv
+                      )
+{
+
+  ConvergenceCommandOptions options;
+  parseOptions( argc, argv, &options );
+
+  std::unique_ptr< WorkerRendererInterface > upRenderer;
+
+  if ( options.backend == "host" )
+  {
+    upRenderer.reset( new HostWorkerRenderer( options.threads ) );
+  }
+  else
+  {
+    upRenderer.reset( new OptixWorkerRenderer( ) );
+  }
+
+  std::vector< std::string > configs = { options.configA };
+  std::vector< std::string > labels  = { "a" };
+
+  if ( !options.configB.empty( ) )
+  {
+
+    configs.push_back( options.configB );
+    labels.push_back( "b" );
+
+  }
+
+  std::ostringstream json;
+  std::ostringstream csv;
+  json << std::setprecision( 9 );
+  csv  << std::setprecision( 9 );
+
+  json << "{\n";
+  json << "  \"backend\": \"" << options.backend << "\",\n";
+  json << "  \"width\": " << options.width << ",\n";
+  json << "  \"height\": " << options.height << ",\n";
+  json << "  \"referenceFrames\": " << options.referenceFrames << ",\n";
+  json << "  \"snapshotsBy\": \"" << ( options.convergence.snapshotByTime ? "time" : "frames" ) << "\",\n";
+  json << "  \"scenes\": [";
+
+  csv << "scene,config,frames,samplesPerPixel,seconds,mse,relmse,ssim,flip\n";
+
+  for ( std::size_t s = 0; s < options.scenes.size( ); ++s )
+  {
+
+    const char *name = sceneNames[ options.scenes[ s ] ];
+
+    RenderSettings base;
+    base.sceneType  = options.scenes[ s ];
+    base.modelFile  = options.modelFile;
+    base.width      = options.width;
+    base.height     = options.height;
+    base.globalSeed = options.seed;
+
+    if ( base.sceneType == 2 && base.modelFile.empty( ) )
+    {
+      base.modelFile = getDefaultModelFile( );
+    }
+
+    setViewerCamera( &base );
+
+    //
+    // reference from configuration a with its own seed
+    //
+    std::string referenceFile = light::OUTPUT_PATH + options.output + "_" + name + "_reference.pfm";
+    Image       reference;
+
+    if ( options.reuseReference != 0 && fileExists( referenceFile ) )
+    {
+
+      reference = readImage( referenceFile );
+      std::cout << "\nUsing " << referenceFile << std::endl;
+
+    }
+    else
+    {
+
+      RenderSettings settings = base;
+      applyRenderConfig( options.configA, &settings );
+      settings.globalSeed = options.seed ^ referenceSeedOffset;
+
+      upRenderer->setup( settings );
+      reference = renderAverage( upRenderer.get( ), options.width, options.height, options.referenceFrames );
+
+      writePFM( referenceFile, reference.width, reference.height, reference.rgba );
+      std::cout << "\nRendered " << referenceFile << std::endl;
+
+    }
+
+    ImageComparer comparer( reference );
+
+    //
+    // one curve per configuration
+    //
+    std::vector< std::vector< ConvergencePoint > > curves;
+
+    json << ( s == 0 ? "\n" : ",\n" )
+         << "    { \"name\": \"" << name << "\", \"configs\": [";
+
+    for ( std::size_t c = 0; c < configs.size( ); ++c )
+    {
+
+      RenderSettings settings = base;
+      applyRenderConfig( configs[ c ], &settings );
+
+      upRenderer->setup( settings );
+      curves.push_back( measureConvergence( upRenderer.get( ), comparer, options.convergence ) );
+
+      printCurve( std::string( name ) + " scene, config " + labels[ c ] + " \"" + configs[ c ] + "\"", curves.back( ) );
+
+      json << ( c == 0 ? "\n" : ",\n" )
+           << "      { \"name\": \"" << labels[ c ] << "\", \"settings\": \"" << configs[ c ] << "\", \"points\": [";
+
+      for ( std::size_t p = 0; p < curves.back( ).size( ); ++p )
+      {
+
+        const ConvergencePoint &point = curves.back( )[ p ];
+
+        json << ( p == 0 ? "\n" : ",\n" )
+             << "        { \"frames\": " << point.frames
+             << ", \"samplesPerPixel\": " << point.samplesPerPixel
+             << ", \"seconds\": " << point.seconds
+             << ", \"mse\": " << point.metrics.mse
+             << ", \"relmse\": " << point.metrics.relMse
+             << ", \"ssim\": " << point.metrics.ssim
+             << ", \"flip\": " << point.metrics.flip << " }";
+
+        csv << name << "," << labels[ c ] << "," << point.frames << "," << point.samplesPerPixel << ","
+            << point.seconds << "," << point.metrics.mse << "," << point.metrics.relMse << ","
+            << point.metrics.ssim << "," << point.metrics.flip << "\n";
+
+      }
+
+      json << "\n      ] }";
+
+    }
+
+    json << "\n    ]";
+
+    if ( curves.size( ) == 2 )
+    {
+
+      ConvergenceComparison comparison = compareConvergence( curves[ 0 ], curves[ 1 ] );
+
+      std::cout << "\nAt " << comparison.equalTimeSeconds << " s relMSE is "
+                << comparison.relMseA << " (a) vs " << comparison.relMseB << " (b)\n"
+                << "Reaching relMSE " << comparison.targetRelMse << " takes "
+                << comparison.secondsA << " s (a) vs " << comparison.secondsB << " s (b), "
+                << comparison.speedup << "x\n";
+
+      json << ",\n    \"comparison\": { \"equalTimeSeconds\": " << comparison.equalTimeSeconds
+           << ", \"relmseA\": " << comparison.relMseA
+           << ", \"relmseB\": " << comparison.relMseB
+           << ", \"targetRelmse\": " << comparison.targetRelMse
+           << ", \"secondsA\": " << comparison.secondsA
+           << ", \"secondsB\": " << comparison.secondsB
+           << ", \"speedup\": " << comparison.speedup << " }";
+
+    }
+
+    json << " }";
+
+  }
+
+  json << "\n  ]\n";
+  json << "}\n";
+
+  for ( const char *pExtension : { "json", "csv" } )
+  {
+
+    std::string   filename = light::OUTPUT_PATH + options.output + "_convergence." + pExtension;
+    std::ofstream file( filename );
+
+    if ( !file.is_open( ) )
+    {
+
+      throw std::runtime_error( "Could not open file for convergence results: " + filename );
+
+    }
+
+    file << ( std::string( pExtension ) == "json" ? json.str( ) : csv.str( ) );
+
+    std::cout << "Results saved to " << filename << std::endl;
+
+  }
+
+  return EXIT_SUCCESS;
+
+} // runConvergenceCommand
+
+
+
+} // namespace light
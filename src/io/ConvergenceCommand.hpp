@@ -0,0 +1,65 @@
+#ifndef ConvergenceCommand_hpp
+#define ConvergenceCommand_hpp
+
+
+namespace light
+{
+
+
+///////////////////////////////////////////////////////////////
+/// \brief isConvergenceCommand
+/// \return true if the arguments ask for error vs time curves
+///         instead of the interactive viewer
+///////////////////////////////////////////////////////////////
+bool isConvergenceCommand (
+                           int          argc,
+                           const char **argv
+                           );
+
+
+///////////////////////////////////////////////////////////////
+/// \brief runConvergenceCommand
+///
+///        Renders a high sample count reference for each scene,
+///        then renders it progressively with one or two render
+///        configurations and scores snapshots at log-spaced frame
+///        counts or times with MSE, relMSE, SSIM and FLIP. Curves
+///        are written to <output>_convergence.json and .csv and,
+///        with two configurations, compared at equal time and at
+///        equal relMSE. References use a different seed from the
+///        measured renders so their noise is independent, and are
+///        saved as <output>_<scene>_reference.pfm.
+///
+///        --convergence [options]
+///            --scenes 0,1                 0 basic, 1 advanced, 2 model,
+///                                         3 scene file, 4 stress scene
+///            --model file                 mesh, scene description or
+///                                         stress scene options
+///            --width W --height H         image size
+///            --backend gpu|host           OptiX or HostRenderer
+///            --threads N                  host render threads
+///            --config-a spec              name=value render settings:
+///            --config-b spec              sqrtSamples, maxBounces,
+///                                         firstBounce, cameraType,
+///                                         displayType, pathTracing
+///            --reference-frames N         frames in each reference
+///            --reuse-reference 0|1        load saved references
+///            --frames N                   most frames per curve
+///            --seconds S                  stop curves after S seconds
+///            --by frames|time             snapshot spacing
+///            --per-decade N               snapshots per power of ten
+///            --seed N                     random seed of the curves
+///            --output name                file prefix
+///
+/// \return process exit code
+///////////////////////////////////////////////////////////////
+int runConvergenceCommand (
+                           int          argc,
+                           const char **argv
+                           );
+
+
+} // namespace light
+
+
+#endif // ConvergenceCommand_hpp
@@ -0,0 +1,102 @@
+#ifndef Hash_hpp
+#define Hash_hpp
+
+
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+
+
+namespace light
+{
+
+
+constexpr std::uint64_t hashSeed  = 0xcbf29ce484222325ull; // FNV-1a offset basis
+constexpr std::uint64_t hashPrime = 0x100000001b3ull;      // FNV-1a prime
+
+
+///////////////////////////////////////////////////////////////
+/// \brief hashBytes
+///
+///        FNV-1a style hash that consumes eight bytes per step so
+///        large buffers (images, vertex arrays) hash quickly.
+///        Results are stable across runs and platforms of the
+///        same endianness, so they can be stored in files.
+/// \param pData
+/// \param bytes
+/// \param hash previous hash to continue from
+///////////////////////////////////////////////////////////////
+inline
+std::uint64_t
+hashBytes(
+          const void   *pData,
+          std::size_t   bytes,
+          std::uint64_t hash = hashSeed
+          )
+{
+
+  const unsigned char *pBytes = static_cast< const unsigned char* >( pData );
+
+  for ( ; bytes >= sizeof( std::uint64_t ); bytes -= sizeof( std::uint64_t ) )
+  {
+
+    std::uint64_t word;
+    std::memcpy( &word, pBytes, sizeof( word ) );
+
+    hash   = ( hash ^ word ) * hashPrime;
+    hash  ^= hash >> 29;
+    pBytes += sizeof( word );
+
+  }
+
+  for ( ; bytes > 0; --bytes )
+  {
+
+    hash = ( hash ^ *pBytes++ ) * hashPrime;
+
+  }
+
+  return hash;
+
+} // hashBytes
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief hashValue
+///
+///        Hashes a trivially copyable value
+///////////////////////////////////////////////////////////////
+template< typename T >
+std::uint64_t
+hashValue(
+          const T      &value,
+          std::uint64_t hash = hashSeed
+          )
+{
+
+  return hashBytes( &value, sizeof( T ), hash );
+
+}
+
+
+
+inline
+std::uint64_t
+hashString(
+           const std::string &text,
+           std::uint64_t      hash = hashSeed
+           )
+{
+
+  hash = hashValue( static_cast< std::uint64_t >( text.size( ) ), hash );
+  return hashBytes( text.data( ), text.size( ), hash );
+
+}
+
+
+} // namespace light
+
+
+#endif // Hash_hpp
@@ -0,0 +1,1082 @@
+#include "ImageIO.hpp"
+#include "Instrumentation.hpp"
+#include "SimdKernels.hpp"
+#include <cmath>
+#include <cctype>
+#include <cstring>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+#include <stdexcept>
+
+
+namespace light
+{
+
+
+namespace
+{
+
+
+///
+/// \brief checkImage
+///
+void
+checkImage(
+           unsigned                    width,
+           unsigned                    height,
+           const std::vector< float > &rgba
+           )
+{
+
+  if ( width == 0 || height == 0 || rgba.size( ) != static_cast< std::size_t >( width ) * height * 4 )
+  {
+
+    throw std::runtime_error( "Image is ill-formed. Not saving" );
+
+  }
+
+}
+
+
+std::string
+getExtension( const std::string &filename )
+{
+
+  std::size_t dot = filename.find_last_of( '.' );
+
+  if ( dot == std::string::npos )
+  {
+    return "";
+  }
+
+  std::string extension = filename.substr( dot + 1 );
+  std::transform( extension.begin( ), extension.end( ), extension.begin( ), ::tolower );
+
+  return extension;
+
+}
+
+
+std::vector< unsigned char >
+readBytes( const std::string &filename )
+{
+
+  std::ifstream file( filename, std::ios::in | std::ios::binary );
+
+  if ( !file.is_open( ) )
+  {
+
+    throw std::runtime_error( "Could not open image: " + filename );
+
+  }
+
+  return std::vector< unsigned char >( std::istreambuf_iterator< char >( file ), std::istreambuf_iterator< char >( ) );
+
+}
+
+
+void
+writeBytes(
+           const std::string                  &filename,
+           const std::vector< unsigned char > &bytes
+           )
+{
+
+  std::ofstream file( filename, std::ios::out | std::ios::binary );
+
+  if ( !file.is_open( ) )
+  {
+
+    throw std::runtime_error( "Could not open file for writing image: " + filename );
+
+  }
+
+  file.write( reinterpret_cast< const char* >( bytes.data( ) ), static_cast< std::streamsize >( bytes.size( ) ) );
+
+}
+
+
+///
+/// \brief The ByteReader struct
+///
+///        Bounds checked little or big endian reads from a
+///        file held in memory
+///
+struct ByteReader
+{
+
+  const std::vector< unsigned char > &bytes;
+  std::size_t                         position;
+  std::string                         filename;
+
+
+  void
+  require( std::size_t count ) const
+  {
+
+    if ( position + count > bytes.size( ) )
+    {
+
+      throw std::runtime_error( "Image file is truncated: " + filename );
+
+    }
+
+  }
+
+
+  std::uint32_t
+  readU32( bool littleEndian = true )
+  {
+
+    require( 4 );
+
+    const unsigned char *p = bytes.data( ) + position;
+    position += 4;
+
+    return littleEndian
+           ? ( std::uint32_t( p[ 0 ] ) | std::uint32_t( p[ 1 ] ) << 8 | std::uint32_t( p[ 2 ] ) << 16 | std::uint32_t( p[ 3 ] ) << 24 )
+           : ( std::uint32_t( p[ 3 ] ) | std::uint32_t( p[ 2 ] ) << 8 | std::uint32_t( p[ 1 ] ) << 16 | std::uint32_t( p[ 0 ] ) << 24 );
+
+  }
+
+
+  std::uint64_t
+  readU64( )
+  {
+
+    std::uint64_t low = readU32( );
+    return low | std::uint64_t( readU32( ) ) << 32;
+
+  }
+
+
+  std::uint16_t
+  readU16( bool littleEndian = true )
+  {
+
+    require( 2 );
+
+    const unsigned char *p = bytes.data( ) + position;
+    position += 2;
+
+    return littleEndian
+           ? static_cast< std::uint16_t >( p[ 0 ] | p[ 1 ] << 8 )
+           : static_cast< std::uint16_t >( p[ 1 ] | p[ 0 ] << 8 );
+
+  }
+
+
+  float
+  readFloat( bool littleEndian = true )
+  {
+
+    std::uint32_t bits = readU32( littleEndian );
+    float         value;
+    std::memcpy( &value, &bits, sizeof( value ) );
+
+    return value;
+
+  }
+
+
+  std::string
+  readString( )
+  {
+
+    std::string text;
+
+    while ( true )
+    {
+
+      require( 1 );
+      char c = static_cast< char >( bytes[ position++ ] );
+
+      if ( c == '\0' )
+      {
+        return text;
+      }
+
+      text += c;
+
+    }
+
+  }
+
+
+  ///
+  /// \brief readToken
+  ///
+  ///        Next whitespace separated word of a PPM or PFM
+  ///        header, skipping '#' comments
+  ///
+  std::string
+  readToken( )
+  {
+
+    std::string token;
+
+    while ( true )
+    {
+
+      if ( position == bytes.size( ) && !token.empty( ) )
+      {
+        return token; // last value of an ASCII file
+      }
+
+      require( 1 );
+      char c = static_cast< char >( bytes[ position ] );
+
+      if ( c == '#' && token.empty( ) )
+      {
+
+        while ( position < bytes.size( ) && bytes[ position ] != '\n' )
+        {
+          ++position;
+        }
+
+      }
+      else if ( std::isspace( static_cast< unsigned char >( c ) ) )
+      {
+
+        ++position;
+
+        if ( !token.empty( ) )
+        {
+          return token; // the single whitespace before binary data is consumed
+        }
+
+      }
+      else
+      {
+
+        token += c;
+        ++position;
+
+      }
+
+    }
+
+  }
+
+
+  unsigned
+  readHeaderNumber( )
+  {
+
+    std::string token = readToken( );
+
+    if ( token.empty( ) || token.find_first_not_of( "0123456789" ) != std::string::npos )
+    {
+
+      throw std::runtime_error( "Bad image header value '" + token + "' in " + filename );
+
+    }
+
+    return static_cast< unsigned >( std::stoul( token ) );
+
+  }
+
+};
+
+
+void
+appendU32(
+          std::vector< unsigned char > *pBytes,
+          std::uint32_t                 value
+          )
+{
+
+  for ( int shift = 0; shift < 32; shift += 8 )
+  {
+    pBytes->push_back( static_cast< unsigned char >( value >> shift ) );
+  }
+
+}
+
+
+void
+appendFloat(
+            std::vector< unsigned char > *pBytes,
+            float                         value
+            )
+{
+
+  std::uint32_t bits;
+  std::memcpy( &bits, &value, sizeof( bits ) );
+  appendU32( pBytes, bits );
+
+}
+
+
+void
+appendString(
+             std::vector< unsigned char > *pBytes,
+             const std::string            &text
+             )
+{
+
+  pBytes->insert( pBytes->end( ), text.begin( ), text.end( ) );
+  pBytes->push_back( 0 );
+
+}
+
+
+void
+appendAttribute(
+                std::vector< unsigned char >       *pBytes,
+                const std::string                  &name,
+                const std::string                  &type,
+                const std::vector< unsigned char > &value
+                )
+{
+
+  appendString( pBytes, name );
+  appendString( pBytes, type );
+  appendU32( pBytes, static_cast< std::uint32_t >( value.size( ) ) );
+  pBytes->insert( pBytes->end( ), value.begin( ), value.end( ) );
+
+}
+
+
+float
+halfToFloat( std::uint16_t half )
+{
+
+  std::uint32_t sign     = ( half >> 15 ) & 1u;
+  std::uint32_t exponent = ( half >> 10 ) & 0x1fu;
+  std::uint32_t mantissa = half & 0x3ffu;
+
+  float value;
+
+  if ( exponent == 0 )
+  {
+    value = std::ldexp( static_cast< float >( mantissa ), -24 ); // subnormal
+  }
+  else if ( exponent == 31 )
+  {
+    value = mantissa == 0 ? INFINITY : NAN;
+  }
+  else
+  {
+    value = std::ldexp( static_cast< float >( mantissa | 0x400u ), static_cast< int >( exponent ) - 25 );
+  }
+
+  return sign ? -value : value;
+
+}
+
+
+Image
+readPPM(
+        const std::string                  &filename,
+        const std::vector< unsigned char > &bytes
+        )
+{
+
+  ByteReader reader { bytes, 0, filename };
+
+  std::string magic = reader.readToken( );
+
+  if ( magic != "P2" && magic != "P3" && magic != "P5" && magic != "P6" )
+  {
+
+    throw std::runtime_error( "Not a PPM or PGM file: " + filename );
+
+  }
+
+  bool     ascii    = magic == "P2" || magic == "P3";
+  unsigned channels = ( magic == "P3" || magic == "P6" ) ? 3 : 1;
+
+  Image image;
+  image.width  = reader.readHeaderNumber( );
+  image.height = reader.readHeaderNumber( );
+
+  unsigned maxValue = reader.readHeaderNumber( );
+
+  if ( image.width == 0 || image.height == 0 || maxValue == 0 || maxValue > 65535 )
+  {
+
+    throw std::runtime_error( "Bad PPM size or maximum value in " + filename );
+
+  }
+
+  float scale = 1.0f / static_cast< float >( maxValue );
+
+  image.rgba.resize( static_cast< std::size_t >( image.width ) * image.height * 4 );
+
+  // files are top-down
+  for ( unsigned row = 0; row < image.height; ++row )
+  {
+
+    float *pDst = image.rgba.data( ) + static_cast< std::size_t >( image.height - 1 - row ) * image.width * 4;
+
+    for ( unsigned x = 0; x < image.width; ++x, pDst += 4 )
+    {
+
+      for ( unsigned c = 0; c < channels; ++c )
+      {
+
+        unsigned value;
+
+        if ( ascii )
+        {
+          value = reader.readHeaderNumber( );
+        }
+        else if ( maxValue < 256 )
+        {
+          reader.require( 1 );
+          value = reader.bytes[ reader.position++ ];
+        }
+        else
+        {
+          value = reader.readU16( false ); // 16 bit samples are big endian
+        }
+
+        pDst[ c ] = static_cast< float >( value ) * scale;
+
+      }
+
+      if ( channels == 1 )
+      {
+        pDst[ 1 ] = pDst[ 2 ] = pDst[ 0 ];
+      }
+
+      pDst[ 3 ] = 1.0f;
+
+    }
+
+  }
+
+  return image;
+
+}
+
+
+Image
+readPFM(
+        const std::string                  &filename,
+        const std::vector< unsigned char > &bytes
+        )
+{
+
+  ByteReader reader { bytes, 0, filename };
+
+  std::string magic = reader.readToken( );
+
+  if ( magic != "PF" && magic != "Pf" )
+  {
+
+    throw std::runtime_error( "Not a PFM file: " + filename );
+
+  }
+
+  unsigned channels = magic == "PF" ? 3 : 1;
+
+  Image image;
+  image.width  = reader.readHeaderNumber( );
+  image.height = reader.readHeaderNumber( );
+
+  std::string scaleToken   = reader.readToken( );
+  bool        littleEndian = !scaleToken.empty( ) && scaleToken[ 0 ] == '-';
+
+  if ( image.width == 0 || image.height == 0 )
+  {
+
+    throw std::runtime_error( "Bad PFM size in " + filename );
+
+  }
+
+  image.rgba.resize( static_cast< std::size_t >( image.width ) * image.height * 4 );
+
+  // rows are already bottom-up
+  for ( std::size_t p = 0; p < image.rgba.size( ); p += 4 )
+  {
+
+    for ( unsigned c = 0; c < channels; ++c )
+    {
+      image.rgba[ p + c ] = reader.readFloat( littleEndian );
+    }
+
+    if ( channels == 1 )
+    {
+      image.rgba[ p + 1 ] = image.rgba[ p + 2 ] = image.rgba[ p ];
+    }
+
+    image.rgba[ p + 3 ] = 1.0f;
+
+  }
+
+  return image;
+
+}
+
+
+Image
+readEXR(
+        const std::string                  &filename,
+        const std::vector< unsigned char > &bytes
+        )
+{
+
+  ByteReader reader { bytes, 0, filename };
+
+  if ( reader.readU32( ) != 20000630u )
+  {
+
+    throw std::runtime_error( "Not an OpenEXR file: " + filename );
+
+  }
+
+  std::uint32_t version = reader.readU32( );
+
+  if ( ( version & 0xffu ) != 2 || ( version & ( 0x200u | 0x800u | 0x1000u ) ) != 0 )
+  {
+
+    throw std::runtime_error( "Only single part scanline OpenEXR files are supported: " + filename );
+
+  }
+
+  struct Channel
+  {
+    std::string   name;
+    std::uint32_t type; // 0 uint, 1 half, 2 float
+    int           target;
+  };
+
+  std::vector< Channel > channels;
+  int compression = -1;
+  int xMin = 0, yMin = 0, xMax = -1, yMax = -1;
+
+  while ( true )
+  {
+
+    std::string name = reader.readString( );
+
+    if ( name.empty( ) )
+    {
+      break; // end of header
+    }
+
+    std::string   type = reader.readString( );
+    std::uint32_t size = reader.readU32( );
+    std::size_t   end  = reader.position + size;
+
+    reader.require( size );
+
+    if ( name == "channels" && type == "chlist" )
+    {
+
+      while ( true )
+      {
+
+        std::string channelName = reader.readString( );
+
+        if ( channelName.empty( ) )
+        {
+          break;
+        }
+
+        std::uint32_t pixelType = reader.readU32( );
+        reader.readU32( ); // pLinear and reserved
+        std::uint32_t xSampling = reader.readU32( );
+        std::uint32_t ySampling = reader.readU32( );
+
+        if ( pixelType > 2 || xSampling != 1 || ySampling != 1 )
+        {
+
+          throw std::runtime_error( "Unsupported OpenEXR channel " + channelName + " in " + filename );
+
+        }
+
+        // last name component so "beauty.R" still maps to red
+        std::string base   = channelName.substr( channelName.find_last_of( '.' ) + 1 );
+        int         target = base == "R" ? 0 : base == "G" ? 1 : base == "B" ? 2 : base == "A" ? 3
+                             : base == "Y" ? 4 : -1;
+
+        channels.push_back( Channel { channelName, pixelType, target } );
+
+      }
+
+    }
+    else if ( name == "compression" )
+    {
+
+      compression = reader.bytes[ reader.position ];
+
+    }
+    else if ( name == "dataWindow" )
+    {
+
+      xMin = static_cast< int >( reader.readU32( ) );
+      yMin = static_cast< int >( reader.readU32( ) );
+      xMax = static_cast< int >( reader.readU32( ) );
+      yMax = static_cast< int >( reader.readU32( ) );
+
+    }
+
+    reader.position = end;
+
+  }
+
+  if ( compression != 0 )
+  {
+
+    throw std::runtime_error( "Only uncompressed OpenEXR files are supported, re-save with no compression: " + filename );
+
+  }
+
+  if ( xMax < xMin || yMax < yMin || channels.empty( ) )
+  {
+
+    throw std::runtime_error( "OpenEXR file has no pixels: " + filename );
+
+  }
+
+  Image image;
+  image.width  = static_cast< unsigned >( xMax - xMin + 1 );
+  image.height = static_cast< unsigned >( yMax - yMin + 1 );
+  image.rgba.assign( static_cast< std::size_t >( image.width ) * image.height * 4, 0.0f );
+
+  bool hasAlpha = false;
+
+  for ( const Channel &channel : channels )
+  {
+    hasAlpha |= channel.target == 3;
+  }
+
+  // one scanline per chunk without compression
+  std::vector< std::uint64_t > offsets( image.height );
+
+  for ( std::uint64_t &offset : offsets )
+  {
+    offset = reader.readU64( );
+  }
+
+  for ( std::uint64_t offset : offsets )
+  {
+
+    reader.position = static_cast< std::size_t >( offset );
+
+    int y = static_cast< int >( reader.readU32( ) );
+    reader.readU32( ); // data size
+
+    if ( y < yMin || y > yMax )
+    {
+
+      throw std::runtime_error( "OpenEXR scanline out of range in " + filename );
+
+    }
+
+    // files are top-down
+    float *pRow = image.rgba.data( ) + static_cast< std::size_t >( yMax - y ) * image.width * 4;
+
+    for ( const Channel &channel : channels )
+    {
+
+      for ( unsigned x = 0; x < image.width; ++x )
+      {
+
+        float value = channel.type == 1 ? halfToFloat( reader.readU16( ) )
+                      : channel.type == 2 ? reader.readFloat( )
+                      : static_cast< float >( reader.readU32( ) );
+
+        if ( channel.target == 4 )
+        {
+          pRow[ x * 4 + 0 ] = pRow[ x * 4 + 1 ] = pRow[ x * 4 + 2 ] = value;
+        }
+        else if ( channel.target >= 0 )
+        {
+          pRow[ x * 4 + channel.target ] = value;
+        }
+
+      }
+
+    }
+
+  }
+
+  if ( !hasAlpha )
+  {
+
+    for ( std::size_t p = 3; p < image.rgba.size( ); p += 4 )
+    {
+      image.rgba[ p ] = 1.0f;
+    }
+
+  }
+
+  return image;
+
+}
+
+
+} // namespace
+
+
+///////////////////////////////////////////////////////////////
+/// \brief writePPM
+///////////////////////////////////////////////////////////////
+void
+writePPM(
+         const std::string          &filename,
+         unsigned                    width,
+         unsigned                    height,
+         const std::vector< float > &rgba
+         )
+{
+
+  checkImage( width, height, rgba );
+
+  LIGHT_PROFILE_SCOPE( OUTPUT );
+
+  std::vector< unsigned char > pix( static_cast< std::size_t >( width ) * height * 3 );
+
+  const SimdKernels &kernels = getSimdKernels( );
+
+  for ( unsigned row = 0; row < height; ++row )
+  {
+
+    // flip so the top of the image is written first
+    const float   *pSrc = rgba.data( ) + static_cast< std::size_t >( height - 1 - row ) * width * 4;
+    unsigned char *pDst = pix.data( ) + static_cast< std::size_t >( row ) * width * 3;
+
+    kernels.rgbaToRgb8( pSrc, width, pDst );
+
+  }
+
+  std::ofstream file( filename, std::ios::out | std::ios::binary );
+
+  if ( !file.is_open( ) )
+  {
+
+    throw std::runtime_error( "Could not open file for writePPM: " + filename );
+
+  }
+
+  file << "P6\n" << width << " " << height << "\n255\n";
+  file.write( reinterpret_cast< const char* >( pix.data( ) ), static_cast< std::streamsize >( pix.size( ) ) );
+
+} // writePPM
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief writePFM
+///////////////////////////////////////////////////////////////
+void
+writePFM(
+         const std::string          &filename,
+         unsigned                    width,
+         unsigned                    height,
+         const std::vector< float > &rgba
+         )
+{
+
+  checkImage( width, height, rgba );
+
+  LIGHT_PROFILE_SCOPE( OUTPUT );
+
+  std::string header = "PF\n" + std::to_string( width ) + " " + std::to_string( height ) + "\n-1.0\n";
+
+  std::vector< unsigned char > bytes( header.begin( ), header.end( ) );
+  bytes.reserve( bytes.size( ) + static_cast< std::size_t >( width ) * height * 12 );
+
+  // PFM rows are bottom-up too
+  for ( std::size_t p = 0; p < rgba.size( ); p += 4 )
+  {
+
+    appendFloat( &bytes, rgba[ p + 0 ] );
+    appendFloat( &bytes, rgba[ p + 1 ] );
+    appendFloat( &bytes, rgba[ p + 2 ] );
+
+  }
+
+  writeBytes( filename, bytes );
+
+} // writePFM
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief writeEXR
+///////////////////////////////////////////////////////////////
+void
+writeEXR(
+         const std::string          &filename,
+         unsigned                    width,
+         unsigned                    height,
+         const std::vector< float > &rgba
+         )
+{
+
+  checkImage( width, height, rgba );
+
+  LIGHT_PROFILE_SCOPE( OUTPUT );
+
+  // channels are stored in name order
+  const char  *names[]  = { "A", "B", "G", "R" };
+  const int    source[] = { 3, 2, 1, 0 };
+
+  std::vector< unsigned char > bytes;
+  appendU32( &bytes, 20000630u ); // magic number
+  appendU32( &bytes, 2u );        // version 2, single part scanline
+
+  std::vector< unsigned char > value;
+
+  for ( const char *pName : names )
+  {
+
+    appendString( &value, pName );
+    appendU32( &value, 2u ); // float
+    appendU32( &value, 0u ); // pLinear and reserved
+    appendU32( &value, 1u ); // x sampling
+    appendU32( &value, 1u ); // y sampling
+
+  }
+
+  value.push_back( 0 );
+  appendAttribute( &bytes, "channels", "chlist", value );
+
+  appendAttribute( &bytes, "compression", "compression", { 0 } );
+
+  value.clear( );
+  appendU32( &value, 0u );
+  appendU32( &value, 0u );
+  appendU32( &value, width - 1 );
+  appendU32( &value, height - 1 );
+  appendAttribute( &bytes, "dataWindow",    "box2i", value );
+  appendAttribute( &bytes, "displayWindow", "box2i", value );
+
+  appendAttribute( &bytes, "lineOrder", "lineOrder", { 0 } );
+
+  value.clear( );
+  appendFloat( &value, 1.0f );
+  appendAttribute( &bytes, "pixelAspectRatio",  "float", value );
+  appendAttribute( &bytes, "screenWindowWidth", "float", value );
+
+  value.clear( );
+  appendFloat( &value, 0.0f );
+  appendFloat( &value, 0.0f );
+  appendAttribute( &bytes, "screenWindowCenter", "v2f", value );
+
+  bytes.push_back( 0 ); // end of header
+
+  std::uint32_t lineBytes = width * 4 * sizeof( float );
+  std::size_t   offset    = bytes.size( ) + static_cast< std::size_t >( height ) * sizeof( std::uint64_t );
+
+  for ( unsigned y = 0; y < height; ++y, offset += 8 + lineBytes )
+  {
+
+    appendU32( &bytes, static_cast< std::uint32_t >( offset ) );
+    appendU32( &bytes, static_cast< std::uint32_t >( static_cast< std::uint64_t >( offset ) >> 32 ) );
+
+  }
+
+  for ( unsigned y = 0; y < height; ++y )
+  {
+
+    // EXR scanlines are top-down
+    const float *pRow = rgba.data( ) + static_cast< std::size_t >( height - 1 - y ) * width * 4;
+
+    appendU32( &bytes, y );
+    appendU32( &bytes, lineBytes );
+
+    for ( int channel : source )
+    {
+
+      for ( unsigned x = 0; x < width; ++x )
+      {
+        appendFloat( &bytes, pRow[ x * 4 + channel ] );
+      }
+
+    }
+
+  }
+
+  writeBytes( filename, bytes );
+
+} // writeEXR
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief readImage
+///////////////////////////////////////////////////////////////
+Image
+readImage( const std::string &filename )
+{
+
+  std::string extension = getExtension( filename );
+
+  if ( extension != "ppm" && extension != "pgm" && extension != "pfm" && extension != "exr" )
+  {
+
+    throw std::runtime_error( "Images must be .ppm, .pgm, .pfm or .exr: " + filename );
+
+  }
+
+  std::vector< unsigned char > bytes = readBytes( filename );
+
+  if ( extension == "pfm" )
+  {
+    return readPFM( filename, bytes );
+  }
+
+  if ( extension == "exr" )
+  {
+    return readEXR( filename, bytes );
+  }
+
+  return readPPM( filename, bytes );
+
+} // readImage
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief FrameWriter::FrameWriter
+///////////////////////////////////////////////////////////////
+FrameWriter::FrameWriter( std::size_t maxQueued )
+  : maxQueued_( std::max< std::size_t >( maxQueued, 1 ) )
+  , writing_  ( false )
+  , stopping_ ( false )
+  , thread_   ( &FrameWriter::_run, this )
+{}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief FrameWriter::~FrameWriter
+///
+///        Writes every queued frame before returning
+///////////////////////////////////////////////////////////////
+FrameWriter::~FrameWriter( )
+{
+
+  {
+    std::lock_guard< std::mutex > lock( mutex_ );
+    stopping_ = true;
+  }
+
+  condition_.notify_all( );
+  thread_.join( );
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief FrameWriter::submit
+///////////////////////////////////////////////////////////////
+void
+FrameWriter::submit(
+                    const std::string    &filename,
+                    unsigned              width,
+                    unsigned              height,
+                    std::vector< float >  rgba
+                    )
+{
+
+  TrackedMemory memory( MemoryCategory::SCRATCH, rgba.size( ) * sizeof( float ) );
+
+  {
+    std::unique_lock< std::mutex > lock( mutex_ );
+    condition_.wait( lock, [ this ] { return queue_.size( ) < maxQueued_; } );
+
+    queue_.push_back( Frame { filename, width, height, std::move( rgba ), std::move( memory ) } );
+  }
+
+  condition_.notify_all( );
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief FrameWriter::wait
+///////////////////////////////////////////////////////////////
+void
+FrameWriter::wait( )
+{
+
+  std::unique_lock< std::mutex > lock( mutex_ );
+  condition_.wait( lock, [ this ] { return queue_.empty( ) && !writing_; } );
+
+}
+
+
+
+std::vector< std::string >
+FrameWriter::getErrors( )
+{
+
+  std::lock_guard< std::mutex > lock( mutex_ );
+  return errors_;
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief FrameWriter::_run
+///////////////////////////////////////////////////////////////
+void
+FrameWriter::_run( )
+{
+
+  std::unique_lock< std::mutex > lock( mutex_ );
+
+  while ( true )
+  {
+
+    condition_.wait( lock, [ this ] { return !queue_.empty( ) || stopping_; } );
+
+    if ( queue_.empty( ) )
+    {
+      return; // stopping with nothing left to write
+    }
+
+    Frame frame = std::move( queue_.front( ) );
+    queue_.pop_front( );
+    writing_ = true;
+
+    // a slot opened up for a blocked submit
+    condition_.notify_all( );
+
+    lock.unlock( );
+
+    std::string error;
+
+    try
+    {
+
+      writePPM( frame.filename, frame.width, frame.height, frame.rgba );
+
+    }
+    catch ( const std::exception &e )
+    {
+
+      error = e.what( );
+
+    }
+
+    lock.lock( );
+
+    writing_ = false;
+
+    if ( !error.empty( ) )
+    {
+      errors_.push_back( error );
+    }
+
+    condition_.notify_all( );
+
+  }
+
+} // FrameWriter::_run
+
+
+
+} // namespace light
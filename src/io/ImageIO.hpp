@@ -0,0 +1,177 @@
+#ifndef ImageIO_hpp
+#define ImageIO_hpp
+
+
+#include <deque>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include "MemoryAccounting.hpp"
+
+
+namespace light
+{
+
+
+/////////////////////////////////////////////
+/// \brief The Image struct
+///
+///        Float RGBA pixels with rows stored bottom-up like
+///        OptiX output buffers and writePPM's input
+/////////////////////////////////////////////
+struct Image
+{
+  unsigned             width  = 0;
+  unsigned             height = 0;
+  std::vector< float > rgba;   // width * height * 4
+};
+
+
+///////////////////////////////////////////////////////////////
+/// \brief writePPM
+///
+///        Writes float RGBA pixels as an 8 bit binary PPM.
+///        Rows are stored bottom-up like OptiX output buffers.
+/// \param filename
+/// \param width
+/// \param height
+/// \param rgba width * height * 4 floats in [0, 1]
+///////////////////////////////////////////////////////////////
+void writePPM (
+               const std::string          &filename,
+               unsigned                    width,
+               unsigned                    height,
+               const std::vector< float > &rgba
+               );
+
+
+///////////////////////////////////////////////////////////////
+/// \brief writePFM
+///
+///        Writes float RGB pixels as a little endian PFM, keeping
+///        full precision for references and convergence frames
+/// \param rgba width * height * 4 floats, any range
+///////////////////////////////////////////////////////////////
+void writePFM (
+               const std::string          &filename,
+               unsigned                    width,
+               unsigned                    height,
+               const std::vector< float > &rgba
+               );
+
+
+///////////////////////////////////////////////////////////////
+/// \brief writeEXR
+///
+///        Writes float RGBA pixels as an uncompressed scanline
+///        OpenEXR file with 32 bit float channels
+/// \param rgba width * height * 4 floats, any range
+///////////////////////////////////////////////////////////////
+void writeEXR (
+               const std::string          &filename,
+               unsigned                    width,
+               unsigned                    height,
+               const std::vector< float > &rgba
+               );
+
+
+///////////////////////////////////////////////////////////////
+/// \brief readImage
+///
+///        Loads a PPM (P3 or P6, 8 or 16 bit), PFM (color or
+///        grayscale, either endianness) or uncompressed scanline
+///        OpenEXR (half, float or uint channels) picked by the
+///        file extension. PPM values are scaled to [0, 1] the
+///        way writePPM stored them; alpha is 1 unless the EXR
+///        has an A channel.
+/// \return pixels, throws if the file can't be read
+///////////////////////////////////////////////////////////////
+Image readImage ( const std::string &filename );
+
+
+
+
+/////////////////////////////////////////////
+/// \brief The FrameWriter class
+///
+///        Writes PPM frames on a background thread so batch
+///        renders can start the next view while the last one
+///        is encoded. Unlike checkpoints no frame is ever
+///        dropped; submit blocks once 'maxQueued' frames are
+///        waiting so memory stays bounded.
+/////////////////////////////////////////////
+class FrameWriter
+{
+
+public:
+
+  explicit
+  FrameWriter( std::size_t maxQueued = 4 );
+
+  ~FrameWriter( );
+
+  FrameWriter( const FrameWriter& )            = delete;
+  FrameWriter &operator=( const FrameWriter& ) = delete;
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief submit
+  /// \param rgba pixels as writePPM expects, taken by value
+  ///////////////////////////////////////////////////////////////
+  void submit (
+               const std::string    &filename,
+               unsigned              width,
+               unsigned              height,
+               std::vector< float >  rgba
+               );
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief wait
+  ///
+  ///        Blocks until every submitted frame is on disk
+  ///////////////////////////////////////////////////////////////
+  void wait ( );
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief getErrors
+  /// \return messages from every failed write so far
+  ///////////////////////////////////////////////////////////////
+  std::vector< std::string > getErrors ( );
+
+
+private:
+
+  struct Frame
+  {
+    std::string          filename;
+    unsigned             width;
+    unsigned             height;
+    std::vector< float > rgba;
+    TrackedMemory        memory; // rgba while queued or being written
+  };
+
+  void _run ( );
+
+  std::mutex              mutex_;
+  std::condition_variable condition_;
+
+  std::deque< Frame > queue_;
+  std::size_t         maxQueued_;
+
+  bool writing_;
+  bool stopping_;
+  std::vector< std::string > errors_;
+
+  std::thread thread_;
+
+};
+
+
+} // namespace light
+
+
+#endif // ImageIO_hpp
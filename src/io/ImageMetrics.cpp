@@ -0,0 +1,873 @@
+#include "ImageMetrics.hpp"
+#include <cmath>
+#include <thread>
+#include <algorithm>
+#include <stdexcept>
+#include "SimdKernels.hpp"
+
+
+namespace light
+{
+
+
+namespace
+{
+
+
+constexpr float pi = 3.14159265358979323846f;
+
+constexpr float relMseEpsilon = 0.01f;
+
+// SSIM stabilizers for a dynamic range of 1
+constexpr float ssimC1    = 0.01f * 0.01f;
+constexpr float ssimC2    = 0.03f * 0.03f;
+constexpr float ssimSigma = 1.5f;
+constexpr int   ssimRadius = 5;
+
+// FLIP constants from the paper
+constexpr float flipQc = 0.7f;  // color difference exponent
+constexpr float flipPc = 0.4f;  // color error mapping knee
+constexpr float flipPt = 0.95f; // error at the knee
+constexpr float flipGw = 0.082f; // feature detector width in degrees
+
+// D65 reference white
+constexpr float whiteX = 0.950428545f;
+constexpr float whiteY = 1.0f;
+constexpr float whiteZ = 1.088900371f;
+
+
+struct Color
+{
+  float x, y, z;
+};
+
+
+///
+/// \brief forEachRowBand
+///
+///        Calls function( begin, end ) on contiguous row ranges,
+///        one per thread
+///
+template< typename Function >
+void
+forEachRowBand(
+               unsigned rows,
+               unsigned numThreads,
+               Function function
+               )
+{
+
+  unsigned bands = std::min( numThreads, rows );
+
+  if ( bands <= 1 )
+  {
+
+    function( 0u, rows );
+    return;
+
+  }
+
+  std::vector< std::thread > threads;
+
+  for ( unsigned band = 1; band < bands; ++band )
+  {
+    threads.emplace_back( function, rows * band / bands, rows * ( band + 1 ) / bands );
+  }
+
+  function( 0u, rows / bands );
+
+  for ( std::thread &thread : threads )
+  {
+    thread.join( );
+  }
+
+}
+
+
+///
+/// \brief forEachPixelBand
+///
+///        forEachRowBand over the pixel index ranges of whole rows
+///
+template< typename Function >
+void
+forEachPixelBand(
+                 unsigned width,
+                 unsigned height,
+                 unsigned numThreads,
+                 Function function
+                 )
+{
+
+  forEachRowBand(
+                 height,
+                 numThreads,
+                 [ & ]( unsigned begin, unsigned end )
+                 {
+                   function( static_cast< std::size_t >( begin ) * width, static_cast< std::size_t >( end ) * width );
+                 }
+                 );
+
+}
+
+
+double
+sumRows( const std::vector< double > &rowSums )
+{
+
+  double sum = 0.0;
+
+  // in order, so the total doesn't depend on the thread count
+  for ( double rowSum : rowSums )
+  {
+    sum += rowSum;
+  }
+
+  return sum;
+
+}
+
+
+///
+/// \brief filterSeparable
+///
+///        Convolves a plane with kernelX along rows then kernelY
+///        along columns, clamping at the borders. Both passes
+///        loop over contiguous pixels in the innermost loop.
+///
+void
+filterSeparable(
+                const std::vector< float > &source,
+                std::vector< float >       *pResult,
+                unsigned                    width,
+                unsigned                    height,
+                const std::vector< float > &kernelX,
+                const std::vector< float > &kernelY,
+                unsigned                    numThreads
+                )
+{
+
+  int radiusX = static_cast< int >( kernelX.size( ) / 2 );
+  int radiusY = static_cast< int >( kernelY.size( ) / 2 );
+
+  std::vector< float > rows( source.size( ) );
+  pResult->resize( source.size( ) );
+
+  forEachRowBand(
+                 height,
+                 numThreads,
+                 [ & ]( unsigned begin, unsigned end )
+                 {
+
+                   std::vector< float > padded( width + 2 * radiusX );
+
+                   for ( unsigned y = begin; y < end; ++y )
+                   {
+
+                     const float *pSource = source.data( ) + static_cast< std::size_t >( y ) * width;
+                     float       *pRow    = rows.data( ) + static_cast< std::size_t >( y ) * width;
+
+                     for ( int x = 0; x < static_cast< int >( padded.size( ) ); ++x )
+                     {
+                       padded[ x ] = pSource[ std::min( std::max( x - radiusX, 0 ), static_cast< int >( width ) - 1 ) ];
+                     }
+
+                     std::fill( pRow, pRow + width, 0.0f );
+
+                     for ( std::size_t k = 0; k < kernelX.size( ); ++k )
+                     {
+
+                       const float  weight  = kernelX[ k ];
+                       const float *pPadded = padded.data( ) + k;
+
+                       for ( unsigned x = 0; x < width; ++x )
+                       {
+                         pRow[ x ] += weight * pPadded[ x ];
+                       }
+
+                     }
+
+                   }
+
+                 }
+                 );
+
+  forEachRowBand(
+                 height,
+                 numThreads,
+                 [ & ]( unsigned begin, unsigned end )
+                 {
+
+                   for ( unsigned y = begin; y < end; ++y )
+                   {
+
+                     float *pResultRow = pResult->data( ) + static_cast< std::size_t >( y ) * width;
+
+                     std::fill( pResultRow, pResultRow + width, 0.0f );
+
+                     for ( std::size_t k = 0; k < kernelY.size( ); ++k )
+                     {
+
+                       int row = std::min(
+                                          std::max( static_cast< int >( y + k ) - radiusY, 0 ),
+                                          static_cast< int >( height ) - 1
+                                          );
+
+                       const float  weight = kernelY[ k ];
+                       const float *pRow   = rows.data( ) + static_cast< std::size_t >( row ) * width;
+
+                       for ( unsigned x = 0; x < width; ++x )
+                       {
+                         pResultRow[ x ] += weight * pRow[ x ];
+                       }
+
+                     }
+
+                   }
+
+                 }
+                 );
+
+}
+
+
+std::vector< float >
+gaussianKernel(
+               float sigma,
+               int   radius
+               )
+{
+
+  std::vector< float > kernel;
+  float                sum = 0.0f;
+
+  for ( int x = -radius; x <= radius; ++x )
+  {
+
+    kernel.push_back( std::exp( -( x * x ) / ( 2.0f * sigma * sigma ) ) );
+    sum += kernel.back( );
+
+  }
+
+  for ( float &weight : kernel )
+  {
+    weight /= sum;
+  }
+
+  return kernel;
+
+}
+
+
+///
+/// \brief normalizeLobes
+///
+///        Scales positive weights to sum to 1 and negative
+///        weights to sum to -1, as FLIP's feature detectors do
+///
+void
+normalizeLobes( std::vector< float > *pKernel )
+{
+
+  float positive = 0.0f;
+  float negative = 0.0f;
+
+  for ( float weight : *pKernel )
+  {
+    ( weight > 0.0f ? positive : negative ) += weight;
+  }
+
+  for ( float &weight : *pKernel )
+  {
+    weight /= weight > 0.0f ? positive : -negative;
+  }
+
+}
+
+
+float
+luminance( const float *pRgba )
+{
+
+  float value = 0.2126f * pRgba[ 0 ] + 0.7152f * pRgba[ 1 ] + 0.0722f * pRgba[ 2 ];
+  return std::min( std::max( value, 0.0f ), 1.0f );
+
+}
+
+
+float
+srgbToLinear( float value )
+{
+
+  value = std::min( std::max( value, 0.0f ), 1.0f );
+
+  return value <= 0.04045f ? value / 12.92f : std::pow( ( value + 0.055f ) / 1.055f, 2.4f );
+
+}
+
+
+Color
+linearRgbToXyz( Color c )
+{
+
+  return Color {
+    0.4124564f * c.x + 0.3575761f * c.y + 0.1804375f * c.z,
+    0.2126729f * c.x + 0.7151522f * c.y + 0.0721750f * c.z,
+    0.0193339f * c.x + 0.1191920f * c.y + 0.9503041f * c.z
+  };
+
+}
+
+
+Color
+xyzToLinearRgb( Color c )
+{
+
+  return Color {
+     3.2404542f * c.x - 1.5371385f * c.y - 0.4985314f * c.z,
+    -0.9692660f * c.x + 1.8760108f * c.y + 0.0415560f * c.z,
+     0.0556434f * c.x - 0.2040259f * c.y + 1.0572252f * c.z
+  };
+
+}
+
+
+Color
+xyzToYCxCz( Color c )
+{
+
+  float y = c.y / whiteY;
+
+  return Color { 116.0f * y - 16.0f, 500.0f * ( c.x / whiteX - y ), 200.0f * ( y - c.z / whiteZ ) };
+
+}
+
+
+Color
+yCxCzToXyz( Color c )
+{
+
+  float y = ( c.x + 16.0f ) / 116.0f;
+
+  return Color { whiteX * ( c.y / 500.0f + y ), whiteY * y, whiteZ * ( y - c.z / 200.0f ) };
+
+}
+
+
+float
+labCurve( float t )
+{
+
+  const float delta = 6.0f / 29.0f;
+
+  return t > delta * delta * delta ? std::cbrt( t ) : t / ( 3.0f * delta * delta ) + 4.0f / 29.0f;
+
+}
+
+
+///
+/// \brief xyzToHuntLab
+/// \return CIELAB with a and b scaled by 0.01 L (Hunt effect)
+///
+Color
+xyzToHuntLab( Color c )
+{
+
+  float fx = labCurve( c.x / whiteX );
+  float fy = labCurve( c.y / whiteY );
+  float fz = labCurve( c.z / whiteZ );
+
+  float L = 116.0f * fy - 16.0f;
+
+  return Color { L, 0.01f * L * 500.0f * ( fx - fy ), 0.01f * L * 200.0f * ( fy - fz ) };
+
+}
+
+
+float
+hyab(
+     Color a,
+     Color b
+     )
+{
+
+  float da = a.y - b.y;
+  float db = a.z - b.z;
+
+  return std::abs( a.x - b.x ) + std::sqrt( da * da + db * db );
+
+}
+
+
+} // namespace
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief ImageComparer::ImageComparer
+///////////////////////////////////////////////////////////////
+ImageComparer::ImageComparer(
+                             const Image               &reference,
+                             const ImageCompareOptions &options
+                             )
+  : width_     ( reference.width )
+  , height_    ( reference.height )
+  , numThreads_( options.numThreads > 0 ? options.numThreads : std::max( 1u, std::thread::hardware_concurrency( ) ) )
+  , options_   ( options )
+  , reference_ ( reference.rgba )
+{
+
+  if ( width_ == 0 || height_ == 0 || reference_.size( ) != static_cast< std::size_t >( width_ ) * height_ * 4 )
+  {
+
+    throw std::runtime_error( "Reference image is empty or ill-formed" );
+
+  }
+
+  std::size_t pixels = static_cast< std::size_t >( width_ ) * height_;
+
+  if ( options_.ssim )
+  {
+
+    std::vector< float > kernel = gaussianKernel( ssimSigma, ssimRadius );
+
+    referenceLuminance_.resize( pixels );
+
+    Plane squares( pixels );
+
+    forEachPixelBand(
+                     width_,
+                     height_,
+                     numThreads_,
+                     [ & ]( std::size_t begin, std::size_t end )
+                     {
+
+                       for ( std::size_t p = begin; p < end; ++p )
+                       {
+
+                         referenceLuminance_[ p ] = luminance( reference_.data( ) + p * 4 );
+                         squares[ p ]             = referenceLuminance_[ p ] * referenceLuminance_[ p ];
+
+                       }
+
+                     }
+                     );
+
+    filterSeparable( referenceLuminance_, &referenceMean_,     width_, height_, kernel, kernel, numThreads_ );
+    filterSeparable( squares,             &referenceVariance_, width_, height_, kernel, kernel, numThreads_ );
+
+    for ( std::size_t p = 0; p < pixels; ++p )
+    {
+      referenceVariance_[ p ] -= referenceMean_[ p ] * referenceMean_[ p ];
+    }
+
+  }
+
+  if ( options_.flip )
+  {
+
+    float ppd = std::max( options_.pixelsPerDegree, 1.0f );
+
+    //
+    // contrast sensitivity filters, sums of Gaussians in degrees:
+    // achromatic, red-green and two for blue-yellow
+    //
+    const float a[] = { 1.0f,    1.0f,    34.1f, 13.5f };
+    const float b[] = { 0.0047f, 0.0053f, 0.04f, 0.025f };
+
+    int radius = static_cast< int >( std::ceil( 3.0f * std::sqrt( 0.04f / ( 2.0f * pi * pi ) ) * ppd ) );
+
+    float sums[ 4 ];
+
+    for ( int i = 0; i < 4; ++i )
+    {
+
+      csfKernels_[ i ].clear( );
+      sums[ i ] = 0.0f;
+
+      for ( int x = -radius; x <= radius; ++x )
+      {
+
+        float degrees = x / ppd;
+
+        csfKernels_[ i ].push_back( std::exp( -pi * pi * degrees * degrees / b[ i ] ) );
+        sums[ i ] += csfKernels_[ i ].back( );
+
+      }
+
+    }
+
+    // each 2D term is a (pi / b) g(x) g(y); a channel's terms sum to 1
+    float terms[ 4 ];
+
+    for ( int i = 0; i < 4; ++i )
+    {
+      terms[ i ] = a[ i ] * pi / b[ i ] * sums[ i ] * sums[ i ];
+    }
+
+    csfWeights_[ 0 ] = a[ 0 ] * pi / b[ 0 ] / terms[ 0 ];
+    csfWeights_[ 1 ] = a[ 1 ] * pi / b[ 1 ] / terms[ 1 ];
+    csfWeights_[ 2 ] = a[ 2 ] * pi / b[ 2 ] / ( terms[ 2 ] + terms[ 3 ] );
+    csfWeights_[ 3 ] = a[ 3 ] * pi / b[ 3 ] / ( terms[ 2 ] + terms[ 3 ] );
+
+    //
+    // edge and point detectors, first and second Gaussian
+    // derivatives along one axis times a Gaussian along the other
+    //
+    float sigma         = 0.5f * flipGw * ppd;
+    int   featureRadius = static_cast< int >( std::ceil( 3.0f * sigma ) );
+
+    featureGaussian_ = gaussianKernel( sigma, featureRadius );
+    edgeKernel_.clear( );
+    pointKernel_.clear( );
+
+    for ( int x = -featureRadius; x <= featureRadius; ++x )
+    {
+
+      float g = std::exp( -( x * x ) / ( 2.0f * sigma * sigma ) );
+
+      edgeKernel_.push_back( -x * g );
+      pointKernel_.push_back( ( x * x / ( sigma * sigma ) - 1.0f ) * g );
+
+    }
+
+    normalizeLobes( &edgeKernel_ );
+    normalizeLobes( &pointKernel_ );
+
+    _computeFlipPlanes( reference_, &referenceFlip_ );
+
+  }
+
+} // ImageComparer::ImageComparer
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief ImageComparer::compare
+///////////////////////////////////////////////////////////////
+ImageMetrics
+ImageComparer::compare( const Image &test ) const
+{
+
+  if ( test.width != width_ || test.height != height_ || test.rgba.size( ) != reference_.size( ) )
+  {
+
+    throw std::runtime_error(
+                             "Image is " + std::to_string( test.width ) + "x" + std::to_string( test.height )
+                             + " but the reference is " + std::to_string( width_ ) + "x" + std::to_string( height_ )
+                             );
+
+  }
+
+  ImageMetrics metrics;
+
+  std::size_t pixels = static_cast< std::size_t >( width_ ) * height_;
+  double      count  = static_cast< double >( pixels );
+
+  //
+  // per pixel squared errors
+  //
+  std::vector< double > squaredRows( height_ );
+  std::vector< double > relativeRows( height_ );
+
+  const SimdKernels &kernels = getSimdKernels( );
+
+  forEachRowBand(
+                 height_,
+                 numThreads_,
+                 [ & ]( unsigned begin, unsigned end )
+                 {
+
+                   for ( unsigned y = begin; y < end; ++y )
+                   {
+
+                     const float *pTest      = test.rgba.data( ) + static_cast< std::size_t >( y ) * width_ * 4;
+                     const float *pReference = reference_.data( ) + static_cast< std::size_t >( y ) * width_ * 4;
+
+                     float squared  = 0.0f;
+                     float relative = 0.0f;
+
+                     kernels.squaredErrors( pTest, pReference, width_, relMseEpsilon, &squared, &relative );
+
+                     squaredRows[ y ]  = squared;
+                     relativeRows[ y ] = relative;
+
+                   }
+
+                 }
+                 );
+
+  metrics.mse    = sumRows( squaredRows ) / ( count * 3.0 );
+  metrics.relMse = sumRows( relativeRows ) / ( count * 3.0 );
+
+  //
+  // SSIM from Gaussian weighted local statistics
+  //
+  if ( options_.ssim )
+  {
+
+    std::vector< float > kernel = gaussianKernel( ssimSigma, ssimRadius );
+
+    Plane lum( pixels ), squares( pixels ), products( pixels );
+
+    forEachPixelBand(
+                     width_,
+                     height_,
+                     numThreads_,
+                     [ & ]( std::size_t begin, std::size_t end )
+                     {
+
+                       for ( std::size_t p = begin; p < end; ++p )
+                       {
+
+                         lum[ p ]      = luminance( test.rgba.data( ) + p * 4 );
+                         squares[ p ]  = lum[ p ] * lum[ p ];
+                         products[ p ] = lum[ p ] * referenceLuminance_[ p ];
+
+                       }
+
+                     }
+                     );
+
+    Plane mean, variance, covariance;
+    filterSeparable( lum,      &mean,       width_, height_, kernel, kernel, numThreads_ );
+    filterSeparable( squares,  &variance,   width_, height_, kernel, kernel, numThreads_ );
+    filterSeparable( products, &covariance, width_, height_, kernel, kernel, numThreads_ );
+
+    std::vector< double > ssimRows( height_ );
+
+    forEachRowBand(
+                   height_,
+                   numThreads_,
+                   [ & ]( unsigned begin, unsigned end )
+                   {
+
+                     for ( unsigned y = begin; y < end; ++y )
+                     {
+
+                       float sum = 0.0f;
+
+                       for ( std::size_t p = static_cast< std::size_t >( y ) * width_; p < ( y + 1u ) * std::size_t( width_ ); ++p )
+                       {
+
+                         float mx  = mean[ p ];
+                         float my  = referenceMean_[ p ];
+                         float vx  = variance[ p ] - mx * mx;
+                         float vy  = referenceVariance_[ p ];
+                         float cxy = covariance[ p ] - mx * my;
+
+                         sum += ( ( 2.0f * mx * my + ssimC1 ) * ( 2.0f * cxy + ssimC2 ) )
+                                / ( ( mx * mx + my * my + ssimC1 ) * ( vx + vy + ssimC2 ) );
+
+                       }
+
+                       ssimRows[ y ] = sum;
+
+                     }
+
+                   }
+                   );
+
+    metrics.ssim = sumRows( ssimRows ) / count;
+
+  }
+
+  //
+  // FLIP: filtered color difference raised by feature differences
+  //
+  if ( options_.flip )
+  {
+
+    FlipPlanes planes;
+    _computeFlipPlanes( test.rgba, &planes );
+
+    // largest color difference, between pure green and blue
+    float maxColor = std::pow(
+                              hyab(
+                                   xyzToHuntLab( linearRgbToXyz( Color { 0.0f, 1.0f, 0.0f } ) ),
+                                   xyzToHuntLab( linearRgbToXyz( Color { 0.0f, 0.0f, 1.0f } ) )
+                                   ),
+                              flipQc
+                              );
+
+    float knee = flipPc * maxColor;
+
+    std::vector< double > flipRows( height_ );
+
+    forEachRowBand(
+                   height_,
+                   numThreads_,
+                   [ & ]( unsigned begin, unsigned end )
+                   {
+
+                     for ( unsigned y = begin; y < end; ++y )
+                     {
+
+                       float sum = 0.0f;
+
+                       for ( std::size_t p = static_cast< std::size_t >( y ) * width_; p < ( y + 1u ) * std::size_t( width_ ); ++p )
+                       {
+
+                         float color = std::pow(
+                                                hyab(
+                                                     Color { planes.L[ p ], planes.a[ p ], planes.b[ p ] },
+                                                     Color { referenceFlip_.L[ p ], referenceFlip_.a[ p ], referenceFlip_.b[ p ] }
+                                                     ),
+                                                flipQc
+                                                );
+
+                         color = color < knee
+                                 ? color * flipPt / knee
+                                 : flipPt + ( color - knee ) / ( maxColor - knee ) * ( 1.0f - flipPt );
+
+                         float feature = std::max(
+                                                  std::abs( planes.edges[ p ] - referenceFlip_.edges[ p ] ),
+                                                  std::abs( planes.points[ p ] - referenceFlip_.points[ p ] )
+                                                  );
+
+                         // feature exponent of 1/2
+                         feature = std::sqrt( feature / std::sqrt( 2.0f ) );
+
+                         sum += std::pow( std::min( color, 1.0f ), 1.0f - std::min( feature, 1.0f ) );
+
+                       }
+
+                       flipRows[ y ] = sum;
+
+                     }
+
+                   }
+                   );
+
+    metrics.flip = sumRows( flipRows ) / count;
+
+  }
+
+  return metrics;
+
+} // ImageComparer::compare
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief ImageComparer::_computeFlipPlanes
+///////////////////////////////////////////////////////////////
+void
+ImageComparer::_computeFlipPlanes(
+                                  const std::vector< float > &rgba,
+                                  FlipPlanes                 *pPlanes
+                                  ) const
+{
+
+  std::size_t pixels = static_cast< std::size_t >( width_ ) * height_;
+
+  // opponent channels and normalized luminance for the features
+  Plane Y( pixels ), Cx( pixels ), Cz( pixels ), luminance( pixels );
+
+  forEachPixelBand(
+                   width_,
+                   height_,
+                   numThreads_,
+                   [ & ]( std::size_t begin, std::size_t end )
+                   {
+
+                     for ( std::size_t p = begin; p < end; ++p )
+                     {
+
+                       const float *pPixel = rgba.data( ) + p * 4;
+
+                       Color linear = { srgbToLinear( pPixel[ 0 ] ), srgbToLinear( pPixel[ 1 ] ), srgbToLinear( pPixel[ 2 ] ) };
+                       Color ycc    = xyzToYCxCz( linearRgbToXyz( linear ) );
+
+                       Y[ p ]         = ycc.x;
+                       Cx[ p ]        = ycc.y;
+                       Cz[ p ]        = ycc.z;
+                       luminance[ p ] = ( ycc.x + 16.0f ) / 116.0f;
+
+                     }
+
+                   }
+                   );
+
+  Plane filteredY, filteredCx, filteredCz, filteredCz2;
+  filterSeparable( Y,  &filteredY,   width_, height_, csfKernels_[ 0 ], csfKernels_[ 0 ], numThreads_ );
+  filterSeparable( Cx, &filteredCx,  width_, height_, csfKernels_[ 1 ], csfKernels_[ 1 ], numThreads_ );
+  filterSeparable( Cz, &filteredCz,  width_, height_, csfKernels_[ 2 ], csfKernels_[ 2 ], numThreads_ );
+  filterSeparable( Cz, &filteredCz2, width_, height_, csfKernels_[ 3 ], csfKernels_[ 3 ], numThreads_ );
+
+  pPlanes->L.resize( pixels );
+  pPlanes->a.resize( pixels );
+  pPlanes->b.resize( pixels );
+
+  forEachPixelBand(
+                   width_,
+                   height_,
+                   numThreads_,
+                   [ & ]( std::size_t begin, std::size_t end )
+                   {
+
+                     for ( std::size_t p = begin; p < end; ++p )
+                     {
+
+                       Color ycc = {
+                         filteredY[ p ] * csfWeights_[ 0 ],
+                         filteredCx[ p ] * csfWeights_[ 1 ],
+                         filteredCz[ p ] * csfWeights_[ 2 ] + filteredCz2[ p ] * csfWeights_[ 3 ]
+                       };
+
+                       // back into the RGB gamut before measuring the difference
+                       Color rgb = xyzToLinearRgb( yCxCzToXyz( ycc ) );
+                       rgb.x = std::min( std::max( rgb.x, 0.0f ), 1.0f );
+                       rgb.y = std::min( std::max( rgb.y, 0.0f ), 1.0f );
+                       rgb.z = std::min( std::max( rgb.z, 0.0f ), 1.0f );
+
+                       Color lab = xyzToHuntLab( linearRgbToXyz( rgb ) );
+
+                       pPlanes->L[ p ] = lab.x;
+                       pPlanes->a[ p ] = lab.y;
+                       pPlanes->b[ p ] = lab.z;
+
+                     }
+
+                   }
+                   );
+
+  Plane edgeX, edgeY, pointX, pointY;
+  filterSeparable( luminance, &edgeX,  width_, height_, edgeKernel_,      featureGaussian_, numThreads_ );
+  filterSeparable( luminance, &edgeY,  width_, height_, featureGaussian_, edgeKernel_,      numThreads_ );
+  filterSeparable( luminance, &pointX, width_, height_, pointKernel_,     featureGaussian_, numThreads_ );
+  filterSeparable( luminance, &pointY, width_, height_, featureGaussian_, pointKernel_,     numThreads_ );
+
+  pPlanes->edges.resize( pixels );
+  pPlanes->points.resize( pixels );
+
+  for ( std::size_t p = 0; p < pixels; ++p )
+  {
+
+    pPlanes->edges[ p ]  = std::sqrt( edgeX[ p ] * edgeX[ p ] + edgeY[ p ] * edgeY[ p ] );
+    pPlanes->points[ p ] = std::sqrt( pointX[ p ] * pointX[ p ] + pointY[ p ] * pointY[ p ] );
+
+  }
+
+} // ImageComparer::_computeFlipPlanes
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief compareImages
+///////////////////////////////////////////////////////////////
+ImageMetrics
+compareImages(
+              const Image               &test,
+              const Image               &reference,
+              const ImageCompareOptions &options
+              )
+{
+
+  return ImageComparer( reference, options ).compare( test );
+
+}
+
+
+
+} // namespace light
@@ -0,0 +1,142 @@
+#ifndef ImageMetrics_hpp
+#define ImageMetrics_hpp
+
+
+#include <vector>
+#include "ImageIO.hpp"
+
+
+namespace light
+{
+
+
+/////////////////////////////////////////////
+/// \brief The ImageMetrics struct
+///
+///        Errors of a test image against a reference. Lower is
+///        better for everything but ssim, which is 1 for equal
+///        images.
+/////////////////////////////////////////////
+struct ImageMetrics
+{
+  double mse    = 0.0; // mean over pixels and RGB channels
+  double relMse = 0.0; // squared error over reference^2 + 0.01
+  double ssim   = 1.0; // mean SSIM of luminance in [0, 1]
+  double flip   = 0.0; // mean LDR FLIP error in [0, 1]
+};
+
+
+/////////////////////////////////////////////
+/// \brief The ImageCompareOptions struct
+/////////////////////////////////////////////
+struct ImageCompareOptions
+{
+  unsigned numThreads      = 0;     // 0 uses every hardware thread
+  bool     ssim            = true;  // the filtered metrics can be
+  bool     flip            = true;  // skipped when only MSE is needed
+  float    pixelsPerDegree = 67.0f; // FLIP viewing distance, 0.7 m from a 24" 4K display
+};
+
+
+/////////////////////////////////////////////
+/// \brief The ImageComparer class
+///
+///        Scores test images against one reference. Everything
+///        that only depends on the reference (its luminance
+///        statistics and filtered FLIP colors and features) is
+///        computed once, so sweeps over many frames only pay for
+///        the test side. Work is split into row bands across
+///        threads and inner loops run over contiguous planes so
+///        the compiler can vectorize them; the squared errors use
+///        the dispatched SIMD kernels. Per-row sums are added in
+///        order, so results don't depend on the thread count.
+///
+///        SSIM uses an 11x11 Gaussian window (sigma 1.5) on
+///        luminance clamped to [0, 1]. FLIP follows the LDR
+///        version of Andersson et al. 2020 and, like writePPM,
+///        takes pixel values clamped to [0, 1] as sRGB encoded.
+/////////////////////////////////////////////
+class ImageComparer
+{
+
+public:
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief ImageComparer
+  /// \param reference image test images must match in size
+  ///////////////////////////////////////////////////////////////
+  explicit
+  ImageComparer(
+                const Image               &reference,
+                const ImageCompareOptions &options = ImageCompareOptions( )
+                );
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief compare
+  /// \return every enabled metric, throws if the sizes differ
+  ///////////////////////////////////////////////////////////////
+  ImageMetrics compare ( const Image &test ) const;
+
+
+  unsigned getWidth  ( ) const { return width_; }
+  unsigned getHeight ( ) const { return height_; }
+
+
+private:
+
+  typedef std::vector< float > Plane;
+
+  struct FlipPlanes
+  {
+    Plane L, a, b;       // filtered, Hunt adjusted CIELAB
+    Plane edges, points; // feature magnitudes of normalized luminance
+  };
+
+  void _computeFlipPlanes (
+                           const std::vector< float > &rgba,
+                           FlipPlanes                 *pPlanes
+                           ) const;
+
+  unsigned width_;
+  unsigned height_;
+  unsigned numThreads_;
+
+  ImageCompareOptions options_;
+
+  std::vector< float > reference_; // RGBA like Image
+
+  // SSIM reference statistics
+  Plane referenceLuminance_;
+  Plane referenceMean_;
+  Plane referenceVariance_;
+
+  FlipPlanes referenceFlip_;
+
+  // FLIP filters for the current pixels per degree
+  std::vector< float > csfKernels_[ 4 ]; // achromatic, red-green, blue-yellow twice
+  float                csfWeights_[ 4 ];
+  std::vector< float > featureGaussian_;
+  std::vector< float > edgeKernel_;
+  std::vector< float > pointKernel_;
+
+};
+
+
+///////////////////////////////////////////////////////////////
+/// \brief compareImages
+///
+///        One-off comparison; use ImageComparer to score many
+///        images against the same reference
+///////////////////////////////////////////////////////////////
+ImageMetrics compareImages (
+                            const Image               &test,
+                            const Image               &reference,
+                            const ImageCompareOptions &options = ImageCompareOptions( )
+                            );
+
+
+} // namespace light
+
+
+#endif // ImageMetrics_hpp
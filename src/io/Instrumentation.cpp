@@ -0,0 +1,428 @@
+#include "Instrumentation.hpp"
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <sstream>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+#include <stdexcept>
+
+
+namespace light
+{
+
+
+namespace
+{
+
+
+///
+/// \brief The ThreadTotals struct
+///
+///        One thread's running totals. Only the owning thread
+///        writes them; atomics let the snapshot read them
+///        while that thread keeps working.
+///
+struct ThreadTotals
+{
+  std::atomic< std::uint64_t > stageNanoseconds[ profileStageCount ];
+  std::atomic< std::uint64_t > stageCalls      [ profileStageCount ];
+  std::atomic< std::uint64_t > counters        [ profileCounterCount ];
+};
+
+
+ProfileSnapshot
+emptySnapshot( )
+{
+
+  ProfileSnapshot snapshot;
+  snapshot.seconds = 0.0;
+
+  std::fill( std::begin( snapshot.stageNanoseconds ), std::end( snapshot.stageNanoseconds ), 0 );
+  std::fill( std::begin( snapshot.stageCalls ),       std::end( snapshot.stageCalls ),       0 );
+  std::fill( std::begin( snapshot.counters ),         std::end( snapshot.counters ),         0 );
+
+  return snapshot;
+
+}
+
+
+void
+addTotals(
+          const ThreadTotals &totals,
+          ProfileSnapshot    *pSum
+          )
+{
+
+  for ( unsigned i = 0; i < profileStageCount; ++i )
+  {
+
+    pSum->stageNanoseconds[ i ] += totals.stageNanoseconds[ i ].load( std::memory_order_relaxed );
+    pSum->stageCalls[ i ]       += totals.stageCalls[ i ].load( std::memory_order_relaxed );
+
+  }
+
+  for ( unsigned i = 0; i < profileCounterCount; ++i )
+  {
+
+    pSum->counters[ i ] += totals.counters[ i ].load( std::memory_order_relaxed );
+
+  }
+
+}
+
+
+///
+/// \brief The ProfileRegistry struct
+///
+///        Every live thread's totals, plus what threads that
+///        already exited left behind
+///
+struct ProfileRegistry
+{
+  std::mutex                      mutex;
+  std::vector< ThreadTotals* >    live;
+  ProfileSnapshot                 retired  = emptySnapshot( );
+  ProfileSnapshot                 baseline = emptySnapshot( );
+  std::chrono::steady_clock::time_point resetTime = std::chrono::steady_clock::now( );
+
+
+  // callers hold the mutex
+  ProfileSnapshot
+  sum( ) const
+  {
+
+    ProfileSnapshot total = retired;
+
+    for ( const ThreadTotals *pTotals : live )
+    {
+      addTotals( *pTotals, &total );
+    }
+
+    return total;
+
+  }
+
+};
+
+
+ProfileRegistry&
+getRegistry( )
+{
+
+  static ProfileRegistry registry;
+  return registry;
+
+}
+
+
+///
+/// \brief The ThreadSlot struct
+///
+///        Registers a thread's totals on first use and folds
+///        them into the retired totals when the thread exits
+///
+struct ThreadSlot
+{
+
+  ThreadTotals totals;
+
+
+  ThreadSlot( )
+  {
+
+    for ( std::atomic< std::uint64_t > &value : totals.stageNanoseconds ) { value.store( 0 ); }
+    for ( std::atomic< std::uint64_t > &value : totals.stageCalls )       { value.store( 0 ); }
+    for ( std::atomic< std::uint64_t > &value : totals.counters )         { value.store( 0 ); }
+
+    ProfileRegistry &registry = getRegistry( );
+
+    std::lock_guard< std::mutex > lock( registry.mutex );
+    registry.live.push_back( &totals );
+
+  }
+
+
+  ~ThreadSlot( )
+  {
+
+    ProfileRegistry &registry = getRegistry( );
+
+    std::lock_guard< std::mutex > lock( registry.mutex );
+
+    addTotals( totals, &registry.retired );
+    registry.live.erase( std::find( registry.live.begin( ), registry.live.end( ), &totals ) );
+
+  }
+
+};
+
+
+ThreadTotals&
+getThreadTotals( )
+{
+
+  thread_local ThreadSlot slot;
+  return slot.totals;
+
+}
+
+
+// single writer, so a plain load and store is enough
+inline
+void
+addRelaxed(
+           std::atomic< std::uint64_t > &value,
+           std::uint64_t                 amount
+           )
+{
+
+  value.store( value.load( std::memory_order_relaxed ) + amount, std::memory_order_relaxed );
+
+}
+
+
+const char *stageNames[ profileStageCount ] = {
+  "sceneUpdate",
+  "launch",
+  "accumulation",
+  "readback",
+  "output"
+};
+
+
+const char *counterNames[ profileCounterCount ] = {
+  "frames",
+  "samples",
+  "rays",
+  "shadowRays"
+};
+
+
+} // namespace
+
+
+
+const char*
+getProfileName( ProfileStage stage )
+{
+
+  return stageNames[ static_cast< unsigned >( stage ) ];
+
+}
+
+
+
+const char*
+getProfileName( ProfileCounter counter )
+{
+
+  return counterNames[ static_cast< unsigned >( counter ) ];
+
+}
+
+
+
+double
+ProfileSnapshot::getStageSeconds( ProfileStage stage ) const
+{
+
+  return static_cast< double >( stageNanoseconds[ static_cast< unsigned >( stage ) ] ) * 1e-9;
+
+}
+
+
+
+double
+ProfileSnapshot::getRate( ProfileCounter counter ) const
+{
+
+  return seconds > 0.0 ? static_cast< double >( counters[ static_cast< unsigned >( counter ) ] ) / seconds : 0.0;
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief addProfileTime
+///////////////////////////////////////////////////////////////
+void
+addProfileTime(
+               ProfileStage  stage,
+               std::uint64_t nanoseconds
+               )
+{
+
+  ThreadTotals &totals = getThreadTotals( );
+  unsigned      index  = static_cast< unsigned >( stage );
+
+  addRelaxed( totals.stageNanoseconds[ index ], nanoseconds );
+  addRelaxed( totals.stageCalls[ index ], 1 );
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief addProfileCount
+///////////////////////////////////////////////////////////////
+void
+addProfileCount(
+                ProfileCounter counter,
+                std::uint64_t  amount
+                )
+{
+
+  addRelaxed( getThreadTotals( ).counters[ static_cast< unsigned >( counter ) ], amount );
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief getProfileSnapshot
+///////////////////////////////////////////////////////////////
+ProfileSnapshot
+getProfileSnapshot( )
+{
+
+  ProfileRegistry &registry = getRegistry( );
+
+  std::lock_guard< std::mutex > lock( registry.mutex );
+
+  ProfileSnapshot snapshot = registry.sum( );
+
+  for ( unsigned i = 0; i < profileStageCount; ++i )
+  {
+
+    snapshot.stageNanoseconds[ i ] -= registry.baseline.stageNanoseconds[ i ];
+    snapshot.stageCalls[ i ]       -= registry.baseline.stageCalls[ i ];
+
+  }
+
+  for ( unsigned i = 0; i < profileCounterCount; ++i )
+  {
+
+    snapshot.counters[ i ] -= registry.baseline.counters[ i ];
+
+  }
+
+  snapshot.seconds = std::chrono::duration< double >( std::chrono::steady_clock::now( ) - registry.resetTime ).count( );
+
+  return snapshot;
+
+} // getProfileSnapshot
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief resetProfile
+///////////////////////////////////////////////////////////////
+void
+resetProfile( )
+{
+
+  ProfileRegistry &registry = getRegistry( );
+
+  std::lock_guard< std::mutex > lock( registry.mutex );
+
+  registry.baseline  = registry.sum( );
+  registry.resetTime = std::chrono::steady_clock::now( );
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief toProfileJson
+///////////////////////////////////////////////////////////////
+std::string
+toProfileJson( const ProfileSnapshot &snapshot )
+{
+
+  std::ostringstream json;
+  json << std::setprecision( 9 );
+
+  json << "{\n";
+  json << "  \"seconds\": " << snapshot.seconds << ",\n";
+
+  json << "  \"stages\": {\n";
+
+  for ( unsigned i = 0; i < profileStageCount; ++i )
+  {
+
+    ProfileStage  stage   = static_cast< ProfileStage >( i );
+    double        seconds = snapshot.getStageSeconds( stage );
+    std::uint64_t calls   = snapshot.stageCalls[ i ];
+
+    json << "    \"" << getProfileName( stage ) << "\": { "
+         << "\"calls\": " << calls << ", "
+         << "\"seconds\": " << seconds << ", "
+         << "\"msPerCall\": " << ( calls > 0 ? seconds * 1000.0 / static_cast< double >( calls ) : 0.0 ) << ", "
+         << "\"fraction\": " << ( snapshot.seconds > 0.0 ? seconds / snapshot.seconds : 0.0 )
+         << " }" << ( i + 1 < profileStageCount ? "," : "" ) << "\n";
+
+  }
+
+  json << "  },\n";
+
+  json << "  \"counters\": {\n";
+
+  for ( unsigned i = 0; i < profileCounterCount; ++i )
+  {
+
+    json << "    \"" << getProfileName( static_cast< ProfileCounter >( i ) ) << "\": " << snapshot.counters[ i ]
+         << ( i + 1 < profileCounterCount ? "," : "" ) << "\n";
+
+  }
+
+  json << "  },\n";
+
+  json << "  \"perSecond\": {\n";
+
+  for ( unsigned i = 0; i < profileCounterCount; ++i )
+  {
+
+    ProfileCounter counter = static_cast< ProfileCounter >( i );
+
+    json << "    \"" << getProfileName( counter ) << "\": " << snapshot.getRate( counter )
+         << ( i + 1 < profileCounterCount ? "," : "" ) << "\n";
+
+  }
+
+  json << "  }\n";
+  json << "}\n";
+
+  return json.str( );
+
+} // toProfileJson
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief writeProfileJson
+///////////////////////////////////////////////////////////////
+void
+writeProfileJson(
+                 const std::string     &filename,
+                 const ProfileSnapshot &snapshot
+                 )
+{
+
+  std::ofstream file( filename );
+
+  if ( !file.is_open( ) )
+  {
+
+    throw std::runtime_error( "Could not open file for writeProfileJson: " + filename );
+
+  }
+
+  file << toProfileJson( snapshot );
+
+}
+
+
+
+} // namespace light
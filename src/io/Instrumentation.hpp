@@ -0,0 +1,186 @@
+#ifndef Instrumentation_hpp
+#define Instrumentation_hpp
+
+
+#include <chrono>
+#include <string>
+#include <cstdint>
+
+
+namespace light
+{
+
+
+/////////////////////////////////////////////
+/// \brief The ProfileStage enum
+///
+///        Timed stages of a render. On the GPU ray generation,
+///        traversal, shading and shadow rays all run inside one
+///        OptiX launch, so LAUNCH covers them together.
+/////////////////////////////////////////////
+enum class ProfileStage : unsigned
+{
+  SCENE_UPDATE, // scene edits and acceleration refits
+  LAUNCH,       // ray generation, traversal, shading, shadow rays
+  ACCUMULATION, // merging partial renders
+  READBACK,     // mapping and copying device buffers
+  OUTPUT,       // encoding and writing images
+  COUNT
+};
+
+
+/////////////////////////////////////////////
+/// \brief The ProfileCounter enum
+/////////////////////////////////////////////
+enum class ProfileCounter : unsigned
+{
+  FRAMES,      // progressive frames launched
+  SAMPLES,     // camera samples launched
+  RAYS,        // closest hit rays traced on the host
+  SHADOW_RAYS, // occlusion rays traced on the host
+  COUNT
+};
+
+
+constexpr unsigned profileStageCount   = static_cast< unsigned >( ProfileStage::COUNT );
+constexpr unsigned profileCounterCount = static_cast< unsigned >( ProfileCounter::COUNT );
+
+
+const char *getProfileName ( ProfileStage stage );
+const char *getProfileName ( ProfileCounter counter );
+
+
+/////////////////////////////////////////////
+/// \brief The ProfileSnapshot struct
+///
+///        Totals over every thread since the last reset
+/////////////////////////////////////////////
+struct ProfileSnapshot
+{
+  double        seconds; // wall time since the reset
+  std::uint64_t stageNanoseconds[ profileStageCount ];
+  std::uint64_t stageCalls      [ profileStageCount ];
+  std::uint64_t counters        [ profileCounterCount ];
+
+  double getStageSeconds ( ProfileStage stage ) const;
+  double getRate         ( ProfileCounter counter ) const; ///< per wall second
+};
+
+
+///////////////////////////////////////////////////////////////
+/// \brief addProfileTime
+///
+///        Adds to the calling thread's totals. Threads only
+///        write their own slot, so there is no contention.
+///////////////////////////////////////////////////////////////
+void addProfileTime (
+                     ProfileStage  stage,
+                     std::uint64_t nanoseconds
+                     );
+
+void addProfileCount (
+                      ProfileCounter counter,
+                      std::uint64_t  amount
+                      );
+
+
+///////////////////////////////////////////////////////////////
+/// \brief getProfileSnapshot
+/// \return totals of running and finished threads
+///////////////////////////////////////////////////////////////
+ProfileSnapshot getProfileSnapshot ( );
+
+
+///////////////////////////////////////////////////////////////
+/// \brief resetProfile
+///
+///        Starts a new measurement. Earlier totals are kept as
+///        a baseline and subtracted, so threads never need to
+///        be stopped to clear their counters.
+///////////////////////////////////////////////////////////////
+void resetProfile ( );
+
+
+///////////////////////////////////////////////////////////////
+/// \brief writeProfileJson
+///
+///        Per-stage times and calls, counters and rates as JSON
+///////////////////////////////////////////////////////////////
+void writeProfileJson (
+                       const std::string     &filename,
+                       const ProfileSnapshot &snapshot
+                       );
+
+std::string toProfileJson ( const ProfileSnapshot &snapshot );
+
+
+/////////////////////////////////////////////
+/// \brief The ScopedTimer class
+///
+///        Adds its lifetime to a stage. Use through
+///        LIGHT_PROFILE_SCOPE so it compiles away.
+/////////////////////////////////////////////
+class ScopedTimer
+{
+
+public:
+
+  explicit
+  ScopedTimer( ProfileStage stage )
+    : stage_( stage )
+    , start_( std::chrono::steady_clock::now( ) )
+  {}
+
+
+  ~ScopedTimer( )
+  {
+
+    std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now( ) - start_;
+
+    addProfileTime(
+                   stage_,
+                   static_cast< std::uint64_t >( std::chrono::duration_cast< std::chrono::nanoseconds >( elapsed ).count( ) )
+                   );
+
+  }
+
+  ScopedTimer( const ScopedTimer& )            = delete;
+  ScopedTimer &operator=( const ScopedTimer& ) = delete;
+
+
+private:
+
+  ProfileStage                          stage_;
+  std::chrono::steady_clock::time_point start_;
+
+};
+
+
+} // namespace light
+
+
+
+//
+// instrumentation compiles to nothing unless the build
+// defines LIGHT_INSTRUMENTATION (ENABLE_INSTRUMENTATION)
+//
+#ifdef LIGHT_INSTRUMENTATION
+
+#define LIGHT_PROFILE_JOIN_( a, b ) a ## b
+#define LIGHT_PROFILE_JOIN( a, b )  LIGHT_PROFILE_JOIN_( a, b )
+
+#define LIGHT_PROFILE_SCOPE( stage ) \
+  ::light::ScopedTimer LIGHT_PROFILE_JOIN( lightProfileTimer, __LINE__ )( ::light::ProfileStage::stage )
+
+#define LIGHT_PROFILE_COUNT( counter, amount ) \
+  ::light::addProfileCount( ::light::ProfileCounter::counter, static_cast< std::uint64_t >( amount ) )
+
+#else
+
+#define LIGHT_PROFILE_SCOPE( stage )           static_cast< void >( 0 )
+#define LIGHT_PROFILE_COUNT( counter, amount ) static_cast< void >( 0 )
+
+#endif
+
+
+#endif // Instrumentation_hpp
@@ -2,7 +2,10 @@
 
 // system
 #include <vector>
+#include <chrono>
+#include <iostream>
 #include <algorithm>
+#include <cfloat>
 
 // shared
 #include "glad/glad.h"
@@ -17,9 +20,13 @@
 // project
 #include "LightBenderCallback.hpp"
 #include "LightBenderConfig.hpp"
-#include "OptixBasicScene.hpp"
-#include "OptixAdvancedScene.hpp"
-#include "OptixModelScene.hpp"
+#include "RenderCheckpoint.hpp"
+#include "Instrumentation.hpp"
+#include "MemoryAccounting.hpp"
+#include "PathStatistics.hpp"
+#include "Trace.hpp"
+#include "OptixScene.hpp"
+#include "OptixSceneFactory.hpp"
 
 
 namespace light
@@ -34,7 +41,12 @@ constexpr int defaultHeight = 720;
 
 int displayType = 2;
 
-bool pathTrace = false;
+float traversalCostScale = 64.0f; // primitive tests per sample shown as red
+
+bool pathTrace    = false;
+bool bounceLayers = false;
+bool pathStats    = false;
+bool fastMath     = true; // interactive frames are previews
 
 int cameraType  = 0;
 int sqrtSamples = 1;
@@ -42,8 +54,37 @@ int sqrtSamples = 1;
 int maxBounces  = 5;
 int firstBounce = 0;
 
+int roulette = ROULETTE_EFFICIENCY;
+int minDepth = 2;
+int splits   = 1;
+
 std::string outputFilename = "lightBenderFrame.ppm";
 
+bool autoCheckpoint     = false;
+int  checkpointInterval = 60; // seconds
+
+std::string checkpointStatus;
+
+
+std::string
+checkpointFilename( )
+{
+
+  return light::OUTPUT_PATH + outputFilename + ".lbckpt";
+
+}
+
+
+double
+currentSeconds( )
+{
+
+  return std::chrono::duration< double >(
+                                         std::chrono::steady_clock::now( ).time_since_epoch( )
+                                         ).count( );
+
+}
+
 }
 
 
@@ -55,6 +96,8 @@ std::string outputFilename = "lightBenderFrame.ppm";
 LightBenderIOHandler::LightBenderIOHandler( shared::World &world )
   : ImguiOpenGLIOHandler( world, true, defaultWidth, defaultHeight, false )
   , currentScene_       ( 0 )
+  , upCheckpointWriter_ ( new CheckpointWriter( ) )
+  , lastCheckpointTime_ ( currentSeconds( ) )
 {
 
   std::unique_ptr< graphics::Callback > upCallback( new LightBenderCallback( *this ) );
@@ -202,6 +245,79 @@ LightBenderIOHandler::saveFrame( )
 
   upScene_->saveFrame( light::OUTPUT_PATH + outputFilename );
 
+  if ( pathTrace && bounceLayers )
+  {
+
+    upScene_->saveBounceLayers( light::OUTPUT_PATH + outputFilename );
+
+  }
+
+}
+
+
+
+/////////////////////////////////////////////
+/// \brief LightBenderIOHandler::saveCheckpoint
+///
+///        Copies the accumulation buffers now and writes
+///        them to disk on the checkpoint thread
+/////////////////////////////////////////////
+void
+LightBenderIOHandler::saveCheckpoint( )
+{
+
+  RenderCheckpoint checkpoint;
+  upScene_->captureCheckpoint( &checkpoint );
+
+  checkpointStatus = "Saved frame " + std::to_string( checkpoint.getHeader( ).frameNumber - 1 );
+
+  upCheckpointWriter_->submit( std::move( checkpoint ), checkpointFilename( ) );
+
+  lastCheckpointTime_ = currentSeconds( );
+
+}
+
+
+
+/////////////////////////////////////////////
+/// \brief LightBenderIOHandler::resumeCheckpoint
+///
+///        Continues a progressive render from the checkpoint
+///        saved for the current output filename
+/////////////////////////////////////////////
+void
+LightBenderIOHandler::resumeCheckpoint( )
+{
+
+  try
+  {
+
+    // make sure a pending write isn't half way to disk
+    upCheckpointWriter_->wait( );
+
+    MappedCheckpoint checkpoint( checkpointFilename( ) );
+
+    // the camera hash is checked against the current view
+    glm::vec3 U, V, W;
+    upCamera_->buildRayBasisVectors( &U, &V, &W );
+    upScene_->setCamera( upCamera_->getEye( ), U, V, W );
+
+    upScene_->restoreCheckpoint( checkpoint );
+
+    sqrtSamples  = static_cast< int >( checkpoint.getHeader( ).sqrtSamples );
+    bounceLayers = checkpoint.getHeader( ).bounceLayers != 0;
+
+    checkpointStatus = "Resumed at frame " + std::to_string( checkpoint.getHeader( ).frameNumber );
+
+  }
+  catch ( const std::exception &e )
+  {
+
+    checkpointStatus = e.what( );
+    std::cerr << "Could not resume checkpoint: " << e.what( ) << std::endl;
+
+  }
+
 }
 
 
@@ -223,8 +339,18 @@ LightBenderIOHandler::_onRender( const double )
   if ( upScene_ )
   {
 
+    // edits made in the gui since the last frame, in one batch
+    upScene_->applySceneChanges( );
+
     upScene_->renderWorld( *upCamera_ );
 
+    if ( autoCheckpoint && pathTrace
+        && currentSeconds( ) - lastCheckpointTime_ >= checkpointInterval )
+    {
+
+      saveCheckpoint( );
+
+    }
 
     optix::Buffer buffer = upScene_->getBuffer( );
 
@@ -329,6 +455,15 @@ LightBenderIOHandler::_onGuiRender( )
 
     }
 
+
+    bool oldFastMath = fastMath;
+    ImGui::Checkbox( "Fast Math", &fastMath );
+
+    if ( oldFastMath != fastMath )
+    {
+      upScene_->setMathPrecision( fastMath ? MATH_FAST : MATH_PRECISE );
+    }
+
     if ( pathTrace )
     {
 
@@ -351,6 +486,44 @@ LightBenderIOHandler::_onGuiRender( )
         upScene_->setFirstBounce( static_cast< unsigned >( firstBounce ) );
       }
 
+
+      int oldRoulette = roulette;
+      int oldMinDepth = minDepth;
+      ImGui::Combo( "Roulette", &roulette, " Albedo \0 Throughput \0 Efficiency \0\0" );
+      ImGui::SliderInt( "Min Depth", &minDepth, 0, 10 );
+
+      if ( oldRoulette != roulette || oldMinDepth != minDepth )
+      {
+        upScene_->setRoulette( static_cast< RoulettePolicy >( roulette ), static_cast< unsigned >( minDepth ) );
+      }
+
+
+      int oldSplits = splits;
+      ImGui::SliderInt( "First Bounce Splits", &splits, 1, 16 );
+
+      if ( oldSplits != splits )
+      {
+        upScene_->setFirstBounceSplits( static_cast< unsigned >( splits ) );
+      }
+
+
+      bool oldLayers = bounceLayers;
+      ImGui::Checkbox( "Direct/Indirect Layers", &bounceLayers );
+
+      if ( oldLayers != bounceLayers )
+      {
+        upScene_->setBounceLayers( bounceLayers );
+      }
+
+
+      bool oldStats = pathStats;
+      ImGui::Checkbox( "Path Statistics", &pathStats );
+
+      if ( oldStats != pathStats )
+      {
+        upScene_->setPathStatistics( pathStats );
+      }
+
     }
 
 
@@ -392,7 +565,7 @@ LightBenderIOHandler::_onGuiRender( )
   ImGui::Separator( );
 
   int oldDisplay = displayType;
-  ImGui::Combo( "Display", &displayType, " Normals \0 Simple Shading \0 BSDF \0\0" );
+  ImGui::Combo( "Display", &displayType, " Normals \0 Simple Shading \0 BSDF \0 Traversal Cost \0\0" );
 
   if ( oldDisplay != displayType )
   {
@@ -401,6 +574,20 @@ LightBenderIOHandler::_onGuiRender( )
 
   }
 
+  // primary and shadow ray primitive tests, drawn when not path tracing
+  if ( displayType == 3 )
+  {
+
+    float oldScale = traversalCostScale;
+    ImGui::SliderFloat( "Tests for Red", &traversalCostScale, 1.0f, 1024.0f, "%.0f", 2.0f );
+
+    if ( oldScale != traversalCostScale )
+    {
+      upScene_->setTraversalCostScale( traversalCostScale );
+    }
+
+  }
+
   ImGui::Separator( );
   ImGui::Text( "Type" );
 
@@ -437,6 +624,233 @@ LightBenderIOHandler::_onGuiRender( )
 
   }
 
+  //
+  // checkpoints
+  //
+  if ( pathTrace && ImGui::CollapsingHeader( "Checkpoint", "checkpoint", false, false ) )
+  {
+
+    ImGui::Checkbox( "Auto Checkpoint", &autoCheckpoint );
+    ImGui::SliderInt( "Interval (s)", &checkpointInterval, 10, 600 );
+
+    if ( ImGui::Button( "Save Checkpoint" ) )
+    {
+      saveCheckpoint( );
+    }
+
+    ImGui::SameLine( );
+
+    if ( ImGui::Button( "Resume Checkpoint" ) )
+    {
+      resumeCheckpoint( );
+    }
+
+    std::string error = upCheckpointWriter_->getLastError( );
+
+    ImGui::Text( "%s", error.empty( ) ? checkpointStatus.c_str( ) : error.c_str( ) );
+
+  }
+
+  //
+  // per-stage timings since the last reset
+  //
+  if ( ImGui::CollapsingHeader( "Profile", "profile", false, false ) )
+  {
+
+#ifdef LIGHT_INSTRUMENTATION
+
+    ProfileSnapshot profile = getProfileSnapshot( );
+
+    double frames = static_cast< double >( profile.counters[ static_cast< unsigned >( ProfileCounter::FRAMES ) ] );
+
+    ImGui::Text( "%.1f s, %.0f frames", profile.seconds, frames );
+
+    for ( unsigned i = 0; i < profileStageCount; ++i )
+    {
+
+      ProfileStage stage   = static_cast< ProfileStage >( i );
+      double       seconds = profile.getStageSeconds( stage );
+
+      ImGui::Text(
+                  "%-13s %8.3f ms/frame %5.1f%%",
+                  getProfileName( stage ),
+                  frames > 0.0 ? seconds * 1000.0 / frames : 0.0,
+                  profile.seconds > 0.0 ? seconds * 100.0 / profile.seconds : 0.0
+                  );
+
+    }
+
+    ImGui::Text( "Samples/s     %.3g", profile.getRate( ProfileCounter::SAMPLES ) );
+    ImGui::Text( "Host rays/s   %.3g", profile.getRate( ProfileCounter::RAYS ) );
+
+    if ( ImGui::Button( "Reset Profile" ) )
+    {
+      resetProfile( );
+    }
+
+    ImGui::SameLine( );
+
+    if ( ImGui::Button( "Save Profile" ) )
+    {
+
+      try
+      {
+
+        writeProfileJson( light::OUTPUT_PATH + outputFilename + ".profile.json", profile );
+
+      }
+      catch ( const std::exception &e )
+      {
+
+        std::cerr << "Could not save profile: " << e.what( ) << std::endl;
+
+      }
+
+    }
+
+    //
+    // timeline of scene loads, frames and tiles
+    //
+    if ( !isTracing( ) )
+    {
+
+      if ( ImGui::Button( "Start Trace" ) )
+      {
+        startTrace( );
+      }
+
+    }
+    else if ( ImGui::Button( "Stop and Save Trace" ) )
+    {
+
+      stopTrace( );
+
+      try
+      {
+
+        writeTraceJson( light::OUTPUT_PATH + outputFilename + ".trace.json" );
+
+      }
+      catch ( const std::exception &e )
+      {
+
+        std::cerr << "Could not save trace: " << e.what( ) << std::endl;
+
+      }
+
+    }
+
+#else
+
+    ImGui::Text( "Built without instrumentation (ENABLE_INSTRUMENTATION)" );
+
+#endif
+
+  }
+
+  //
+  // bytes held per subsystem, host and device together
+  //
+  if ( ImGui::CollapsingHeader( "Memory", "memory", false, false ) )
+  {
+
+    MemorySnapshot memory = getMemorySnapshot( );
+
+    const double mebibyte = 1024.0 * 1024.0;
+
+    ImGui::Text( "%-13s %9s %9s", "MiB", "current", "peak" );
+
+    for ( unsigned i = 0; i < memoryCategoryCount; ++i )
+    {
+
+      ImGui::Text(
+                  "%-13s %9.2f %9.2f",
+                  getMemoryCategoryName( static_cast< MemoryCategory >( i ) ),
+                  memory.current[ i ] / mebibyte,
+                  memory.peak[ i ] / mebibyte
+                  );
+
+    }
+
+    ImGui::Text( "%-13s %9.2f %9.2f", "total", memory.totalCurrent / mebibyte, memory.totalPeak / mebibyte );
+
+    if ( ImGui::Button( "Reset Peaks" ) )
+    {
+      resetMemoryPeaks( );
+    }
+
+    ImGui::SameLine( );
+
+    if ( ImGui::Button( "Save Memory" ) )
+    {
+
+      try
+      {
+
+        writeMemoryJson( light::OUTPUT_PATH + outputFilename + ".memory.json", memory );
+
+      }
+      catch ( const std::exception &e )
+      {
+
+        std::cerr << "Could not save memory report: " << e.what( ) << std::endl;
+
+      }
+
+    }
+
+  }
+
+  //
+  // how path traced samples ended since the camera last moved
+  //
+  if ( pathTrace && pathStats && ImGui::CollapsingHeader( "Path Statistics", "pathStats", false, false ) )
+  {
+
+    PathStatistics statistics = upScene_->getPathStatistics( );
+
+    float histogram[ PATH_STATS_MAX_LENGTH ];
+
+    for ( unsigned i = 0; i < PATH_STATS_MAX_LENGTH; ++i )
+    {
+      histogram[ i ] = static_cast< float >( statistics.lengths[ i ] );
+    }
+
+    ImGui::Text( "%.3g paths, mean length %.2f", static_cast< double >( statistics.getPathCount( ) ), statistics.getMeanLength( ) );
+    ImGui::PlotHistogram( "Lengths", histogram, PATH_STATS_MAX_LENGTH, 0, nullptr, 0.0f, FLT_MAX, ImVec2( 0, 60 ) );
+
+    for ( unsigned i = 0; i < pathTerminationCount; ++i )
+    {
+
+      PathTermination termination = static_cast< PathTermination >( i );
+
+      ImGui::Text( "%-13s %5.1f%%", getPathTerminationName( termination ), statistics.getFraction( termination ) * 100.0 );
+
+    }
+
+    ImGui::Text( "Mean throughput %.3f", statistics.getMeanThroughput( ) );
+    ImGui::Text( "Shadow occluded %.1f%%", statistics.getOcclusionRate( ) * 100.0 );
+
+    if ( ImGui::Button( "Save Path Statistics" ) )
+    {
+
+      try
+      {
+
+        writePathStatisticsJson( light::OUTPUT_PATH + outputFilename + ".paths.json", statistics );
+
+      }
+      catch ( const std::exception &e )
+      {
+
+        std::cerr << "Could not save path statistics: " << e.what( ) << std::endl;
+
+      }
+
+    }
+
+  }
+
   //
   // Control listing
   //
@@ -468,6 +882,8 @@ void
 LightBenderIOHandler::_setScene( )
 {
 
+  LIGHT_TRACE_SCOPE( "setScene", "scene" );
+
   if ( upScene_ )
   {
 
@@ -476,63 +892,25 @@ LightBenderIOHandler::_setScene( )
   }
 
 
-  std::string modelFile = light::MODEL_PATH + "tie_interceptor/obj_format/tie_interceptor.obj";
-//  std::string modelFile = light::MODEL_PATH + "x_wing/x-wing.obj";
-
-
-  switch ( currentScene_ )
-  {
-
-  case 0:
-
-    upScene_
-      = std::unique_ptr< OptixScene >( new OptixBasicScene(
-                                                           defaultWidth,
-                                                           defaultHeight,
-                                                           upGLWrapper_->getBuffer( "renderBuffer" )
-                                                           ) );
-
-    break;
-
-
-  case 1:
-
-    upScene_
-      = std::unique_ptr< OptixScene >( new OptixAdvancedScene(
-                                                              defaultWidth,
-                                                              defaultHeight,
-                                                              upGLWrapper_->getBuffer(
-                                                                                      "renderBuffer"
-                                                                                      )
-                                                              ) );
-    break;
-
-
-  case 2:
-
-    upScene_
-      = std::unique_ptr< OptixScene >( new OptixModelScene(
-                                                           defaultWidth,
-                                                           defaultHeight,
-                                                           upGLWrapper_->getBuffer( "renderBuffer" ),
-                                                           modelFile
-                                                           ) );
-    break;
-
-
-  default:
-
-    throw std::runtime_error( "Unknown scene" );
-
-    break;
-
-  } // switch
+  upScene_ = createOptixScene(
+                              currentScene_,
+                              defaultWidth,
+                              defaultHeight,
+                              upGLWrapper_->getBuffer( "renderBuffer" ),
+                              getDefaultModelFile( )
+                              );
 
+  upScene_->setTraversalCostScale( traversalCostScale );
   upScene_->setDisplayType( displayType );
   upScene_->setPathTracing( pathTrace );
   upScene_->setCameraType ( cameraType );
   upScene_->setMaxBounces ( static_cast< unsigned >( maxBounces ) );
   upScene_->setFirstBounce( static_cast< unsigned >( firstBounce ) );
+  upScene_->setBounceLayers( bounceLayers );
+  upScene_->setPathStatistics( pathStats );
+  upScene_->setMathPrecision( fastMath ? MATH_FAST : MATH_PRECISE );
+  upScene_->setRoulette( static_cast< RoulettePolicy >( roulette ), static_cast< unsigned >( minDepth ) );
+  upScene_->setFirstBounceSplits( static_cast< unsigned >( splits ) );
 
 } // LightBenderIOHandler::_setScene
 
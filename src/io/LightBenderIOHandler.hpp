@@ -27,6 +27,7 @@ namespace light
 {
 
 class OptixScene;
+class CheckpointWriter;
 
 
 /////////////////////////////////////////////
@@ -84,6 +85,18 @@ public:
   void saveFrame( );
 
 
+  ///////////////////////////////////////////////////////////////
+  /// \brief saveCheckpoint
+  ///////////////////////////////////////////////////////////////
+  void saveCheckpoint( );
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief resumeCheckpoint
+  ///////////////////////////////////////////////////////////////
+  void resumeCheckpoint( );
+
+
 protected:
 
 private:
@@ -102,6 +115,9 @@ private:
 
   int currentScene_;
 
+  std::unique_ptr< CheckpointWriter > upCheckpointWriter_;
+  double lastCheckpointTime_;
+
 
 };
 
@@ -0,0 +1,334 @@
+#include "MemoryAccounting.hpp"
+#include <atomic>
+#include <sstream>
+#include <fstream>
+#include <stdexcept>
+
+
+namespace light
+{
+
+
+namespace
+{
+
+
+///
+/// \brief The MemoryCounters struct
+///
+///        Current and peak bytes per category and in total
+///
+struct MemoryCounters
+{
+  std::atomic< std::int64_t > current[ memoryCategoryCount ];
+  std::atomic< std::int64_t > peak[ memoryCategoryCount ];
+  std::atomic< std::int64_t > totalCurrent{ 0 };
+  std::atomic< std::int64_t > totalPeak{ 0 };
+
+  MemoryCounters( )
+  {
+
+    for ( unsigned c = 0; c < memoryCategoryCount; ++c )
+    {
+
+      current[ c ].store( 0 );
+      peak[ c ].store( 0 );
+
+    }
+
+  }
+
+};
+
+
+MemoryCounters&
+getCounters( )
+{
+
+  static MemoryCounters counters;
+  return counters;
+
+}
+
+
+void
+raisePeak(
+          std::atomic< std::int64_t > &peak,
+          std::int64_t                 value
+          )
+{
+
+  std::int64_t previous = peak.load( std::memory_order_relaxed );
+
+  while ( value > previous && !peak.compare_exchange_weak( previous, value, std::memory_order_relaxed ) )
+  {
+  }
+
+}
+
+
+const char *categoryNames[ memoryCategoryCount ] =
+{
+  "geometry",
+  "acceleration",
+  "textures",
+  "framebuffers",
+  "scratch"
+};
+
+
+} // namespace
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief getMemoryCategoryName
+///////////////////////////////////////////////////////////////
+const char*
+getMemoryCategoryName( MemoryCategory category )
+{
+
+  return categoryNames[ static_cast< unsigned >( category ) ];
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief addMemory
+///////////////////////////////////////////////////////////////
+void
+addMemory(
+          MemoryCategory category,
+          std::int64_t   bytes
+          )
+{
+
+  if ( bytes == 0 )
+  {
+    return;
+  }
+
+  MemoryCounters &counters = getCounters( );
+  unsigned        index    = static_cast< unsigned >( category );
+
+  std::int64_t current = counters.current[ index ].fetch_add( bytes, std::memory_order_relaxed ) + bytes;
+  std::int64_t total   = counters.totalCurrent.fetch_add( bytes, std::memory_order_relaxed ) + bytes;
+
+  if ( bytes > 0 )
+  {
+
+    raisePeak( counters.peak[ index ], current );
+    raisePeak( counters.totalPeak, total );
+
+  }
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief getMemorySnapshot
+///////////////////////////////////////////////////////////////
+MemorySnapshot
+getMemorySnapshot( )
+{
+
+  MemoryCounters &counters = getCounters( );
+  MemorySnapshot  snapshot;
+
+  for ( unsigned c = 0; c < memoryCategoryCount; ++c )
+  {
+
+    snapshot.current[ c ] = counters.current[ c ].load( std::memory_order_relaxed );
+    snapshot.peak[ c ]    = counters.peak[ c ].load( std::memory_order_relaxed );
+
+  }
+
+  snapshot.totalCurrent = counters.totalCurrent.load( std::memory_order_relaxed );
+  snapshot.totalPeak    = counters.totalPeak.load( std::memory_order_relaxed );
+
+  return snapshot;
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief resetMemoryPeaks
+///////////////////////////////////////////////////////////////
+void
+resetMemoryPeaks( )
+{
+
+  MemoryCounters &counters = getCounters( );
+
+  for ( unsigned c = 0; c < memoryCategoryCount; ++c )
+  {
+
+    counters.peak[ c ].store( counters.current[ c ].load( ) );
+
+  }
+
+  counters.totalPeak.store( counters.totalCurrent.load( ) );
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief toMemoryJson
+///////////////////////////////////////////////////////////////
+std::string
+toMemoryJson( const MemorySnapshot &snapshot )
+{
+
+  std::ostringstream json;
+
+  json << "{\n";
+  json << "  \"categories\": {\n";
+
+  for ( unsigned c = 0; c < memoryCategoryCount; ++c )
+  {
+
+    json << "    \"" << categoryNames[ c ] << "\": { "
+         << "\"currentBytes\": " << snapshot.current[ c ] << ", "
+         << "\"peakBytes\": " << snapshot.peak[ c ] << " }"
+         << ( c + 1 < memoryCategoryCount ? ",\n" : "\n" );
+
+  }
+
+  json << "  },\n";
+  json << "  \"total\": { "
+       << "\"currentBytes\": " << snapshot.totalCurrent << ", "
+       << "\"peakBytes\": " << snapshot.totalPeak << " }\n";
+  json << "}\n";
+
+  return json.str( );
+
+} // toMemoryJson
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief writeMemoryJson
+///////////////////////////////////////////////////////////////
+void
+writeMemoryJson(
+                const std::string    &filename,
+                const MemorySnapshot &snapshot
+                )
+{
+
+  std::ofstream file( filename );
+
+  if ( !file.is_open( ) )
+  {
+
+    throw std::runtime_error( "Could not open file for writeMemoryJson: " + filename );
+
+  }
+
+  file << toMemoryJson( snapshot );
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief TrackedMemory::TrackedMemory
+///////////////////////////////////////////////////////////////
+TrackedMemory::TrackedMemory(
+                             MemoryCategory category,
+                             std::size_t    bytes
+                             )
+  : category_( category )
+  , bytes_   ( bytes )
+{
+
+  addMemory( category_, static_cast< std::int64_t >( bytes_ ) );
+
+}
+
+
+
+TrackedMemory::TrackedMemory( const TrackedMemory &other )
+  : TrackedMemory( other.category_, other.bytes_ )
+{}
+
+
+
+TrackedMemory::TrackedMemory( TrackedMemory &&other )
+  : category_( other.category_ )
+  , bytes_   ( other.bytes_ )
+{
+
+  other.bytes_ = 0;
+
+}
+
+
+
+TrackedMemory::~TrackedMemory( )
+{
+
+  addMemory( category_, -static_cast< std::int64_t >( bytes_ ) );
+
+}
+
+
+
+TrackedMemory&
+TrackedMemory::operator=( const TrackedMemory &other )
+{
+
+  if ( this != &other )
+  {
+
+    set( 0 );
+    category_ = other.category_;
+    set( other.bytes_ );
+
+  }
+
+  return *this;
+
+}
+
+
+
+TrackedMemory&
+TrackedMemory::operator=( TrackedMemory &&other )
+{
+
+  if ( this != &other )
+  {
+
+    set( 0 );
+    category_    = other.category_;
+    bytes_       = other.bytes_;
+    other.bytes_ = 0;
+
+  }
+
+  return *this;
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief TrackedMemory::set
+///////////////////////////////////////////////////////////////
+void
+TrackedMemory::set( std::size_t bytes )
+{
+
+  addMemory( category_, static_cast< std::int64_t >( bytes ) - static_cast< std::int64_t >( bytes_ ) );
+  bytes_ = bytes;
+
+}
+
+
+
+} // namespace light
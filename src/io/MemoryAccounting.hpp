@@ -0,0 +1,132 @@
+#ifndef MemoryAccounting_hpp
+#define MemoryAccounting_hpp
+
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+
+namespace light
+{
+
+
+/////////////////////////////////////////////
+/// \brief The MemoryCategory enum
+///
+///        Subsystems whose allocations are accounted for,
+///        host and device bytes together
+/////////////////////////////////////////////
+enum class MemoryCategory : unsigned
+{
+  GEOMETRY,     // vertices, indices, shape and material records
+  ACCELERATION, // BVH nodes, item indices and instances
+  TEXTURES,
+  FRAMEBUFFERS, // output, layer and accumulation buffers
+  SCRATCH,      // readback copies and frames queued for writing
+  COUNT
+};
+
+
+constexpr unsigned memoryCategoryCount = static_cast< unsigned >( MemoryCategory::COUNT );
+
+
+const char *getMemoryCategoryName ( MemoryCategory category );
+
+
+///////////////////////////////////////////////////////////////
+/// \brief addMemory
+///
+///        Adds (or with negative bytes, removes) an allocation
+///        and raises the category's and the total peak when
+///        they are exceeded. Safe from any thread.
+///////////////////////////////////////////////////////////////
+void addMemory (
+                MemoryCategory category,
+                std::int64_t   bytes
+                );
+
+
+/////////////////////////////////////////////
+/// \brief The MemorySnapshot struct
+///
+///        Bytes in use and the most ever in use since the
+///        last resetMemoryPeaks
+/////////////////////////////////////////////
+struct MemorySnapshot
+{
+  std::int64_t current[ memoryCategoryCount ] = { };
+  std::int64_t peak[ memoryCategoryCount ]    = { };
+
+  std::int64_t totalCurrent = 0;
+  std::int64_t totalPeak    = 0; // peak of the sum, not the sum of peaks
+};
+
+
+MemorySnapshot getMemorySnapshot ( );
+
+
+///////////////////////////////////////////////////////////////
+/// \brief resetMemoryPeaks
+///
+///        Lowers every peak to the current usage
+///////////////////////////////////////////////////////////////
+void resetMemoryPeaks ( );
+
+
+std::string toMemoryJson ( const MemorySnapshot &snapshot );
+
+void writeMemoryJson (
+                      const std::string    &filename,
+                      const MemorySnapshot &snapshot
+                      );
+
+
+/////////////////////////////////////////////
+/// \brief The TrackedMemory class
+///
+///        Holds one allocation's size in a category and gives
+///        it back when destroyed. Owners call set whenever
+///        their storage changes size; copies count again.
+/////////////////////////////////////////////
+class TrackedMemory
+{
+
+public:
+
+  explicit
+  TrackedMemory(
+                MemoryCategory category,
+                std::size_t    bytes = 0
+                );
+
+  TrackedMemory( const TrackedMemory &other );
+
+  TrackedMemory( TrackedMemory &&other );
+
+  ~TrackedMemory( );
+
+  TrackedMemory &operator= ( const TrackedMemory &other );
+
+  TrackedMemory &operator= ( TrackedMemory &&other );
+
+
+  void set ( std::size_t bytes );
+
+  std::size_t getBytes ( ) const { return bytes_; }
+
+  MemoryCategory getCategory ( ) const { return category_; }
+
+
+private:
+
+  MemoryCategory category_;
+  std::size_t    bytes_;
+
+};
+
+
+} // namespace light
+
+
+#endif // MemoryAccounting_hpp
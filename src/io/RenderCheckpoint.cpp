@@ -0,0 +1,540 @@
+#include "RenderCheckpoint.hpp"
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include "Hash.hpp"
+
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+
+namespace light
+{
+
+
+namespace
+{
+
+
+const char          checkpointMagic[ 8 ] = { 'L', 'B', 'C', 'K', 'P', 'T', '\0', '\0' };
+const std::uint32_t checkpointVersion    = 2;
+
+// pixel data starts on a page boundary so it can be mapped directly
+const std::uint64_t checkpointDataOffset = 4096;
+
+static_assert( sizeof( CheckpointHeader ) <= checkpointDataOffset, "Checkpoint header must fit in one page" );
+
+
+std::size_t
+layerFloats( const CheckpointHeader &header )
+{
+
+  return static_cast< std::size_t >( header.width ) * header.height * 4;
+
+}
+
+
+///
+/// \brief flushToDisk
+///
+///        Makes sure the file contents reach the disk before the
+///        rename, otherwise a crash could leave an empty file
+///
+void
+flushToDisk( std::FILE *pFile )
+{
+
+  std::fflush( pFile );
+
+#ifdef _WIN32
+  _commit( _fileno( pFile ) );
+#else
+  fsync( fileno( pFile ) );
+#endif
+
+}
+
+
+void
+replaceFile(
+            const std::string &from,
+            const std::string &to
+            )
+{
+
+#ifdef _WIN32
+  bool moved = MoveFileExA( from.c_str( ), to.c_str( ), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH ) != 0;
+#else
+  bool moved = std::rename( from.c_str( ), to.c_str( ) ) == 0;
+#endif
+
+  if ( !moved )
+  {
+
+    std::remove( from.c_str( ) );
+    throw std::runtime_error( "Could not move checkpoint into place: " + to );
+
+  }
+
+}
+
+
+} // namespace
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief RenderCheckpoint::RenderCheckpoint
+///////////////////////////////////////////////////////////////
+RenderCheckpoint::RenderCheckpoint( )
+{
+
+  std::memset( &header_, 0, sizeof( header_ ) );
+  std::memcpy( header_.magic, checkpointMagic, sizeof( checkpointMagic ) );
+
+  header_.version     = checkpointVersion;
+  header_.headerBytes = sizeof( CheckpointHeader );
+  header_.dataOffset  = checkpointDataOffset;
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief RenderCheckpoint::resize
+///////////////////////////////////////////////////////////////
+void
+RenderCheckpoint::resize(
+                         unsigned width,
+                         unsigned height,
+                         unsigned layerCount
+                         )
+{
+
+  header_.width      = width;
+  header_.height     = height;
+  header_.layerCount = layerCount;
+
+  data_.resize( layerFloats( header_ ) * layerCount );
+
+  header_.dataBytes = data_.size( ) * sizeof( float );
+
+}
+
+
+
+float *
+RenderCheckpoint::getLayer( unsigned layer )
+{
+
+  return data_.data( ) + layerFloats( header_ ) * layer;
+
+}
+
+
+
+const float *
+RenderCheckpoint::getLayer( unsigned layer ) const
+{
+
+  return data_.data( ) + layerFloats( header_ ) * layer;
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief RenderCheckpoint::write
+/// \param filename
+///////////////////////////////////////////////////////////////
+void
+RenderCheckpoint::write( const std::string &filename ) const
+{
+
+  CheckpointHeader header = header_;
+  header.dataChecksum     = hashBytes( data_.data( ), header.dataBytes );
+
+  std::string tmpFilename = filename + ".tmp";
+
+  std::FILE *pFile = std::fopen( tmpFilename.c_str( ), "wb" );
+
+  if ( !pFile )
+  {
+
+    throw std::runtime_error( "Could not open checkpoint for writing: " + tmpFilename );
+
+  }
+
+  std::vector< char > padding( static_cast< std::size_t >( header.dataOffset ) - sizeof( header ), 0 );
+
+  bool ok = std::fwrite( &header, sizeof( header ), 1, pFile ) == 1
+            && std::fwrite( padding.data( ), 1, padding.size( ), pFile ) == padding.size( )
+            && std::fwrite( data_.data( ), 1, header.dataBytes, pFile ) == header.dataBytes;
+
+  if ( ok )
+  {
+
+    flushToDisk( pFile );
+
+  }
+
+  ok = ( std::fclose( pFile ) == 0 ) && ok;
+
+  if ( !ok )
+  {
+
+    std::remove( tmpFilename.c_str( ) );
+    throw std::runtime_error( "Failed writing checkpoint: " + tmpFilename );
+
+  }
+
+  replaceFile( tmpFilename, filename );
+
+} // RenderCheckpoint::write
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief MappedCheckpoint::MappedCheckpoint
+/// \param filename
+///////////////////////////////////////////////////////////////
+MappedCheckpoint::MappedCheckpoint( const std::string &filename )
+  : pData_( nullptr )
+  , bytes_( 0 )
+{
+
+#ifdef _WIN32
+
+  fileHandle_ = CreateFileA(
+                            filename.c_str( ),
+                            GENERIC_READ,
+                            FILE_SHARE_READ,
+                            nullptr,
+                            OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL,
+                            nullptr
+                            );
+
+  if ( fileHandle_ == INVALID_HANDLE_VALUE )
+  {
+
+    throw std::runtime_error( "Could not open checkpoint: " + filename );
+
+  }
+
+  LARGE_INTEGER size;
+  GetFileSizeEx( fileHandle_, &size );
+  bytes_ = static_cast< std::size_t >( size.QuadPart );
+
+  mappingHandle_ = CreateFileMappingA( fileHandle_, nullptr, PAGE_READONLY, 0, 0, nullptr );
+
+  if ( mappingHandle_ )
+  {
+
+    pData_ = static_cast< const unsigned char* >( MapViewOfFile( mappingHandle_, FILE_MAP_READ, 0, 0, 0 ) );
+
+  }
+
+  if ( !pData_ )
+  {
+
+    if ( mappingHandle_ )
+    {
+      CloseHandle( mappingHandle_ );
+    }
+
+    CloseHandle( fileHandle_ );
+    throw std::runtime_error( "Could not map checkpoint: " + filename );
+
+  }
+
+#else
+
+  fileDescriptor_ = open( filename.c_str( ), O_RDONLY );
+
+  if ( fileDescriptor_ < 0 )
+  {
+
+    throw std::runtime_error( "Could not open checkpoint: " + filename );
+
+  }
+
+  struct stat info;
+
+  if ( fstat( fileDescriptor_, &info ) != 0 || info.st_size <= 0 )
+  {
+
+    close( fileDescriptor_ );
+    throw std::runtime_error( "Could not read checkpoint size: " + filename );
+
+  }
+
+  bytes_ = static_cast< std::size_t >( info.st_size );
+
+  void *pMapping = mmap( nullptr, bytes_, PROT_READ, MAP_PRIVATE, fileDescriptor_, 0 );
+
+  if ( pMapping == MAP_FAILED )
+  {
+
+    close( fileDescriptor_ );
+    throw std::runtime_error( "Could not map checkpoint: " + filename );
+
+  }
+
+  pData_ = static_cast< const unsigned char* >( pMapping );
+
+#endif
+
+  //
+  // validate before anyone reads pixel data
+  //
+  std::string error;
+
+  const CheckpointHeader &header = getHeader( );
+
+  if ( bytes_ < sizeof( CheckpointHeader )
+      || std::memcmp( header.magic, checkpointMagic, sizeof( checkpointMagic ) ) != 0 )
+  {
+
+    error = "Not a LightBender checkpoint: ";
+
+  }
+  else if ( header.version != checkpointVersion || header.headerBytes != sizeof( CheckpointHeader ) )
+  {
+
+    error = "Unsupported checkpoint version: ";
+
+  }
+  else if ( header.layerCount != 1u + ( header.bounceLayers ? 2u : 0u ) + ( header.rouletteLayer ? 1u : 0u ) )
+  {
+
+    error = "Checkpoint layers don't match its header: ";
+
+  }
+  else if ( header.dataOffset + header.dataBytes > bytes_
+           || header.dataBytes != layerFloats( header ) * header.layerCount * sizeof( float ) )
+  {
+
+    error = "Checkpoint is truncated: ";
+
+  }
+  else if ( hashBytes( pData_ + header.dataOffset, static_cast< std::size_t >( header.dataBytes ) ) != header.dataChecksum )
+  {
+
+    error = "Checkpoint checksum mismatch: ";
+
+  }
+
+  if ( !error.empty( ) )
+  {
+
+    _release( );
+    throw std::runtime_error( error + filename );
+
+  }
+
+} // MappedCheckpoint::MappedCheckpoint
+
+
+
+MappedCheckpoint::~MappedCheckpoint( )
+{
+
+  _release( );
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief MappedCheckpoint::_release
+///////////////////////////////////////////////////////////////
+void
+MappedCheckpoint::_release( )
+{
+
+  if ( !pData_ )
+  {
+    return;
+  }
+
+#ifdef _WIN32
+  UnmapViewOfFile( pData_ );
+  CloseHandle( mappingHandle_ );
+  CloseHandle( fileHandle_ );
+#else
+  munmap( const_cast< unsigned char* >( pData_ ), bytes_ );
+  close( fileDescriptor_ );
+#endif
+
+  pData_ = nullptr;
+
+}
+
+
+
+const CheckpointHeader &
+MappedCheckpoint::getHeader( ) const
+{
+
+  return *reinterpret_cast< const CheckpointHeader* >( pData_ );
+
+}
+
+
+
+const float *
+MappedCheckpoint::getLayer( unsigned layer ) const
+{
+
+  const CheckpointHeader &header = getHeader( );
+
+  return reinterpret_cast< const float* >( pData_ + header.dataOffset ) + layerFloats( header ) * layer;
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief CheckpointWriter::CheckpointWriter
+///////////////////////////////////////////////////////////////
+CheckpointWriter::CheckpointWriter( )
+  : writing_ ( false )
+  , stopping_( false )
+  , thread_  ( &CheckpointWriter::_run, this )
+{}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief CheckpointWriter::~CheckpointWriter
+///
+///        Finishes any pending write before returning
+///////////////////////////////////////////////////////////////
+CheckpointWriter::~CheckpointWriter( )
+{
+
+  {
+    std::lock_guard< std::mutex > lock( mutex_ );
+    stopping_ = true;
+  }
+
+  condition_.notify_all( );
+  thread_.join( );
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief CheckpointWriter::submit
+///////////////////////////////////////////////////////////////
+void
+CheckpointWriter::submit(
+                         RenderCheckpoint   checkpoint,
+                         const std::string &filename
+                         )
+{
+
+  {
+    std::lock_guard< std::mutex > lock( mutex_ );
+    upPending_.reset( new RenderCheckpoint( std::move( checkpoint ) ) );
+    pendingFilename_ = filename;
+  }
+
+  condition_.notify_all( );
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief CheckpointWriter::wait
+///////////////////////////////////////////////////////////////
+void
+CheckpointWriter::wait( )
+{
+
+  std::unique_lock< std::mutex > lock( mutex_ );
+  condition_.wait( lock, [ this ] { return !upPending_ && !writing_; } );
+
+}
+
+
+
+std::string
+CheckpointWriter::getLastError( )
+{
+
+  std::lock_guard< std::mutex > lock( mutex_ );
+  return lastError_;
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief CheckpointWriter::_run
+///////////////////////////////////////////////////////////////
+void
+CheckpointWriter::_run( )
+{
+
+  std::unique_lock< std::mutex > lock( mutex_ );
+
+  while ( true )
+  {
+
+    condition_.wait( lock, [ this ] { return upPending_ || stopping_; } );
+
+    if ( !upPending_ )
+    {
+      return; // stopping with nothing left to write
+    }
+
+    std::unique_ptr< RenderCheckpoint > upCheckpoint = std::move( upPending_ );
+    std::string filename = pendingFilename_;
+    writing_ = true;
+
+    lock.unlock( );
+
+    std::string error;
+
+    try
+    {
+
+      upCheckpoint->write( filename );
+
+    }
+    catch ( const std::exception &e )
+    {
+
+      error = e.what( );
+
+    }
+
+    lock.lock( );
+
+    writing_ = false;
+
+    if ( !error.empty( ) )
+    {
+      lastError_ = error;
+    }
+
+    condition_.notify_all( );
+
+  }
+
+} // CheckpointWriter::_run
+
+
+
+} // namespace light
@@ -0,0 +1,221 @@
+#ifndef RenderCheckpoint_hpp
+#define RenderCheckpoint_hpp
+
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+
+namespace light
+{
+
+
+///
+/// \brief The CheckpointHeader struct
+///
+///        Fixed size header at the start of a checkpoint file.
+///        Pixel data follows at dataOffset (page aligned) as
+///        layerCount consecutive width * height float4 images
+///        in output buffer order: the output, the direct and
+///        indirect layers if bounceLayers is set, then the
+///        ROULETTE_EFFICIENCY pixel moments (mean, mean square,
+///        0, 0) if rouletteLayer is set.
+///
+struct CheckpointHeader
+{
+  char          magic[ 8 ];
+  std::uint32_t version;
+  std::uint32_t headerBytes;
+
+  std::uint32_t width;
+  std::uint32_t height;
+  std::uint32_t layerCount;      // 1 to 4, see above
+  std::uint32_t pathTracing;
+  std::uint32_t bounceLayers;    // direct and indirect layers follow the output
+  std::uint32_t rouletteLayer;   // roulette moments are the last layer
+
+  std::uint32_t frameNumber;     // next progressive frame to render
+  std::uint32_t frameOffset;     // random sequence offset (distributed renders)
+  std::uint32_t globalSeed;      // per-render random seed
+  std::uint32_t sqrtSamples;
+
+  std::uint64_t samplesPerPixel; // samples already in the accumulated mean
+  std::uint64_t sceneHash;
+  std::uint64_t cameraHash;
+
+  std::uint64_t dataOffset;
+  std::uint64_t dataBytes;
+  std::uint64_t dataChecksum;
+};
+
+
+/////////////////////////////////////////////
+/// \brief The RenderCheckpoint class
+///
+///        In-memory snapshot of a progressive render: the
+///        accumulated radiance layers plus everything needed
+///        to continue the random sequence where it stopped
+/////////////////////////////////////////////
+class RenderCheckpoint
+{
+
+public:
+
+  RenderCheckpoint( );
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief resize
+  ///
+  ///        Sets the image size and layer count and allocates
+  ///        the pixel storage
+  ///////////////////////////////////////////////////////////////
+  void resize (
+               unsigned width,
+               unsigned height,
+               unsigned layerCount
+               );
+
+
+  CheckpointHeader       &getHeader ( )       { return header_; }
+  const CheckpointHeader &getHeader ( ) const { return header_; }
+
+  float       *getLayer ( unsigned layer );
+  const float *getLayer ( unsigned layer ) const;
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief write
+  ///
+  ///        Writes to 'filename.tmp', flushes it to disk and then
+  ///        renames it over 'filename' so a crash mid-write never
+  ///        leaves a truncated checkpoint behind
+  ///////////////////////////////////////////////////////////////
+  void write ( const std::string &filename ) const;
+
+
+private:
+
+  CheckpointHeader header_;
+  std::vector< float > data_;
+
+};
+
+
+
+/////////////////////////////////////////////
+/// \brief The MappedCheckpoint class
+///
+///        Read-only memory mapping of a checkpoint file. The
+///        header and checksum are validated on open; layers are
+///        read straight out of the mapping.
+/////////////////////////////////////////////
+class MappedCheckpoint
+{
+
+public:
+
+  explicit
+  MappedCheckpoint( const std::string &filename );
+
+  ~MappedCheckpoint( );
+
+  MappedCheckpoint( const MappedCheckpoint& )            = delete;
+  MappedCheckpoint &operator=( const MappedCheckpoint& ) = delete;
+
+
+  const CheckpointHeader &getHeader ( ) const;
+
+  const float *getLayer ( unsigned layer ) const;
+
+
+private:
+
+  void _release ( );
+
+  const unsigned char *pData_;
+  std::size_t          bytes_;
+
+#ifdef _WIN32
+  void *fileHandle_;
+  void *mappingHandle_;
+#else
+  int fileDescriptor_;
+#endif
+
+};
+
+
+
+/////////////////////////////////////////////
+/// \brief The CheckpointWriter class
+///
+///        Writes checkpoints on a background thread so the
+///        render loop only pays for copying the buffers out.
+///        If a new checkpoint arrives before the previous one
+///        is written the older one is dropped.
+/////////////////////////////////////////////
+class CheckpointWriter
+{
+
+public:
+
+  CheckpointWriter( );
+
+  ~CheckpointWriter( );
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief submit
+  /// \param checkpoint snapshot to write, taken by value
+  /// \param filename destination
+  ///////////////////////////////////////////////////////////////
+  void submit (
+               RenderCheckpoint   checkpoint,
+               const std::string &filename
+               );
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief wait
+  ///
+  ///        Blocks until every submitted checkpoint is on disk
+  ///////////////////////////////////////////////////////////////
+  void wait ( );
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief getLastError
+  /// \return message from the most recent failed write, if any
+  ///////////////////////////////////////////////////////////////
+  std::string getLastError ( );
+
+
+private:
+
+  void _run ( );
+
+  std::mutex              mutex_;
+  std::condition_variable condition_;
+
+  std::unique_ptr< RenderCheckpoint > upPending_;
+  std::string                         pendingFilename_;
+
+  bool        writing_;
+  bool        stopping_;
+  std::string lastError_;
+
+  std::thread thread_;
+
+};
+
+
+} // namespace light
+
+
+#endif // RenderCheckpoint_hpp
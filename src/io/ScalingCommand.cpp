@@ -0,0 +1,378 @@
+#include "ScalingCommand.hpp"
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <thread>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+#include "glm/glm.hpp"
+#include "graphics/Camera.hpp"
+#include "LightBenderConfig.hpp"
+#include "BuiltinScenes.hpp"
+#include "StressScene.hpp"
+#include "HostScene.hpp"
+#include "HostRenderer.hpp"
+#include "HostTuning.hpp"
+#include "SimdIsa.hpp"
+#include "OptixSceneFactory.hpp"
+
+
+namespace light
+{
+
+
+namespace
+{
+
+
+const std::string scalingFlag = "--scaling";
+
+const char *sceneNames[] = { "basic", "advanced", "model", "file", "stress" };
+
+
+struct ScalingOptions
+{
+  std::vector< int > scenes      = { 0, 1, 2 };
+  std::string        modelFile;
+  unsigned           width       = 320;
+  unsigned           height      = 180;
+  unsigned           sqrtSamples = 2;
+  unsigned           maxThreads  = std::max( 1u, std::thread::hardware_concurrency( ) );
+  unsigned           repeats     = 3;
+  unsigned           tune        = 0;
+  std::string        simd; // forces the SIMD instruction set, overriding tuning and LIGHT_SIMD
+  std::string        output      = "scaling";
+};
+
+
+std::vector< int >
+parseScenes( const std::string &value )
+{
+
+  std::vector< int > scenes;
+  std::stringstream  list( value );
+  std::string        item;
+
+  while ( std::getline( list, item, ',' ) )
+  {
+
+    int scene = std::stoi( item );
+
+    if ( scene < 0 || scene > 4 )
+    {
+
+      throw std::runtime_error( "Scaling scenes are 0 basic, 1 advanced, 2 model, 3 file or 4 stress" );
+
+    }
+
+    scenes.push_back( scene );
+
+  }
+
+  return scenes;
+
+}
+
+
+void
+parseOptions(
+             int             argc,
+             const char    **argv,
+             ScalingOptions *pOptions
+             )
+{
+
+  for ( int i = 2; i < argc; ++i )
+  {
+
+    std::string flag( argv[ i ] );
+
+    if ( i + 1 >= argc )
+    {
+
+      throw std::runtime_error( "Missing value for " + flag );
+
+    }
+
+    std::string value( argv[ ++i ] );
+
+    if      ( flag == "--scenes" )      { pOptions->scenes      = parseScenes( value ); }
+    else if ( flag == "--model" )       { pOptions->modelFile   = value; }
+    else if ( flag == "--width" )       { pOptions->width       = static_cast< unsigned >( std::stoul( value ) ); }
+    else if ( flag == "--height" )      { pOptions->height      = static_cast< unsigned >( std::stoul( value ) ); }
+    else if ( flag == "--samples" )     { pOptions->sqrtSamples = static_cast< unsigned >( std::stoul( value ) ); }
+    else if ( flag == "--max-threads" ) { pOptions->maxThreads  = static_cast< unsigned >( std::stoul( value ) ); }
+    else if ( flag == "--repeats" )     { pOptions->repeats     = static_cast< unsigned >( std::stoul( value ) ); }
+    else if ( flag == "--tune" )        { pOptions->tune        = static_cast< unsigned >( std::stoul( value ) ); }
+    else if ( flag == "--simd" )        { pOptions->simd        = value; }
+    else if ( flag == "--output" )      { pOptions->output      = value; }
+    else
+    {
+
+      throw std::runtime_error( "Unknown option " + flag );
+
+    }
+
+  }
+
+  if ( pOptions->width == 0 || pOptions->height == 0 || pOptions->scenes.empty( ) )
+  {
+
+    throw std::runtime_error( "Scaling runs need an image size and at least one scene" );
+
+  }
+
+  pOptions->maxThreads = std::max( 1u, pOptions->maxThreads );
+
+  if ( !pOptions->simd.empty( ) )
+  {
+    parseSimdIsa( pOptions->simd );
+  }
+
+} // parseOptions
+
+
+SceneDescription
+loadScene(
+          const ScalingOptions &options,
+          int                   sceneType
+          )
+{
+
+  switch ( sceneType )
+  {
+
+  case 0:
+    return buildBasicScene( );
+
+  case 1:
+    return buildAdvancedScene( );
+
+  case 2:
+    return buildModelScene( options.modelFile.empty( ) ? getDefaultModelFile( ) : options.modelFile );
+
+  case 3:
+    return SceneDescription::read( options.modelFile );
+
+  default:
+    return buildStressScene( parseStressSceneOptions( options.modelFile ) );
+
+  } // switch
+
+}
+
+
+Float3
+toFloat3( glm::vec3 v )
+{
+
+  return Float3 { v.x, v.y, v.z };
+
+}
+
+
+void
+setViewerCamera(
+                const ScalingOptions &options,
+                HostRenderer         *pRenderer
+                )
+{
+
+  // same starting view as the viewer and batch renders
+  graphics::Camera camera;
+  camera.setAspectRatio( options.width * 1.0f / options.height );
+  camera.updateOrbit( 20.0f, 45.0f, -30.0f );
+
+  glm::vec3 U, V, W;
+  camera.buildRayBasisVectors( &U, &V, &W );
+
+  pRenderer->setCamera( toFloat3( glm::vec3( camera.getEye( ) ) ), toFloat3( U ), toFloat3( V ), toFloat3( W ) );
+
+}
+
+
+std::string
+tuningFilename( )
+{
+
+  return light::OUTPUT_PATH + "hostTuning_" + getHostName( ) + ".txt";
+
+}
+
+
+} // namespace
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief isScalingCommand
+///////////////////////////////////////////////////////////////
+bool
+isScalingCommand(
+                 int          argc,
+                 const char **argv
+                 )
+{
+
+  return argc > 1 && argv[ 1 ] == scalingFlag;
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief runScalingCommand
+///////////////////////////////////////////////////////////////
+int
+runScalingCommand(
+                  int          argc,
+                  const char **argv
+                  )
+{
+
+  ScalingOptions options;
+  parseOptions( argc, argv, &options );
+
+  HostRenderSettings settings;
+  settings.sqrtSamples = options.sqrtSamples;
+
+  if ( !options.simd.empty( ) )
+  {
+    forceSimdIsa( parseSimdIsa( options.simd ) );
+  }
+
+  //
+  // tuned settings for this machine, measured now or on an earlier run
+  //
+  HostTuning tuning;
+  bool       tuned = false;
+
+  if ( options.tune != 0 )
+  {
+
+    HostScene    scene( loadScene( options, options.scenes.front( ) ) );
+    HostRenderer renderer( scene, options.width, options.height );
+    setViewerCamera( options, &renderer );
+
+    tuning = tuneHostRendering( &renderer, settings, options.maxThreads, options.repeats );
+    tuned  = true;
+
+    writeHostTuning( tuningFilename( ), tuning );
+
+    std::cout << "Tuned on the " << sceneNames[ options.scenes.front( ) ] << " scene, saved to "
+              << tuningFilename( ) << std::endl;
+
+  }
+  else
+  {
+
+    tuned = readHostTuning( tuningFilename( ), &tuning );
+
+  }
+
+  if ( tuned && applyHostTuning( tuning, &settings ) )
+  {
+
+    std::cout << "Host tuning for " << tuning.host << ": " << tuning.numThreads << " threads, "
+              << tuning.tileSize << " pixel tiles, " << toString( tuning.simdIsa ) << " kernels" << std::endl;
+
+  }
+
+  std::cout << "SIMD kernels: " << toString( getSimdIsa( ) ) << std::endl;
+
+  //
+  // every scene at every thread count
+  //
+  std::ostringstream json;
+  json << std::setprecision( 9 );
+
+  json << "{\n";
+  json << "  \"host\": \"" << getHostName( ) << "\",\n";
+  json << "  \"hardwareThreads\": " << std::max( 1u, std::thread::hardware_concurrency( ) ) << ",\n";
+  json << "  \"width\": " << options.width << ",\n";
+  json << "  \"height\": " << options.height << ",\n";
+  json << "  \"samplesPerPixel\": " << options.sqrtSamples * options.sqrtSamples << ",\n";
+  json << "  \"tileSize\": " << settings.tileSize << ",\n";
+  json << "  \"simdIsa\": \"" << toString( getSimdIsa( ) ) << "\",\n";
+  json << "  \"scenes\": [";
+
+  std::vector< unsigned > threadCounts = getScalingThreadCounts( options.maxThreads );
+
+  for ( std::size_t s = 0; s < options.scenes.size( ); ++s )
+  {
+
+    const char *name = sceneNames[ options.scenes[ s ] ];
+
+    HostScene    scene( loadScene( options, options.scenes[ s ] ) );
+    HostRenderer renderer( scene, options.width, options.height );
+    setViewerCamera( options, &renderer );
+
+    std::vector< ScalingResult > results = measureScaling( &renderer, settings, threadCounts, options.repeats );
+
+    std::cout << "\n" << name << " scene\n";
+    std::cout << "threads   ms/frame     samples/s   speedup  efficiency\n";
+
+    json << ( s == 0 ? "\n" : ",\n" )
+         << "    { \"name\": \"" << name << "\", \"results\": [";
+
+    for ( std::size_t r = 0; r < results.size( ); ++r )
+    {
+
+      const ScalingResult &result = results[ r ];
+
+      char line[ 128 ];
+      std::snprintf(
+                    line,
+                    sizeof( line ),
+                    "%7u %10.2f %13.4g %9.2f %10.1f%%\n",
+                    result.numThreads,
+                    result.seconds * 1000.0,
+                    result.samplesPerSecond,
+                    result.speedup,
+                    result.efficiency * 100.0
+                    );
+
+      std::cout << line;
+
+      json << ( r == 0 ? "\n" : ",\n" )
+           << "      { \"threads\": " << result.numThreads
+           << ", \"seconds\": " << result.seconds
+           << ", \"samplesPerSecond\": " << result.samplesPerSecond
+           << ", \"speedup\": " << result.speedup
+           << ", \"efficiency\": " << result.efficiency << " }";
+
+    }
+
+    json << "\n    ] }";
+
+  }
+
+  json << "\n  ]\n";
+  json << "}\n";
+
+  std::string   filename = light::OUTPUT_PATH + options.output + "_scaling.json";
+  std::ofstream file( filename );
+
+  if ( !file.is_open( ) )
+  {
+
+    throw std::runtime_error( "Could not open file for scaling results: " + filename );
+
+  }
+
+  file << json.str( );
+
+  std::cout << "\nResults saved to " << filename << std::endl;
+
+  return EXIT_SUCCESS;
+
+} // runScalingCommand
+
+
+
+} // namespace light
@@ -0,0 +1,54 @@
+#ifndef ScalingCommand_hpp
+#define ScalingCommand_hpp
+
+
+namespace light
+{
+
+
+///////////////////////////////////////////////////////////////
+/// \brief isScalingCommand
+/// \return true if the arguments ask for the thread scaling
+///         benchmark instead of the interactive viewer
+///////////////////////////////////////////////////////////////
+bool isScalingCommand (
+                       int          argc,
+                       const char **argv
+                       );
+
+
+///////////////////////////////////////////////////////////////
+/// \brief runScalingCommand
+///
+///        Renders scenes on the host at 1, 2, 4, ... N threads
+///        and prints seconds per frame, samples/s, speedup and
+///        parallel efficiency for each, also written to
+///        <output>_scaling.json. With --tune 1 it first finds
+///        the fastest thread count and tile size for this
+///        machine and saves them to hostTuning_<host>.txt, which
+///        later runs on the same machine pick up. Needs no GPU.
+///
+///        --scaling [options]
+///            --scenes 0,1,2            0 basic, 1 advanced, 2 model,
+///                                      3 scene file, 4 stress scene
+///            --model file              mesh, scene description or
+///                                      stress scene options
+///            --width W --height H      image size
+///            --samples N               sqrt of samples per pixel
+///            --max-threads N           defaults to every hardware thread
+///            --repeats N               frames per measurement, fastest kept
+///            --tune 0|1                tune and save before measuring
+///            --output name             JSON file prefix
+///
+/// \return process exit code
+///////////////////////////////////////////////////////////////
+int runScalingCommand (
+                       int          argc,
+                       const char **argv
+                       );
+
+
+} // namespace light
+
+
+#endif // ScalingCommand_hpp
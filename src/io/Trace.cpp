@@ -0,0 +1,360 @@
+#include "Trace.hpp"
+#include <map>
+#include <mutex>
+#include <chrono>
+#include <atomic>
+#include <sstream>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+#include <stdexcept>
+
+
+namespace light
+{
+
+
+namespace
+{
+
+
+///
+/// \brief The ThreadEvents struct
+///
+///        One thread's events. Only that thread appends, the
+///        mutex is there for readers and is never contended
+///        while a frame renders.
+///
+struct ThreadEvents
+{
+  std::mutex                mutex;
+  std::vector< TraceEvent > events;
+  unsigned                  thread;
+};
+
+
+///
+/// \brief The TraceRegistry struct
+///
+///        Every live thread's events, plus the events of
+///        threads that already exited
+///
+struct TraceRegistry
+{
+  std::mutex                        mutex;
+  std::vector< ThreadEvents* >      live;
+  std::vector< TraceEvent >         retired;
+  std::map< unsigned, std::string > threadNames;
+  std::atomic< bool >               tracing{ false };
+  std::atomic< std::int64_t >       startTicks{ 0 };
+  std::atomic< unsigned >           nextThread{ 1 };
+};
+
+
+TraceRegistry&
+getRegistry( )
+{
+
+  static TraceRegistry registry;
+  return registry;
+
+}
+
+
+///
+/// \brief The ThreadSlot struct
+///
+///        Registers a thread's events on first use and moves
+///        them to the retired events when the thread exits
+///
+struct ThreadSlot
+{
+
+  ThreadEvents events;
+
+
+  ThreadSlot( )
+  {
+
+    TraceRegistry &registry = getRegistry( );
+
+    events.thread = registry.nextThread.fetch_add( 1 );
+
+    std::lock_guard< std::mutex > lock( registry.mutex );
+    registry.live.push_back( &events );
+
+  }
+
+
+  ~ThreadSlot( )
+  {
+
+    TraceRegistry &registry = getRegistry( );
+
+    std::lock_guard< std::mutex > lock( registry.mutex );
+    std::lock_guard< std::mutex > eventLock( events.mutex );
+
+    registry.retired.insert( registry.retired.end( ), events.events.begin( ), events.events.end( ) );
+    registry.live.erase( std::find( registry.live.begin( ), registry.live.end( ), &events ) );
+
+  }
+
+};
+
+
+ThreadEvents&
+getThreadEvents( )
+{
+
+  thread_local ThreadSlot slot;
+  return slot.events;
+
+}
+
+
+std::int64_t
+nowTicks( )
+{
+
+  return std::chrono::duration_cast< std::chrono::nanoseconds >(
+                                                                std::chrono::steady_clock::now( ).time_since_epoch( )
+                                                                ).count( );
+
+}
+
+
+std::string
+escapeJson( const std::string &text )
+{
+
+  std::string escaped;
+
+  for ( char c : text )
+  {
+
+    if ( c == '"' || c == '\\' )
+    {
+      escaped += '\\';
+    }
+
+    escaped += ( static_cast< unsigned char >( c ) < 0x20 ) ? ' ' : c;
+
+  }
+
+  return escaped;
+
+}
+
+
+} // namespace
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief startTrace
+///////////////////////////////////////////////////////////////
+void
+startTrace( )
+{
+
+  TraceRegistry &registry = getRegistry( );
+
+  std::lock_guard< std::mutex > lock( registry.mutex );
+
+  registry.retired.clear( );
+
+  for ( ThreadEvents *pEvents : registry.live )
+  {
+
+    std::lock_guard< std::mutex > eventLock( pEvents->mutex );
+    pEvents->events.clear( );
+
+  }
+
+  registry.startTicks.store( nowTicks( ) );
+  registry.tracing.store( true );
+
+}
+
+
+
+void
+stopTrace( )
+{
+
+  getRegistry( ).tracing.store( false );
+
+}
+
+
+
+bool
+isTracing( )
+{
+
+  return getRegistry( ).tracing.load( std::memory_order_relaxed );
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief addTraceEvent
+///////////////////////////////////////////////////////////////
+void
+addTraceEvent(
+              const char *name,
+              const char *category,
+              char        phase
+              )
+{
+
+  std::int64_t  elapsed = nowTicks( ) - getRegistry( ).startTicks.load( std::memory_order_relaxed );
+  ThreadEvents &events  = getThreadEvents( );
+
+  TraceEvent event = {
+    name,
+    category,
+    phase,
+    events.thread,
+    static_cast< std::uint64_t >( std::max< std::int64_t >( elapsed, 0 ) )
+  };
+
+  std::lock_guard< std::mutex > lock( events.mutex );
+  events.events.push_back( event );
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief setTraceThreadName
+///////////////////////////////////////////////////////////////
+void
+setTraceThreadName( const std::string &name )
+{
+
+  unsigned       thread   = getThreadEvents( ).thread;
+  TraceRegistry &registry = getRegistry( );
+
+  std::lock_guard< std::mutex > lock( registry.mutex );
+  registry.threadNames[ thread ] = name;
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief getTraceEvents
+///////////////////////////////////////////////////////////////
+std::vector< TraceEvent >
+getTraceEvents( )
+{
+
+  TraceRegistry &registry = getRegistry( );
+
+  std::lock_guard< std::mutex > lock( registry.mutex );
+
+  std::vector< TraceEvent > events = registry.retired;
+
+  for ( ThreadEvents *pEvents : registry.live )
+  {
+
+    std::lock_guard< std::mutex > eventLock( pEvents->mutex );
+    events.insert( events.end( ), pEvents->events.begin( ), pEvents->events.end( ) );
+
+  }
+
+  return events;
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief toTraceJson
+///////////////////////////////////////////////////////////////
+std::string
+toTraceJson( )
+{
+
+  std::vector< TraceEvent > events = getTraceEvents( );
+
+  std::map< unsigned, std::string > threadNames;
+
+  {
+
+    TraceRegistry &registry = getRegistry( );
+
+    std::lock_guard< std::mutex > lock( registry.mutex );
+    threadNames = registry.threadNames;
+
+  }
+
+  std::ostringstream json;
+  json << std::fixed << std::setprecision( 3 );
+
+  json << "{\n";
+  json << "  \"displayTimeUnit\": \"ms\",\n";
+  json << "  \"traceEvents\": [";
+
+  bool first = true;
+
+  for ( const auto &threadName : threadNames )
+  {
+
+    json << ( first ? "\n" : ",\n" )
+         << "    { \"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << threadName.first
+         << ", \"args\": { \"name\": \"" << escapeJson( threadName.second ) << "\" } }";
+
+    first = false;
+
+  }
+
+  for ( const TraceEvent &event : events )
+  {
+
+    // timestamps are microseconds
+    json << ( first ? "\n" : ",\n" )
+         << "    { \"name\": \"" << escapeJson( event.name ) << "\""
+         << ", \"cat\": \"" << escapeJson( event.category ) << "\""
+         << ", \"ph\": \"" << event.phase << "\""
+         << ", \"ts\": " << static_cast< double >( event.nanoseconds ) * 1e-3
+         << ", \"pid\": 1, \"tid\": " << event.thread << " }";
+
+    first = false;
+
+  }
+
+  json << "\n  ]\n";
+  json << "}\n";
+
+  return json.str( );
+
+} // toTraceJson
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief writeTraceJson
+///////////////////////////////////////////////////////////////
+void
+writeTraceJson( const std::string &filename )
+{
+
+  std::ofstream file( filename );
+
+  if ( !file.is_open( ) )
+  {
+
+    throw std::runtime_error( "Could not open file for writeTraceJson: " + filename );
+
+  }
+
+  file << toTraceJson( );
+
+}
+
+
+
+} // namespace light
@@ -0,0 +1,152 @@
+#ifndef Trace_hpp
+#define Trace_hpp
+
+
+#include <string>
+#include <cstdint>
+#include <vector>
+
+
+namespace light
+{
+
+
+/////////////////////////////////////////////
+/// \brief The TraceEvent struct
+///
+///        One begin ('B') or end ('E') event of a traced
+///        scope. Names and categories are string literals.
+/////////////////////////////////////////////
+struct TraceEvent
+{
+  const char   *name;
+  const char   *category;
+  char          phase;
+  unsigned      thread;      // small id in order of first use
+  std::uint64_t nanoseconds; // since startTrace
+};
+
+
+///////////////////////////////////////////////////////////////
+/// \brief startTrace
+///
+///        Drops earlier events and starts recording. Until
+///        then scopes only check a flag.
+///////////////////////////////////////////////////////////////
+void startTrace ( );
+
+void stopTrace ( );
+
+bool isTracing ( );
+
+
+///////////////////////////////////////////////////////////////
+/// \brief addTraceEvent
+///
+///        Appends to the calling thread's own event list
+///////////////////////////////////////////////////////////////
+void addTraceEvent (
+                    const char *name,
+                    const char *category,
+                    char        phase
+                    );
+
+
+///////////////////////////////////////////////////////////////
+/// \brief setTraceThreadName
+///
+///        Label shown for the calling thread in the timeline
+///////////////////////////////////////////////////////////////
+void setTraceThreadName ( const std::string &name );
+
+
+///////////////////////////////////////////////////////////////
+/// \brief getTraceEvents
+/// \return events of every thread, each thread's in order
+///////////////////////////////////////////////////////////////
+std::vector< TraceEvent > getTraceEvents ( );
+
+
+///////////////////////////////////////////////////////////////
+/// \brief toTraceJson
+///
+///        Chrome trace event format, opens in chrome://tracing
+///        and ui.perfetto.dev
+///////////////////////////////////////////////////////////////
+std::string toTraceJson ( );
+
+void writeTraceJson ( const std::string &filename );
+
+
+/////////////////////////////////////////////
+/// \brief The TraceScope class
+///
+///        Begin event now, end event when destroyed. Use
+///        through LIGHT_TRACE_SCOPE so it compiles away.
+/////////////////////////////////////////////
+class TraceScope
+{
+
+public:
+
+  TraceScope(
+             const char *name,
+             const char *category
+             )
+    : name_    ( name )
+    , category_( category )
+    , active_  ( isTracing( ) )
+  {
+
+    if ( active_ )
+    {
+      addTraceEvent( name_, category_, 'B' );
+    }
+
+  }
+
+
+  // a scope that began while tracing always ends, so begin and end pair up
+  ~TraceScope( )
+  {
+
+    if ( active_ )
+    {
+      addTraceEvent( name_, category_, 'E' );
+    }
+
+  }
+
+  TraceScope( const TraceScope& )            = delete;
+  TraceScope &operator=( const TraceScope& ) = delete;
+
+
+private:
+
+  const char *name_;
+  const char *category_;
+  bool        active_;
+
+};
+
+
+} // namespace light
+
+
+
+#ifdef LIGHT_INSTRUMENTATION
+
+#define LIGHT_TRACE_JOIN_( a, b ) a ## b
+#define LIGHT_TRACE_JOIN( a, b )  LIGHT_TRACE_JOIN_( a, b )
+
+#define LIGHT_TRACE_SCOPE( name, category ) \
+  ::light::TraceScope LIGHT_TRACE_JOIN( lightTraceScope, __LINE__ )( name, category )
+
+#else
+
+#define LIGHT_TRACE_SCOPE( name, category ) static_cast< void >( 0 )
+
+#endif
+
+
+#endif // Trace_hpp
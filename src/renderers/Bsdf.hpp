@@ -0,0 +1,152 @@
+#ifndef Bsdf_hpp
+#define Bsdf_hpp
+
+
+//
+// The Fresnel and diffuse terms of closest_hit_bsdf, shared by the
+// device programs and the host path tracer. Together with the GGX
+// lobe in Microfacet.hpp they make up the bsdf: a dielectric
+// coating reflecting F over an Oren-Nayar base that gets the
+// remaining 1 - F. Per channel functions take scalars; the vector
+// versions work on any type with x, y and z members.
+//
+#include "FastMath.hpp"
+#include "Sampling.hpp"
+
+
+
+///
+/// \brief refractedCosine
+///
+///        dot( -n, refract( -v, n, eta ) ) without building the
+///        refracted vector; 0 on total internal reflection
+///
+/// \param cosNV cosine between the normal and view vector
+/// \param eta   ratio of indices of refraction
+///
+FAST_MATH_FUNC
+float
+refractedCosine(
+                float cosNV,
+                float eta
+                )
+{
+
+  float k = 1.0f - eta * eta * ( 1.0f - cosNV * cosNV );
+
+  return k < 0.0f ? 0.0f : sqrtf( k );
+
+}
+
+
+///
+/// \brief dielectricFresnel
+///
+///        Unpolarized Fresnel reflectance of light arriving from
+///        air at cos( theta ) = cosI on a dielectric of index ior
+///
+FAST_MATH_FUNC
+float
+dielectricFresnel(
+                  float cosI,
+                  float ior
+                  )
+{
+
+  float cosT = refractedCosine( cosI, 1.0f / ior );
+
+  float rs = ( cosI - ior * cosT ) / ( cosI + ior * cosT );
+  float rp = ( cosT - ior * cosI ) / ( cosT + ior * cosI );
+
+  return ( rs * rs + rp * rp ) * 0.5f;
+
+}
+
+
+///
+/// \brief dielectricFresnel
+/// \return dielectricFresnel for each RGB index of refraction
+///
+template< typename Vector >
+FAST_MATH_FUNC
+Vector
+dielectricFresnel(
+                  float         cosI,
+                  const Vector &ior
+                  )
+{
+
+  Vector result;
+  result.x = dielectricFresnel( cosI, ior.x );
+  result.y = dielectricFresnel( cosI, ior.y );
+  result.z = dielectricFresnel( cosI, ior.z );
+
+  return result;
+
+}
+
+
+///
+/// \brief orenNayarDiffuse
+///
+///        Oren-Nayar reflection of one channel, the qualitative
+///        model with the roughness as sigma. The albedo also
+///        enters A, as in the original bsdf program.
+///
+/// \param cosLV cosine between the light and view directions
+///
+FAST_MATH_FUNC
+float
+orenNayarDiffuse(
+                 float albedo,
+                 float roughness,
+                 float cosNL,
+                 float cosNV,
+                 float cosLV
+                 )
+{
+
+  float sigma2 = roughness * roughness;
+
+  float s = cosLV - cosNL * cosNV;
+  float t = s <= 0.0f ? 1.0f : fmaxf( cosNL, cosNV );
+
+  float A = ( 1.0f
+             - 0.5f  * ( sigma2 / ( sigma2 + 0.33f ) )
+             + 0.17f * ( sigma2 / ( sigma2 + 0.13f ) ) * albedo
+             ) * SAMPLING_INV_PI;
+
+  float B = 0.45f * ( sigma2 / ( sigma2 + 0.09f ) ) * SAMPLING_INV_PI;
+
+  return albedo * ( A + B * s / t );
+
+}
+
+
+///
+/// \brief orenNayarDiffuse
+/// \return orenNayarDiffuse for each RGB albedo
+///
+template< typename Vector >
+FAST_MATH_FUNC
+Vector
+orenNayarDiffuse(
+                 const Vector &albedo,
+                 float         roughness,
+                 float         cosNL,
+                 float         cosNV,
+                 float         cosLV
+                 )
+{
+
+  Vector result;
+  result.x = orenNayarDiffuse( albedo.x, roughness, cosNL, cosNV, cosLV );
+  result.y = orenNayarDiffuse( albedo.y, roughness, cosNL, cosNV, cosLV );
+  result.z = orenNayarDiffuse( albedo.z, roughness, cosNL, cosNV, cosLV );
+
+  return result;
+
+}
+
+
+#endif // Bsdf_hpp
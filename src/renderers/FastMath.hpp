@@ -0,0 +1,350 @@
+#ifndef FastMath_hpp
+#define FastMath_hpp
+
+
+//
+// Precise and fast variants of the transcendental functions
+// used in shading, shared by the device programs and the host.
+// The fast variants are range reductions plus short minimax
+// polynomials or bit tricks; each states its maximum error over
+// its documented domain, which FastMathUnitTests checks. Inputs
+// outside a domain (NaN, infinities, denormals) aren't handled.
+//
+#include <math.h>
+#include <string.h>
+
+
+#ifdef __CUDACC__
+#define FAST_MATH_FUNC static __host__ __device__ __inline__
+#else
+#define FAST_MATH_FUNC static inline
+#endif
+
+
+// 2^f on [-0.5, 0.5], relative error 2.6e-6
+#define FAST_EXP2_C0 0.9999992614f
+#define FAST_EXP2_C1 0.6931218147f
+#define FAST_EXP2_C2 0.2402474483f
+#define FAST_EXP2_C3 0.0559178603f
+#define FAST_EXP2_C4 0.0095701019f
+
+// log2( 1 + t ) / t on [sqrt( 0.5 ) - 1, sqrt( 2 ) - 1], absolute error 1.1e-5
+#define FAST_LOG2_C0  1.4427030287f
+#define FAST_LOG2_C1 -0.7212235245f
+#define FAST_LOG2_C2  0.4796711197f
+#define FAST_LOG2_C3 -0.3658550129f
+#define FAST_LOG2_C4  0.3198278792f
+#define FAST_LOG2_C5 -0.2115358806f
+
+// acos( x ) / sqrt( 1 - x ) on [0, 1], Abramowitz and Stegun 4.4.45
+#define FAST_ACOS_C0  1.5707288f
+#define FAST_ACOS_C1 -0.2121144f
+#define FAST_ACOS_C2  0.0742610f
+#define FAST_ACOS_C3 -0.0187293f
+
+// rsqrt seed and the single Newton step tuned with it (Moroz et al. 2018)
+#define FAST_RSQRT_MAGIC 0x5f1ffff9
+#define FAST_RSQRT_A     0.703952253f
+#define FAST_RSQRT_B     2.38924456f
+
+#define FAST_LOG2E 1.44269504089f
+#define FAST_PI    3.14159265359f
+
+
+///
+/// \brief The MathPrecision enum
+///
+///        Picks the variant behind the math* functions. Preview
+///        renders use MATH_FAST, final renders MATH_PRECISE.
+///
+enum MathPrecision
+{
+  MATH_PRECISE, // the C library (or CUDA's accurate) functions
+  MATH_FAST     // the approximations below
+};
+
+
+
+FAST_MATH_FUNC
+int
+fastFloatBits( float x )
+{
+
+#ifdef __CUDA_ARCH__
+  return __float_as_int( x );
+#else
+  int bits;
+  memcpy( &bits, &x, sizeof( bits ) );
+  return bits;
+#endif
+
+}
+
+
+FAST_MATH_FUNC
+float
+fastBitsFloat( int bits )
+{
+
+#ifdef __CUDA_ARCH__
+  return __int_as_float( bits );
+#else
+  float x;
+  memcpy( &x, &bits, sizeof( x ) );
+  return x;
+#endif
+
+}
+
+
+
+///
+/// \brief fastExp2
+///
+///        2^x for x in [-126, 127], relative error below 3e-6.
+///        Inputs are clamped to that range, so large negative
+///        x give about 1e-38 instead of 0.
+///
+FAST_MATH_FUNC
+float
+fastExp2( float x )
+{
+
+  x = fminf( fmaxf( x, -126.0f ), 127.0f );
+
+  float n = floorf( x + 0.5f );
+  float f = x - n;
+
+  float p = FAST_EXP2_C4;
+  p = p * f + FAST_EXP2_C3;
+  p = p * f + FAST_EXP2_C2;
+  p = p * f + FAST_EXP2_C1;
+  p = p * f + FAST_EXP2_C0;
+
+  // 2^n built directly in the exponent field
+  return p * fastBitsFloat( ( static_cast< int >( n ) + 127 ) << 23 );
+
+}
+
+
+///
+/// \brief fastExp
+///
+///        e^x for x in [-87, 88], relative error below 1e-5
+///        (the rounding of x * log2(e) grows with |x|)
+///
+FAST_MATH_FUNC
+float
+fastExp( float x )
+{
+
+  return fastExp2( x * FAST_LOG2E );
+
+}
+
+
+///
+/// \brief fastLog2
+///
+///        log2( x ) for positive normal x, absolute error below
+///        1e-5 and exactly 0 at x = 1
+///
+FAST_MATH_FUNC
+float
+fastLog2( float x )
+{
+
+  int bits     = fastFloatBits( x );
+  int exponent = ( ( bits >> 23 ) & 0xff ) - 127;
+
+  // mantissa in [1, 2), moved to [sqrt( 0.5 ), sqrt( 2 ) ) around 1
+  float m = fastBitsFloat( ( bits & 0x007fffff ) | 0x3f800000 );
+
+  if ( m > 1.41421356f )
+  {
+
+    m *= 0.5f;
+    ++exponent;
+
+  }
+
+  float t = m - 1.0f;
+
+  float q = FAST_LOG2_C5;
+  q = q * t + FAST_LOG2_C4;
+  q = q * t + FAST_LOG2_C3;
+  q = q * t + FAST_LOG2_C2;
+  q = q * t + FAST_LOG2_C1;
+  q = q * t + FAST_LOG2_C0;
+
+  return static_cast< float >( exponent ) + t * q;
+
+}
+
+
+///
+/// \brief fastPow
+///
+///        x^y as 2^( y log2 x ) for x > 0 and 0 for x <= 0. The
+///        relative error is below 3e-6 + 7e-6 |y| while the
+///        result stays within fastExp2's range.
+///
+FAST_MATH_FUNC
+float
+fastPow(
+        float x,
+        float y
+        )
+{
+
+  return x > 0.0f ? fastExp2( y * fastLog2( x ) ) : 0.0f;
+
+}
+
+
+///
+/// \brief fastRsqrt
+///
+///        1 / sqrt( x ) for positive normal x from the bit level
+///        seed and one tuned Newton step, relative error below
+///        6.6e-4
+///
+FAST_MATH_FUNC
+float
+fastRsqrt( float x )
+{
+
+  float y = fastBitsFloat( FAST_RSQRT_MAGIC - ( fastFloatBits( x ) >> 1 ) );
+
+  return y * FAST_RSQRT_A * ( FAST_RSQRT_B - x * y * y );
+
+}
+
+
+///
+/// \brief fastAcos
+///
+///        acos( x ) for x in [-1, 1], absolute error below 7e-5
+///        radians
+///
+FAST_MATH_FUNC
+float
+fastAcos( float x )
+{
+
+  float a = fabsf( x );
+
+  float p = FAST_ACOS_C3;
+  p = p * a + FAST_ACOS_C2;
+  p = p * a + FAST_ACOS_C1;
+  p = p * a + FAST_ACOS_C0;
+
+  float angle = p * sqrtf( fmaxf( 1.0f - a, 0.0f ) );
+
+  return x < 0.0f ? FAST_PI - angle : angle;
+
+}
+
+
+///
+/// \brief fastNormalize
+///
+///        Any vector with x, y and z members; the length of the
+///        result is within 6.6e-4 of 1
+///
+template< typename Vector >
+FAST_MATH_FUNC
+Vector
+fastNormalize( Vector v )
+{
+
+  float scale = fastRsqrt( v.x * v.x + v.y * v.y + v.z * v.z );
+
+  v.x *= scale;
+  v.y *= scale;
+  v.z *= scale;
+
+  return v;
+
+}
+
+
+
+//
+// Policy selected variants. The precision is usually a launch
+// wide variable, so branches on it don't diverge.
+//
+FAST_MATH_FUNC
+float
+mathExp(
+        float         x,
+        MathPrecision precision
+        )
+{
+
+  return precision == MATH_FAST ? fastExp( x ) : expf( x );
+
+}
+
+
+FAST_MATH_FUNC
+float
+mathPow(
+        float         x,
+        float         y,
+        MathPrecision precision
+        )
+{
+
+  return precision == MATH_FAST ? fastPow( x, y ) : powf( x, y );
+
+}
+
+
+FAST_MATH_FUNC
+float
+mathRsqrt(
+          float         x,
+          MathPrecision precision
+          )
+{
+
+  return precision == MATH_FAST ? fastRsqrt( x ) : 1.0f / sqrtf( x );
+
+}
+
+
+FAST_MATH_FUNC
+float
+mathAcos(
+         float         x,
+         MathPrecision precision
+         )
+{
+
+  return precision == MATH_FAST ? fastAcos( x ) : acosf( x );
+
+}
+
+
+template< typename Vector >
+FAST_MATH_FUNC
+Vector
+mathNormalize(
+              Vector        v,
+              MathPrecision precision
+              )
+{
+
+  float scale = mathRsqrt( v.x * v.x + v.y * v.y + v.z * v.z, precision );
+
+  v.x *= scale;
+  v.y *= scale;
+  v.z *= scale;
+
+  return v;
+
+}
+
+
+#endif // FastMath_hpp
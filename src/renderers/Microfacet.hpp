@@ -0,0 +1,186 @@
+#ifndef Microfacet_hpp
+#define Microfacet_hpp
+
+
+//
+// GGX (Trowbridge-Reitz) microfacet reflection with the height
+// correlated Smith masking-shadowing term, shared by the device
+// programs and the host. Directions are in a local frame around
+// the normal (+z) and point away from the surface. Fresnel is
+// left to the caller, which knows the material's indices.
+//
+#include "Sampling.hpp"
+
+
+// roughness below this makes D overflow float for mirror-like
+// reflections; such surfaces behave as mirrors anyway
+#define GGX_MIN_ALPHA 1.0e-3f
+
+
+
+///
+/// \brief ggxAlpha
+/// \return the GGX alpha for a material roughness
+///
+FAST_MATH_FUNC
+float
+ggxAlpha( float roughness )
+{
+
+  return fmaxf( roughness, GGX_MIN_ALPHA );
+
+}
+
+
+///
+/// \brief ggxSmithLambdaTerm
+/// \return sqrt( alpha^2 + ( 1 - alpha^2 ) cos^2 ), the part of
+///         the Smith terms shared by G1 and G2
+///
+FAST_MATH_FUNC
+float
+ggxSmithLambdaTerm(
+                   float cosTheta,
+                   float alpha
+                   )
+{
+
+  float alpha2 = alpha * alpha;
+
+  return sqrtf( alpha2 + ( 1.0f - alpha2 ) * cosTheta * cosTheta );
+
+}
+
+
+///
+/// \brief ggxSmithG2
+///
+///        Height correlated masking-shadowing of the view and
+///        light directions (Heitz 2014)
+///
+FAST_MATH_FUNC
+float
+ggxSmithG2(
+           float cosNV,
+           float cosNL,
+           float alpha
+           )
+{
+
+  return 2.0f * cosNV * cosNL
+         / ( cosNL * ggxSmithLambdaTerm( cosNV, alpha ) + cosNV * ggxSmithLambdaTerm( cosNL, alpha ) );
+
+}
+
+
+///
+/// \brief ggxReflection
+///
+///        D G2 / ( 4 cos( theta_v ) cos( theta_l ) ), the GGX
+///        reflection without Fresnel; 0 unless both directions
+///        are above the surface
+///
+FAST_MATH_FUNC
+float
+ggxReflection(
+              float cosNV,
+              float cosNL,
+              float cosNH,
+              float alpha
+              )
+{
+
+  if ( cosNV <= 0.0f || cosNL <= 0.0f )
+  {
+    return 0.0f;
+  }
+
+  float visibility = 0.5f / ( cosNL * ggxSmithLambdaTerm( cosNV, alpha ) + cosNV * ggxSmithLambdaTerm( cosNL, alpha ) );
+
+  return ggxD( cosNH, alpha ) * visibility;
+
+}
+
+
+///
+/// \brief sampleGgxReflection
+/// \return the view direction v mirrored about a visible normal
+///         (sampleGgxVndf). It can end up below the surface,
+///         where single scattering loses the light.
+///
+template< typename Vector >
+FAST_MATH_FUNC
+Vector
+sampleGgxReflection(
+                    const Vector &v,
+                    float         alpha,
+                    float         u1,
+                    float         u2
+                    )
+{
+
+  Vector h = sampleGgxVndf( v, alpha, u1, u2 );
+
+  float twoCosVH = 2.0f * ( v.x * h.x + v.y * h.y + v.z * h.z );
+
+  Vector l;
+  l.x = twoCosVH * h.x - v.x;
+  l.y = twoCosVH * h.y - v.y;
+  l.z = twoCosVH * h.z - v.z;
+
+  return l;
+
+}
+
+
+///
+/// \brief ggxReflectionPdf
+///
+///        Density of sampleGgxReflection's direction per solid
+///        angle: the visible normal density over the
+///        4 cos( theta_vh ) Jacobian of the reflection
+///
+FAST_MATH_FUNC
+float
+ggxReflectionPdf(
+                 float cosNV,
+                 float cosNH,
+                 float alpha
+                 )
+{
+
+  return ggxSmithG1( cosNV, alpha ) * ggxD( cosNH, alpha ) / ( 4.0f * cosNV );
+
+}
+
+
+///
+/// \brief ggxReflectionWeight
+///
+///        ggxReflection * cos( theta_l ) / ggxReflectionPdf for a
+///        sampled direction, which reduces to G2 / G1( v ). The
+///        throughput scale of a path that sampled the lobe,
+///        times Fresnel.
+///
+FAST_MATH_FUNC
+float
+ggxReflectionWeight(
+                    float cosNV,
+                    float cosNL,
+                    float alpha
+                    )
+{
+
+  if ( cosNV <= 0.0f || cosNL <= 0.0f )
+  {
+    return 0.0f;
+  }
+
+  float lambdaV = ggxSmithLambdaTerm( cosNV, alpha );
+
+  return cosNL * ( cosNV + lambdaV ) / ( cosNL * lambdaV + cosNV * ggxSmithLambdaTerm( cosNL, alpha ) );
+
+}
+
+
+#endif // Microfacet_hpp
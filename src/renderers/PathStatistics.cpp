@@ -0,0 +1,259 @@
+#include "PathStatistics.hpp"
+#include <sstream>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+#include <stdexcept>
+
+
+namespace light
+{
+
+
+namespace
+{
+
+
+const char *terminationNames[ pathTerminationCount ] = {
+  "absorbed",
+  "missed",
+  "maxBounces",
+  "emitted"
+};
+
+
+} // namespace
+
+
+
+const char*
+getPathTerminationName( PathTermination termination )
+{
+
+  return terminationNames[ static_cast< unsigned >( termination ) ];
+
+}
+
+
+
+PathStatistics::PathStatistics( )
+  : throughputSum ( 0.0 )
+  , shadowRays    ( 0 )
+  , shadowOccluded( 0 )
+{
+
+  std::fill( std::begin( lengths ),      std::end( lengths ),      0 );
+  std::fill( std::begin( terminations ), std::end( terminations ), 0 );
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief PathStatistics::addSlots
+///////////////////////////////////////////////////////////////
+void
+PathStatistics::addSlots( const std::uint64_t *pSlots )
+{
+
+  for ( unsigned slot = 0; slot < PATH_STATS_SLOTS; ++slot )
+  {
+
+    const std::uint64_t *pFields = pSlots + slot * PATH_STATS_FIELDS;
+
+    for ( unsigned i = 0; i < PATH_STATS_MAX_LENGTH; ++i )
+    {
+      lengths[ i ] += pFields[ i ];
+    }
+
+    for ( unsigned i = 0; i < pathTerminationCount; ++i )
+    {
+      terminations[ i ] += pFields[ PATH_STATS_ABSORBED + i ];
+    }
+
+    throughputSum  += static_cast< double >( pFields[ PATH_STATS_THROUGHPUT ] ) / PATH_STATS_FIXED_ONE;
+    shadowRays     += pFields[ PATH_STATS_SHADOW_RAYS ];
+    shadowOccluded += pFields[ PATH_STATS_SHADOW_OCCLUDED ];
+
+  }
+
+}
+
+
+
+void
+PathStatistics::merge( const PathStatistics &other )
+{
+
+  for ( unsigned i = 0; i < PATH_STATS_MAX_LENGTH; ++i )
+  {
+    lengths[ i ] += other.lengths[ i ];
+  }
+
+  for ( unsigned i = 0; i < pathTerminationCount; ++i )
+  {
+    terminations[ i ] += other.terminations[ i ];
+  }
+
+  throughputSum  += other.throughputSum;
+  shadowRays     += other.shadowRays;
+  shadowOccluded += other.shadowOccluded;
+
+}
+
+
+
+std::uint64_t
+PathStatistics::getPathCount( ) const
+{
+
+  std::uint64_t count = 0;
+
+  for ( std::uint64_t paths : lengths )
+  {
+    count += paths;
+  }
+
+  return count;
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief PathStatistics::getMeanLength
+///
+///        Paths in the last bin count as its length, so this
+///        is a lower bound when that bin is used
+///////////////////////////////////////////////////////////////
+double
+PathStatistics::getMeanLength( ) const
+{
+
+  std::uint64_t paths    = getPathCount( );
+  double        segments = 0.0;
+
+  for ( unsigned i = 0; i < PATH_STATS_MAX_LENGTH; ++i )
+  {
+    segments += static_cast< double >( lengths[ i ] ) * ( i + 1 );
+  }
+
+  return paths > 0 ? segments / static_cast< double >( paths ) : 0.0;
+
+}
+
+
+
+double
+PathStatistics::getMeanThroughput( ) const
+{
+
+  std::uint64_t paths = getPathCount( );
+
+  return paths > 0 ? throughputSum / static_cast< double >( paths ) : 0.0;
+
+}
+
+
+
+double
+PathStatistics::getOcclusionRate( ) const
+{
+
+  return shadowRays > 0 ? static_cast< double >( shadowOccluded ) / static_cast< double >( shadowRays ) : 0.0;
+
+}
+
+
+
+double
+PathStatistics::getFraction( PathTermination termination ) const
+{
+
+  std::uint64_t paths = getPathCount( );
+
+  return paths > 0
+         ? static_cast< double >( terminations[ static_cast< unsigned >( termination ) ] ) / static_cast< double >( paths )
+         : 0.0;
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief toJson
+///////////////////////////////////////////////////////////////
+std::string
+toJson( const PathStatistics &statistics )
+{
+
+  std::ostringstream json;
+  json << std::setprecision( 9 );
+
+  json << "{\n";
+  json << "  \"paths\": " << statistics.getPathCount( ) << ",\n";
+  json << "  \"meanLength\": " << statistics.getMeanLength( ) << ",\n";
+
+  json << "  \"lengthHistogram\": [";
+
+  for ( unsigned i = 0; i < PATH_STATS_MAX_LENGTH; ++i )
+  {
+    json << ( i > 0 ? ", " : " " ) << statistics.lengths[ i ];
+  }
+
+  json << " ],\n";
+
+  json << "  \"terminations\": {\n";
+
+  for ( unsigned i = 0; i < pathTerminationCount; ++i )
+  {
+
+    PathTermination termination = static_cast< PathTermination >( i );
+
+    json << "    \"" << getPathTerminationName( termination ) << "\": { "
+         << "\"paths\": " << statistics.terminations[ i ] << ", "
+         << "\"fraction\": " << statistics.getFraction( termination )
+         << " }" << ( i + 1 < pathTerminationCount ? "," : "" ) << "\n";
+
+  }
+
+  json << "  },\n";
+
+  json << "  \"meanThroughput\": " << statistics.getMeanThroughput( ) << ",\n";
+  json << "  \"shadowRays\": " << statistics.shadowRays << ",\n";
+  json << "  \"shadowOccluded\": " << statistics.shadowOccluded << ",\n";
+  json << "  \"occlusionRate\": " << statistics.getOcclusionRate( ) << "\n";
+  json << "}\n";
+
+  return json.str( );
+
+} // toJson
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief writePathStatisticsJson
+///////////////////////////////////////////////////////////////
+void
+writePathStatisticsJson(
+                        const std::string    &filename,
+                        const PathStatistics &statistics
+                        )
+{
+
+  std::ofstream file( filename );
+
+  if ( !file.is_open( ) )
+  {
+
+    throw std::runtime_error( "Could not open file for writePathStatisticsJson: " + filename );
+
+  }
+
+  file << toJson( statistics );
+
+}
+
+
+
+} // namespace light
@@ -0,0 +1,116 @@
+#ifndef PathStatistics_hpp
+#define PathStatistics_hpp
+
+
+//
+// Layout of the path statistics buffer shared by the path
+// tracing cameras and the host. Each launch index keeps its
+// own counters while it traces and adds them once to one of
+// PATH_STATS_SLOTS slots so atomics rarely collide; the host
+// sums the slots.
+//
+#define PATH_STATS_MAX_LENGTH 16   // histogram bins, the last one also holds longer paths
+#define PATH_STATS_SLOTS      64
+#define PATH_STATS_FIXED_ONE  65536.0f // throughput is summed in 16.16 fixed point
+
+enum PathStatsField
+{
+  PATH_STATS_ABSORBED = PATH_STATS_MAX_LENGTH, // roulette chose neither scatter nor reflect
+  PATH_STATS_MISSED,                           // left the scene
+  PATH_STATS_MAX_BOUNCES,                      // cut off at max_bounces
+  PATH_STATS_EMITTED,                          // hit a light
+  PATH_STATS_THROUGHPUT,                       // mean RGB throughput when the path ended
+  PATH_STATS_SHADOW_RAYS,
+  PATH_STATS_SHADOW_OCCLUDED,
+  PATH_STATS_FIELDS
+};
+
+
+#ifndef __CUDACC__
+
+
+#include <string>
+#include <cstdint>
+
+
+namespace light
+{
+
+
+/////////////////////////////////////////////
+/// \brief The PathTermination enum
+/////////////////////////////////////////////
+enum class PathTermination : unsigned
+{
+  ABSORBED,
+  MISSED,
+  MAX_BOUNCES,
+  EMITTED,
+  COUNT
+};
+
+
+constexpr unsigned pathTerminationCount = static_cast< unsigned >( PathTermination::COUNT );
+
+
+const char *getPathTerminationName ( PathTermination termination );
+
+
+/////////////////////////////////////////////
+/// \brief The PathStatistics struct
+///
+///        How path traced samples ended, merged over every
+///        slot of the device statistics buffer
+/////////////////////////////////////////////
+struct PathStatistics
+{
+
+  std::uint64_t lengths[ PATH_STATS_MAX_LENGTH ]; ///< paths of 1, 2, ... segments
+  std::uint64_t terminations[ pathTerminationCount ];
+  double        throughputSum;
+  std::uint64_t shadowRays;
+  std::uint64_t shadowOccluded;
+
+
+  PathStatistics( );
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief addSlots
+  /// \param pSlots PATH_STATS_SLOTS * PATH_STATS_FIELDS values
+  ///        laid out as the device writes them
+  ///////////////////////////////////////////////////////////////
+  void addSlots ( const std::uint64_t *pSlots );
+
+  void merge ( const PathStatistics &other );
+
+
+  std::uint64_t getPathCount ( ) const;
+
+  double getMeanLength ( ) const;
+  double getMeanThroughput ( ) const;
+  double getOcclusionRate ( ) const;
+  double getFraction ( PathTermination termination ) const;
+
+};
+
+
+///////////////////////////////////////////////////////////////
+/// \brief toJson
+///////////////////////////////////////////////////////////////
+std::string toJson ( const PathStatistics &statistics );
+
+
+void writePathStatisticsJson (
+                              const std::string    &filename,
+                              const PathStatistics &statistics
+                              );
+
+
+} // namespace light
+
+
+#endif // __CUDACC__
+
+
+#endif // PathStatistics_hpp
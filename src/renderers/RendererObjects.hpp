@@ -146,5 +146,15 @@ struct PerRayData_pathtrace
   int inside;
   int useSpecular;
 
+  // path statistics, see PathStatistics.hpp
+  int      terminated;     // PATH_STATS_* reason once done is set
+  unsigned shadowRays;
+  unsigned shadowOccluded;
+
+  // path termination, see Roulette.hpp
+  float rouletteScale; // rouletteEfficiencyScale of the path's pixel
+  int   splitBranch;   // re-entering the first hit for another first bounce split
+  int   bounced;       // a hit picked the next direction, even if the path then ended
+
 };
 
@@ -0,0 +1,218 @@
+#ifndef Roulette_hpp
+#define Roulette_hpp
+
+
+//
+// Russian roulette policies for ending paths, shared by the
+// device programs and the host. A policy gives the probability
+// that a path survives a bounce; survivors divide their
+// throughput by it, so every policy is unbiased and they only
+// differ in the variance and time they trade.
+//
+#include "FastMath.hpp"
+
+
+// converged pixels would otherwise never end a path early
+#define ROULETTE_MAX_SCALE 8.0f
+
+
+
+///
+/// \brief The RoulettePolicy enum
+///
+enum RoulettePolicy
+{
+  ROULETTE_ALBEDO,     // ends paths while picking a lobe, by the lobes' mean weights
+  ROULETTE_THROUGHPUT, // survive with the path throughput
+  ROULETTE_EFFICIENCY  // survive with the throughput scaled for variance per unit time
+};
+
+
+
+///
+/// \brief rouletteEfficiencyScale
+///
+///        Ending a path of throughput t with probability 1 - q
+///        adds t^2 M ( 1 / q - 1 ) to a pixel's variance V and
+///        saves ( 1 - q ) C of the sample's cost T, where M and C
+///        are the second moment and cost of the rest of the path.
+///        ( V + t^2 M / q ) ( T + q C ) is smallest at
+///        q = t sqrt( M T / ( V C ) ). Taking the rest of a path
+///        to cost and scatter about as much as a whole sample
+///        (T ~ C, M ~ V + mean^2) leaves q = t times this scale.
+///
+/// \param mean     mean of the pixel's samples
+/// \param variance variance of a single sample
+///
+FAST_MATH_FUNC
+float
+rouletteEfficiencyScale(
+                        float mean,
+                        float variance
+                        )
+{
+
+  return fminf( sqrtf( 1.0f + mean * mean / fmaxf( variance, 1.0e-12f ) ), ROULETTE_MAX_SCALE );
+
+}
+
+
+
+///
+/// \brief accumulateRouletteMoments
+///
+///        Adds a frame's mean luminance to a pixel's running
+///        mean and mean square. These moments are all the state
+///        ROULETTE_EFFICIENCY keeps between frames, so
+///        checkpoints store them with the image.
+///
+/// \param frame 1 for the first frame of a render
+///
+FAST_MATH_FUNC
+void
+accumulateRouletteMoments(
+                          float   &mean,
+                          float   &meanSquare,
+                          float    luminance,
+                          unsigned frame
+                          )
+{
+
+  if ( frame > 1 )
+  {
+
+    float weight = 1.0f / frame;
+
+    mean       += ( luminance - mean ) * weight;
+    meanSquare += ( luminance * luminance - meanSquare ) * weight;
+
+  }
+  else
+  {
+
+    mean       = luminance;
+    meanSquare = luminance * luminance;
+
+  }
+
+}
+
+
+
+///
+/// \brief rouletteMomentScale
+///
+///        rouletteEfficiencyScale of a pixel from the moments of
+///        the frames it accumulated so far
+///
+/// \param frames          frames in the moments
+/// \param samplesPerFrame samples each frame averaged
+///
+FAST_MATH_FUNC
+float
+rouletteMomentScale(
+                    float    mean,
+                    float    meanSquare,
+                    unsigned frames,
+                    unsigned samplesPerFrame
+                    )
+{
+
+  // a variance needs two frames
+  if ( frames < 2 )
+  {
+    return 1.0f;
+  }
+
+  float frameVariance = fmaxf( meanSquare - mean * mean, 0.0f );
+
+  return rouletteEfficiencyScale( mean, frameVariance * samplesPerFrame );
+
+}
+
+
+
+///
+/// \brief lobeProbabilities
+///
+///        Probabilities of continuing a path along the diffuse
+///        and specular lobes from their mean weights, albedo
+///        ( 1 - F ) and F. Every policy weights a lobe it picks
+///        by weight / probability, so they estimate the same
+///        integral. ROULETTE_ALBEDO uses the weights as they
+///        are and ends the path with the rest, at most one since
+///        albedo <= 1. The other policies only pick a lobe, in
+///        proportion to its weight, and leave ending paths to
+///        survivalProbability.
+///
+FAST_MATH_FUNC
+void
+lobeProbabilities(
+                  RoulettePolicy policy,
+                  float          diffuseWeight,
+                  float          specularWeight,
+                  float         &scatterProb,
+                  float         &reflectProb
+                  )
+{
+
+  scatterProb = diffuseWeight;
+  reflectProb = specularWeight;
+
+  if ( policy != ROULETTE_ALBEDO )
+  {
+
+    float lobes = fmaxf( scatterProb + reflectProb, 1.0e-6f );
+
+    scatterProb /= lobes;
+    reflectProb /= lobes;
+
+  }
+
+}
+
+
+
+///
+/// \brief survivalProbability
+///
+///        ROULETTE_THROUGHPUT keeps a path with probability
+///        min( 1, throughput ), so survivors carry a throughput
+///        of about one and dim paths stop spending rays.
+///        ROULETTE_EFFICIENCY multiplies the throughput by
+///        rouletteEfficiencyScale first, keeping more paths in
+///        pixels that are already smooth. ROULETTE_ALBEDO
+///        returns 1 since it ends paths while picking a lobe.
+///
+/// \param throughput largest RGB component of the path throughput
+/// \param scale      rouletteEfficiencyScale of the path's pixel
+/// \param depth      segments traced before this bounce, minus one
+/// \param minDepth   depth below which paths always survive
+///
+FAST_MATH_FUNC
+float
+survivalProbability(
+                    RoulettePolicy policy,
+                    float          throughput,
+                    float          scale,
+                    int            depth,
+                    int            minDepth
+                    )
+{
+
+  if ( policy == ROULETTE_ALBEDO || depth < minDepth )
+  {
+    return 1.0f;
+  }
+
+  if ( policy == ROULETTE_EFFICIENCY )
+  {
+    throughput *= scale;
+  }
+
+  return fminf( fmaxf( throughput, 0.0f ), 1.0f );
+
+}
+
+
+#endif // Roulette_hpp
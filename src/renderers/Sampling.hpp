@@ -0,0 +1,405 @@
+#ifndef Sampling_hpp
+#define Sampling_hpp
+
+
+//
+// Direction sampling shared by the device programs and the host.
+// Every function is branchless apart from selects and works on
+// any vector type with x, y and z members (float3 on the device).
+// Samples are in a local frame around +z; alignToNormal moves
+// them around a world space normal. src/simd/SimdSampling.hpp
+// has lane-wise versions with the same polynomials, and the
+// SimdKernels table batched ones.
+//
+#include "FastMath.hpp"
+
+
+// sin( t ) / t - 1 and cos( t ) - 1 on [-pi / 4, pi / 4] in powers
+// of t^2 (Taylor), errors below 2e-9 and 3e-8
+#define SAMPLING_SIN_C1 -1.6666667e-1f
+#define SAMPLING_SIN_C2  8.3333333e-3f
+#define SAMPLING_SIN_C3 -1.9841270e-4f
+#define SAMPLING_SIN_C4  2.7557319e-6f
+
+#define SAMPLING_COS_C1 -5.0000000e-1f
+#define SAMPLING_COS_C2  4.1666667e-2f
+#define SAMPLING_COS_C3 -1.3888889e-3f
+#define SAMPLING_COS_C4  2.4801587e-5f
+
+#define SAMPLING_PI_OVER_4 0.785398163397f
+#define SAMPLING_INV_PI    0.318309886184f
+
+
+
+///
+/// \brief quarterSinCos
+///
+///        sin( t ) and cos( t ) for t in [-pi / 4, pi / 4]
+///
+FAST_MATH_FUNC
+void
+quarterSinCos(
+              float  t,
+              float &s,
+              float &c
+              )
+{
+
+  float t2 = t * t;
+
+  float ps = SAMPLING_SIN_C4;
+  ps = ps * t2 + SAMPLING_SIN_C3;
+  ps = ps * t2 + SAMPLING_SIN_C2;
+  ps = ps * t2 + SAMPLING_SIN_C1;
+
+  float pc = SAMPLING_COS_C4;
+  pc = pc * t2 + SAMPLING_COS_C3;
+  pc = pc * t2 + SAMPLING_COS_C2;
+  pc = pc * t2 + SAMPLING_COS_C1;
+
+  s = t + t * t2 * ps;
+  c = 1.0f + t2 * pc;
+
+}
+
+
+///
+/// \brief turnSinCos
+///
+///        sin and cos of 2 pi u for u in [0, 1], reduced to a
+///        quarter turn around the nearest multiple of pi / 2
+///
+FAST_MATH_FUNC
+void
+turnSinCos(
+           float  u,
+           float &s,
+           float &c
+           )
+{
+
+  float q = floorf( 4.0f * u + 0.5f );
+
+  float qs, qc;
+  quarterSinCos( ( 4.0f * u - q ) * ( 2.0f * SAMPLING_PI_OVER_4 ), qs, qc );
+
+  int quadrant = static_cast< int >( q );
+
+  // odd quadrants rotate by pi / 2, quadrants 2 and 3 by pi
+  float rs = ( quadrant & 1 ) ? qc  : qs;
+  float rc = ( quadrant & 1 ) ? -qs : qc;
+
+  s = ( quadrant & 2 ) ? -rs : rs;
+  c = ( quadrant & 2 ) ? -rc : rc;
+
+}
+
+
+
+///
+/// \brief orthonormalBasis
+///
+///        Tangents b1 and b2 completing the unit vector n to a
+///        right handed basis, without branches or normalization
+///        (Duff et al. 2017, "Building an Orthonormal Basis,
+///        Revisited")
+///
+template< typename Vector >
+FAST_MATH_FUNC
+void
+orthonormalBasis(
+                 const Vector &n,
+                 Vector       &b1,
+                 Vector       &b2
+                 )
+{
+
+  float sign = copysignf( 1.0f, n.z );
+  float a    = -1.0f / ( sign + n.z );
+  float b    = n.x * n.y * a;
+
+  b1.x = 1.0f + sign * n.x * n.x * a;
+  b1.y = sign * b;
+  b1.z = -sign * n.x;
+
+  b2.x = b;
+  b2.y = sign + n.y * n.y * a;
+  b2.z = -n.y;
+
+}
+
+
+///
+/// \brief alignToNormal
+/// \return the local direction 'v' (around +z) in the frame of
+///         the unit vector n
+///
+template< typename Vector >
+FAST_MATH_FUNC
+Vector
+alignToNormal(
+              const Vector &v,
+              const Vector &n
+              )
+{
+
+  Vector b1, b2;
+  orthonormalBasis( n, b1, b2 );
+
+  Vector result;
+  result.x = b1.x * v.x + b2.x * v.y + n.x * v.z;
+  result.y = b1.y * v.x + b2.y * v.y + n.y * v.z;
+  result.z = b1.z * v.x + b2.z * v.y + n.z * v.z;
+
+  return result;
+
+}
+
+
+
+///
+/// \brief sampleConcentricDisk
+///
+///        Maps the unit square to the unit disk keeping
+///        stratification (Shirley and Chiu 1997). The larger of
+///        |a| and |b| is the radius, the ratio of the two the
+///        angle within its quarter.
+///
+FAST_MATH_FUNC
+void
+sampleConcentricDisk(
+                     float  u1,
+                     float  u2,
+                     float &x,
+                     float &y
+                     )
+{
+
+  float a = 2.0f * u1 - 1.0f;
+  float b = 2.0f * u2 - 1.0f;
+
+  bool  alongA = a * a > b * b;
+  float r      = alongA ? a : b;
+  float ratio  = ( alongA ? b : a ) / ( r != 0.0f ? r : 1.0f );
+
+  float s, c;
+  quarterSinCos( SAMPLING_PI_OVER_4 * ratio, s, c );
+
+  // around the b axis the angle is pi / 2 - t
+  x = r * ( alongA ? c : s );
+  y = r * ( alongA ? s : c );
+
+}
+
+
+///
+/// \brief sampleCosineHemisphere
+/// \return a direction around +z with density cos( theta ) / pi
+///
+template< typename Vector >
+FAST_MATH_FUNC
+Vector
+sampleCosineHemisphere(
+                       float u1,
+                       float u2
+                       )
+{
+
+  Vector v;
+  sampleConcentricDisk( u1, u2, v.x, v.y );
+
+  v.z = sqrtf( fmaxf( 0.0f, 1.0f - v.x * v.x - v.y * v.y ) );
+
+  return v;
+
+}
+
+
+FAST_MATH_FUNC
+float
+cosineHemispherePdf( float cosTheta )
+{
+
+  return fmaxf( cosTheta, 0.0f ) * SAMPLING_INV_PI;
+
+}
+
+
+///
+/// \brief sampleUniformCone
+/// \return a direction within cosMax of +z, uniform in solid
+///         angle. u1 picks the angle around z, u2 the height.
+///
+template< typename Vector >
+FAST_MATH_FUNC
+Vector
+sampleUniformCone(
+                  float u1,
+                  float u2,
+                  float cosMax
+                  )
+{
+
+  Vector v;
+  v.z = cosMax + ( 1.0f - cosMax ) * u2;
+
+  float r = sqrtf( fmaxf( 0.0f, 1.0f - v.z * v.z ) );
+
+  float s, c;
+  turnSinCos( u1, s, c );
+
+  v.x = r * c;
+  v.y = r * s;
+
+  return v;
+
+}
+
+
+FAST_MATH_FUNC
+float
+uniformConePdf( float cosMax )
+{
+
+  return SAMPLING_INV_PI / ( 2.0f * ( 1.0f - cosMax ) );
+
+}
+
+
+///
+/// \brief sampleUniformSphere
+/// \return a direction uniform over the sphere, the mapping of
+///         src/testing/matlab/sampleSphere.m
+///
+template< typename Vector >
+FAST_MATH_FUNC
+Vector
+sampleUniformSphere(
+                    float u1,
+                    float u2
+                    )
+{
+
+  return sampleUniformCone< Vector >( u1, u2, -1.0f );
+
+}
+
+
+FAST_MATH_FUNC
+float
+uniformSpherePdf( )
+{
+
+  return 0.25f * SAMPLING_INV_PI;
+
+}
+
+
+
+///
+/// \brief ggxD
+///
+///        GGX (Trowbridge-Reitz) normal distribution with
+///        roughness alpha at cos( theta_h ) = cosNH
+///
+FAST_MATH_FUNC
+float
+ggxD(
+     float cosNH,
+     float alpha
+     )
+{
+
+  float alpha2 = alpha * alpha;
+  float d      = cosNH * cosNH * ( alpha2 - 1.0f ) + 1.0f;
+
+  return cosNH > 0.0f ? alpha2 * SAMPLING_INV_PI / ( d * d ) : 0.0f;
+
+}
+
+
+///
+/// \brief ggxSmithG1
+///
+///        Smith masking of the GGX distribution for a direction
+///        at cos( theta ) = cosNV
+///
+FAST_MATH_FUNC
+float
+ggxSmithG1(
+           float cosNV,
+           float alpha
+           )
+{
+
+  float alpha2 = alpha * alpha;
+
+  return 2.0f * cosNV / ( cosNV + sqrtf( alpha2 + ( 1.0f - alpha2 ) * cosNV * cosNV ) );
+
+}
+
+
+///
+/// \brief sampleGgxVndf
+/// \return a microfacet normal around +z from the distribution
+///         of normals visible from v (v.z > 0), sampled as a
+///         spherical cap in the stretched configuration (Dupuy
+///         and Benyoub 2023). u1 picks the angle around z.
+///
+template< typename Vector >
+FAST_MATH_FUNC
+Vector
+sampleGgxVndf(
+              const Vector &v,
+              float         alpha,
+              float         u1,
+              float         u2
+              )
+{
+
+  // view direction in the configuration where alpha is 1
+  Vector vh;
+  vh.x = alpha * v.x;
+  vh.y = alpha * v.y;
+  vh.z = v.z;
+  vh   = mathNormalize( vh, MATH_PRECISE );
+
+  float z = ( 1.0f - u2 ) * ( 1.0f + vh.z ) - vh.z;
+  float r = sqrtf( fminf( fmaxf( 1.0f - z * z, 0.0f ), 1.0f ) );
+
+  float s, c;
+  turnSinCos( u1, s, c );
+
+  Vector h;
+  h.x = alpha * ( r * c + vh.x );
+  h.y = alpha * ( r * s + vh.y );
+  h.z = fmaxf( z + vh.z, 0.0f );
+
+  return mathNormalize( h, MATH_PRECISE );
+
+}
+
+
+///
+/// \brief ggxVndfPdf
+///
+///        Density of sampleGgxVndf's normal h, per solid angle of
+///        h, from the cosines between the normal, the view
+///        direction v and h
+///
+FAST_MATH_FUNC
+float
+ggxVndfPdf(
+           float cosNV,
+           float cosNH,
+           float cosVH,
+           float alpha
+           )
+{
+
+  return ggxSmithG1( cosNV, alpha ) * fmaxf( cosVH, 0.0f ) * ggxD( cosNH, alpha ) / cosNV;
+
+}
+
+
+#endif // Sampling_hpp
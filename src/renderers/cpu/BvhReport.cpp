@@ -0,0 +1,341 @@
+#include "BvhReport.hpp"
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <sstream>
+#include <algorithm>
+#include "HostScene.hpp"
+
+
+namespace light
+{
+
+
+namespace
+{
+
+
+float
+overlapArea(
+            const Aabb &a,
+            const Aabb &b
+            )
+{
+
+  Aabb shared = { maximum( a.min, b.min ), minimum( a.max, b.max ) };
+
+  return shared.surfaceArea( );
+
+}
+
+
+std::string
+formatLine(
+           const std::string &level,
+           const BvhReport   &report
+           )
+{
+
+  std::ostringstream sizes;
+
+  for ( std::size_t n = 0; n < report.leafSizes.size( ); ++n )
+  {
+
+    if ( report.leafSizes[ n ] > 0 )
+    {
+      sizes << ( sizes.tellp( ) > 0 ? " " : "" ) << n << ":" << report.leafSizes[ n ];
+    }
+
+  }
+
+  char line[ 256 ];
+  std::snprintf(
+                line,
+                sizeof( line ),
+                "%-12s %9zu %9zu %9zu %6u %8.2f %9.2f %9.2f %7.3f %7.3f %10.1f  ",
+                level.c_str( ),
+                report.items,
+                report.nodes,
+                report.leaves,
+                report.maxDepth,
+                report.meanLeafDepth,
+                report.sahCost,
+                report.buildSahCost,
+                report.meanSiblingOverlap,
+                report.maxSiblingOverlap,
+                report.memoryBytes / 1024.0
+                );
+
+  return line + sizes.str( ) + "\n";
+
+}
+
+
+void
+countPixel(
+           const TraversalStats &stats,
+           TraversalStats       *pPixel,
+           TraversalStats       *pTotal
+           )
+{
+
+  pPixel->nodes += stats.nodes;
+  pPixel->tests += stats.tests;
+  pTotal->nodes += stats.nodes;
+  pTotal->tests += stats.tests;
+
+}
+
+
+} // namespace
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief analyzeBvh
+///////////////////////////////////////////////////////////////
+BvhReport
+analyzeBvh( const Bvh &bvh )
+{
+
+  BvhReport report;
+
+  const std::vector< BvhNode > &nodes = bvh.getNodes( );
+
+  report.items        = bvh.getIndices( ).size( );
+  report.nodes        = nodes.size( );
+  report.memoryBytes  = bvh.getMemoryBytes( );
+  report.sahCost      = nodes.empty( ) ? 0.0f : bvh.getSahCost( );
+  report.buildSahCost = bvh.getBuildSahCost( );
+
+  // children always follow their parent, so one pass sets every depth
+  std::vector< unsigned > depths( nodes.size( ), 0 );
+
+  double      leafDepthSum = 0.0;
+  double      overlapSum   = 0.0;
+  std::size_t interior     = 0;
+
+  for ( std::size_t i = 0; i < nodes.size( ); ++i )
+  {
+
+    const BvhNode &node = nodes[ i ];
+
+    report.maxDepth = std::max( report.maxDepth, depths[ i ] );
+
+    if ( node.count > 0 )
+    {
+
+      ++report.leaves;
+      leafDepthSum += depths[ i ];
+
+      if ( report.leafSizes.size( ) <= node.count )
+      {
+        report.leafSizes.resize( node.count + 1, 0 );
+      }
+
+      ++report.leafSizes[ node.count ];
+
+      continue;
+
+    }
+
+    depths[ node.first ]     = depths[ i ] + 1;
+    depths[ node.first + 1 ] = depths[ i ] + 1;
+
+    float parentArea = node.bounds.surfaceArea( );
+
+    double overlap = parentArea > 0.0f
+                     ? overlapArea( nodes[ node.first ].bounds, nodes[ node.first + 1 ].bounds ) / parentArea
+                     : 0.0;
+
+    overlapSum               += overlap;
+    report.maxSiblingOverlap  = std::max( report.maxSiblingOverlap, overlap );
+    ++interior;
+
+  }
+
+  report.meanLeafDepth      = report.leaves > 0 ? leafDepthSum / report.leaves : 0.0;
+  report.meanSiblingOverlap = interior > 0 ? overlapSum / interior : 0.0;
+
+  return report;
+
+} // analyzeBvh
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief measureRayCost
+///////////////////////////////////////////////////////////////
+RayCostReport
+measureRayCost(
+               const HostScene &scene,
+               unsigned         width,
+               unsigned         height,
+               Float3           eye,
+               Float3           U,
+               Float3           V,
+               Float3           W
+               )
+{
+
+  RayCostReport report;
+  report.width  = width;
+  report.height = height;
+  report.pixels.resize( static_cast< std::size_t >( width ) * height );
+
+  const std::vector< IlluminatorRecord > &illuminators = scene.getSceneDescription( ).getIlluminators( );
+
+  const float epsilon = 1e-3f;
+
+  for ( unsigned y = 0; y < height; ++y )
+  {
+
+    for ( unsigned x = 0; x < width; ++x )
+    {
+
+      TraversalStats &pixel = report.pixels[ static_cast< std::size_t >( y ) * width + x ];
+
+      float dx = ( x + 0.5f ) * 2.0f / width - 1.0f;
+      float dy = ( y + 0.5f ) * 2.0f / height - 1.0f;
+
+      HostRay ray = { eye, U * dx + V * dy + W, 0.0f, std::numeric_limits< float >::infinity( ) };
+      HostHit hit;
+
+      TraversalStats stats;
+      bool           found = scene.intersect( ray, &hit, &stats );
+
+      countPixel( stats, &pixel, &report.primary );
+      ++report.primaryRays;
+
+      if ( found )
+      {
+
+        Float3 point = ray.origin + ray.direction * hit.t;
+
+        for ( const IlluminatorRecord &illuminator : illuminators )
+        {
+
+          // stop at the light's surface so it doesn't occlude itself
+          Float3 toLight  = illuminator.center - point;
+          float  distance = std::sqrt( dot( toLight, toLight ) );
+
+          float reach = std::max( distance, epsilon );
+
+          HostRay shadowRay = { point, toLight, epsilon / reach, 1.0f - illuminator.radius / reach - epsilon };
+
+          TraversalStats shadowStats;
+          scene.occluded( shadowRay, &shadowStats );
+
+          countPixel( shadowStats, &pixel, &report.shadow );
+          ++report.shadowRays;
+
+        }
+
+      }
+
+      report.maxPixelNodes = std::max( report.maxPixelNodes, pixel.nodes );
+      report.maxPixelTests = std::max( report.maxPixelTests, pixel.tests );
+
+    }
+
+  }
+
+  return report;
+
+} // measureRayCost
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief toCostHeatmap
+///////////////////////////////////////////////////////////////
+std::vector< float >
+toCostHeatmap(
+              const RayCostReport &report,
+              float                scale
+              )
+{
+
+  std::vector< float > rgba;
+  rgba.reserve( report.pixels.size( ) * 4 );
+
+  for ( const TraversalStats &pixel : report.pixels )
+  {
+
+    // blue, cyan, green, yellow, red at h = 0, 1, 2, 3, 4
+    float h = std::min( static_cast< float >( pixel.nodes + pixel.tests ) / std::max( scale, 1.0f ), 1.0f ) * 4.0f;
+
+    rgba.push_back( std::min( std::max( h - 2.0f, 0.0f ), 1.0f ) );
+    rgba.push_back( std::min( std::min( h, 4.0f - h ), 1.0f ) );
+    rgba.push_back( std::min( std::max( 2.0f - h, 0.0f ), 1.0f ) );
+    rgba.push_back( 1.0f );
+
+  }
+
+  return rgba;
+
+} // toCostHeatmap
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief formatBvhReport
+///////////////////////////////////////////////////////////////
+std::string
+formatBvhReport( const HostScene &scene )
+{
+
+  std::string text;
+
+  char header[ 256 ];
+  std::snprintf(
+                header,
+                sizeof( header ),
+                "%-12s %9s %9s %9s %6s %8s %9s %9s %7s %7s %10s  %s\n",
+                "level", "items", "nodes", "leaves", "depth", "leafDep",
+                "SAH", "builtSAH", "ovlMean", "ovlMax", "KiB", "leaf sizes (items:leaves)"
+                );
+
+  text += header;
+
+  BvhReport top = analyzeBvh( scene.getTopLevel( ) );
+  text += formatLine( "top", top );
+
+  BvhReport total;
+  total.nodes = top.nodes;
+
+  for ( std::size_t level = 0; level < scene.getBottomLevelCount( ); ++level )
+  {
+
+    BvhReport bottom = analyzeBvh( scene.getBottomLevel( level ) );
+    text += formatLine( "bottom " + std::to_string( level ), bottom );
+
+    total.items    += bottom.items;
+    total.nodes    += bottom.nodes;
+    total.maxDepth  = std::max( total.maxDepth, top.maxDepth + 1 + bottom.maxDepth );
+
+  }
+
+  char summary[ 256 ];
+  std::snprintf(
+                summary,
+                sizeof( summary ),
+                "total: %zu instances of %zu bottom levels, %zu items, %zu nodes, "
+                "deepest path %u, %.1f KiB with instances\n",
+                scene.getInstanceCount( ),
+                scene.getBottomLevelCount( ),
+                total.items,
+                total.nodes,
+                total.maxDepth,
+                scene.getAccelerationBytes( ) / 1024.0
+                );
+
+  text += summary;
+
+  return text;
+
+} // formatBvhReport
+
+
+
+} // namespace light
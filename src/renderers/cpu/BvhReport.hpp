@@ -0,0 +1,115 @@
+#ifndef BvhReport_hpp
+#define BvhReport_hpp
+
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include "HostBvh.hpp"
+
+
+namespace light
+{
+
+
+class HostScene;
+
+
+/////////////////////////////////////////////
+/// \brief The BvhReport struct
+///
+///        Quality measures of one built BVH
+/////////////////////////////////////////////
+struct BvhReport
+{
+  std::size_t items         = 0;
+  std::size_t nodes         = 0;
+  std::size_t leaves        = 0;
+  unsigned    maxDepth      = 0; // root is depth 0
+  double      meanLeafDepth = 0.0;
+  float       sahCost       = 0.0f;
+  float       buildSahCost  = 0.0f;
+
+  std::vector< std::size_t > leafSizes; // leafSizes[ n ] leaves hold n items
+
+  // surface area of the box shared by two siblings over their
+  // parent's, high values mean rays enter both children
+  double meanSiblingOverlap = 0.0;
+  double maxSiblingOverlap  = 0.0;
+
+  std::size_t memoryBytes = 0;
+};
+
+
+///////////////////////////////////////////////////////////////
+/// \brief analyzeBvh
+///////////////////////////////////////////////////////////////
+BvhReport analyzeBvh ( const Bvh &bvh );
+
+
+/////////////////////////////////////////////
+/// \brief The RayCostReport struct
+///
+///        Traversal work of a grid of primary rays and one
+///        shadow ray per light from every hit
+/////////////////////////////////////////////
+struct RayCostReport
+{
+  unsigned width  = 0;
+  unsigned height = 0;
+
+  std::vector< TraversalStats > pixels; // primary and shadow rays together, row by row
+
+  TraversalStats primary;
+  TraversalStats shadow;
+  std::size_t    primaryRays = 0;
+  std::size_t    shadowRays  = 0;
+
+  std::uint64_t maxPixelNodes = 0;
+  std::uint64_t maxPixelTests = 0;
+};
+
+
+///////////////////////////////////////////////////////////////
+/// \brief measureRayCost
+///
+///        Traces one primary ray through the center of each
+///        pixel of a pinhole camera (eye + x U + y V + W for x, y
+///        in [-1, 1]) and a shadow ray towards every illuminator
+///        center from each hit
+///////////////////////////////////////////////////////////////
+RayCostReport measureRayCost (
+                              const HostScene &scene,
+                              unsigned         width,
+                              unsigned         height,
+                              Float3           eye,
+                              Float3           U,
+                              Float3           V,
+                              Float3           W
+                              );
+
+
+///////////////////////////////////////////////////////////////
+/// \brief toCostHeatmap
+/// \param scale node visits plus tests per pixel shown as red
+/// \return RGBA pixels, blue through green to red, rows
+///         bottom-up like writePPM expects
+///////////////////////////////////////////////////////////////
+std::vector< float > toCostHeatmap (
+                                    const RayCostReport &report,
+                                    float                scale
+                                    );
+
+
+///////////////////////////////////////////////////////////////
+/// \brief formatBvhReport
+/// \return one line per level: top level first, then each
+///         bottom level, then the totals
+///////////////////////////////////////////////////////////////
+std::string formatBvhReport ( const HostScene &scene );
+
+
+} // namespace light
+
+
+#endif // BvhReport_hpp
@@ -0,0 +1,527 @@
+#include "HostBvh.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <numeric>
+#include <thread>
+#include "Trace.hpp"
+
+
+namespace light
+{
+
+
+namespace
+{
+
+
+constexpr unsigned binCount = 16;
+
+// past this depth nodes are split at the median so the
+// traversal stack can never overflow
+constexpr unsigned maxSahDepth = 40;
+
+// below this many nodes a refit is cheaper than starting threads
+constexpr std::size_t minParallelRefitNodes = 8192;
+
+// subtrees handed out per refit thread so uneven ones balance
+constexpr unsigned refitTasksPerThread = 4;
+
+
+///
+/// \brief The BuildTask struct
+///
+///        Node waiting to be split over a range of indices
+///
+struct BuildTask
+{
+  std::uint32_t node;
+  std::uint32_t first;
+  std::uint32_t count;
+  unsigned      depth;
+};
+
+
+struct Bin
+{
+  Aabb          bounds;
+  std::uint32_t count;
+};
+
+
+} // namespace
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief transformAabb
+///////////////////////////////////////////////////////////////
+Aabb
+transformAabb(
+              const Transform &transform,
+              const Aabb      &box
+              )
+{
+
+  if ( box.isEmpty( ) )
+  {
+    return box;
+  }
+
+  // the transformed center plus the extent pushed through the
+  // absolute value of the linear part bounds all eight corners
+  const float *m = transform.m;
+
+  Float3 center = transformPoint( transform, box.centroid( ) );
+  Float3 half   = ( box.max - box.min ) * 0.5f;
+
+  Float3 extent = {
+    std::abs( m[ 0 ] ) * half.x + std::abs( m[ 1 ] ) * half.y + std::abs( m[ 2 ] )  * half.z,
+    std::abs( m[ 4 ] ) * half.x + std::abs( m[ 5 ] ) * half.y + std::abs( m[ 6 ] )  * half.z,
+    std::abs( m[ 8 ] ) * half.x + std::abs( m[ 9 ] ) * half.y + std::abs( m[ 10 ] ) * half.z
+  };
+
+  return Aabb { center - extent, center + extent };
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief Bvh::build
+///////////////////////////////////////////////////////////////
+void
+Bvh::build(
+           const std::vector< Aabb > &bounds,
+           unsigned                   maxLeafSize
+           )
+{
+
+  LIGHT_TRACE_SCOPE( "bvhBuild", "accel" );
+
+  nodes_.clear( );
+  indices_.resize( bounds.size( ) );
+  std::iota( indices_.begin( ), indices_.end( ), 0u );
+
+  if ( bounds.empty( ) )
+  {
+    return;
+  }
+
+  maxLeafSize = std::max( maxLeafSize, 1u );
+
+  std::vector< Float3 > centroids( bounds.size( ) );
+
+  for ( std::size_t i = 0; i < bounds.size( ); ++i )
+  {
+    centroids[ i ] = bounds[ i ].centroid( );
+  }
+
+  nodes_.reserve( bounds.size( ) * 2 / maxLeafSize + 1 );
+  nodes_.push_back( BvhNode { Aabb::empty( ), 0, 0 } );
+
+  std::vector< BuildTask > tasks;
+  tasks.push_back( BuildTask { 0, 0, static_cast< std::uint32_t >( bounds.size( ) ), 0 } );
+
+  while ( !tasks.empty( ) )
+  {
+
+    BuildTask task = tasks.back( );
+    tasks.pop_back( );
+
+    std::uint32_t *pIndices = indices_.data( ) + task.first;
+
+    Aabb nodeBounds     = Aabb::empty( );
+    Aabb centroidBounds = Aabb::empty( );
+
+    for ( std::uint32_t i = 0; i < task.count; ++i )
+    {
+
+      nodeBounds.grow( bounds[ pIndices[ i ] ] );
+      centroidBounds.grow( centroids[ pIndices[ i ] ] );
+
+    }
+
+    nodes_[ task.node ].bounds = nodeBounds;
+
+    if ( task.count <= maxLeafSize )
+    {
+
+      nodes_[ task.node ].first = task.first;
+      nodes_[ task.node ].count = task.count;
+      continue;
+
+    }
+
+    //
+    // binned SAH over all three axes
+    //
+    Float3 extent  = centroidBounds.max - centroidBounds.min;
+    int    bestAxis  = -1;
+    unsigned bestBin = 0;
+    float  bestCost  = static_cast< float >( task.count ) * nodeBounds.surfaceArea( );
+
+    for ( int axis = 0; axis < 3 && task.depth < maxSahDepth; ++axis )
+    {
+
+      float axisExtent = component( extent, axis );
+
+      if ( axisExtent <= 0.0f )
+      {
+        continue;
+      }
+
+      Bin bins[ binCount ];
+
+      for ( Bin &bin : bins )
+      {
+        bin = Bin { Aabb::empty( ), 0 };
+      }
+
+      float scale = binCount / axisExtent;
+      float start = component( centroidBounds.min, axis );
+
+      for ( std::uint32_t i = 0; i < task.count; ++i )
+      {
+
+        unsigned b = std::min( binCount - 1, static_cast< unsigned >( ( component( centroids[ pIndices[ i ] ], axis ) - start ) * scale ) );
+        bins[ b ].bounds.grow( bounds[ pIndices[ i ] ] );
+        ++bins[ b ].count;
+
+      }
+
+      // sweep from the right to get every right-hand side cost
+      float rightCost[ binCount ];
+      Aabb  right      = Aabb::empty( );
+      std::uint32_t rightCount = 0;
+
+      for ( unsigned b = binCount - 1; b > 0; --b )
+      {
+
+        right.grow( bins[ b ].bounds );
+        rightCount     += bins[ b ].count;
+        rightCost[ b ]  = right.surfaceArea( ) * static_cast< float >( rightCount );
+
+      }
+
+      Aabb left = Aabb::empty( );
+      std::uint32_t leftCount = 0;
+
+      for ( unsigned b = 0; b < binCount - 1; ++b )
+      {
+
+        left.grow( bins[ b ].bounds );
+        leftCount += bins[ b ].count;
+
+        if ( leftCount == 0 || leftCount == task.count )
+        {
+          continue;
+        }
+
+        float cost = left.surfaceArea( ) * static_cast< float >( leftCount ) + rightCost[ b + 1 ];
+
+        if ( cost < bestCost )
+        {
+
+          bestCost = cost;
+          bestAxis = axis;
+          bestBin  = b;
+
+        }
+
+      }
+
+    }
+
+    std::uint32_t leftCount;
+
+    if ( bestAxis >= 0 )
+    {
+
+      float scale = binCount / component( extent, bestAxis );
+      float start = component( centroidBounds.min, bestAxis );
+
+      std::uint32_t *pMiddle = std::partition(
+                                              pIndices,
+                                              pIndices + task.count,
+                                              [ & ]( std::uint32_t index )
+                                              {
+                                                unsigned b = std::min( binCount - 1, static_cast< unsigned >( ( component( centroids[ index ], bestAxis ) - start ) * scale ) );
+                                                return b <= bestBin;
+                                              }
+                                              );
+
+      leftCount = static_cast< std::uint32_t >( pMiddle - pIndices );
+
+    }
+    else
+    {
+
+      // no split beats a leaf, or centroids coincide: split at the
+      // median of the widest axis so leaves stay small
+      int axis = ( extent.x >= extent.y && extent.x >= extent.z ) ? 0 : ( extent.y >= extent.z ? 1 : 2 );
+
+      leftCount = task.count / 2;
+
+      std::nth_element(
+                       pIndices,
+                       pIndices + leftCount,
+                       pIndices + task.count,
+                       [ & ]( std::uint32_t a, std::uint32_t b )
+                       {
+                         return component( centroids[ a ], axis ) < component( centroids[ b ], axis );
+                       }
+                       );
+
+    }
+
+    std::uint32_t child = static_cast< std::uint32_t >( nodes_.size( ) );
+
+    nodes_[ task.node ].first = child;
+    nodes_[ task.node ].count = 0;
+
+    nodes_.push_back( BvhNode { Aabb::empty( ), 0, 0 } );
+    nodes_.push_back( BvhNode { Aabb::empty( ), 0, 0 } );
+
+    tasks.push_back( BuildTask { child,     task.first,             leftCount,              task.depth + 1 } );
+    tasks.push_back( BuildTask { child + 1, task.first + leftCount, task.count - leftCount, task.depth + 1 } );
+
+  }
+
+  buildSahCost_ = getSahCost( );
+
+} // Bvh::build
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief Bvh::refit
+///////////////////////////////////////////////////////////////
+void
+Bvh::refit(
+           const std::vector< Aabb > &bounds,
+           unsigned                   numThreads
+           )
+{
+
+  if ( nodes_.empty( ) )
+  {
+    return;
+  }
+
+  if ( numThreads <= 1 || nodes_.size( ) < minParallelRefitNodes )
+  {
+
+    // children come after parents, so reverse order is bottom-up
+    for ( std::size_t i = nodes_.size( ); i-- > 0; )
+    {
+      _refitNode( static_cast< std::uint32_t >( i ), bounds );
+    }
+
+    return;
+
+  }
+
+  //
+  // split the top of the tree until there are enough
+  // independent subtrees to keep every thread busy
+  //
+  std::vector< std::uint32_t > subtrees = { 0 };
+  std::vector< std::uint32_t > topNodes;
+
+  while ( subtrees.size( ) < numThreads * refitTasksPerThread )
+  {
+
+    std::vector< std::uint32_t > next;
+    bool split = false;
+
+    for ( std::uint32_t node : subtrees )
+    {
+
+      if ( nodes_[ node ].count == 0 )
+      {
+
+        topNodes.push_back( node );
+        next.push_back( nodes_[ node ].first );
+        next.push_back( nodes_[ node ].first + 1 );
+        split = true;
+
+      }
+      else
+      {
+
+        next.push_back( node );
+
+      }
+
+    }
+
+    subtrees.swap( next );
+
+    if ( !split )
+    {
+      break;
+    }
+
+  }
+
+  std::atomic< std::size_t > nextSubtree( 0 );
+
+  auto worker = [ this, &bounds, &subtrees, &nextSubtree ]( )
+                {
+
+                  std::size_t task;
+
+                  while ( ( task = nextSubtree++ ) < subtrees.size( ) )
+                  {
+
+                    _refitSubtree( subtrees[ task ], bounds );
+
+                  }
+
+                };
+
+  std::vector< std::thread > threads;
+  threads.reserve( numThreads - 1 );
+
+  for ( unsigned i = 1; i < numThreads; ++i )
+  {
+
+    threads.emplace_back( worker );
+
+  }
+
+  worker( );
+
+  for ( std::thread &thread : threads )
+  {
+
+    thread.join( );
+
+  }
+
+  // the few nodes above the subtrees, deepest first
+  std::sort( topNodes.begin( ), topNodes.end( ), std::greater< std::uint32_t >( ) );
+
+  for ( std::uint32_t node : topNodes )
+  {
+    _refitNode( node, bounds );
+  }
+
+} // Bvh::refit
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief Bvh::getSahCost
+///////////////////////////////////////////////////////////////
+float
+Bvh::getSahCost( ) const
+{
+
+  if ( nodes_.empty( ) )
+  {
+    return 0.0f;
+  }
+
+  float rootArea = nodes_[ 0 ].bounds.surfaceArea( );
+
+  if ( rootArea <= 0.0f )
+  {
+    return 0.0f;
+  }
+
+  // same unit costs for a node visit and an item test as the build
+  double cost = 0.0;
+
+  for ( const BvhNode &node : nodes_ )
+  {
+
+    float weight = node.count > 0 ? static_cast< float >( node.count ) : 1.0f;
+    cost += static_cast< double >( node.bounds.surfaceArea( ) * weight );
+
+  }
+
+  return static_cast< float >( cost / rootArea );
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief Bvh::_refitSubtree
+///////////////////////////////////////////////////////////////
+void
+Bvh::_refitSubtree(
+                   std::uint32_t              node,
+                   const std::vector< Aabb > &bounds
+                   )
+{
+
+  const BvhNode &n = nodes_[ node ];
+
+  if ( n.count == 0 )
+  {
+
+    _refitSubtree( n.first,     bounds );
+    _refitSubtree( n.first + 1, bounds );
+
+  }
+
+  _refitNode( node, bounds );
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief Bvh::_refitNode
+///
+///        Recomputes one node from its items or from its
+///        already refit children
+///////////////////////////////////////////////////////////////
+void
+Bvh::_refitNode(
+                std::uint32_t              node,
+                const std::vector< Aabb > &bounds
+                )
+{
+
+  BvhNode &n = nodes_[ node ];
+  Aabb box   = Aabb::empty( );
+
+  if ( n.count > 0 )
+  {
+
+    for ( std::uint32_t i = 0; i < n.count; ++i )
+    {
+      box.grow( bounds[ indices_[ n.first + i ] ] );
+    }
+
+  }
+  else
+  {
+
+    box.grow( nodes_[ n.first ].bounds );
+    box.grow( nodes_[ n.first + 1 ].bounds );
+
+  }
+
+  n.bounds = box;
+
+}
+
+
+
+std::size_t
+Bvh::getMemoryBytes( ) const
+{
+
+  return nodes_.capacity( ) * sizeof( BvhNode ) + indices_.capacity( ) * sizeof( std::uint32_t );
+
+}
+
+
+
+} // namespace light
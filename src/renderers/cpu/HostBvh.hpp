@@ -0,0 +1,348 @@
+#ifndef HostBvh_hpp
+#define HostBvh_hpp
+
+
+#include <vector>
+#include <limits>
+#include <cstdint>
+#include <cstddef>
+#include "HostMath.hpp"
+
+
+namespace light
+{
+
+
+/////////////////////////////////////////////
+/// \brief The Aabb struct
+/////////////////////////////////////////////
+struct Aabb
+{
+
+  Float3 min;
+  Float3 max;
+
+
+  static
+  Aabb
+  empty( )
+  {
+
+    const float inf = std::numeric_limits< float >::infinity( );
+    return Aabb { Float3 { inf, inf, inf }, Float3 { -inf, -inf, -inf } };
+
+  }
+
+  void grow( Float3 p )        { min = minimum( min, p );     max = maximum( max, p ); }
+  void grow( const Aabb &box ) { min = minimum( min, box.min ); max = maximum( max, box.max ); }
+
+  bool   isEmpty  ( ) const { return min.x > max.x || min.y > max.y || min.z > max.z; }
+  Float3 centroid ( ) const { return ( min + max ) * 0.5f; }
+
+
+  float
+  surfaceArea( ) const
+  {
+
+    if ( isEmpty( ) )
+    {
+      return 0.0f;
+    }
+
+    Float3 d = max - min;
+    return 2.0f * ( d.x * d.y + d.y * d.z + d.z * d.x );
+
+  }
+
+};
+
+
+///////////////////////////////////////////////////////////////
+/// \brief transformAabb
+/// \return world bounds of the eight transformed corners of 'box'
+///////////////////////////////////////////////////////////////
+Aabb transformAabb (
+                    const Transform &transform,
+                    const Aabb      &box
+                    );
+
+
+/////////////////////////////////////////////
+/// \brief The HostRay struct
+///
+///        Direction doesn't need to be normalized; hit
+///        distances are in units of its length
+/////////////////////////////////////////////
+struct HostRay
+{
+  Float3 origin;
+  Float3 direction;
+  float  tmin;
+  float  tmax;
+};
+
+
+/////////////////////////////////////////////
+/// \brief The TraversalStats struct
+///
+///        Work done by traversals, summed over every call
+///        that was handed the same stats
+/////////////////////////////////////////////
+struct TraversalStats
+{
+  std::uint64_t nodes = 0; // nodes visited, leaves included
+  std::uint64_t tests = 0; // items passed to the leaf function
+};
+
+
+/////////////////////////////////////////////
+/// \brief The BvhNode struct
+///
+///        Leaves (count > 0) cover getIndices( )[ first,
+///        first + count ). Interior nodes (count == 0) have
+///        their children at first and first + 1.
+/////////////////////////////////////////////
+struct BvhNode
+{
+  Aabb          bounds;
+  std::uint32_t first;
+  std::uint32_t count;
+};
+
+
+/////////////////////////////////////////////
+/// \brief The Bvh class
+///
+///        Bounding volume hierarchy over caller owned
+///        items, built with binned SAH. Nodes live in one
+///        array with children always after their parent.
+///        Moving items can be refit, which keeps the tree and
+///        only recomputes bounds; getSahCost against
+///        getBuildSahCost tells how much quality that lost.
+/////////////////////////////////////////////
+class Bvh
+{
+
+public:
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief build
+  /// \param bounds one box per item
+  /// \param maxLeafSize items per leaf before splitting is forced
+  ///////////////////////////////////////////////////////////////
+  void build (
+              const std::vector< Aabb > &bounds,
+              unsigned                   maxLeafSize = 4
+              );
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief refit
+  ///
+  ///        Recomputes node bounds bottom-up for items that
+  ///        moved without changing the tree. Large trees are
+  ///        refit in parallel, one subtree per task.
+  /// \param bounds one box per item, same items as the build
+  /// \param numThreads
+  ///////////////////////////////////////////////////////////////
+  void refit (
+              const std::vector< Aabb > &bounds,
+              unsigned                   numThreads = 1
+              );
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief getSahCost
+  /// \return surface area heuristic cost of the current tree
+  ///         relative to its root: the expected number of node
+  ///         visits plus item tests for a ray through the root
+  ///////////////////////////////////////////////////////////////
+  float getSahCost ( ) const;
+
+  float getBuildSahCost ( ) const { return buildSahCost_; }
+
+
+  const std::vector< BvhNode >       &getNodes   ( ) const { return nodes_; }
+  const std::vector< std::uint32_t > &getIndices ( ) const { return indices_; }
+
+  Aabb getBounds ( ) const { return nodes_.empty( ) ? Aabb::empty( ) : nodes_[ 0 ].bounds; }
+
+  std::size_t getMemoryBytes ( ) const;
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief traverse
+  ///
+  ///        Visits leaf items whose boxes the ray enters, nearest
+  ///        node first. 'leaf( item, &tmax )' tests one item,
+  ///        shortens tmax on a closer hit and returns true to stop
+  ///        traversal early (shadow rays).
+  /// \param pStats optional, counts visited nodes and item tests
+  ///////////////////////////////////////////////////////////////
+  template< typename LeafFunction >
+  void traverse (
+                 const HostRay  &ray,
+                 LeafFunction    leaf,
+                 TraversalStats *pStats = nullptr
+                 ) const;
+
+
+private:
+
+  void _refitSubtree (
+                      std::uint32_t              node,
+                      const std::vector< Aabb > &bounds
+                      );
+
+  void _refitNode (
+                   std::uint32_t              node,
+                   const std::vector< Aabb > &bounds
+                   );
+
+  std::vector< BvhNode >       nodes_;
+  std::vector< std::uint32_t > indices_;
+  float                        buildSahCost_ { 0.0f };
+
+};
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief intersectAabb
+/// \param pEntry distance where the ray enters 'box'
+/// \return true if the ray overlaps 'box' within [tmin, tmax]
+///////////////////////////////////////////////////////////////
+inline
+bool
+intersectAabb(
+              const Aabb &box,
+              Float3      origin,
+              Float3      inverseDirection,
+              float       tmin,
+              float       tmax,
+              float      *pEntry
+              )
+{
+
+  Float3 t0 = ( box.min - origin ) * inverseDirection;
+  Float3 t1 = ( box.max - origin ) * inverseDirection;
+
+  float entry = std::max( std::max( std::min( t0.x, t1.x ), std::min( t0.y, t1.y ) ), std::max( std::min( t0.z, t1.z ), tmin ) );
+  float exit  = std::min( std::min( std::max( t0.x, t1.x ), std::max( t0.y, t1.y ) ), std::min( std::max( t0.z, t1.z ), tmax ) );
+
+  *pEntry = entry;
+
+  return entry <= exit;
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief Bvh::traverse
+///////////////////////////////////////////////////////////////
+template< typename LeafFunction >
+void
+Bvh::traverse(
+              const HostRay  &ray,
+              LeafFunction    leaf,
+              TraversalStats *pStats
+              ) const
+{
+
+  if ( nodes_.empty( ) )
+  {
+    return;
+  }
+
+  Float3 inverseDirection = {
+    1.0f / ray.direction.x,
+    1.0f / ray.direction.y,
+    1.0f / ray.direction.z
+  };
+
+  float tmax = ray.tmax;
+  float entry;
+
+  if ( !intersectAabb( nodes_[ 0 ].bounds, ray.origin, inverseDirection, ray.tmin, tmax, &entry ) )
+  {
+    return;
+  }
+
+  std::uint32_t stack[ 128 ];
+  int           stackSize = 0;
+  std::uint32_t nodeIndex = 0;
+
+  while ( true )
+  {
+
+    const BvhNode &node = nodes_[ nodeIndex ];
+
+    if ( pStats )
+    {
+      ++pStats->nodes;
+    }
+
+    if ( node.count > 0 )
+    {
+
+      for ( std::uint32_t i = 0; i < node.count; ++i )
+      {
+
+        if ( pStats )
+        {
+          ++pStats->tests;
+        }
+
+        if ( leaf( indices_[ node.first + i ], &tmax ) )
+        {
+          return;
+        }
+
+      }
+
+    }
+    else
+    {
+
+      float entryA, entryB;
+      bool hitA = intersectAabb( nodes_[ node.first ].bounds,     ray.origin, inverseDirection, ray.tmin, tmax, &entryA );
+      bool hitB = intersectAabb( nodes_[ node.first + 1 ].bounds, ray.origin, inverseDirection, ray.tmin, tmax, &entryB );
+
+      if ( hitA && hitB )
+      {
+
+        // visit the nearer child first, the other one later
+        bool aFirst = entryA <= entryB;
+        stack[ stackSize++ ] = aFirst ? node.first + 1 : node.first;
+        nodeIndex            = aFirst ? node.first : node.first + 1;
+        continue;
+
+      }
+
+      if ( hitA || hitB )
+      {
+
+        nodeIndex = hitA ? node.first : node.first + 1;
+        continue;
+
+      }
+
+    }
+
+    if ( stackSize == 0 )
+    {
+      return;
+    }
+
+    nodeIndex = stack[ --stackSize ];
+
+  }
+
+} // Bvh::traverse
+
+
+} // namespace light
+
+
+#endif // HostBvh_hpp
@@ -0,0 +1,197 @@
+#ifndef HostMath_hpp
+#define HostMath_hpp
+
+
+#include <cmath>
+#include <algorithm>
+#include "SceneDescription.hpp"
+
+
+namespace light
+{
+
+
+inline Float3 operator+( Float3 a, Float3 b ) { return Float3 { a.x + b.x, a.y + b.y, a.z + b.z }; }
+inline Float3 operator-( Float3 a, Float3 b ) { return Float3 { a.x - b.x, a.y - b.y, a.z - b.z }; }
+inline Float3 operator*( Float3 a, Float3 b ) { return Float3 { a.x * b.x, a.y * b.y, a.z * b.z }; }
+inline Float3 operator*( Float3 a, float s )  { return Float3 { a.x * s, a.y * s, a.z * s }; }
+inline Float3 operator*( float s, Float3 a )  { return a * s; }
+inline Float3 operator-( Float3 a )           { return Float3 { -a.x, -a.y, -a.z }; }
+
+
+inline
+float
+dot(
+    Float3 a,
+    Float3 b
+    )
+{
+
+  return a.x * b.x + a.y * b.y + a.z * b.z;
+
+}
+
+
+inline
+Float3
+cross(
+      Float3 a,
+      Float3 b
+      )
+{
+
+  return Float3 {
+    a.y * b.z - a.z * b.y,
+    a.z * b.x - a.x * b.z,
+    a.x * b.y - a.y * b.x
+  };
+
+}
+
+
+inline
+Float3
+normalize( Float3 v )
+{
+
+  return v * ( 1.0f / std::sqrt( dot( v, v ) ) );
+
+}
+
+
+inline
+Float3
+minimum(
+        Float3 a,
+        Float3 b
+        )
+{
+
+  return Float3 { std::min( a.x, b.x ), std::min( a.y, b.y ), std::min( a.z, b.z ) };
+
+}
+
+
+inline
+Float3
+maximum(
+        Float3 a,
+        Float3 b
+        )
+{
+
+  return Float3 { std::max( a.x, b.x ), std::max( a.y, b.y ), std::max( a.z, b.z ) };
+
+}
+
+
+inline
+float
+component(
+          Float3 v,
+          int    axis
+          )
+{
+
+  return axis == 0 ? v.x : ( axis == 1 ? v.y : v.z );
+
+}
+
+
+///////////////////////////////////////////////////////////////
+/// \brief transformVector
+///
+///        Applies only the linear part of 'transform'
+///////////////////////////////////////////////////////////////
+inline
+Float3
+transformVector(
+                const Transform &transform,
+                Float3           v
+                )
+{
+
+  const float *m = transform.m;
+
+  return Float3 {
+    m[ 0 ] * v.x + m[ 1 ] * v.y + m[ 2 ]  * v.z,
+    m[ 4 ] * v.x + m[ 5 ] * v.y + m[ 6 ]  * v.z,
+    m[ 8 ] * v.x + m[ 9 ] * v.y + m[ 10 ] * v.z
+  };
+
+}
+
+
+///////////////////////////////////////////////////////////////
+/// \brief transformNormal
+///
+///        Transforms an object space normal with the
+///        transpose of 'inverse' (the world to object matrix)
+///////////////////////////////////////////////////////////////
+inline
+Float3
+transformNormal(
+                const Transform &inverse,
+                Float3           n
+                )
+{
+
+  const float *m = inverse.m;
+
+  return Float3 {
+    m[ 0 ] * n.x + m[ 4 ] * n.y + m[ 8 ]  * n.z,
+    m[ 1 ] * n.x + m[ 5 ] * n.y + m[ 9 ]  * n.z,
+    m[ 2 ] * n.x + m[ 6 ] * n.y + m[ 10 ] * n.z
+  };
+
+}
+
+
+///////////////////////////////////////////////////////////////
+/// \brief invertTransform
+///
+///        Inverse of an affine 3x4 transform. Singular
+///        transforms give non-finite values.
+///////////////////////////////////////////////////////////////
+inline
+Transform
+invertTransform( const Transform &transform )
+{
+
+  const float *m = transform.m;
+
+  // cofactors of the linear part
+  float c00 = m[ 5 ] * m[ 10 ] - m[ 6 ] * m[ 9 ];
+  float c01 = m[ 6 ] * m[ 8 ]  - m[ 4 ] * m[ 10 ];
+  float c02 = m[ 4 ] * m[ 9 ]  - m[ 5 ] * m[ 8 ];
+
+  float invDet = 1.0f / ( m[ 0 ] * c00 + m[ 1 ] * c01 + m[ 2 ] * c02 );
+
+  Transform inverse;
+  float *r = inverse.m;
+
+  r[ 0 ]  = c00 * invDet;
+  r[ 1 ]  = ( m[ 2 ] * m[ 9 ]  - m[ 1 ] * m[ 10 ] ) * invDet;
+  r[ 2 ]  = ( m[ 1 ] * m[ 6 ]  - m[ 2 ] * m[ 5 ] )  * invDet;
+  r[ 4 ]  = c01 * invDet;
+  r[ 5 ]  = ( m[ 0 ] * m[ 10 ] - m[ 2 ] * m[ 8 ] )  * invDet;
+  r[ 6 ]  = ( m[ 2 ] * m[ 4 ]  - m[ 0 ] * m[ 6 ] )  * invDet;
+  r[ 8 ]  = c02 * invDet;
+  r[ 9 ]  = ( m[ 1 ] * m[ 8 ]  - m[ 0 ] * m[ 9 ] )  * invDet;
+  r[ 10 ] = ( m[ 0 ] * m[ 5 ]  - m[ 1 ] * m[ 4 ] )  * invDet;
+
+  Float3 translation = transformVector( inverse, Float3 { m[ 3 ], m[ 7 ], m[ 11 ] } );
+
+  r[ 3 ]  = -translation.x;
+  r[ 7 ]  = -translation.y;
+  r[ 11 ] = -translation.z;
+
+  return inverse;
+
+} // invertTransform
+
+
+} // namespace light
+
+
+#endif // HostMath_hpp
@@ -0,0 +1,640 @@
+#include "HostRenderer.hpp"
+#include <cmath>
+#include <chrono>
+#include <algorithm>
+#include "HostMath.hpp"
+#include "Sampling.hpp"
+#include "Microfacet.hpp"
+#include "Bsdf.hpp"
+#include "Instrumentation.hpp"
+
+
+namespace light
+{
+
+
+namespace
+{
+
+
+constexpr float pi = 3.14159265358979323846f;
+
+constexpr std::size_t bytesPerPixel = 4 * sizeof( float );
+
+// OptixRenderer's scene_epsilon, for the path tracer's rays
+constexpr float sceneEpsilon = 1e-2f;
+
+
+///
+/// \brief hashPixel
+/// \return well mixed start of a pixel's random sequence
+///
+std::uint32_t
+hashPixel(
+          unsigned x,
+          unsigned y,
+          unsigned seed
+          )
+{
+
+  std::uint32_t hash = x * 73856093u ^ y * 19349663u ^ seed * 83492791u;
+
+  hash ^= hash >> 16;
+  hash *= 0x7feb352du;
+  hash ^= hash >> 15;
+  hash *= 0x846ca68bu;
+  hash ^= hash >> 16;
+
+  return hash;
+
+}
+
+
+float
+nextRandom( std::uint32_t *pState )
+{
+
+  *pState = *pState * 1664525u + 1013904223u;
+
+  return static_cast< float >( *pState >> 8 ) / 16777216.0f;
+
+}
+
+
+float
+average( Float3 v )
+{
+
+  return ( v.x + v.y + v.z ) / 3.0f;
+
+}
+
+
+///
+/// \brief playRoulette
+///
+///        Ends the path that just picked its next direction or
+///        scales up its throughput, like the device's playRoulette
+///
+void
+playRoulette(
+             const HostRenderSettings &settings,
+             HostPath                 *pPath,
+             std::uint32_t            *pState
+             )
+{
+
+  Float3 &attenuation = pPath->attenuation;
+
+  float throughput = std::max( attenuation.x, std::max( attenuation.y, attenuation.z ) );
+
+  // compare split paths to the path they were split from
+  if ( pPath->depth > 0 )
+  {
+    throughput *= std::max( 1u, settings.splits );
+  }
+
+  float survival = survivalProbability(
+                                       settings.roulette,
+                                       throughput,
+                                       settings.rouletteScale,
+                                       pPath->depth,
+                                       static_cast< int >( settings.minDepth )
+                                       );
+
+  if ( survival >= 1.0f )
+  {
+    return;
+  }
+
+  if ( nextRandom( pState ) < survival )
+  {
+    attenuation = attenuation * ( 1.0f / survival );
+  }
+  else
+  {
+    pPath->done = true;
+  }
+
+}
+
+
+} // namespace
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief HostRenderer::HostRenderer
+///////////////////////////////////////////////////////////////
+HostRenderer::HostRenderer(
+                           const HostScene &scene,
+                           unsigned         width,
+                           unsigned         height
+                           )
+  : scene_ ( scene )
+  , width_ ( width )
+  , height_( height )
+  , eye_   { 0.0f, 0.0f, 0.0f }
+  , U_     { 1.0f, 0.0f, 0.0f }
+  , V_     { 0.0f, 1.0f, 0.0f }
+  , W_     { 0.0f, 0.0f, -1.0f }
+{}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief HostRenderer::setCamera
+///////////////////////////////////////////////////////////////
+void
+HostRenderer::setCamera(
+                        Float3 eye,
+                        Float3 U,
+                        Float3 V,
+                        Float3 W
+                        )
+{
+
+  eye_ = eye;
+  U_   = U;
+  V_   = V;
+  W_   = W;
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief HostRenderer::render
+///////////////////////////////////////////////////////////////
+HostFrameStats
+HostRenderer::render( const HostRenderSettings &settings )
+{
+
+  HostFrameStats stats;
+
+  stats.numThreads = std::max( 1u, settings.numThreads );
+  stats.tileSize   = settings.tileSize > 0
+                     ? settings.tileSize
+                     : TileScheduler::chooseTileSize( width_, height_, stats.numThreads, bytesPerPixel );
+
+  if ( !upFramebuffer_ || upFramebuffer_->getTileSize( ) != stats.tileSize )
+  {
+    upFramebuffer_.reset( new TiledFramebuffer( width_, height_, stats.tileSize ) );
+  }
+
+  TileScheduler scheduler( width_, height_, stats.tileSize, settings.order );
+
+  unsigned sqrtSamples = std::max( 1u, settings.sqrtSamples );
+  float    sampleScale = 1.0f / static_cast< float >( sqrtSamples * sqrtSamples );
+
+  auto start = std::chrono::steady_clock::now( );
+
+  scheduler.run(
+                stats.numThreads,
+                [ & ]( const Tile &tile )
+                {
+
+                  for ( unsigned y = tile.y; y < tile.y + tile.height; ++y )
+                  {
+
+                    for ( unsigned x = tile.x; x < tile.x + tile.width; ++x )
+                    {
+
+                      std::uint32_t state    = hashPixel( x, y, settings.seed );
+                      Float3        radiance = { 0.0f, 0.0f, 0.0f };
+
+                      // stratified jitter like the device cameras
+                      for ( unsigned sy = 0; sy < sqrtSamples; ++sy )
+                      {
+
+                        for ( unsigned sx = 0; sx < sqrtSamples; ++sx )
+                        {
+
+                          float jx = ( sx + nextRandom( &state ) ) / sqrtSamples;
+                          float jy = ( sy + nextRandom( &state ) ) / sqrtSamples;
+
+                          float dx = ( x + jx ) * 2.0f / width_ - 1.0f;
+                          float dy = ( y + jy ) * 2.0f / height_ - 1.0f;
+
+                          HostRay ray = { eye_, mathNormalize( U_ * dx + V_ * dy + W_, settings.math ), 0.0f, 1e30f };
+
+                          radiance = radiance + ( settings.pathTracing
+                                                  ? _tracePath( ray, settings, &state )
+                                                  : _shade( ray, settings.math ) );
+
+                        }
+
+                      }
+
+                      float *pPixel = upFramebuffer_->getPixel( x, y );
+
+                      pPixel[ 0 ] = radiance.x * sampleScale;
+                      pPixel[ 1 ] = radiance.y * sampleScale;
+                      pPixel[ 2 ] = radiance.z * sampleScale;
+                      pPixel[ 3 ] = 1.0f;
+
+                    }
+
+                  }
+
+                  LIGHT_PROFILE_COUNT( SAMPLES, tile.width * tile.height * sqrtSamples * sqrtSamples );
+
+                }
+                );
+
+  stats.seconds = std::chrono::duration< double >( std::chrono::steady_clock::now( ) - start ).count( );
+  stats.samples = static_cast< std::uint64_t >( width_ ) * height_ * sqrtSamples * sqrtSamples;
+
+  return stats;
+
+} // HostRenderer::render
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief HostRenderer::getPixels
+///////////////////////////////////////////////////////////////
+std::vector< float >
+HostRenderer::getPixels( ) const
+{
+
+  std::vector< float > pixels;
+
+  if ( upFramebuffer_ )
+  {
+    upFramebuffer_->toScanline( &pixels );
+  }
+  else
+  {
+    pixels.assign( static_cast< std::size_t >( width_ ) * height_ * 4, 0.0f );
+  }
+
+  return pixels;
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief HostRenderer::_shade
+///
+///        Direct light only: a lambertian surface with the
+///        material's albedo, lit by each illuminator sampled at
+///        its center through one shadow ray. Unlike
+///        closest_hit_simple_shading it uses the material albedo
+///        rather than a fixed 0.8, and never bounces.
+///////////////////////////////////////////////////////////////
+Float3
+HostRenderer::_shade(
+                     const HostRay &ray,
+                     MathPrecision  precision
+                     ) const
+{
+
+  HostHit hit;
+
+  if ( !scene_.intersect( ray, &hit ) )
+  {
+    return Float3 { 0.0f, 0.0f, 0.0f };
+  }
+
+  const SceneDescription &description = scene_.getSceneDescription( );
+  const MaterialRecord   &material    = description.getMaterials( )[ hit.material ];
+
+  if ( isEmissive( material ) )
+  {
+    return material.emission;
+  }
+
+  const float epsilon = 1e-3f;
+
+  Float3 point    = ray.origin + ray.direction * hit.t;
+  Float3 normal   = dot( hit.normal, ray.direction ) > 0.0f ? -hit.normal : hit.normal;
+  Float3 radiance = { 0.0f, 0.0f, 0.0f };
+
+  for ( const IlluminatorRecord &illuminator : description.getIlluminators( ) )
+  {
+
+    Float3 toLight         = illuminator.center - point;
+    float  distanceSquared = dot( toLight, toLight );
+    float  inverseDistance = mathRsqrt( distanceSquared, precision );
+    float  distance        = distanceSquared * inverseDistance;
+
+    if ( distance <= illuminator.radius )
+    {
+      continue;
+    }
+
+    Float3 direction = toLight * inverseDistance;
+    float  cosAngle  = dot( normal, direction );
+
+    if ( cosAngle <= 0.0f )
+    {
+      continue;
+    }
+
+    // stop at the light's surface so it doesn't occlude itself; t runs
+    // along toLight, so a fast inverse distance can't overshoot it
+    HostRay shadowRay = {
+      point,
+      toLight,
+      epsilon * inverseDistance,
+      1.0f - ( illuminator.radius + epsilon ) * inverseDistance
+    };
+
+    if ( scene_.occluded( shadowRay ) )
+    {
+      continue;
+    }
+
+    // lambertian surface, flux / 4 and the device's pi pdf
+    radiance = radiance + material.albedo * illuminator.radiantFlux
+               * ( cosAngle / ( 4.0f * pi * pi * distanceSquared ) );
+
+  }
+
+  return radiance;
+
+} // HostRenderer::_shade
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief HostRenderer::_tracePath
+///
+///        One camera sample through the bounce loop of the
+///        pinhole camera program: each hit adds its radiance
+///        times the throughput it was reached with, and the
+///        first hit's bounce is split settings.splits ways
+///////////////////////////////////////////////////////////////
+Float3
+HostRenderer::_tracePath(
+                         const HostRay            &ray,
+                         const HostRenderSettings &settings,
+                         std::uint32_t            *pState
+                         ) const
+{
+
+  // a camera that stops at the first hit has no bounce to split
+  unsigned splits = settings.maxBounces > 0 ? std::max( 1u, settings.splits ) : 1u;
+
+  Float3 total = { 0.0f, 0.0f, 0.0f };
+
+  for ( unsigned branch = 0; branch < splits; ++branch )
+  {
+
+    // later branches never start on a light, see below
+    HostPath path;
+    path.splitBranch = branch > 0;
+
+    HostRay segment = ray;
+
+    for ( ; ; )
+    {
+
+      Float3 attenuation = path.attenuation;
+
+      total = total + _shadeBsdf( segment, settings, &path, pState ) * attenuation;
+
+      if ( path.depth >= static_cast< int >( settings.maxBounces ) || path.done )
+      {
+        break;
+      }
+
+      if ( path.depth == 0 )
+      {
+
+        path.attenuation = path.attenuation * ( 1.0f / splits );
+        path.splitBranch = false;
+
+      }
+
+      ++path.depth;
+      segment = HostRay { path.origin, path.direction, sceneEpsilon, 1e30f };
+
+    }
+
+    // nothing to split when the first hit picked no bounce
+    if ( !path.bounced )
+    {
+      break;
+    }
+
+  }
+
+  return total;
+
+} // HostRenderer::_tracePath
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief HostRenderer::_shadeBsdf
+///
+///        closest_hit_bsdf on the host: light sampled on each
+///        illuminator's sphere and shaded with the Oren-Nayar
+///        and GGX lobes, then the next direction picked by the
+///        roulette policy. Only geometric normals are available,
+///        so meshes shade flat.
+/// \return radiance leaving the hit towards the ray's origin
+///////////////////////////////////////////////////////////////
+Float3
+HostRenderer::_shadeBsdf(
+                         const HostRay            &ray,
+                         const HostRenderSettings &settings,
+                         HostPath                 *pPath,
+                         std::uint32_t            *pState
+                         ) const
+{
+
+  const Float3 black = { 0.0f, 0.0f, 0.0f };
+
+  HostHit hit;
+
+  // black background, like OptixRenderer
+  if ( !scene_.intersect( ray, &hit ) )
+  {
+
+    pPath->done = true;
+    return black;
+
+  }
+
+  const SceneDescription &description = scene_.getSceneDescription( );
+  const MaterialRecord   &material    = description.getMaterials( )[ hit.material ];
+
+  if ( isEmissive( material ) )
+  {
+
+    pPath->done = true;
+    return pPath->countEmitted ? material.emission : black;
+
+  }
+
+  MathPrecision precision = settings.math;
+
+  Float3 point  = ray.origin + ray.direction * hit.t;
+  Float3 normal = dot( hit.normal, ray.direction ) > 0.0f ? -hit.normal : hit.normal;
+  Float3 w_v    = -ray.direction;
+
+  float  cosNV = dot( normal, w_v );
+  Float3 F     = dielectricFresnel( cosNV, material.ior );
+
+  Float3 radiance = black;
+
+  //
+  // direct light, skipped by split branches: the first branch
+  // sampled it
+  //
+  if ( !pPath->splitBranch )
+  {
+
+    for ( const IlluminatorRecord &illuminator : description.getIlluminators( ) )
+    {
+
+      // a point on the half of the sphere facing the surface
+      Float3 offset = sampleUniformSphere< Float3 >( nextRandom( pState ), nextRandom( pState ) );
+
+      if ( dot( offset, point - illuminator.center ) < 0.0f )
+      {
+        offset = -offset;
+      }
+
+      Float3 lightPos = illuminator.center + offset * illuminator.radius;
+
+      Float3 w_l         = lightPos - point;
+      float  distToLight = std::sqrt( dot( w_l, w_l ) );
+      w_l = w_l * ( 1.0f / distToLight );
+
+      float cosNL = dot( normal, w_l );
+
+      if ( cosNL <= 0.0f )
+      {
+        continue;
+      }
+
+      // stop short of the light's own surface
+      HostRay shadowRay = { point, w_l, sceneEpsilon, distToLight - sceneEpsilon };
+
+      if ( scene_.occluded( shadowRay ) )
+      {
+        continue;
+      }
+
+      // lambertian emitter and the device's pi pdf
+      float totalDistance = distToLight + illuminator.radius;
+      float emitted       = 0.5f * std::max( 0.0f, -dot( w_l, mathNormalize( lightPos - illuminator.center, precision ) ) );
+
+      Float3 localRadiance = illuminator.radiantFlux * ( emitted * cosNL / ( totalDistance * totalDistance * pi ) );
+
+      Float3 specular = black;
+
+      if ( pPath->useSpecular )
+      {
+
+        Float3 H     = mathNormalize( w_v + w_l, precision );
+        float  alpha = ggxAlpha( material.roughness );
+
+        specular = dielectricFresnel( dot( w_v, H ), material.ior )
+                   * ggxReflection( cosNV, cosNL, dot( normal, H ), alpha );
+
+      }
+
+      Float3 diffuse = orenNayarDiffuse( material.albedo, material.roughness, cosNL, cosNV, dot( w_l, w_v ) );
+
+      radiance = radiance + localRadiance * ( diffuse * ( Float3 { 1.0f, 1.0f, 1.0f } - F ) + specular );
+
+    }
+
+  }
+
+  //
+  // next direction, by the same lobe weights and roulette
+  //
+  Float3 diffuseWeight = material.albedo * ( Float3 { 1.0f, 1.0f, 1.0f } - F );
+
+  float scatterProb;
+  float reflectProb;
+
+  lobeProbabilities( settings.roulette, average( diffuseWeight ), average( F ), scatterProb, reflectProb );
+
+  float rouletteVal = nextRandom( pState );
+
+  // split branches share the first hit's absorption
+  if ( pPath->splitBranch )
+  {
+    rouletteVal *= std::min( scatterProb + reflectProb, 1.0f );
+  }
+
+  rouletteVal -= scatterProb;
+
+  if ( rouletteVal <= 0.0f )
+  {
+
+    float z1 = nextRandom( pState );
+    float z2 = nextRandom( pState );
+
+    pPath->bounced      = true;
+    pPath->origin       = point;
+    pPath->direction    = alignToNormal( sampleCosineHemisphere< Float3 >( z1, z2 ), normal );
+    pPath->attenuation  = pPath->attenuation * diffuseWeight * ( 1.0f / scatterProb );
+    pPath->countEmitted = false;
+    pPath->useSpecular  = false;
+
+    playRoulette( settings, pPath, pState );
+
+    return radiance;
+
+  }
+
+  rouletteVal -= reflectProb;
+
+  if ( rouletteVal <= 0.0f )
+  {
+
+    pPath->bounced = true;
+
+    float z1 = nextRandom( pState );
+    float z2 = nextRandom( pState );
+
+    float alpha = ggxAlpha( material.roughness );
+
+    Float3 b1, b2;
+    orthonormalBasis( normal, b1, b2 );
+
+    Float3 v = { dot( w_v, b1 ), dot( w_v, b2 ), std::max( cosNV, 1.0e-4f ) };
+    Float3 h = sampleGgxVndf( v, alpha, z1, z2 );
+
+    float  cosVH = dot( v, h );
+    Float3 l     = h * ( 2.0f * cosVH ) - v;
+
+    // reflected under the surface, lost to single scattering
+    if ( l.z <= 0.0f )
+    {
+
+      pPath->done = true;
+      return radiance;
+
+    }
+
+    pPath->origin      = point;
+    pPath->direction   = b1 * l.x + b2 * l.y + normal * l.z;
+    pPath->attenuation = pPath->attenuation * dielectricFresnel( cosVH, material.ior )
+                         * ( ggxReflectionWeight( v.z, l.z, alpha ) / reflectProb );
+
+    playRoulette( settings, pPath, pState );
+
+    return radiance;
+
+  }
+
+  // absorbed
+  pPath->done = true;
+
+  return radiance;
+
+} // HostRenderer::_shadeBsdf
+
+
+
+} // namespace light
@@ -0,0 +1,175 @@
+#ifndef HostRenderer_hpp
+#define HostRenderer_hpp
+
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include "HostScene.hpp"
+#include "FastMath.hpp"
+#include "Roulette.hpp"
+#include "TileScheduler.hpp"
+#include "TiledFramebuffer.hpp"
+
+
+namespace light
+{
+
+
+/////////////////////////////////////////////
+/// \brief The HostRenderSettings struct
+/////////////////////////////////////////////
+struct HostRenderSettings
+{
+  unsigned  sqrtSamples = 1;
+  unsigned  numThreads  = 1;
+  unsigned  tileSize    = 0; // 0 lets TileScheduler::chooseTileSize pick
+  TileOrder order       = TileOrder::HILBERT;
+  unsigned  seed        = 0;
+
+  MathPrecision math = MATH_PRECISE; // MATH_FAST for previews
+
+  // paths that bounce like closest_hit_bsdf instead of direct
+  // light only, with the device's bounce and roulette settings
+  bool           pathTracing   = false;
+  unsigned       maxBounces    = 3;
+  RoulettePolicy roulette      = ROULETTE_THROUGHPUT;
+  unsigned       minDepth      = 2;
+  unsigned       splits        = 1;    // first bounce splits
+  float          rouletteScale = 1.0f; // ROULETTE_EFFICIENCY's scale, one for every pixel
+};
+
+
+/////////////////////////////////////////////
+/// \brief The HostPath struct
+///
+///        What a host path carries from one bounce to the next,
+///        the fields of PerRayData_pathtrace closest_hit_bsdf
+///        reads and writes
+/////////////////////////////////////////////
+struct HostPath
+{
+  Float3 attenuation  = { 1.0f, 1.0f, 1.0f };
+  Float3 origin       = { 0.0f, 0.0f, 0.0f };
+  Float3 direction    = { 0.0f, 0.0f, 0.0f };
+  int    depth        = 0;
+  bool   countEmitted = true;
+  bool   useSpecular  = true;
+  bool   splitBranch  = false;
+  bool   bounced      = false;
+  bool   done         = false;
+};
+
+
+/////////////////////////////////////////////
+/// \brief The HostFrameStats struct
+/////////////////////////////////////////////
+struct HostFrameStats
+{
+  std::uint64_t samples    = 0;
+  double        seconds    = 0.0;
+  unsigned      tileSize   = 0;
+  unsigned      numThreads = 0;
+
+  double getSamplesPerSecond ( ) const { return seconds > 0.0 ? samples / seconds : 0.0; }
+};
+
+
+/////////////////////////////////////////////
+/// \brief The HostRenderer class
+///
+///        Renders a HostScene tile by tile on any number of
+///        threads. By default it computes direct lighting only:
+///        lambertian surfaces with their material albedo, lit by
+///        every illuminator through a shadow ray to its center.
+///        With HostRenderSettings::pathTracing it follows the
+///        pinhole camera and closest_hit_bsdf instead, through
+///        the same shared headers. Each pixel seeds its own
+///        random numbers, so images don't depend on the thread
+///        count or tile size.
+/////////////////////////////////////////////
+class HostRenderer
+{
+
+public:
+
+  HostRenderer(
+               const HostScene &scene,
+               unsigned         width,
+               unsigned         height
+               );
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief setCamera
+  ///
+  ///        Pinhole camera, rays go through eye + x U + y V + W
+  ///        for x, y in [-1, 1]
+  ///////////////////////////////////////////////////////////////
+  void setCamera (
+                  Float3 eye,
+                  Float3 U,
+                  Float3 V,
+                  Float3 W
+                  );
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief render
+  ///
+  ///        Renders one frame of sqrtSamples^2 jittered samples
+  ///        per pixel, replacing the previous one
+  ///////////////////////////////////////////////////////////////
+  HostFrameStats render ( const HostRenderSettings &settings );
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief getPixels
+  /// \return RGBA rows bottom-up, like the OptiX output buffer
+  ///////////////////////////////////////////////////////////////
+  std::vector< float > getPixels ( ) const;
+
+
+  unsigned getWidth  ( ) const { return width_; }
+  unsigned getHeight ( ) const { return height_; }
+
+
+private:
+
+  Float3 _shade (
+                 const HostRay &ray,
+                 MathPrecision  precision
+                 ) const;
+
+  Float3 _tracePath (
+                     const HostRay            &ray,
+                     const HostRenderSettings &settings,
+                     std::uint32_t            *pState
+                     ) const;
+
+  Float3 _shadeBsdf (
+                     const HostRay            &ray,
+                     const HostRenderSettings &settings,
+                     HostPath                 *pPath,
+                     std::uint32_t            *pState
+                     ) const;
+
+  const HostScene &scene_;
+
+  unsigned width_;
+  unsigned height_;
+
+  Float3 eye_;
+  Float3 U_;
+  Float3 V_;
+  Float3 W_;
+
+  std::unique_ptr< TiledFramebuffer > upFramebuffer_;
+
+};
+
+
+} // namespace light
+
+
+#endif // HostRenderer_hpp
@@ -0,0 +1,683 @@
+#include "HostScene.hpp"
+#include "Instrumentation.hpp"
+#include <map>
+#include <cmath>
+
+
+namespace light
+{
+
+
+namespace
+{
+
+
+bool
+intersectSphere(
+                Float3         center,
+                float          radius,
+                const HostRay &ray,
+                float          tmax,
+                float         *pT,
+                Float3        *pNormal
+                )
+{
+
+  Float3 oc = ray.origin - center;
+
+  float a = dot( ray.direction, ray.direction );
+  float b = dot( oc, ray.direction );
+  float c = dot( oc, oc ) - radius * radius;
+
+  float discriminant = b * b - a * c;
+
+  if ( discriminant < 0.0f )
+  {
+    return false;
+  }
+
+  float root = std::sqrt( discriminant );
+  float t    = ( -b - root ) / a;
+
+  if ( t < ray.tmin )
+  {
+    t = ( -b + root ) / a; // inside the sphere
+  }
+
+  if ( t < ray.tmin || t > tmax )
+  {
+    return false;
+  }
+
+  *pT      = t;
+  *pNormal = ( oc + ray.direction * t ) * ( 1.0f / radius );
+
+  return true;
+
+}
+
+
+bool
+intersectBox(
+             Float3         boxMin,
+             Float3         boxMax,
+             const HostRay &ray,
+             float          tmax,
+             float         *pT,
+             Float3        *pNormal
+             )
+{
+
+  Float3 t0   = ( boxMin - ray.origin ) * Float3 { 1.0f / ray.direction.x, 1.0f / ray.direction.y, 1.0f / ray.direction.z };
+  Float3 t1   = ( boxMax - ray.origin ) * Float3 { 1.0f / ray.direction.x, 1.0f / ray.direction.y, 1.0f / ray.direction.z };
+  Float3 near = minimum( t0, t1 );
+  Float3 far  = maximum( t0, t1 );
+
+  int nearAxis = ( near.x >= near.y && near.x >= near.z ) ? 0 : ( near.y >= near.z ? 1 : 2 );
+  int farAxis  = ( far.x <= far.y && far.x <= far.z ) ? 0 : ( far.y <= far.z ? 1 : 2 );
+
+  float tNear = component( near, nearAxis );
+  float tFar  = component( far, farAxis );
+
+  if ( tNear > tFar )
+  {
+    return false;
+  }
+
+  // leaving the box from inside uses the far face
+  bool  entering = tNear >= ray.tmin;
+  float t        = entering ? tNear : tFar;
+  int   axis     = entering ? nearAxis : farAxis;
+
+  if ( t < ray.tmin || t > tmax )
+  {
+    return false;
+  }
+
+  float sign = ( component( ray.direction, axis ) < 0.0f ) == entering ? 1.0f : -1.0f;
+
+  *pT      = t;
+  *pNormal = Float3 {
+    axis == 0 ? sign : 0.0f,
+    axis == 1 ? sign : 0.0f,
+    axis == 2 ? sign : 0.0f
+  };
+
+  return true;
+
+} // intersectBox
+
+
+bool
+intersectQuad(
+              Float3         anchor,
+              Float3         v1,
+              Float3         v2,
+              const HostRay &ray,
+              float          tmax,
+              float         *pT,
+              Float3        *pNormal
+              )
+{
+
+  Float3 normal = normalize( cross( v1, v2 ) );
+  float  denom  = dot( normal, ray.direction );
+
+  if ( denom == 0.0f )
+  {
+    return false;
+  }
+
+  float t = ( dot( normal, anchor ) - dot( normal, ray.origin ) ) / denom;
+
+  if ( t < ray.tmin || t > tmax )
+  {
+    return false;
+  }
+
+  Float3 p  = ray.origin + ray.direction * t - anchor;
+  float  a1 = dot( v1, p ) / dot( v1, v1 );
+  float  a2 = dot( v2, p ) / dot( v2, v2 );
+
+  if ( a1 < 0.0f || a1 > 1.0f || a2 < 0.0f || a2 > 1.0f )
+  {
+    return false;
+  }
+
+  *pT      = t;
+  *pNormal = normal;
+
+  return true;
+
+}
+
+
+///
+/// \brief intersectTriangle
+///
+///        Moller-Trumbore
+///
+bool
+intersectTriangle(
+                  Float3         p0,
+                  Float3         p1,
+                  Float3         p2,
+                  const HostRay &ray,
+                  float          tmax,
+                  float         *pT,
+                  Float3        *pNormal
+                  )
+{
+
+  Float3 e1 = p1 - p0;
+  Float3 e2 = p2 - p0;
+  Float3 pv = cross( ray.direction, e2 );
+
+  float determinant = dot( e1, pv );
+
+  if ( std::abs( determinant ) < 1e-12f )
+  {
+    return false;
+  }
+
+  float inverse = 1.0f / determinant;
+
+  Float3 tv = ray.origin - p0;
+  float  u  = dot( tv, pv ) * inverse;
+
+  if ( u < 0.0f || u > 1.0f )
+  {
+    return false;
+  }
+
+  Float3 qv = cross( tv, e1 );
+  float  v  = dot( ray.direction, qv ) * inverse;
+
+  if ( v < 0.0f || u + v > 1.0f )
+  {
+    return false;
+  }
+
+  float t = dot( e2, qv ) * inverse;
+
+  if ( t < ray.tmin || t > tmax )
+  {
+    return false;
+  }
+
+  *pT      = t;
+  *pNormal = cross( e1, e2 );
+
+  return true;
+
+}
+
+
+} // namespace
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief HostScene::HostScene
+///////////////////////////////////////////////////////////////
+HostScene::HostScene(
+                     SceneDescription scene,
+                     unsigned         maxLeafSize
+                     )
+  : scene_( std::move( scene ) )
+{
+
+  scene_.validate( );
+
+  const std::vector< ShapeRecord >   &shapes          = scene_.getShapes( );
+  const std::vector< std::uint32_t > &shapePrimitives = scene_.getShapePrimitives( );
+
+  transformInstances_.resize( scene_.getTransforms( ).size( ) );
+
+  // shapes using the same primitives share a bottom level
+  std::map< std::vector< std::uint32_t >, std::uint32_t > bottomLevelIndices;
+
+  std::vector< Aabb > bounds;
+
+  for ( std::uint32_t s = 0; s < shapes.size( ); ++s )
+  {
+
+    const ShapeRecord &shape = shapes[ s ];
+
+    if ( shape.primitiveCount == 0 )
+    {
+      continue;
+    }
+
+    std::vector< std::uint32_t > primitives(
+                                            shapePrimitives.begin( ) + shape.firstPrimitive,
+                                            shapePrimitives.begin( ) + shape.firstPrimitive + shape.primitiveCount
+                                            );
+
+    auto found = bottomLevelIndices.find( primitives );
+
+    if ( found == bottomLevelIndices.end( ) )
+    {
+
+      BottomLevel level;
+
+      for ( std::uint32_t primitive : primitives )
+      {
+
+        const PrimitiveRecord &record = scene_.getPrimitives( )[ primitive ];
+
+        if ( record.type == PrimitiveType::MESH )
+        {
+
+          const MeshRecord &mesh = scene_.getMeshes( )[ record.mesh ];
+
+          for ( std::uint32_t t = 0; t < mesh.triangleCount; ++t )
+          {
+            level.elements.push_back( Element { primitive, mesh.firstTriangle + t } );
+          }
+
+        }
+        else
+        {
+
+          level.elements.push_back( Element { primitive, 0 } );
+
+        }
+
+      }
+
+      bounds.clear( );
+
+      for ( const Element &element : level.elements )
+      {
+        bounds.push_back( _getElementBounds( element ) );
+      }
+
+      level.bvh.build( bounds, maxLeafSize );
+      level.elements.shrink_to_fit( );
+
+      found = bottomLevelIndices.emplace( std::move( primitives ), static_cast< std::uint32_t >( bottomLevels_.size( ) ) ).first;
+      bottomLevels_.push_back( std::move( level ) );
+
+    }
+
+    Instance instance;
+    instance.objectToWorld = scene_.getTransforms( )[ shape.transform ];
+    instance.worldToObject = invertTransform( instance.objectToWorld );
+    instance.bottomLevel   = found->second;
+    instance.material      = shape.material;
+    instance.shape         = s;
+
+    transformInstances_[ shape.transform ].push_back( static_cast< std::uint32_t >( instances_.size( ) ) );
+    instances_.push_back( instance );
+
+  }
+
+  //
+  // top level over instance world bounds
+  //
+  for ( const Instance &instance : instances_ )
+  {
+    instanceBounds_.push_back( _getInstanceBounds( instance ) );
+  }
+
+  topLevel_.build( instanceBounds_, 1 );
+
+  geometryMemory_.set( scene_.getMemoryBytes( ) );
+  accelerationMemory_.set( getAccelerationBytes( ) );
+
+} // HostScene::HostScene
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief HostScene::applySceneChanges
+///////////////////////////////////////////////////////////////
+void
+HostScene::applySceneChanges(
+                             const SceneChanges &changes,
+                             unsigned            numThreads
+                             )
+{
+
+  if ( changes.transforms.empty( ) )
+  {
+    return;
+  }
+
+  LIGHT_PROFILE_SCOPE( SCENE_UPDATE );
+
+  for ( std::uint32_t transform : changes.transforms )
+  {
+
+    for ( std::uint32_t index : transformInstances_[ transform ] )
+    {
+
+      Instance &instance = instances_[ index ];
+
+      instance.objectToWorld = scene_.getTransforms( )[ transform ];
+      instance.worldToObject = invertTransform( instance.objectToWorld );
+
+      instanceBounds_[ index ] = _getInstanceBounds( instance );
+
+    }
+
+  }
+
+  topLevel_.refit( instanceBounds_, numThreads );
+
+  if ( getTopLevelCostGrowth( ) > rebuildThreshold_ )
+  {
+
+    topLevel_.build( instanceBounds_, 1 );
+    ++topLevelRebuilds_;
+
+  }
+
+  accelerationMemory_.set( getAccelerationBytes( ) );
+
+} // HostScene::applySceneChanges
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief HostScene::getTopLevelCostGrowth
+///////////////////////////////////////////////////////////////
+float
+HostScene::getTopLevelCostGrowth( ) const
+{
+
+  float built = topLevel_.getBuildSahCost( );
+
+  return built > 0.0f ? topLevel_.getSahCost( ) / built : 1.0f;
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief HostScene::intersect
+///////////////////////////////////////////////////////////////
+bool
+HostScene::intersect(
+                     const HostRay  &ray,
+                     HostHit        *pHit,
+                     TraversalStats *pStats
+                     ) const
+{
+
+  LIGHT_PROFILE_COUNT( RAYS, 1 );
+
+  return _trace< false >( ray, pHit, pStats );
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief HostScene::occluded
+///////////////////////////////////////////////////////////////
+bool
+HostScene::occluded(
+                    const HostRay  &ray,
+                    TraversalStats *pStats
+                    ) const
+{
+
+  LIGHT_PROFILE_COUNT( SHADOW_RAYS, 1 );
+
+  return _trace< true >( ray, nullptr, pStats );
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief HostScene::getAccelerationBytes
+///////////////////////////////////////////////////////////////
+std::size_t
+HostScene::getAccelerationBytes( ) const
+{
+
+  std::size_t bytes = topLevel_.getMemoryBytes( ) + instances_.capacity( ) * sizeof( Instance );
+
+  for ( const BottomLevel &level : bottomLevels_ )
+  {
+    bytes += level.bvh.getMemoryBytes( ) + level.elements.capacity( ) * sizeof( Element );
+  }
+
+  return bytes;
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief HostScene::_trace
+///
+///        Walks the top level, moves the ray into each candidate
+///        instance's object space and walks its bottom level.
+///        Directions aren't renormalized so distances agree in
+///        both spaces. Nodes of both levels are counted, but
+///        only bottom level items count as tests.
+///////////////////////////////////////////////////////////////
+template< bool ANY_HIT >
+bool
+HostScene::_trace(
+                  const HostRay  &ray,
+                  HostHit        *pHit,
+                  TraversalStats *pStats
+                  ) const
+{
+
+  bool hit = false;
+
+  TraversalStats topStats;
+
+  const Instance *pHitInstance = nullptr;
+  const Element  *pHitElement  = nullptr;
+  Float3          objectNormal = { 0.0f, 0.0f, 0.0f };
+  float           hitT         = ray.tmax;
+
+  topLevel_.traverse(
+                     ray,
+                     [ & ]( std::uint32_t instanceIndex, float *pTMax )
+                     {
+
+                       const Instance    &instance = instances_[ instanceIndex ];
+                       const BottomLevel &level    = bottomLevels_[ instance.bottomLevel ];
+
+                       HostRay local;
+                       local.origin    = transformPoint( instance.worldToObject, ray.origin );
+                       local.direction = transformVector( instance.worldToObject, ray.direction );
+                       local.tmin      = ray.tmin;
+                       local.tmax      = *pTMax;
+
+                       bool stop = false;
+
+                       level.bvh.traverse(
+                                          local,
+                                          [ & ]( std::uint32_t elementIndex, float *pLocalTMax )
+                                          {
+
+                                            float  t;
+                                            Float3 normal;
+
+                                            if ( !_intersectElement( level.elements[ elementIndex ], local, *pLocalTMax, &t, &normal ) )
+                                            {
+                                              return false;
+                                            }
+
+                                            hit = true;
+
+                                            if ( ANY_HIT )
+                                            {
+                                              stop = true;
+                                              return true;
+                                            }
+
+                                            *pLocalTMax  = t;
+                                            *pTMax       = t;
+                                            hitT         = t;
+                                            objectNormal = normal;
+                                            pHitInstance = &instance;
+                                            pHitElement  = &level.elements[ elementIndex ];
+
+                                            return false;
+
+                                          },
+                                          pStats
+                                          );
+
+                       return stop;
+
+                     },
+                     pStats ? &topStats : nullptr
+                     );
+
+  if ( pStats )
+  {
+    pStats->nodes += topStats.nodes;
+  }
+
+  if ( hit && !ANY_HIT )
+  {
+
+    pHit->t         = hitT;
+    pHit->normal    = normalize( transformNormal( pHitInstance->worldToObject, objectNormal ) );
+    pHit->shape     = pHitInstance->shape;
+    pHit->material  = pHitInstance->material;
+    pHit->primitive = pHitElement->primitive;
+
+  }
+
+  return hit;
+
+} // HostScene::_trace
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief HostScene::_intersectElement
+///////////////////////////////////////////////////////////////
+bool
+HostScene::_intersectElement(
+                             const Element &element,
+                             const HostRay &ray,
+                             float          tmax,
+                             float         *pT,
+                             Float3        *pNormal
+                             ) const
+{
+
+  const PrimitiveRecord &primitive = scene_.getPrimitives( )[ element.primitive ];
+
+  switch ( primitive.type )
+  {
+
+  case PrimitiveType::BOX:
+    return intersectBox( primitive.a, primitive.b, ray, tmax, pT, pNormal );
+
+  case PrimitiveType::SPHERE:
+    return intersectSphere( primitive.a, primitive.radius, ray, tmax, pT, pNormal );
+
+  case PrimitiveType::QUAD:
+    return intersectQuad( primitive.a, primitive.b, primitive.c, ray, tmax, pT, pNormal );
+
+  case PrimitiveType::MESH:
+  {
+
+    const MeshRecord    &mesh     = scene_.getMeshes( )[ primitive.mesh ];
+    const Float3        *pVertex  = scene_.getVertices( ).data( ) + mesh.firstVertex;
+    const std::uint32_t *pCorners = scene_.getTriangles( ).data( ) + element.triangle * 3;
+
+    return intersectTriangle(
+                             pVertex[ pCorners[ 0 ] ],
+                             pVertex[ pCorners[ 1 ] ],
+                             pVertex[ pCorners[ 2 ] ],
+                             ray,
+                             tmax,
+                             pT,
+                             pNormal
+                             );
+
+  }
+
+  } // switch
+
+  return false;
+
+} // HostScene::_intersectElement
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief HostScene::_getElementBounds
+///////////////////////////////////////////////////////////////
+Aabb
+HostScene::_getElementBounds( const Element &element ) const
+{
+
+  const PrimitiveRecord &primitive = scene_.getPrimitives( )[ element.primitive ];
+
+  Aabb bounds = Aabb::empty( );
+
+  switch ( primitive.type )
+  {
+
+  case PrimitiveType::BOX:
+    bounds.grow( primitive.a );
+    bounds.grow( primitive.b );
+    break;
+
+  case PrimitiveType::SPHERE:
+  {
+    Float3 r = { primitive.radius, primitive.radius, primitive.radius };
+    bounds.grow( primitive.a - r );
+    bounds.grow( primitive.a + r );
+    break;
+  }
+
+  case PrimitiveType::QUAD:
+    bounds.grow( primitive.a );
+    bounds.grow( primitive.a + primitive.b );
+    bounds.grow( primitive.a + primitive.c );
+    bounds.grow( primitive.a + primitive.b + primitive.c );
+    break;
+
+  case PrimitiveType::MESH:
+  {
+
+    const MeshRecord    &mesh     = scene_.getMeshes( )[ primitive.mesh ];
+    const Float3        *pVertex  = scene_.getVertices( ).data( ) + mesh.firstVertex;
+    const std::uint32_t *pCorners = scene_.getTriangles( ).data( ) + element.triangle * 3;
+
+    bounds.grow( pVertex[ pCorners[ 0 ] ] );
+    bounds.grow( pVertex[ pCorners[ 1 ] ] );
+    bounds.grow( pVertex[ pCorners[ 2 ] ] );
+    break;
+
+  }
+
+  } // switch
+
+  return bounds;
+
+} // HostScene::_getElementBounds
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief HostScene::_getInstanceBounds
+///////////////////////////////////////////////////////////////
+Aabb
+HostScene::_getInstanceBounds( const Instance &instance ) const
+{
+
+  return transformAabb( instance.objectToWorld, bottomLevels_[ instance.bottomLevel ].bvh.getBounds( ) );
+
+}
+
+
+
+} // namespace light
@@ -0,0 +1,210 @@
+#ifndef HostScene_hpp
+#define HostScene_hpp
+
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "HostBvh.hpp"
+#include "SceneDescription.hpp"
+#include "SceneEditor.hpp"
+#include "MemoryAccounting.hpp"
+
+
+namespace light
+{
+
+
+/////////////////////////////////////////////
+/// \brief The HostHit struct
+/////////////////////////////////////////////
+struct HostHit
+{
+  float         t;
+  Float3        normal;    // world space geometric normal, unit length
+  std::uint32_t shape;     // shape (instance) that was hit
+  std::uint32_t material;  // the instance's material
+  std::uint32_t primitive; // scene primitive index
+};
+
+
+/////////////////////////////////////////////
+/// \brief The HostScene class
+///
+///        Two-level acceleration structure for tracing a
+///        SceneDescription on the CPU. Every distinct set of
+///        primitives gets one bottom-level BVH in object space;
+///        each shape is an instance holding a transform and a
+///        material that points at one of them, and a top-level
+///        BVH covers the instances' world bounds. Memory grows
+///        with unique geometry plus the number of instances.
+/////////////////////////////////////////////
+class HostScene
+{
+
+public:
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief HostScene
+  /// \param scene description to trace, kept by the scene
+  /// \param maxLeafSize items per BVH leaf
+  ///////////////////////////////////////////////////////////////
+  explicit
+  HostScene(
+            SceneDescription scene,
+            unsigned         maxLeafSize = 4
+            );
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief intersect
+  /// \param pStats optional, counts nodes of both levels and
+  ///        primitive tests
+  /// \return true with the closest hit in [tmin, tmax]
+  ///////////////////////////////////////////////////////////////
+  bool intersect (
+                  const HostRay  &ray,
+                  HostHit        *pHit,
+                  TraversalStats *pStats = nullptr
+                  ) const;
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief occluded
+  /// \return true if anything is hit in [tmin, tmax]
+  ///////////////////////////////////////////////////////////////
+  bool occluded (
+                 const HostRay  &ray,
+                 TraversalStats *pStats = nullptr
+                 ) const;
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief createSceneEditor
+  /// \return editor for this scene's description; pass what it
+  ///         collects to applySceneChanges
+  ///////////////////////////////////////////////////////////////
+  SceneEditor createSceneEditor ( ) { return SceneEditor( &scene_ ); }
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief applySceneChanges
+  ///
+  ///        Moves instances whose transforms changed and refits
+  ///        the top level around them. Once refitting has grown
+  ///        the top level's SAH cost past the rebuild threshold
+  ///        it is rebuilt instead. Bottom levels are in object
+  ///        space and never change for rigid motion; materials
+  ///        and lights are read from the description directly.
+  /// \param changes edits made with createSceneEditor's editor
+  /// \param numThreads threads used to refit large top levels
+  ///////////////////////////////////////////////////////////////
+  void applySceneChanges (
+                          const SceneChanges &changes,
+                          unsigned            numThreads = 1
+                          );
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief setRebuildThreshold
+  /// \param costGrowth refit top level SAH cost over its cost when
+  ///        built that triggers a rebuild
+  ///////////////////////////////////////////////////////////////
+  void setRebuildThreshold ( float costGrowth ) { rebuildThreshold_ = costGrowth; }
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief getTopLevelCostGrowth
+  /// \return current top level SAH cost over its cost when built
+  ///////////////////////////////////////////////////////////////
+  float getTopLevelCostGrowth ( ) const;
+
+  std::size_t getTopLevelRebuildCount ( ) const { return topLevelRebuilds_; }
+
+
+  const SceneDescription &getSceneDescription ( ) const { return scene_; }
+
+  std::size_t getBottomLevelCount ( ) const { return bottomLevels_.size( ); }
+  std::size_t getInstanceCount    ( ) const { return instances_.size( ); }
+
+  const Bvh &getTopLevel    ( ) const                   { return topLevel_; }
+  const Bvh &getBottomLevel ( std::size_t level ) const { return bottomLevels_[ level ].bvh; }
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief getAccelerationBytes
+  /// \return memory held by both BVH levels and the instances
+  ///////////////////////////////////////////////////////////////
+  std::size_t getAccelerationBytes ( ) const;
+
+
+private:
+
+  ///
+  /// \brief The Element struct
+  ///
+  ///        One intersectable item of a bottom level: an
+  ///        analytic primitive or one triangle of a mesh
+  ///
+  struct Element
+  {
+    std::uint32_t primitive;
+    std::uint32_t triangle; // scene triangle index (meshes only)
+  };
+
+  struct BottomLevel
+  {
+    std::vector< Element > elements;
+    Bvh                    bvh;
+  };
+
+  struct Instance
+  {
+    Transform     objectToWorld;
+    Transform     worldToObject;
+    std::uint32_t bottomLevel;
+    std::uint32_t material;
+    std::uint32_t shape;
+  };
+
+
+  template< bool ANY_HIT >
+  bool _trace (
+               const HostRay  &ray,
+               HostHit        *pHit,
+               TraversalStats *pStats
+               ) const;
+
+  bool _intersectElement (
+                          const Element &element,
+                          const HostRay &ray,
+                          float          tmax,
+                          float         *pT,
+                          Float3        *pNormal
+                          ) const;
+
+  Aabb _getElementBounds ( const Element &element ) const;
+
+  Aabb _getInstanceBounds ( const Instance &instance ) const;
+
+  SceneDescription           scene_;
+  std::vector< BottomLevel > bottomLevels_;
+  std::vector< Instance >    instances_;
+  Bvh                        topLevel_;
+
+  std::vector< Aabb >                           instanceBounds_;     // world bounds, top level items
+  std::vector< std::vector< std::uint32_t > >   transformInstances_; // instances using each transform
+
+  float       rebuildThreshold_ { 1.5f };
+  std::size_t topLevelRebuilds_ { 0 };
+
+  TrackedMemory geometryMemory_     { MemoryCategory::GEOMETRY };
+  TrackedMemory accelerationMemory_ { MemoryCategory::ACCELERATION };
+
+};
+
+
+} // namespace light
+
+
+#endif // HostScene_hpp
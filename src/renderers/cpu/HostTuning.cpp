@@ -0,0 +1,534 @@
+#include "HostTuning.hpp"
+#include <thread>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <stdexcept>
+#include <unistd.h>
+#include "Sampling.hpp"
+#include "SimdKernels.hpp"
+
+
+namespace light
+{
+
+
+namespace
+{
+
+
+const unsigned tileSizes[] = { 8, 16, 32, 64, 128 };
+
+// throughput within this fraction of the best counts as a tie
+constexpr double tuningTolerance = 0.03;
+
+// samples per kernel call when timing instruction sets
+constexpr std::size_t simdSampleCount = 16 * 1024;
+
+// kernel calls per timed run
+constexpr unsigned simdPasses = 16;
+
+
+unsigned
+getHardwareThreads( )
+{
+
+  return std::max( 1u, std::thread::hardware_concurrency( ) );
+
+}
+
+
+HostFrameStats
+fastestFrame(
+             HostRenderer             *pRenderer,
+             const HostRenderSettings &settings,
+             unsigned                  repeats
+             )
+{
+
+  HostFrameStats best;
+
+  for ( unsigned i = 0; i < std::max( 1u, repeats ); ++i )
+  {
+
+    HostFrameStats stats = pRenderer->render( settings );
+
+    if ( i == 0 || stats.seconds < best.seconds )
+    {
+      best = stats;
+    }
+
+  }
+
+  return best;
+
+}
+
+
+struct Vector
+{
+  float x, y, z;
+};
+
+
+///
+/// \brief The SimdWorkload struct
+///
+///        Uniform numbers, unit normals and view directions on
+///        the normals' side, and pixels, as separate arrays for
+///        the batched kernels
+///
+struct SimdWorkload
+{
+  std::vector< float > u1, u2, cosMax, alpha;
+  std::vector< float > nx, ny, nz, vx, vy, vz;
+  std::vector< float > rgba, reference;
+
+  std::vector< float >        x, y, z, pdf;
+  std::vector< std::uint8_t > rgb;
+  float                       squared  = 0.0f;
+  float                       relative = 0.0f;
+
+  SimdWorkload( );
+};
+
+
+SimdWorkload::SimdWorkload( )
+  : x( simdSampleCount )
+  , y( simdSampleCount )
+  , z( simdSampleCount )
+  , pdf( simdSampleCount )
+  , rgb( simdSampleCount * 3 )
+{
+
+  std::uint32_t seed = 1u;
+
+  auto rand = [ &seed ]( )
+  {
+
+    seed = seed * 1664525u + 1013904223u;
+
+    return static_cast< float >( seed >> 8 ) / 16777216.0f;
+
+  };
+
+  for ( std::size_t i = 0; i < simdSampleCount; ++i )
+  {
+
+    u1.push_back( rand( ) );
+    u2.push_back( rand( ) );
+    cosMax.push_back( 0.5f + 0.49f * rand( ) );
+    alpha.push_back( 0.05f + rand( ) );
+
+    Vector n = sampleUniformSphere< Vector >( rand( ), rand( ) );
+    Vector v = alignToNormal( sampleCosineHemisphere< Vector >( rand( ), rand( ) ), n );
+
+    nx.push_back( n.x );
+    ny.push_back( n.y );
+    nz.push_back( n.z );
+    vx.push_back( v.x );
+    vy.push_back( v.y );
+    vz.push_back( v.z );
+
+    for ( int c = 0; c < 4; ++c )
+    {
+
+      rgba.push_back( rand( ) );
+      reference.push_back( rand( ) );
+
+    }
+
+  }
+
+}
+
+
+///
+/// \brief timeSimdKernels
+/// \return seconds for the fastest of 'repeats' runs of every
+///         kernel in 'kernels' over the workload
+///
+double
+timeSimdKernels(
+                const SimdKernels &kernels,
+                SimdWorkload      *pWork,
+                unsigned           repeats
+                )
+{
+
+  SimdConstVectors normals { pWork->nx.data( ), pWork->ny.data( ), pWork->nz.data( ) };
+  SimdConstVectors views   { pWork->vx.data( ), pWork->vy.data( ), pWork->vz.data( ) };
+  SimdVectors      out     { pWork->x.data( ), pWork->y.data( ), pWork->z.data( ) };
+
+  double best = 0.0;
+
+  for ( unsigned i = 0; i < std::max( 1u, repeats ); ++i )
+  {
+
+    auto start = std::chrono::steady_clock::now( );
+
+    for ( unsigned pass = 0; pass < simdPasses; ++pass )
+    {
+
+      kernels.sampleCosineHemisphere( pWork->u1.data( ), pWork->u2.data( ), normals,
+                                      simdSampleCount, out, pWork->pdf.data( ) );
+
+      kernels.sampleUniformSphere( pWork->u1.data( ), pWork->u2.data( ), simdSampleCount, out );
+
+      kernels.sampleUniformCone( pWork->u1.data( ), pWork->u2.data( ), pWork->cosMax.data( ), normals,
+                                 simdSampleCount, out, pWork->pdf.data( ) );
+
+      kernels.sampleGgxVndf( pWork->u1.data( ), pWork->u2.data( ), pWork->alpha.data( ), normals, views,
+                             simdSampleCount, out, pWork->pdf.data( ) );
+
+      kernels.squaredErrors( pWork->rgba.data( ), pWork->reference.data( ), simdSampleCount, 1e-2f,
+                             &pWork->squared, &pWork->relative );
+
+      kernels.rgbaToRgb8( pWork->rgba.data( ), simdSampleCount, pWork->rgb.data( ) );
+
+    }
+
+    double seconds = std::chrono::duration< double >( std::chrono::steady_clock::now( ) - start ).count( );
+
+    if ( i == 0 || seconds < best )
+    {
+      best = seconds;
+    }
+
+  }
+
+  return best;
+
+}
+
+
+} // namespace
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief getScalingThreadCounts
+///////////////////////////////////////////////////////////////
+std::vector< unsigned >
+getScalingThreadCounts( unsigned maxThreads )
+{
+
+  maxThreads = std::max( 1u, maxThreads );
+
+  std::vector< unsigned > counts;
+
+  for ( unsigned count = 1; count < maxThreads; count *= 2 )
+  {
+    counts.push_back( count );
+  }
+
+  counts.push_back( maxThreads );
+
+  return counts;
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief measureScaling
+///////////////////////////////////////////////////////////////
+std::vector< ScalingResult >
+measureScaling(
+               HostRenderer                  *pRenderer,
+               const HostRenderSettings      &settings,
+               const std::vector< unsigned > &threadCounts,
+               unsigned                       repeats
+               )
+{
+
+  std::vector< ScalingResult > results;
+
+  for ( unsigned numThreads : threadCounts )
+  {
+
+    HostRenderSettings threadSettings = settings;
+    threadSettings.numThreads = numThreads;
+
+    HostFrameStats frame = fastestFrame( pRenderer, threadSettings, repeats );
+
+    ScalingResult result;
+    result.numThreads       = frame.numThreads;
+    result.seconds          = frame.seconds;
+    result.samplesPerSecond = frame.getSamplesPerSecond( );
+
+    double baseline = results.empty( ) ? result.samplesPerSecond : results.front( ).samplesPerSecond;
+
+    result.speedup    = baseline > 0.0 ? result.samplesPerSecond / baseline : 0.0;
+    result.efficiency = result.speedup / result.numThreads;
+
+    results.push_back( result );
+
+  }
+
+  return results;
+
+} // measureScaling
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief tuneHostRendering
+///////////////////////////////////////////////////////////////
+HostTuning
+tuneHostRendering(
+                  HostRenderer             *pRenderer,
+                  const HostRenderSettings &settings,
+                  unsigned                  maxThreads,
+                  unsigned                  repeats
+                  )
+{
+
+  HostTuning tuning;
+  tuning.host            = getHostName( );
+  tuning.hardwareThreads = getHardwareThreads( );
+
+  //
+  // thread count, with the renderer's own tile size choice
+  //
+  std::vector< ScalingResult > scaling = measureScaling(
+                                                        pRenderer,
+                                                        settings,
+                                                        getScalingThreadCounts( maxThreads ),
+                                                        repeats
+                                                        );
+
+  double best = 0.0;
+
+  for ( const ScalingResult &result : scaling )
+  {
+    best = std::max( best, result.samplesPerSecond );
+  }
+
+  for ( const ScalingResult &result : scaling )
+  {
+
+    if ( result.samplesPerSecond >= best * ( 1.0 - tuningTolerance ) )
+    {
+
+      tuning.numThreads = result.numThreads;
+      break;
+
+    }
+
+  }
+
+  //
+  // tile size at that thread count
+  //
+  HostRenderSettings tileSettings = settings;
+  tileSettings.numThreads = tuning.numThreads;
+
+  for ( unsigned tileSize : tileSizes )
+  {
+
+    tileSettings.tileSize = tileSize;
+
+    double samplesPerSecond = fastestFrame( pRenderer, tileSettings, repeats ).getSamplesPerSecond( );
+
+    if ( samplesPerSecond > tuning.samplesPerSecond )
+    {
+
+      tuning.tileSize         = tileSize;
+      tuning.samplesPerSecond = samplesPerSecond;
+
+    }
+
+  }
+
+  tuning.simdIsa = tuneSimdIsa( repeats );
+
+  return tuning;
+
+} // tuneHostRendering
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief tuneSimdIsa
+///////////////////////////////////////////////////////////////
+SimdIsa
+tuneSimdIsa( unsigned repeats )
+{
+
+  SimdWorkload work;
+
+  std::vector< double > seconds;
+
+  for ( int isa = 0; isa <= static_cast< int >( detectSimdIsa( ) ); ++isa )
+  {
+    seconds.push_back( timeSimdKernels( getSimdKernels( static_cast< SimdIsa >( isa ) ), &work, repeats ) );
+  }
+
+  double best = *std::min_element( seconds.begin( ), seconds.end( ) );
+
+  for ( std::size_t isa = 0; isa < seconds.size( ); ++isa )
+  {
+
+    if ( seconds[ isa ] * ( 1.0 - tuningTolerance ) <= best )
+    {
+      return static_cast< SimdIsa >( isa );
+    }
+
+  }
+
+  return detectSimdIsa( );
+
+} // tuneSimdIsa
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief getHostName
+///////////////////////////////////////////////////////////////
+std::string
+getHostName( )
+{
+
+  char name[ 256 ] = { };
+
+  if ( gethostname( name, sizeof( name ) - 1 ) != 0 || name[ 0 ] == '\0' )
+  {
+    return "unknown";
+  }
+
+  return name;
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief applyHostTuning
+///////////////////////////////////////////////////////////////
+bool
+applyHostTuning(
+                const HostTuning   &tuning,
+                HostRenderSettings *pSettings
+                )
+{
+
+  if ( tuning.host != getHostName( ) || tuning.hardwareThreads != getHardwareThreads( ) )
+  {
+    return false;
+  }
+
+  pSettings->numThreads = tuning.numThreads;
+  pSettings->tileSize   = tuning.tileSize;
+
+  if ( isSimdIsaSupported( tuning.simdIsa ) )
+  {
+    preferSimdIsa( tuning.simdIsa );
+  }
+
+  return true;
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief writeHostTuning
+///////////////////////////////////////////////////////////////
+void
+writeHostTuning(
+                const std::string &filename,
+                const HostTuning  &tuning
+                )
+{
+
+  std::ofstream file( filename );
+
+  if ( !file.is_open( ) )
+  {
+
+    throw std::runtime_error( "Could not open file for writeHostTuning: " + filename );
+
+  }
+
+  file << "host "             << tuning.host             << "\n"
+       << "hardwareThreads "  << tuning.hardwareThreads  << "\n"
+       << "numThreads "       << tuning.numThreads       << "\n"
+       << "tileSize "         << tuning.tileSize         << "\n"
+       << "simdIsa "          << toString( tuning.simdIsa ) << "\n"
+       << "samplesPerSecond " << tuning.samplesPerSecond << "\n";
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief readHostTuning
+///////////////////////////////////////////////////////////////
+bool
+readHostTuning(
+               const std::string &filename,
+               HostTuning        *pTuning
+               )
+{
+
+  std::ifstream file( filename );
+
+  if ( !file.is_open( ) )
+  {
+    return false;
+  }
+
+  HostTuning  tuning;
+  std::string line;
+  std::string isa = toString( tuning.simdIsa );
+
+  while ( std::getline( file, line ) )
+  {
+
+    std::istringstream fields( line );
+    std::string        key;
+
+    if ( !( fields >> key ) )
+    {
+      continue;
+    }
+
+    bool parsed = false;
+
+    if      ( key == "host" )             { parsed = static_cast< bool >( fields >> tuning.host ); }
+    else if ( key == "hardwareThreads" )  { parsed = static_cast< bool >( fields >> tuning.hardwareThreads ); }
+    else if ( key == "numThreads" )       { parsed = static_cast< bool >( fields >> tuning.numThreads ); }
+    else if ( key == "tileSize" )         { parsed = static_cast< bool >( fields >> tuning.tileSize ); }
+    else if ( key == "simdIsa" )          { parsed = static_cast< bool >( fields >> isa ); }
+    else if ( key == "samplesPerSecond" ) { parsed = static_cast< bool >( fields >> tuning.samplesPerSecond ); }
+
+    if ( !parsed )
+    {
+
+      throw std::runtime_error( "Bad line in host tuning " + filename + ": " + line );
+
+    }
+
+  }
+
+  if ( tuning.numThreads == 0 || tuning.tileSize == 0 )
+  {
+
+    throw std::runtime_error( "Incomplete host tuning: " + filename );
+
+  }
+
+  tuning.simdIsa = parseSimdIsa( isa );
+
+  *pTuning = tuning;
+
+  return true;
+
+} // readHostTuning
+
+
+
+} // namespace light
@@ -0,0 +1,140 @@
+#ifndef HostTuning_hpp
+#define HostTuning_hpp
+
+
+#include <string>
+#include <vector>
+#include "HostRenderer.hpp"
+#include "SimdIsa.hpp"
+
+
+namespace light
+{
+
+
+/////////////////////////////////////////////
+/// \brief The ScalingResult struct
+///
+///        Fastest of several frames at one thread count
+/////////////////////////////////////////////
+struct ScalingResult
+{
+  unsigned numThreads       = 0;
+  double   seconds          = 0.0;
+  double   samplesPerSecond = 0.0;
+  double   speedup          = 0.0; // over the first (single thread) result
+  double   efficiency       = 0.0; // speedup per thread
+};
+
+
+///////////////////////////////////////////////////////////////
+/// \brief getScalingThreadCounts
+/// \return 1, 2, 4, ... up to and always including maxThreads
+///////////////////////////////////////////////////////////////
+std::vector< unsigned > getScalingThreadCounts ( unsigned maxThreads );
+
+
+///////////////////////////////////////////////////////////////
+/// \brief measureScaling
+///
+///        Renders 'repeats' frames at each thread count and
+///        keeps the fastest, which is the least disturbed by
+///        other processes
+///////////////////////////////////////////////////////////////
+std::vector< ScalingResult > measureScaling (
+                                             HostRenderer                  *pRenderer,
+                                             const HostRenderSettings      &settings,
+                                             const std::vector< unsigned > &threadCounts,
+                                             unsigned                       repeats
+                                             );
+
+
+/////////////////////////////////////////////
+/// \brief The HostTuning struct
+///
+///        Settings measured fastest on one machine. The host
+///        name and hardware thread count identify the machine
+///        a saved tuning belongs to.
+/////////////////////////////////////////////
+struct HostTuning
+{
+  std::string host;
+  unsigned    hardwareThreads  = 0;
+  unsigned    numThreads       = 0;
+  unsigned    tileSize         = 0;
+  SimdIsa     simdIsa          = detectSimdIsa( ); // for the host SIMD kernels
+  double      samplesPerSecond = 0.0;
+};
+
+
+///////////////////////////////////////////////////////////////
+/// \brief tuneHostRendering
+///
+///        Picks the thread count with the best throughput
+///        (fewer threads when within 3 %, they leave cores to
+///        the rest of the machine), then the power of two tile
+///        size from 8 to 128 that is fastest at that count, and
+///        the SIMD instruction set with tuneSimdIsa
+///////////////////////////////////////////////////////////////
+HostTuning tuneHostRendering (
+                              HostRenderer             *pRenderer,
+                              const HostRenderSettings &settings,
+                              unsigned                  maxThreads,
+                              unsigned                  repeats
+                              );
+
+
+///////////////////////////////////////////////////////////////
+/// \brief tuneSimdIsa
+///
+///        Times every getSimdKernels kernel for each instruction
+///        set this CPU supports and picks the fastest, or the
+///        narrowest within 3 % of it (wide vectors can lower the
+///        clock for the rest of the program)
+///////////////////////////////////////////////////////////////
+SimdIsa tuneSimdIsa ( unsigned repeats );
+
+
+///////////////////////////////////////////////////////////////
+/// \brief getHostName
+/// \return this machine's name, "unknown" if it can't be read
+///////////////////////////////////////////////////////////////
+std::string getHostName ( );
+
+
+///////////////////////////////////////////////////////////////
+/// \brief applyHostTuning
+///
+///        Copies the tuned thread count and tile size into
+///        'pSettings' and prefers the tuned SIMD instruction set
+///        (preferSimdIsa, so forceSimdIsa and LIGHT_SIMD still
+///        win) if the tuning was made on this machine
+/// \return false if it belongs to another machine
+///////////////////////////////////////////////////////////////
+bool applyHostTuning (
+                      const HostTuning   &tuning,
+                      HostRenderSettings *pSettings
+                      );
+
+
+void writeHostTuning (
+                      const std::string &filename,
+                      const HostTuning  &tuning
+                      );
+
+
+///////////////////////////////////////////////////////////////
+/// \brief readHostTuning
+/// \return false if the file doesn't exist; throws if it exists
+///         but can't be parsed
+///////////////////////////////////////////////////////////////
+bool readHostTuning (
+                     const std::string &filename,
+                     HostTuning        *pTuning
+                     );
+
+
+} // namespace light
+
+
+#endif // HostTuning_hpp
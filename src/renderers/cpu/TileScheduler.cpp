@@ -0,0 +1,507 @@
+#include "TileScheduler.hpp"
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include "Trace.hpp"
+
+#if defined( __unix__ ) || defined( __APPLE__ )
+#include <unistd.h>
+#endif
+
+
+namespace light
+{
+
+
+namespace
+{
+
+constexpr unsigned minTileSize    = 8;
+constexpr unsigned maxTileSize    = 256;
+constexpr unsigned tilesPerThread = 4;
+
+// below this a tile is dominated by scheduling and cache warm up
+constexpr double minTileSeconds = 1.0e-4;
+
+// above this the last tiles of a frame leave threads idle
+constexpr double maxTileSeconds = 1.0e-2;
+
+constexpr std::size_t defaultCacheBytes = 256 * 1024;
+
+
+///
+/// \brief nextPowerOfTwo
+///
+unsigned
+nextPowerOfTwo( unsigned value )
+{
+
+  unsigned result = 1;
+
+  while ( result < value )
+  {
+    result <<= 1;
+  }
+
+  return result;
+
+}
+
+
+///
+/// \brief spreadBits
+///
+///        Inserts a zero between each of the lower 16 bits
+///
+unsigned
+spreadBits( unsigned v )
+{
+
+  v &= 0x0000ffff;
+  v  = ( v | ( v << 8 ) ) & 0x00ff00ff;
+  v  = ( v | ( v << 4 ) ) & 0x0f0f0f0f;
+  v  = ( v | ( v << 2 ) ) & 0x33333333;
+  v  = ( v | ( v << 1 ) ) & 0x55555555;
+
+  return v;
+
+}
+
+
+} // namespace
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief TileScheduler::TileScheduler
+///////////////////////////////////////////////////////////////
+TileScheduler::TileScheduler(
+                             unsigned  width,
+                             unsigned  height,
+                             unsigned  tileSize,
+                             TileOrder order,
+                             unsigned  seed
+                             )
+  : width_          ( width )
+  , height_         ( height )
+  , tileSize_       ( tileSize )
+  , tilesX_         ( 0 )
+  , tilesY_         ( 0 )
+  , order_          ( order )
+  , nextTile_       ( 0 )
+  , secondsPerPixel_( 0.0 )
+{
+
+  if ( width_ == 0 || height_ == 0 || tileSize_ == 0 )
+  {
+
+    throw std::runtime_error( "TileScheduler requires a non-empty image and tile size" );
+
+  }
+
+  tilesX_ = ( width_  + tileSize_ - 1 ) / tileSize_;
+  tilesY_ = ( height_ + tileSize_ - 1 ) / tileSize_;
+
+  _buildTiles( seed );
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief TileScheduler::reset
+///////////////////////////////////////////////////////////////
+void
+TileScheduler::reset( )
+{
+
+  nextTile_ = 0;
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief TileScheduler::nextTile
+/// \param pTile
+/// \return
+///////////////////////////////////////////////////////////////
+bool
+TileScheduler::nextTile( Tile *pTile )
+{
+
+  unsigned index = nextTile_.fetch_add( 1, std::memory_order_relaxed );
+
+  if ( index >= tiles_.size( ) )
+  {
+
+    return false;
+
+  }
+
+  *pTile = tiles_[ index ];
+
+  return true;
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief TileScheduler::run
+/// \param numThreads
+/// \param renderTile
+///////////////////////////////////////////////////////////////
+void
+TileScheduler::run(
+                   unsigned                                   numThreads,
+                   const std::function< void( const Tile& ) > &renderTile
+                   )
+{
+
+  numThreads = std::max( 1u, numThreads );
+
+  reset( );
+
+  auto worker = [ this, &renderTile ]( )
+                {
+
+                  Tile tile;
+
+                  while ( nextTile( &tile ) )
+                  {
+
+                    LIGHT_TRACE_SCOPE( "tile", "render" );
+
+                    renderTile( tile );
+
+                  }
+
+                };
+
+  auto start = std::chrono::steady_clock::now( );
+
+  std::vector< std::thread > threads;
+  threads.reserve( numThreads - 1 );
+
+  for ( unsigned i = 1; i < numThreads; ++i )
+  {
+
+    threads.emplace_back( worker );
+
+  }
+
+  worker( );
+
+  for ( std::thread &thread : threads )
+  {
+
+    thread.join( );
+
+  }
+
+  std::chrono::duration< double > elapsed = std::chrono::steady_clock::now( ) - start;
+
+  // thread-seconds per pixel so the value doesn't depend on the thread count
+  secondsPerPixel_ = elapsed.count( ) * numThreads
+                     / ( static_cast< double >( width_ ) * height_ );
+
+} // TileScheduler::run
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief TileScheduler::suggestTileSize
+/// \param numThreads
+/// \param bytesPerPixel
+/// \return
+///////////////////////////////////////////////////////////////
+unsigned
+TileScheduler::suggestTileSize(
+                               unsigned    numThreads,
+                               std::size_t bytesPerPixel
+                               ) const
+{
+
+  return chooseTileSize(
+                        width_,
+                        height_,
+                        numThreads,
+                        bytesPerPixel,
+                        detectCacheSize( ),
+                        secondsPerPixel_
+                        );
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief TileScheduler::chooseTileSize
+/// \return
+///////////////////////////////////////////////////////////////
+unsigned
+TileScheduler::chooseTileSize(
+                              unsigned    width,
+                              unsigned    height,
+                              unsigned    numThreads,
+                              std::size_t bytesPerPixel,
+                              std::size_t cacheBytes,
+                              double      secondsPerPixel
+                              )
+{
+
+  numThreads    = std::max( 1u, numThreads );
+  bytesPerPixel = std::max< std::size_t >( 1, bytesPerPixel );
+
+  //
+  // largest tile whose framebuffer footprint fits in half the cache
+  //
+  unsigned cacheLimit = minTileSize;
+
+  while ( cacheLimit < maxTileSize
+         && ( 2ull * cacheLimit ) * ( 2ull * cacheLimit ) * bytesPerPixel <= cacheBytes / 2 )
+  {
+
+    cacheLimit *= 2;
+
+  }
+
+  //
+  // enough tiles for every thread to grab several
+  //
+  auto tileCount = [ width, height ]( unsigned size )
+                   {
+                     return ( ( width  + size - 1 ) / size ) * ( ( height + size - 1 ) / size );
+                   };
+
+  unsigned balanceLimit = cacheLimit;
+
+  while ( balanceLimit > minTileSize && tileCount( balanceLimit ) < tilesPerThread * numThreads )
+  {
+
+    balanceLimit /= 2;
+
+  }
+
+  unsigned tileSize = balanceLimit;
+
+  //
+  // measured cost per tile
+  //
+  if ( secondsPerPixel > 0.0 )
+  {
+
+    auto tileSeconds = [ secondsPerPixel ]( unsigned size )
+                       {
+                         return secondsPerPixel * size * size;
+                       };
+
+    while ( tileSize > minTileSize && tileSeconds( tileSize ) > maxTileSeconds )
+    {
+
+      tileSize /= 2;
+
+    }
+
+    while ( tileSize < balanceLimit && tileSeconds( tileSize ) < minTileSeconds )
+    {
+
+      tileSize *= 2;
+
+    }
+
+  }
+
+  return tileSize;
+
+} // TileScheduler::chooseTileSize
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief TileScheduler::detectCacheSize
+/// \return
+///////////////////////////////////////////////////////////////
+std::size_t
+TileScheduler::detectCacheSize( )
+{
+
+#if defined( _SC_LEVEL2_CACHE_SIZE )
+
+  long bytes = sysconf( _SC_LEVEL2_CACHE_SIZE );
+
+  if ( bytes > 0 )
+  {
+
+    return static_cast< std::size_t >( bytes );
+
+  }
+
+#endif
+
+  return defaultCacheBytes;
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief TileScheduler::hilbertIndex
+///
+///        Standard rotate-and-accumulate conversion from grid
+///        coordinates to distance along the curve
+///////////////////////////////////////////////////////////////
+unsigned
+TileScheduler::hilbertIndex(
+                            unsigned gridSize,
+                            unsigned x,
+                            unsigned y
+                            )
+{
+
+  unsigned d = 0;
+
+  for ( unsigned s = gridSize / 2; s > 0; s /= 2 )
+  {
+
+    unsigned rx = ( x & s ) > 0 ? 1 : 0;
+    unsigned ry = ( y & s ) > 0 ? 1 : 0;
+
+    d += s * s * ( ( 3 * rx ) ^ ry );
+
+    // rotate the quadrant so the sub-curve has the right orientation
+    if ( ry == 0 )
+    {
+
+      if ( rx == 1 )
+      {
+
+        x = gridSize - 1 - x;
+        y = gridSize - 1 - y;
+
+      }
+
+      std::swap( x, y );
+
+    }
+
+  }
+
+  return d;
+
+} // TileScheduler::hilbertIndex
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief TileScheduler::mortonIndex
+///////////////////////////////////////////////////////////////
+unsigned
+TileScheduler::mortonIndex(
+                           unsigned x,
+                           unsigned y
+                           )
+{
+
+  return spreadBits( x ) | ( spreadBits( y ) << 1 );
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief TileScheduler::_buildTiles
+/// \param seed
+///////////////////////////////////////////////////////////////
+void
+TileScheduler::_buildTiles( unsigned seed )
+{
+
+  tiles_.clear( );
+  tiles_.reserve( tilesX_ * tilesY_ );
+
+  for ( unsigned ty = 0; ty < tilesY_; ++ty )
+  {
+
+    for ( unsigned tx = 0; tx < tilesX_; ++tx )
+    {
+
+      Tile tile;
+      tile.x      = tx * tileSize_;
+      tile.y      = ty * tileSize_;
+      tile.width  = std::min( tileSize_, width_  - tile.x );
+      tile.height = std::min( tileSize_, height_ - tile.y );
+      tile.index  = ty * tilesX_ + tx;
+
+      tiles_.push_back( tile );
+
+    }
+
+  }
+
+  switch ( order_ )
+  {
+
+  case TileOrder::SCANLINE:
+
+    break;
+
+
+  case TileOrder::RANDOM:
+
+    std::shuffle( tiles_.begin( ), tiles_.end( ), std::mt19937( seed ) );
+    break;
+
+
+  case TileOrder::MORTON:
+  case TileOrder::HILBERT:
+  {
+
+    unsigned gridSize = nextPowerOfTwo( std::max( tilesX_, tilesY_ ) );
+    bool     hilbert  = ( order_ == TileOrder::HILBERT );
+
+    std::vector< std::pair< unsigned, Tile > > keyed;
+    keyed.reserve( tiles_.size( ) );
+
+    for ( const Tile &tile : tiles_ )
+    {
+
+      unsigned tx = tile.x / tileSize_;
+      unsigned ty = tile.y / tileSize_;
+
+      unsigned key = hilbert ? hilbertIndex( gridSize, tx, ty ) : mortonIndex( tx, ty );
+
+      keyed.emplace_back( key, tile );
+
+    }
+
+    std::sort(
+              keyed.begin( ),
+              keyed.end( ),
+              [ ]( const std::pair< unsigned, Tile > &a, const std::pair< unsigned, Tile > &b )
+              {
+                return a.first < b.first;
+              }
+              );
+
+    for ( std::size_t i = 0; i < keyed.size( ); ++i )
+    {
+
+      tiles_[ i ] = keyed[ i ].second;
+
+    }
+
+    break;
+
+  }
+
+  } // switch
+
+} // TileScheduler::_buildTiles
+
+
+
+} // namespace light
@@ -0,0 +1,228 @@
+#ifndef TileScheduler_hpp
+#define TileScheduler_hpp
+
+
+#include <vector>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+
+
+namespace light
+{
+
+
+/////////////////////////////////////////////
+/// \brief The Tile struct
+///
+///        Rectangular block of pixels. Tiles on the
+///        right and top edges of the image may be
+///        smaller than the scheduler's tile size.
+/////////////////////////////////////////////
+struct Tile
+{
+
+  unsigned x;      ///< pixel column of the lower left corner
+  unsigned y;      ///< pixel row of the lower left corner
+  unsigned width;  ///< pixel width (clipped to the image)
+  unsigned height; ///< pixel height (clipped to the image)
+  unsigned index;  ///< row-major tile index (storage slot in a TiledFramebuffer)
+
+};
+
+
+/////////////////////////////////////////////
+/// \brief The TileOrder enum
+///
+///        Order in which tiles are handed to threads
+/////////////////////////////////////////////
+enum class TileOrder
+{
+
+  SCANLINE, ///< row by row
+  RANDOM,   ///< seeded shuffle (worst case coherence)
+  MORTON,   ///< Z-order curve
+  HILBERT   ///< Hilbert curve (consecutive tiles always share an edge)
+
+};
+
+
+/////////////////////////////////////////////
+/// \brief The TileScheduler class
+///
+///        Splits an image into square tiles and hands them
+///        out to worker threads along a space filling curve
+///        so threads working at the same time touch nearby
+///        parts of the scene.
+/////////////////////////////////////////////
+class TileScheduler
+{
+
+public:
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief TileScheduler
+  /// \param width     image width in pixels
+  /// \param height    image height in pixels
+  /// \param tileSize  edge length of a tile in pixels
+  /// \param order     traversal order of the tiles
+  /// \param seed      shuffle seed used by TileOrder::RANDOM
+  ///////////////////////////////////////////////////////////////
+  TileScheduler(
+                unsigned  width,
+                unsigned  height,
+                unsigned  tileSize,
+                TileOrder order = TileOrder::HILBERT,
+                unsigned  seed  = 0
+                );
+
+
+  unsigned  getWidth      ( ) const { return width_; }
+  unsigned  getHeight     ( ) const { return height_; }
+  unsigned  getTileSize   ( ) const { return tileSize_; }
+  unsigned  getTilesX     ( ) const { return tilesX_; }
+  unsigned  getTilesY     ( ) const { return tilesY_; }
+  TileOrder getOrder      ( ) const { return order_; }
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief getTiles
+  /// \return all tiles in traversal order
+  ///////////////////////////////////////////////////////////////
+  const std::vector< Tile > &getTiles ( ) const { return tiles_; }
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief reset
+  ///
+  ///        Starts handing out tiles from the beginning of the
+  ///        curve again. Not safe while threads call nextTile.
+  ///////////////////////////////////////////////////////////////
+  void reset ( );
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief nextTile
+  ///
+  ///        Thread safe. Fetches the next unclaimed tile.
+  ///
+  /// \return false once every tile has been handed out
+  ///////////////////////////////////////////////////////////////
+  bool nextTile ( Tile *pTile );
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief run
+  ///
+  ///        Renders every tile once using 'numThreads' threads
+  ///        (the calling thread included) and records the
+  ///        average cost per pixel for later tile size choices.
+  ///////////////////////////////////////////////////////////////
+  void run (
+            unsigned                                  numThreads,
+            const std::function< void( const Tile& ) > &renderTile
+            );
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief getSecondsPerPixel
+  /// \return average measured cost of a pixel over the last run
+  ///////////////////////////////////////////////////////////////
+  double getSecondsPerPixel ( ) const { return secondsPerPixel_; }
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief suggestTileSize
+  ///
+  ///        Tile size to use on the next frame given the cost
+  ///        measured by run( )
+  ///////////////////////////////////////////////////////////////
+  unsigned suggestTileSize (
+                            unsigned    numThreads,
+                            std::size_t bytesPerPixel
+                            ) const;
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief chooseTileSize
+  ///
+  ///        Picks a power of two tile size that
+  ///          - keeps the tile's framebuffer footprint within
+  ///            half of the per-core cache (the other half is
+  ///            left for acceleration structure and texture data)
+  ///          - leaves at least a few tiles per thread for load
+  ///            balancing
+  ///          - keeps the measured time per tile (if known) large
+  ///            enough to hide scheduling overhead and small
+  ///            enough to avoid a long tail at the end of a frame
+  ///
+  /// \param secondsPerPixel measured cost, 0 if unknown
+  ///////////////////////////////////////////////////////////////
+  static
+  unsigned chooseTileSize (
+                           unsigned    width,
+                           unsigned    height,
+                           unsigned    numThreads,
+                           std::size_t bytesPerPixel,
+                           std::size_t cacheBytes      = detectCacheSize( ),
+                           double      secondsPerPixel = 0.0
+                           );
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief detectCacheSize
+  /// \return per-core (L2) cache size in bytes, or a
+  ///         conservative default if it can't be queried
+  ///////////////////////////////////////////////////////////////
+  static
+  std::size_t detectCacheSize ( );
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief hilbertIndex
+  /// \param gridSize power of two edge length of the curve's grid
+  /// \return distance of (x, y) along the Hilbert curve
+  ///////////////////////////////////////////////////////////////
+  static
+  unsigned hilbertIndex (
+                         unsigned gridSize,
+                         unsigned x,
+                         unsigned y
+                         );
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief mortonIndex
+  /// \return interleaved bits of x and y (16 bits each)
+  ///////////////////////////////////////////////////////////////
+  static
+  unsigned mortonIndex (
+                        unsigned x,
+                        unsigned y
+                        );
+
+
+private:
+
+  void _buildTiles ( unsigned seed );
+
+  unsigned  width_;
+  unsigned  height_;
+  unsigned  tileSize_;
+  unsigned  tilesX_;
+  unsigned  tilesY_;
+  TileOrder order_;
+
+  std::vector< Tile > tiles_;
+
+  std::atomic< unsigned > nextTile_;
+
+  double secondsPerPixel_;
+
+};
+
+
+} // namespace light
+
+
+#endif // TileScheduler_hpp
@@ -0,0 +1,151 @@
+#include "TiledFramebuffer.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+
+namespace light
+{
+
+
+///////////////////////////////////////////////////////////////
+/// \brief TiledFramebuffer::TiledFramebuffer
+///////////////////////////////////////////////////////////////
+TiledFramebuffer::TiledFramebuffer(
+                                   unsigned width,
+                                   unsigned height,
+                                   unsigned tileSize,
+                                   unsigned channels
+                                   )
+  : width_   ( width )
+  , height_  ( height )
+  , tileSize_( tileSize )
+  , channels_( channels )
+  , tilesX_  ( 0 )
+  , memory_  ( MemoryCategory::FRAMEBUFFERS )
+{
+
+  if ( width_ == 0 || height_ == 0 || tileSize_ == 0 || channels_ == 0 )
+  {
+
+    throw std::runtime_error( "TiledFramebuffer requires non-zero dimensions" );
+
+  }
+
+  tilesX_ = ( width_ + tileSize_ - 1 ) / tileSize_;
+
+  unsigned tilesY = ( height_ + tileSize_ - 1 ) / tileSize_;
+
+  data_.resize( _tileOffset( tilesX_ * tilesY ), 0.0f );
+  memory_.set( data_.size( ) * sizeof( float ) );
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief TiledFramebuffer::getPixelOffset
+/// \param x
+/// \param y
+/// \return
+///////////////////////////////////////////////////////////////
+std::size_t
+TiledFramebuffer::getPixelOffset(
+                                 unsigned x,
+                                 unsigned y
+                                 ) const
+{
+
+  unsigned tileIndex = ( y / tileSize_ ) * tilesX_ + ( x / tileSize_ );
+  unsigned localX    = x % tileSize_;
+  unsigned localY    = y % tileSize_;
+
+  return _tileOffset( tileIndex )
+         + ( static_cast< std::size_t >( localY ) * tileSize_ + localX ) * channels_;
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief TiledFramebuffer::clear
+/// \param value
+///////////////////////////////////////////////////////////////
+void
+TiledFramebuffer::clear( float value )
+{
+
+  std::fill( data_.begin( ), data_.end( ), value );
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief TiledFramebuffer::toScanline
+/// \param pPixels
+///////////////////////////////////////////////////////////////
+void
+TiledFramebuffer::toScanline( std::vector< float > *pPixels ) const
+{
+
+  pPixels->resize( static_cast< std::size_t >( width_ ) * height_ * channels_ );
+
+  for ( unsigned y = 0; y < height_; ++y )
+  {
+
+    float *pDst = pPixels->data( ) + static_cast< std::size_t >( y ) * width_ * channels_;
+
+    // copy one tile-row span at a time
+    for ( unsigned x = 0; x < width_; x += tileSize_ )
+    {
+
+      unsigned span = std::min( tileSize_, width_ - x );
+      const float *pSrc = getPixel( x, y );
+
+      std::copy( pSrc, pSrc + span * channels_, pDst + static_cast< std::size_t >( x ) * channels_ );
+
+    }
+
+  }
+
+} // TiledFramebuffer::toScanline
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief TiledFramebuffer::fromScanline
+/// \param pixels
+///////////////////////////////////////////////////////////////
+void
+TiledFramebuffer::fromScanline( const std::vector< float > &pixels )
+{
+
+  if ( pixels.size( ) != static_cast< std::size_t >( width_ ) * height_ * channels_ )
+  {
+
+    throw std::runtime_error( "Scanline image size does not match the tiled framebuffer" );
+
+  }
+
+  for ( unsigned y = 0; y < height_; ++y )
+  {
+
+    const float *pSrc = pixels.data( ) + static_cast< std::size_t >( y ) * width_ * channels_;
+
+    for ( unsigned x = 0; x < width_; x += tileSize_ )
+    {
+
+      unsigned span = std::min( tileSize_, width_ - x );
+      const float *pSpan = pSrc + static_cast< std::size_t >( x ) * channels_;
+
+      std::copy( pSpan, pSpan + span * channels_, getPixel( x, y ) );
+
+    }
+
+  }
+
+} // TiledFramebuffer::fromScanline
+
+
+
+} // namespace light
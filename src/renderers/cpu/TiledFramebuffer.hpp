@@ -0,0 +1,121 @@
+#ifndef TiledFramebuffer_hpp
+#define TiledFramebuffer_hpp
+
+
+#include <vector>
+#include <cstddef>
+#include "TileScheduler.hpp"
+#include "MemoryAccounting.hpp"
+
+
+namespace light
+{
+
+
+/////////////////////////////////////////////
+/// \brief The TiledFramebuffer class
+///
+///        Float framebuffer stored tile by tile instead of
+///        scanline by scanline. Each tile occupies one
+///        contiguous tileSize x tileSize block (edge tiles
+///        are padded) so a thread rendering a tile never
+///        shares cache lines with its neighbours.
+/////////////////////////////////////////////
+class TiledFramebuffer
+{
+
+public:
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief TiledFramebuffer
+  /// \param width    image width in pixels
+  /// \param height   image height in pixels
+  /// \param tileSize must match the TileScheduler used to render
+  /// \param channels floats per pixel
+  ///////////////////////////////////////////////////////////////
+  TiledFramebuffer(
+                   unsigned width,
+                   unsigned height,
+                   unsigned tileSize,
+                   unsigned channels = 4
+                   );
+
+
+  unsigned getWidth    ( ) const { return width_; }
+  unsigned getHeight   ( ) const { return height_; }
+  unsigned getTileSize ( ) const { return tileSize_; }
+  unsigned getChannels ( ) const { return channels_; }
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief getTileData
+  /// \return first float of the tile's block, rows are
+  ///         tileSize pixels apart
+  ///////////////////////////////////////////////////////////////
+  float       *getTileData ( const Tile &tile )       { return &data_[ _tileOffset( tile.index ) ]; }
+  const float *getTileData ( const Tile &tile ) const { return &data_[ _tileOffset( tile.index ) ]; }
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief getPixel
+  /// \return first channel of the pixel at image coords (x, y)
+  ///////////////////////////////////////////////////////////////
+  float       *getPixel ( unsigned x, unsigned y )       { return &data_[ getPixelOffset( x, y ) ]; }
+  const float *getPixel ( unsigned x, unsigned y ) const { return &data_[ getPixelOffset( x, y ) ]; }
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief getPixelOffset
+  /// \return index of the pixel's first channel in the tiled storage
+  ///////////////////////////////////////////////////////////////
+  std::size_t getPixelOffset (
+                              unsigned x,
+                              unsigned y
+                              ) const;
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief clear
+  ///////////////////////////////////////////////////////////////
+  void clear ( float value = 0.0f );
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief toScanline
+  ///
+  ///        Copies the image into row-major order, bottom row
+  ///        first (the same layout as the OptiX output buffer)
+  ///////////////////////////////////////////////////////////////
+  void toScanline ( std::vector< float > *pPixels ) const;
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief fromScanline
+  ///////////////////////////////////////////////////////////////
+  void fromScanline ( const std::vector< float > &pixels );
+
+
+private:
+
+  std::size_t _tileOffset ( unsigned tileIndex ) const
+  {
+    return static_cast< std::size_t >( tileIndex ) * tileSize_ * tileSize_ * channels_;
+  }
+
+  unsigned width_;
+  unsigned height_;
+  unsigned tileSize_;
+  unsigned channels_;
+  unsigned tilesX_;
+
+  std::vector< float > data_;
+
+  TrackedMemory memory_;
+
+};
+
+
+} // namespace light
+
+
+#endif // TiledFramebuffer_hpp
@@ -16,13 +16,14 @@ OptixFileScene::OptixFileScene(
                                int                width,
                                int                height,
                                unsigned           vbo,
-                               const std::string &
+                               const std::string &filename
                                )
   : OptixScene( width, height, vbo )
 {
 
-  context_->validate( );
-  context_->compile( );
+  compileScene( SceneDescription::read( filename ) );
+
+  compileContext( );
 
 }
 
@@ -12,6 +12,9 @@ namespace light
 /////////////////////////////////////////////
 /// \brief The OptixFileScene class
 ///
+///        Scene compiled from a SceneDescription
+///        written to disk with SceneDescription::write
+///
 /// \author Logan Barnes
 /////////////////////////////////////////////
 class OptixFileScene : public OptixScene
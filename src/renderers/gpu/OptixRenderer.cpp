@@ -5,8 +5,14 @@
 #include <cstring>
 #include <random>
 #include <limits>
+#include <algorithm>
 #include "glad/glad.h"
 #include "LightBenderConfig.hpp"
+#include "RenderCheckpoint.hpp"
+#include "Hash.hpp"
+#include "Instrumentation.hpp"
+#include "Trace.hpp"
+#include "PathStatistics.hpp"
 #include "graphics/Camera.hpp"
 #include "optixMod/optix_math_stream_namespace_mod.h"
 
@@ -181,6 +187,28 @@ void displayBufferPPM( const std::string &filename, optix::Buffer buffer)
 
 }
 
+
+///
+/// \brief layerFilename
+///
+///        Inserts a suffix before the file extension
+///        ( "frame.ppm" -> "frame_direct.ppm" )
+///
+std::string layerFilename( const std::string &filename, const std::string &suffix )
+{
+
+    std::string::size_type dot   = filename.find_last_of( '.' );
+    std::string::size_type slash = filename.find_last_of( "/\\" );
+
+    if ( dot == std::string::npos || ( slash != std::string::npos && dot < slash ) )
+    {
+        return filename + suffix;
+    }
+
+    return filename.substr( 0, dot ) + suffix + filename.substr( dot );
+
+}
+
 #ifdef __GNUC__
 #pragma GCC diagnostic pop
 #endif
@@ -202,9 +230,19 @@ OptixRenderer::OptixRenderer(
   , error_color      ( 1.0f, 0.0f, 0.0f )
   , context_         ( optix::Context::create( ) )
   , pathTracing_     ( false )
+  , bounceLayers_    ( false )
+  , pathStatistics_  ( false )
   , frame_           ( 1u )
+  , sqrtSamples_     ( 1u )
+  , globalSeed_      ( 0u )
+  , frameOffset_     ( 0u )
+  , framebufferMemory_( MemoryCategory::FRAMEBUFFERS )
 {
 
+  LIGHT_TRACE_SCOPE( "createContext", "scene" );
+
+  std::fill( camera_, camera_ + 4, glm::vec3( 0.0f ) );
+
   // context
   context_->setRayTypeCount   ( 2 );
   context_->setEntryPointCount( 1 );
@@ -214,6 +252,8 @@ OptixRenderer::OptixRenderer(
   context_[ "shadow_ray_type"   ]->setUint ( 1 );
   context_[ "scene_epsilon"     ]->setFloat( 1.e-2f );
   context_[ "frame_number"      ]->setUint ( frame_ );
+  context_[ "frame_offset"      ]->setUint ( 0u );
+  context_[ "launch_offset"     ]->setUint ( 0u, 0u );
 
   context_[ "eye" ]->setFloat( 0.0f, 0.0f,  0.0f );
   context_[ "U"   ]->setFloat( 1.0f, 0.0f,  0.0f );
@@ -256,7 +296,20 @@ OptixRenderer::OptixRenderer(
                                                                   ) );
 
   optix::Buffer buffer;
-  buffer = context_->createBufferFromGLBO( RT_BUFFER_OUTPUT, vbo );
+
+  if ( vbo )
+  {
+
+    buffer = context_->createBufferFromGLBO( RT_BUFFER_OUTPUT, vbo );
+
+  }
+  else
+  {
+
+    buffer = context_->createBuffer( RT_BUFFER_OUTPUT );
+
+  }
+
   buffer->setFormat( RT_FORMAT_FLOAT4 );
   buffer->setSize(
                   static_cast< unsigned >( width ),
@@ -265,9 +318,42 @@ OptixRenderer::OptixRenderer(
 
   context_[ "output_buffer" ]->set( buffer );
 
+  //
+  // bounce layers stay 1x1 until they are requested
+  //
+  context_[ "bounce_layers"   ]->setUint( 0 );
+  context_[ "direct_buffer"   ]->set( context_->createBuffer( RT_BUFFER_INPUT_OUTPUT, RT_FORMAT_FLOAT4, 1, 1 ) );
+  context_[ "indirect_buffer" ]->set( context_->createBuffer( RT_BUFFER_INPUT_OUTPUT, RT_FORMAT_FLOAT4, 1, 1 ) );
+
+  //
+  // and the traversal cost counters
+  //
+  context_[ "traversal_cost"        ]->setUint ( 0 );
+  context_[ "cost_scale"            ]->setFloat( 64.0f );
+  context_[ "traversal_cost_buffer" ]->set( context_->createBuffer( RT_BUFFER_INPUT_OUTPUT, RT_FORMAT_UNSIGNED_INT2, 1, 1 ) );
+
+  //
+  // same for path statistics
+  //
+  optix::Buffer statsBuffer = context_->createBuffer( RT_BUFFER_INPUT_OUTPUT, RT_FORMAT_USER, 1 );
+  statsBuffer->setElementSize( sizeof( std::uint64_t ) );
+
+  context_[ "path_stats"        ]->setUint( 0 );
+  context_[ "path_stats_buffer" ]->set( statsBuffer );
+
+  //
+  // and the pixel moments of efficiency roulette
+  //
+  context_[ "roulette_buffer" ]->set( context_->createBuffer( RT_BUFFER_INPUT_OUTPUT, RT_FORMAT_FLOAT2, 1, 1 ) );
+
+  setRoulette         ( ROULETTE_EFFICIENCY, 2 );
+  setFirstBounceSplits( 1 );
+
   setSqrtSamples( 1 );
   setCameraType ( 0 );
 
+  _updateFramebufferMemory( );
+
 }
 
 
@@ -312,7 +398,7 @@ OptixRenderer::setCameraType( int type )
 
     camera = "pathtrace_" + camera;
 
-    context_[ "globalSeed" ]->setUint( dis( gen ) );
+    setGlobalSeed( dis( gen ) );
 
   }
 
@@ -331,12 +417,46 @@ void
 OptixRenderer::setSqrtSamples( unsigned sqrtSamples )
 {
 
+  sqrtSamples_ = sqrtSamples;
+
   context_[ "sqrt_num_samples" ]->setUint( sqrtSamples );
 
 }
 
 
 
+///
+/// \brief OptixRenderer::setGlobalSeed
+/// \param seed
+///
+void
+OptixRenderer::setGlobalSeed( unsigned seed )
+{
+
+  globalSeed_ = seed;
+
+  context_[ "globalSeed" ]->setUint( seed );
+
+}
+
+
+
+///
+/// \brief OptixRenderer::setFrameOffset
+/// \param offset
+///
+void
+OptixRenderer::setFrameOffset( unsigned offset )
+{
+
+  frameOffset_ = offset;
+
+  context_[ "frame_offset" ]->setUint( offset );
+
+}
+
+
+
 ///
 /// \brief OptixRenderer::setPathTracing
 /// \param pathTracing
@@ -351,6 +471,216 @@ OptixRenderer::setPathTracing( bool pathTracing )
 
 
 
+///
+/// \brief OptixRenderer::setBounceLayers
+/// \param bounceLayers
+///
+void
+OptixRenderer::setBounceLayers( bool bounceLayers )
+{
+
+  bounceLayers_ = bounceLayers;
+
+  RTsize width  = 1;
+  RTsize height = 1;
+
+  if ( bounceLayers_ )
+  {
+
+    getBuffer( )->getSize( width, height );
+
+  }
+
+  context_[ "direct_buffer"   ]->getBuffer( )->setSize( width, height );
+  context_[ "indirect_buffer" ]->getBuffer( )->setSize( width, height );
+  context_[ "bounce_layers"   ]->setUint( bounceLayers_ ? 1 : 0 );
+
+  _updateFramebufferMemory( );
+  resetFrameCount( );
+
+} // OptixRenderer::setBounceLayers
+
+
+
+///
+/// \brief OptixRenderer::setTraversalCost
+/// \param enabled
+/// \param scale
+///
+void
+OptixRenderer::setTraversalCost(
+                                bool  enabled,
+                                float scale
+                                )
+{
+
+  RTsize width  = 1;
+  RTsize height = 1;
+
+  if ( enabled )
+  {
+
+    getBuffer( )->getSize( width, height );
+
+  }
+
+  context_[ "traversal_cost_buffer" ]->getBuffer( )->setSize( width, height );
+  context_[ "traversal_cost"        ]->setUint ( enabled ? 1 : 0 );
+  context_[ "cost_scale"            ]->setFloat( std::max( scale, 1.0f ) );
+
+  _updateFramebufferMemory( );
+  resetFrameCount( );
+
+} // OptixRenderer::setTraversalCost
+
+
+
+///
+/// \brief OptixRenderer::setPathStatistics
+/// \param enabled
+///
+void
+OptixRenderer::setPathStatistics( bool enabled )
+{
+
+  pathStatistics_ = enabled;
+
+  context_[ "path_stats_buffer" ]->getBuffer( )->setSize( enabled ? PATH_STATS_SLOTS * PATH_STATS_FIELDS : 1 );
+  context_[ "path_stats"        ]->setUint( enabled ? 1 : 0 );
+
+  _updateFramebufferMemory( );
+  _clearPathStatistics( );
+
+}
+
+
+
+///
+/// \brief OptixRenderer::setRoulette
+/// \param policy
+/// \param minDepth
+///
+void
+OptixRenderer::setRoulette(
+                           RoulettePolicy policy,
+                           unsigned       minDepth
+                           )
+{
+
+  RTsize width  = 1;
+  RTsize height = 1;
+
+  if ( policy == ROULETTE_EFFICIENCY )
+  {
+
+    getBuffer( )->getSize( width, height );
+
+  }
+
+  context_[ "roulette_buffer"    ]->getBuffer( )->setSize( width, height );
+  context_[ "roulette_policy"    ]->setUint( static_cast< unsigned >( policy ) );
+  context_[ "roulette_min_depth" ]->setUint( minDepth );
+
+  _updateFramebufferMemory( );
+  resetFrameCount( );
+
+} // OptixRenderer::setRoulette
+
+
+
+///
+/// \brief OptixRenderer::setFirstBounceSplits
+/// \param splits
+///
+void
+OptixRenderer::setFirstBounceSplits( unsigned splits )
+{
+
+  context_[ "first_bounce_splits" ]->setUint( std::max( splits, 1u ) );
+
+  resetFrameCount( );
+
+}
+
+
+
+///
+/// \brief OptixRenderer::getPathStatistics
+///
+PathStatistics
+OptixRenderer::getPathStatistics( )
+{
+
+  PathStatistics statistics;
+
+  if ( pathStatistics_ )
+  {
+
+    LIGHT_PROFILE_SCOPE( READBACK );
+
+    optix::Buffer buffer = context_[ "path_stats_buffer" ]->getBuffer( );
+
+    statistics.addSlots( static_cast< const std::uint64_t* >( buffer->map( ) ) );
+    buffer->unmap( );
+
+  }
+
+  return statistics;
+
+}
+
+
+
+///
+/// \brief OptixRenderer::_clearPathStatistics
+///
+void
+OptixRenderer::_clearPathStatistics( )
+{
+
+  optix::Buffer buffer = context_[ "path_stats_buffer" ]->getBuffer( );
+
+  RTsize size;
+  buffer->getSize( size );
+
+  std::memset( buffer->map( ), 0, size * sizeof( std::uint64_t ) );
+  buffer->unmap( );
+
+}
+
+
+
+///
+/// \brief OptixRenderer::_updateFramebufferMemory
+///
+void
+OptixRenderer::_updateFramebufferMemory( )
+{
+
+  RTsize width, height;
+
+  getBuffer( )->getSize( width, height );
+  std::size_t bytes = width * height * sizeof( float ) * 4;
+
+  context_[ "direct_buffer" ]->getBuffer( )->getSize( width, height );
+  bytes += width * height * sizeof( float ) * 4 * 2; // direct and indirect
+
+  context_[ "traversal_cost_buffer" ]->getBuffer( )->getSize( width, height );
+  bytes += width * height * sizeof( unsigned ) * 2;
+
+  context_[ "roulette_buffer" ]->getBuffer( )->getSize( width, height );
+  bytes += width * height * sizeof( float ) * 2;
+
+  RTsize size;
+  context_[ "path_stats_buffer" ]->getBuffer( )->getSize( size );
+  bytes += size * sizeof( std::uint64_t );
+
+  framebufferMemory_.set( bytes );
+
+}
+
+
+
 ///
 /// \brief OptixRenderer::resize
 /// \param w
@@ -384,26 +714,97 @@ OptixRenderer::renderWorld( const graphics::Camera &camera )
 
   camera.buildRayBasisVectors( &U, &V, &W );
 
+  setCamera( eye, U, V, W );
+
+  RTsize buffer_width, buffer_height;
+  getBuffer( )->getSize( buffer_width, buffer_height );
+
+  renderRegion(
+               0,
+               0,
+               static_cast< unsigned >( buffer_width  ),
+               static_cast< unsigned >( buffer_height )
+               );
+
+} // OptixRenderer::RenderWorld
+
+
+
+///
+/// \brief OptixRenderer::setCamera
+///
+void
+OptixRenderer::setCamera(
+                         const glm::vec3 &eye,
+                         const glm::vec3 &U,
+                         const glm::vec3 &V,
+                         const glm::vec3 &W
+                         )
+{
+
+  camera_[ 0 ] = eye;
+  camera_[ 1 ] = U;
+  camera_[ 2 ] = V;
+  camera_[ 3 ] = W;
+
   context_[ "eye" ]->setFloat( eye.x, eye.y, eye.z );
   context_[ "U"   ]->setFloat(   U.x,   U.y,   U.z );
   context_[ "V"   ]->setFloat(   V.x,   V.y,   V.z );
   context_[ "W"   ]->setFloat(   W.x,   W.y,   W.z );
 
-  context_[ "frame_number" ]->setUint ( frame_ );
+}
+
 
-  optix::Buffer buffer = context_[ "output_buffer" ]->getBuffer( );
-  RTsize buffer_width, buffer_height;
-  buffer->getSize( buffer_width, buffer_height );
 
-  context_->launch(
-                   0,
-                   static_cast< unsigned >( buffer_width  ),
-                   static_cast< unsigned >( buffer_height )
-                   );
+///
+/// \brief OptixRenderer::renderRegion
+///
+void
+OptixRenderer::renderRegion(
+                            unsigned x,
+                            unsigned y,
+                            unsigned width,
+                            unsigned height
+                            )
+{
+
+  LIGHT_TRACE_SCOPE( "frame", "render" );
+  LIGHT_PROFILE_SCOPE( LAUNCH );
+  LIGHT_PROFILE_COUNT( FRAMES, 1 );
+  LIGHT_PROFILE_COUNT( SAMPLES, static_cast< std::uint64_t >( width ) * height * sqrtSamples_ * sqrtSamples_ );
+
+  context_[ "frame_number"  ]->setUint( frame_ );
+  context_[ "launch_offset" ]->setUint( x, y );
+
+  context_->launch( 0, width, height );
 
   ++frame_;
 
-} // OptixRenderer::RenderWorld
+} // OptixRenderer::renderRegion
+
+
+
+///
+/// \brief OptixRenderer::compileContext
+///
+void
+OptixRenderer::compileContext( )
+{
+
+  {
+
+    LIGHT_TRACE_SCOPE( "compile", "scene" );
+
+    context_->validate( );
+    context_->compile( );
+
+  }
+
+  LIGHT_TRACE_SCOPE( "accelerationBuild", "accel" );
+
+  context_->launch( 0, 0, 0 );
+
+} // OptixRenderer::compileContext
 
 
 //
@@ -422,15 +823,273 @@ void
 OptixRenderer::saveFrame( const std::string &filename )
 {
 
+  LIGHT_PROFILE_SCOPE( OUTPUT );
+
   displayBufferPPM( filename, getBuffer( ) );
 
 }
 
+
+
+///
+/// \brief OptixRenderer::saveBounceLayers
+/// \param filename
+///
+void
+OptixRenderer::saveBounceLayers( const std::string &filename )
+{
+
+  if ( !bounceLayers_ )
+  {
+
+    throw std::runtime_error( "Bounce layers are not enabled for this renderer" );
+
+  }
+
+  LIGHT_PROFILE_SCOPE( OUTPUT );
+
+  displayBufferPPM( layerFilename( filename, "_direct"   ), context_[ "direct_buffer"   ]->getBuffer( ) );
+  displayBufferPPM( layerFilename( filename, "_indirect" ), context_[ "indirect_buffer" ]->getBuffer( ) );
+  displayBufferPPM( layerFilename( filename, "_both"     ), getBuffer( ) );
+
+}
+
 #ifdef __GNUC__
 #pragma GCC diagnostic pop
 #endif
 
 
+///
+/// \brief OptixRenderer::captureCheckpoint
+/// \param pCheckpoint
+///
+void
+OptixRenderer::captureCheckpoint( RenderCheckpoint *pCheckpoint )
+{
+
+  RTsize width, height;
+  getBuffer( )->getSize( width, height );
+
+  std::vector< optix::Buffer > layers = { getBuffer( ) };
+
+  if ( bounceLayers_ )
+  {
+
+    layers.push_back( context_[ "direct_buffer"   ]->getBuffer( ) );
+    layers.push_back( context_[ "indirect_buffer" ]->getBuffer( ) );
+
+  }
+
+  // efficiency roulette reads the moments of earlier frames, so a
+  // resumed render needs them to stay bit identical
+  bool rouletteLayer = context_[ "roulette_policy" ]->getUint( ) == ROULETTE_EFFICIENCY;
+
+  pCheckpoint->resize(
+                      static_cast< unsigned >( width ),
+                      static_cast< unsigned >( height ),
+                      static_cast< unsigned >( layers.size( ) ) + ( rouletteLayer ? 1 : 0 )
+                      );
+
+  std::size_t layerBytes = width * height * 4 * sizeof( float );
+
+  LIGHT_PROFILE_SCOPE( READBACK );
+
+  for ( unsigned i = 0; i < layers.size( ); ++i )
+  {
+
+    std::memcpy( pCheckpoint->getLayer( i ), layers[ i ]->map( ), layerBytes );
+    layers[ i ]->unmap( );
+
+  }
+
+  if ( rouletteLayer )
+  {
+
+    optix::Buffer moments = context_[ "roulette_buffer" ]->getBuffer( );
+
+    const float *pMoments = static_cast< const float* >( moments->map( ) );
+    float       *pLayer   = pCheckpoint->getLayer( static_cast< unsigned >( layers.size( ) ) );
+
+    // float2 moments go into a float4 layer
+    for ( std::size_t i = 0; i < width * height; ++i )
+    {
+
+      pLayer[ i * 4 + 0 ] = pMoments[ i * 2 + 0 ];
+      pLayer[ i * 4 + 1 ] = pMoments[ i * 2 + 1 ];
+      pLayer[ i * 4 + 2 ] = 0.0f;
+      pLayer[ i * 4 + 3 ] = 0.0f;
+
+    }
+
+    moments->unmap( );
+
+  }
+
+  CheckpointHeader &header = pCheckpoint->getHeader( );
+
+  header.pathTracing     = pathTracing_ ? 1 : 0;
+  header.bounceLayers    = bounceLayers_ ? 1 : 0;
+  header.rouletteLayer   = rouletteLayer ? 1 : 0;
+  header.frameNumber     = frame_;
+  header.frameOffset     = frameOffset_;
+  header.globalSeed      = globalSeed_;
+  header.sqrtSamples     = sqrtSamples_;
+  header.samplesPerPixel = static_cast< std::uint64_t >( frame_ - 1 ) * sqrtSamples_ * sqrtSamples_;
+  header.sceneHash       = getSceneHash( );
+  header.cameraHash      = getCameraHash( );
+
+} // OptixRenderer::captureCheckpoint
+
+
+
+///
+/// \brief OptixRenderer::restoreCheckpoint
+/// \param checkpoint
+///
+void
+OptixRenderer::restoreCheckpoint( const MappedCheckpoint &checkpoint )
+{
+
+  const CheckpointHeader &header = checkpoint.getHeader( );
+
+  RTsize width, height;
+  getBuffer( )->getSize( width, height );
+
+  if ( header.width != width || header.height != height )
+  {
+
+    throw std::runtime_error( "Checkpoint image size does not match the renderer" );
+
+  }
+
+  if ( header.sceneHash != getSceneHash( ) )
+  {
+
+    throw std::runtime_error( "Checkpoint was rendered from a different scene or scene settings" );
+
+  }
+
+  if ( header.cameraHash != getCameraHash( ) )
+  {
+
+    throw std::runtime_error( "Checkpoint was rendered from a different camera" );
+
+  }
+
+  bool rouletteLayer = context_[ "roulette_policy" ]->getUint( ) == ROULETTE_EFFICIENCY;
+
+  if ( ( header.rouletteLayer != 0 ) != rouletteLayer )
+  {
+
+    throw std::runtime_error( "Checkpoint roulette moments do not match the roulette policy" );
+
+  }
+
+  if ( ( header.bounceLayers != 0 ) != bounceLayers_ )
+  {
+
+    setBounceLayers( header.bounceLayers != 0 );
+
+  }
+
+  std::vector< optix::Buffer > layers = { getBuffer( ) };
+
+  if ( bounceLayers_ )
+  {
+
+    layers.push_back( context_[ "direct_buffer"   ]->getBuffer( ) );
+    layers.push_back( context_[ "indirect_buffer" ]->getBuffer( ) );
+
+  }
+
+  std::size_t layerBytes = width * height * 4 * sizeof( float );
+
+  for ( unsigned i = 0; i < layers.size( ); ++i )
+  {
+
+    std::memcpy( layers[ i ]->map( ), checkpoint.getLayer( i ), layerBytes );
+    layers[ i ]->unmap( );
+
+  }
+
+  if ( rouletteLayer )
+  {
+
+    optix::Buffer moments = context_[ "roulette_buffer" ]->getBuffer( );
+
+    const float *pLayer   = checkpoint.getLayer( static_cast< unsigned >( layers.size( ) ) );
+    float       *pMoments = static_cast< float* >( moments->map( ) );
+
+    for ( std::size_t i = 0; i < width * height; ++i )
+    {
+
+      pMoments[ i * 2 + 0 ] = pLayer[ i * 4 + 0 ];
+      pMoments[ i * 2 + 1 ] = pLayer[ i * 4 + 1 ];
+
+    }
+
+    moments->unmap( );
+
+  }
+
+  setSqrtSamples( header.sqrtSamples );
+  setGlobalSeed ( header.globalSeed );
+  setFrameOffset( header.frameOffset );
+
+  frame_ = header.frameNumber;
+
+} // OptixRenderer::restoreCheckpoint
+
+
+
+///
+/// \brief OptixRenderer::getSceneHash
+/// \return
+///
+std::uint64_t
+OptixRenderer::getSceneHash( )
+{
+
+  std::uint64_t hash = hashValue( pathTracing_ );
+
+  // the albedo policy weighs bounces differently from the others
+  hash = hashValue( context_[ "roulette_policy"     ]->getUint( ), hash );
+  hash = hashValue( context_[ "roulette_min_depth"  ]->getUint( ), hash );
+  hash = hashValue( context_[ "first_bounce_splits" ]->getUint( ), hash );
+
+  return hash;
+
+}
+
+
+
+///
+/// \brief OptixRenderer::getCameraHash
+/// \return
+///
+std::uint64_t
+OptixRenderer::getCameraHash( )
+{
+
+  RTsize width, height;
+  getBuffer( )->getSize( width, height );
+
+  std::uint64_t hash = hashSeed;
+
+  for ( const glm::vec3 &v : camera_ )
+  {
+    hash = hashValue( v.x, hashValue( v.y, hashValue( v.z, hash ) ) );
+  }
+
+  hash = hashValue( static_cast< std::uint64_t >( width ),  hash );
+  hash = hashValue( static_cast< std::uint64_t >( height ), hash );
+
+  return hash;
+
+}
+
+
+
 ///
 /// \brief OptixRenderer::getBuffer
 /// \return
@@ -454,6 +1113,11 @@ OptixRenderer::resetFrameCount( )
 
   frame_ = 1;
 
+  if ( pathStatistics_ )
+  {
+    _clearPathStatistics( );
+  }
+
 }
 
 
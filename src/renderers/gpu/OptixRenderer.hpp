@@ -6,12 +6,20 @@
 #include "optixu/optixpp_namespace.h"
 #include "RendererInterface.hpp"
 #include <string>
+#include <cstdint>
+#include "MemoryAccounting.hpp"
+#include "Roulette.hpp"
 
 
 namespace light
 {
 
 
+class RenderCheckpoint;
+class MappedCheckpoint;
+struct PathStatistics;
+
+
 /////////////////////////////////////////////
 /// \brief The OptixRenderer class
 ///
@@ -24,6 +32,9 @@ public:
 
   ///////////////////////////////////////////////////////////////
   /// \brief OptixRenderer
+  ///
+  ///        A vbo of 0 renders into a plain OptiX buffer instead
+  ///        of an OpenGL buffer (headless workers, batch jobs)
   ///////////////////////////////////////////////////////////////
   OptixRenderer(
                 int      width,
@@ -44,6 +55,92 @@ public:
   void setPathTracing ( bool pathTracing );
 
 
+  ///////////////////////////////////////////////////////////////
+  /// \brief setGlobalSeed
+  ///
+  ///        Path tracing cameras pick a random seed; processes
+  ///        rendering parts of the same image must share one
+  ///////////////////////////////////////////////////////////////
+  void setGlobalSeed ( unsigned seed );
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief setFrameOffset
+  ///
+  ///        Shifts the random sequence used by the path tracer so
+  ///        separate processes can render disjoint sample ranges
+  ///////////////////////////////////////////////////////////////
+  void setFrameOffset ( unsigned offset );
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief setBounceLayers
+  ///
+  ///        Splits path traced radiance into direct (first hit)
+  ///        and indirect (all later bounces) accumulation layers
+  ///        alongside the full image. Bounces the image skips for
+  ///        first_bounce are skipped in the layers too, so the
+  ///        image is always their sum.
+  ///////////////////////////////////////////////////////////////
+  void setBounceLayers ( bool bounceLayers );
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief setTraversalCost
+  ///
+  ///        Replaces the non path traced image with a heatmap of
+  ///        primitive tests per sample made by primary and shadow
+  ///        rays; 'scale' tests per sample show as red
+  ///////////////////////////////////////////////////////////////
+  void setTraversalCost (
+                         bool  enabled,
+                         float scale = 64.0f
+                         );
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief setPathStatistics
+  ///
+  ///        Counts how path traced samples end: length, reason,
+  ///        throughput and shadow ray occlusion. The counts
+  ///        start over whenever the frame count is reset.
+  ///////////////////////////////////////////////////////////////
+  void setPathStatistics ( bool enabled );
+
+  bool getPathStatisticsEnabled ( ) const { return pathStatistics_; }
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief setRoulette
+  ///
+  ///        How path traced samples end, see Roulette.hpp. Paths
+  ///        always continue until they are minDepth bounces
+  ///        long. ROULETTE_EFFICIENCY keeps per pixel moments of
+  ///        the accumulated frames.
+  ///////////////////////////////////////////////////////////////
+  void setRoulette (
+                    RoulettePolicy policy,
+                    unsigned       minDepth
+                    );
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief setFirstBounceSplits
+  ///
+  ///        Continues the first hit of every camera ray along
+  ///        'splits' bounces, which share the camera ray and the
+  ///        first hit's light samples. 1 turns splitting off.
+  ///////////////////////////////////////////////////////////////
+  void setFirstBounceSplits ( unsigned splits );
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief getPathStatistics
+  /// \return counts merged from every slot since the last reset
+  ///////////////////////////////////////////////////////////////
+  PathStatistics getPathStatistics ( );
+
+
   virtual
   void resize (
                int w,
@@ -54,13 +151,91 @@ public:
   void renderWorld ( const graphics::Camera &camera ) final;
 
 
+  ///////////////////////////////////////////////////////////////
+  /// \brief setCamera
+  ///
+  ///        Sets the pinhole/orthographic ray basis directly
+  ///////////////////////////////////////////////////////////////
+  void setCamera (
+                  const glm::vec3 &eye,
+                  const glm::vec3 &U,
+                  const glm::vec3 &V,
+                  const glm::vec3 &W
+                  );
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief renderRegion
+  ///
+  ///        Launches one frame over a sub-rectangle of the output
+  ///        buffer with the current camera
+  ///////////////////////////////////////////////////////////////
+  void renderRegion (
+                     unsigned x,
+                     unsigned y,
+                     unsigned width,
+                     unsigned height
+                     );
+
+
   void saveFrame( const std::string &filename );
 
 
+  ///////////////////////////////////////////////////////////////
+  /// \brief saveBounceLayers
+  ///
+  ///        Writes '<name>_direct', '<name>_indirect' and
+  ///        '<name>_both' images next to 'filename'
+  ///////////////////////////////////////////////////////////////
+  void saveBounceLayers( const std::string &filename );
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief captureCheckpoint
+  ///
+  ///        Copies the accumulated buffers and the random sequence
+  ///        position. Writing the result to disk is left to the
+  ///        caller (see CheckpointWriter).
+  ///////////////////////////////////////////////////////////////
+  void captureCheckpoint ( RenderCheckpoint *pCheckpoint );
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief restoreCheckpoint
+  ///
+  ///        Loads accumulated buffers and frame state so rendering
+  ///        continues exactly where the checkpoint left off. Must be
+  ///        called after the scene, camera and sampling settings are
+  ///        applied since those reset the frame count. Throws if the
+  ///        checkpoint belongs to a different scene, camera or size.
+  ///////////////////////////////////////////////////////////////
+  void restoreCheckpoint ( const MappedCheckpoint &checkpoint );
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief getSceneHash
+  /// \return hash of everything that changes the converged image
+  ///         apart from the camera
+  ///////////////////////////////////////////////////////////////
+  virtual
+  std::uint64_t getSceneHash ( );
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief getCameraHash
+  /// \return hash of the last camera basis and the image size
+  ///////////////////////////////////////////////////////////////
+  std::uint64_t getCameraHash ( );
+
+
   optix::Buffer getBuffer ( );
 
   void resetFrameCount ( );
 
+  unsigned getFrameNumber ( ) const { return frame_; }
+  unsigned getSqrtSamples ( ) const { return sqrtSamples_; }
+  unsigned getGlobalSeed  ( ) const { return globalSeed_; }
+
 
   glm::vec3 background_color;
   glm::vec3 error_color;
@@ -68,6 +243,15 @@ public:
 
 protected:
 
+  ///////////////////////////////////////////////////////////////
+  /// \brief compileContext
+  ///
+  ///        Validates and compiles the context, then builds the
+  ///        acceleration structures with an empty launch so the
+  ///        cost shows up while loading, not in the first frame.
+  ///////////////////////////////////////////////////////////////
+  void compileContext ( );
+
   optix::Context context_;
 
 
@@ -78,12 +262,30 @@ private:
 //  int    m_num_devices;
 //  bool   m_cpu_rendering_enabled;
 
+  void _clearPathStatistics ( );
+
+  ///
+  /// \brief _updateFramebufferMemory
+  ///
+  ///        Recounts the output buffer and every optional
+  ///        per-pixel buffer at their current sizes
+  ///
+  void _updateFramebufferMemory ( );
+
   bool pathTracing_;
+  bool bounceLayers_;
+  bool pathStatistics_;
   unsigned frame_;
+  unsigned sqrtSamples_;
+  unsigned globalSeed_;
+  unsigned frameOffset_;
+
+  glm::vec3 camera_[ 4 ]; // eye, U, V, W of the last render
 
   unsigned width_;
   unsigned height_;
 
+  TrackedMemory framebufferMemory_;
 
 
 };
@@ -1,5 +1,10 @@
 #include "OptixScene.hpp"
+#include <map>
 #include <sstream>
+#include <typeinfo>
+#include "Hash.hpp"
+#include "Instrumentation.hpp"
+#include "Trace.hpp"
 #include "optixMod/optix_math_stream_namespace_mod.h"
 #include "LightBenderConfig.hpp"
 #include "graphics/Camera.hpp"
@@ -10,6 +15,170 @@ namespace light
 {
 
 
+namespace
+{
+
+
+constexpr int traversalCostDisplay = 3;
+
+
+optix::float3
+toOptix( Float3 v )
+{
+
+  return optix::make_float3( v.x, v.y, v.z );
+
+}
+
+
+optix::Matrix4x4
+toOptix( const Transform &transform )
+{
+
+  float matrix[ 16 ] = { 0.0f };
+  std::memcpy( matrix, transform.m, sizeof( transform.m ) );
+  matrix[ 15 ] = 1.0f;
+
+  return optix::Matrix4x4( matrix );
+
+}
+
+
+Illuminator
+toOptix( const IlluminatorRecord &record )
+{
+
+  Illuminator illuminator;
+  illuminator.center      = toOptix( record.center );
+  illuminator.radiantFlux = toOptix( record.radiantFlux );
+  illuminator.shape       = static_cast< LightShape::LightShapes >( record.shape );
+  illuminator.radius      = record.radius;
+
+  return illuminator;
+
+}
+
+
+void
+setMaterialVariables(
+                     optix::Material       material,
+                     const MaterialRecord &record
+                     )
+{
+
+  if ( isEmissive( record ) )
+  {
+
+    material[ "emissionRadiance" ]->setFloat( toOptix( record.emission ) );
+
+  }
+  else
+  {
+
+    material[ "albedo"    ]->setFloat( toOptix( record.albedo ) );
+    material[ "roughness" ]->setFloat( record.roughness );
+    material[ "ior"       ]->setFloat( toOptix( record.ior ) );
+
+  }
+
+}
+
+
+optix::Buffer
+createFilledBuffer(
+                   optix::Context context,
+                   RTformat       format,
+                   std::size_t    count,
+                   std::size_t    elementBytes,
+                   const void    *pData
+                   )
+{
+
+  optix::Buffer buffer = context->createBuffer( RT_BUFFER_INPUT, format, count );
+
+  if ( count > 0 )
+  {
+
+    std::memcpy( buffer->map( ), pData, count * elementBytes );
+    buffer->unmap( );
+
+  }
+
+  return buffer;
+
+}
+
+
+///
+/// \brief estimateBvhBytes
+///
+///        OptiX doesn't report what its acceleration structures
+///        occupy, so count what a binary BVH over 'items' needs:
+///        2 items - 1 nodes of bounds and child links plus one
+///        index per item
+///
+std::size_t
+estimateBvhBytes( std::size_t items )
+{
+
+  const std::size_t nodeBytes = 32;
+
+  return items > 0 ? ( 2 * items - 1 ) * nodeBytes + items * sizeof( std::uint32_t ) : 0;
+
+}
+
+
+///
+/// \brief getPrimitiveBytes
+/// \return device input buffer bytes created for one primitive
+///
+std::size_t
+getPrimitiveBytes(
+                  const SceneDescription &scene,
+                  const PrimitiveRecord  &primitive
+                  )
+{
+
+  if ( primitive.type != PrimitiveType::MESH )
+  {
+    return sizeof( PrimitiveRecord );
+  }
+
+  const MeshRecord &mesh = scene.getMeshes( )[ primitive.mesh ];
+
+  // vertices, normals, index triples and a material index per triangle
+  return ( mesh.vertexCount + mesh.normalCount ) * sizeof( Float3 )
+         + mesh.triangleCount * ( sizeof( std::uint32_t ) * 3 + sizeof( int ) );
+
+}
+
+
+std::size_t
+getItemCount(
+             const SceneDescription             &scene,
+             const std::vector< std::uint32_t > &primitives
+             )
+{
+
+  std::size_t items = 0;
+
+  for ( std::uint32_t index : primitives )
+  {
+
+    const PrimitiveRecord &primitive = scene.getPrimitives( )[ index ];
+
+    items += primitive.type == PrimitiveType::MESH ? scene.getMeshes( )[ primitive.mesh ].triangleCount : 1;
+
+  }
+
+  return items;
+
+}
+
+
+} // namespace
+
+
 
 ///////////////////////////////////////////////////////////////
 /// \brief OptixScene::OptixScene
@@ -21,6 +190,11 @@ OptixScene::OptixScene(
                        )
   : OptixRenderer ( width, height, vbo )
   , sceneMaterial_( context_->createMaterial( ) )
+  , editor_       ( &description_ )
+  , displayType_  ( 0 )
+  , costScale_    ( 64.0f )
+  , geometryMemory_    ( MemoryCategory::GEOMETRY )
+  , accelerationMemory_( MemoryCategory::ACCELERATION )
 {
 
   //
@@ -86,6 +260,7 @@ OptixScene::OptixScene(
   setSqrtSamples( 1 ); // single sample per pixel on each pass
   setMaxBounces ( 5 ); // only allow 5 bounces
   setFirstBounce( 0 ); // start rendering on first bounce
+  setMathPrecision( MATH_PRECISE ); // final quality until a preview asks otherwise
 
 }
 
@@ -107,9 +282,16 @@ void
 OptixScene::setDisplayType( int type )
 {
 
-  std::string programName       = materialNames_[ static_cast< size_t >( type ) ];
+  displayType_ = type;
+
+  // the heatmap counts the same primary and shadow rays simple shading traces
+  bool traversalCost = ( type == traversalCostDisplay );
+
+  std::string programName       = materialNames_[ static_cast< size_t >( traversalCost ? 1 : type ) ];
   optix::Program currentProgram = materialPrograms_[ programName ];
 
+  setTraversalCost( traversalCost, costScale_ );
+
   sceneMaterial_->setClosestHitProgram( 0, currentProgram );
 
   for ( auto &shapePair : shapes_ )
@@ -137,6 +319,22 @@ OptixScene::setDisplayType( int type )
 
 
 
+///////////////////////////////////////////////////////////////
+/// \brief OptixScene::setTraversalCostScale
+/// \param scale
+///////////////////////////////////////////////////////////////
+void
+OptixScene::setTraversalCostScale( float scale )
+{
+
+  costScale_ = scale;
+
+  setTraversalCost( displayType_ == traversalCostDisplay, costScale_ );
+
+} // OptixScene::setTraversalCostScale
+
+
+
 ///////////////////////////////////////////////////////////////
 /// \brief OptixScene::setMaxBounces
 /// \param bounces
@@ -169,6 +367,85 @@ OptixScene::setFirstBounce( unsigned bounce )
 
 
 
+///////////////////////////////////////////////////////////////
+/// \brief OptixScene::setMathPrecision
+/// \param precision
+///////////////////////////////////////////////////////////////
+void
+OptixScene::setMathPrecision( MathPrecision precision )
+{
+
+  context_[ "math_precision" ]->setUint( static_cast< unsigned >( precision ) );
+
+  resetFrameCount( );
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief OptixScene::getSceneHash
+///
+///        Covers the scene class, render settings, shape transforms,
+///        editable material values and illuminators. Shapes are
+///        visited by name so the hash doesn't depend on map order.
+///////////////////////////////////////////////////////////////
+std::uint64_t
+OptixScene::getSceneHash( )
+{
+
+  std::uint64_t hash = OptixRenderer::getSceneHash( );
+
+  hash = hashString( typeid( *this ).name( ), hash );
+  hash = hashValue( displayType_, hash );
+  hash = hashValue( context_[ "max_bounces"    ]->getUint( ), hash );
+  hash = hashValue( context_[ "first_bounce"   ]->getUint( ), hash );
+  hash = hashValue( context_[ "math_precision" ]->getUint( ), hash );
+
+  std::map< std::string, const ShapeGroup* > sortedShapes;
+
+  for ( const auto &shapePair : shapes_ )
+  {
+    sortedShapes[ shapePair.first ] = &shapePair.second;
+  }
+
+  for ( const auto &shapePair : sortedShapes )
+  {
+
+    const ShapeGroup &shape = *shapePair.second;
+
+    hash = hashString( shapePair.first, hash );
+    hash = hashBytes( shape.transform.getData( ), sizeof( float ) * 16, hash );
+    hash = hashValue( shape.illuminatorIndex, hash );
+    hash = hashValue( static_cast< std::uint64_t >( shape.geometries.size( ) ), hash );
+
+    // the values renderSceneGui lets users edit
+    if ( shape.illuminatorIndex < 0 && !shape.materials.empty( ) )
+    {
+
+      optix::Material material = shape.materials[ 0 ];
+
+      hash = hashValue( material[ "albedo"    ]->getFloat3( ), hash );
+      hash = hashValue( material[ "roughness" ]->getFloat ( ), hash );
+      hash = hashValue( material[ "ior"       ]->getFloat3( ), hash );
+
+    }
+
+  }
+
+  if ( !illuminators_.empty( ) )
+  {
+
+    hash = hashBytes( illuminators_.data( ), illuminators_.size( ) * sizeof( Illuminator ), hash );
+
+  }
+
+  return hash;
+
+} // OptixScene::getSceneHash
+
+
+
 ///////////////////////////////////////////////////////////////
 /// \brief OptixScene::createBoxPrimitive
 /// \param min
@@ -278,6 +555,76 @@ OptixScene::createQuadPrimitive(
 
 
 
+///////////////////////////////////////////////////////////////
+/// \brief OptixScene::createMeshPrimitive
+/// \param scene
+/// \param mesh
+/// \return
+///////////////////////////////////////////////////////////////
+optix::Geometry
+OptixScene::createMeshPrimitive(
+                                const SceneDescription &scene,
+                                std::uint32_t           mesh
+                                )
+{
+
+  static_assert( sizeof( Float3 ) == sizeof( optix::float3 ), "Scene vertices must match float3" );
+
+  const MeshRecord &record = scene.getMeshes( )[ mesh ];
+
+  std::string mesh_ptx( light::RES_PATH + "ptx/cudaLightBender_generated_TriangleMesh.cu.ptx" );
+  optix::Program mesh_bounds    = context_->createProgramFromPTXFile( mesh_ptx, "mesh_bounds" );
+  optix::Program mesh_intersect = context_->createProgramFromPTXFile( mesh_ptx, "mesh_intersect" );
+
+  optix::Geometry geometry = context_->createGeometry( );
+
+  geometry->setPrimitiveCount( record.triangleCount );
+  geometry->setBoundingBoxProgram( mesh_bounds );
+  geometry->setIntersectionProgram( mesh_intersect );
+
+  const std::uint32_t *pTriangles = scene.getTriangles( ).data( ) + record.firstTriangle * 3;
+  std::vector< int > materialIndices( record.triangleCount, 0 );
+
+  geometry[ "vertex_buffer" ]->setBuffer( createFilledBuffer(
+                                                             context_,
+                                                             RT_FORMAT_FLOAT3,
+                                                             record.vertexCount,
+                                                             sizeof( Float3 ),
+                                                             scene.getVertices( ).data( ) + record.firstVertex
+                                                             ) );
+
+  geometry[ "normal_buffer" ]->setBuffer( createFilledBuffer(
+                                                             context_,
+                                                             RT_FORMAT_FLOAT3,
+                                                             record.normalCount,
+                                                             sizeof( Float3 ),
+                                                             scene.getNormals( ).data( ) + record.firstNormal
+                                                             ) );
+
+  geometry[ "index_buffer" ]->setBuffer( createFilledBuffer(
+                                                            context_,
+                                                            RT_FORMAT_INT3,
+                                                            record.triangleCount,
+                                                            sizeof( std::uint32_t ) * 3,
+                                                            pTriangles
+                                                            ) );
+
+  geometry[ "texcoord_buffer" ]->setBuffer( context_->createBuffer( RT_BUFFER_INPUT, RT_FORMAT_FLOAT2, 0 ) );
+
+  geometry[ "material_buffer" ]->setBuffer( createFilledBuffer(
+                                                               context_,
+                                                               RT_FORMAT_INT,
+                                                               materialIndices.size( ),
+                                                               sizeof( int ),
+                                                               materialIndices.data( )
+                                                               ) );
+
+  return geometry;
+
+} // OptixScene::createMeshPrimitive
+
+
+
 ///////////////////////////////////////////////////////////////
 /// \brief OptixScene::createMaterial
 /// \param closestHitProgram
@@ -594,10 +941,304 @@ OptixScene::createSphereIlluminator(
 
 
 
+///////////////////////////////////////////////////////////////
+/// \brief OptixScene::compileScene
+/// \param scene
+///////////////////////////////////////////////////////////////
+void
+OptixScene::compileScene( const SceneDescription &scene )
+{
+
+  static_assert( sizeof( IlluminatorRecord ) == sizeof( Illuminator ), "Illuminator layouts must match" );
+
+  LIGHT_TRACE_SCOPE( "compileScene", "scene" );
+
+  scene.validate( );
+
+  //
+  // primitives
+  //
+  std::vector< optix::Geometry > geometries;
+
+  for ( const PrimitiveRecord &primitive : scene.getPrimitives( ) )
+  {
+
+    switch ( primitive.type )
+    {
+
+    case PrimitiveType::BOX:
+      geometries.push_back( createBoxPrimitive( toOptix( primitive.a ), toOptix( primitive.b ) ) );
+      break;
+
+    case PrimitiveType::SPHERE:
+      geometries.push_back( createSpherePrimitive( toOptix( primitive.a ), primitive.radius ) );
+      break;
+
+    case PrimitiveType::QUAD:
+      geometries.push_back( createQuadPrimitive(
+                                                toOptix( primitive.a ),
+                                                toOptix( primitive.b ),
+                                                toOptix( primitive.c )
+                                                ) );
+      break;
+
+    case PrimitiveType::MESH:
+      geometries.push_back( createMeshPrimitive( scene, primitive.mesh ) );
+      break;
+
+    } // switch
+
+  }
+
+  //
+  // materials
+  //
+  materials_.clear( );
+
+  for ( const MaterialRecord &record : scene.getMaterials( ) )
+  {
+
+    optix::Material material;
+
+    if ( isEmissive( record ) )
+    {
+
+      material = context_->createMaterial( );
+      material->setClosestHitProgram( 0, materialPrograms_[ "closest_hit_emission" ] );
+
+    }
+    else
+    {
+
+      material = createMaterial(
+                                materialPrograms_[ "closest_hit_bsdf" ],
+                                materialPrograms_[ "any_hit_occlusion" ]
+                                );
+
+    }
+
+    setMaterialVariables( material, record );
+    materials_.push_back( material );
+
+  }
+
+  //
+  // lights
+  //
+  illuminators_.clear( );
+
+  for ( const IlluminatorRecord &record : scene.getIlluminators( ) )
+  {
+    illuminators_.push_back( toOptix( record ) );
+  }
+
+  //
+  // shapes
+  //
+  shapes_.clear( );
+
+  transformShapes_.assign( scene.getTransforms( ).size( ), std::vector< std::string >( ) );
+
+  // instances of the same primitives share one acceleration structure
+  std::map< std::pair< std::vector< std::uint32_t >, AccelHint >, optix::Acceleration > accelerations;
+
+  for ( std::size_t i = 0; i < scene.getShapes( ).size( ); ++i )
+  {
+
+    const ShapeRecord &record = scene.getShapes( )[ i ];
+    const Transform &transform = scene.getTransforms( )[ record.transform ];
+
+    ShapeGroup shape;
+
+    for ( std::uint32_t p = 0; p < record.primitiveCount; ++p )
+    {
+
+      shape.geometries.push_back( geometries[ scene.getShapePrimitives( )[ record.firstPrimitive + p ] ] );
+      shape.materials.push_back( materials_[ record.material ] );
+
+    }
+
+    if ( record.accel == AccelHint::BVH )
+    {
+
+      shape.builderAccel   = "Trbvh";
+      shape.traverserAccel = "Bvh";
+
+    }
+
+    shape.transform        = toOptix( transform );
+    shape.illuminatorIndex = record.illuminator;
+
+    createShapeGeomGroup( &shape );
+
+    auto key = std::make_pair(
+                              std::vector< std::uint32_t >(
+                                                           scene.getShapePrimitives( ).begin( ) + record.firstPrimitive,
+                                                           scene.getShapePrimitives( ).begin( ) + record.firstPrimitive + record.primitiveCount
+                                                           ),
+                              record.accel
+                              );
+
+    auto found = accelerations.find( key );
+
+    if ( found == accelerations.end( ) )
+    {
+      accelerations.emplace( std::move( key ), shape.group->getAcceleration( ) );
+    }
+    else
+    {
+      shape.group->setAcceleration( found->second );
+    }
+
+    shapes_[ scene.getShapeNames( )[ i ] ] = shape;
+    transformShapes_[ record.transform ].push_back( scene.getShapeNames( )[ i ] );
+
+  }
+
+  //
+  // top group everything will get attached to
+  //
+  optix::Group topGroup = context_->createGroup( );
+  topGroup->setChildCount( static_cast< unsigned >( shapes_.size( ) ) );
+
+  unsigned index = 0;
+
+  for ( auto &shapePair : shapes_ )
+  {
+
+    ShapeGroup &s = shapePair.second;
+    attachToGroup( topGroup, s.group, index, s.transform );
+    s.transformNode = topGroup->getChild< optix::Transform >( index );
+    ++index;
+
+  }
+
+  // moving shapes only changes transforms, so the top level refits
+  topAcceleration_ = context_->createAcceleration( "Bvh", "Bvh" );
+  topAcceleration_->setProperty( "refit", "1" );
+  topGroup->setAcceleration( topAcceleration_ );
+
+  context_[ "top_object"   ]->set( topGroup );
+  context_[ "top_shadower" ]->set( topGroup );
+
+  illuminatorBuffer_ = createInputBuffer( illuminators_ );
+  context_[ "illuminators" ]->set( illuminatorBuffer_ );
+
+  description_ = scene;
+  editor_.takeChanges( ); // edits of the previous scene no longer apply
+
+  //
+  // memory: the device buffers above plus the description kept for edits
+  //
+  std::size_t geometryBytes = description_.getMemoryBytes( ) + illuminators_.size( ) * sizeof( Illuminator );
+
+  for ( const PrimitiveRecord &primitive : scene.getPrimitives( ) )
+  {
+    geometryBytes += getPrimitiveBytes( scene, primitive );
+  }
+
+  std::size_t accelerationBytes = estimateBvhBytes( shapes_.size( ) );
+
+  for ( const auto &acceleration : accelerations )
+  {
+    accelerationBytes += estimateBvhBytes( getItemCount( scene, acceleration.first.first ) );
+  }
+
+  geometryMemory_.set( geometryBytes );
+  accelerationMemory_.set( accelerationBytes );
+
+} // OptixScene::compileScene
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief OptixScene::applySceneChanges
+///////////////////////////////////////////////////////////////
+bool
+OptixScene::applySceneChanges( )
+{
+
+  if ( !editor_.hasChanges( ) )
+  {
+    return false;
+  }
+
+  LIGHT_PROFILE_SCOPE( SCENE_UPDATE );
+
+  SceneChanges changes = editor_.takeChanges( );
+
+  //
+  // materials only need their variables set
+  //
+  for ( std::uint32_t index : changes.materials )
+  {
+
+    setMaterialVariables( materials_[ index ], description_.getMaterials( )[ index ] );
+
+  }
+
+  //
+  // lights are patched in place with one map of the buffer
+  //
+  if ( !changes.illuminators.empty( ) )
+  {
+
+    Illuminator *pIlluminators = static_cast< Illuminator* >( illuminatorBuffer_->map( ) );
+
+    for ( std::uint32_t index : changes.illuminators )
+    {
+
+      illuminators_[ index ] = toOptix( description_.getIlluminators( )[ index ] );
+      pIlluminators[ index ] = illuminators_[ index ];
+
+    }
+
+    illuminatorBuffer_->unmap( );
+
+  }
+
+  //
+  // moved shapes update their transform nodes and the top
+  // level refits; bottom levels are untouched
+  //
+  if ( !changes.transforms.empty( ) )
+  {
+
+    for ( std::uint32_t index : changes.transforms )
+    {
+
+      optix::Matrix4x4 matrix = toOptix( description_.getTransforms( )[ index ] );
+
+      for ( const std::string &name : transformShapes_[ index ] )
+      {
+
+        ShapeGroup &shape = shapes_[ name ];
+
+        shape.transform = matrix;
+        shape.transformNode->setMatrix( false, matrix.getData( ), 0 );
+
+      }
+
+    }
+
+    topAcceleration_->markDirty( );
+
+  }
+
+  resetFrameCount( );
+
+  return true;
+
+} // OptixScene::applySceneChanges
+
+
+
 ///////////////////////////////////////////////////////////////
 /// \brief Optixcene::renderSceneGui
 ///
-///        Allows for specific manipulation of each scene
+///        Allows for specific manipulation of each scene. Edits
+///        go through the scene editor and reach OptiX with the
+///        next applySceneChanges.
 ///////////////////////////////////////////////////////////////
 void
 OptixScene::renderSceneGui( )
@@ -608,96 +1249,53 @@ OptixScene::renderSceneGui( )
 
     std::stringstream stream;
 
+    const std::vector< ShapeRecord > &shapes = description_.getShapes( );
+    const std::vector< std::string > &names  = description_.getShapeNames( );
+
     //
     // Non-emitting shapes
     //
-    for ( auto &shapePair : shapes_ )
+    for ( std::size_t s = 0; s < shapes.size( ); ++s )
     {
 
-      ShapeGroup &shape       = shapePair.second;
-      const std::string &name = shapePair.first;
+      const ShapeRecord &shape = shapes[ s ];
+      const std::string &name  = names[ s ];
 
-      if ( shape.illuminatorIndex < 0 )
+      if ( shape.illuminator < 0 )
       {
 
         ImGui::Separator( );
 
         ImGui::Text( "%s", name.c_str( ) );
 
+        MaterialRecord material = description_.getMaterials( )[ shape.material ];
+
 
         //
         // albedo
         //
-        optix::float3 albedo = shape.materials[ 0 ][ "albedo" ]->getFloat3( );
-        float albedoOld[ 3 ] = { albedo.x, albedo.y, albedo.z };
-        float albedoNew[ 3 ] = { albedo.x, albedo.y, albedo.z };
-
         stream << "Albedo " << name;
-        ImGui::ColorEdit3( stream.str( ).c_str( ), albedoNew );
+        ImGui::ColorEdit3( stream.str( ).c_str( ), &material.albedo.x );
         stream.str( std::string( ) );
 
-        if (
-            albedoOld[ 0 ] != albedoNew[ 0 ]
-            || albedoOld[ 1 ] != albedoNew[ 1 ]
-            || albedoOld[ 2 ] != albedoNew[ 2 ]
-            )
-        {
-
-          shape.materials[ 0 ][ "albedo" ]->setFloat(
-                                                     albedoNew[ 0 ],
-                                                     albedoNew[ 1 ],
-                                                     albedoNew[ 2 ]
-                                                     );
-          resetFrameCount( );
-
-        }
-
 
         //
         // roughness
         //
-        float roughness    = shape.materials[ 0 ][ "roughness" ]->getFloat( );
-        float roughnessOld = roughness;
-
         stream << "Roughness " << name;
-        ImGui::SliderFloat( stream.str( ).c_str( ), &roughness, 0.001f, 1.0f );
+        ImGui::SliderFloat( stream.str( ).c_str( ), &material.roughness, 0.001f, 1.0f );
         stream.str( std::string( ) );
 
-        if ( roughnessOld != roughness )
-        {
-
-          shape.materials[ 0 ][ "roughness" ]->setFloat( roughness );
-          resetFrameCount( );
-
-        }
-
 
         //
-        // albedo
+        // index of refraction
         //
-        optix::float3 ior = shape.materials[ 0 ][ "ior" ]->getFloat3( );
-        float iorOld[ 3 ] = { ior.x, ior.y, ior.z };
-        float iorNew[ 3 ] = { ior.x, ior.y, ior.z };
-
         stream << "IOR " << name;
-        ImGui::SliderFloat3( stream.str( ).c_str( ), iorNew, 1.0f, 10.0f );
+        ImGui::SliderFloat3( stream.str( ).c_str( ), &material.ior.x, 1.0f, 10.0f );
         stream.str( std::string( ) );
 
-        if (
-            iorOld[ 0 ] != iorNew[ 0 ]
-            || iorOld[ 1 ] != iorNew[ 1 ]
-            || iorOld[ 2 ] != iorNew[ 2 ]
-            )
-        {
-
-          shape.materials[ 0 ][ "ior" ]->setFloat(
-                                                  iorNew[ 0 ],
-                                                  iorNew[ 1 ],
-                                                  iorNew[ 2 ]
-                                                  );
-          resetFrameCount( );
-
-        }
+        // only marks the material dirty if something moved
+        editor_.setMaterial( shape.material, material );
 
       }
 
@@ -708,58 +1306,35 @@ OptixScene::renderSceneGui( )
     //
     // Illuminators
     //
-    bool updateLightBuffer = false;
-
-    for ( auto &shapePair : shapes_ )
+    for ( std::size_t s = 0; s < shapes.size( ); ++s )
     {
 
-      ShapeGroup &shape       = shapePair.second;
-      const std::string &name = shapePair.first;
+      const ShapeRecord &shape = shapes[ s ];
+      const std::string &name  = names[ s ];
 
-      if ( shape.illuminatorIndex >= 0 )
+      if ( shape.illuminator >= 0 )
       {
 
-        Illuminator &i = illuminators_[ static_cast< unsigned >( shape.illuminatorIndex ) ];
+        std::uint32_t index = static_cast< std::uint32_t >( shape.illuminator );
+        IlluminatorRecord illuminator = description_.getIlluminators( )[ index ];
 
         ImGui::Separator( );
 
         ImGui::Text( "%s", name.c_str( ) );
 
-        float fluxOld[ 3 ] = { i.radiantFlux.x, i.radiantFlux.y, i.radiantFlux.z };
-
         stream << "Power (W) " << name;
-        ImGui::SliderFloat3( stream.str( ).c_str( ), fluxOld, 1.0f, 3000.0f );
+        ImGui::SliderFloat3( stream.str( ).c_str( ), &illuminator.radiantFlux.x, 1.0f, 3000.0f );
         stream.str( std::string( ) );
 
-        if ( fluxOld[ 0 ] != i.radiantFlux.x
-            || fluxOld[ 1 ] != i.radiantFlux.y
-            || fluxOld[ 2 ] != i.radiantFlux.z )
-        {
-
-          i.radiantFlux     = optix::make_float3( fluxOld[ 0 ], fluxOld[ 1 ], fluxOld[ 2 ] );
-          updateLightBuffer = true;
-
-        }
+        editor_.setIlluminator( index, illuminator );
 
       }
 
     } // lights for loop
 
-    if ( updateLightBuffer )
-    {
-
-      optix::Buffer illumBuf = context_[ "illuminators" ]->getBuffer( );
-      illumBuf->destroy( );
-
-      context_[ "illuminators" ]->setBuffer( createInputBuffer( illuminators_ ) );
-
-      resetFrameCount( );
-
-    }
-
   } // collapsing header
 
-} // OptixBasicScene::renderSceneGui
+} // OptixScene::renderSceneGui
 
 
 
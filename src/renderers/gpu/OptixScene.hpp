@@ -10,6 +10,10 @@
 
 #include "optixMod/optix_math_stream_namespace_mod.h"
 #include "commonStructs.h"
+#include "FastMath.hpp"
+#include "SceneDescription.hpp"
+#include "SceneEditor.hpp"
+#include "MemoryAccounting.hpp"
 
 
 namespace light
@@ -31,6 +35,8 @@ struct ShapeGroup
     optix::Matrix4x4::identity( )
   };
 
+  optix::Transform transformNode; // set once attached to the top group
+
   std::string builderAccel
   {
     "NoAccel"
@@ -78,11 +84,20 @@ public:
 
   ///////////////////////////////////////////////////////////////
   /// \brief setDisplayType
-  /// \param type
+  /// \param type 0 normals, 1 simple shading, 2 bsdf, 3 simple
+  ///        shading drawn as a traversal cost heatmap
   ///////////////////////////////////////////////////////////////
   void setDisplayType ( int type );
 
 
+  ///////////////////////////////////////////////////////////////
+  /// \brief setTraversalCostScale
+  /// \param scale primitive tests per sample shown as red by the
+  ///        traversal cost display
+  ///////////////////////////////////////////////////////////////
+  void setTraversalCostScale ( float scale );
+
+
   ///////////////////////////////////////////////////////////////
   /// \brief setMaxBounces
   /// \param bounces
@@ -97,6 +112,22 @@ public:
   void setFirstBounce ( unsigned bounce );
 
 
+  ///////////////////////////////////////////////////////////////
+  /// \brief setMathPrecision
+  /// \param precision MATH_FAST approximates exp, pow, acos and
+  ///        normalize in the bsdf programs for previews;
+  ///        MATH_PRECISE, the default, is for final renders
+  ///////////////////////////////////////////////////////////////
+  void setMathPrecision ( MathPrecision precision );
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief getSceneHash
+  /// \return hash of the scene contents and render settings
+  ///////////////////////////////////////////////////////////////
+  std::uint64_t getSceneHash ( ) override;
+
+
   ///////////////////////////////////////////////////////////////
   /// \brief createBoxPrimitive
   /// \param min
@@ -135,6 +166,18 @@ public:
                                        );
 
 
+  ///////////////////////////////////////////////////////////////
+  /// \brief createMeshPrimitive
+  /// \param scene description holding the mesh data
+  /// \param mesh index of the mesh in 'scene'
+  /// \return
+  ///////////////////////////////////////////////////////////////
+  optix::Geometry createMeshPrimitive (
+                                       const SceneDescription &scene,
+                                       std::uint32_t           mesh
+                                       );
+
+
   ///////////////////////////////////////////////////////////////
   /// \brief createMaterial
   /// \param closestHitProgram
@@ -284,8 +327,46 @@ public:
   void renderSceneGui ( );
 
 
+  ///////////////////////////////////////////////////////////////
+  /// \brief getSceneDescription
+  /// \return backend independent description the scene was compiled from
+  ///////////////////////////////////////////////////////////////
+  const SceneDescription &getSceneDescription ( ) const { return description_; }
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief getSceneEditor
+  /// \return editor for the description; edits take effect at the
+  ///         next applySceneChanges
+  ///////////////////////////////////////////////////////////////
+  SceneEditor &getSceneEditor ( ) { return editor_; }
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief applySceneChanges
+  ///
+  ///        Patches only the materials, lights and transforms
+  ///        edited since the last call. Moved shapes refit the
+  ///        top level acceleration instead of rebuilding it.
+  ///        Call once per frame before rendering.
+  /// \return true if anything changed (the frame count is reset)
+  ///////////////////////////////////////////////////////////////
+  bool applySceneChanges ( );
+
+
 protected:
 
+  ///////////////////////////////////////////////////////////////
+  /// \brief compileScene
+  ///
+  ///        Builds OptiX geometry, materials, shape groups and
+  ///        the top level group from 'scene'. Primitives and
+  ///        materials shared in the description are shared in
+  ///        the context.
+  ///////////////////////////////////////////////////////////////
+  void compileScene ( const SceneDescription &scene );
+
+
   optix::Material sceneMaterial_;
 
   std::vector< std::string > materialNames_;
@@ -294,9 +375,24 @@ protected:
   std::unordered_map< std::string, ShapeGroup > shapes_;
   std::vector< Illuminator > illuminators_;
 
+  SceneDescription description_;
+  SceneEditor      editor_;
+
+  // compiled state indexed like the description's records
+  std::vector< optix::Material >              materials_;
+  std::vector< std::vector< std::string > >   transformShapes_; // shapes using each transform
+  optix::Buffer                               illuminatorBuffer_;
+  optix::Acceleration                         topAcceleration_;
+
 
 private:
 
+  int   displayType_;
+  float costScale_;
+
+  TrackedMemory geometryMemory_;
+  TrackedMemory accelerationMemory_;
+
 };
 
 
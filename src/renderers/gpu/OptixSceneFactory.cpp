@@ -0,0 +1,88 @@
+#include "OptixSceneFactory.hpp"
+#include <stdexcept>
+#include "LightBenderConfig.hpp"
+#include "OptixBasicScene.hpp"
+#include "OptixAdvancedScene.hpp"
+#include "OptixModelScene.hpp"
+#include "OptixFileScene.hpp"
+#include "OptixStressScene.hpp"
+#include "Trace.hpp"
+
+
+namespace light
+{
+
+
+///////////////////////////////////////////////////////////////
+/// \brief createOptixScene
+///////////////////////////////////////////////////////////////
+std::unique_ptr< OptixScene >
+createOptixScene(
+                 int                sceneType,
+                 int                width,
+                 int                height,
+                 unsigned           vbo,
+                 const std::string &modelFile
+                 )
+{
+
+  LIGHT_TRACE_SCOPE( "createScene", "scene" );
+
+  switch ( sceneType )
+  {
+
+  case 0:
+
+    return std::unique_ptr< OptixScene >( new OptixBasicScene( width, height, vbo ) );
+
+
+  case 1:
+
+    return std::unique_ptr< OptixScene >( new OptixAdvancedScene( width, height, vbo ) );
+
+
+  case 2:
+
+    return std::unique_ptr< OptixScene >( new OptixModelScene(
+                                                              width,
+                                                              height,
+                                                              vbo,
+                                                              modelFile.empty( ) ? getDefaultModelFile( ) : modelFile
+                                                              ) );
+
+
+  case 3:
+
+    return std::unique_ptr< OptixScene >( new OptixFileScene( width, height, vbo, modelFile ) );
+
+
+  case 4:
+
+    return std::unique_ptr< OptixScene >( new OptixStressScene( width, height, vbo, modelFile ) );
+
+
+  default:
+
+    throw std::runtime_error( "Unknown scene" );
+
+  } // switch
+
+} // createOptixScene
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief getDefaultModelFile
+///////////////////////////////////////////////////////////////
+std::string
+getDefaultModelFile( )
+{
+
+  return light::MODEL_PATH + "tie_interceptor/obj_format/tie_interceptor.obj";
+//  return light::MODEL_PATH + "x_wing/x-wing.obj";
+
+}
+
+
+
+} // namespace light
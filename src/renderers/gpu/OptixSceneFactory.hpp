@@ -0,0 +1,46 @@
+#ifndef OptixSceneFactory_hpp
+#define OptixSceneFactory_hpp
+
+
+#include <memory>
+#include <string>
+
+
+namespace light
+{
+
+
+class OptixScene;
+
+
+///////////////////////////////////////////////////////////////
+/// \brief createOptixScene
+/// \param sceneType 0 - basic, 1 - advanced, 2 - model, 3 - scene file,
+///        4 - generated stress scene
+/// \param width
+/// \param height
+/// \param vbo OpenGL buffer to render into, 0 for headless rendering
+/// \param modelFile mesh loaded by the model scene, the scene
+///        description loaded by the file scene or the options of
+///        the stress scene ("spheres=1000,seed=2")
+///////////////////////////////////////////////////////////////
+std::unique_ptr< OptixScene > createOptixScene (
+                                                int                sceneType,
+                                                int                width,
+                                                int                height,
+                                                unsigned           vbo,
+                                                const std::string &modelFile
+                                                );
+
+
+///////////////////////////////////////////////////////////////
+/// \brief getDefaultModelFile
+/// \return mesh used by the model scene when none is given
+///////////////////////////////////////////////////////////////
+std::string getDefaultModelFile ( );
+
+
+} // namespace light
+
+
+#endif // OptixSceneFactory_hpp
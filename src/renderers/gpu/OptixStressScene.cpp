@@ -0,0 +1,37 @@
+#include "OptixStressScene.hpp"
+#include "StressScene.hpp"
+
+
+namespace light
+{
+
+
+///////////////////////////////////////////////////////////////
+/// \brief OptixStressScene::OptixStressScene
+///////////////////////////////////////////////////////////////
+OptixStressScene::OptixStressScene(
+                                   int                width,
+                                   int                height,
+                                   unsigned           vbo,
+                                   const std::string &spec
+                                   )
+  : OptixScene( width, height, vbo )
+{
+
+  compileScene( buildStressScene( parseStressSceneOptions( spec ) ) );
+
+  compileContext( );
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief OptixStressScene::~OptixStressScene
+///////////////////////////////////////////////////////////////
+OptixStressScene::~OptixStressScene( )
+{}
+
+
+
+} // namespace light
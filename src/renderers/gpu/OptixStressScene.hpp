@@ -0,0 +1,47 @@
+#ifndef OptixStressScene_hpp
+#define OptixStressScene_hpp
+
+
+#include "OptixScene.hpp"
+
+
+namespace light
+{
+
+
+/////////////////////////////////////////////
+/// \brief The OptixStressScene class
+///
+///        Scene compiled from buildStressScene
+/////////////////////////////////////////////
+class OptixStressScene : public OptixScene
+{
+
+public:
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief OptixStressScene
+  /// \param spec options for parseStressSceneOptions
+  ///////////////////////////////////////////////////////////////
+  OptixStressScene(
+                   int                width,
+                   int                height,
+                   unsigned           vbo,
+                   const std::string &spec
+                   );
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief ~OptixStressScene
+  ///////////////////////////////////////////////////////////////
+  virtual
+  ~OptixStressScene( );
+
+
+};
+
+
+} // namespace light
+
+
+#endif // OptixStressScene_hpp
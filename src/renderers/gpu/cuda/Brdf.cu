@@ -1,42 +1,17 @@
 #include <optix.h>
 #include <optixu/optixu_math_stream_namespace.h>
 #include "commonStructs.h"
+#include "PathStatistics.hpp"
+#include "FastMath.hpp"
+#include "Sampling.hpp"
+#include "Microfacet.hpp"
+#include "Bsdf.hpp"
+#include "Roulette.hpp"
 #include "random.h"
 #include "RendererObjects.hpp" // should be last to avoid FLT_MAX redefintion warning
 
 
 
-//////////////////////////////////////////////////////////////
-/// \brief createONB
-///
-///        Create Orthonormal Basis from normalized vector
-//////////////////////////////////////////////////////////////
-static
-__device__ __inline__
-void
-createONB(
-          const float3 &n, ///< normal
-          float3       &U, ///< output U vector
-          float3       &V  ///< output V vector
-          )
-{
-
-  U = cross( n, make_float3( 0.0f, 1.0f, 0.0f ) );
-
-  if ( dot( U, U ) < 1.e-3f )
-  {
-
-    U = cross( n, make_float3( 1.0f, 0.0f, 0.0f ) );
-
-  }
-
-  U = normalize( U );
-  V = cross( n, U );
-
-}
-
-
-
 //////////////////////////////////////////////////////////////
 /// \brief sampleLight
 ///
@@ -55,16 +30,10 @@ sampleIlluminator(
                   )
 {
 
-  float theta = rnd( seed ) * 2 * M_PIf;
-  float u     = rnd( seed ) * 2.0 - 1.0;
-
-  float xyCoeff = sqrt( 1.0 - u * u );
+  float z1 = rnd( seed );
+  float z2 = rnd( seed );
 
-  float3 samplePos = make_float3(
-                                 xyCoeff * cos( theta ),
-                                 xyCoeff * sin( theta ),
-                                 u
-                                 );
+  float3 samplePos = sampleUniformSphere< float3 >( z1, z2 );
 
   // sample on hemisphere in direction of point
   if ( dot( samplePos, normalize( surfel.point - illuminator.center ) ) < 0.0f )
@@ -84,44 +53,34 @@ sampleIlluminator(
 
 
 
+//////////////////////////////////////////////////////////////
+/// \brief calculateSpecular
+///
+///        GGX reflection with height correlated Smith masking
+///        and Fresnel at the half vector, the lobe the reflect
+///        branch samples
+//////////////////////////////////////////////////////////////
 static
 __device__ __inline__
 float3
 calculateSpecular(
                   const float3         &V,
                   const float3         &L,
-                  const float3         &F,
-                  const SurfaceElement &surfel
+                  const SurfaceElement &surfel,
+                  MathPrecision         precision
                   )
 {
 
-  // roughness -> 'm' in cook-torrance lingo
-  float m = surfel.material.roughness;
+  float alpha = ggxAlpha( surfel.material.roughness );
 
-  float3 H = normalize( V + L );
+  float3 H = mathNormalize( V + L, precision );
 
   float cosNV = dot( surfel.normal, V );
   float cosNH = dot( surfel.normal, H );
   float cosNL = dot( surfel.normal, L );
   float cosVH = dot( V, H );
 
-  // geometric attenuation
-  float G = min( 1.0f, min( 2.0f * cosNH * cosNV / cosVH, 2.0f * cosNH * cosNL / cosVH ) );
-
-  // microfacet slope distribution
-  float cosNHPow2 = cosNH * cosNH;
-  float mPo2      = m * m;
-
-  float D = ( 1.0 / ( M_PIf * mPo2 * cosNHPow2 * cosNHPow2 ) )
-            * exp( ( cosNHPow2 - 1.0 ) / ( mPo2 * cosNHPow2 ) );
-
-  // return mat.albedo * ( F * D * G ) / ( PI * cosNL * cosNV );
-  // return mat.albedo * F;
-  float3 specular = surfel.material.albedo * ( F * D * G ) / ( M_PIf * cosNL * cosNV );
-
-  float3 diffuse = surfel.material.albedo * ( 1.0 - F ) / M_PIf;
-
-  return diffuse + specular;
+  return dielectricFresnel( cosVH, surfel.material.IOR ) * ggxReflection( cosNV, cosNL, cosNH, alpha );
 
 } // calculateSpecular
 
@@ -140,11 +99,70 @@ rtDeclareVariable( float,                t_hit,            rtIntersectionDistanc
 rtDeclareVariable( unsigned int,         shadow_ray_type,  , );
 rtDeclareVariable( float,                scene_epsilon,    , );
 rtDeclareVariable( rtObject,             top_shadower,     , );
+rtDeclareVariable( unsigned int,         math_precision,   , ); // MathPrecision
+rtDeclareVariable( unsigned int,         roulette_policy,     , ); // RoulettePolicy
+rtDeclareVariable( unsigned int,         roulette_min_depth,  , );
+rtDeclareVariable( unsigned int,         first_bounce_splits, , );
 
 rtBuffer< Illuminator > illuminators;
 
 
 
+/////////////////////////////////////////////////////////
+/// \brief playRoulette
+///
+///        Ends the path that just picked its next direction or
+///        scales up its throughput to make up for the paths
+///        that were ended
+/////////////////////////////////////////////////////////
+static
+__device__ __inline__
+void
+playRoulette( RoulettePolicy policy )
+{
+
+  float3 &attenuation = prd_current.attenuation;
+
+  float throughput = fmaxf( attenuation.x, fmaxf( attenuation.y, attenuation.z ) );
+
+  // every path past the first hit is one of the first bounce
+  // splits, compare it to the path it was split from
+  if ( prd_current.depth > 0 )
+  {
+    throughput *= first_bounce_splits;
+  }
+
+  float survival = survivalProbability(
+                                       policy,
+                                       throughput,
+                                       prd_current.rouletteScale,
+                                       prd_current.depth,
+                                       static_cast< int >( roulette_min_depth )
+                                       );
+
+  if ( survival >= 1.0f )
+  {
+    return;
+  }
+
+  if ( rnd( prd_current.seed ) < survival )
+  {
+
+    attenuation /= survival;
+
+  }
+  else
+  {
+
+    prd_current.done       = true;
+    prd_current.terminated = PATH_STATS_ABSORBED;
+
+  }
+
+} // playRoulette
+
+
+
 /////////////////////////////////////////////////////////
 /// \brief closest_hit_normals
 ///
@@ -192,7 +210,10 @@ closest_hit_simple_shading( )
   float3 w_i;
   float distToLightPow2, distToLight;
 
-  for ( int i = 0; i < illuminators.size( ); ++i )
+  // split branches re-enter the first hit only for another bounce
+  int lightCount = prd_current.splitBranch ? 0 : static_cast< int >( illuminators.size( ) );
+
+  for ( int i = 0; i < lightCount; ++i )
   {
 
     Illuminator &illuminator = illuminators[ i ];
@@ -263,6 +284,13 @@ closest_hit_simple_shading( )
       // shoot ray into scene
       rtTrace( top_shadower, shadow_ray, shadow_prd );
 
+      ++prd_current.shadowRays;
+
+      if ( dot( shadow_prd.attenuation, shadow_prd.attenuation ) == 0.0f )
+      {
+        ++prd_current.shadowOccluded;
+      }
+
 
       radiance += ( simpleShadeAlbedo / M_PIf ) // lambertian pi normalization
                   * ( flux / totalDistPow2 )    // inverse square law
@@ -281,10 +309,24 @@ closest_hit_simple_shading( )
   if ( prd_current.seed != static_cast< unsigned >( -1 ) )
   {
 
+    RoulettePolicy policy = static_cast< RoulettePolicy >( roulette_policy );
+
     float scatterProb = ( simpleShadeAlbedo.x + simpleShadeAlbedo.y + simpleShadeAlbedo.z ) / 3;
 
+    if ( policy != ROULETTE_ALBEDO )
+    {
+      scatterProb = 1.0f; // playRoulette decides when to stop
+    }
+
     float rouletteVal = rnd( prd_current.seed );
 
+    // first bounce splits share the first hit's absorption, so a
+    // split branch only ever scatters
+    if ( prd_current.splitBranch )
+    {
+      rouletteVal *= fminf( scatterProb, 1.0f );
+    }
+
     //
     // scatter
     //
@@ -293,21 +335,18 @@ closest_hit_simple_shading( )
     if ( rouletteVal <= 0.0f )
     {
 
-      prd_current.origin = surfel.point;
+      prd_current.bounced = true;
+      prd_current.origin  = surfel.point;
 
       float z1 = rnd( prd_current.seed );
       float z2 = rnd( prd_current.seed );
-      float3 p;
-
-      optix::cosine_sample_hemisphere( z1, z2, p );
 
-      float3 v1, v2;
-      createONB( surfel.normal, v1, v2 );
-
-      prd_current.direction    = v1 * p.x + v2 * p.y + surfel.normal * p.z;
+      prd_current.direction    = alignToNormal( sampleCosineHemisphere< float3 >( z1, z2 ), surfel.normal );
       prd_current.attenuation *= simpleShadeAlbedo / scatterProb;
       prd_current.countEmitted = false;
 
+      playRoulette( policy );
+
       prd_current.radiance = radiance;
       return;
 
@@ -316,7 +355,8 @@ closest_hit_simple_shading( )
     //
     // absorb
     //
-    prd_current.done = true;
+    prd_current.done       = true;
+    prd_current.terminated = PATH_STATS_ABSORBED;
 
   }
 
@@ -351,8 +391,10 @@ closest_hit_bsdf( )
   surfel.material.roughness = roughness;
   surfel.material.IOR       = ior;
 
-  float3 worldGeoNormal   = normalize( rtTransformNormal( RT_OBJECT_TO_WORLD, geometric_normal ) );
-  float3 worldShadeNormal = normalize( rtTransformNormal( RT_OBJECT_TO_WORLD, shading_normal ) );
+  MathPrecision precision = static_cast< MathPrecision >( math_precision );
+
+  float3 worldGeoNormal   = mathNormalize( rtTransformNormal( RT_OBJECT_TO_WORLD, geometric_normal ), precision );
+  float3 worldShadeNormal = mathNormalize( rtTransformNormal( RT_OBJECT_TO_WORLD, shading_normal ), precision );
 
   surfel.normal = faceforward( worldShadeNormal, -ray.direction, worldGeoNormal );
 
@@ -367,24 +409,9 @@ closest_hit_bsdf( )
   //
   // fresnel calculation for current surface
   //
-  float3 currentIOR = make_float3( 1.0 ); // air (no transmission yet)
-
   float cosNV = dot( surfel.normal, w_v );
 
-  float3 eta = currentIOR / surfel.material.IOR;
-  float3 cosT;
-
-  // individual fresnel calc for each RGB wavelength
-  float3 T = refract( -w_v, surfel.normal, eta.x );
-  cosT.x = dot( -surfel.normal, T );
-
-  T      = refract( -w_v, surfel.normal, eta.y );
-  cosT.y = dot( -surfel.normal, T );
-
-  T      = refract( -w_v, surfel.normal, eta.z );
-  cosT.z = dot( -surfel.normal, T );
-
-  float3 F = fresnel( make_float3( cosNV ), cosT, currentIOR, surfel.material.IOR );
+  float3 F = dielectricFresnel( cosNV, surfel.material.IOR );
 
 
 
@@ -392,7 +419,11 @@ closest_hit_bsdf( )
   float3 w_l; // light vector
   float distToLightPow2, distToLight;
 
-  for ( int i = 0; i < illuminators.size( ); ++i )
+  // split branches re-enter the first hit only for another bounce,
+  // its light was sampled by the first branch
+  int lightCount = prd_current.splitBranch ? 0 : static_cast< int >( illuminators.size( ) );
+
+  for ( int i = 0; i < lightCount; ++i )
   {
 
     Illuminator &illuminator = illuminators[ i ];
@@ -422,7 +453,7 @@ closest_hit_bsdf( )
 
       // lambertian emitter
       ///\todo: Sample by sollid angle for quicker convergance
-      flux *= 0.5f * max( 0.0, dot( -w_l, normalize( lightPos - illuminator.center ) ) );
+      flux *= 0.5f * max( 0.0, dot( -w_l, mathNormalize( lightPos - illuminator.center, precision ) ) );
 
     }
     else
@@ -465,6 +496,13 @@ closest_hit_bsdf( )
       // shoot ray into scene
       rtTrace( top_shadower, shadow_ray, shadow_prd );
 
+      ++prd_current.shadowRays;
+
+      if ( dot( shadow_prd.attenuation, shadow_prd.attenuation ) == 0.0f )
+      {
+        ++prd_current.shadowOccluded;
+      }
+
 
       // bsdf calculation added below
       localRadiance = ( flux / totalDistPow2 )  // incident radiance
@@ -481,37 +519,27 @@ closest_hit_bsdf( )
         //
 
         //
-        // cook-torrance specular
+        // ggx specular
         //
         float3 specular = make_float3( 0.0f );
 
         if ( prd_current.useSpecular )
         {
 
-          specular = calculateSpecular( w_v, w_l, F, surfel );
+          specular = calculateSpecular( w_v, w_l, surfel, precision );
 
         }
 
         //
         // oren nayar diffuse brdf
         //
-        float gammaPow2 = surfel.material.roughness * surfel.material.roughness;
-
-        float nDotL = optix::dot( surfel.normal, w_l );
-        float nDotV = optix::dot( surfel.normal, w_v );
-
-        float s = optix::dot( w_l, w_v ) - nDotL * nDotV;
-
-        float t = s <= 0.0f ? 1.0f : max( nDotL, nDotV );
-
-        float3 A = ( 1.0
-                    - 0.5  * ( gammaPow2 / ( gammaPow2 + 0.33 ) )
-                    + 0.17 * ( gammaPow2 / ( gammaPow2 + 0.13 ) ) * surfel.material.albedo
-                    ) / M_PIf;
-
-        float B = 0.45f * ( gammaPow2 / ( gammaPow2 + 0.09f ) ) / M_PIf;
-
-        float3 diffuse = surfel.material.albedo * ( A + B * s / t );
+        float3 diffuse = orenNayarDiffuse(
+                                          surfel.material.albedo,
+                                          surfel.material.roughness,
+                                          optix::dot( surfel.normal, w_l ),
+                                          optix::dot( surfel.normal, w_v ),
+                                          optix::dot( w_l, w_v )
+                                          );
 
         radiance += localRadiance * ( diffuse * ( 1.0f - F ) + specular );
 
@@ -528,16 +556,33 @@ closest_hit_bsdf( )
   if ( prd_current.seed != static_cast< unsigned >( -1 ) )
   {
 
-    float reflectProb = ( F.x + F.y + F.z ) / 3;
+    RoulettePolicy policy = static_cast< RoulettePolicy >( roulette_policy );
+
+    float3 diffuseWeight = albedo * ( 1.0f - F ); // as in the light samples above
 
-    float scatterProb = ( albedo.x + albedo.y + albedo.z ) / 3;
-//    scatterProb *= 1.0 - reflectProb;
+    float scatterProb;
+    float reflectProb;
+
+    lobeProbabilities(
+                      policy,
+                      ( diffuseWeight.x + diffuseWeight.y + diffuseWeight.z ) / 3,
+                      ( F.x + F.y + F.z ) / 3,
+                      scatterProb,
+                      reflectProb
+                      );
 
     //
     // russian roulette based on scattering probabilities
     //
     float rouletteVal = rnd( prd_current.seed );
 
+    // first bounce splits share the first hit's absorption, so a
+    // split branch only picks between the lobes
+    if ( prd_current.splitBranch )
+    {
+      rouletteVal *= fminf( scatterProb + reflectProb, 1.0f );
+    }
+
     //
     // diffuse scatter
     //
@@ -546,22 +591,19 @@ closest_hit_bsdf( )
     if ( rouletteVal <= 0.0f )
     {
 
-      prd_current.origin = surfel.point;
+      prd_current.bounced = true;
+      prd_current.origin  = surfel.point;
 
       float z1 = rnd( prd_current.seed );
       float z2 = rnd( prd_current.seed );
-      float3 p;
 
-      optix::cosine_sample_hemisphere( z1, z2, p );
-
-      float3 v1, v2;
-      createONB( surfel.normal, v1, v2 );
-
-      prd_current.direction    = v1 * p.x + v2 * p.y + surfel.normal * p.z;
-      prd_current.attenuation *= albedo / scatterProb;  // use the albedo as the diffuse response
+      prd_current.direction    = alignToNormal( sampleCosineHemisphere< float3 >( z1, z2 ), surfel.normal );
+      prd_current.attenuation *= diffuseWeight / scatterProb;
       prd_current.countEmitted = false;
       prd_current.useSpecular  = false;
 
+      playRoulette( policy );
+
       prd_current.radiance = radiance;
       return;
 
@@ -576,33 +618,47 @@ closest_hit_bsdf( )
     if ( rouletteVal <= 0.0f )
     {
 
+      prd_current.bounced = true;
+
       //
-      // sample from raised cosine distribution
+      // sample the ggx lobe by its visible normals in the
+      // normal's frame
       //
       float z1 = rnd( prd_current.seed );
       float z2 = rnd( prd_current.seed );
-      float3 p;
 
-      optix::cosine_sample_hemisphere( z1, z2, p );
+      float alpha = ggxAlpha( surfel.material.roughness );
+
+      float3 b1, b2;
+      orthonormalBasis( surfel.normal, b1, b2 );
+
+      float3 v = make_float3( dot( w_v, b1 ), dot( w_v, b2 ), fmaxf( dot( w_v, surfel.normal ), 1.0e-4f ) );
+      float3 h = sampleGgxVndf( v, alpha, z1, z2 );
 
-      float scaling = roughness;
+      float cosVH = dot( v, h );
+      float3 l    = 2.0f * cosVH * h - v;
 
-      p.x *= scaling;
-      p.y *= scaling;
+      if ( l.z <= 0.0f )
+      {
 
-      p.z /= scaling;
+        // reflected under the surface, lost to single scattering
+        prd_current.done       = true;
+        prd_current.terminated = PATH_STATS_ABSORBED;
 
-      p = normalize( p );
+        prd_current.radiance = radiance;
+        return;
 
-      float3 v1, v2;
-      float3 R = reflect( -w_v, surfel.normal );
-      createONB( R, v1, v2 );
+      }
 
       prd_current.origin       = surfel.point;
-      prd_current.direction    =  v1 * p.x + v2 * p.y + R * p.z;
-      prd_current.attenuation *= F / reflectProb;
+      prd_current.direction    = b1 * l.x + b2 * l.y + surfel.normal * l.z;
+      prd_current.attenuation *= dielectricFresnel( cosVH, surfel.material.IOR )
+                                 * ggxReflectionWeight( v.z, l.z, alpha )
+                                 / reflectProb;
 //      prd_current.countEmitted = true;
 
+      playRoulette( policy );
+
       prd_current.radiance = radiance;
       return;
 
@@ -612,7 +668,8 @@ closest_hit_bsdf( )
     //
     // absorb
     //
-    prd_current.done = true;
+    prd_current.done       = true;
+    prd_current.terminated = PATH_STATS_ABSORBED;
 
   }
 
@@ -631,7 +688,8 @@ closest_hit_emission( )
 
   prd_current.radiance = prd_current.countEmitted ? emissionRadiance : make_float3( 0.f );
 //  prd_current.radiance = emissionRadiance * prd_current.attenuation;
-  prd_current.done = true;
+  prd_current.done       = true;
+  prd_current.terminated = PATH_STATS_EMITTED;
 
 }
 
@@ -2,6 +2,8 @@
 #include "RendererObjects.hpp"
 #include "path_tracer.h"
 #include "random.h"
+#include "PathStatistics.hpp"
+#include "Roulette.hpp"
 
 
 
@@ -9,8 +11,11 @@ rtDeclareVariable( PerRayData_pathtrace, prd_current,       rtPayload, );
 
 rtDeclareVariable( optix::Ray,           ray,               rtCurrentRay,  );
 rtDeclareVariable( uint2,                launch_index,      rtLaunchIndex, );
+rtDeclareVariable( uint2,                launch_dim,        rtLaunchDim,   );
+rtDeclareVariable( uint2,                launch_offset,     , ); // launches may cover a sub-region of the image
 
 rtDeclareVariable( unsigned int,         frame_number,      , );
+rtDeclareVariable( unsigned int,         frame_offset,      , );
 rtDeclareVariable( unsigned int,         sqrt_num_samples,  , );
 
 rtDeclareVariable( unsigned int,         radiance_ray_type, , );
@@ -19,7 +24,13 @@ rtDeclareVariable( rtObject,             top_object,        , );
 
 rtDeclareVariable( unsigned int,         max_bounces,       , );
 rtDeclareVariable( unsigned int,         first_bounce,      , );
+rtDeclareVariable( unsigned int,         first_bounce_splits, , );
+rtDeclareVariable( unsigned int,         roulette_policy,   , ); // RoulettePolicy
 rtDeclareVariable( unsigned int,         globalSeed,        , );
+rtDeclareVariable( unsigned int,         bounce_layers,     , );
+rtDeclareVariable( unsigned int,         path_stats,        , );
+rtDeclareVariable( unsigned int,         traversal_cost,    , );
+rtDeclareVariable( float,                cost_scale,        , ); // tests per sample shown as red
 
 
 //
@@ -32,6 +43,238 @@ rtDeclareVariable( float3, W,   , );
 
 rtBuffer< float4, 2 >        output_buffer;
 
+// per-bounce accumulation layers (only written when bounce_layers is set)
+rtBuffer< float4, 2 >        direct_buffer;
+rtBuffer< float4, 2 >        indirect_buffer;
+
+// PATH_STATS_SLOTS * PATH_STATS_FIELDS counters (only written when path_stats is set)
+rtBuffer< unsigned long long > path_stats_buffer;
+
+// primitive tests of radiance (x) and shadow (y) rays, see traversal_cost.h
+rtBuffer< uint2, 2 >         traversal_cost_buffer;
+
+// running mean of each frame's pixel luminance and its square
+// (only written for ROULETTE_EFFICIENCY)
+rtBuffer< float2, 2 >        roulette_buffer;
+
+
+
+/////////////////////////////////////////////////////////
+/// \brief accumulate
+///
+///        Blends the radiance from the current frame
+///        into the running average stored in 'old'
+/////////////////////////////////////////////////////////
+static
+__device__ __inline__
+float4
+accumulate(
+           const float4 &old,     ///< previously accumulated value
+           const float3 &radiance ///< radiance from the current frame
+           )
+{
+
+  if ( frame_number > 1 )
+  {
+
+    float a            = 1.0f / static_cast< float >( frame_number );
+    float b            = ( static_cast< float >( frame_number ) - 1.0f ) * a;
+    float3 oldRadiance = make_float3( old );
+    return make_float4( a * radiance + b * oldRadiance, 1.0f );
+
+  }
+
+  return make_float4( radiance, 1.0f );
+
+} // accumulate
+
+
+
+/////////////////////////////////////////////////////////
+/// \brief writeFrame
+///
+///        Accumulates the full image and, if requested,
+///        the direct and indirect bounce layers
+/////////////////////////////////////////////////////////
+static
+__device__ __inline__
+void
+writeFrame(
+           const float3 &totalRadiance,
+           const float3 &directRadiance,
+           const float3 &indirectRadiance
+           )
+{
+
+  const uint2 pixel = launch_index + launch_offset;
+
+  output_buffer[ pixel ] = accumulate( output_buffer[ pixel ], totalRadiance );
+
+  if ( bounce_layers )
+  {
+
+    direct_buffer  [ pixel ] = accumulate( direct_buffer  [ pixel ], directRadiance   );
+    indirect_buffer[ pixel ] = accumulate( indirect_buffer[ pixel ], indirectRadiance );
+
+  }
+
+  if ( roulette_policy == ROULETTE_EFFICIENCY )
+  {
+
+    float  luminance = ( totalRadiance.x + totalRadiance.y + totalRadiance.z ) * ( 1.0f / 3.0f );
+    float2 moments   = roulette_buffer[ pixel ];
+
+    accumulateRouletteMoments( moments.x, moments.y, luminance, frame_number );
+
+    roulette_buffer[ pixel ] = moments;
+
+  }
+
+} // writeFrame
+
+
+
+/////////////////////////////////////////////////////////
+/// \brief getRouletteScale
+///
+///        rouletteEfficiencyScale of the pixel from the
+///        frames it accumulated so far
+/////////////////////////////////////////////////////////
+static
+__device__ __inline__
+float
+getRouletteScale( )
+{
+
+  if ( roulette_policy != ROULETTE_EFFICIENCY )
+  {
+    return 1.0f;
+  }
+
+  float2 moments = roulette_buffer[ launch_index + launch_offset ];
+
+  return rouletteMomentScale( moments.x, moments.y, frame_number - 1, sqrt_num_samples * sqrt_num_samples );
+
+} // getRouletteScale
+
+
+/////////////////////////////////////////////////////////
+/// \brief The PathCounters struct
+///
+///        Statistics one launch index gathers over its
+///        samples before adding them to the shared buffer
+/////////////////////////////////////////////////////////
+struct PathCounters
+{
+  unsigned           ended[ 4 ]; // indexed by reason - PATH_STATS_ABSORBED
+  unsigned long long throughput;
+  unsigned           shadowRays;
+  unsigned           shadowOccluded;
+};
+
+
+
+static
+__device__ __inline__
+unsigned long long*
+getPathStatsSlot( )
+{
+
+  unsigned slot = ( launch_index.y * launch_dim.x + launch_index.x ) % PATH_STATS_SLOTS;
+
+  return &path_stats_buffer[ slot * PATH_STATS_FIELDS ];
+
+}
+
+
+
+/////////////////////////////////////////////////////////
+/// \brief countPath
+///
+///        Records how a finished path ended. Only the
+///        length histogram goes straight to the buffer.
+/////////////////////////////////////////////////////////
+static
+__device__ __inline__
+void
+countPath(
+          const PerRayData_pathtrace &prd,
+          PathCounters               &counters
+          )
+{
+
+  // a path that was still going when the loop stopped hit max_bounces
+  int reason = prd.done ? prd.terminated : PATH_STATS_MAX_BOUNCES;
+
+  ++counters.ended[ reason - PATH_STATS_ABSORBED ];
+
+  float throughput = ( prd.attenuation.x + prd.attenuation.y + prd.attenuation.z ) * ( 1.0f / 3.0f );
+
+  counters.throughput     += static_cast< unsigned long long >( throughput * PATH_STATS_FIXED_ONE );
+  counters.shadowRays     += prd.shadowRays;
+  counters.shadowOccluded += prd.shadowOccluded;
+
+  atomicAdd( getPathStatsSlot( ) + min( prd.depth, PATH_STATS_MAX_LENGTH - 1 ), 1ull );
+
+} // countPath
+
+
+
+static
+__device__ __inline__
+void
+flushPathCounters( const PathCounters &counters )
+{
+
+  unsigned long long *pSlot = getPathStatsSlot( );
+
+  for ( int i = 0; i < 4; ++i )
+  {
+
+    if ( counters.ended[ i ] )
+    {
+      atomicAdd( pSlot + PATH_STATS_ABSORBED + i, static_cast< unsigned long long >( counters.ended[ i ] ) );
+    }
+
+  }
+
+  atomicAdd( pSlot + PATH_STATS_THROUGHPUT,      counters.throughput );
+  atomicAdd( pSlot + PATH_STATS_SHADOW_RAYS,     static_cast< unsigned long long >( counters.shadowRays ) );
+  atomicAdd( pSlot + PATH_STATS_SHADOW_OCCLUDED, static_cast< unsigned long long >( counters.shadowOccluded ) );
+
+} // flushPathCounters
+
+
+
+/////////////////////////////////////////////////////////
+/// \brief traversalCostColor
+///
+///        Blue through green to red as the primitive tests
+///        per sample approach cost_scale
+/////////////////////////////////////////////////////////
+static
+__device__ __inline__
+float3
+traversalCostColor(
+                   uint2    cost,
+                   unsigned samples
+                   )
+{
+
+  float tests = static_cast< float >( cost.x + cost.y ) / samples;
+  float h     = fminf( tests / cost_scale, 1.0f ) * 4.0f;
+
+  // blue, cyan, green, yellow, red at h = 0, 1, 2, 3, 4
+  return make_float3(
+                     clamp( h - 2.0f, 0.0f, 1.0f ),
+                     fminf( clamp( h, 0.0f, 1.0f ), clamp( 4.0f - h, 0.0f, 1.0f ) ),
+                     clamp( 2.0f - h, 0.0f, 1.0f )
+                     );
+
+} // traversalCostColor
+
+
+
 /////////////////////////////////////////////////////////
 /// \brief pinhole_camera
 /////////////////////////////////////////////////////////
@@ -40,10 +283,12 @@ void
 pinhole_camera( )
 {
 
+  const uint2 pixel = launch_index + launch_offset;
+
   optix::size_t2 screenSize = output_buffer.size( );
 
   float2 inv_screen  = 1.0f / make_float2( screenSize ) * 2.0f;
-  float2 pixelCorner = make_float2( launch_index ) * inv_screen - 1.0f;
+  float2 pixelCorner = make_float2( pixel ) * inv_screen - 1.0f;
 
   float2 jitter_scale = inv_screen / sqrt_num_samples;
 
@@ -55,6 +300,11 @@ pinhole_camera( )
 
   unsigned int samples_per_pixel = sqrt_num_samples * sqrt_num_samples;
 
+  if ( traversal_cost )
+  {
+    traversal_cost_buffer[ pixel ] = make_uint2( 0u );
+  }
+
   // seems faster than two for loops for x and y on gpu
   while ( samples_per_pixel-- )
   {
@@ -79,6 +329,12 @@ pinhole_camera( )
     prd.seed         = static_cast< unsigned >( -1 ); // overflow to max value
     prd.depth        = 0;
     prd.useSpecular  = true;
+    prd.terminated   = PATH_STATS_ABSORBED;
+    prd.shadowRays   = 0;
+    prd.shadowOccluded = 0;
+    prd.rouletteScale  = 1.0f;
+    prd.splitBranch    = false;
+    prd.bounced        = false;
 
     optix::Ray ray(
                    ray_origin,
@@ -95,7 +351,12 @@ pinhole_camera( )
 
   totalRadiance /= sqrt_num_samples * sqrt_num_samples;
 
-  output_buffer[ launch_index ] = make_float4( totalRadiance, 1.0 );
+  if ( traversal_cost )
+  {
+    totalRadiance = traversalCostColor( traversal_cost_buffer[ pixel ], sqrt_num_samples * sqrt_num_samples );
+  }
+
+  output_buffer[ pixel ] = make_float4( totalRadiance, 1.0 );
 
 } // pinhole_camera
 
@@ -109,22 +370,30 @@ void
 pathtrace_pinhole_camera( )
 {
 
+  const uint2 pixel = launch_index + launch_offset;
+
   optix::size_t2 screenSize = output_buffer.size( );
 
   float2 inv_screen  = 1.0f / make_float2( screenSize ) * 2.0f;
-  float2 pixelCorner = make_float2( launch_index ) * inv_screen - 1.0f;
+  float2 pixelCorner = make_float2( pixel ) * inv_screen - 1.0f;
 
   float2 jitter_scale = inv_screen / sqrt_num_samples;
 
-  float3 totalRadiance = make_float3( 0.0f );
+  float3 totalRadiance    = make_float3( 0.0f );
+  float3 directRadiance   = make_float3( 0.0f );
+  float3 indirectRadiance = make_float3( 0.0f );
 
   // loop vars
   unsigned x, y;
   float2 jitter;
 
-  unsigned seed = tea< 16 >( screenSize.x * launch_index.y + launch_index.x, frame_number );
+  unsigned seed = tea< 16 >( screenSize.x * pixel.y + pixel.x, frame_number + frame_offset );
   seed += globalSeed;
 
+  PathCounters counters = { { 0, 0, 0, 0 }, 0ull, 0, 0 };
+
+  float rouletteScale = getRouletteScale( );
+
   unsigned int samples_per_pixel = sqrt_num_samples * sqrt_num_samples;
 
   // seems faster than two for loops for x and y on gpu
@@ -141,81 +410,131 @@ pathtrace_pinhole_camera( )
     float3 ray_origin    = eye;
     float3 ray_direction = normalize( d.x * U + d.y * V + W );
 
-    PerRayData_pathtrace prd;
-    prd.result       = make_float3( 0.f );
-    prd.attenuation  = make_float3( 1.f );
-    prd.radiance     = make_float3( 0.f );
-    prd.countEmitted = true;
-    prd.done         = false;
-    prd.inside       = false;
-    prd.seed         = seed;
-    prd.depth        = 0;
-    prd.useSpecular  = true;
+    unsigned branchSeed = seed;
 
-    for ( ; ; )
+    // a camera that stops at the first hit has no bounce to split
+    unsigned splits = max_bounces > 0 ? first_bounce_splits : 1u;
+
+    // the branches share the camera ray and its first hit; each
+    // takes its own bounce from there
+    for ( unsigned branch = 0; branch < splits; ++branch )
     {
 
-      float3 attenuation = prd.attenuation;
+      PerRayData_pathtrace prd;
+      prd.result       = make_float3( 0.f );
+      prd.attenuation  = make_float3( 1.f );
+      prd.radiance     = make_float3( 0.f );
+      prd.countEmitted = true; // later branches never start on a light, see below
+      prd.done         = false;
+      prd.inside       = false;
+      prd.seed         = branchSeed;
+      prd.depth        = 0;
+      prd.useSpecular  = true;
+      prd.terminated   = PATH_STATS_ABSORBED;
+      prd.shadowRays   = 0;
+      prd.shadowOccluded = 0;
+      prd.rouletteScale  = rouletteScale;
+      prd.splitBranch    = branch > 0;
+      prd.bounced        = false;
+
+      float3 origin    = ray_origin;
+      float3 direction = ray_direction;
+
+      for ( ; ; )
+      {
 
-      optix::Ray ray(
-                     ray_origin,
-                     ray_direction,
-                     radiance_ray_type,
-                     scene_epsilon
-                     );
+        float3 attenuation = prd.attenuation;
 
-      rtTrace( top_object, ray, prd );
+        optix::Ray ray(
+                       origin,
+                       direction,
+                       radiance_ray_type,
+                       scene_epsilon
+                       );
 
+        rtTrace( top_object, ray, prd );
 
-      if ( prd.depth >= max_bounces )
-      {
+        float3 bounceRadiance = prd.radiance * attenuation;
 
-        prd.result += prd.radiance * attenuation;
-        break;
+        bool lastBounce = prd.depth >= max_bounces;
 
-      }
+        // the layers split what the image counts by depth, so they
+        // skip bounces before first_bounce too and always add up
+        // to the image
+        if ( lastBounce || prd.depth >= first_bounce )
+        {
 
-      if ( prd.depth >= first_bounce )
-      {
+          prd.result += bounceRadiance;
 
-        prd.result += prd.radiance * attenuation;
+          if ( prd.depth == 0 )
+          {
 
-      }
+            directRadiance += bounceRadiance;
 
-      if ( prd.done )
-      {
+          }
+          else
+          {
 
-        break;
+            indirectRadiance += bounceRadiance;
 
-      }
+          }
 
-      ++prd.depth;
-      ray_origin    = prd.origin;
-      ray_direction = prd.direction;
+        }
 
-    }
+        if ( lastBounce || prd.done )
+        {
 
-    totalRadiance += prd.result;
+          break;
 
-  }
+        }
 
-  totalRadiance /= sqrt_num_samples * sqrt_num_samples;
+        if ( prd.depth == 0 )
+        {
 
-  if ( frame_number > 1 )
-  {
+          prd.attenuation /= static_cast< float >( splits );
+          prd.splitBranch  = false;
 
-    float a            = 1.0f / static_cast< float >( frame_number );
-    float b            = ( static_cast< float >( frame_number ) - 1.0f ) * a;
-    float3 oldRadiance = make_float3( output_buffer[ launch_index ] );
-    output_buffer[ launch_index ] = make_float4( a * totalRadiance + b * oldRadiance, 1.0f );
+        }
+
+        ++prd.depth;
+        origin    = prd.origin;
+        direction = prd.direction;
+
+      }
+
+      totalRadiance += prd.result;
+      branchSeed     = prd.seed;
+
+      if ( path_stats )
+      {
+        countPath( prd, counters );
+      }
+
+      // the first hit missed, hit a light or absorbed the path
+      // without picking a bounce, so there's nothing to split.
+      // Split branches share that absorption (see closest_hit_bsdf)
+      // to keep the estimate unbiased.
+      if ( !prd.bounced )
+      {
+        break;
+      }
+
+    }
 
   }
-  else
+
+  if ( path_stats )
   {
+    flushPathCounters( counters );
+  }
 
-    output_buffer[ launch_index ] = make_float4( totalRadiance, 1.0f );
+  float invSamples = 1.0f / ( sqrt_num_samples * sqrt_num_samples );
 
-  }
+  totalRadiance    *= invSamples;
+  directRadiance   *= invSamples;
+  indirectRadiance *= invSamples;
+
+  writeFrame( totalRadiance, directRadiance, indirectRadiance );
 
 } // pinhole_camera
 
@@ -229,10 +548,12 @@ void
 orthographic_camera( )
 {
 
+  const uint2 pixel = launch_index + launch_offset;
+
   optix::size_t2 screenSize = output_buffer.size( );
 
   float2 inv_screen  = 1.0f / make_float2( screenSize ) * 2.0f;
-  float2 pixelCorner = make_float2( launch_index ) * inv_screen - 1.0f;
+  float2 pixelCorner = make_float2( pixel ) * inv_screen - 1.0f;
 
   float2 jitter_scale = inv_screen / sqrt_num_samples;
 
@@ -244,6 +565,11 @@ orthographic_camera( )
 
   unsigned int samples_per_pixel = sqrt_num_samples * sqrt_num_samples;
 
+  if ( traversal_cost )
+  {
+    traversal_cost_buffer[ pixel ] = make_uint2( 0u );
+  }
+
   // seems faster than two for loops for x and y on gpu
   while ( samples_per_pixel-- )
   {
@@ -268,6 +594,12 @@ orthographic_camera( )
     prd.seed         = static_cast< unsigned >( -1 ); // overflow to max value
     prd.depth        = 0;
     prd.useSpecular  = true;
+    prd.terminated   = PATH_STATS_ABSORBED;
+    prd.shadowRays   = 0;
+    prd.shadowOccluded = 0;
+    prd.rouletteScale  = 1.0f;
+    prd.splitBranch    = false;
+    prd.bounced        = false;
 
     optix::Ray ray(
                    ray_origin,
@@ -284,7 +616,12 @@ orthographic_camera( )
 
   totalRadiance /= sqrt_num_samples * sqrt_num_samples;
 
-  output_buffer[ launch_index ] = make_float4( totalRadiance, 1.0 );
+  if ( traversal_cost )
+  {
+    totalRadiance = traversalCostColor( traversal_cost_buffer[ pixel ], sqrt_num_samples * sqrt_num_samples );
+  }
+
+  output_buffer[ pixel ] = make_float4( totalRadiance, 1.0 );
 
 } // orthographic_camera
 
@@ -298,22 +635,30 @@ void
 pathtrace_orthographic_camera( )
 {
 
+  const uint2 pixel = launch_index + launch_offset;
+
   optix::size_t2 screenSize = output_buffer.size( );
 
   float2 inv_screen  = 1.0f / make_float2( screenSize ) * 2.0f;
-  float2 pixelCorner = make_float2( launch_index ) * inv_screen - 1.0f;
+  float2 pixelCorner = make_float2( pixel ) * inv_screen - 1.0f;
 
   float2 jitter_scale = inv_screen / sqrt_num_samples;
 
-  float3 totalRadiance = make_float3( 0.0f );
+  float3 totalRadiance    = make_float3( 0.0f );
+  float3 directRadiance   = make_float3( 0.0f );
+  float3 indirectRadiance = make_float3( 0.0f );
 
   // loop vars
   unsigned x, y;
   float2 jitter;
 
-  unsigned seed = tea< 16 >( screenSize.x * launch_index.y + launch_index.x, frame_number );
+  unsigned seed = tea< 16 >( screenSize.x * pixel.y + pixel.x, frame_number + frame_offset );
   seed += globalSeed;
 
+  PathCounters counters = { { 0, 0, 0, 0 }, 0ull, 0, 0 };
+
+  float rouletteScale = getRouletteScale( );
+
   unsigned int samples_per_pixel = sqrt_num_samples * sqrt_num_samples;
 
   // seems faster than two for loops for x and y on gpu
@@ -331,81 +676,128 @@ pathtrace_orthographic_camera( )
     float3 ray_direction = normalize( W );          // always parallel view direction
 
 
-    PerRayData_pathtrace prd;
-    prd.result       = make_float3( 0.f );
-    prd.attenuation  = make_float3( 1.f );
-    prd.radiance     = make_float3( 0.f );
-    prd.countEmitted = true;
-    prd.done         = false;
-    prd.inside       = false;
-    prd.seed         = seed;
-    prd.depth        = 0;
-    prd.useSpecular  = true;
+    unsigned branchSeed = seed;
 
-    for ( ; ; )
+    // the branches share the camera ray and its first hit; each
+    // takes its own bounce from there
+    for ( unsigned branch = 0; branch < first_bounce_splits; ++branch )
     {
 
-      float3 attenuation = prd.attenuation;
+      PerRayData_pathtrace prd;
+      prd.result       = make_float3( 0.f );
+      prd.attenuation  = make_float3( 1.f );
+      prd.radiance     = make_float3( 0.f );
+      prd.countEmitted = true; // later branches never start on a light, see below
+      prd.done         = false;
+      prd.inside       = false;
+      prd.seed         = branchSeed;
+      prd.depth        = 0;
+      prd.useSpecular  = true;
+      prd.terminated   = PATH_STATS_ABSORBED;
+      prd.shadowRays   = 0;
+      prd.shadowOccluded = 0;
+      prd.rouletteScale  = rouletteScale;
+      prd.splitBranch    = branch > 0;
+      prd.bounced        = false;
+
+      float3 origin    = ray_origin;
+      float3 direction = ray_direction;
+
+      for ( ; ; )
+      {
 
-      optix::Ray ray(
-                     ray_origin,
-                     ray_direction,
-                     radiance_ray_type,
-                     scene_epsilon
-                     );
+        float3 attenuation = prd.attenuation;
 
-      rtTrace( top_object, ray, prd );
+        optix::Ray ray(
+                       origin,
+                       direction,
+                       radiance_ray_type,
+                       scene_epsilon
+                       );
 
+        rtTrace( top_object, ray, prd );
 
-      if ( prd.depth > max_bounces )
-      {
+        float3 bounceRadiance = prd.radiance * attenuation;
 
-        prd.result += prd.radiance * attenuation;
-        break;
+        bool lastBounce = prd.depth > max_bounces;
 
-      }
+        // the layers split what the image counts by depth, so they
+        // skip bounces before first_bounce too and always add up
+        // to the image
+        if ( lastBounce || prd.depth >= first_bounce )
+        {
 
-      if ( prd.depth >= first_bounce )
-      {
+          prd.result += bounceRadiance;
 
-        prd.result += prd.radiance * attenuation;
+          if ( prd.depth == 0 )
+          {
 
-      }
+            directRadiance += bounceRadiance;
 
-      if ( prd.done )
-      {
+          }
+          else
+          {
 
-        break;
+            indirectRadiance += bounceRadiance;
 
-      }
+          }
 
-      ++prd.depth;
-      ray_origin    = prd.origin;
-      ray_direction = prd.direction;
+        }
 
-    }
+        if ( lastBounce || prd.done )
+        {
 
-    totalRadiance += prd.result;
+          break;
 
-  }
+        }
 
-  totalRadiance /= sqrt_num_samples * sqrt_num_samples;
+        if ( prd.depth == 0 )
+        {
 
-  if ( frame_number > 1 )
-  {
+          prd.attenuation /= static_cast< float >( first_bounce_splits );
+          prd.splitBranch  = false;
 
-    float a            = 1.0f / static_cast< float >( frame_number );
-    float b            = ( static_cast< float >( frame_number ) - 1.0f ) * a;
-    float3 oldRadiance = make_float3( output_buffer[ launch_index ] );
-    output_buffer[ launch_index ] = make_float4( a * totalRadiance + b * oldRadiance, 1.0f );
+        }
+
+        ++prd.depth;
+        origin    = prd.origin;
+        direction = prd.direction;
+
+      }
+
+      totalRadiance += prd.result;
+      branchSeed     = prd.seed;
+
+      if ( path_stats )
+      {
+        countPath( prd, counters );
+      }
+
+      // the first hit missed, hit a light or absorbed the path
+      // without picking a bounce, so there's nothing to split.
+      // Split branches share that absorption (see closest_hit_bsdf)
+      // to keep the estimate unbiased.
+      if ( !prd.bounced )
+      {
+        break;
+      }
+
+    }
 
   }
-  else
+
+  if ( path_stats )
   {
+    flushPathCounters( counters );
+  }
 
-    output_buffer[ launch_index ] = make_float4( totalRadiance, 1.0f );
+  float invSamples = 1.0f / ( sqrt_num_samples * sqrt_num_samples );
 
-  }
+  totalRadiance    *= invSamples;
+  directRadiance   *= invSamples;
+  indirectRadiance *= invSamples;
+
+  writeFrame( totalRadiance, directRadiance, indirectRadiance );
 
 } // orthographic_camera
 
@@ -424,8 +816,9 @@ void
 miss( )
 {
 
-  prd_current.radiance = bg_color;
-  prd_current.done     = true;
+  prd_current.radiance   = bg_color;
+  prd_current.done       = true;
+  prd_current.terminated = PATH_STATS_MISSED;
 
 }
 
@@ -443,6 +836,8 @@ void
 exception( )
 {
 
-  output_buffer[ launch_index ] = make_float4( error_color, 1.0 );
+  const uint2 pixel = launch_index + launch_offset;
+
+  output_buffer[ pixel ] = make_float4( error_color, 1.0 );
 
 }
@@ -22,6 +22,7 @@
 #include "optixu/optixu_math_namespace.h"
 #include "optixu/optixu_matrix_namespace.h"
 #include "optixu/optixu_aabb_namespace.h"
+#include "traversal_cost.h"
 
 
 rtDeclareVariable( float3,     boxmin,           , );
@@ -62,6 +63,8 @@ void
 box_intersect( int )
 {
 
+  countPrimitiveTest( ray.ray_type );
+
   float3 t0   = ( boxmin - ray.origin ) / ray.direction;
   float3 t1   = ( boxmax - ray.origin ) / ray.direction;
   float3 near = fminf( t0, t1 );
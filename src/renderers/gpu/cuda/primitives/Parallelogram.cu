@@ -19,6 +19,7 @@
  */
 
 #include "optix_world.h"
+#include "traversal_cost.h"
 
 
 rtDeclareVariable( float4,     plane,            , );
@@ -43,6 +44,8 @@ void
 intersect( int primIdx )
 {
 
+  countPrimitiveTest( ray.ray_type );
+
   float3 n = make_float3( plane );
   float dt = optix::dot( ray.direction, n );
   float t  = ( plane.w - optix::dot( n, ray.origin ) ) / dt;
@@ -19,6 +19,7 @@
  */
 
 #include <optix_world.h>
+#include "traversal_cost.h"
 
 rtDeclareVariable( float4,     sphere,           , );
 
@@ -37,6 +38,8 @@ void
 intersect_sphere( void )
 {
 
+  countPrimitiveTest( ray.ray_type );
+
   float3 center = make_float3( sphere );
   float3 O      = ray.origin - center;
   float3 D      = ray.direction;
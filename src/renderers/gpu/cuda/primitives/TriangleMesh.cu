@@ -31,6 +31,7 @@
 #include <optixu/optixu_matrix_namespace.h>
 #include <optixu/optixu_aabb_namespace.h>
 #include "intersection_refinement.h"
+#include "traversal_cost.h"
 
 using namespace optix;
 
@@ -60,6 +61,8 @@ static __device__
 void
 meshIntersect( int primIdx )
 {
+  countPrimitiveTest( ray.ray_type );
+
   const int3 v_idx = index_buffer[ primIdx ];
 
   const float3 p0 = vertex_buffer[ v_idx.x ];
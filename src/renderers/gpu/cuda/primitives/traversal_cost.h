@@ -0,0 +1,48 @@
+#ifndef traversal_cost_h
+#define traversal_cost_h
+
+
+#include <optix.h>
+#include <optixu/optixu_math_namespace.h>
+
+
+//
+// Primitive tests per pixel for the traversal cost display.
+// OptiX doesn't expose node visits, so every call of an
+// intersection program counts as one test: x for radiance
+// rays, y for shadow rays. The camera clears its pixel first.
+//
+rtDeclareVariable( unsigned int, traversal_cost,       , );
+rtDeclareVariable( unsigned int, shadow_ray_type,      , );
+rtDeclareVariable( uint2,        cost_launch_index,    rtLaunchIndex, );
+rtDeclareVariable( uint2,        launch_offset,        , );
+
+rtBuffer< uint2, 2 > traversal_cost_buffer;
+
+
+static
+__device__ __inline__
+void
+countPrimitiveTest( unsigned int rayType )
+{
+
+  if ( traversal_cost )
+  {
+
+    uint2 &cost = traversal_cost_buffer[ cost_launch_index + launch_offset ];
+
+    if ( rayType == shadow_ray_type )
+    {
+      ++cost.y;
+    }
+    else
+    {
+      ++cost.x;
+    }
+
+  }
+
+}
+
+
+#endif // traversal_cost_h
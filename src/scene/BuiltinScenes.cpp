@@ -0,0 +1,337 @@
+#include "BuiltinScenes.hpp"
+#include <cmath>
+#include "ObjLoader.hpp"
+
+
+namespace light
+{
+
+
+namespace
+{
+
+
+const float  pi   = 3.14159265358979323846f;
+const Float3 clay = { 0.71f, 0.62f, 0.53f };
+
+
+Float3
+uniform( float value )
+{
+
+  return Float3 { value, value, value };
+
+}
+
+
+IlluminatorRecord
+sphereLight(
+            Float3 center,
+            Float3 radiantFlux,
+            float  radius
+            )
+{
+
+  IlluminatorRecord illuminator;
+  illuminator.center      = center;
+  illuminator.radiantFlux = radiantFlux;
+  illuminator.shape       = 0; // LightShape::SPHERE
+  illuminator.radius      = radius;
+
+  return illuminator;
+
+}
+
+
+} // namespace
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief buildBasicScene
+///////////////////////////////////////////////////////////////
+SceneDescription
+buildBasicScene( )
+{
+
+  SceneDescription scene;
+
+  float roughness = 0.3f;
+
+  std::uint32_t boxPrim    = scene.addBox( );
+  std::uint32_t quadPrim   = scene.addQuad( );
+  std::uint32_t spherePrim = scene.addSphere( );
+
+  std::uint32_t boxMaterial    = scene.addMaterial( clay, roughness, uniform( 1.0f ) );
+  std::uint32_t quadMaterial   = scene.addMaterial( clay, roughness, uniform( 1.5f ) );
+  std::uint32_t sphereMaterial = scene.addMaterial( clay, roughness, uniform( 1.0f ) );
+
+  scene.addShape(
+                 "box",
+                 { boxPrim },
+                 boxMaterial,
+                 makeTransform( Float3 { -1.5f, 0.0f, 0.0f } )
+                 );
+
+  scene.addShape(
+                 "ground",
+                 { quadPrim },
+                 quadMaterial,
+                 makeTransform(
+                               Float3 { 0.0f, -1.0f, 0.0f },
+                               Float3 { 5.0f, 5.0f,  1.0f },
+                               pi * 0.5f,
+                               Float3 { 1.0f, 0.0f,  0.0f }
+                               )
+                 );
+
+  scene.addShape(
+                 "sphere",
+                 { spherePrim },
+                 sphereMaterial,
+                 makeTransform( Float3 { 1.5f, 0.0f, 0.0f } )
+                 );
+
+  scene.addSphereIlluminator(
+                             "light",
+                             sphereLight( Float3 { 2.0f, 6.0f, 4.0f }, uniform( 1000.0f ), 0.1f ),
+                             spherePrim
+                             );
+
+  return scene;
+
+} // buildBasicScene
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief buildAdvancedScene
+///////////////////////////////////////////////////////////////
+SceneDescription
+buildAdvancedScene( )
+{
+
+  SceneDescription scene;
+
+  float roughness = 0.2f;
+
+  std::uint32_t boxPrim    = scene.addBox( );
+  std::uint32_t quadPrim   = scene.addQuad( );
+  std::uint32_t spherePrim = scene.addSphere( );
+
+  std::uint32_t groundMaterial       = scene.addMaterial( clay,                          roughness, uniform( 2.5f ) );
+  std::uint32_t bigBoxMaterial       = scene.addMaterial( clay,                          0.001f,    uniform( 100.5f ) );
+  std::uint32_t littleBoxMaterial    = scene.addMaterial( clay,                          roughness, uniform( 1.5f ) );
+  std::uint32_t bigSphereMaterial    = scene.addMaterial( Float3 { 0.8f, 0.3f, 0.7f },   roughness, uniform( 1.5f ) );
+  std::uint32_t littleSphereMaterial = scene.addMaterial( clay,                          0.01f,     uniform( 10.0f ) );
+  std::uint32_t wallMaterial         = scene.addMaterial( clay,                          roughness, uniform( 1.5f ) );
+  std::uint32_t redWallMaterial      = scene.addMaterial( Float3 { 0.8f, 0.2f, 0.3f },   roughness, uniform( 1.0f ) );
+  std::uint32_t greenWallMaterial    = scene.addMaterial( Float3 { 0.2f, 0.8f, 0.3f },   roughness, uniform( 1.0f ) );
+
+  //
+  // ground quad
+  //
+  scene.addShape(
+                 "ground",
+                 { quadPrim },
+                 groundMaterial,
+                 makeTransform(
+                               Float3 { 0.0f, 0.0f, 0.0f },
+                               Float3 { 5.0f, 5.0f, 1.0f },
+                               pi * 0.5f,
+                               Float3 { 1.0f, 0.0f, 0.0f }
+                               )
+                 );
+
+  //
+  // stack of two boxes
+  //
+  scene.addShape(
+                 "big box",
+                 { boxPrim },
+                 bigBoxMaterial,
+                 makeTransform( Float3 { -2.0f, 1.0f, -1.0f } )
+                 );
+
+  scene.addShape(
+                 "little box",
+                 { boxPrim },
+                 littleBoxMaterial,
+                 makeTransform( Float3 { -2.0f, 2.5f, -1.0f }, uniform( 0.5f ) )
+                 );
+
+  //
+  // two spheres
+  //
+  scene.addShape(
+                 "big sphere",
+                 { spherePrim },
+                 bigSphereMaterial,
+                 makeTransform( Float3 { 1.5f, 1.0f, 0.0f } )
+                 );
+
+  scene.addShape(
+                 "little sphere",
+                 { spherePrim },
+                 littleSphereMaterial,
+                 makeTransform( Float3 { 2.5f, 0.5f, 1.0f }, uniform( 0.5f ) )
+                 );
+
+  //
+  // walls
+  //
+  scene.addShape(
+                 "back wall",
+                 { quadPrim },
+                 wallMaterial,
+                 makeTransform(
+                               Float3 { 0.0f, 4.0f, -5.0f },
+                               Float3 { 5.0f, 4.0f, 1.0f },
+                               pi,
+                               Float3 { 0.0f, 1.0f, 0.0f }
+                               )
+                 );
+
+  scene.addShape(
+                 "left wall",
+                 { quadPrim },
+                 redWallMaterial,
+                 makeTransform(
+                               Float3 { -5.0f, 4.0f, 0.0f },
+                               Float3 { 5.0f, 4.0f, 1.0f },
+                               pi * -0.5f,
+                               Float3 { 0.0f, 1.0f, 0.0f }
+                               )
+                 );
+
+  scene.addShape(
+                 "front wall",
+                 { quadPrim },
+                 wallMaterial,
+                 makeTransform(
+                               Float3 { 0.0f, 4.0f, 5.0f },
+                               Float3 { 5.0f, 4.0f, 1.0f }
+                               )
+                 );
+
+  scene.addShape(
+                 "green wall",
+                 { quadPrim },
+                 greenWallMaterial,
+                 makeTransform(
+                               Float3 { 5.0f, 4.0f, 0.0f },
+                               Float3 { 5.0f, 4.0f, 1.0f },
+                               pi * 0.5f,
+                               Float3 { 0.0f, 1.0f, 0.0f }
+                               )
+                 );
+
+  //
+  // lights
+  //
+  scene.addSphereIlluminator(
+                             "high light",
+                             sphereLight( Float3 { 1.0f, 4.0f, -3.0f }, uniform( 400.0f ), 0.7f ),
+                             spherePrim
+                             );
+
+  scene.addSphereIlluminator(
+                             "low light",
+                             sphereLight( Float3 { -1.5f, 1.0f, 4.0f }, uniform( 120.0f ), 0.75f ),
+                             spherePrim
+                             );
+
+  return scene;
+
+} // buildAdvancedScene
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief buildModelScene
+///////////////////////////////////////////////////////////////
+SceneDescription
+buildModelScene( const std::string &modelFile )
+{
+
+  SceneDescription scene;
+
+  float roughness = 0.3f;
+
+  std::uint32_t quadPrim   = scene.addQuad( );
+  std::uint32_t spherePrim = scene.addSphere( );
+
+  ObjMesh mesh = loadObjMesh( modelFile );
+  std::uint32_t meshPrim = scene.addMesh( mesh.vertices, mesh.normals, mesh.triangles );
+
+  std::uint32_t groundMaterial = scene.addMaterial( clay, roughness, uniform( 1.5f ) );
+  std::uint32_t wallMaterial   = scene.addMaterial( clay, roughness, uniform( 1.5f ) );
+  std::uint32_t modelMaterial  = scene.addMaterial( clay, roughness, uniform( 1.5f ) );
+
+  scene.addShape(
+                 "ground",
+                 { quadPrim },
+                 groundMaterial,
+                 makeTransform(
+                               Float3 { 0.0f, 0.0f, 0.0f },
+                               Float3 { 8.0f, 8.0f, 1.0f },
+                               pi * 0.5f,
+                               Float3 { 1.0f, 0.0f, 0.0f }
+                               )
+                 );
+
+  scene.addShape(
+                 "back wall",
+                 { quadPrim },
+                 wallMaterial,
+                 makeTransform(
+                               Float3 { 0.0f, 4.0f, -8.0f },
+                               Float3 { 8.0f, 4.0f, 1.0f },
+                               pi,
+                               Float3 { 0.0f, 1.0f, 0.0f }
+                               )
+                 );
+
+  scene.addShape(
+                 "left wall",
+                 { quadPrim },
+                 wallMaterial,
+                 makeTransform(
+                               Float3 { -8.0f, 4.0f, 0.0f },
+                               Float3 { 8.0f, 4.0f, 1.0f },
+                               pi * -0.5f,
+                               Float3 { 0.0f, 1.0f, 0.0f }
+                               )
+                 );
+
+  scene.addShape(
+                 "model",
+                 { meshPrim },
+                 modelMaterial,
+                 makeTransform( Float3 { 0.0f, 3.0f, 0.0f }, uniform( 0.01f ) ),
+                 AccelHint::BVH
+                 );
+
+  //
+  // sun: 1.362 W/m^2 at the surface, 0.002 for an arbitrary atmosphere
+  //
+  Float3 direction = { 4.0f, 10.0f, 4.0f };
+  float distance   = 149.6e9f / std::sqrt( direction.x * direction.x + direction.y * direction.y + direction.z * direction.z );
+
+  scene.addSphereIlluminator(
+                             "light1",
+                             sphereLight(
+                                         Float3 { direction.x * distance, direction.y * distance, direction.z * distance },
+                                         uniform( 4.1e26f * 0.002f ),
+                                         695.7e6f
+                                         ),
+                             spherePrim
+                             );
+
+  return scene;
+
+} // buildModelScene
+
+
+
+} // namespace light
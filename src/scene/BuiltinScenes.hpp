@@ -0,0 +1,37 @@
+#ifndef BuiltinScenes_hpp
+#define BuiltinScenes_hpp
+
+
+#include <string>
+#include "SceneDescription.hpp"
+
+
+namespace light
+{
+
+
+///////////////////////////////////////////////////////////////
+/// \brief buildBasicScene
+/// \return box, sphere and ground quad under a single light
+///////////////////////////////////////////////////////////////
+SceneDescription buildBasicScene ( );
+
+
+///////////////////////////////////////////////////////////////
+/// \brief buildAdvancedScene
+/// \return box stack and spheres in a colored room with two lights
+///////////////////////////////////////////////////////////////
+SceneDescription buildAdvancedScene ( );
+
+
+///////////////////////////////////////////////////////////////
+/// \brief buildModelScene
+/// \param modelFile OBJ mesh placed in a corner lit by the sun
+///////////////////////////////////////////////////////////////
+SceneDescription buildModelScene ( const std::string &modelFile );
+
+
+} // namespace light
+
+
+#endif // BuiltinScenes_hpp
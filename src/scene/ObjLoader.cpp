@@ -0,0 +1,282 @@
+#include "ObjLoader.hpp"
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+#include "Trace.hpp"
+
+
+namespace light
+{
+
+
+namespace
+{
+
+
+///
+/// \brief The Corner struct
+///
+///        Position and normal index of one face corner
+///        (normal is -1 when the corner has none)
+///
+struct Corner
+{
+  std::int64_t position;
+  std::int64_t normal;
+};
+
+
+bool
+isSpace( char c )
+{
+
+  return c == ' ' || c == '\t' || c == '\r';
+
+}
+
+
+const char *
+skipSpace( const char *p )
+{
+
+  while ( isSpace( *p ) )
+  {
+    ++p;
+  }
+
+  return p;
+
+}
+
+
+///
+/// \brief resolveIndex
+///
+///        OBJ indices are 1-based, negative values count back
+///        from the most recent element
+///
+std::int64_t
+resolveIndex(
+             long        index,
+             std::size_t count
+             )
+{
+
+  std::int64_t resolved = index < 0
+                          ? static_cast< std::int64_t >( count ) + index
+                          : static_cast< std::int64_t >( index ) - 1;
+
+  if ( index == 0 || resolved < 0 || resolved >= static_cast< std::int64_t >( count ) )
+  {
+
+    throw std::runtime_error( "OBJ face refers to a missing vertex" );
+
+  }
+
+  return resolved;
+
+}
+
+
+Float3
+parseFloat3( const char *p )
+{
+
+  char *pEnd;
+  Float3 value;
+
+  value.x = std::strtof( p, &pEnd );
+  value.y = std::strtof( pEnd, &pEnd );
+  value.z = std::strtof( pEnd, &pEnd );
+
+  return value;
+
+}
+
+
+} // namespace
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief loadObjMesh
+///////////////////////////////////////////////////////////////
+ObjMesh
+loadObjMesh( const std::string &filename )
+{
+
+  LIGHT_TRACE_SCOPE( "meshLoad", "load" );
+
+  std::ifstream file( filename );
+
+  if ( !file )
+  {
+
+    throw std::runtime_error( "Could not open OBJ file: " + filename );
+
+  }
+
+  std::stringstream stream;
+  stream << file.rdbuf( );
+
+  return parseObjMesh( stream.str( ) );
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief parseObjMesh
+///////////////////////////////////////////////////////////////
+ObjMesh
+parseObjMesh( const std::string &text )
+{
+
+  std::vector< Float3 > positions;
+  std::vector< Float3 > normals;
+  std::vector< Corner > corners; // three per triangle
+
+  bool allCornersHaveNormals = true;
+
+  std::vector< Corner > face;
+
+  std::size_t lineStart = 0;
+
+  while ( lineStart < text.size( ) )
+  {
+
+    std::size_t lineEnd = text.find( '\n', lineStart );
+
+    if ( lineEnd == std::string::npos )
+    {
+      lineEnd = text.size( );
+    }
+
+    std::string line = text.substr( lineStart, lineEnd - lineStart );
+    lineStart = lineEnd + 1;
+
+    const char *p = skipSpace( line.c_str( ) );
+
+    if ( p[ 0 ] == 'v' && isSpace( p[ 1 ] ) )
+    {
+
+      positions.push_back( parseFloat3( p + 1 ) );
+
+    }
+    else if ( p[ 0 ] == 'v' && p[ 1 ] == 'n' && isSpace( p[ 2 ] ) )
+    {
+
+      normals.push_back( parseFloat3( p + 2 ) );
+
+    }
+    else if ( p[ 0 ] == 'f' && isSpace( p[ 1 ] ) )
+    {
+
+      face.clear( );
+      p = skipSpace( p + 1 );
+
+      // corners look like v, v/t, v//n or v/t/n
+      while ( *p )
+      {
+
+        char *pEnd;
+        long position = std::strtol( p, &pEnd, 10 );
+
+        if ( pEnd == p )
+        {
+          throw std::runtime_error( "Malformed OBJ face" );
+        }
+
+        Corner corner;
+        corner.position = resolveIndex( position, positions.size( ) );
+        corner.normal   = -1;
+
+        p = pEnd;
+
+        if ( *p == '/' )
+        {
+
+          ++p;
+
+          if ( *p != '/' )
+          {
+            std::strtol( p, &pEnd, 10 ); // texture coordinate, unused
+            p = pEnd;
+          }
+
+          if ( *p == '/' )
+          {
+            ++p;
+            corner.normal = resolveIndex( std::strtol( p, &pEnd, 10 ), normals.size( ) );
+            p = pEnd;
+          }
+
+        }
+
+        allCornersHaveNormals = allCornersHaveNormals && corner.normal >= 0;
+
+        face.push_back( corner );
+        p = skipSpace( p );
+
+      }
+
+      for ( std::size_t i = 2; i < face.size( ); ++i )
+      {
+
+        corners.push_back( face[ 0 ] );
+        corners.push_back( face[ i - 1 ] );
+        corners.push_back( face[ i ] );
+
+      }
+
+    }
+
+  }
+
+  //
+  // one output vertex per unique position/normal pair
+  //
+  bool useNormals = allCornersHaveNormals && !corners.empty( );
+
+  ObjMesh mesh;
+  mesh.triangles.reserve( corners.size( ) );
+
+  std::unordered_map< std::uint64_t, std::uint32_t > vertexIndices;
+
+  for ( const Corner &corner : corners )
+  {
+
+    std::uint64_t key = static_cast< std::uint64_t >( corner.position );
+
+    if ( useNormals )
+    {
+      key |= static_cast< std::uint64_t >( corner.normal ) << 32;
+    }
+
+    auto inserted = vertexIndices.emplace( key, static_cast< std::uint32_t >( mesh.vertices.size( ) ) );
+
+    if ( inserted.second )
+    {
+
+      mesh.vertices.push_back( positions[ static_cast< std::size_t >( corner.position ) ] );
+
+      if ( useNormals )
+      {
+        mesh.normals.push_back( normals[ static_cast< std::size_t >( corner.normal ) ] );
+      }
+
+    }
+
+    mesh.triangles.push_back( inserted.first->second );
+
+  }
+
+  return mesh;
+
+} // parseObjMesh
+
+
+
+} // namespace light
@@ -0,0 +1,51 @@
+#ifndef ObjLoader_hpp
+#define ObjLoader_hpp
+
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "SceneDescription.hpp"
+
+
+namespace light
+{
+
+
+/////////////////////////////////////////////
+/// \brief The ObjMesh struct
+///
+///        Indexed triangle mesh ready for
+///        SceneDescription::addMesh
+/////////////////////////////////////////////
+struct ObjMesh
+{
+  std::vector< Float3 >        vertices;
+  std::vector< Float3 >        normals;   // empty when the file has none
+  std::vector< std::uint32_t > triangles;
+};
+
+
+///////////////////////////////////////////////////////////////
+/// \brief loadObjMesh
+///
+///        Reads the positions, normals and faces of a Wavefront
+///        OBJ file into one mesh. Polygons are fan triangulated
+///        and materials, groups and texture coordinates are
+///        ignored.
+///////////////////////////////////////////////////////////////
+ObjMesh loadObjMesh ( const std::string &filename );
+
+
+///////////////////////////////////////////////////////////////
+/// \brief parseObjMesh
+///
+///        loadObjMesh for text already in memory
+///////////////////////////////////////////////////////////////
+ObjMesh parseObjMesh ( const std::string &text );
+
+
+} // namespace light
+
+
+#endif // ObjLoader_hpp
@@ -0,0 +1,879 @@
+#include "SceneDescription.hpp"
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_set>
+#include "Hash.hpp"
+#include "Trace.hpp"
+
+
+namespace light
+{
+
+
+namespace
+{
+
+
+const char          sceneMagic[ 8 ] = { 'L', 'B', 'S', 'C', 'E', 'N', 'E', '\0' };
+const std::uint32_t sceneVersion    = 1;
+
+const float pi = 3.14159265358979323846f;
+
+
+///
+/// \brief The SceneWriter class
+///
+///        Appends arrays of plain records to a byte buffer
+///
+class SceneWriter
+{
+
+public:
+
+  template< typename T >
+  void write( const T &value )
+  {
+
+    static_assert( std::is_trivially_copyable< T >::value, "Only plain records can be written" );
+
+    const unsigned char *pBytes = reinterpret_cast< const unsigned char* >( &value );
+    bytes_.insert( bytes_.end( ), pBytes, pBytes + sizeof( T ) );
+
+  }
+
+  template< typename T >
+  void write( const std::vector< T > &values )
+  {
+
+    static_assert( std::is_trivially_copyable< T >::value, "Only plain records can be written" );
+
+    write( static_cast< std::uint64_t >( values.size( ) ) );
+
+    const unsigned char *pBytes = reinterpret_cast< const unsigned char* >( values.data( ) );
+    bytes_.insert( bytes_.end( ), pBytes, pBytes + values.size( ) * sizeof( T ) );
+
+  }
+
+  void write( const std::vector< std::string > &strings )
+  {
+
+    write( static_cast< std::uint64_t >( strings.size( ) ) );
+
+    for ( const std::string &text : strings )
+    {
+
+      write( static_cast< std::uint32_t >( text.size( ) ) );
+      bytes_.insert( bytes_.end( ), text.begin( ), text.end( ) );
+
+    }
+
+  }
+
+  std::vector< unsigned char > &getBytes( ) { return bytes_; }
+
+
+private:
+
+  std::vector< unsigned char > bytes_;
+
+};
+
+
+///
+/// \brief The SceneReader class
+///
+///        Reads records back in the order they were written
+///        and throws on truncated data
+///
+class SceneReader
+{
+
+public:
+
+  explicit
+  SceneReader( const std::vector< unsigned char > &bytes )
+    : bytes_ ( bytes )
+    , offset_( 0 )
+  {}
+
+  template< typename T >
+  void read( T *pValue )
+  {
+
+    _require( sizeof( T ) );
+    std::memcpy( pValue, bytes_.data( ) + offset_, sizeof( T ) );
+    offset_ += sizeof( T );
+
+  }
+
+  template< typename T >
+  void read( std::vector< T > *pValues )
+  {
+
+    std::uint64_t count;
+    read( &count );
+
+    if ( count > ( bytes_.size( ) - offset_ ) / sizeof( T ) )
+    {
+      throw std::runtime_error( "Scene description is truncated" );
+    }
+
+    pValues->resize( static_cast< std::size_t >( count ) );
+    std::memcpy( pValues->data( ), bytes_.data( ) + offset_, pValues->size( ) * sizeof( T ) );
+    offset_ += pValues->size( ) * sizeof( T );
+
+  }
+
+  void read( std::vector< std::string > *pStrings )
+  {
+
+    std::uint64_t count;
+    read( &count );
+
+    if ( count > bytes_.size( ) - offset_ )
+    {
+      throw std::runtime_error( "Scene description is truncated" );
+    }
+
+    pStrings->resize( static_cast< std::size_t >( count ) );
+
+    for ( std::string &text : *pStrings )
+    {
+
+      std::uint32_t length;
+      read( &length );
+      _require( length );
+
+      text.assign( reinterpret_cast< const char* >( bytes_.data( ) + offset_ ), length );
+      offset_ += length;
+
+    }
+
+  }
+
+  std::size_t getOffset( ) const { return offset_; }
+
+
+private:
+
+  void _require( std::size_t bytes )
+  {
+
+    if ( bytes > bytes_.size( ) - offset_ )
+    {
+      throw std::runtime_error( "Scene description is truncated" );
+    }
+
+  }
+
+  const std::vector< unsigned char > &bytes_;
+  std::size_t offset_;
+
+};
+
+
+template< typename T >
+std::uint64_t
+hashArray(
+          const std::vector< T > &values,
+          std::uint64_t           hash
+          )
+{
+
+  hash = hashValue( static_cast< std::uint64_t >( values.size( ) ), hash );
+  return hashBytes( values.data( ), values.size( ) * sizeof( T ), hash );
+
+}
+
+
+void
+checkIndex(
+           std::size_t index,
+           std::size_t size,
+           const char *pWhat
+           )
+{
+
+  if ( index >= size )
+  {
+
+    throw std::runtime_error( std::string( "Scene description has an invalid " ) + pWhat + " index" );
+
+  }
+
+}
+
+
+void
+checkRange(
+           std::size_t first,
+           std::size_t count,
+           std::size_t size,
+           const char *pWhat
+           )
+{
+
+  if ( first > size || count > size - first )
+  {
+
+    throw std::runtime_error( std::string( "Scene description has an invalid " ) + pWhat + " range" );
+
+  }
+
+}
+
+
+} // namespace
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief SceneDescription::addBox
+///////////////////////////////////////////////////////////////
+std::uint32_t
+SceneDescription::addBox(
+                         Float3 min,
+                         Float3 max
+                         )
+{
+
+  PrimitiveRecord primitive = { };
+  primitive.type = PrimitiveType::BOX;
+  primitive.a    = min;
+  primitive.b    = max;
+
+  return _addPrimitive( primitive );
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief SceneDescription::addSphere
+///////////////////////////////////////////////////////////////
+std::uint32_t
+SceneDescription::addSphere(
+                            Float3 center,
+                            float  radius
+                            )
+{
+
+  PrimitiveRecord primitive = { };
+  primitive.type   = PrimitiveType::SPHERE;
+  primitive.a      = center;
+  primitive.radius = radius;
+
+  return _addPrimitive( primitive );
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief SceneDescription::addQuad
+///////////////////////////////////////////////////////////////
+std::uint32_t
+SceneDescription::addQuad(
+                          Float3 anchor,
+                          Float3 v1,
+                          Float3 v2
+                          )
+{
+
+  PrimitiveRecord primitive = { };
+  primitive.type = PrimitiveType::QUAD;
+  primitive.a    = anchor;
+  primitive.b    = v1;
+  primitive.c    = v2;
+
+  return _addPrimitive( primitive );
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief SceneDescription::addMesh
+///////////////////////////////////////////////////////////////
+std::uint32_t
+SceneDescription::addMesh(
+                          const std::vector< Float3 >        &vertices,
+                          const std::vector< Float3 >        &normals,
+                          const std::vector< std::uint32_t > &triangles
+                          )
+{
+
+  if ( !normals.empty( ) && normals.size( ) != vertices.size( ) )
+  {
+
+    throw std::runtime_error( "Mesh normals must match the vertex count" );
+
+  }
+
+  if ( triangles.size( ) % 3 != 0 )
+  {
+
+    throw std::runtime_error( "Mesh triangle indices must come in threes" );
+
+  }
+
+  for ( std::uint32_t index : triangles )
+  {
+
+    checkIndex( index, vertices.size( ), "mesh vertex" );
+
+  }
+
+  MeshRecord mesh;
+  mesh.firstVertex   = static_cast< std::uint32_t >( vertices_.size( ) );
+  mesh.vertexCount   = static_cast< std::uint32_t >( vertices.size( ) );
+  mesh.firstNormal   = static_cast< std::uint32_t >( normals_.size( ) );
+  mesh.normalCount   = static_cast< std::uint32_t >( normals.size( ) );
+  mesh.firstTriangle = static_cast< std::uint32_t >( triangles_.size( ) / 3 );
+  mesh.triangleCount = static_cast< std::uint32_t >( triangles.size( ) / 3 );
+
+  vertices_ .insert( vertices_.end( ),  vertices.begin( ),  vertices.end( ) );
+  normals_  .insert( normals_.end( ),   normals.begin( ),   normals.end( ) );
+  triangles_.insert( triangles_.end( ), triangles.begin( ), triangles.end( ) );
+
+  PrimitiveRecord primitive = { };
+  primitive.type = PrimitiveType::MESH;
+  primitive.mesh = static_cast< std::uint32_t >( meshes_.size( ) );
+
+  meshes_.push_back( mesh );
+
+  return _addPrimitive( primitive );
+
+} // SceneDescription::addMesh
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief SceneDescription::addMaterial
+///////////////////////////////////////////////////////////////
+std::uint32_t
+SceneDescription::addMaterial(
+                              Float3 albedo,
+                              float  roughness,
+                              Float3 ior
+                              )
+{
+
+  MaterialRecord material = { };
+  material.albedo    = albedo;
+  material.roughness = roughness;
+  material.ior       = ior;
+
+  materials_.push_back( material );
+
+  return static_cast< std::uint32_t >( materials_.size( ) - 1 );
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief SceneDescription::addShape
+///////////////////////////////////////////////////////////////
+std::uint32_t
+SceneDescription::addShape(
+                           const std::string                  &name,
+                           const std::vector< std::uint32_t > &primitives,
+                           std::uint32_t                       material,
+                           const Transform                    &transform,
+                           AccelHint                           accel
+                           )
+{
+
+  ShapeRecord shape;
+  shape.firstPrimitive = static_cast< std::uint32_t >( shapePrimitives_.size( ) );
+  shape.primitiveCount = static_cast< std::uint32_t >( primitives.size( ) );
+  shape.material       = material;
+  shape.transform      = static_cast< std::uint32_t >( transforms_.size( ) );
+  shape.illuminator    = -1;
+  shape.accel          = accel;
+
+  shapePrimitives_.insert( shapePrimitives_.end( ), primitives.begin( ), primitives.end( ) );
+  transforms_.push_back( transform );
+  shapes_.push_back( shape );
+  shapeNames_.push_back( name );
+
+  return static_cast< std::uint32_t >( shapes_.size( ) - 1 );
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief SceneDescription::addInstance
+///////////////////////////////////////////////////////////////
+std::uint32_t
+SceneDescription::addInstance(
+                              const std::string &name,
+                              std::uint32_t      source,
+                              std::uint32_t      material,
+                              const Transform   &transform
+                              )
+{
+
+  checkIndex( source, shapes_.size( ), "instance source shape" );
+
+  ShapeRecord shape = shapes_[ source ];
+  shape.material    = material;
+  shape.transform   = static_cast< std::uint32_t >( transforms_.size( ) );
+  shape.illuminator = -1;
+
+  transforms_.push_back( transform );
+  shapes_.push_back( shape );
+  shapeNames_.push_back( name );
+
+  return static_cast< std::uint32_t >( shapes_.size( ) - 1 );
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief SceneDescription::addSphereIlluminator
+///////////////////////////////////////////////////////////////
+std::uint32_t
+SceneDescription::addSphereIlluminator(
+                                       const std::string       &name,
+                                       const IlluminatorRecord &illuminator,
+                                       std::uint32_t            spherePrimitive
+                                       )
+{
+
+  illuminators_.push_back( illuminator );
+
+  MaterialRecord material = { };
+  material.emission = getSphereEmission( illuminator );
+
+  materials_.push_back( material );
+
+  std::uint32_t shape = addShape(
+                                 name,
+                                 { spherePrimitive },
+                                 static_cast< std::uint32_t >( materials_.size( ) - 1 ),
+                                 makeTransform(
+                                               illuminator.center,
+                                               Float3 { illuminator.radius, illuminator.radius, illuminator.radius }
+                                               )
+                                 );
+
+  shapes_[ shape ].illuminator = static_cast< std::int32_t >( illuminators_.size( ) - 1 );
+
+  return shape;
+
+} // SceneDescription::addSphereIlluminator
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief SceneDescription::validate
+///////////////////////////////////////////////////////////////
+void
+SceneDescription::validate( ) const
+{
+
+  for ( const PrimitiveRecord &primitive : primitives_ )
+  {
+
+    if ( primitive.type > PrimitiveType::MESH )
+    {
+      throw std::runtime_error( "Scene description has an unknown primitive type" );
+    }
+
+    if ( primitive.type == PrimitiveType::MESH )
+    {
+      checkIndex( primitive.mesh, meshes_.size( ), "mesh" );
+    }
+
+  }
+
+  for ( const MeshRecord &mesh : meshes_ )
+  {
+
+    checkRange( mesh.firstVertex,   mesh.vertexCount,   vertices_.size( ),      "vertex" );
+    checkRange( mesh.firstNormal,   mesh.normalCount,   normals_.size( ),       "normal" );
+    checkRange( mesh.firstTriangle, mesh.triangleCount, triangles_.size( ) / 3, "triangle" );
+
+    if ( mesh.normalCount != 0 && mesh.normalCount != mesh.vertexCount )
+    {
+      throw std::runtime_error( "Scene description mesh normals don't match its vertices" );
+    }
+
+    for ( std::uint32_t i = 0; i < mesh.triangleCount * 3; ++i )
+    {
+      checkIndex( triangles_[ mesh.firstTriangle * 3 + i ], mesh.vertexCount, "mesh vertex" );
+    }
+
+  }
+
+  if ( shapeNames_.size( ) != shapes_.size( ) )
+  {
+    throw std::runtime_error( "Scene description shape names don't match its shapes" );
+  }
+
+  std::unordered_set< std::string > names;
+
+  for ( std::size_t i = 0; i < shapes_.size( ); ++i )
+  {
+
+    const ShapeRecord &shape = shapes_[ i ];
+
+    checkRange( shape.firstPrimitive, shape.primitiveCount, shapePrimitives_.size( ), "shape primitive" );
+    checkIndex( shape.material,  materials_.size( ),  "material" );
+    checkIndex( shape.transform, transforms_.size( ), "transform" );
+
+    if ( shape.illuminator >= 0 )
+    {
+      checkIndex( static_cast< std::size_t >( shape.illuminator ), illuminators_.size( ), "illuminator" );
+    }
+
+    if ( shape.accel > AccelHint::BVH )
+    {
+      throw std::runtime_error( "Scene description has an unknown acceleration hint" );
+    }
+
+    if ( !names.insert( shapeNames_[ i ] ).second )
+    {
+      throw std::runtime_error( "Scene description has duplicate shape '" + shapeNames_[ i ] + "'" );
+    }
+
+  }
+
+  for ( std::uint32_t primitive : shapePrimitives_ )
+  {
+    checkIndex( primitive, primitives_.size( ), "primitive" );
+  }
+
+} // SceneDescription::validate
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief SceneDescription::getMemoryBytes
+///////////////////////////////////////////////////////////////
+std::size_t
+SceneDescription::getMemoryBytes( ) const
+{
+
+  std::size_t bytes = primitives_.capacity( ) * sizeof( PrimitiveRecord )
+                      + meshes_.capacity( ) * sizeof( MeshRecord )
+                      + vertices_.capacity( ) * sizeof( Float3 )
+                      + normals_.capacity( ) * sizeof( Float3 )
+                      + triangles_.capacity( ) * sizeof( std::uint32_t )
+                      + materials_.capacity( ) * sizeof( MaterialRecord )
+                      + transforms_.capacity( ) * sizeof( Transform )
+                      + illuminators_.capacity( ) * sizeof( IlluminatorRecord )
+                      + shapes_.capacity( ) * sizeof( ShapeRecord )
+                      + shapePrimitives_.capacity( ) * sizeof( std::uint32_t )
+                      + shapeNames_.capacity( ) * sizeof( std::string );
+
+  for ( const std::string &name : shapeNames_ )
+  {
+    bytes += name.capacity( );
+  }
+
+  return bytes;
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief SceneDescription::getHash
+///////////////////////////////////////////////////////////////
+std::uint64_t
+SceneDescription::getHash( ) const
+{
+
+  std::uint64_t hash = hashSeed;
+
+  hash = hashArray( primitives_,      hash );
+  hash = hashArray( meshes_,          hash );
+  hash = hashArray( vertices_,        hash );
+  hash = hashArray( normals_,         hash );
+  hash = hashArray( triangles_,       hash );
+  hash = hashArray( materials_,       hash );
+  hash = hashArray( transforms_,      hash );
+  hash = hashArray( illuminators_,    hash );
+  hash = hashArray( shapes_,          hash );
+  hash = hashArray( shapePrimitives_, hash );
+
+  for ( const std::string &name : shapeNames_ )
+  {
+    hash = hashString( name, hash );
+  }
+
+  return hash;
+
+} // SceneDescription::getHash
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief SceneDescription::serialize
+///////////////////////////////////////////////////////////////
+std::vector< unsigned char >
+SceneDescription::serialize( ) const
+{
+
+  SceneWriter writer;
+
+  for ( char c : sceneMagic )
+  {
+    writer.write( c );
+  }
+
+  writer.write( sceneVersion );
+
+  writer.write( primitives_ );
+  writer.write( meshes_ );
+  writer.write( vertices_ );
+  writer.write( normals_ );
+  writer.write( triangles_ );
+  writer.write( materials_ );
+  writer.write( transforms_ );
+  writer.write( illuminators_ );
+  writer.write( shapes_ );
+  writer.write( shapePrimitives_ );
+  writer.write( shapeNames_ );
+
+  writer.write( getHash( ) );
+
+  return std::move( writer.getBytes( ) );
+
+} // SceneDescription::serialize
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief SceneDescription::deserialize
+///////////////////////////////////////////////////////////////
+SceneDescription
+SceneDescription::deserialize( const std::vector< unsigned char > &bytes )
+{
+
+  if ( bytes.size( ) < sizeof( sceneMagic ) || std::memcmp( bytes.data( ), sceneMagic, sizeof( sceneMagic ) ) != 0 )
+  {
+
+    throw std::runtime_error( "Not a LightBender scene description" );
+
+  }
+
+  SceneReader reader( bytes );
+  SceneDescription scene;
+
+  char magic[ sizeof( sceneMagic ) ];
+  reader.read( &magic );
+
+  std::uint32_t version;
+  reader.read( &version );
+
+  if ( version != sceneVersion )
+  {
+
+    throw std::runtime_error( "Unsupported scene description version" );
+
+  }
+
+  reader.read( &scene.primitives_ );
+  reader.read( &scene.meshes_ );
+  reader.read( &scene.vertices_ );
+  reader.read( &scene.normals_ );
+  reader.read( &scene.triangles_ );
+  reader.read( &scene.materials_ );
+  reader.read( &scene.transforms_ );
+  reader.read( &scene.illuminators_ );
+  reader.read( &scene.shapes_ );
+  reader.read( &scene.shapePrimitives_ );
+  reader.read( &scene.shapeNames_ );
+
+  std::uint64_t hash;
+  reader.read( &hash );
+
+  if ( hash != scene.getHash( ) )
+  {
+
+    throw std::runtime_error( "Scene description checksum mismatch" );
+
+  }
+
+  scene.validate( );
+
+  return scene;
+
+} // SceneDescription::deserialize
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief SceneDescription::write
+///////////////////////////////////////////////////////////////
+void
+SceneDescription::write( const std::string &filename ) const
+{
+
+  std::vector< unsigned char > bytes = serialize( );
+
+  std::ofstream file( filename, std::ios::binary );
+  file.write( reinterpret_cast< const char* >( bytes.data( ) ), static_cast< std::streamsize >( bytes.size( ) ) );
+
+  if ( !file )
+  {
+
+    throw std::runtime_error( "Failed writing scene description: " + filename );
+
+  }
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief SceneDescription::read
+///////////////////////////////////////////////////////////////
+SceneDescription
+SceneDescription::read( const std::string &filename )
+{
+
+  LIGHT_TRACE_SCOPE( "sceneLoad", "load" );
+
+  std::ifstream file( filename, std::ios::binary );
+
+  if ( !file )
+  {
+
+    throw std::runtime_error( "Could not open scene description: " + filename );
+
+  }
+
+  std::vector< unsigned char > bytes(
+                                     ( std::istreambuf_iterator< char >( file ) ),
+                                     std::istreambuf_iterator< char >( )
+                                     );
+
+  return deserialize( bytes );
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief SceneDescription::_addPrimitive
+///////////////////////////////////////////////////////////////
+std::uint32_t
+SceneDescription::_addPrimitive( const PrimitiveRecord &primitive )
+{
+
+  primitives_.push_back( primitive );
+
+  return static_cast< std::uint32_t >( primitives_.size( ) - 1 );
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief makeTransform
+///////////////////////////////////////////////////////////////
+Transform
+makeTransform(
+              Float3 translation,
+              Float3 scale,
+              float  rotationAngle,
+              Float3 rotationAxis
+              )
+{
+
+  float length = std::sqrt(
+                           rotationAxis.x * rotationAxis.x
+                           + rotationAxis.y * rotationAxis.y
+                           + rotationAxis.z * rotationAxis.z
+                           );
+
+  float x = rotationAxis.x / length;
+  float y = rotationAxis.y / length;
+  float z = rotationAxis.z / length;
+
+  float c = std::cos( rotationAngle );
+  float s = std::sin( rotationAngle );
+  float t = 1.0f - c;
+
+  // axis-angle rotation
+  float r[ 9 ] = {
+    x * x * t + c,     x * y * t - z * s, x * z * t + y * s,
+    x * y * t + z * s, y * y * t + c,     y * z * t - x * s,
+    x * z * t - y * s, y * z * t + x * s, z * z * t + c
+  };
+
+  Transform transform;
+
+  for ( int row = 0; row < 3; ++row )
+  {
+
+    transform.m[ row * 4 + 0 ] = r[ row * 3 + 0 ] * scale.x;
+    transform.m[ row * 4 + 1 ] = r[ row * 3 + 1 ] * scale.y;
+    transform.m[ row * 4 + 2 ] = r[ row * 3 + 2 ] * scale.z;
+
+  }
+
+  transform.m[ 3 ]  = translation.x;
+  transform.m[ 7 ]  = translation.y;
+  transform.m[ 11 ] = translation.z;
+
+  return transform;
+
+} // makeTransform
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief transformPoint
+///////////////////////////////////////////////////////////////
+Float3
+transformPoint(
+               const Transform &transform,
+               Float3           point
+               )
+{
+
+  const float *m = transform.m;
+
+  return Float3 {
+    m[ 0 ] * point.x + m[ 1 ] * point.y + m[ 2 ]  * point.z + m[ 3 ],
+    m[ 4 ] * point.x + m[ 5 ] * point.y + m[ 6 ]  * point.z + m[ 7 ],
+    m[ 8 ] * point.x + m[ 9 ] * point.y + m[ 10 ] * point.z + m[ 11 ]
+  };
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief getSphereEmission
+///////////////////////////////////////////////////////////////
+Float3
+getSphereEmission( const IlluminatorRecord &illuminator )
+{
+
+  float area  = pi * 4.0f * illuminator.radius * illuminator.radius;
+  float scale = 1.0f / ( pi * area );
+
+  return Float3 {
+    illuminator.radiantFlux.x * scale,
+    illuminator.radiantFlux.y * scale,
+    illuminator.radiantFlux.z * scale
+  };
+
+}
+
+
+
+} // namespace light
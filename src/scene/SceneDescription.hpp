@@ -0,0 +1,378 @@
+#ifndef SceneDescription_hpp
+#define SceneDescription_hpp
+
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+
+namespace light
+{
+
+
+/////////////////////////////////////////////
+/// \brief The Float3 struct
+///
+///        Plain three component vector so scene data
+///        doesn't depend on any backend's math types
+/////////////////////////////////////////////
+struct Float3
+{
+  float x;
+  float y;
+  float z;
+};
+
+
+/////////////////////////////////////////////
+/// \brief The Transform struct
+///
+///        Row-major 3x4 affine matrix (the top three rows
+///        of a 4x4 matrix applied to column vectors)
+/////////////////////////////////////////////
+struct Transform
+{
+  float m[ 12 ];
+};
+
+
+enum class PrimitiveType : std::uint32_t
+{
+
+  BOX,    ///< axis aligned box from 'a' (min) to 'b' (max)
+  SPHERE, ///< sphere at 'a' with 'radius'
+  QUAD,   ///< parallelogram at anchor 'a' spanned by 'b' and 'c'
+  MESH    ///< triangle mesh 'mesh'
+
+};
+
+
+enum class AccelHint : std::uint32_t
+{
+
+  NONE, ///< few primitives, no acceleration structure
+  BVH   ///< many primitives, build a BVH over them
+
+};
+
+
+/////////////////////////////////////////////
+/// \brief The PrimitiveRecord struct
+/////////////////////////////////////////////
+struct PrimitiveRecord
+{
+  PrimitiveType type;
+  std::uint32_t mesh;   // index into meshes (MESH only)
+  Float3        a;
+  Float3        b;
+  Float3        c;
+  float         radius;
+};
+
+
+/////////////////////////////////////////////
+/// \brief The MeshRecord struct
+///
+///        Ranges into the scene's vertex, normal and
+///        triangle arrays. Triangle indices are local to
+///        the mesh. normalCount is zero or vertexCount.
+/////////////////////////////////////////////
+struct MeshRecord
+{
+  std::uint32_t firstVertex;
+  std::uint32_t vertexCount;
+  std::uint32_t firstNormal;
+  std::uint32_t normalCount;
+  std::uint32_t firstTriangle;
+  std::uint32_t triangleCount;
+};
+
+
+/////////////////////////////////////////////
+/// \brief The MaterialRecord struct
+///
+///        Materials with non-zero emission are lights and
+///        ignore the surface parameters
+/////////////////////////////////////////////
+struct MaterialRecord
+{
+  Float3 albedo;
+  Float3 ior;
+  Float3 emission;
+  float  roughness;
+};
+
+
+/////////////////////////////////////////////
+/// \brief The IlluminatorRecord struct
+///
+///        Same layout as the device side Illuminator
+/////////////////////////////////////////////
+struct IlluminatorRecord
+{
+  Float3        center;
+  Float3        radiantFlux;
+  std::uint32_t shape;
+  float         radius;
+};
+
+
+/////////////////////////////////////////////
+/// \brief The ShapeRecord struct
+///
+///        A named group of primitives sharing one material
+///        and one transform
+/////////////////////////////////////////////
+struct ShapeRecord
+{
+  std::uint32_t firstPrimitive; // range in getShapePrimitives( )
+  std::uint32_t primitiveCount;
+  std::uint32_t material;
+  std::uint32_t transform;
+  std::int32_t  illuminator;    // -1 for non-emitting shapes
+  AccelHint     accel;
+};
+
+
+/////////////////////////////////////////////
+/// \brief The SceneDescription class
+///
+///        Backend independent scene: flat arrays of plain
+///        records that renderers compile into their own
+///        structures. Primitives and materials may be shared
+///        between shapes. Descriptions can be hashed and
+///        written to or read from disk.
+/////////////////////////////////////////////
+class SceneDescription
+{
+
+public:
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief addBox, addSphere, addQuad
+  /// \return primitive index
+  ///////////////////////////////////////////////////////////////
+  std::uint32_t addBox (
+                        Float3 min = Float3 { -1.0f, -1.0f, -1.0f },
+                        Float3 max = Float3 {  1.0f,  1.0f,  1.0f }
+                        );
+
+  std::uint32_t addSphere (
+                           Float3 center = Float3 { 0.0f, 0.0f, 0.0f },
+                           float  radius = 1.0f
+                           );
+
+  std::uint32_t addQuad (
+                         Float3 anchor = Float3 { -1.0f, -1.0f, 0.0f },
+                         Float3 v1     = Float3 {  2.0f,  0.0f, 0.0f },
+                         Float3 v2     = Float3 {  0.0f,  2.0f, 0.0f }
+                         );
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief addMesh
+  /// \param vertices
+  /// \param normals per vertex normals or empty
+  /// \param triangles three vertex indices per triangle
+  /// \return primitive index
+  ///////////////////////////////////////////////////////////////
+  std::uint32_t addMesh (
+                         const std::vector< Float3 >        &vertices,
+                         const std::vector< Float3 >        &normals,
+                         const std::vector< std::uint32_t > &triangles
+                         );
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief addMaterial
+  /// \return material index
+  ///////////////////////////////////////////////////////////////
+  std::uint32_t addMaterial (
+                             Float3 albedo,
+                             float  roughness,
+                             Float3 ior
+                             );
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief addShape
+  /// \param name unique shape name
+  /// \param primitives
+  /// \param material
+  /// \param transform
+  /// \param accel
+  /// \return shape index
+  ///////////////////////////////////////////////////////////////
+  std::uint32_t addShape (
+                          const std::string                  &name,
+                          const std::vector< std::uint32_t > &primitives,
+                          std::uint32_t                       material,
+                          const Transform                    &transform,
+                          AccelHint                           accel = AccelHint::NONE
+                          );
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief addInstance
+  ///
+  ///        Adds a shape that reuses the primitives of shape
+  ///        'source' with its own material and transform. Costs
+  ///        one shape record however large the source is.
+  /// \return shape index
+  ///////////////////////////////////////////////////////////////
+  std::uint32_t addInstance (
+                             const std::string &name,
+                             std::uint32_t      source,
+                             std::uint32_t      material,
+                             const Transform   &transform
+                             );
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief addSphereIlluminator
+  ///
+  ///        Adds the light and an emitting shape that scales
+  ///        'spherePrimitive' to the light's size
+  /// \return shape index
+  ///////////////////////////////////////////////////////////////
+  std::uint32_t addSphereIlluminator (
+                                      const std::string       &name,
+                                      const IlluminatorRecord &illuminator,
+                                      std::uint32_t            spherePrimitive
+                                      );
+
+
+  const std::vector< PrimitiveRecord >   &getPrimitives      ( ) const { return primitives_; }
+  const std::vector< MeshRecord >        &getMeshes          ( ) const { return meshes_; }
+  const std::vector< Float3 >            &getVertices        ( ) const { return vertices_; }
+  const std::vector< Float3 >            &getNormals         ( ) const { return normals_; }
+  const std::vector< std::uint32_t >     &getTriangles       ( ) const { return triangles_; }
+  const std::vector< ShapeRecord >       &getShapes          ( ) const { return shapes_; }
+  const std::vector< std::uint32_t >     &getShapePrimitives ( ) const { return shapePrimitives_; }
+  const std::vector< std::string >       &getShapeNames      ( ) const { return shapeNames_; }
+
+  const std::vector< MaterialRecord >    &getMaterials       ( ) const { return materials_; }
+  std::vector< MaterialRecord >          &getMaterials       ( )       { return materials_; }
+
+  const std::vector< Transform >         &getTransforms      ( ) const { return transforms_; }
+  std::vector< Transform >               &getTransforms      ( )       { return transforms_; }
+
+  const std::vector< IlluminatorRecord > &getIlluminators    ( ) const { return illuminators_; }
+  std::vector< IlluminatorRecord >       &getIlluminators    ( )       { return illuminators_; }
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief validate
+  ///
+  ///        Throws if any record refers outside its arrays
+  ///////////////////////////////////////////////////////////////
+  void validate ( ) const;
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief getHash
+  /// \return hash of every record, stable across runs
+  ///////////////////////////////////////////////////////////////
+  std::uint64_t getHash ( ) const;
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief getMemoryBytes
+  /// \return memory held by every record array
+  ///////////////////////////////////////////////////////////////
+  std::size_t getMemoryBytes ( ) const;
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief serialize
+  /// \return binary form understood by deserialize
+  ///////////////////////////////////////////////////////////////
+  std::vector< unsigned char > serialize ( ) const;
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief deserialize
+  ///
+  ///        Throws on foreign, truncated or corrupt data
+  ///////////////////////////////////////////////////////////////
+  static
+  SceneDescription deserialize ( const std::vector< unsigned char > &bytes );
+
+
+  void write ( const std::string &filename ) const;
+
+  static
+  SceneDescription read ( const std::string &filename );
+
+
+private:
+
+  std::uint32_t _addPrimitive ( const PrimitiveRecord &primitive );
+
+  std::vector< PrimitiveRecord >   primitives_;
+  std::vector< MeshRecord >        meshes_;
+  std::vector< Float3 >            vertices_;
+  std::vector< Float3 >            normals_;
+  std::vector< std::uint32_t >     triangles_;
+  std::vector< MaterialRecord >    materials_;
+  std::vector< Transform >         transforms_;
+  std::vector< IlluminatorRecord > illuminators_;
+  std::vector< ShapeRecord >       shapes_;
+  std::vector< std::uint32_t >     shapePrimitives_;
+  std::vector< std::string >       shapeNames_;
+
+};
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief makeTransform
+///
+///        translation * rotation * scale, matching the order
+///        scenes have always used for their shapes
+/// \param rotationAngle radians about 'rotationAxis'
+///////////////////////////////////////////////////////////////
+Transform makeTransform (
+                         Float3 translation   = Float3 { 0.0f, 0.0f, 0.0f },
+                         Float3 scale         = Float3 { 1.0f, 1.0f, 1.0f },
+                         float  rotationAngle = 0.0f,
+                         Float3 rotationAxis  = Float3 { 0.0f, 1.0f, 0.0f }
+                         );
+
+
+///////////////////////////////////////////////////////////////
+/// \brief transformPoint
+///////////////////////////////////////////////////////////////
+Float3 transformPoint (
+                       const Transform &transform,
+                       Float3           point
+                       );
+
+
+///////////////////////////////////////////////////////////////
+/// \brief getSphereEmission
+/// \return radiance leaving a uniformly emitting sphere the size
+///         of 'illuminator'
+///////////////////////////////////////////////////////////////
+Float3 getSphereEmission ( const IlluminatorRecord &illuminator );
+
+
+///////////////////////////////////////////////////////////////
+/// \brief isEmissive
+///////////////////////////////////////////////////////////////
+inline
+bool
+isEmissive( const MaterialRecord &material )
+{
+
+  return material.emission.x > 0.0f || material.emission.y > 0.0f || material.emission.z > 0.0f;
+
+}
+
+
+} // namespace light
+
+
+#endif // SceneDescription_hpp
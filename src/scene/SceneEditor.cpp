@@ -0,0 +1,252 @@
+#include "SceneEditor.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+
+namespace light
+{
+
+
+namespace
+{
+
+
+template< typename T >
+bool
+sameBytes(
+          const T &a,
+          const T &b
+          )
+{
+
+  return std::memcmp( &a, &b, sizeof( T ) ) == 0;
+
+}
+
+
+void
+checkEditIndex(
+               std::size_t index,
+               std::size_t size,
+               const char *pWhat
+               )
+{
+
+  if ( index >= size )
+  {
+
+    throw std::runtime_error( std::string( "Can't edit " ) + pWhat + " " + std::to_string( index )
+                             + ", the scene only has " + std::to_string( size ) );
+
+  }
+
+}
+
+
+} // namespace
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief SceneEditor::SceneEditor
+///////////////////////////////////////////////////////////////
+SceneEditor::SceneEditor( SceneDescription *pScene )
+  : pScene_( pScene )
+{
+
+  if ( !pScene_ )
+  {
+
+    throw std::runtime_error( "SceneEditor needs a scene description" );
+
+  }
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief SceneEditor::setMaterial
+///////////////////////////////////////////////////////////////
+void
+SceneEditor::setMaterial(
+                         std::uint32_t         material,
+                         const MaterialRecord &record
+                         )
+{
+
+  std::vector< MaterialRecord > &materials = pScene_->getMaterials( );
+
+  checkEditIndex( material, materials.size( ), "material" );
+
+  if ( !sameBytes( materials[ material ], record ) )
+  {
+
+    materials[ material ] = record;
+    materials_.mark( material, materials.size( ) );
+
+  }
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief SceneEditor::setIlluminator
+///////////////////////////////////////////////////////////////
+void
+SceneEditor::setIlluminator(
+                            std::uint32_t            illuminator,
+                            const IlluminatorRecord &record
+                            )
+{
+
+  std::vector< IlluminatorRecord > &illuminators = pScene_->getIlluminators( );
+
+  checkEditIndex( illuminator, illuminators.size( ), "illuminator" );
+
+  if ( sameBytes( illuminators[ illuminator ], record ) )
+  {
+    return;
+  }
+
+  illuminators[ illuminator ] = record;
+  illuminators_.mark( illuminator, illuminators.size( ) );
+
+  for ( const ShapeRecord &shape : pScene_->getShapes( ) )
+  {
+
+    if ( shape.illuminator != static_cast< std::int32_t >( illuminator ) )
+    {
+      continue;
+    }
+
+    MaterialRecord material = pScene_->getMaterials( )[ shape.material ];
+    material.emission       = getSphereEmission( record );
+
+    setMaterial( shape.material, material );
+
+    setTransform(
+                 shape.transform,
+                 makeTransform( record.center, Float3 { record.radius, record.radius, record.radius } )
+                 );
+
+  }
+
+} // SceneEditor::setIlluminator
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief SceneEditor::setTransform
+///////////////////////////////////////////////////////////////
+void
+SceneEditor::setTransform(
+                          std::uint32_t    transform,
+                          const Transform &record
+                          )
+{
+
+  std::vector< Transform > &transforms = pScene_->getTransforms( );
+
+  checkEditIndex( transform, transforms.size( ), "transform" );
+
+  if ( !sameBytes( transforms[ transform ], record ) )
+  {
+
+    transforms[ transform ] = record;
+    transforms_.mark( transform, transforms.size( ) );
+
+  }
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief SceneEditor::hasChanges
+///////////////////////////////////////////////////////////////
+bool
+SceneEditor::hasChanges( ) const
+{
+
+  return !materials_.indices.empty( )
+         || !illuminators_.indices.empty( )
+         || !transforms_.indices.empty( );
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief SceneEditor::takeChanges
+///////////////////////////////////////////////////////////////
+SceneChanges
+SceneEditor::takeChanges( )
+{
+
+  SceneChanges changes;
+
+  changes.materials    = materials_.take( );
+  changes.illuminators = illuminators_.take( );
+  changes.transforms   = transforms_.take( );
+
+  return changes;
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief SceneEditor::DirtySet::mark
+///////////////////////////////////////////////////////////////
+void
+SceneEditor::DirtySet::mark(
+                            std::uint32_t index,
+                            std::size_t   size
+                            )
+{
+
+  if ( flags.size( ) < size )
+  {
+    flags.resize( size, false );
+  }
+
+  if ( !flags[ index ] )
+  {
+
+    flags[ index ] = true;
+    indices.push_back( index );
+
+  }
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief SceneEditor::DirtySet::take
+///////////////////////////////////////////////////////////////
+std::vector< std::uint32_t >
+SceneEditor::DirtySet::take( )
+{
+
+  std::vector< std::uint32_t > taken;
+  taken.swap( indices );
+
+  for ( std::uint32_t index : taken )
+  {
+    flags[ index ] = false;
+  }
+
+  std::sort( taken.begin( ), taken.end( ) );
+
+  return taken;
+
+}
+
+
+
+} // namespace light
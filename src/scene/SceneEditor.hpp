@@ -0,0 +1,138 @@
+#ifndef SceneEditor_hpp
+#define SceneEditor_hpp
+
+
+#include <vector>
+#include <cstdint>
+#include "SceneDescription.hpp"
+
+
+namespace light
+{
+
+
+/////////////////////////////////////////////
+/// \brief The SceneChanges struct
+///
+///        Sorted indices of records edited since the last
+///        batch was taken
+/////////////////////////////////////////////
+struct SceneChanges
+{
+
+  std::vector< std::uint32_t > materials;
+  std::vector< std::uint32_t > illuminators;
+  std::vector< std::uint32_t > transforms;
+
+  bool empty ( ) const
+  {
+    return materials.empty( ) && illuminators.empty( ) && transforms.empty( );
+  }
+
+};
+
+
+/////////////////////////////////////////////
+/// \brief The SceneEditor class
+///
+///        Edits the records of a SceneDescription and remembers
+///        which ones changed so a renderer can patch just those
+///        once per frame instead of recompiling the scene.
+///        Edits that don't change a value aren't recorded. The
+///        description's arrays must not grow or shrink while it
+///        is being edited.
+/////////////////////////////////////////////
+class SceneEditor
+{
+
+public:
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief SceneEditor
+  /// \param pScene description to edit, must outlive the editor
+  ///////////////////////////////////////////////////////////////
+  explicit
+  SceneEditor( SceneDescription *pScene );
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief setMaterial
+  ///////////////////////////////////////////////////////////////
+  void setMaterial (
+                    std::uint32_t         material,
+                    const MaterialRecord &record
+                    );
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief setIlluminator
+  ///
+  ///        Also keeps the emitting shape in step: its material's
+  ///        emission follows the flux and its transform follows
+  ///        the center and radius
+  ///////////////////////////////////////////////////////////////
+  void setIlluminator (
+                       std::uint32_t            illuminator,
+                       const IlluminatorRecord &record
+                       );
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief setTransform
+  ///////////////////////////////////////////////////////////////
+  void setTransform (
+                     std::uint32_t    transform,
+                     const Transform &record
+                     );
+
+
+  bool hasChanges ( ) const;
+
+
+  ///////////////////////////////////////////////////////////////
+  /// \brief takeChanges
+  /// \return everything edited since the last call, which is
+  ///         forgotten afterwards
+  ///////////////////////////////////////////////////////////////
+  SceneChanges takeChanges ( );
+
+
+  const SceneDescription &getScene ( ) const { return *pScene_; }
+
+
+private:
+
+  ///
+  /// \brief The DirtySet struct
+  ///
+  ///        Indices in the order they were first marked plus a
+  ///        flag per record so marking is O(1)
+  ///
+  struct DirtySet
+  {
+
+    std::vector< std::uint32_t > indices;
+    std::vector< bool >          flags;
+
+    void mark (
+               std::uint32_t index,
+               std::size_t   size
+               );
+
+    std::vector< std::uint32_t > take ( );
+
+  };
+
+  SceneDescription *pScene_;
+
+  DirtySet materials_;
+  DirtySet illuminators_;
+  DirtySet transforms_;
+
+};
+
+
+} // namespace light
+
+
+#endif // SceneEditor_hpp
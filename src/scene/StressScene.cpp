@@ -0,0 +1,533 @@
+#include "StressScene.hpp"
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+#include <sstream>
+#include <algorithm>
+#include <stdexcept>
+#include "ObjLoader.hpp"
+#include "Trace.hpp"
+
+
+namespace light
+{
+
+
+namespace
+{
+
+
+const float pi = 3.14159265358979323846f;
+
+// average distance between neighbouring objects
+const float objectSpacing = 3.0f;
+
+
+///
+/// \brief The StressRandom class
+///
+///        splitmix64, written out so scenes don't depend on
+///        how a standard library implements its distributions
+///
+class StressRandom
+{
+
+public:
+
+  explicit
+  StressRandom( std::uint32_t seed )
+    : state_( seed )
+  {}
+
+
+  float next( )
+  {
+
+    state_ += 0x9e3779b97f4a7c15ull;
+
+    std::uint64_t z = state_;
+    z = ( z ^ ( z >> 30 ) ) * 0xbf58476d1ce4e5b9ull;
+    z = ( z ^ ( z >> 27 ) ) * 0x94d049bb133111ebull;
+    z ^= z >> 31;
+
+    return static_cast< float >( z >> 40 ) / 16777216.0f;
+
+  }
+
+
+  float range(
+              float low,
+              float high
+              )
+  {
+
+    return low + ( high - low ) * next( );
+
+  }
+
+
+  std::uint32_t index( std::uint32_t count )
+  {
+
+    return std::min( static_cast< std::uint32_t >( next( ) * count ), count - 1 );
+
+  }
+
+
+  Float3 direction( )
+  {
+
+    float z   = range( -1.0f, 1.0f );
+    float phi = range( 0.0f, 2.0f * pi );
+    float r   = std::sqrt( std::max( 0.0f, 1.0f - z * z ) );
+
+    return Float3 { r * std::cos( phi ), r * std::sin( phi ), z };
+
+  }
+
+
+private:
+
+  std::uint64_t state_;
+
+};
+
+
+Float3
+add(
+    Float3 a,
+    Float3 b
+    )
+{
+
+  return Float3 { a.x + b.x, a.y + b.y, a.z + b.z };
+
+}
+
+
+Float3
+scale(
+      Float3 a,
+      float  s
+      )
+{
+
+  return Float3 { a.x * s, a.y * s, a.z * s };
+
+}
+
+
+Float3
+crossProduct(
+             Float3 a,
+             Float3 b
+             )
+{
+
+  return Float3 { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+
+}
+
+
+Float3
+unitLength( Float3 v )
+{
+
+  float length = std::sqrt( v.x * v.x + v.y * v.y + v.z * v.z );
+
+  return length > 0.0f ? scale( v, 1.0f / length ) : Float3 { 0.0f, 1.0f, 0.0f };
+
+}
+
+
+///
+/// \brief addBlobMesh
+///
+///        Sphere tessellated into 'rings' bands of 2 'rings'
+///        quads, two triangles each
+///
+std::uint32_t
+addBlobMesh(
+            SceneDescription *pScene,
+            unsigned          rings
+            )
+{
+
+  rings = std::max( 2u, rings );
+
+  unsigned segments = rings * 2;
+
+  std::vector< Float3 >        vertices;
+  std::vector< Float3 >        normals;
+  std::vector< std::uint32_t > triangles;
+
+  for ( unsigned ring = 0; ring <= rings; ++ring )
+  {
+
+    float theta = pi * ring / rings;
+
+    for ( unsigned segment = 0; segment <= segments; ++segment )
+    {
+
+      float phi = 2.0f * pi * segment / segments;
+
+      Float3 normal = { std::sin( theta ) * std::cos( phi ), std::cos( theta ), std::sin( theta ) * std::sin( phi ) };
+
+      normals.push_back( normal );
+      vertices.push_back( normal );
+
+    }
+
+  }
+
+  for ( unsigned ring = 0; ring < rings; ++ring )
+  {
+
+    for ( unsigned segment = 0; segment < segments; ++segment )
+    {
+
+      std::uint32_t i0 = ring * ( segments + 1 ) + segment;
+      std::uint32_t i1 = i0 + segments + 1;
+
+      triangles.insert( triangles.end( ), { i0, i1, i0 + 1 } );
+      triangles.insert( triangles.end( ), { i0 + 1, i1, i1 + 1 } );
+
+    }
+
+  }
+
+  return pScene->addMesh( vertices, normals, triangles );
+
+}
+
+
+///
+/// \brief addObjMesh
+///
+///        Loads a mesh centered and scaled to fit a 2 x 2 x 2
+///        box like the procedural one
+///
+std::uint32_t
+addObjMesh(
+           SceneDescription  *pScene,
+           const std::string &filename
+           )
+{
+
+  ObjMesh mesh = loadObjMesh( filename );
+
+  if ( mesh.vertices.empty( ) )
+  {
+
+    throw std::runtime_error( "Stress scene mesh has no vertices: " + filename );
+
+  }
+
+  Float3 low  = mesh.vertices.front( );
+  Float3 high = mesh.vertices.front( );
+
+  for ( const Float3 &v : mesh.vertices )
+  {
+
+    low  = Float3 { std::min( low.x, v.x ), std::min( low.y, v.y ), std::min( low.z, v.z ) };
+    high = Float3 { std::max( high.x, v.x ), std::max( high.y, v.y ), std::max( high.z, v.z ) };
+
+  }
+
+  Float3 center = scale( add( low, high ), 0.5f );
+  float  extent = std::max( { high.x - low.x, high.y - low.y, high.z - low.z, 1e-6f } );
+
+  for ( Float3 &v : mesh.vertices )
+  {
+    v = scale( add( v, scale( center, -1.0f ) ), 2.0f / extent );
+  }
+
+  return pScene->addMesh( mesh.vertices, mesh.normals, mesh.triangles );
+
+}
+
+
+///
+/// \brief addGroupedShapes
+///
+///        One shape per material holding every primitive that
+///        drew it
+///
+void
+addGroupedShapes(
+                 SceneDescription                   *pScene,
+                 const std::string                  &kind,
+                 const std::vector< std::uint32_t > &primitives,
+                 const std::vector< std::uint32_t > &materials,
+                 StressRandom                       *pRandom
+                 )
+{
+
+  std::vector< std::vector< std::uint32_t > > byMaterial( materials.size( ) );
+
+  for ( std::uint32_t primitive : primitives )
+  {
+    byMaterial[ pRandom->index( static_cast< std::uint32_t >( materials.size( ) ) ) ].push_back( primitive );
+  }
+
+  for ( std::size_t m = 0; m < materials.size( ); ++m )
+  {
+
+    if ( !byMaterial[ m ].empty( ) )
+    {
+
+      pScene->addShape(
+                       kind + " " + std::to_string( m ),
+                       byMaterial[ m ],
+                       materials[ m ],
+                       makeTransform( ),
+                       AccelHint::BVH
+                       );
+
+    }
+
+  }
+
+}
+
+
+} // namespace
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief buildStressScene
+///////////////////////////////////////////////////////////////
+SceneDescription
+buildStressScene( const StressSceneOptions &options )
+{
+
+  LIGHT_TRACE_SCOPE( "stressScene", "load" );
+
+  SceneDescription scene;
+  StressRandom     random( options.seed );
+
+  unsigned objects = options.spheres + options.boxes + options.quads + options.meshInstances;
+
+  float side = std::max( 10.0f, objectSpacing * std::cbrt( static_cast< float >( objects ) ) );
+
+  auto position = [ & ]( )
+                  {
+                    return Float3 {
+                      random.range( -0.5f, 0.5f ) * side,
+                      random.range( 0.5f, side * 0.5f ),
+                      random.range( -0.5f, 0.5f ) * side
+                    };
+                  };
+
+  //
+  // materials
+  //
+  std::vector< std::uint32_t > materials;
+
+  for ( unsigned m = 0; m < std::max( 1u, options.materials ); ++m )
+  {
+
+    Float3 albedo    = { random.range( 0.2f, 0.9f ), random.range( 0.2f, 0.9f ), random.range( 0.2f, 0.9f ) };
+    float  roughness = random.range( 0.05f, 0.8f );
+    float  ior       = random.range( 1.0f, 1.8f );
+
+    materials.push_back( scene.addMaterial( albedo, roughness, Float3 { ior, ior, ior } ) );
+
+  }
+
+  //
+  // analytic primitives
+  //
+  std::vector< std::uint32_t > spheres;
+
+  for ( unsigned i = 0; i < options.spheres; ++i )
+  {
+
+    float radius = random.range( 0.2f, 0.6f );
+    spheres.push_back( scene.addSphere( position( ), radius ) );
+
+  }
+
+  std::vector< std::uint32_t > boxes;
+
+  for ( unsigned i = 0; i < options.boxes; ++i )
+  {
+
+    Float3 center = position( );
+    Float3 half   = { random.range( 0.2f, 0.6f ), random.range( 0.2f, 0.6f ), random.range( 0.2f, 0.6f ) };
+
+    boxes.push_back( scene.addBox( add( center, scale( half, -1.0f ) ), add( center, half ) ) );
+
+  }
+
+  std::vector< std::uint32_t > quads;
+
+  for ( unsigned i = 0; i < options.quads; ++i )
+  {
+
+    Float3 anchor = position( );
+    Float3 v1     = scale( random.direction( ), random.range( 0.5f, 1.5f ) );
+    Float3 v2     = scale( unitLength( crossProduct( v1, random.direction( ) ) ), random.range( 0.5f, 1.5f ) );
+
+    quads.push_back( scene.addQuad( anchor, v1, v2 ) );
+
+  }
+
+  addGroupedShapes( &scene, "sphere", spheres, materials, &random );
+  addGroupedShapes( &scene, "box",    boxes,   materials, &random );
+  addGroupedShapes( &scene, "quad",   quads,   materials, &random );
+
+  //
+  // instanced mesh
+  //
+  if ( options.meshInstances > 0 )
+  {
+
+    std::uint32_t meshPrim = options.meshFile.empty( )
+                             ? addBlobMesh( &scene, options.meshRings )
+                             : addObjMesh( &scene, options.meshFile );
+
+    std::uint32_t source = 0;
+
+    for ( unsigned i = 0; i < options.meshInstances; ++i )
+    {
+
+      Transform transform = makeTransform(
+                                          position( ),
+                                          scale( Float3 { 1.0f, 1.0f, 1.0f }, random.range( 0.3f, 0.8f ) ),
+                                          random.range( 0.0f, 2.0f * pi ),
+                                          random.direction( )
+                                          );
+
+      std::uint32_t material = materials[ random.index( static_cast< std::uint32_t >( materials.size( ) ) ) ];
+
+      if ( i == 0 )
+      {
+        source = scene.addShape( "mesh 0", { meshPrim }, material, transform, AccelHint::BVH );
+      }
+      else
+      {
+        scene.addInstance( "mesh " + std::to_string( i ), source, material, transform );
+      }
+
+    }
+
+  }
+
+  //
+  // ground and lights
+  //
+  std::uint32_t quadPrim   = scene.addQuad( );
+  std::uint32_t spherePrim = scene.addSphere( );
+
+  scene.addShape(
+                 "ground",
+                 { quadPrim },
+                 materials.front( ),
+                 makeTransform(
+                               Float3 { 0.0f, 0.0f, 0.0f },
+                               Float3 { side, side, 1.0f },
+                               pi * 0.5f,
+                               Float3 { 1.0f, 0.0f, 0.0f }
+                               )
+                 );
+
+  // the basic scene's 1000 W light, spread over the lights and
+  // scaled with the floor so the image brightness doesn't change
+  float flux = 1000.0f * ( side / 10.0f ) * ( side / 10.0f ) / std::max( 1u, options.illuminators );
+
+  for ( unsigned i = 0; i < options.illuminators; ++i )
+  {
+
+    IlluminatorRecord illuminator;
+    illuminator.center      = Float3 { random.range( -0.5f, 0.5f ) * side, side * 0.75f, random.range( -0.5f, 0.5f ) * side };
+    illuminator.radiantFlux = Float3 { flux, flux, flux };
+    illuminator.shape       = 0; // LightShape::SPHERE
+    illuminator.radius      = 0.1f;
+
+    scene.addSphereIlluminator( "light " + std::to_string( i ), illuminator, spherePrim );
+
+  }
+
+  return scene;
+
+} // buildStressScene
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief parseStressSceneOptions
+///////////////////////////////////////////////////////////////
+StressSceneOptions
+parseStressSceneOptions( const std::string &spec )
+{
+
+  StressSceneOptions options;
+
+  std::stringstream pairs( spec );
+  std::string       pair;
+
+  while ( std::getline( pairs, pair, ',' ) )
+  {
+
+    if ( pair.empty( ) )
+    {
+      continue;
+    }
+
+    std::size_t equals = pair.find( '=' );
+
+    if ( equals == std::string::npos )
+    {
+
+      throw std::runtime_error( "Stress scene options are name=value pairs: " + pair );
+
+    }
+
+    std::string name  = pair.substr( 0, equals );
+    std::string value = pair.substr( equals + 1 );
+
+    if ( name == "mesh" )
+    {
+
+      options.meshFile = value;
+      continue;
+
+    }
+
+    char          *pEnd   = nullptr;
+    unsigned long  number = std::strtoul( value.c_str( ), &pEnd, 10 );
+
+    if ( value.empty( ) || *pEnd != '\0' )
+    {
+
+      throw std::runtime_error( "Stress scene option " + name + " needs a whole number: " + value );
+
+    }
+
+
+    if      ( name == "spheres" )       { options.spheres       = static_cast< unsigned >( number ); }
+    else if ( name == "boxes" )         { options.boxes         = static_cast< unsigned >( number ); }
+    else if ( name == "quads" )         { options.quads         = static_cast< unsigned >( number ); }
+    else if ( name == "meshInstances" ) { options.meshInstances = static_cast< unsigned >( number ); }
+    else if ( name == "meshRings" )     { options.meshRings     = static_cast< unsigned >( number ); }
+    else if ( name == "illuminators" )  { options.illuminators  = static_cast< unsigned >( number ); }
+    else if ( name == "materials" )     { options.materials     = static_cast< unsigned >( number ); }
+    else if ( name == "seed" )          { options.seed          = static_cast< std::uint32_t >( number ); }
+    else
+    {
+
+      throw std::runtime_error( "Unknown stress scene option " + name );
+
+    }
+
+  }
+
+  return options;
+
+} // parseStressSceneOptions
+
+
+
+} // namespace light
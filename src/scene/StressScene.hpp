@@ -0,0 +1,63 @@
+#ifndef StressScene_hpp
+#define StressScene_hpp
+
+
+#include <string>
+#include <cstdint>
+#include "SceneDescription.hpp"
+
+
+namespace light
+{
+
+
+/////////////////////////////////////////////
+/// \brief The StressSceneOptions struct
+///
+///        Sizes of a generated scene. Objects are scattered
+///        through a cube that grows with their count so the
+///        density, and with it the work per ray, stays about
+///        the same at every scale.
+/////////////////////////////////////////////
+struct StressSceneOptions
+{
+  unsigned spheres       = 100;
+  unsigned boxes         = 100;
+  unsigned quads         = 20;
+  unsigned meshInstances = 10;
+  unsigned meshRings     = 16; // procedural mesh has 4 rings^2 triangles
+  unsigned illuminators  = 4;
+  unsigned materials     = 16;
+
+  std::uint32_t seed = 1;
+
+  std::string meshFile; // OBJ instanced instead of the procedural mesh, "mesh=" in specs
+};
+
+
+///////////////////////////////////////////////////////////////
+/// \brief buildStressScene
+///
+///        Spheres, boxes and quads each split into one shape per
+///        material (so every shape's bottom level holds many
+///        primitives), instanced copies of one mesh, sphere
+///        lights above the objects and a ground quad. The same
+///        options and seed always give the same scene on every
+///        platform.
+///////////////////////////////////////////////////////////////
+SceneDescription buildStressScene ( const StressSceneOptions &options );
+
+
+///////////////////////////////////////////////////////////////
+/// \brief parseStressSceneOptions
+/// \param spec comma separated name=value pairs named like the
+///        option fields, "spheres=1000,illuminators=16,seed=7";
+///        fields not given keep their defaults
+///////////////////////////////////////////////////////////////
+StressSceneOptions parseStressSceneOptions ( const std::string &spec );
+
+
+} // namespace light
+
+
+#endif // StressScene_hpp
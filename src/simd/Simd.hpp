@@ -0,0 +1,729 @@
+#ifndef Simd_hpp
+#define Simd_hpp
+
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <math.h>
+
+
+/////////////////////////////////////////////
+///        Instruction set of the including translation unit.
+///
+///        Every vector type lives in a namespace named after it
+///        (simd_scalar, simd_sse4, simd_avx2, simd_avx512), so
+///        the same kernel source compiled once per instruction
+///        set gives distinct symbols and one binary can hold all
+///        of them. LIGHT_SIMD_WIDTH is the widest native vector.
+///
+///        LIGHT_SIMD_TARGET (0 scalar to 3 AVX-512) caps the
+///        choice, so the per instruction set kernel files stay
+///        distinct when the whole build targets a newer CPU.
+/////////////////////////////////////////////
+#if !defined( LIGHT_SIMD_TARGET )
+#define LIGHT_SIMD_TARGET 3
+#endif
+
+#if LIGHT_SIMD_TARGET >= 3 && defined( __AVX512F__ )
+
+#include <immintrin.h>
+#define LIGHT_SIMD_NAMESPACE simd_avx512
+#define LIGHT_SIMD_WIDTH     16
+#define LIGHT_SIMD_HAS_SSE4
+#define LIGHT_SIMD_HAS_AVX2
+#define LIGHT_SIMD_HAS_AVX512
+
+#elif LIGHT_SIMD_TARGET >= 2 && defined( __AVX2__ ) && ( defined( __FMA__ ) || defined( _MSC_VER ) )
+
+#include <immintrin.h>
+#define LIGHT_SIMD_NAMESPACE simd_avx2
+#define LIGHT_SIMD_WIDTH     8
+#define LIGHT_SIMD_HAS_SSE4
+#define LIGHT_SIMD_HAS_AVX2
+
+#elif LIGHT_SIMD_TARGET >= 1 && ( defined( __SSE4_1__ ) || defined( LIGHT_SIMD_SSE4 ) ) // MSVC has no SSE4 switch
+
+#include <smmintrin.h>
+#define LIGHT_SIMD_NAMESPACE simd_sse4
+#define LIGHT_SIMD_WIDTH     4
+#define LIGHT_SIMD_HAS_SSE4
+
+#else
+
+#define LIGHT_SIMD_NAMESPACE simd_scalar
+#define LIGHT_SIMD_WIDTH     1
+
+#endif
+
+
+namespace light
+{
+
+namespace LIGHT_SIMD_NAMESPACE
+{
+
+
+/////////////////////////////////////////////
+/// \brief The VMask, VInt and VFloat templates
+///
+///        N lanes of booleans, 32 bit integers and floats. The
+///        generic versions are plain arrays the compiler may
+///        vectorize; 4, 8 and 16 lanes are specialized with
+///        SSE4.1, AVX2 and AVX-512F intrinsics when the
+///        translation unit is compiled for them.
+///
+///        Lanewise operators and free functions work the same on
+///        every width: min and max return the second argument
+///        when either is NaN, toInt truncates, shifts are
+///        logical and scalars are broadcast explicitly, e.g.
+///        a * VFloat< N >( 2.0f ).
+/////////////////////////////////////////////
+template< int N >
+struct VMask
+{
+  bool v[ N ];
+
+  VMask( ) = default;
+
+  explicit
+  VMask( bool value ) { for ( int i = 0; i < N; ++i ) { v[ i ] = value; } }
+
+  bool operator[]( int i ) const { return v[ i ]; }
+};
+
+
+template< int N >
+struct VInt
+{
+  std::int32_t v[ N ];
+
+  VInt( ) = default;
+
+  VInt( std::int32_t value ) { for ( int i = 0; i < N; ++i ) { v[ i ] = value; } }
+
+  static VInt load( const std::int32_t *p ) { VInt r; std::memcpy( r.v, p, sizeof( r.v ) ); return r; }
+
+  void store( std::int32_t *p ) const { std::memcpy( p, v, sizeof( v ) ); }
+
+  static VInt sequence( ) { VInt r; for ( int i = 0; i < N; ++i ) { r.v[ i ] = i; } return r; }
+
+  std::int32_t operator[]( int i ) const { return v[ i ]; }
+};
+
+
+template< int N >
+struct VFloat
+{
+  float v[ N ];
+
+  VFloat( ) = default;
+
+  VFloat( float value ) { for ( int i = 0; i < N; ++i ) { v[ i ] = value; } }
+
+  static VFloat load( const float *p ) { VFloat r; std::memcpy( r.v, p, sizeof( r.v ) ); return r; }
+
+  void store( float *p ) const { std::memcpy( p, v, sizeof( v ) ); }
+
+  float operator[]( int i ) const { return v[ i ]; }
+};
+
+
+// single lane math; kept in this namespace rather than calling
+// std:: inline functions, whose out of line copies could be
+// compiled for a wider instruction set than the caller's
+#if defined( _MSC_VER ) && !defined( __clang__ )
+inline float sqrtLane ( float x ) { return static_cast< float >( ::sqrt( x ) ); }
+inline float floorLane( float x ) { return static_cast< float >( ::floor( x ) ); }
+#else
+inline float sqrtLane ( float x ) { return __builtin_sqrtf( x ); }
+inline float floorLane( float x ) { return __builtin_floorf( x ); }
+#endif
+
+
+// lanewise loops for the generic versions
+#define LIGHT_SIMD_LANES( Result, expression ) \
+  Result r;                                    \
+  for ( int i = 0; i < N; ++i )                \
+  {                                            \
+    r.v[ i ] = expression;                     \
+  }                                            \
+  return r;
+
+
+template< int N > VFloat< N > operator+( VFloat< N > a, VFloat< N > b ) { LIGHT_SIMD_LANES( VFloat< N >, a.v[ i ] + b.v[ i ] ) }
+template< int N > VFloat< N > operator-( VFloat< N > a, VFloat< N > b ) { LIGHT_SIMD_LANES( VFloat< N >, a.v[ i ] - b.v[ i ] ) }
+template< int N > VFloat< N > operator*( VFloat< N > a, VFloat< N > b ) { LIGHT_SIMD_LANES( VFloat< N >, a.v[ i ] * b.v[ i ] ) }
+template< int N > VFloat< N > operator/( VFloat< N > a, VFloat< N > b ) { LIGHT_SIMD_LANES( VFloat< N >, a.v[ i ] / b.v[ i ] ) }
+template< int N > VFloat< N > operator-( VFloat< N > a )                { LIGHT_SIMD_LANES( VFloat< N >, -a.v[ i ] ) }
+
+template< int N > VFloat< N > min  ( VFloat< N > a, VFloat< N > b ) { LIGHT_SIMD_LANES( VFloat< N >, a.v[ i ] < b.v[ i ] ? a.v[ i ] : b.v[ i ] ) }
+template< int N > VFloat< N > max  ( VFloat< N > a, VFloat< N > b ) { LIGHT_SIMD_LANES( VFloat< N >, a.v[ i ] > b.v[ i ] ? a.v[ i ] : b.v[ i ] ) }
+template< int N > VFloat< N > abs  ( VFloat< N > a )                { LIGHT_SIMD_LANES( VFloat< N >, a.v[ i ] < 0.0f ? -a.v[ i ] : a.v[ i ] ) }
+template< int N > VFloat< N > sqrt ( VFloat< N > a )                { LIGHT_SIMD_LANES( VFloat< N >, sqrtLane( a.v[ i ] ) ) }
+template< int N > VFloat< N > floor( VFloat< N > a )                { LIGHT_SIMD_LANES( VFloat< N >, floorLane( a.v[ i ] ) ) }
+
+template< int N >
+VFloat< N >
+fmadd(
+      VFloat< N > a,
+      VFloat< N > b,
+      VFloat< N > c
+      )
+{
+  LIGHT_SIMD_LANES( VFloat< N >, a.v[ i ] * b.v[ i ] + c.v[ i ] )
+}
+
+template< int N > VMask< N > operator< ( VFloat< N > a, VFloat< N > b ) { LIGHT_SIMD_LANES( VMask< N >, a.v[ i ] <  b.v[ i ] ) }
+template< int N > VMask< N > operator<=( VFloat< N > a, VFloat< N > b ) { LIGHT_SIMD_LANES( VMask< N >, a.v[ i ] <= b.v[ i ] ) }
+template< int N > VMask< N > operator> ( VFloat< N > a, VFloat< N > b ) { LIGHT_SIMD_LANES( VMask< N >, a.v[ i ] >  b.v[ i ] ) }
+template< int N > VMask< N > operator>=( VFloat< N > a, VFloat< N > b ) { LIGHT_SIMD_LANES( VMask< N >, a.v[ i ] >= b.v[ i ] ) }
+template< int N > VMask< N > operator==( VFloat< N > a, VFloat< N > b ) { LIGHT_SIMD_LANES( VMask< N >, a.v[ i ] == b.v[ i ] ) }
+template< int N > VMask< N > operator!=( VFloat< N > a, VFloat< N > b ) { LIGHT_SIMD_LANES( VMask< N >, a.v[ i ] != b.v[ i ] ) }
+
+template< int N >
+VFloat< N >
+select(
+       VMask< N >  m,
+       VFloat< N > a,
+       VFloat< N > b
+       )
+{
+  LIGHT_SIMD_LANES( VFloat< N >, m.v[ i ] ? a.v[ i ] : b.v[ i ] )
+}
+
+template< int N > VInt< N >   toInt  ( VFloat< N > a ) { LIGHT_SIMD_LANES( VInt< N >,   static_cast< std::int32_t >( a.v[ i ] ) ) }
+template< int N > VFloat< N > toFloat( VInt< N > a )   { LIGHT_SIMD_LANES( VFloat< N >, static_cast< float >( a.v[ i ] ) ) }
+
+template< int N > VInt< N >   asInt  ( VFloat< N > a ) { VInt< N >   r; std::memcpy( r.v, a.v, sizeof( r.v ) ); return r; }
+template< int N > VFloat< N > asFloat( VInt< N > a )   { VFloat< N > r; std::memcpy( r.v, a.v, sizeof( r.v ) ); return r; }
+
+template< int N > VInt< N > operator+( VInt< N > a, VInt< N > b ) { LIGHT_SIMD_LANES( VInt< N >, static_cast< std::int32_t >( static_cast< std::uint32_t >( a.v[ i ] ) + static_cast< std::uint32_t >( b.v[ i ] ) ) ) }
+template< int N > VInt< N > operator-( VInt< N > a, VInt< N > b ) { LIGHT_SIMD_LANES( VInt< N >, static_cast< std::int32_t >( static_cast< std::uint32_t >( a.v[ i ] ) - static_cast< std::uint32_t >( b.v[ i ] ) ) ) }
+template< int N > VInt< N > operator*( VInt< N > a, VInt< N > b ) { LIGHT_SIMD_LANES( VInt< N >, static_cast< std::int32_t >( static_cast< std::uint32_t >( a.v[ i ] ) * static_cast< std::uint32_t >( b.v[ i ] ) ) ) }
+template< int N > VInt< N > operator&( VInt< N > a, VInt< N > b ) { LIGHT_SIMD_LANES( VInt< N >, a.v[ i ] & b.v[ i ] ) }
+template< int N > VInt< N > operator|( VInt< N > a, VInt< N > b ) { LIGHT_SIMD_LANES( VInt< N >, a.v[ i ] | b.v[ i ] ) }
+template< int N > VInt< N > operator^( VInt< N > a, VInt< N > b ) { LIGHT_SIMD_LANES( VInt< N >, a.v[ i ] ^ b.v[ i ] ) }
+
+template< int N > VInt< N > operator<<( VInt< N > a, int n ) { LIGHT_SIMD_LANES( VInt< N >, static_cast< std::int32_t >( static_cast< std::uint32_t >( a.v[ i ] ) << n ) ) }
+template< int N > VInt< N > operator>>( VInt< N > a, int n ) { LIGHT_SIMD_LANES( VInt< N >, static_cast< std::int32_t >( static_cast< std::uint32_t >( a.v[ i ] ) >> n ) ) }
+
+template< int N > VMask< N > operator==( VInt< N > a, VInt< N > b ) { LIGHT_SIMD_LANES( VMask< N >, a.v[ i ] == b.v[ i ] ) }
+template< int N > VMask< N > operator< ( VInt< N > a, VInt< N > b ) { LIGHT_SIMD_LANES( VMask< N >, a.v[ i ] <  b.v[ i ] ) }
+template< int N > VMask< N > operator> ( VInt< N > a, VInt< N > b ) { LIGHT_SIMD_LANES( VMask< N >, a.v[ i ] >  b.v[ i ] ) }
+
+template< int N >
+VInt< N >
+select(
+       VMask< N > m,
+       VInt< N >  a,
+       VInt< N >  b
+       )
+{
+  LIGHT_SIMD_LANES( VInt< N >, m.v[ i ] ? a.v[ i ] : b.v[ i ] )
+}
+
+template< int N > VMask< N > operator&( VMask< N > a, VMask< N > b ) { LIGHT_SIMD_LANES( VMask< N >, a.v[ i ] && b.v[ i ] ) }
+template< int N > VMask< N > operator|( VMask< N > a, VMask< N > b ) { LIGHT_SIMD_LANES( VMask< N >, a.v[ i ] || b.v[ i ] ) }
+template< int N > VMask< N > operator^( VMask< N > a, VMask< N > b ) { LIGHT_SIMD_LANES( VMask< N >, a.v[ i ] != b.v[ i ] ) }
+template< int N > VMask< N > operator!( VMask< N > a )               { LIGHT_SIMD_LANES( VMask< N >, !a.v[ i ] ) }
+
+///
+/// \brief bits
+/// \return lane i of the mask in bit i
+///
+template< int N >
+std::uint32_t
+bits( VMask< N > m )
+{
+
+  std::uint32_t result = 0;
+
+  for ( int i = 0; i < N; ++i )
+  {
+    result |= m.v[ i ] ? 1u << i : 0u;
+  }
+
+  return result;
+
+}
+
+
+///
+/// \brief reduceAdd
+/// \return sum of the lanes, added in lane order
+///
+template< int N >
+float
+reduceAdd( VFloat< N > a )
+{
+
+  float lanes[ N ];
+  a.store( lanes );
+
+  float sum = lanes[ 0 ];
+
+  for ( int i = 1; i < N; ++i )
+  {
+    sum += lanes[ i ];
+  }
+
+  return sum;
+
+}
+
+
+#undef LIGHT_SIMD_LANES
+
+
+// width independent helpers built on the operations above
+template< int N > VFloat< N > &operator+=( VFloat< N > &a, VFloat< N > b ) { return a = a + b; }
+template< int N > VFloat< N > &operator-=( VFloat< N > &a, VFloat< N > b ) { return a = a - b; }
+template< int N > VFloat< N > &operator*=( VFloat< N > &a, VFloat< N > b ) { return a = a * b; }
+template< int N > VInt< N >   &operator+=( VInt< N > &a, VInt< N > b )     { return a = a + b; }
+
+template< int N > bool any ( VMask< N > m ) { return bits( m ) != 0u; }
+template< int N > bool none( VMask< N > m ) { return bits( m ) == 0u; }
+template< int N > bool all ( VMask< N > m ) { return bits( m ) == ( 1u << N ) - 1u; }
+
+template< int N > VFloat< N > rcp  ( VFloat< N > a ) { return VFloat< N >( 1.0f ) / a; }
+template< int N > VFloat< N > rsqrt( VFloat< N > a ) { return VFloat< N >( 1.0f ) / sqrt( a ); }
+
+template< int N >
+VFloat< N >
+clamp(
+      VFloat< N > a,
+      VFloat< N > low,
+      VFloat< N > high
+      )
+{
+  return min( max( a, low ), high );
+}
+
+
+///
+/// \brief loadPartial
+/// \return the first 'count' values from p, 'fill' in the other
+///         lanes, for the ends of arrays
+///
+template< int N >
+VFloat< N >
+loadPartial(
+            const float *p,
+            std::size_t  count,
+            float        fill = 0.0f
+            )
+{
+
+  float lanes[ N ];
+
+  for ( int i = 0; i < N; ++i )
+  {
+    lanes[ i ] = static_cast< std::size_t >( i ) < count ? p[ i ] : fill;
+  }
+
+  return VFloat< N >::load( lanes );
+
+}
+
+
+template< int N >
+void
+storePartial(
+             VFloat< N >  a,
+             float       *p,
+             std::size_t  count
+             )
+{
+
+  float lanes[ N ];
+  a.store( lanes );
+
+  for ( int i = 0; i < N && static_cast< std::size_t >( i ) < count; ++i )
+  {
+    p[ i ] = lanes[ i ];
+  }
+
+}
+
+
+
+#if defined( LIGHT_SIMD_HAS_SSE4 )
+
+//
+// 4 lanes, SSE4.1
+//
+template< >
+struct VMask< 4 >
+{
+  __m128 m;
+
+  VMask( ) = default;
+
+  explicit
+  VMask( __m128 value ) : m( value ) {}
+
+  explicit
+  VMask( bool value ) : m( _mm_castsi128_ps( _mm_set1_epi32( value ? -1 : 0 ) ) ) {}
+
+  bool operator[]( int i ) const { return ( _mm_movemask_ps( m ) >> i ) & 1; }
+};
+
+
+template< >
+struct VInt< 4 >
+{
+  __m128i m;
+
+  VInt( ) = default;
+
+  explicit
+  VInt( __m128i value ) : m( value ) {}
+
+  VInt( std::int32_t value ) : m( _mm_set1_epi32( value ) ) {}
+
+  static VInt load( const std::int32_t *p ) { return VInt( _mm_loadu_si128( reinterpret_cast< const __m128i* >( p ) ) ); }
+
+  void store( std::int32_t *p ) const { _mm_storeu_si128( reinterpret_cast< __m128i* >( p ), m ); }
+
+  static VInt sequence( ) { return VInt( _mm_setr_epi32( 0, 1, 2, 3 ) ); }
+
+  std::int32_t operator[]( int i ) const { std::int32_t lanes[ 4 ]; store( lanes ); return lanes[ i ]; }
+};
+
+
+template< >
+struct VFloat< 4 >
+{
+  __m128 m;
+
+  VFloat( ) = default;
+
+  explicit
+  VFloat( __m128 value ) : m( value ) {}
+
+  VFloat( float value ) : m( _mm_set1_ps( value ) ) {}
+
+  static VFloat load( const float *p ) { return VFloat( _mm_loadu_ps( p ) ); }
+
+  void store( float *p ) const { _mm_storeu_ps( p, m ); }
+
+  float operator[]( int i ) const { float lanes[ 4 ]; store( lanes ); return lanes[ i ]; }
+};
+
+
+inline VFloat< 4 > operator+( VFloat< 4 > a, VFloat< 4 > b ) { return VFloat< 4 >( _mm_add_ps( a.m, b.m ) ); }
+inline VFloat< 4 > operator-( VFloat< 4 > a, VFloat< 4 > b ) { return VFloat< 4 >( _mm_sub_ps( a.m, b.m ) ); }
+inline VFloat< 4 > operator*( VFloat< 4 > a, VFloat< 4 > b ) { return VFloat< 4 >( _mm_mul_ps( a.m, b.m ) ); }
+inline VFloat< 4 > operator/( VFloat< 4 > a, VFloat< 4 > b ) { return VFloat< 4 >( _mm_div_ps( a.m, b.m ) ); }
+inline VFloat< 4 > operator-( VFloat< 4 > a )                { return VFloat< 4 >( _mm_xor_ps( a.m, _mm_set1_ps( -0.0f ) ) ); }
+
+inline VFloat< 4 > min  ( VFloat< 4 > a, VFloat< 4 > b ) { return VFloat< 4 >( _mm_min_ps( a.m, b.m ) ); }
+inline VFloat< 4 > max  ( VFloat< 4 > a, VFloat< 4 > b ) { return VFloat< 4 >( _mm_max_ps( a.m, b.m ) ); }
+inline VFloat< 4 > abs  ( VFloat< 4 > a )                { return VFloat< 4 >( _mm_andnot_ps( _mm_set1_ps( -0.0f ), a.m ) ); }
+inline VFloat< 4 > sqrt ( VFloat< 4 > a )                { return VFloat< 4 >( _mm_sqrt_ps( a.m ) ); }
+inline VFloat< 4 > floor( VFloat< 4 > a )                { return VFloat< 4 >( _mm_floor_ps( a.m ) ); }
+
+inline VFloat< 4 > fmadd( VFloat< 4 > a, VFloat< 4 > b, VFloat< 4 > c ) { return VFloat< 4 >( _mm_add_ps( _mm_mul_ps( a.m, b.m ), c.m ) ); }
+
+inline VMask< 4 > operator< ( VFloat< 4 > a, VFloat< 4 > b ) { return VMask< 4 >( _mm_cmplt_ps( a.m, b.m ) ); }
+inline VMask< 4 > operator<=( VFloat< 4 > a, VFloat< 4 > b ) { return VMask< 4 >( _mm_cmple_ps( a.m, b.m ) ); }
+inline VMask< 4 > operator> ( VFloat< 4 > a, VFloat< 4 > b ) { return VMask< 4 >( _mm_cmpgt_ps( a.m, b.m ) ); }
+inline VMask< 4 > operator>=( VFloat< 4 > a, VFloat< 4 > b ) { return VMask< 4 >( _mm_cmpge_ps( a.m, b.m ) ); }
+inline VMask< 4 > operator==( VFloat< 4 > a, VFloat< 4 > b ) { return VMask< 4 >( _mm_cmpeq_ps( a.m, b.m ) ); }
+inline VMask< 4 > operator!=( VFloat< 4 > a, VFloat< 4 > b ) { return VMask< 4 >( _mm_cmpneq_ps( a.m, b.m ) ); }
+
+inline VFloat< 4 > select( VMask< 4 > m, VFloat< 4 > a, VFloat< 4 > b ) { return VFloat< 4 >( _mm_blendv_ps( b.m, a.m, m.m ) ); }
+
+inline VInt< 4 >   toInt  ( VFloat< 4 > a ) { return VInt< 4 >( _mm_cvttps_epi32( a.m ) ); }
+inline VFloat< 4 > toFloat( VInt< 4 > a )   { return VFloat< 4 >( _mm_cvtepi32_ps( a.m ) ); }
+inline VInt< 4 >   asInt  ( VFloat< 4 > a ) { return VInt< 4 >( _mm_castps_si128( a.m ) ); }
+inline VFloat< 4 > asFloat( VInt< 4 > a )   { return VFloat< 4 >( _mm_castsi128_ps( a.m ) ); }
+
+inline VInt< 4 > operator+( VInt< 4 > a, VInt< 4 > b ) { return VInt< 4 >( _mm_add_epi32( a.m, b.m ) ); }
+inline VInt< 4 > operator-( VInt< 4 > a, VInt< 4 > b ) { return VInt< 4 >( _mm_sub_epi32( a.m, b.m ) ); }
+inline VInt< 4 > operator*( VInt< 4 > a, VInt< 4 > b ) { return VInt< 4 >( _mm_mullo_epi32( a.m, b.m ) ); }
+inline VInt< 4 > operator&( VInt< 4 > a, VInt< 4 > b ) { return VInt< 4 >( _mm_and_si128( a.m, b.m ) ); }
+inline VInt< 4 > operator|( VInt< 4 > a, VInt< 4 > b ) { return VInt< 4 >( _mm_or_si128( a.m, b.m ) ); }
+inline VInt< 4 > operator^( VInt< 4 > a, VInt< 4 > b ) { return VInt< 4 >( _mm_xor_si128( a.m, b.m ) ); }
+
+inline VInt< 4 > operator<<( VInt< 4 > a, int n ) { return VInt< 4 >( _mm_sll_epi32( a.m, _mm_cvtsi32_si128( n ) ) ); }
+inline VInt< 4 > operator>>( VInt< 4 > a, int n ) { return VInt< 4 >( _mm_srl_epi32( a.m, _mm_cvtsi32_si128( n ) ) ); }
+
+inline VMask< 4 > operator==( VInt< 4 > a, VInt< 4 > b ) { return VMask< 4 >( _mm_castsi128_ps( _mm_cmpeq_epi32( a.m, b.m ) ) ); }
+inline VMask< 4 > operator< ( VInt< 4 > a, VInt< 4 > b ) { return VMask< 4 >( _mm_castsi128_ps( _mm_cmplt_epi32( a.m, b.m ) ) ); }
+inline VMask< 4 > operator> ( VInt< 4 > a, VInt< 4 > b ) { return VMask< 4 >( _mm_castsi128_ps( _mm_cmpgt_epi32( a.m, b.m ) ) ); }
+
+inline VInt< 4 > select( VMask< 4 > m, VInt< 4 > a, VInt< 4 > b )
+{
+  return VInt< 4 >( _mm_castps_si128( _mm_blendv_ps( _mm_castsi128_ps( b.m ), _mm_castsi128_ps( a.m ), m.m ) ) );
+}
+
+inline VMask< 4 > operator&( VMask< 4 > a, VMask< 4 > b ) { return VMask< 4 >( _mm_and_ps( a.m, b.m ) ); }
+inline VMask< 4 > operator|( VMask< 4 > a, VMask< 4 > b ) { return VMask< 4 >( _mm_or_ps( a.m, b.m ) ); }
+inline VMask< 4 > operator^( VMask< 4 > a, VMask< 4 > b ) { return VMask< 4 >( _mm_xor_ps( a.m, b.m ) ); }
+inline VMask< 4 > operator!( VMask< 4 > a )               { return VMask< 4 >( _mm_xor_ps( a.m, _mm_castsi128_ps( _mm_set1_epi32( -1 ) ) ) ); }
+
+inline std::uint32_t bits( VMask< 4 > m ) { return static_cast< std::uint32_t >( _mm_movemask_ps( m.m ) ); }
+
+#endif // LIGHT_SIMD_HAS_SSE4
+
+
+
+#if defined( LIGHT_SIMD_HAS_AVX2 )
+
+//
+// 8 lanes, AVX2 and FMA
+//
+template< >
+struct VMask< 8 >
+{
+  __m256 m;
+
+  VMask( ) = default;
+
+  explicit
+  VMask( __m256 value ) : m( value ) {}
+
+  explicit
+  VMask( bool value ) : m( _mm256_castsi256_ps( _mm256_set1_epi32( value ? -1 : 0 ) ) ) {}
+
+  bool operator[]( int i ) const { return ( _mm256_movemask_ps( m ) >> i ) & 1; }
+};
+
+
+template< >
+struct VInt< 8 >
+{
+  __m256i m;
+
+  VInt( ) = default;
+
+  explicit
+  VInt( __m256i value ) : m( value ) {}
+
+  VInt( std::int32_t value ) : m( _mm256_set1_epi32( value ) ) {}
+
+  static VInt load( const std::int32_t *p ) { return VInt( _mm256_loadu_si256( reinterpret_cast< const __m256i* >( p ) ) ); }
+
+  void store( std::int32_t *p ) const { _mm256_storeu_si256( reinterpret_cast< __m256i* >( p ), m ); }
+
+  static VInt sequence( ) { return VInt( _mm256_setr_epi32( 0, 1, 2, 3, 4, 5, 6, 7 ) ); }
+
+  std::int32_t operator[]( int i ) const { std::int32_t lanes[ 8 ]; store( lanes ); return lanes[ i ]; }
+};
+
+
+template< >
+struct VFloat< 8 >
+{
+  __m256 m;
+
+  VFloat( ) = default;
+
+  explicit
+  VFloat( __m256 value ) : m( value ) {}
+
+  VFloat( float value ) : m( _mm256_set1_ps( value ) ) {}
+
+  static VFloat load( const float *p ) { return VFloat( _mm256_loadu_ps( p ) ); }
+
+  void store( float *p ) const { _mm256_storeu_ps( p, m ); }
+
+  float operator[]( int i ) const { float lanes[ 8 ]; store( lanes ); return lanes[ i ]; }
+};
+
+
+inline VFloat< 8 > operator+( VFloat< 8 > a, VFloat< 8 > b ) { return VFloat< 8 >( _mm256_add_ps( a.m, b.m ) ); }
+inline VFloat< 8 > operator-( VFloat< 8 > a, VFloat< 8 > b ) { return VFloat< 8 >( _mm256_sub_ps( a.m, b.m ) ); }
+inline VFloat< 8 > operator*( VFloat< 8 > a, VFloat< 8 > b ) { return VFloat< 8 >( _mm256_mul_ps( a.m, b.m ) ); }
+inline VFloat< 8 > operator/( VFloat< 8 > a, VFloat< 8 > b ) { return VFloat< 8 >( _mm256_div_ps( a.m, b.m ) ); }
+inline VFloat< 8 > operator-( VFloat< 8 > a )                { return VFloat< 8 >( _mm256_xor_ps( a.m, _mm256_set1_ps( -0.0f ) ) ); }
+
+inline VFloat< 8 > min  ( VFloat< 8 > a, VFloat< 8 > b ) { return VFloat< 8 >( _mm256_min_ps( a.m, b.m ) ); }
+inline VFloat< 8 > max  ( VFloat< 8 > a, VFloat< 8 > b ) { return VFloat< 8 >( _mm256_max_ps( a.m, b.m ) ); }
+inline VFloat< 8 > abs  ( VFloat< 8 > a )                { return VFloat< 8 >( _mm256_andnot_ps( _mm256_set1_ps( -0.0f ), a.m ) ); }
+inline VFloat< 8 > sqrt ( VFloat< 8 > a )                { return VFloat< 8 >( _mm256_sqrt_ps( a.m ) ); }
+inline VFloat< 8 > floor( VFloat< 8 > a )                { return VFloat< 8 >( _mm256_floor_ps( a.m ) ); }
+
+inline VFloat< 8 > fmadd( VFloat< 8 > a, VFloat< 8 > b, VFloat< 8 > c ) { return VFloat< 8 >( _mm256_fmadd_ps( a.m, b.m, c.m ) ); }
+
+inline VMask< 8 > operator< ( VFloat< 8 > a, VFloat< 8 > b ) { return VMask< 8 >( _mm256_cmp_ps( a.m, b.m, _CMP_LT_OQ ) ); }
+inline VMask< 8 > operator<=( VFloat< 8 > a, VFloat< 8 > b ) { return VMask< 8 >( _mm256_cmp_ps( a.m, b.m, _CMP_LE_OQ ) ); }
+inline VMask< 8 > operator> ( VFloat< 8 > a, VFloat< 8 > b ) { return VMask< 8 >( _mm256_cmp_ps( a.m, b.m, _CMP_GT_OQ ) ); }
+inline VMask< 8 > operator>=( VFloat< 8 > a, VFloat< 8 > b ) { return VMask< 8 >( _mm256_cmp_ps( a.m, b.m, _CMP_GE_OQ ) ); }
+inline VMask< 8 > operator==( VFloat< 8 > a, VFloat< 8 > b ) { return VMask< 8 >( _mm256_cmp_ps( a.m, b.m, _CMP_EQ_OQ ) ); }
+inline VMask< 8 > operator!=( VFloat< 8 > a, VFloat< 8 > b ) { return VMask< 8 >( _mm256_cmp_ps( a.m, b.m, _CMP_NEQ_UQ ) ); }
+
+inline VFloat< 8 > select( VMask< 8 > m, VFloat< 8 > a, VFloat< 8 > b ) { return VFloat< 8 >( _mm256_blendv_ps( b.m, a.m, m.m ) ); }
+
+inline VInt< 8 >   toInt  ( VFloat< 8 > a ) { return VInt< 8 >( _mm256_cvttps_epi32( a.m ) ); }
+inline VFloat< 8 > toFloat( VInt< 8 > a )   { return VFloat< 8 >( _mm256_cvtepi32_ps( a.m ) ); }
+inline VInt< 8 >   asInt  ( VFloat< 8 > a ) { return VInt< 8 >( _mm256_castps_si256( a.m ) ); }
+inline VFloat< 8 > asFloat( VInt< 8 > a )   { return VFloat< 8 >( _mm256_castsi256_ps( a.m ) ); }
+
+inline VInt< 8 > operator+( VInt< 8 > a, VInt< 8 > b ) { return VInt< 8 >( _mm256_add_epi32( a.m, b.m ) ); }
+inline VInt< 8 > operator-( VInt< 8 > a, VInt< 8 > b ) { return VInt< 8 >( _mm256_sub_epi32( a.m, b.m ) ); }
+inline VInt< 8 > operator*( VInt< 8 > a, VInt< 8 > b ) { return VInt< 8 >( _mm256_mullo_epi32( a.m, b.m ) ); }
+inline VInt< 8 > operator&( VInt< 8 > a, VInt< 8 > b ) { return VInt< 8 >( _mm256_and_si256( a.m, b.m ) ); }
+inline VInt< 8 > operator|( VInt< 8 > a, VInt< 8 > b ) { return VInt< 8 >( _mm256_or_si256( a.m, b.m ) ); }
+inline VInt< 8 > operator^( VInt< 8 > a, VInt< 8 > b ) { return VInt< 8 >( _mm256_xor_si256( a.m, b.m ) ); }
+
+inline VInt< 8 > operator<<( VInt< 8 > a, int n ) { return VInt< 8 >( _mm256_sll_epi32( a.m, _mm_cvtsi32_si128( n ) ) ); }
+inline VInt< 8 > operator>>( VInt< 8 > a, int n ) { return VInt< 8 >( _mm256_srl_epi32( a.m, _mm_cvtsi32_si128( n ) ) ); }
+
+inline VMask< 8 > operator==( VInt< 8 > a, VInt< 8 > b ) { return VMask< 8 >( _mm256_castsi256_ps( _mm256_cmpeq_epi32( a.m, b.m ) ) ); }
+inline VMask< 8 > operator< ( VInt< 8 > a, VInt< 8 > b ) { return VMask< 8 >( _mm256_castsi256_ps( _mm256_cmpgt_epi32( b.m, a.m ) ) ); }
+inline VMask< 8 > operator> ( VInt< 8 > a, VInt< 8 > b ) { return VMask< 8 >( _mm256_castsi256_ps( _mm256_cmpgt_epi32( a.m, b.m ) ) ); }
+
+inline VInt< 8 > select( VMask< 8 > m, VInt< 8 > a, VInt< 8 > b )
+{
+  return VInt< 8 >( _mm256_castps_si256( _mm256_blendv_ps( _mm256_castsi256_ps( b.m ), _mm256_castsi256_ps( a.m ), m.m ) ) );
+}
+
+inline VMask< 8 > operator&( VMask< 8 > a, VMask< 8 > b ) { return VMask< 8 >( _mm256_and_ps( a.m, b.m ) ); }
+inline VMask< 8 > operator|( VMask< 8 > a, VMask< 8 > b ) { return VMask< 8 >( _mm256_or_ps( a.m, b.m ) ); }
+inline VMask< 8 > operator^( VMask< 8 > a, VMask< 8 > b ) { return VMask< 8 >( _mm256_xor_ps( a.m, b.m ) ); }
+inline VMask< 8 > operator!( VMask< 8 > a )               { return VMask< 8 >( _mm256_xor_ps( a.m, _mm256_castsi256_ps( _mm256_set1_epi32( -1 ) ) ) ); }
+
+inline std::uint32_t bits( VMask< 8 > m ) { return static_cast< std::uint32_t >( _mm256_movemask_ps( m.m ) ); }
+
+#endif // LIGHT_SIMD_HAS_AVX2
+
+
+
+#if defined( LIGHT_SIMD_HAS_AVX512 )
+
+//
+// 16 lanes, AVX-512F only, so float logic goes through integers
+//
+template< >
+struct VMask< 16 >
+{
+  __mmask16 m;
+
+  VMask( ) = default;
+
+  explicit
+  VMask( __mmask16 value ) : m( value ) {}
+
+  explicit
+  VMask( bool value ) : m( static_cast< __mmask16 >( value ? 0xffff : 0 ) ) {}
+
+  bool operator[]( int i ) const { return ( m >> i ) & 1; }
+};
+
+
+template< >
+struct VInt< 16 >
+{
+  __m512i m;
+
+  VInt( ) = default;
+
+  explicit
+  VInt( __m512i value ) : m( value ) {}
+
+  VInt( std::int32_t value ) : m( _mm512_set1_epi32( value ) ) {}
+
+  static VInt load( const std::int32_t *p ) { return VInt( _mm512_loadu_si512( p ) ); }
+
+  void store( std::int32_t *p ) const { _mm512_storeu_si512( p, m ); }
+
+  static VInt sequence( ) { return VInt( _mm512_setr_epi32( 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 ) ); }
+
+  std::int32_t operator[]( int i ) const { std::int32_t lanes[ 16 ]; store( lanes ); return lanes[ i ]; }
+};
+
+
+template< >
+struct VFloat< 16 >
+{
+  __m512 m;
+
+  VFloat( ) = default;
+
+  explicit
+  VFloat( __m512 value ) : m( value ) {}
+
+  VFloat( float value ) : m( _mm512_set1_ps( value ) ) {}
+
+  static VFloat load( const float *p ) { return VFloat( _mm512_loadu_ps( p ) ); }
+
+  void store( float *p ) const { _mm512_storeu_ps( p, m ); }
+
+  float operator[]( int i ) const { float lanes[ 16 ]; store( lanes ); return lanes[ i ]; }
+};
+
+
+inline VFloat< 16 > operator+( VFloat< 16 > a, VFloat< 16 > b ) { return VFloat< 16 >( _mm512_add_ps( a.m, b.m ) ); }
+inline VFloat< 16 > operator-( VFloat< 16 > a, VFloat< 16 > b ) { return VFloat< 16 >( _mm512_sub_ps( a.m, b.m ) ); }
+inline VFloat< 16 > operator*( VFloat< 16 > a, VFloat< 16 > b ) { return VFloat< 16 >( _mm512_mul_ps( a.m, b.m ) ); }
+inline VFloat< 16 > operator/( VFloat< 16 > a, VFloat< 16 > b ) { return VFloat< 16 >( _mm512_div_ps( a.m, b.m ) ); }
+
+inline VFloat< 16 > operator-( VFloat< 16 > a )
+{
+  return VFloat< 16 >( _mm512_castsi512_ps( _mm512_xor_si512( _mm512_castps_si512( a.m ), _mm512_set1_epi32( static_cast< int >( 0x80000000u ) ) ) ) );
+}
+
+inline VFloat< 16 > min  ( VFloat< 16 > a, VFloat< 16 > b ) { return VFloat< 16 >( _mm512_min_ps( a.m, b.m ) ); }
+inline VFloat< 16 > max  ( VFloat< 16 > a, VFloat< 16 > b ) { return VFloat< 16 >( _mm512_max_ps( a.m, b.m ) ); }
+inline VFloat< 16 > abs  ( VFloat< 16 > a )                 { return VFloat< 16 >( _mm512_abs_ps( a.m ) ); }
+inline VFloat< 16 > sqrt ( VFloat< 16 > a )                 { return VFloat< 16 >( _mm512_sqrt_ps( a.m ) ); }
+inline VFloat< 16 > floor( VFloat< 16 > a )                 { return VFloat< 16 >( _mm512_roundscale_ps( a.m, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC ) ); }
+
+inline VFloat< 16 > fmadd( VFloat< 16 > a, VFloat< 16 > b, VFloat< 16 > c ) { return VFloat< 16 >( _mm512_fmadd_ps( a.m, b.m, c.m ) ); }
+
+inline VMask< 16 > operator< ( VFloat< 16 > a, VFloat< 16 > b ) { return VMask< 16 >( _mm512_cmp_ps_mask( a.m, b.m, _CMP_LT_OQ ) ); }
+inline VMask< 16 > operator<=( VFloat< 16 > a, VFloat< 16 > b ) { return VMask< 16 >( _mm512_cmp_ps_mask( a.m, b.m, _CMP_LE_OQ ) ); }
+inline VMask< 16 > operator> ( VFloat< 16 > a, VFloat< 16 > b ) { return VMask< 16 >( _mm512_cmp_ps_mask( a.m, b.m, _CMP_GT_OQ ) ); }
+inline VMask< 16 > operator>=( VFloat< 16 > a, VFloat< 16 > b ) { return VMask< 16 >( _mm512_cmp_ps_mask( a.m, b.m, _CMP_GE_OQ ) ); }
+inline VMask< 16 > operator==( VFloat< 16 > a, VFloat< 16 > b ) { return VMask< 16 >( _mm512_cmp_ps_mask( a.m, b.m, _CMP_EQ_OQ ) ); }
+inline VMask< 16 > operator!=( VFloat< 16 > a, VFloat< 16 > b ) { return VMask< 16 >( _mm512_cmp_ps_mask( a.m, b.m, _CMP_NEQ_UQ ) ); }
+
+inline VFloat< 16 > select( VMask< 16 > m, VFloat< 16 > a, VFloat< 16 > b ) { return VFloat< 16 >( _mm512_mask_blend_ps( m.m, b.m, a.m ) ); }
+
+inline VInt< 16 >   toInt  ( VFloat< 16 > a ) { return VInt< 16 >( _mm512_cvttps_epi32( a.m ) ); }
+inline VFloat< 16 > toFloat( VInt< 16 > a )   { return VFloat< 16 >( _mm512_cvtepi32_ps( a.m ) ); }
+inline VInt< 16 >   asInt  ( VFloat< 16 > a ) { return VInt< 16 >( _mm512_castps_si512( a.m ) ); }
+inline VFloat< 16 > asFloat( VInt< 16 > a )   { return VFloat< 16 >( _mm512_castsi512_ps( a.m ) ); }
+
+inline VInt< 16 > operator+( VInt< 16 > a, VInt< 16 > b ) { return VInt< 16 >( _mm512_add_epi32( a.m, b.m ) ); }
+inline VInt< 16 > operator-( VInt< 16 > a, VInt< 16 > b ) { return VInt< 16 >( _mm512_sub_epi32( a.m, b.m ) ); }
+inline VInt< 16 > operator*( VInt< 16 > a, VInt< 16 > b ) { return VInt< 16 >( _mm512_mullo_epi32( a.m, b.m ) ); }
+inline VInt< 16 > operator&( VInt< 16 > a, VInt< 16 > b ) { return VInt< 16 >( _mm512_and_si512( a.m, b.m ) ); }
+inline VInt< 16 > operator|( VInt< 16 > a, VInt< 16 > b ) { return VInt< 16 >( _mm512_or_si512( a.m, b.m ) ); }
+inline VInt< 16 > operator^( VInt< 16 > a, VInt< 16 > b ) { return VInt< 16 >( _mm512_xor_si512( a.m, b.m ) ); }
+
+inline VInt< 16 > operator<<( VInt< 16 > a, int n ) { return VInt< 16 >( _mm512_sll_epi32( a.m, _mm_cvtsi32_si128( n ) ) ); }
+inline VInt< 16 > operator>>( VInt< 16 > a, int n ) { return VInt< 16 >( _mm512_srl_epi32( a.m, _mm_cvtsi32_si128( n ) ) ); }
+
+inline VMask< 16 > operator==( VInt< 16 > a, VInt< 16 > b ) { return VMask< 16 >( _mm512_cmpeq_epi32_mask( a.m, b.m ) ); }
+inline VMask< 16 > operator< ( VInt< 16 > a, VInt< 16 > b ) { return VMask< 16 >( _mm512_cmplt_epi32_mask( a.m, b.m ) ); }
+inline VMask< 16 > operator> ( VInt< 16 > a, VInt< 16 > b ) { return VMask< 16 >( _mm512_cmpgt_epi32_mask( a.m, b.m ) ); }
+
+inline VInt< 16 > select( VMask< 16 > m, VInt< 16 > a, VInt< 16 > b ) { return VInt< 16 >( _mm512_mask_blend_epi32( m.m, b.m, a.m ) ); }
+
+inline VMask< 16 > operator&( VMask< 16 > a, VMask< 16 > b ) { return VMask< 16 >( static_cast< __mmask16 >( a.m & b.m ) ); }
+inline VMask< 16 > operator|( VMask< 16 > a, VMask< 16 > b ) { return VMask< 16 >( static_cast< __mmask16 >( a.m | b.m ) ); }
+inline VMask< 16 > operator^( VMask< 16 > a, VMask< 16 > b ) { return VMask< 16 >( static_cast< __mmask16 >( a.m ^ b.m ) ); }
+inline VMask< 16 > operator!( VMask< 16 > a )                { return VMask< 16 >( static_cast< __mmask16 >( ~a.m ) ); }
+
+inline std::uint32_t bits( VMask< 16 > m ) { return static_cast< std::uint32_t >( m.m ); }
+
+#endif // LIGHT_SIMD_HAS_AVX512
+
+
+
+// native vectors of this translation unit
+typedef VFloat< LIGHT_SIMD_WIDTH > VFloatN;
+typedef VInt< LIGHT_SIMD_WIDTH >   VIntN;
+typedef VMask< LIGHT_SIMD_WIDTH >  VMaskN;
+
+
+} // namespace LIGHT_SIMD_NAMESPACE
+
+} // namespace light
+
+
+#endif // Simd_hpp
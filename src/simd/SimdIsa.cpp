@@ -0,0 +1,387 @@
+#include "SimdIsa.hpp"
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <stdexcept>
+
+#if defined( LIGHT_SIMD_X86 )
+#if defined( _MSC_VER )
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+
+namespace light
+{
+
+
+namespace
+{
+
+
+// -1 when nothing is forced
+std::atomic< int > forcedIsa( -1 );
+
+// -1 when nothing is preferred
+std::atomic< int > preferredIsa( -1 );
+
+
+#if defined( LIGHT_SIMD_X86 )
+
+
+void
+cpuid(
+      unsigned      leaf,
+      unsigned      subleaf,
+      std::uint32_t registers[ 4 ] // eax, ebx, ecx, edx
+      )
+{
+
+#if defined( _MSC_VER )
+
+  int values[ 4 ];
+  __cpuidex( values, static_cast< int >( leaf ), static_cast< int >( subleaf ) );
+
+  for ( int i = 0; i < 4; ++i )
+  {
+    registers[ i ] = static_cast< std::uint32_t >( values[ i ] );
+  }
+
+#else
+
+  unsigned a = 0, b = 0, c = 0, d = 0;
+  __cpuid_count( leaf, subleaf, a, b, c, d );
+
+  registers[ 0 ] = a;
+  registers[ 1 ] = b;
+  registers[ 2 ] = c;
+  registers[ 3 ] = d;
+
+#endif
+
+}
+
+
+///
+/// \brief getEnabledXState
+/// \return XCR0, the register states the OS saves on context
+///         switches; wide registers are only usable when it does
+///
+std::uint64_t
+getEnabledXState( )
+{
+
+#if defined( _MSC_VER )
+
+  return _xgetbv( 0 );
+
+#else
+
+  std::uint32_t low = 0, high = 0;
+  __asm__ volatile ( "xgetbv" : "=a" ( low ), "=d" ( high ) : "c" ( 0 ) );
+
+  return ( static_cast< std::uint64_t >( high ) << 32 ) | low;
+
+#endif
+
+}
+
+
+SimdIsa
+detect( )
+{
+
+  std::uint32_t registers[ 4 ];
+
+  cpuid( 0, 0, registers );
+  unsigned maxLeaf = registers[ 0 ];
+
+  if ( maxLeaf < 1 )
+  {
+    return SimdIsa::SCALAR;
+  }
+
+  cpuid( 1, 0, registers );
+
+  bool sse41   = ( registers[ 2 ] >> 19 ) & 1u;
+  bool fma     = ( registers[ 2 ] >> 12 ) & 1u;
+  bool osxsave = ( registers[ 2 ] >> 27 ) & 1u;
+  bool avx     = ( registers[ 2 ] >> 28 ) & 1u;
+
+  if ( !sse41 )
+  {
+    return SimdIsa::SCALAR;
+  }
+
+  if ( !osxsave || !avx || maxLeaf < 7 )
+  {
+    return SimdIsa::SSE4;
+  }
+
+  std::uint64_t xstate = getEnabledXState( );
+
+  // XMM and YMM state, then opmask and both ZMM halves
+  bool ymmEnabled = ( xstate & 0x6u ) == 0x6u;
+  bool zmmEnabled = ( xstate & 0xe6u ) == 0xe6u;
+
+  cpuid( 7, 0, registers );
+
+  bool avx2    = ( registers[ 1 ] >> 5 ) & 1u;
+  bool avx512f = ( registers[ 1 ] >> 16 ) & 1u;
+
+  if ( !ymmEnabled || !avx2 || !fma )
+  {
+    return SimdIsa::SSE4;
+  }
+
+  if ( !zmmEnabled || !avx512f )
+  {
+    return SimdIsa::AVX2;
+  }
+
+  return SimdIsa::AVX512;
+
+}
+
+
+#else
+
+
+SimdIsa
+detect( )
+{
+
+  // only the portable kernels are built for other architectures
+  return SimdIsa::SCALAR;
+
+}
+
+
+#endif
+
+
+///
+/// \brief getEnvironmentIsa
+/// \return LIGHT_SIMD from the environment, or -1 if it isn't
+///         set or names an instruction set the CPU lacks
+///
+int
+getEnvironmentIsa( )
+{
+
+  const char *pName = std::getenv( "LIGHT_SIMD" );
+
+  if ( !pName || !*pName )
+  {
+    return -1;
+  }
+
+  SimdIsa isa = parseSimdIsa( pName );
+
+  return isSimdIsaSupported( isa ) ? static_cast< int >( isa ) : -1;
+
+}
+
+
+} // namespace
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief detectSimdIsa
+///////////////////////////////////////////////////////////////
+SimdIsa
+detectSimdIsa( )
+{
+
+  static const SimdIsa detected = detect( );
+
+  return detected;
+
+} // detectSimdIsa
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief getSimdIsa
+///////////////////////////////////////////////////////////////
+SimdIsa
+getSimdIsa( )
+{
+
+  int forced = forcedIsa.load( std::memory_order_relaxed );
+
+  if ( forced >= 0 )
+  {
+    return static_cast< SimdIsa >( forced );
+  }
+
+  static const int environment = getEnvironmentIsa( );
+
+  if ( environment >= 0 )
+  {
+    return static_cast< SimdIsa >( environment );
+  }
+
+  int preferred = preferredIsa.load( std::memory_order_relaxed );
+
+  if ( preferred >= 0 )
+  {
+    return static_cast< SimdIsa >( preferred );
+  }
+
+  return detectSimdIsa( );
+
+} // getSimdIsa
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief forceSimdIsa
+///////////////////////////////////////////////////////////////
+void
+forceSimdIsa( SimdIsa isa )
+{
+
+  if ( !isSimdIsaSupported( isa ) )
+  {
+
+    throw std::runtime_error( "This CPU doesn't support " + toString( isa ) + " (best is "
+                              + toString( detectSimdIsa( ) ) + ")" );
+
+  }
+
+  forcedIsa.store( static_cast< int >( isa ), std::memory_order_relaxed );
+
+} // forceSimdIsa
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief clearForcedSimdIsa
+///////////////////////////////////////////////////////////////
+void
+clearForcedSimdIsa( )
+{
+
+  forcedIsa.store( -1, std::memory_order_relaxed );
+
+} // clearForcedSimdIsa
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief preferSimdIsa
+///////////////////////////////////////////////////////////////
+void
+preferSimdIsa( SimdIsa isa )
+{
+
+  if ( !isSimdIsaSupported( isa ) )
+  {
+
+    throw std::runtime_error( "This CPU doesn't support " + toString( isa ) + " (best is "
+                              + toString( detectSimdIsa( ) ) + ")" );
+
+  }
+
+  preferredIsa.store( static_cast< int >( isa ), std::memory_order_relaxed );
+
+} // preferSimdIsa
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief clearPreferredSimdIsa
+///////////////////////////////////////////////////////////////
+void
+clearPreferredSimdIsa( )
+{
+
+  preferredIsa.store( -1, std::memory_order_relaxed );
+
+} // clearPreferredSimdIsa
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief isSimdIsaSupported
+///////////////////////////////////////////////////////////////
+bool
+isSimdIsaSupported( SimdIsa isa )
+{
+
+  return static_cast< int >( isa ) <= static_cast< int >( detectSimdIsa( ) );
+
+} // isSimdIsaSupported
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief getSimdWidth
+///////////////////////////////////////////////////////////////
+unsigned
+getSimdWidth( SimdIsa isa )
+{
+
+  switch ( isa )
+  {
+
+  case SimdIsa::SSE4:   return 4;
+  case SimdIsa::AVX2:   return 8;
+  case SimdIsa::AVX512: return 16;
+  default:              return 1;
+
+  } // switch
+
+} // getSimdWidth
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief toString
+///////////////////////////////////////////////////////////////
+std::string
+toString( SimdIsa isa )
+{
+
+  switch ( isa )
+  {
+
+  case SimdIsa::SSE4:   return "sse4";
+  case SimdIsa::AVX2:   return "avx2";
+  case SimdIsa::AVX512: return "avx512";
+  default:              return "scalar";
+
+  } // switch
+
+} // toString
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief parseSimdIsa
+///////////////////////////////////////////////////////////////
+SimdIsa
+parseSimdIsa( const std::string &name )
+{
+
+  for ( int i = 0; i <= static_cast< int >( SimdIsa::AVX512 ); ++i )
+  {
+
+    if ( name == toString( static_cast< SimdIsa >( i ) ) )
+    {
+      return static_cast< SimdIsa >( i );
+    }
+
+  }
+
+  throw std::runtime_error( "SIMD instruction sets are scalar, sse4, avx2 and avx512, not " + name );
+
+} // parseSimdIsa
+
+
+
+} // namespace light
@@ -0,0 +1,114 @@
+#ifndef SimdIsa_hpp
+#define SimdIsa_hpp
+
+
+#include <string>
+
+
+namespace light
+{
+
+
+/////////////////////////////////////////////
+/// \brief The SimdIsa enum
+///
+///        Instruction sets the SIMD kernels are compiled for,
+///        in increasing order of capability
+/////////////////////////////////////////////
+enum class SimdIsa
+{
+  SCALAR = 0,
+  SSE4   = 1, // SSE4.1, 4 lanes
+  AVX2   = 2, // AVX2 and FMA, 8 lanes
+  AVX512 = 3, // AVX-512F, 16 lanes
+};
+
+
+///////////////////////////////////////////////////////////////
+/// \brief detectSimdIsa
+/// \return the best instruction set this CPU and OS support,
+///         checked once with CPUID and XGETBV. Only instruction
+///         sets this build has kernels for are returned.
+///////////////////////////////////////////////////////////////
+SimdIsa detectSimdIsa ( );
+
+
+///////////////////////////////////////////////////////////////
+/// \brief getSimdIsa
+///
+///        The instruction set kernels are dispatched to: the
+///        forced one if set, else LIGHT_SIMD=<name> from the
+///        environment when this CPU supports it, else the
+///        preferred one if set, else the detected one
+///////////////////////////////////////////////////////////////
+SimdIsa getSimdIsa ( );
+
+
+///////////////////////////////////////////////////////////////
+/// \brief forceSimdIsa
+///
+///        Makes getSimdIsa return 'isa', so benchmarks and tests
+///        can compare code paths. Throws if this CPU doesn't
+///        support it.
+///////////////////////////////////////////////////////////////
+void forceSimdIsa ( SimdIsa isa );
+
+
+///////////////////////////////////////////////////////////////
+/// \brief clearForcedSimdIsa
+///
+///        Goes back to the environment, preferred or detected
+///        instruction set
+///////////////////////////////////////////////////////////////
+void clearForcedSimdIsa ( );
+
+
+///////////////////////////////////////////////////////////////
+/// \brief preferSimdIsa
+///
+///        Makes getSimdIsa return 'isa' instead of the detected
+///        one, e.g. the fastest measured by the host tuning.
+///        Forcing and LIGHT_SIMD still take precedence. Throws
+///        if this CPU doesn't support it.
+///////////////////////////////////////////////////////////////
+void preferSimdIsa ( SimdIsa isa );
+
+
+///////////////////////////////////////////////////////////////
+/// \brief clearPreferredSimdIsa
+///////////////////////////////////////////////////////////////
+void clearPreferredSimdIsa ( );
+
+
+///////////////////////////////////////////////////////////////
+/// \brief isSimdIsaSupported
+///////////////////////////////////////////////////////////////
+bool isSimdIsaSupported ( SimdIsa isa );
+
+
+///////////////////////////////////////////////////////////////
+/// \brief getSimdWidth
+/// \return float lanes per vector, 1 for SCALAR
+///////////////////////////////////////////////////////////////
+unsigned getSimdWidth ( SimdIsa isa );
+
+
+///////////////////////////////////////////////////////////////
+/// \brief toString
+/// \return scalar, sse4, avx2 or avx512
+///////////////////////////////////////////////////////////////
+std::string toString ( SimdIsa isa );
+
+
+///////////////////////////////////////////////////////////////
+/// \brief parseSimdIsa
+/// \return the instruction set named by toString, throws for
+///         other names
+///////////////////////////////////////////////////////////////
+SimdIsa parseSimdIsa ( const std::string &name );
+
+
+} // namespace light
+
+
+#endif // SimdIsa_hpp
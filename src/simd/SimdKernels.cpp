@@ -0,0 +1,72 @@
+#include "SimdKernels.hpp"
+#include <stdexcept>
+
+
+namespace light
+{
+
+
+// one table per SimdKernels<Isa>.cpp
+namespace simd_scalar { const SimdKernels &getKernels( ); }
+
+#if defined( LIGHT_SIMD_X86 )
+namespace simd_sse4   { const SimdKernels &getKernels( ); }
+namespace simd_avx2   { const SimdKernels &getKernels( ); }
+namespace simd_avx512 { const SimdKernels &getKernels( ); }
+#endif
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief getSimdKernels
+///////////////////////////////////////////////////////////////
+const SimdKernels&
+getSimdKernels( )
+{
+
+  return getSimdKernels( getSimdIsa( ) );
+
+} // getSimdKernels
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief getSimdKernels
+///////////////////////////////////////////////////////////////
+const SimdKernels&
+getSimdKernels( SimdIsa isa )
+{
+
+  if ( !isSimdIsaSupported( isa ) )
+  {
+
+    throw std::runtime_error( "No " + toString( isa ) + " kernels for this CPU" );
+
+  }
+
+  switch ( isa )
+  {
+
+#if defined( LIGHT_SIMD_X86 )
+
+  case SimdIsa::SSE4:
+    return simd_sse4::getKernels( );
+
+  case SimdIsa::AVX2:
+    return simd_avx2::getKernels( );
+
+  case SimdIsa::AVX512:
+    return simd_avx512::getKernels( );
+
+#endif
+
+  default:
+    return simd_scalar::getKernels( );
+
+  } // switch
+
+} // getSimdKernels
+
+
+
+} // namespace light
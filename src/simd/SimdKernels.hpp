@@ -0,0 +1,160 @@
+#ifndef SimdKernels_hpp
+#define SimdKernels_hpp
+
+
+#include <cstddef>
+#include <cstdint>
+#include "SimdIsa.hpp"
+
+
+namespace light
+{
+
+
+/////////////////////////////////////////////
+/// \brief The SimdVectors and SimdConstVectors structs
+///
+///        Three component vectors stored as separate x, y and z
+///        arrays, so the kernels load whole vectors per lane
+/////////////////////////////////////////////
+struct SimdVectors
+{
+  float *pX;
+  float *pY;
+  float *pZ;
+};
+
+
+struct SimdConstVectors
+{
+  const float *pX;
+  const float *pY;
+  const float *pZ;
+};
+
+
+/////////////////////////////////////////////
+/// \brief The SimdKernels struct
+///
+///        Vectorized host loops compiled once per instruction set
+///        (SimdKernelsImpl.hpp), picked at run time by
+///        getSimdKernels. Every version gives the same results up
+///        to float rounding in sums, whose order depends on the
+///        vector width, and fused multiply-adds.
+/////////////////////////////////////////////
+struct SimdKernels
+{
+  SimdIsa isa;
+
+  ///
+  /// \brief rgbaToRgb8
+  ///
+  ///        Float RGBA pixels to 8 bit RGB, each value times 255
+  ///        clamped to [0, 255] and truncated like writePPM
+  ///
+  void ( *rgbaToRgb8 )(
+                       const float  *pRgba,
+                       std::size_t   pixels,
+                       std::uint8_t *pRgb
+                       );
+
+  ///
+  /// \brief squaredErrors
+  ///
+  ///        Sums over the RGB channels of a row of squared errors
+  ///        and of squared errors over reference^2 + epsilon
+  ///
+  void ( *squaredErrors )(
+                          const float *pTest,
+                          const float *pReference,
+                          std::size_t  pixels,
+                          float        epsilon,
+                          float       *pSquared,
+                          float       *pRelative
+                          );
+
+  ///
+  /// \brief sampleCosineHemisphere
+  ///
+  ///        Cosine weighted directions around unit normals from
+  ///        pairs of uniform numbers, and their densities
+  ///        (Sampling.hpp's sampleCosineHemisphere and
+  ///        alignToNormal)
+  ///
+  void ( *sampleCosineHemisphere )(
+                                   const float      *pU1,
+                                   const float      *pU2,
+                                   SimdConstVectors  normals,
+                                   std::size_t       count,
+                                   SimdVectors       directions,
+                                   float            *pPdfs
+                                   );
+
+  ///
+  /// \brief sampleUniformSphere
+  ///
+  ///        Directions uniform over the sphere, density 1 / 4 pi
+  ///
+  void ( *sampleUniformSphere )(
+                                const float *pU1,
+                                const float *pU2,
+                                std::size_t  count,
+                                SimdVectors  directions
+                                );
+
+  ///
+  /// \brief sampleUniformCone
+  ///
+  ///        Directions uniform within pCosMax[ i ] of unit axes,
+  ///        e.g. towards spherical lights, and their densities
+  ///
+  void ( *sampleUniformCone )(
+                              const float      *pU1,
+                              const float      *pU2,
+                              const float      *pCosMax,
+                              SimdConstVectors  axes,
+                              std::size_t       count,
+                              SimdVectors       directions,
+                              float            *pPdfs
+                              );
+
+  ///
+  /// \brief sampleGgxVndf
+  ///
+  ///        GGX microfacet normals visible from the unit view
+  ///        directions (pointing away from the surface, on the
+  ///        normals' side) with roughness pAlpha[ i ], and their
+  ///        densities
+  ///
+  void ( *sampleGgxVndf )(
+                          const float      *pU1,
+                          const float      *pU2,
+                          const float      *pAlpha,
+                          SimdConstVectors  normals,
+                          SimdConstVectors  views,
+                          std::size_t       count,
+                          SimdVectors       halfVectors,
+                          float            *pPdfs
+                          );
+};
+
+
+///////////////////////////////////////////////////////////////
+/// \brief getSimdKernels
+/// \return the kernels for getSimdIsa( )
+///////////////////////////////////////////////////////////////
+const SimdKernels &getSimdKernels ( );
+
+
+///////////////////////////////////////////////////////////////
+/// \brief getSimdKernels
+/// \return the kernels for 'isa', throws if this CPU doesn't
+///         support it
+///////////////////////////////////////////////////////////////
+const SimdKernels &getSimdKernels ( SimdIsa isa );
+
+
+} // namespace light
+
+
+#endif // SimdKernels_hpp
@@ -0,0 +1,7 @@
+// AVX2 and FMA kernels; CMakeLists.txt enables the instruction set for this file
+#define LIGHT_SIMD_TARGET 2
+#include "SimdKernelsImpl.hpp"
+
+#if LIGHT_SIMD_WIDTH != 8
+#error "SimdKernelsAvx2.cpp must be compiled with AVX2 and FMA enabled"
+#endif
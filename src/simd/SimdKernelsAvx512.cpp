@@ -0,0 +1,7 @@
+// AVX-512F kernels; CMakeLists.txt enables the instruction set for this file
+#define LIGHT_SIMD_TARGET 3
+#include "SimdKernelsImpl.hpp"
+
+#if LIGHT_SIMD_WIDTH != 16
+#error "SimdKernelsAvx512.cpp must be compiled with AVX-512F enabled"
+#endif
@@ -0,0 +1,430 @@
+#ifndef SimdKernelsImpl_hpp
+#define SimdKernelsImpl_hpp
+
+
+/////////////////////////////////////////////
+///        Kernel bodies, included once by each
+///        SimdKernels<Isa>.cpp. Only use the vector types and
+///        helpers from Simd.hpp here: out of line copies of
+///        std:: inline functions from a wide instruction set
+///        file could be shared with callers on older CPUs.
+/////////////////////////////////////////////
+#include "Simd.hpp"
+#include "SimdKernels.hpp"
+#include "SimdSampling.hpp"
+
+
+namespace light
+{
+
+namespace LIGHT_SIMD_NAMESPACE
+{
+
+
+namespace
+{
+
+
+constexpr int width = LIGHT_SIMD_WIDTH;
+
+
+constexpr SimdIsa
+thisIsa( )
+{
+
+  return width == 16 ? SimdIsa::AVX512
+         : width == 8 ? SimdIsa::AVX2
+         : width == 4 ? SimdIsa::SSE4
+         : SimdIsa::SCALAR;
+
+}
+
+
+///
+/// \brief isAlpha
+/// \return lanes holding alpha when the vector starts at float
+///         'offset' of an RGBA array
+///
+VMaskN
+isAlpha( std::size_t offset )
+{
+
+  VIntN channel = ( VIntN( static_cast< std::int32_t >( offset & 3u ) ) + VIntN::sequence( ) ) & VIntN( 3 );
+
+  return channel == VIntN( 3 );
+
+}
+
+
+///
+/// \brief packRgb
+///
+///        Writes the colour bytes of 'lanes' converted floats
+///        starting at float 'offset', skipping alpha
+///
+void
+packRgb(
+        VFloatN        value,
+        std::size_t    offset,
+        std::size_t    lanes,
+        std::uint8_t *&pRgb
+        )
+{
+
+  VIntN        bytes = toInt( clamp( value * VFloatN( 255.0f ), VFloatN( 0.0f ), VFloatN( 255.0f ) ) );
+  std::int32_t values[ width ];
+
+  bytes.store( values );
+
+  for ( std::size_t l = 0; l < lanes; ++l )
+  {
+
+    if ( ( ( offset + l ) & 3u ) != 3u )
+    {
+      *pRgb++ = static_cast< std::uint8_t >( values[ l ] );
+    }
+
+  }
+
+}
+
+
+void
+rgbaToRgb8(
+           const float  *pRgba,
+           std::size_t   pixels,
+           std::uint8_t *pRgb
+           )
+{
+
+  std::size_t count = pixels * 4;
+  std::size_t full  = count - count % width;
+
+  for ( std::size_t i = 0; i < full; i += width )
+  {
+    packRgb( VFloatN::load( pRgba + i ), i, width, pRgb );
+  }
+
+  if ( full < count )
+  {
+    packRgb( loadPartial< width >( pRgba + full, count - full ), full, count - full, pRgb );
+  }
+
+}
+
+
+void
+squaredErrors(
+              const float *pTest,
+              const float *pReference,
+              std::size_t  pixels,
+              float        epsilon,
+              float       *pSquared,
+              float       *pRelative
+              )
+{
+
+  std::size_t count = pixels * 4;
+  std::size_t full  = count - count % width;
+
+  VFloatN squared( 0.0f );
+  VFloatN relative( 0.0f );
+
+  // vectors of whole pixels always have alpha in the same lanes
+  const VMaskN alphaLanes = isAlpha( 0 );
+
+  auto accumulate = [ &squared, &relative, &alphaLanes, epsilon ]( VFloatN test, VFloatN reference, std::size_t offset )
+  {
+
+    VFloatN difference = select( width % 4 == 0 ? alphaLanes : isAlpha( offset ), VFloatN( 0.0f ), test - reference );
+    VFloatN error      = difference * difference;
+
+    squared  += error;
+    relative += error / fmadd( reference, reference, VFloatN( epsilon ) );
+
+  };
+
+  for ( std::size_t i = 0; i < full; i += width )
+  {
+    accumulate( VFloatN::load( pTest + i ), VFloatN::load( pReference + i ), i );
+  }
+
+  // zero padding past the end adds nothing to either sum
+  if ( full < count )
+  {
+
+    accumulate(
+               loadPartial< width >( pTest + full,      count - full ),
+               loadPartial< width >( pReference + full, count - full ),
+               full
+               );
+
+  }
+
+  *pSquared  = reduceAdd( squared );
+  *pRelative = reduceAdd( relative );
+
+}
+
+
+///
+/// \brief forEachBlock
+///
+///        Calls block( first, lanes ) for every full vector of
+///        'count' elements, then once for the partial one left
+///
+template< typename Block >
+void
+forEachBlock(
+             std::size_t count,
+             Block       block
+             )
+{
+
+  std::size_t full = count - count % width;
+
+  for ( std::size_t i = 0; i < full; i += width )
+  {
+    block( i, static_cast< std::size_t >( width ) );
+  }
+
+  if ( full < count )
+  {
+    block( full, count - full );
+  }
+
+}
+
+
+VFloatN
+loadLanes(
+          const float *p,
+          std::size_t  lanes,
+          float        fill
+          )
+{
+
+  return lanes == width ? VFloatN::load( p ) : loadPartial< width >( p, lanes, fill );
+
+}
+
+
+void
+storeLanes(
+           VFloatN      value,
+           float       *p,
+           std::size_t  lanes
+           )
+{
+
+  if ( lanes == width )
+  {
+    value.store( p );
+  }
+  else
+  {
+    storePartial( value, p, lanes );
+  }
+
+}
+
+
+// partial vectors are padded with +z, so no lane divides by zero
+VVector3< width >
+loadVectors(
+            SimdConstVectors vectors,
+            std::size_t      first,
+            std::size_t      lanes
+            )
+{
+
+  VVector3< width > v = {
+    loadLanes( vectors.pX + first, lanes, 0.0f ),
+    loadLanes( vectors.pY + first, lanes, 0.0f ),
+    loadLanes( vectors.pZ + first, lanes, 1.0f )
+  };
+
+  return v;
+
+}
+
+
+void
+storeVectors(
+             const VVector3< width > &v,
+             SimdVectors              vectors,
+             std::size_t              first,
+             std::size_t              lanes
+             )
+{
+
+  storeLanes( v.x, vectors.pX + first, lanes );
+  storeLanes( v.y, vectors.pY + first, lanes );
+  storeLanes( v.z, vectors.pZ + first, lanes );
+
+}
+
+
+void
+sampleCosineHemisphereBatch(
+                            const float      *pU1,
+                            const float      *pU2,
+                            SimdConstVectors  normals,
+                            std::size_t       count,
+                            SimdVectors       directions,
+                            float            *pPdfs
+                            )
+{
+
+  forEachBlock( count, [ = ]( std::size_t first, std::size_t lanes )
+  {
+
+    VVector3< width > local = sampleCosineHemisphere(
+                                                     loadLanes( pU1 + first, lanes, 0.5f ),
+                                                     loadLanes( pU2 + first, lanes, 0.5f )
+                                                     );
+
+    storeVectors( alignToNormal( local, loadVectors( normals, first, lanes ) ), directions, first, lanes );
+    storeLanes( local.z * VFloatN( SAMPLING_INV_PI ), pPdfs + first, lanes );
+
+  } );
+
+}
+
+
+void
+sampleUniformSphereBatch(
+                         const float *pU1,
+                         const float *pU2,
+                         std::size_t  count,
+                         SimdVectors  directions
+                         )
+{
+
+  forEachBlock( count, [ = ]( std::size_t first, std::size_t lanes )
+  {
+
+    storeVectors(
+                 sampleUniformSphere( loadLanes( pU1 + first, lanes, 0.5f ), loadLanes( pU2 + first, lanes, 0.5f ) ),
+                 directions,
+                 first,
+                 lanes
+                 );
+
+  } );
+
+}
+
+
+void
+sampleUniformConeBatch(
+                       const float      *pU1,
+                       const float      *pU2,
+                       const float      *pCosMax,
+                       SimdConstVectors  axes,
+                       std::size_t       count,
+                       SimdVectors       directions,
+                       float            *pPdfs
+                       )
+{
+
+  forEachBlock( count, [ = ]( std::size_t first, std::size_t lanes )
+  {
+
+    VFloatN cosMax = loadLanes( pCosMax + first, lanes, 0.0f );
+
+    VVector3< width > local = sampleUniformCone(
+                                                loadLanes( pU1 + first, lanes, 0.5f ),
+                                                loadLanes( pU2 + first, lanes, 0.5f ),
+                                                cosMax
+                                                );
+
+    storeVectors( alignToNormal( local, loadVectors( axes, first, lanes ) ), directions, first, lanes );
+    storeLanes( VFloatN( 0.5f * SAMPLING_INV_PI ) / ( VFloatN( 1.0f ) - cosMax ), pPdfs + first, lanes );
+
+  } );
+
+}
+
+
+void
+sampleGgxVndfBatch(
+                   const float      *pU1,
+                   const float      *pU2,
+                   const float      *pAlpha,
+                   SimdConstVectors  normals,
+                   SimdConstVectors  views,
+                   std::size_t       count,
+                   SimdVectors       halfVectors,
+                   float            *pPdfs
+                   )
+{
+
+  forEachBlock( count, [ = ]( std::size_t first, std::size_t lanes )
+  {
+
+    VFloatN           alpha = loadLanes( pAlpha + first, lanes, 1.0f );
+    VVector3< width > n     = loadVectors( normals, first, lanes );
+    VVector3< width > v     = loadVectors( views, first, lanes );
+
+    // view direction in the normal's frame
+    VVector3< width > b1, b2;
+    orthonormalBasis( n, b1, b2 );
+
+    VVector3< width > local = {
+      fmadd( b1.x, v.x, fmadd( b1.y, v.y, b1.z * v.z ) ),
+      fmadd( b2.x, v.x, fmadd( b2.y, v.y, b2.z * v.z ) ),
+      fmadd( n.x,  v.x, fmadd( n.y,  v.y, n.z * v.z ) )
+    };
+
+    VVector3< width > h = sampleGgxVndf(
+                                        local,
+                                        alpha,
+                                        loadLanes( pU1 + first, lanes, 0.5f ),
+                                        loadLanes( pU2 + first, lanes, 0.5f )
+                                        );
+
+    VFloatN cosVH = fmadd( local.x, h.x, fmadd( local.y, h.y, local.z * h.z ) );
+
+    storeVectors( alignToNormal( h, n ), halfVectors, first, lanes );
+    storeLanes( ggxVndfPdf( local.z, h.z, cosVH, alpha ), pPdfs + first, lanes );
+
+  } );
+
+}
+
+
+} // namespace
+
+
+
+///////////////////////////////////////////////////////////////
+/// \brief getKernels
+/// \return this instruction set's kernels
+///////////////////////////////////////////////////////////////
+const SimdKernels&
+getKernels( )
+{
+
+  static const SimdKernels kernels = {
+    thisIsa( ),
+    &rgbaToRgb8,
+    &squaredErrors,
+    &sampleCosineHemisphereBatch,
+    &sampleUniformSphereBatch,
+    &sampleUniformConeBatch,
+    &sampleGgxVndfBatch,
+  };
+
+  return kernels;
+
+} // getKernels
+
+
+
+} // namespace LIGHT_SIMD_NAMESPACE
+
+} // namespace light
+
+
+#endif // SimdKernelsImpl_hpp
@@ -0,0 +1,7 @@
+// portable kernels, for CPUs without SSE4.1 and other architectures
+#define LIGHT_SIMD_TARGET 0
+#include "SimdKernelsImpl.hpp"
+
+#if LIGHT_SIMD_WIDTH != 1
+#error "SimdKernelsScalar.cpp must build the scalar kernels"
+#endif
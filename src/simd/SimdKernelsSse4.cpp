@@ -0,0 +1,7 @@
+// SSE4.1 kernels; CMakeLists.txt enables the instruction set for this file
+#define LIGHT_SIMD_TARGET 1
+#include "SimdKernelsImpl.hpp"
+
+#if LIGHT_SIMD_WIDTH != 4
+#error "SimdKernelsSse4.cpp must be compiled with SSE4.1 enabled"
+#endif
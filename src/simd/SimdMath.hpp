@@ -0,0 +1,165 @@
+#ifndef SimdMath_hpp
+#define SimdMath_hpp
+
+
+/////////////////////////////////////////////
+///        Lane-wise versions of the fast math in
+///        FastMath.hpp with the same coefficients and error
+///        bounds. Targets without FMA round the polynomial
+///        steps separately, which stays within the bounds.
+/////////////////////////////////////////////
+#include "Simd.hpp"
+#include "FastMath.hpp"
+
+
+namespace light
+{
+
+namespace LIGHT_SIMD_NAMESPACE
+{
+
+
+template< int N >
+VFloat< N >
+fastExp2( VFloat< N > x )
+{
+
+  typedef VFloat< N > F;
+
+  x = clamp( x, F( -126.0f ), F( 127.0f ) );
+
+  F n = floor( x + F( 0.5f ) );
+  F f = x - n;
+
+  F p = F( FAST_EXP2_C4 );
+  p = fmadd( p, f, F( FAST_EXP2_C3 ) );
+  p = fmadd( p, f, F( FAST_EXP2_C2 ) );
+  p = fmadd( p, f, F( FAST_EXP2_C1 ) );
+  p = fmadd( p, f, F( FAST_EXP2_C0 ) );
+
+  return p * asFloat( ( toInt( n ) + VInt< N >( 127 ) ) << 23 );
+
+}
+
+
+template< int N >
+VFloat< N >
+fastExp( VFloat< N > x )
+{
+
+  return fastExp2( x * VFloat< N >( FAST_LOG2E ) );
+
+}
+
+
+template< int N >
+VFloat< N >
+fastLog2( VFloat< N > x )
+{
+
+  typedef VFloat< N > F;
+  typedef VInt< N >   I;
+
+  I bits     = asInt( x );
+  F exponent = toFloat( ( ( bits >> 23 ) & I( 0xff ) ) - I( 127 ) );
+  F m        = asFloat( ( bits & I( 0x007fffff ) ) | I( 0x3f800000 ) );
+
+  VMask< N > high = m > F( 1.41421356f );
+
+  m        = select( high, m * F( 0.5f ), m );
+  exponent = select( high, exponent + F( 1.0f ), exponent );
+
+  F t = m - F( 1.0f );
+
+  F q = F( FAST_LOG2_C5 );
+  q = fmadd( q, t, F( FAST_LOG2_C4 ) );
+  q = fmadd( q, t, F( FAST_LOG2_C3 ) );
+  q = fmadd( q, t, F( FAST_LOG2_C2 ) );
+  q = fmadd( q, t, F( FAST_LOG2_C1 ) );
+  q = fmadd( q, t, F( FAST_LOG2_C0 ) );
+
+  return fmadd( t, q, exponent );
+
+}
+
+
+template< int N >
+VFloat< N >
+fastPow(
+        VFloat< N > x,
+        VFloat< N > y
+        )
+{
+
+  typedef VFloat< N > F;
+
+  return select( x > F( 0.0f ), fastExp2( y * fastLog2( x ) ), F( 0.0f ) );
+
+}
+
+
+template< int N >
+VFloat< N >
+fastRsqrt( VFloat< N > x )
+{
+
+  typedef VFloat< N > F;
+
+  F y = asFloat( VInt< N >( FAST_RSQRT_MAGIC ) - ( asInt( x ) >> 1 ) );
+
+  return y * F( FAST_RSQRT_A ) * ( F( FAST_RSQRT_B ) - x * y * y );
+
+}
+
+
+template< int N >
+VFloat< N >
+fastAcos( VFloat< N > x )
+{
+
+  typedef VFloat< N > F;
+
+  F a = abs( x );
+
+  F p = F( FAST_ACOS_C3 );
+  p = fmadd( p, a, F( FAST_ACOS_C2 ) );
+  p = fmadd( p, a, F( FAST_ACOS_C1 ) );
+  p = fmadd( p, a, F( FAST_ACOS_C0 ) );
+
+  F angle = p * sqrt( max( F( 1.0f ) - a, F( 0.0f ) ) );
+
+  return select( x < F( 0.0f ), F( FAST_PI ) - angle, angle );
+
+}
+
+
+///
+/// \brief fastNormalize
+///
+///        Normalizes N vectors stored as separate x, y and z
+///        lanes in place
+///
+template< int N >
+void
+fastNormalize(
+              VFloat< N > &x,
+              VFloat< N > &y,
+              VFloat< N > &z
+              )
+{
+
+  VFloat< N > scale = fastRsqrt( fmadd( x, x, fmadd( y, y, z * z ) ) );
+
+  x *= scale;
+  y *= scale;
+  z *= scale;
+
+}
+
+
+} // namespace LIGHT_SIMD_NAMESPACE
+
+} // namespace light
+
+
+#endif // SimdMath_hpp
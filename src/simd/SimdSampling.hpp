@@ -0,0 +1,331 @@
+#ifndef SimdSampling_hpp
+#define SimdSampling_hpp
+
+
+/////////////////////////////////////////////
+///        Lane-wise versions of the direction sampling in
+///        Sampling.hpp, with the same polynomials and mappings.
+///        Directions are kept as separate x, y and z vectors.
+/////////////////////////////////////////////
+#include "Simd.hpp"
+#include "Sampling.hpp"
+
+
+namespace light
+{
+
+namespace LIGHT_SIMD_NAMESPACE
+{
+
+
+///
+/// \brief The VVector3 struct
+///
+///        N three component vectors, one per lane
+///
+template< int N >
+struct VVector3
+{
+  VFloat< N > x, y, z;
+};
+
+
+template< int N >
+void
+quarterSinCos(
+              VFloat< N >  t,
+              VFloat< N > &s,
+              VFloat< N > &c
+              )
+{
+
+  typedef VFloat< N > F;
+
+  F t2 = t * t;
+
+  F ps = F( SAMPLING_SIN_C4 );
+  ps = fmadd( ps, t2, F( SAMPLING_SIN_C3 ) );
+  ps = fmadd( ps, t2, F( SAMPLING_SIN_C2 ) );
+  ps = fmadd( ps, t2, F( SAMPLING_SIN_C1 ) );
+
+  F pc = F( SAMPLING_COS_C4 );
+  pc = fmadd( pc, t2, F( SAMPLING_COS_C3 ) );
+  pc = fmadd( pc, t2, F( SAMPLING_COS_C2 ) );
+  pc = fmadd( pc, t2, F( SAMPLING_COS_C1 ) );
+
+  s = fmadd( t * t2, ps, t );
+  c = fmadd( t2, pc, F( 1.0f ) );
+
+}
+
+
+template< int N >
+void
+turnSinCos(
+           VFloat< N >  u,
+           VFloat< N > &s,
+           VFloat< N > &c
+           )
+{
+
+  typedef VFloat< N > F;
+  typedef VInt< N >   I;
+
+  F q = floor( fmadd( u, F( 4.0f ), F( 0.5f ) ) );
+
+  F qs, qc;
+  quarterSinCos( ( u * F( 4.0f ) - q ) * F( 2.0f * SAMPLING_PI_OVER_4 ), qs, qc );
+
+  I quadrant = toInt( q );
+
+  VMask< N > odd = ( quadrant & I( 1 ) ) == I( 1 );
+
+  F rs = select( odd, qc, qs );
+  F rc = select( odd, -qs, qc );
+
+  // quadrants 2 and 3 flip both signs
+  F flip = asFloat( ( quadrant & I( 2 ) ) << 30 );
+
+  s = asFloat( asInt( rs ) ^ asInt( flip ) );
+  c = asFloat( asInt( rc ) ^ asInt( flip ) );
+
+}
+
+
+template< int N >
+void
+orthonormalBasis(
+                 const VVector3< N > &n,
+                 VVector3< N >       &b1,
+                 VVector3< N >       &b2
+                 )
+{
+
+  typedef VFloat< N > F;
+  typedef VInt< N >   I;
+
+  // copysign( 1, n.z )
+  F sign = asFloat( ( asInt( n.z ) & I( static_cast< std::int32_t >( 0x80000000u ) ) ) | asInt( F( 1.0f ) ) );
+  F a    = -F( 1.0f ) / ( sign + n.z );
+  F b    = n.x * n.y * a;
+
+  b1.x = fmadd( sign * n.x, n.x * a, F( 1.0f ) );
+  b1.y = sign * b;
+  b1.z = -( sign * n.x );
+
+  b2.x = b;
+  b2.y = fmadd( n.y, n.y * a, sign );
+  b2.z = -n.y;
+
+}
+
+
+template< int N >
+VVector3< N >
+alignToNormal(
+              const VVector3< N > &v,
+              const VVector3< N > &n
+              )
+{
+
+  VVector3< N > b1, b2;
+  orthonormalBasis( n, b1, b2 );
+
+  VVector3< N > result;
+  result.x = fmadd( b1.x, v.x, fmadd( b2.x, v.y, n.x * v.z ) );
+  result.y = fmadd( b1.y, v.x, fmadd( b2.y, v.y, n.y * v.z ) );
+  result.z = fmadd( b1.z, v.x, fmadd( b2.z, v.y, n.z * v.z ) );
+
+  return result;
+
+}
+
+
+template< int N >
+void
+sampleConcentricDisk(
+                     VFloat< N >  u1,
+                     VFloat< N >  u2,
+                     VFloat< N > &x,
+                     VFloat< N > &y
+                     )
+{
+
+  typedef VFloat< N > F;
+
+  F a = fmadd( u1, F( 2.0f ), F( -1.0f ) );
+  F b = fmadd( u2, F( 2.0f ), F( -1.0f ) );
+
+  VMask< N > alongA = a * a > b * b;
+
+  F r     = select( alongA, a, b );
+  F ratio = select( alongA, b, a ) / select( r != F( 0.0f ), r, F( 1.0f ) );
+
+  F s, c;
+  quarterSinCos( F( SAMPLING_PI_OVER_4 ) * ratio, s, c );
+
+  x = r * select( alongA, c, s );
+  y = r * select( alongA, s, c );
+
+}
+
+
+template< int N >
+VVector3< N >
+sampleCosineHemisphere(
+                       VFloat< N > u1,
+                       VFloat< N > u2
+                       )
+{
+
+  typedef VFloat< N > F;
+
+  VVector3< N > v;
+  sampleConcentricDisk( u1, u2, v.x, v.y );
+
+  v.z = sqrt( max( F( 0.0f ), F( 1.0f ) - v.x * v.x - v.y * v.y ) );
+
+  return v;
+
+}
+
+
+template< int N >
+VVector3< N >
+sampleUniformCone(
+                  VFloat< N > u1,
+                  VFloat< N > u2,
+                  VFloat< N > cosMax
+                  )
+{
+
+  typedef VFloat< N > F;
+
+  VVector3< N > v;
+  v.z = fmadd( F( 1.0f ) - cosMax, u2, cosMax );
+
+  F r = sqrt( max( F( 0.0f ), F( 1.0f ) - v.z * v.z ) );
+
+  F s, c;
+  turnSinCos( u1, s, c );
+
+  v.x = r * c;
+  v.y = r * s;
+
+  return v;
+
+}
+
+
+template< int N >
+VVector3< N >
+sampleUniformSphere(
+                    VFloat< N > u1,
+                    VFloat< N > u2
+                    )
+{
+
+  return sampleUniformCone( u1, u2, VFloat< N >( -1.0f ) );
+
+}
+
+
+template< int N >
+VFloat< N >
+ggxD(
+     VFloat< N > cosNH,
+     VFloat< N > alpha
+     )
+{
+
+  typedef VFloat< N > F;
+
+  F alpha2 = alpha * alpha;
+  F d      = fmadd( cosNH * cosNH, alpha2 - F( 1.0f ), F( 1.0f ) );
+
+  return select( cosNH > F( 0.0f ), alpha2 * F( SAMPLING_INV_PI ) / ( d * d ), F( 0.0f ) );
+
+}
+
+
+template< int N >
+VFloat< N >
+ggxSmithG1(
+           VFloat< N > cosNV,
+           VFloat< N > alpha
+           )
+{
+
+  typedef VFloat< N > F;
+
+  F alpha2 = alpha * alpha;
+
+  return F( 2.0f ) * cosNV / ( cosNV + sqrt( fmadd( F( 1.0f ) - alpha2, cosNV * cosNV, alpha2 ) ) );
+
+}
+
+
+template< int N >
+VVector3< N >
+sampleGgxVndf(
+              const VVector3< N > &v,
+              VFloat< N >          alpha,
+              VFloat< N >          u1,
+              VFloat< N >          u2
+              )
+{
+
+  typedef VFloat< N > F;
+
+  VVector3< N > vh = { alpha * v.x, alpha * v.y, v.z };
+
+  F scale = rsqrt( fmadd( vh.x, vh.x, fmadd( vh.y, vh.y, vh.z * vh.z ) ) );
+
+  vh.x *= scale;
+  vh.y *= scale;
+  vh.z *= scale;
+
+  F z = fmadd( F( 1.0f ) - u2, F( 1.0f ) + vh.z, -vh.z );
+  F r = sqrt( clamp( F( 1.0f ) - z * z, F( 0.0f ), F( 1.0f ) ) );
+
+  F s, c;
+  turnSinCos( u1, s, c );
+
+  VVector3< N > h = {
+    alpha * fmadd( r, c, vh.x ),
+    alpha * fmadd( r, s, vh.y ),
+    max( z + vh.z, F( 0.0f ) )
+  };
+
+  scale = rsqrt( fmadd( h.x, h.x, fmadd( h.y, h.y, h.z * h.z ) ) );
+
+  h.x *= scale;
+  h.y *= scale;
+  h.z *= scale;
+
+  return h;
+
+}
+
+
+template< int N >
+VFloat< N >
+ggxVndfPdf(
+           VFloat< N > cosNV,
+           VFloat< N > cosNH,
+           VFloat< N > cosVH,
+           VFloat< N > alpha
+           )
+{
+
+  return ggxSmithG1( cosNV, alpha ) * max( cosVH, VFloat< N >( 0.0f ) ) * ggxD( cosNH, alpha ) / cosNV;
+
+}
+
+
+} // namespace LIGHT_SIMD_NAMESPACE
+
+} // namespace light
+
+
+#endif // SimdSampling_hpp
@@ -0,0 +1,170 @@
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include "gmock/gmock.h"
+#include "BenchmarkComparison.hpp"
+
+
+namespace
+{
+
+
+///
+/// \brief benchmarkJson
+/// \return Google Benchmark style output with one iteration entry
+///         per time, followed by the aggregates it would print
+///
+std::string
+benchmarkJson(
+              const std::string           &runName,
+              const std::vector< double > &times,
+              const std::string           &unit = "ns"
+              )
+{
+
+  std::string entries;
+
+  for ( double time : times )
+  {
+
+    entries += "    { \"name\": \"" + runName + "/repeats:5\", \"run_name\": \"" + runName
+               + "\", \"run_type\": \"iteration\", \"real_time\": " + std::to_string( time )
+               + ", \"cpu_time\": " + std::to_string( time * 2.0 )
+               + ", \"time_unit\": \"" + unit + "\" },\n";
+
+  }
+
+  return "{\n  \"context\": { \"host_name\": \"ci\", \"caches\": [ { \"level\": 1 } ], \"library_build_type\": \"release\" },\n"
+         "  \"benchmarks\": [\n" + entries +
+         "    { \"name\": \"" + runName + "/repeats:5_mean\", \"run_name\": \"" + runName
+         + "\", \"run_type\": \"aggregate\", \"aggregate_name\": \"mean\", \"real_time\": 1e9, \"cpu_time\": 1e9, \"time_unit\": \"ns\" }\n"
+         "  ]\n}\n";
+
+}
+
+
+light::BenchmarkResults
+results(
+        const std::string           &name,
+        const std::vector< double > &times
+        )
+{
+
+  light::BenchmarkResults result;
+  result.samples[ name ] = times;
+
+  return result;
+
+}
+
+
+
+TEST( BenchmarkComparisonUnitTests, ParsesRepetitionsAndSkipsAggregates )
+{
+
+  std::string json = benchmarkJson( "BM_Traverse/1000", { 1.5, 2.5, 3.5 }, "us" );
+
+  light::BenchmarkResults real = light::parseBenchmarkResults( json, false );
+  light::BenchmarkResults cpu  = light::parseBenchmarkResults( json, true );
+
+  ASSERT_EQ( 1u, real.samples.size( ) );
+  EXPECT_THAT( real.samples[ "BM_Traverse/1000" ], ::testing::ElementsAre( 1500.0, 2500.0, 3500.0 ) );
+  EXPECT_THAT( cpu.samples[ "BM_Traverse/1000" ],  ::testing::ElementsAre( 3000.0, 5000.0, 7000.0 ) );
+
+  // older versions have no run_type or run_name, and failed runs are skipped
+  std::string old = "{ \"benchmarks\": [ { \"name\": \"BM_Shade\", \"real_time\": 4, \"time_unit\": \"ms\" },"
+                    " { \"name\": \"BM_Shade_mean\", \"real_time\": 4, \"time_unit\": \"ms\" },"
+                    " { \"name\": \"BM_Shade\", \"error_occurred\": true, \"real_time\": 9 } ] }";
+
+  light::BenchmarkResults oldResults = light::parseBenchmarkResults( old, false );
+
+  ASSERT_EQ( 1u, oldResults.samples.size( ) );
+  EXPECT_THAT( oldResults.samples[ "BM_Shade" ], ::testing::ElementsAre( 4e6 ) );
+
+  EXPECT_THROW( light::parseBenchmarkResults( "{ \"benchmarks\": [ { \"name\": ", false ), std::runtime_error );
+  EXPECT_THROW( light::parseBenchmarkResults( "{ \"context\": { } }", false ),          std::runtime_error );
+
+}
+
+
+
+TEST( BenchmarkComparisonUnitTests, MannWhitneyMatchesKnownValues )
+{
+
+  // exact: separated samples of 3 and 5 are 1 and 2 arrangements of C(6,3) and C(10,5)
+  EXPECT_NEAR( 2.0 / 20.0,  light::mannWhitneyPValue( { 1, 2, 3 },       { 4, 5, 6 } ),        1e-12 );
+  EXPECT_NEAR( 2.0 / 252.0, light::mannWhitneyPValue( { 1, 2, 3, 4, 5 }, { 6, 7, 8, 9, 10 } ), 1e-12 );
+  EXPECT_NEAR( 4.0 / 252.0, light::mannWhitneyPValue( { 1, 2, 3, 4, 6 }, { 5, 7, 8, 9, 10 } ), 1e-12 );
+
+  // ties fall back to the corrected normal approximation
+  EXPECT_NEAR( 0.0704846, light::mannWhitneyPValue( { 1, 2, 2, 3, 4 }, { 2, 4, 5, 5, 6 } ), 1e-6 );
+
+  EXPECT_DOUBLE_EQ( 1.0, light::mannWhitneyPValue( { 3, 3, 3 }, { 3, 3, 3 } ) );
+  EXPECT_DOUBLE_EQ( 1.0, light::mannWhitneyPValue( { 1 },       { } ) );
+
+  // order of the samples doesn't matter
+  std::vector< double > a = { 10, 12, 11, 15, 13, 14, 9, 16 };
+  std::vector< double > b = { 14, 18, 17, 13, 19, 20, 15, 21 };
+
+  EXPECT_DOUBLE_EQ( light::mannWhitneyPValue( a, b ), light::mannWhitneyPValue( b, a ) );
+
+}
+
+
+
+TEST( BenchmarkComparisonUnitTests, FlagsOnlySignificantSlowdownsPastTheThreshold )
+{
+
+  std::vector< double > baseline = { 100, 101, 99, 100.5, 99.5, 100.2, 99.8, 100.1 };
+  std::vector< double > slower   = { 110, 111, 109, 110.5, 109.5, 110.2, 109.8, 110.1 };
+  std::vector< double > slightly = { 102, 103, 101, 102.5, 101.5, 102.2, 101.8, 102.1 };
+  std::vector< double > faster   = { 80, 81, 79, 80.5, 79.5, 80.2, 79.8, 80.1 };
+  std::vector< double > noisy    = { 100, 130, 95, 120, 90, 125, 98, 105 };
+
+  light::BenchmarkComparison regression = light::compareBenchmarks( results( "BM", baseline ), results( "BM", slower ) );
+
+  ASSERT_EQ( 1u, regression.cases.size( ) );
+  EXPECT_EQ( 1u, regression.getRegressionCount( ) );
+  EXPECT_NEAR( 1.1, regression.cases[ 0 ].ratio, 1e-3 );
+  EXPECT_LE( regression.cases[ 0 ].ratioLow,  1.1 );
+  EXPECT_GE( regression.cases[ 0 ].ratioHigh, 1.1 );
+  EXPECT_GT( regression.cases[ 0 ].ratioLow,  1.05 );
+
+  // significant but within the 5% threshold
+  light::BenchmarkComparison small = light::compareBenchmarks( results( "BM", baseline ), results( "BM", slightly ) );
+  EXPECT_TRUE ( small.cases[ 0 ].significant );
+  EXPECT_EQ   ( 0u, small.getRegressionCount( ) );
+
+  light::BenchmarkComparison speedup = light::compareBenchmarks( results( "BM", baseline ), results( "BM", faster ) );
+  EXPECT_TRUE ( speedup.cases[ 0 ].significant );
+  EXPECT_EQ   ( 0u, speedup.getRegressionCount( ) );
+
+  // a slower median buried in noise isn't significant
+  light::BenchmarkComparison noise = light::compareBenchmarks( results( "BM", baseline ), results( "BM", noisy ) );
+  EXPECT_FALSE( noise.cases[ 0 ].significant );
+  EXPECT_EQ   ( 0u, noise.getRegressionCount( ) );
+
+}
+
+
+
+TEST( BenchmarkComparisonUnitTests, ReportsUnmatchedCases )
+{
+
+  light::BenchmarkResults baseline = results( "BM_Old", { 1, 2 } );
+  baseline.samples[ "BM_Both" ] = { 1, 2 };
+
+  light::BenchmarkResults test = results( "BM_New", { 1, 2 } );
+  test.samples[ "BM_Both" ] = { 1, 2 };
+
+  light::BenchmarkComparison comparison = light::compareBenchmarks( baseline, test );
+
+  ASSERT_EQ( 1u, comparison.cases.size( ) );
+  EXPECT_EQ( "BM_Both", comparison.cases[ 0 ].name );
+  EXPECT_THAT( comparison.baselineOnly, ::testing::ElementsAre( "BM_Old" ) );
+  EXPECT_THAT( comparison.testOnly,     ::testing::ElementsAre( "BM_New" ) );
+
+}
+
+
+} // namespace
@@ -0,0 +1,147 @@
+#include <string>
+#include <vector>
+#include "gmock/gmock.h"
+#include "BvhReport.hpp"
+#include "HostScene.hpp"
+#include "BuiltinScenes.hpp"
+
+
+namespace
+{
+
+
+light::Aabb
+makeBox(
+        float x,
+        float width
+        )
+{
+
+  return light::Aabb { light::Float3 { x, 0.0f, 0.0f }, light::Float3 { x + width, 1.0f, 1.0f } };
+
+}
+
+
+
+//////////////////////////////////////////////////////////
+// four separate boxes give a balanced tree without overlap
+//////////////////////////////////////////////////////////
+TEST( BvhReportUnitTests, CountsLeavesAndDepth )
+{
+
+  light::Bvh bvh;
+  bvh.build( { makeBox( 0.0f, 1.0f ), makeBox( 2.0f, 1.0f ), makeBox( 4.0f, 1.0f ), makeBox( 6.0f, 1.0f ) }, 1 );
+
+  light::BvhReport report = light::analyzeBvh( bvh );
+
+  EXPECT_EQ( 4u, report.items );
+  EXPECT_EQ( 7u, report.nodes );
+  EXPECT_EQ( 4u, report.leaves );
+  EXPECT_EQ( 2u, report.maxDepth );
+  EXPECT_DOUBLE_EQ( 2.0, report.meanLeafDepth );
+
+  ASSERT_EQ( 2u, report.leafSizes.size( ) );
+  EXPECT_EQ( 4u, report.leafSizes[ 1 ] );
+
+  EXPECT_DOUBLE_EQ( 0.0, report.meanSiblingOverlap );
+  EXPECT_FLOAT_EQ( bvh.getSahCost( ), report.sahCost );
+  EXPECT_EQ( bvh.getMemoryBytes( ), report.memoryBytes );
+
+}
+
+
+
+//////////////////////////////////////////////////////////
+// nested siblings overlap by the smaller one's area
+//////////////////////////////////////////////////////////
+TEST( BvhReportUnitTests, MeasuresSiblingOverlap )
+{
+
+  light::Bvh bvh;
+  bvh.build( { makeBox( 0.0f, 4.0f ), makeBox( 1.0f, 1.0f ) }, 1 );
+
+  light::BvhReport report = light::analyzeBvh( bvh );
+
+  ASSERT_EQ( 3u, report.nodes );
+
+  // the unit cube's area over the 4 x 1 x 1 root's
+  EXPECT_NEAR( 6.0 / 18.0, report.meanSiblingOverlap, 1e-6 );
+  EXPECT_DOUBLE_EQ( report.meanSiblingOverlap, report.maxSiblingOverlap );
+
+}
+
+
+
+//////////////////////////////////////////////////////////
+// traversal stats count work only for what a ray reaches
+//////////////////////////////////////////////////////////
+TEST( BvhReportUnitTests, TraversalStatsCountWork )
+{
+
+  light::HostScene scene( light::buildBasicScene( ) );
+  light::HostHit   hit;
+
+  light::TraversalStats hitStats;
+  ASSERT_TRUE( scene.intersect( light::HostRay { { 1.5f, 0.0f, 10.0f }, { 0.0f, 0.0f, -1.0f }, 1e-4f, 1e30f }, &hit, &hitStats ) );
+
+  EXPECT_GT( hitStats.nodes, 0u );
+  EXPECT_GT( hitStats.tests, 0u );
+
+  light::TraversalStats missStats;
+  EXPECT_FALSE( scene.occluded( light::HostRay { { 0.0f, 0.0f, 100.0f }, { 0.0f, 0.0f, 1.0f }, 1e-4f, 1e30f }, &missStats ) );
+
+  EXPECT_EQ( 0u, missStats.tests );
+  EXPECT_LE( missStats.nodes, 1u );
+
+}
+
+
+
+//////////////////////////////////////////////////////////
+// every pixel gets a primary ray and hits add shadow rays
+//////////////////////////////////////////////////////////
+TEST( BvhReportUnitTests, RayCostCoversEveryPixel )
+{
+
+  light::HostScene scene( light::buildBasicScene( ) );
+
+  light::RayCostReport report = light::measureRayCost(
+                                                      scene,
+                                                      8,
+                                                      6,
+                                                      light::Float3 { 0.0f, 2.0f, 10.0f },
+                                                      light::Float3 { 1.0f, 0.0f, 0.0f },
+                                                      light::Float3 { 0.0f, 0.75f, 0.0f },
+                                                      light::Float3 { 0.0f, -0.2f, -1.0f }
+                                                      );
+
+  EXPECT_EQ( 48u, report.pixels.size( ) );
+  EXPECT_EQ( 48u, report.primaryRays );
+  EXPECT_GT( report.shadowRays, 0u );
+  EXPECT_GT( report.primary.tests, 0u );
+
+  light::TraversalStats sum;
+
+  for ( const light::TraversalStats &pixel : report.pixels )
+  {
+
+    sum.nodes += pixel.nodes;
+    sum.tests += pixel.tests;
+
+  }
+
+  EXPECT_EQ( report.primary.nodes + report.shadow.nodes, sum.nodes );
+  EXPECT_EQ( report.primary.tests + report.shadow.tests, sum.tests );
+
+  std::vector< float > heatmap = light::toCostHeatmap( report, 1.0f );
+  EXPECT_EQ( 48u * 4u, heatmap.size( ) );
+
+  std::string text = light::formatBvhReport( scene );
+  EXPECT_THAT( text, ::testing::HasSubstr( "top " ) );
+  EXPECT_THAT( text, ::testing::HasSubstr( "bottom 2" ) );
+  EXPECT_THAT( text, ::testing::HasSubstr( "total: " ) );
+
+}
+
+
+} // namespace
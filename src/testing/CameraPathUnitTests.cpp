@@ -0,0 +1,222 @@
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <stdexcept>
+#include "gmock/gmock.h"
+#include "CameraPath.hpp"
+#include "ImageIO.hpp"
+#include "HostMath.hpp"
+
+
+namespace
+{
+
+
+constexpr float tolerance = 1e-5f;
+
+
+TEST( CameraPathUnitTests, ParsesOrbitKeysAndViews )
+{
+
+  light::CameraPath orbit = light::CameraPath::parse(
+                                                     "# x-wing fly-by\n"
+                                                     "orbit 0 20 45 -30\n"
+                                                     "\n"
+                                                     "orbit 2.5 10 90 -10   # closer\n"
+                                                     );
+
+  ASSERT_EQ( 2u, orbit.getOrbitKeys( ).size( ) );
+  EXPECT_FLOAT_EQ( 2.5f, orbit.getOrbitKeys( )[ 1 ].time );
+  EXPECT_FLOAT_EQ( 90.0f, orbit.getOrbitKeys( )[ 1 ].dx );
+  EXPECT_TRUE( orbit.getViews( ).empty( ) );
+
+  light::CameraPath views = light::CameraPath::parse(
+                                                     "view 0 0 5  0 0 0\n"
+                                                     "view 5 0 0  0 0 0  0 0 1\n"
+                                                     );
+
+  ASSERT_EQ( 2u, views.getViews( ).size( ) );
+  EXPECT_FLOAT_EQ( 1.0f, views.getViews( )[ 0 ].up.y );
+  EXPECT_FLOAT_EQ( 1.0f, views.getViews( )[ 1 ].up.z );
+
+  std::vector< light::CameraShot > shots = views.getShots( 10 );
+  ASSERT_EQ( 2u, shots.size( ) );
+  EXPECT_FALSE( shots[ 0 ].orbit );
+
+}
+
+
+
+TEST( CameraPathUnitTests, RejectsMalformedPaths )
+{
+
+  EXPECT_THROW( light::CameraPath::parse( "" ), std::runtime_error );
+  EXPECT_THROW( light::CameraPath::parse( "orbit 0 1 2\n" ), std::runtime_error );
+  EXPECT_THROW( light::CameraPath::parse( "orbit 0 1 2 x\n" ), std::runtime_error );
+  EXPECT_THROW( light::CameraPath::parse( "dolly 0 1 2 3\n" ), std::runtime_error );
+  EXPECT_THROW( light::CameraPath::parse( "orbit 1 0 0 0\norbit 0 0 0 0\n" ), std::runtime_error );
+  EXPECT_THROW( light::CameraPath::parse( "orbit 0 0 0 0\nview 0 0 5 0 0 0\n" ), std::runtime_error );
+  EXPECT_THROW( light::CameraPath::parse( "view 0 0 0 0 0 0\n" ), std::runtime_error );
+
+  try
+  {
+
+    light::CameraPath::parse( "orbit 0 0 0 0\n\norbit 1 0 0\n" );
+    FAIL( ) << "short orbit line accepted";
+
+  }
+  catch ( const std::runtime_error &e )
+  {
+
+    EXPECT_THAT( e.what( ), ::testing::HasSubstr( "line 3" ) );
+
+  }
+
+}
+
+
+
+TEST( CameraPathUnitTests, InterpolatesOrbitKeys )
+{
+
+  light::CameraPath path;
+  path.addOrbitKey( light::OrbitKey { 0.0f, 20.0f, 0.0f,   -30.0f } );
+  path.addOrbitKey( light::OrbitKey { 2.0f, 10.0f, 180.0f, -10.0f } );
+
+  light::OrbitKey middle = path.getOrbitKey( 1.0f );
+  EXPECT_NEAR( 15.0f, middle.zoom, tolerance );
+  EXPECT_NEAR( 90.0f, middle.dx,   tolerance );
+  EXPECT_NEAR( -20.0f, middle.dy,  tolerance );
+
+  // clamped past either end
+  EXPECT_FLOAT_EQ( 20.0f, path.getOrbitKey( -1.0f ).zoom );
+  EXPECT_FLOAT_EQ( 10.0f, path.getOrbitKey( 5.0f ).zoom );
+
+  std::vector< light::CameraShot > shots = path.getShots( 5 );
+  ASSERT_EQ( 5u, shots.size( ) );
+
+  for ( unsigned i = 0; i < 5; ++i )
+  {
+
+    EXPECT_TRUE( shots[ i ].orbit );
+    EXPECT_NEAR( 45.0f * i, shots[ i ].key.dx, 1e-4f );
+
+  }
+
+  EXPECT_EQ( 2u, path.getShots( ).size( ) );
+
+}
+
+
+
+TEST( CameraPathUnitTests, TurntableCoversOneTurn )
+{
+
+  light::CameraPath path = light::CameraPath::makeTurntable( light::OrbitKey { 0.0f, 20.0f, 45.0f, -30.0f }, 8 );
+
+  std::vector< light::CameraShot > shots = path.getShots( );
+  ASSERT_EQ( 8u, shots.size( ) );
+
+  for ( unsigned i = 0; i < 8; ++i )
+  {
+
+    EXPECT_NEAR( 45.0f + 45.0f * i, shots[ i ].key.dx, 1e-4f );
+    EXPECT_FLOAT_EQ( 20.0f, shots[ i ].key.zoom );
+    EXPECT_FLOAT_EQ( -30.0f, shots[ i ].key.dy );
+
+  }
+
+  EXPECT_THROW( light::CameraPath::makeTurntable( light::OrbitKey { 0.0f, 0.0f, 0.0f, 0.0f }, 0 ), std::runtime_error );
+
+}
+
+
+
+TEST( CameraPathUnitTests, LookAtBasisIsOrthogonal )
+{
+
+  light::CameraView view;
+  view.eye    = light::Float3 { 3.0f, 2.0f, 5.0f };
+  view.lookAt = light::Float3 { 0.0f, 0.5f, 0.0f };
+  view.up     = light::Float3 { 0.0f, 1.0f, 0.0f };
+
+  light::Float3 U, V, W;
+  light::makeLookAtBasis( view, 0.75f, 0.5f, &U, &V, &W );
+
+  light::Float3 forward = light::normalize( view.lookAt - view.eye );
+
+  EXPECT_NEAR( 1.0f, light::dot( W, forward ), tolerance );
+  EXPECT_NEAR( 0.75f, std::sqrt( light::dot( U, U ) ), tolerance );
+  EXPECT_NEAR( 0.5f,  std::sqrt( light::dot( V, V ) ), tolerance );
+  EXPECT_NEAR( 0.0f, light::dot( U, V ), tolerance );
+  EXPECT_NEAR( 0.0f, light::dot( U, W ), tolerance );
+  EXPECT_NEAR( 0.0f, light::dot( V, W ), tolerance );
+
+  // U to the right and V up, so U x V points back at the eye
+  EXPECT_NEAR( 0.0f, U.y, tolerance );
+  EXPECT_GT( V.y, 0.0f );
+  EXPECT_LT( light::dot( light::cross( U, V ), W ), 0.0f );
+
+}
+
+
+
+TEST( CameraPathUnitTests, FrameWriterWritesEveryFrame )
+{
+
+  const unsigned width  = 4;
+  const unsigned height = 2;
+
+  std::vector< std::string > filenames;
+
+  {
+
+    light::FrameWriter writer( 1 );
+
+    for ( unsigned i = 0; i < 3; ++i )
+    {
+
+      filenames.push_back( "lightBenderFrameTest_" + std::to_string( i ) + ".ppm" );
+      writer.submit( filenames.back( ), width, height, std::vector< float >( width * height * 4, 0.25f * i ) );
+
+    }
+
+    writer.wait( );
+    EXPECT_TRUE( writer.getErrors( ).empty( ) );
+
+    writer.submit( "missingDirectory/lightBenderFrameTest.ppm", width, height, std::vector< float >( width * height * 4 ) );
+    writer.wait( );
+    EXPECT_EQ( 1u, writer.getErrors( ).size( ) );
+
+  }
+
+  for ( unsigned i = 0; i < filenames.size( ); ++i )
+  {
+
+    std::ifstream file( filenames[ i ], std::ios::binary );
+    ASSERT_TRUE( file.is_open( ) );
+
+    std::string magic;
+    unsigned w, h, maxValue;
+    file >> magic >> w >> h >> maxValue;
+    file.get( );
+
+    EXPECT_EQ( "P6", magic );
+    EXPECT_EQ( width, w );
+    EXPECT_EQ( height, h );
+
+    char rgb[ 3 ];
+    file.read( rgb, 3 );
+    EXPECT_EQ( static_cast< unsigned char >( 0.25f * i * 255.0f ), static_cast< unsigned char >( rgb[ 0 ] ) );
+
+    file.close( );
+    std::remove( filenames[ i ].c_str( ) );
+
+  }
+
+}
+
+
+} // namespace
@@ -0,0 +1,193 @@
+#include <vector>
+#include <stdexcept>
+#include "gmock/gmock.h"
+#include "Convergence.hpp"
+#include "HostWorkerRenderer.hpp"
+
+
+namespace
+{
+
+
+light::RenderSettings
+basicSettings( std::uint32_t seed )
+{
+
+  light::RenderSettings settings;
+  settings.sceneType   = 0;
+  settings.width       = 24;
+  settings.height      = 16;
+  settings.sqrtSamples = 1;
+  settings.globalSeed  = seed;
+
+  const float eye[] = { 0.0f, 2.0f, 10.0f };
+  const float U[]   = { 1.5f, 0.0f, 0.0f };
+  const float V[]   = { 0.0f, 1.0f, 0.0f };
+  const float W[]   = { 0.0f, -0.2f, -1.0f };
+
+  for ( int c = 0; c < 3; ++c )
+  {
+
+    settings.eye[ c ] = eye[ c ];
+    settings.U  [ c ] = U  [ c ];
+    settings.V  [ c ] = V  [ c ];
+    settings.W  [ c ] = W  [ c ];
+
+  }
+
+  return settings;
+
+}
+
+
+light::ConvergencePoint
+point(
+      double seconds,
+      double relMse
+      )
+{
+
+  light::ConvergencePoint result;
+  result.seconds        = seconds;
+  result.metrics.relMse = relMse;
+
+  return result;
+
+}
+
+
+
+TEST( ConvergenceUnitTests, CountsAreLogSpacedAndEndAtTheMaximum )
+{
+
+  EXPECT_EQ( std::vector< unsigned >( { 1, 2, 3, 6, 10, 18, 32, 50 } ), light::getLogSpacedCounts( 50, 4 ) );
+  EXPECT_EQ( std::vector< unsigned >( { 1, 10, 100, 128 } ),            light::getLogSpacedCounts( 128, 1 ) );
+  EXPECT_EQ( std::vector< unsigned >( { 1 } ),                          light::getLogSpacedCounts( 1, 4 ) );
+  EXPECT_TRUE( light::getLogSpacedCounts( 0, 4 ).empty( ) );
+
+}
+
+
+
+TEST( ConvergenceUnitTests, ErrorFallsAsHostFramesAccumulate )
+{
+
+  light::HostWorkerRenderer renderer( 2 );
+
+  renderer.setup( basicSettings( 99 ) );
+  light::Image reference = light::renderAverage( &renderer, 24, 16, 256 );
+
+  renderer.setup( basicSettings( 1 ) );
+
+  light::ImageCompareOptions metrics;
+  metrics.flip = false;
+
+  light::ConvergenceOptions options;
+  options.maxFrames          = 64;
+  options.snapshotsPerDecade = 2;
+
+  std::vector< light::ConvergencePoint > points = light::measureConvergence(
+                                                                            &renderer,
+                                                                            light::ImageComparer( reference, metrics ),
+                                                                            options
+                                                                            );
+
+  ASSERT_EQ( 5u, points.size( ) ); // 1, 3, 10, 32, 64
+
+  EXPECT_EQ( 1u,  points.front( ).frames );
+  EXPECT_EQ( 64u, points.back( ).frames );
+  EXPECT_EQ( 64u, points.back( ).samplesPerPixel );
+  EXPECT_GT( points.front( ).metrics.mse, 0.0 );
+  EXPECT_LT( points.back( ).metrics.mse, points.front( ).metrics.mse * 0.25 );
+  EXPECT_GE( points.back( ).seconds, points.front( ).seconds );
+
+  // a different frame split gives the same image
+  light::HostWorkerRenderer other( 1 );
+  other.setup( basicSettings( 99 ) );
+
+  light::WorkUnit unit;
+  unit.width      = 24;
+  unit.height     = 16;
+  unit.frameCount = 2;
+
+  light::PartialResult both;
+  other.render( unit, &both );
+
+  unit.frameCount = 1;
+  light::PartialResult first, second;
+  other.render( unit, &first );
+  unit.firstFrame = 1;
+  other.render( unit, &second );
+
+  ASSERT_EQ( both.radianceSum.size( ), first.radianceSum.size( ) );
+  EXPECT_EQ( 2u, both.samplesPerPixel );
+
+  for ( std::size_t i = 0; i < both.radianceSum.size( ); ++i )
+  {
+    EXPECT_FLOAT_EQ( both.radianceSum[ i ], first.radianceSum[ i ] + second.radianceSum[ i ] );
+  }
+
+}
+
+
+
+TEST( ConvergenceUnitTests, TimeSnapshotsStopAtTheTimeLimit )
+{
+
+  light::HostWorkerRenderer renderer( 1 );
+  renderer.setup( basicSettings( 3 ) );
+
+  light::ImageCompareOptions metrics;
+  metrics.ssim = false;
+  metrics.flip = false;
+
+  light::ConvergenceOptions options;
+  options.maxFrames      = 1000000;
+  options.maxSeconds     = 0.05;
+  options.snapshotByTime = true;
+
+  std::vector< light::ConvergencePoint > points = light::measureConvergence(
+                                                                            &renderer,
+                                                                            light::ImageComparer( light::renderAverage( &renderer, 24, 16, 4 ), metrics ),
+                                                                            options
+                                                                            );
+
+  ASSERT_GE( points.size( ), 2u );
+  EXPECT_GE( points.back( ).seconds, 0.05 );
+  EXPECT_LT( points.back( ).frames, 1000000u );
+
+  for ( std::size_t i = 1; i < points.size( ); ++i )
+  {
+    EXPECT_GT( points[ i ].frames, points[ i - 1 ].frames );
+  }
+
+}
+
+
+
+//////////////////////////////////////////////////////////
+// b reaches every error in half the time of a
+//////////////////////////////////////////////////////////
+TEST( ConvergenceUnitTests, ComparesAtEqualTimeAndEqualError )
+{
+
+  std::vector< light::ConvergencePoint > a = { point( 1.0, 1.0 ),  point( 10.0, 0.1 ),  point( 100.0, 0.01 ) };
+  std::vector< light::ConvergencePoint > b = { point( 0.5, 1.0 ),  point( 5.0, 0.1 ),   point( 50.0, 0.01 ) };
+
+  light::ConvergenceComparison comparison = light::compareConvergence( a, b );
+
+  EXPECT_DOUBLE_EQ( 50.0, comparison.equalTimeSeconds );
+  EXPECT_NEAR( 0.02, comparison.relMseA, 1e-9 );
+  EXPECT_NEAR( 0.01, comparison.relMseB, 1e-9 );
+
+  EXPECT_NEAR( 0.01,  comparison.targetRelMse, 1e-12 );
+  EXPECT_NEAR( 100.0, comparison.secondsA, 1e-9 );
+  EXPECT_NEAR( 50.0,  comparison.secondsB, 1e-9 );
+  EXPECT_NEAR( 2.0,   comparison.speedup, 1e-9 );
+
+  EXPECT_THROW( light::compareConvergence( a, { } ), std::runtime_error );
+
+}
+
+
+} // namespace
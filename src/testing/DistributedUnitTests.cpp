@@ -0,0 +1,261 @@
+#include <thread>
+#include <memory>
+#include <vector>
+#include "gmock/gmock.h"
+#include "RenderProtocol.hpp"
+#include "RenderWorker.hpp"
+#include "RenderCoordinator.hpp"
+#include "AccumulationBuffer.hpp"
+
+
+namespace
+{
+
+
+///
+/// \brief The FakeWorkerRenderer class
+///
+///        Every sample of frame f at pixel (x, y) has the value
+///        x + y * width + f so merged results can be checked exactly
+///
+class FakeWorkerRenderer : public light::WorkerRendererInterface
+{
+
+public:
+
+  void setup( const light::RenderSettings &settings ) final
+  {
+
+    settings_ = settings;
+
+  }
+
+  void render(
+              const light::WorkUnit &unit,
+              light::PartialResult  *pResult
+              ) final
+  {
+
+    unsigned spp = settings_.sqrtSamples * settings_.sqrtSamples;
+
+    pResult->samplesPerPixel = unit.frameCount * spp;
+    pResult->radianceSum.assign( unit.width * unit.height * 4, 0.0f );
+
+    for ( unsigned y = 0; y < unit.height; ++y )
+    {
+
+      for ( unsigned x = 0; x < unit.width; ++x )
+      {
+
+        float pixelValue = static_cast< float >( unit.x + x + ( unit.y + y ) * settings_.width );
+
+        for ( unsigned f = unit.firstFrame; f < unit.firstFrame + unit.frameCount; ++f )
+        {
+
+          pResult->radianceSum[ ( y * unit.width + x ) * 4 ] += ( pixelValue + f ) * spp;
+
+        }
+
+        pResult->radianceSum[ ( y * unit.width + x ) * 4 + 3 ] = static_cast< float >( pResult->samplesPerPixel );
+
+      }
+
+    }
+
+  }
+
+
+private:
+
+  light::RenderSettings settings_;
+
+};
+
+
+
+//////////////////////////////////////////////////////////
+// pixels covered by more samples count proportionally more
+//////////////////////////////////////////////////////////
+TEST( DistributedUnitTests, AccumulationWeightsBySampleCount )
+{
+
+  light::AccumulationBuffer buffer( 2, 1 );
+
+  light::PartialResult first;
+  first.unit.width      = 2;
+  first.unit.height     = 1;
+  first.samplesPerPixel = 1;
+  first.radianceSum     = { 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f };
+
+  light::PartialResult second;
+  second.unit.x          = 1;
+  second.unit.width      = 1;
+  second.unit.height     = 1;
+  second.samplesPerPixel = 3;
+  second.radianceSum     = { 9.0f, 0.0f, 0.0f, 3.0f };
+
+  buffer.merge( first );
+  buffer.merge( second );
+
+  std::vector< float > rgba;
+  buffer.resolve( &rgba );
+
+  EXPECT_FLOAT_EQ( 1.0f,  rgba[ 0 ] );
+  EXPECT_FLOAT_EQ( 2.5f,  rgba[ 4 ] );
+  EXPECT_FLOAT_EQ( 1.0f,  rgba[ 7 ] );
+  EXPECT_EQ( 4u, buffer.getSampleCount( 1, 0 ) );
+
+}
+
+
+
+//////////////////////////////////////////////////////////
+// messages survive the encode/decode round trip
+//////////////////////////////////////////////////////////
+TEST( DistributedUnitTests, SettingsRoundTrip )
+{
+
+  light::RenderSettings settings;
+  settings.sceneType   = 2;
+  settings.modelFile   = "models/x-wing.obj";
+  settings.width       = 640;
+  settings.height      = 480;
+  settings.W[ 2 ]      = -1.0f;
+  settings.sqrtSamples = 3;
+  settings.globalSeed  = 0xdeadbeef;
+  settings.pathTracing = false;
+  settings.roulettePolicy    = 0;
+  settings.rouletteMinDepth  = 4;
+  settings.firstBounceSplits = 3;
+  settings.mathPrecision     = 1;
+
+  light::RenderSettings decoded;
+  light::decode( light::encode( settings ), &decoded );
+
+  EXPECT_EQ( settings.sceneType,   decoded.sceneType );
+  EXPECT_EQ( settings.modelFile,   decoded.modelFile );
+  EXPECT_EQ( settings.width,       decoded.width );
+  EXPECT_EQ( settings.height,      decoded.height );
+  EXPECT_EQ( settings.W[ 2 ],      decoded.W[ 2 ] );
+  EXPECT_EQ( settings.sqrtSamples, decoded.sqrtSamples );
+  EXPECT_EQ( settings.globalSeed,  decoded.globalSeed );
+  EXPECT_EQ( settings.pathTracing, decoded.pathTracing );
+  EXPECT_EQ( settings.roulettePolicy,    decoded.roulettePolicy );
+  EXPECT_EQ( settings.rouletteMinDepth,  decoded.rouletteMinDepth );
+  EXPECT_EQ( settings.firstBounceSplits, decoded.firstBounceSplits );
+  EXPECT_EQ( settings.mathPrecision,     decoded.mathPrecision );
+
+}
+
+
+
+//////////////////////////////////////////////////////////
+// fields go on the wire little-endian whatever the host
+//////////////////////////////////////////////////////////
+TEST( DistributedUnitTests, WireFormatIsLittleEndian )
+{
+
+  light::PartialResult result;
+  result.unit.x          = 0x01020304u;
+  result.unit.width      = 1;
+  result.unit.height     = 1;
+  result.samplesPerPixel = 0x0a0b0c0du;
+  result.radianceSum     = { 1.0f, -2.0f, 0.5f, 0.0f };
+
+  std::vector< unsigned char > bytes = light::encode( result );
+
+  EXPECT_EQ( 0x04, bytes[ 0 ] );
+  EXPECT_EQ( 0x03, bytes[ 1 ] );
+  EXPECT_EQ( 0x02, bytes[ 2 ] );
+  EXPECT_EQ( 0x01, bytes[ 3 ] );
+
+  // 1.0f is 0x3f800000, right after the unit, sample and value counts
+  std::size_t first = 6 * 4 + sizeof( result.samplesPerPixel ) + 8;
+
+  EXPECT_EQ( 0x00, bytes[ first + 0 ] );
+  EXPECT_EQ( 0x00, bytes[ first + 1 ] );
+  EXPECT_EQ( 0x80, bytes[ first + 2 ] );
+  EXPECT_EQ( 0x3f, bytes[ first + 3 ] );
+
+  light::PartialResult decoded;
+  light::decode( bytes, &decoded );
+
+  EXPECT_EQ( result.unit.x,          decoded.unit.x );
+  EXPECT_EQ( result.samplesPerPixel, decoded.samplesPerPixel );
+  EXPECT_THAT( decoded.radianceSum, ::testing::ContainerEq( result.radianceSum ) );
+
+}
+
+
+
+//////////////////////////////////////////////////////////
+// two workers over localhost produce the same image as
+// a single process accumulating every frame
+//////////////////////////////////////////////////////////
+TEST( DistributedUnitTests, CoordinatorMergesWorkers )
+{
+
+  constexpr unsigned width  = 37;
+  constexpr unsigned height = 21;
+  constexpr unsigned frames = 10;
+
+  std::vector< std::unique_ptr< light::RenderWorker > > workers;
+  std::vector< std::thread > threads;
+  std::vector< light::WorkerAddress > addresses;
+
+  for ( int i = 0; i < 2; ++i )
+  {
+
+    workers.emplace_back( new light::RenderWorker(
+                                                  std::unique_ptr< light::WorkerRendererInterface >(
+                                                                                                     new FakeWorkerRenderer( )
+                                                                                                     )
+                                                  ) );
+
+    addresses.push_back( { "127.0.0.1", workers.back( )->getPort( ) } );
+
+    threads.emplace_back( &light::RenderWorker::serve, workers.back( ).get( ) );
+
+  }
+
+  light::RenderSettings settings;
+  settings.width       = width;
+  settings.height      = height;
+  settings.sqrtSamples = 2;
+
+  light::RenderCoordinator coordinator( addresses );
+  coordinator.setTileSize     ( 8 );
+  coordinator.setFramesPerUnit( 3 );
+
+  light::AccumulationBuffer buffer = coordinator.render( settings, frames );
+
+  coordinator.shutdownWorkers( );
+
+  for ( std::thread &thread : threads )
+  {
+    thread.join( );
+  }
+
+  std::vector< float > rgba;
+  buffer.resolve( &rgba );
+
+  for ( unsigned y = 0; y < height; ++y )
+  {
+
+    for ( unsigned x = 0; x < width; ++x )
+    {
+
+      float expected = static_cast< float >( x + y * width ) + ( frames - 1 ) * 0.5f;
+
+      EXPECT_FLOAT_EQ( expected, rgba[ ( y * width + x ) * 4 ] );
+      EXPECT_EQ( frames * 4u, buffer.getSampleCount( x, y ) );
+
+    }
+
+  }
+
+}
+
+
+
+} // namespace
@@ -0,0 +1,301 @@
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include "gmock/gmock.h"
+#include "FastMath.hpp"
+#include "SimdMath.hpp"
+
+
+namespace
+{
+
+
+namespace simd = light::LIGHT_SIMD_NAMESPACE;
+
+
+// the documented bounds from FastMath.hpp
+constexpr double exp2Bound  = 3e-6;
+constexpr double expBound   = 1e-5;
+constexpr double log2Bound  = 1e-5;
+constexpr double rsqrtBound = 6.6e-4;
+constexpr double acosBound  = 7e-5;
+
+double powBound( double y ) { return 3e-6 + 7e-6 * std::abs( y ); }
+
+
+///
+/// \brief The MaxErrors struct
+///
+///        Worst errors seen against double precision references
+///
+struct MaxErrors
+{
+  double exp2  = 0.0;
+  double exp   = 0.0;
+  double log2  = 0.0;
+  double rsqrt = 0.0;
+  double acos  = 0.0;
+
+
+  void add(
+           float  x,
+           double fastExp2,
+           double fastExp,
+           double fastLog2,
+           double fastRsqrt,
+           double fastAcos
+           )
+  {
+
+    double value = x;
+
+    if ( std::abs( value ) <= 126.0 )
+    {
+      exp2 = std::max( exp2, std::abs( fastExp2 / std::exp2( value ) - 1.0 ) );
+    }
+
+    if ( value >= -87.0 && value <= 88.0 )
+    {
+      exp = std::max( exp, std::abs( fastExp / std::exp( value ) - 1.0 ) );
+    }
+
+    if ( std::isnormal( x ) && x > 0.0f )
+    {
+
+      log2  = std::max( log2,  std::abs( fastLog2 - std::log2( value ) ) );
+      rsqrt = std::max( rsqrt, std::abs( fastRsqrt * std::sqrt( value ) - 1.0 ) );
+
+    }
+
+    if ( std::abs( value ) <= 1.0 )
+    {
+      acos = std::max( acos, std::abs( fastAcos - std::acos( value ) ) );
+    }
+
+  }
+
+};
+
+
+float
+floatFromBits( std::uint32_t bits )
+{
+
+  float x;
+  std::memcpy( &x, &bits, sizeof( x ) );
+
+  return x;
+
+}
+
+
+void
+expectWithinBounds( const MaxErrors &errors )
+{
+
+  EXPECT_LT( errors.exp2,  exp2Bound );
+  EXPECT_LT( errors.exp,   expBound );
+  EXPECT_LT( errors.log2,  log2Bound );
+  EXPECT_LT( errors.rsqrt, rsqrtBound );
+  EXPECT_LT( errors.acos,  acosBound );
+
+}
+
+
+///
+/// \brief checkSimdBounds
+///
+///        Runs every finite float, in steps, through the N lane
+///        versions
+///
+template< int N >
+void
+checkSimdBounds( )
+{
+
+  MaxErrors errors;
+  float     inputs[ N ];
+  int       count = 0;
+
+  auto flush = [ &errors, &inputs, &count ]( )
+  {
+
+    simd::VFloat< N > x = simd::VFloat< N >::load( inputs );
+
+    simd::VFloat< N > exp2  = simd::fastExp2( x );
+    simd::VFloat< N > exp   = simd::fastExp( x );
+    simd::VFloat< N > log2  = simd::fastLog2( x );
+    simd::VFloat< N > rsqrt = simd::fastRsqrt( x );
+    simd::VFloat< N > acos  = simd::fastAcos( x );
+
+    for ( int i = 0; i < count; ++i )
+    {
+      errors.add( inputs[ i ], exp2[ i ], exp[ i ], log2[ i ], rsqrt[ i ], acos[ i ] );
+    }
+
+    count = 0;
+
+  };
+
+  for ( std::uint64_t bits = 0; bits < 0x100000000ull; bits += 4099 )
+  {
+
+    float x = floatFromBits( static_cast< std::uint32_t >( bits ) );
+
+    if ( std::isfinite( x ) )
+    {
+
+      inputs[ count++ ] = x;
+
+      if ( count == N )
+      {
+        flush( );
+      }
+
+    }
+
+  }
+
+  std::fill( inputs + count, inputs + N, 1.0f );
+  flush( );
+
+  expectWithinBounds( errors );
+
+}
+
+
+
+TEST( FastMathUnitTests, ScalarVariantsStayWithinTheirBounds )
+{
+
+  MaxErrors errors;
+
+  for ( std::uint64_t bits = 0; bits < 0x100000000ull; bits += 257 )
+  {
+
+    float x = floatFromBits( static_cast< std::uint32_t >( bits ) );
+
+    if ( std::isfinite( x ) )
+    {
+      errors.add( x, fastExp2( x ), fastExp( x ), fastLog2( x ), fastRsqrt( x ), fastAcos( x ) );
+    }
+
+  }
+
+  expectWithinBounds( errors );
+
+  // the ends of the ranges where shading uses them
+  EXPECT_FLOAT_EQ( 0.0f, fastLog2( 1.0f ) );
+  EXPECT_NEAR( 0.0f,     fastAcos( 1.0f ),  1e-6f );
+  EXPECT_NEAR( FAST_PI,  fastAcos( -1.0f ), 1e-6f );
+  EXPECT_LT  ( fastExp( -200.0f ), 1e-37f );
+
+}
+
+
+
+TEST( FastMathUnitTests, PowStaysWithinItsBoundForShadingExponents )
+{
+
+  double worst = 0.0;
+
+  for ( float y = 0.0f; y <= 512.0f; y += 0.73f )
+  {
+
+    for ( float x = 1e-3f; x <= 8.0f; x *= 1.0021f )
+    {
+
+      double exponent = y * std::log2( static_cast< double >( x ) );
+
+      if ( exponent <= -125.0 || exponent >= 126.0 )
+      {
+        continue;
+      }
+
+      double reference = std::pow( static_cast< double >( x ), static_cast< double >( y ) );
+
+      worst = std::max( worst, std::abs( fastPow( x, y ) / reference - 1.0 ) / powBound( y ) );
+
+    }
+
+  }
+
+  EXPECT_LT( worst, 1.0 );
+
+  EXPECT_EQ( 0.0f, fastPow( 0.0f,  3.0f ) );
+  EXPECT_EQ( 0.0f, fastPow( -2.0f, 3.0f ) );
+
+}
+
+
+
+TEST( FastMathUnitTests, SimdVariantsStayWithinTheSameBounds )
+{
+
+  checkSimdBounds< 4 >( );
+  checkSimdBounds< 8 >( );
+  checkSimdBounds< 16 >( );
+
+  float x[ 4 ] = { 3.0f, 0.0f, -1.0f, 1e-3f };
+  float y[ 4 ] = { 4.0f, 0.5f, 2.0f,  0.0f };
+  float z[ 4 ] = { 0.0f, 0.0f, 2.0f,  1e-3f };
+
+  simd::VFloat< 4 > vx = simd::VFloat< 4 >::load( x );
+  simd::VFloat< 4 > vy = simd::VFloat< 4 >::load( y );
+  simd::VFloat< 4 > vz = simd::VFloat< 4 >::load( z );
+
+  simd::fastNormalize( vx, vy, vz );
+
+  for ( int i = 0; i < 4; ++i )
+  {
+
+    float length = std::sqrt( vx[ i ] * vx[ i ] + vy[ i ] * vy[ i ] + vz[ i ] * vz[ i ] );
+    EXPECT_NEAR( 1.0f, length, rsqrtBound ) << "vector " << i;
+
+  }
+
+  simd::VFloat< 4 > powers = simd::fastPow( simd::VFloat< 4 >::load( x ), simd::VFloat< 4 >( 2.0f ) );
+
+  EXPECT_NEAR( 9.0f, powers[ 0 ], 9.0f * powBound( 2.0 ) );
+  EXPECT_EQ  ( 0.0f, powers[ 1 ] );
+  EXPECT_EQ  ( 0.0f, powers[ 2 ] );
+
+}
+
+
+
+TEST( FastMathUnitTests, PrecisionPolicyPicksTheVariant )
+{
+
+  struct Vector
+  {
+    float x, y, z;
+  };
+
+  for ( float x : { 0.1f, 0.5f, 0.9f } )
+  {
+
+    EXPECT_EQ( std::exp( x ),          mathExp( x, MATH_PRECISE ) );
+    EXPECT_EQ( fastExp( x ),           mathExp( x, MATH_FAST ) );
+    EXPECT_EQ( std::pow( x, 20.0f ),   mathPow( x, 20.0f, MATH_PRECISE ) );
+    EXPECT_EQ( fastPow( x, 20.0f ),    mathPow( x, 20.0f, MATH_FAST ) );
+    EXPECT_EQ( std::acos( x ),         mathAcos( x, MATH_PRECISE ) );
+    EXPECT_EQ( fastAcos( x ),          mathAcos( x, MATH_FAST ) );
+    EXPECT_EQ( fastRsqrt( x ),         mathRsqrt( x, MATH_FAST ) );
+    EXPECT_FLOAT_EQ( 1.0f / std::sqrt( x ), mathRsqrt( x, MATH_PRECISE ) );
+
+  }
+
+  Vector v       = { 3.0f, 4.0f, 12.0f };
+  Vector precise = mathNormalize( v, MATH_PRECISE );
+  Vector fast    = mathNormalize( v, MATH_FAST );
+
+  EXPECT_FLOAT_EQ( 3.0f / 13.0f,  precise.x );
+  EXPECT_FLOAT_EQ( 12.0f / 13.0f, precise.z );
+  EXPECT_NEAR    ( 4.0f / 13.0f,  fast.y, 4.0f / 13.0f * rsqrtBound );
+
+}
+
+
+} // namespace
@@ -0,0 +1,411 @@
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <thread>
+#include <iostream>
+#include <algorithm>
+#include "gmock/gmock.h"
+#include "BuiltinScenes.hpp"
+#include "HostScene.hpp"
+#include "HostRenderer.hpp"
+#include "ImageIO.hpp"
+#include "ImageMetrics.hpp"
+
+
+#ifndef LIGHT_GOLDEN_DIR
+#define LIGHT_GOLDEN_DIR "src/testing/golden/"
+#endif
+
+
+//
+// The scenes are path traced on the host (HostRenderer with
+// pathTracing), which bounces through the shared headers of
+// closest_hit_bsdf: its Oren-Nayar, GGX and Fresnel terms, lobe
+// sampling, roulette, first bounce splits and math precision. The
+// images guard those, the scene builders and the host BVH; the
+// OptiX programs' own plumbing still needs a GPU.
+//
+
+
+namespace
+{
+
+
+// small enough that both scenes path trace in a few seconds
+constexpr unsigned width          = 64;
+constexpr unsigned height         = 48;
+constexpr unsigned sqrtSamples    = 2;
+constexpr unsigned frames         = 64;
+constexpr unsigned referenceFrame = 1024;
+
+// reference frames are seeded apart from the tested ones
+constexpr unsigned referenceSeed = 0x40000000u;
+
+// near-mirror surfaces that catch a light sample in their GGX
+// lobe make rare fireflies far brighter than any light. Frames are
+// clamped here, the reference's too, above the lights' own
+// radiance so that only those are cut.
+constexpr float maxFrameRadiance = 32.0f;
+
+// a channel fails when it is further than maxZ standard errors
+// from the reference, plus a floor for pixels that had no variance
+// in the tested frames. The clamped fireflies still leave a few
+// pixels and the relMSE noisy, so those bounds are loose; the mean
+// brightness is what catches a biased estimator.
+constexpr double maxZ            = 5.0;
+constexpr double absoluteFloor   = 2e-3;
+constexpr double relativeFloor   = 0.02;
+constexpr double maxFailFraction = 0.03;
+
+constexpr double maxRelMse         = 0.03;
+constexpr double maxMeanDifference = 0.01;
+
+// fast math previews against precise renders of the same samples;
+// a few paths take another lobe or end in another roulette draw
+constexpr double maxFastRelMse         = 1e-4;
+constexpr double maxFastMeanDifference = 3e-3;
+
+
+///
+/// \brief The GoldenCase struct
+///
+///        A builtin scene and the fixed camera it is checked from;
+///        the advanced scene is a closed room, so its camera is inside
+///
+struct GoldenCase
+{
+  std::string             name;
+  light::SceneDescription scene;
+  light::Float3           eye, U, V, W;
+};
+
+
+///
+/// \brief The FrameStatistics struct
+///
+///        Per channel mean of a set of frames and the variance of
+///        that mean
+///
+struct FrameStatistics
+{
+  light::Image         mean;
+  std::vector< float > meanVariance;
+};
+
+
+GoldenCase
+basicCase( )
+{
+
+  GoldenCase golden;
+  golden.name  = "basic";
+  golden.scene = light::buildBasicScene( );
+  golden.eye   = light::Float3 { 0.0f, 2.0f, 9.0f };
+  golden.U     = light::Float3 { 0.8f, 0.0f, 0.0f };
+  golden.V     = light::Float3 { 0.0f, 0.6f, 0.0f };
+  golden.W     = light::Float3 { 0.0f, -0.25f, -1.0f };
+
+  return golden;
+
+}
+
+
+GoldenCase
+advancedCase( )
+{
+
+  GoldenCase golden;
+  golden.name  = "advanced";
+  golden.scene = light::buildAdvancedScene( );
+  golden.eye   = light::Float3 { 0.0f, 3.5f, 4.5f };
+  golden.U     = light::Float3 { 1.0f, 0.0f, 0.0f };
+  golden.V     = light::Float3 { 0.0f, 0.75f, 0.0f };
+  golden.W     = light::Float3 { 0.0f, -0.35f, -1.0f };
+
+  return golden;
+
+}
+
+
+///
+/// \brief goldenSettings
+///
+///        Path tracing with the device's default bounces and
+///        minimum depth, throughput roulette and two first
+///        bounce splits
+///
+light::HostRenderSettings
+goldenSettings( )
+{
+
+  light::HostRenderSettings settings;
+  settings.sqrtSamples = sqrtSamples;
+  settings.numThreads  = std::max( 1u, std::thread::hardware_concurrency( ) );
+  settings.pathTracing = true;
+  settings.maxBounces  = 3;
+  settings.roulette    = ROULETTE_THROUGHPUT;
+  settings.minDepth    = 2;
+  settings.splits      = 2;
+
+  return settings;
+
+}
+
+
+///
+/// \brief renderStatistics
+///
+///        Renders frames seeded firstSeed, firstSeed + 1, ... and
+///        returns their per channel mean and its variance
+///
+FrameStatistics
+renderStatistics(
+                 const GoldenCase          &golden,
+                 light::HostRenderSettings  settings,
+                 unsigned                   frameCount,
+                 unsigned                   firstSeed
+                 )
+{
+
+  light::HostScene    scene( golden.scene );
+  light::HostRenderer renderer( scene, width, height );
+  renderer.setCamera( golden.eye, golden.U, golden.V, golden.W );
+
+  std::size_t           count = static_cast< std::size_t >( width ) * height * 4;
+  std::vector< double > sum( count, 0.0 );
+  std::vector< double > sumSquares( count, 0.0 );
+
+  for ( unsigned frame = 0; frame < frameCount; ++frame )
+  {
+
+    settings.seed = firstSeed + frame;
+    renderer.render( settings );
+
+    std::vector< float > pixels = renderer.getPixels( );
+
+    for ( std::size_t i = 0; i < count; ++i )
+    {
+
+      double value = std::min( pixels[ i ], maxFrameRadiance );
+
+      sum       [ i ] += value;
+      sumSquares[ i ] += value * value;
+
+    }
+
+  }
+
+  FrameStatistics statistics;
+  statistics.mean.width  = width;
+  statistics.mean.height = height;
+  statistics.mean.rgba.resize( count );
+  statistics.meanVariance.resize( count );
+
+  for ( std::size_t i = 0; i < count; ++i )
+  {
+
+    double mean     = sum[ i ] / frameCount;
+    double variance = std::max( 0.0, sumSquares[ i ] / frameCount - mean * mean ) * frameCount / ( frameCount - 1 );
+
+    statistics.mean.rgba    [ i ] = static_cast< float >( mean );
+    statistics.meanVariance [ i ] = static_cast< float >( variance / frameCount );
+
+  }
+
+  return statistics;
+
+}
+
+
+double
+meanRgb( const light::Image &image )
+{
+
+  double sum = 0.0;
+
+  for ( std::size_t i = 0; i < image.rgba.size( ); i += 4 )
+  {
+    sum += image.rgba[ i ] + image.rgba[ i + 1 ] + image.rgba[ i + 2 ];
+  }
+
+  return sum / ( image.rgba.size( ) / 4 * 3 );
+
+}
+
+
+///
+/// \brief checkGolden
+///
+///        Renders a case and checks it against its stored reference,
+///        or replaces the reference when LIGHT_UPDATE_GOLDEN is set
+///
+void
+checkGolden(
+            const GoldenCase                &golden,
+            const light::HostRenderSettings &settings = goldenSettings( )
+            )
+{
+
+  std::string referenceFile = std::string( LIGHT_GOLDEN_DIR ) + golden.name + ".pfm";
+
+  const char *pUpdate = std::getenv( "LIGHT_UPDATE_GOLDEN" );
+
+  if ( pUpdate && std::string( pUpdate ) != "0" )
+  {
+
+    FrameStatistics reference = renderStatistics( golden, settings, referenceFrame, referenceSeed );
+    light::writePFM( referenceFile, width, height, reference.mean.rgba );
+
+    std::cout << "Wrote " << referenceFile << std::endl;
+    return;
+
+  }
+
+  light::Image reference = light::readImage( referenceFile );
+
+  ASSERT_EQ( width,  reference.width )  << referenceFile;
+  ASSERT_EQ( height, reference.height ) << referenceFile;
+
+  FrameStatistics test = renderStatistics( golden, settings, frames, 0 );
+
+  // the reference's own noise has the same per frame variance
+  double referenceShare = static_cast< double >( frames ) / referenceFrame;
+
+  std::size_t failed = 0;
+  std::size_t pixels = static_cast< std::size_t >( width ) * height;
+
+  for ( std::size_t p = 0; p < pixels; ++p )
+  {
+
+    bool pixelFailed = false;
+
+    for ( std::size_t c = p * 4; c < p * 4 + 3; ++c )
+    {
+
+      double expected  = reference.rgba[ c ];
+      double tolerance = maxZ * std::sqrt( test.meanVariance[ c ] * ( 1.0 + referenceShare ) )
+                         + absoluteFloor + relativeFloor * std::abs( expected );
+
+      pixelFailed = pixelFailed || std::abs( test.mean.rgba[ c ] - expected ) > tolerance;
+
+    }
+
+    failed += pixelFailed ? 1 : 0;
+
+  }
+
+  double failFraction = static_cast< double >( failed ) / pixels;
+
+  light::ImageCompareOptions options;
+  options.ssim = false;
+  options.flip = false;
+
+  light::ImageMetrics metrics = light::compareImages( test.mean, reference, options );
+
+  double meanDifference = std::abs( meanRgb( test.mean ) / std::max( meanRgb( reference ), 1e-6 ) - 1.0 );
+
+  EXPECT_LE( failFraction,   maxFailFraction )   << golden.name << ": " << failed << " pixels outside tolerance";
+  EXPECT_LE( metrics.relMse, maxRelMse )         << golden.name;
+  EXPECT_LE( meanDifference, maxMeanDifference ) << golden.name << ": mean brightness";
+
+  if ( ::testing::Test::HasFailure( ) )
+  {
+
+    std::string actualFile = ::testing::TempDir( ) + golden.name + "_actual.pfm";
+    light::writePFM( actualFile, width, height, test.mean.rgba );
+
+    std::cout << "Wrote the failing render to " << actualFile << std::endl;
+
+  }
+
+}
+
+
+
+TEST( GoldenImageTests, BasicSceneMatchesReference )
+{
+
+  checkGolden( basicCase( ) );
+
+}
+
+
+
+TEST( GoldenImageTests, AdvancedSceneMatchesReference )
+{
+
+  checkGolden( advancedCase( ) );
+
+}
+
+
+
+//////////////////////////////////////////////////////////
+// every policy estimates the same image, so the others and
+// unsplit paths must match the throughput reference too
+//////////////////////////////////////////////////////////
+TEST( GoldenImageTests, RoulettePoliciesMatchTheSameReference )
+{
+
+  const char *pUpdate = std::getenv( "LIGHT_UPDATE_GOLDEN" );
+
+  if ( pUpdate && std::string( pUpdate ) != "0" )
+  {
+    return;
+  }
+
+  light::HostRenderSettings albedo = goldenSettings( );
+  albedo.roulette = ROULETTE_ALBEDO;
+  albedo.splits   = 1;
+
+  light::HostRenderSettings efficiency = goldenSettings( );
+  efficiency.roulette      = ROULETTE_EFFICIENCY;
+  efficiency.rouletteScale = 2.0f;
+
+  for ( const light::HostRenderSettings &settings : { albedo, efficiency } )
+  {
+
+    SCOPED_TRACE( settings.roulette == ROULETTE_ALBEDO ? "albedo" : "efficiency" );
+
+    checkGolden( basicCase( ), settings );
+    checkGolden( advancedCase( ), settings );
+
+  }
+
+}
+
+
+
+TEST( GoldenImageTests, FastMathPreviewStaysCloseToPrecise )
+{
+
+  light::ImageCompareOptions options;
+  options.ssim = false;
+  options.flip = false;
+
+  for ( const GoldenCase &golden : { basicCase( ), advancedCase( ) } )
+  {
+
+    // same seeds, so only the math differs
+    light::HostRenderSettings settings = goldenSettings( );
+
+    settings.math = MATH_PRECISE;
+    FrameStatistics precise = renderStatistics( golden, settings, 4, 0 );
+
+    settings.math = MATH_FAST;
+    FrameStatistics fast = renderStatistics( golden, settings, 4, 0 );
+
+    light::ImageMetrics metrics = light::compareImages( fast.mean, precise.mean, options );
+
+    double meanDifference = std::abs( meanRgb( fast.mean ) / std::max( meanRgb( precise.mean ), 1e-6 ) - 1.0 );
+
+    EXPECT_LE( metrics.relMse, maxFastRelMse )         << golden.name;
+    EXPECT_LE( meanDifference, maxFastMeanDifference ) << golden.name << ": mean brightness";
+
+  }
+
+}
+
+
+} // namespace
@@ -0,0 +1,420 @@
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+#include "gmock/gmock.h"
+#include "HostScene.hpp"
+#include "BuiltinScenes.hpp"
+
+
+namespace
+{
+
+
+///
+/// \brief makeTriangleSoup
+///
+///        Mesh of random small triangles inside a unit cube
+///
+light::SceneDescription
+makeTriangleSoup(
+                 unsigned triangleCount,
+                 unsigned seed
+                 )
+{
+
+  std::mt19937 generator( seed );
+  std::uniform_real_distribution< float > position( -1.0f, 1.0f );
+  std::uniform_real_distribution< float > offset( -0.1f, 0.1f );
+
+  std::vector< light::Float3 >        vertices;
+  std::vector< std::uint32_t >        triangles;
+
+  for ( unsigned t = 0; t < triangleCount; ++t )
+  {
+
+    light::Float3 center = { position( generator ), position( generator ), position( generator ) };
+
+    for ( unsigned corner = 0; corner < 3; ++corner )
+    {
+
+      triangles.push_back( static_cast< std::uint32_t >( vertices.size( ) ) );
+      vertices.push_back( light::Float3 {
+                            center.x + offset( generator ),
+                            center.y + offset( generator ),
+                            center.z + offset( generator )
+                          } );
+
+    }
+
+  }
+
+  light::SceneDescription scene;
+
+  std::uint32_t mesh     = scene.addMesh( vertices, { }, triangles );
+  std::uint32_t material = scene.addMaterial( { 0.5f, 0.5f, 0.5f }, 0.5f, { 1.5f, 1.5f, 1.5f } );
+
+  scene.addShape( "soup", { mesh }, material, light::makeTransform( ), light::AccelHint::BVH );
+
+  return scene;
+
+}
+
+
+light::HostRay
+makeRay(
+        light::Float3 origin,
+        light::Float3 direction
+        )
+{
+
+  return light::HostRay { origin, direction, 1e-4f, 1e30f };
+
+}
+
+
+
+//////////////////////////////////////////////////////////
+// the BVH finds exactly what testing every triangle finds
+//////////////////////////////////////////////////////////
+TEST( HostSceneUnitTests, BvhMatchesBruteForce )
+{
+
+  light::SceneDescription soup = makeTriangleSoup( 2000, 7 );
+
+  light::HostScene bvh       ( soup );
+  light::HostScene bruteForce( soup, 1u << 30 ); // one leaf holding everything
+
+  std::mt19937 generator( 11 );
+  std::uniform_real_distribution< float > uniform( -1.0f, 1.0f );
+
+  unsigned hits = 0;
+
+  for ( unsigned i = 0; i < 2000; ++i )
+  {
+
+    light::HostRay ray = makeRay(
+                                 { uniform( generator ) * 1.2f, uniform( generator ) * 1.2f, 3.0f },
+                                 { uniform( generator ) * 0.1f, uniform( generator ) * 0.1f, -1.0f }
+                                 );
+
+    light::HostHit expected, actual;
+
+    bool expectedHit = bruteForce.intersect( ray, &expected );
+    bool actualHit   = bvh.intersect( ray, &actual );
+
+    ASSERT_EQ( expectedHit, actualHit );
+    ASSERT_EQ( expectedHit, bvh.occluded( ray ) );
+
+    if ( expectedHit )
+    {
+
+      EXPECT_FLOAT_EQ( expected.t, actual.t );
+      ++hits;
+
+    }
+
+  }
+
+  // enough rays hit for the comparison to mean something
+  EXPECT_GT( hits, 500u );
+
+}
+
+
+
+//////////////////////////////////////////////////////////
+// a thousand instances of one mesh share its bottom level
+//////////////////////////////////////////////////////////
+TEST( HostSceneUnitTests, InstancesShareBottomLevel )
+{
+
+  light::SceneDescription fleet = makeTriangleSoup( 1000, 3 );
+
+  light::HostScene single( fleet );
+  std::size_t singleBytes = single.getAccelerationBytes( );
+
+  std::uint32_t red = fleet.addMaterial( { 0.9f, 0.1f, 0.1f }, 0.5f, { 1.5f, 1.5f, 1.5f } );
+
+  for ( unsigned i = 0; i < 1000; ++i )
+  {
+
+    fleet.addInstance(
+                      "ship " + std::to_string( i ),
+                      0,
+                      red,
+                      light::makeTransform( { static_cast< float >( i % 32 ) * 4.0f, static_cast< float >( i / 32 ) * 4.0f, -10.0f } )
+                      );
+
+  }
+
+  light::HostScene scene( fleet );
+
+  EXPECT_EQ( 1u,    scene.getBottomLevelCount( ) );
+  EXPECT_EQ( 1001u, scene.getInstanceCount( ) );
+
+  // instances cost far less than another copy of the mesh each
+  EXPECT_LT( scene.getAccelerationBytes( ), singleBytes + 1000 * 256 );
+
+  // a ray that hits the original hits instance 33 when moved with it
+  const std::vector< light::Float3 > &vertices = fleet.getVertices( );
+
+  light::Float3 center = {
+    ( vertices[ 0 ].x + vertices[ 1 ].x + vertices[ 2 ].x ) / 3.0f,
+    ( vertices[ 0 ].y + vertices[ 1 ].y + vertices[ 2 ].y ) / 3.0f,
+    0.0f
+  };
+  light::HostRay ray   = makeRay( { center.x, center.y, 10.0f }, { 0.0f, 0.0f, -1.0f } );
+  light::HostHit original, hit;
+
+  ASSERT_TRUE( single.intersect( ray, &original ) );
+
+  ray.origin = light::Float3 { center.x + 4.0f, center.y + 4.0f, 10.0f };
+
+  ASSERT_TRUE( scene.intersect( ray, &hit ) );
+  EXPECT_NEAR( original.t + 10.0f, hit.t, 1e-3f );
+  EXPECT_EQ( red, hit.material );
+  EXPECT_EQ( "ship 33", scene.getSceneDescription( ).getShapeNames( )[ hit.shape ] );
+
+}
+
+
+
+//////////////////////////////////////////////////////////
+// transformed analytic primitives report world distances
+// and world normals
+//////////////////////////////////////////////////////////
+TEST( HostSceneUnitTests, TransformedPrimitives )
+{
+
+  light::SceneDescription description;
+
+  std::uint32_t sphere   = description.addSphere( );
+  std::uint32_t box      = description.addBox( );
+  std::uint32_t quad     = description.addQuad( );
+  std::uint32_t material = description.addMaterial( { 0.5f, 0.5f, 0.5f }, 0.5f, { 1.5f, 1.5f, 1.5f } );
+
+  description.addShape( "sphere", { sphere }, material, light::makeTransform( { 0.0f, 0.0f, 0.0f }, { 2.0f, 2.0f, 2.0f } ) );
+  description.addShape( "box",    { box },    material, light::makeTransform( { 10.0f, 0.0f, 0.0f } ) );
+  description.addShape(
+                       "floor",
+                       { quad },
+                       material,
+                       light::makeTransform(
+                                            { 0.0f, -5.0f, 0.0f },
+                                            { 20.0f, 20.0f, 1.0f },
+                                            3.14159265f * 0.5f,
+                                            { 1.0f, 0.0f, 0.0f }
+                                            )
+                       );
+
+  light::HostScene scene( description );
+  light::HostHit hit;
+
+  ASSERT_TRUE( scene.intersect( makeRay( { 0.0f, 0.0f, 10.0f }, { 0.0f, 0.0f, -1.0f } ), &hit ) );
+  EXPECT_NEAR( 8.0f, hit.t, 1e-4f );
+  EXPECT_NEAR( 1.0f, hit.normal.z, 1e-4f );
+  EXPECT_EQ( 0u, hit.shape );
+
+  ASSERT_TRUE( scene.intersect( makeRay( { 10.0f, 0.0f, 10.0f }, { 0.0f, 0.0f, -2.0f } ), &hit ) );
+  EXPECT_NEAR( 4.5f, hit.t, 1e-4f ); // direction isn't normalized
+  EXPECT_EQ( 1u, hit.shape );
+
+  ASSERT_TRUE( scene.intersect( makeRay( { 5.0f, 0.0f, 0.0f }, { 0.0f, -1.0f, 0.0f } ), &hit ) );
+  EXPECT_NEAR( 5.0f, hit.t, 1e-4f );
+  EXPECT_NEAR( 1.0f, std::abs( hit.normal.y ), 1e-4f );
+  EXPECT_EQ( 2u, hit.shape );
+
+  // from inside the sphere the far side is hit
+  ASSERT_TRUE( scene.intersect( makeRay( { 0.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f } ), &hit ) );
+  EXPECT_NEAR( 2.0f, hit.t, 1e-4f );
+
+  EXPECT_FALSE( scene.occluded( makeRay( { 0.0f, 10.0f, 0.0f }, { 0.0f, 1.0f, 0.0f } ) ) );
+
+  light::HostRay shortRay = makeRay( { 0.0f, 0.0f, 10.0f }, { 0.0f, 0.0f, -1.0f } );
+  shortRay.tmax = 7.0f;
+
+  EXPECT_FALSE( scene.occluded( shortRay ) );
+
+}
+
+
+
+//////////////////////////////////////////////////////////
+// built in scenes trace on the host
+//////////////////////////////////////////////////////////
+TEST( HostSceneUnitTests, BasicSceneTraces )
+{
+
+  light::HostScene scene( light::buildBasicScene( ) );
+  light::HostHit hit;
+
+  ASSERT_TRUE( scene.intersect( makeRay( { 1.5f, 0.0f, 10.0f }, { 0.0f, 0.0f, -1.0f } ), &hit ) );
+  EXPECT_EQ( "sphere", scene.getSceneDescription( ).getShapeNames( )[ hit.shape ] );
+
+  ASSERT_TRUE( scene.intersect( makeRay( { -1.5f, 0.0f, 10.0f }, { 0.0f, 0.0f, -1.0f } ), &hit ) );
+  EXPECT_EQ( "box", scene.getSceneDescription( ).getShapeNames( )[ hit.shape ] );
+  EXPECT_NEAR( 9.0f, hit.t, 1e-4f );
+
+  ASSERT_TRUE( scene.intersect( makeRay( { 0.0f, 5.0f, 3.0f }, { 0.0f, -1.0f, 0.0f } ), &hit ) );
+  EXPECT_EQ( "ground", scene.getSceneDescription( ).getShapeNames( )[ hit.shape ] );
+
+  // box, quad and sphere primitives, the light reuses the sphere
+  EXPECT_EQ( 3u, scene.getBottomLevelCount( ) );
+
+}
+
+
+
+//////////////////////////////////////////////////////////
+// refitting moved items gives the bounds a serial refit
+// gives and still finds every hit
+//////////////////////////////////////////////////////////
+TEST( HostSceneUnitTests, RefitTracksMovedItems )
+{
+
+  std::mt19937 generator( 5 );
+  std::uniform_real_distribution< float > uniform( -10.0f, 10.0f );
+
+  std::vector< light::Aabb > bounds( 40000 );
+
+  for ( light::Aabb &box : bounds )
+  {
+
+    light::Float3 center = { uniform( generator ), uniform( generator ), uniform( generator ) };
+    box = light::Aabb { center - light::Float3 { 0.1f, 0.1f, 0.1f }, center + light::Float3 { 0.1f, 0.1f, 0.1f } };
+
+  }
+
+  light::Bvh serial;
+  serial.build( bounds, 2 );
+
+  light::Bvh parallel = serial;
+
+  EXPECT_FLOAT_EQ( serial.getBuildSahCost( ), serial.getSahCost( ) );
+
+  // a small drift every item
+  for ( light::Aabb &box : bounds )
+  {
+
+    light::Float3 offset = { uniform( generator ) * 0.05f, uniform( generator ) * 0.05f, 0.0f };
+    box.min = box.min + offset;
+    box.max = box.max + offset;
+
+  }
+
+  serial.refit( bounds, 1 );
+  parallel.refit( bounds, 4 );
+
+  ASSERT_EQ( serial.getNodes( ).size( ), parallel.getNodes( ).size( ) );
+
+  for ( std::size_t n = 0; n < serial.getNodes( ).size( ); ++n )
+  {
+
+    const light::Aabb &a = serial.getNodes( )[ n ].bounds;
+    const light::Aabb &b = parallel.getNodes( )[ n ].bounds;
+
+    ASSERT_EQ( a.min.x, b.min.x );
+    ASSERT_EQ( a.max.y, b.max.y );
+    ASSERT_EQ( a.max.z, b.max.z );
+
+  }
+
+  // every item is still inside every box on its way to the root
+  light::Aabb root = serial.getBounds( );
+
+  for ( const light::Aabb &box : bounds )
+  {
+
+    ASSERT_LE( root.min.x, box.min.x );
+    ASSERT_GE( root.max.x, box.max.x );
+
+  }
+
+  // drift degrades the tree, but only a little
+  EXPECT_GT( serial.getSahCost( ), serial.getBuildSahCost( ) );
+  EXPECT_LT( serial.getSahCost( ), serial.getBuildSahCost( ) * 1.5f );
+
+}
+
+
+
+//////////////////////////////////////////////////////////
+// moving instances refits the top level and rebuilds it
+// once it has degraded past the threshold
+//////////////////////////////////////////////////////////
+TEST( HostSceneUnitTests, AnimatedInstances )
+{
+
+  light::SceneDescription description;
+
+  std::uint32_t sphere   = description.addSphere( );
+  std::uint32_t material = description.addMaterial( { 0.5f, 0.5f, 0.5f }, 0.5f, { 1.5f, 1.5f, 1.5f } );
+  std::uint32_t first    = description.addShape( "ball 0", { sphere }, material, light::makeTransform( ) );
+
+  for ( unsigned i = 1; i < 256; ++i )
+  {
+
+    description.addInstance(
+                            "ball " + std::to_string( i ),
+                            first,
+                            material,
+                            light::makeTransform( { static_cast< float >( i % 16 ) * 3.0f, static_cast< float >( i / 16 ) * 3.0f, 0.0f } )
+                            );
+
+  }
+
+  light::HostScene scene( description );
+  light::SceneEditor editor = scene.createSceneEditor( );
+
+  // move ball 17 from ( 3, 3 ) up out of the grid
+  std::uint32_t transform = scene.getSceneDescription( ).getShapes( )[ 17 ].transform;
+
+  editor.setTransform( transform, light::makeTransform( { 3.0f, 3.0f, 20.0f } ) );
+  scene.applySceneChanges( editor.takeChanges( ) );
+
+  EXPECT_EQ( 0u, scene.getTopLevelRebuildCount( ) );
+
+  light::HostHit hit;
+
+  ASSERT_TRUE( scene.intersect( makeRay( { 3.0f, 3.0f, 30.0f }, { 0.0f, 0.0f, -1.0f } ), &hit ) );
+  EXPECT_NEAR( 9.0f, hit.t, 1e-4f );
+  EXPECT_EQ( 17u, hit.shape );
+
+  // the ball is gone from its old place
+  light::HostRay oldPlace = makeRay( { 3.0f, 3.0f, -5.0f }, { 0.0f, 0.0f, 1.0f } );
+  oldPlace.tmax = 10.0f;
+
+  EXPECT_FALSE( scene.occluded( oldPlace ) );
+
+  // shuffling every ball far apart degrades the tree enough to rebuild
+  std::mt19937 generator( 9 );
+  std::uniform_real_distribution< float > uniform( -200.0f, 200.0f );
+
+  for ( std::uint32_t s = 0; s < 256; ++s )
+  {
+
+    editor.setTransform(
+                        scene.getSceneDescription( ).getShapes( )[ s ].transform,
+                        light::makeTransform( { uniform( generator ), uniform( generator ), uniform( generator ) } )
+                        );
+
+  }
+
+  scene.applySceneChanges( editor.takeChanges( ), 4 );
+
+  EXPECT_EQ( 1u, scene.getTopLevelRebuildCount( ) );
+  EXPECT_FLOAT_EQ( 1.0f, scene.getTopLevelCostGrowth( ) );
+
+  light::Float3 center = light::transformPoint( scene.getSceneDescription( ).getTransforms( )[ transform ], { 0.0f, 0.0f, 0.0f } );
+
+  ASSERT_TRUE( scene.intersect( makeRay( center + light::Float3 { 0.0f, 0.0f, 0.5f }, { 0.0f, 0.0f, 1.0f } ), &hit ) );
+  EXPECT_NEAR( 0.5f, hit.t, 1e-4f ); // from inside, the far side
+  EXPECT_EQ( 17u, hit.shape );
+
+}
+
+
+
+} // namespace
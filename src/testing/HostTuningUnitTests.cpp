@@ -0,0 +1,154 @@
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "gmock/gmock.h"
+#include "HostRenderer.hpp"
+#include "HostTuning.hpp"
+#include "BuiltinScenes.hpp"
+
+
+namespace
+{
+
+
+constexpr unsigned imageWidth  = 24;
+constexpr unsigned imageHeight = 16;
+
+
+void
+setTestCamera( light::HostRenderer *pRenderer )
+{
+
+  pRenderer->setCamera(
+                       light::Float3 { 0.0f, 2.0f, 10.0f },
+                       light::Float3 { 1.5f, 0.0f, 0.0f },
+                       light::Float3 { 0.0f, 1.0f, 0.0f },
+                       light::Float3 { 0.0f, -0.2f, -1.0f }
+                       );
+
+}
+
+
+
+TEST( HostTuningUnitTests, ThreadCountsDoubleUpToTheMaximum )
+{
+
+  EXPECT_EQ( std::vector< unsigned >( { 1 } ),                light::getScalingThreadCounts( 0 ) );
+  EXPECT_EQ( std::vector< unsigned >( { 1, 2, 4, 8 } ),       light::getScalingThreadCounts( 8 ) );
+  EXPECT_EQ( std::vector< unsigned >( { 1, 2, 4, 8, 12 } ),   light::getScalingThreadCounts( 12 ) );
+
+}
+
+
+
+//////////////////////////////////////////////////////////
+// pixels seed their own samples, so the image is the
+// same whatever the threads and tiles
+//////////////////////////////////////////////////////////
+TEST( HostTuningUnitTests, ImageDoesNotDependOnThreadsOrTiles )
+{
+
+  light::HostScene    scene( light::buildBasicScene( ) );
+  light::HostRenderer renderer( scene, imageWidth, imageHeight );
+  setTestCamera( &renderer );
+
+  light::HostRenderSettings settings;
+  settings.sqrtSamples = 2;
+  settings.numThreads  = 1;
+  settings.tileSize    = 16;
+
+  light::HostFrameStats stats = renderer.render( settings );
+
+  EXPECT_EQ( imageWidth * imageHeight * 4u, stats.samples );
+  EXPECT_EQ( 16u, stats.tileSize );
+
+  std::vector< float > single = renderer.getPixels( );
+
+  settings.numThreads = 4;
+  settings.tileSize   = 8;
+  renderer.render( settings );
+
+  EXPECT_EQ( single, renderer.getPixels( ) );
+
+  float sum = 0.0f;
+
+  for ( std::size_t i = 0; i < single.size( ); i += 4 )
+  {
+    sum += single[ i ] + single[ i + 1 ] + single[ i + 2 ];
+  }
+
+  EXPECT_GT( sum, 0.0f );
+
+}
+
+
+
+TEST( HostTuningUnitTests, SpeedupIsRelativeToOneThread )
+{
+
+  light::HostScene    scene( light::buildBasicScene( ) );
+  light::HostRenderer renderer( scene, imageWidth, imageHeight );
+  setTestCamera( &renderer );
+
+  std::vector< light::ScalingResult > results = light::measureScaling(
+                                                                      &renderer,
+                                                                      light::HostRenderSettings( ),
+                                                                      { 1, 2 },
+                                                                      1
+                                                                      );
+
+  ASSERT_EQ( 2u, results.size( ) );
+  EXPECT_DOUBLE_EQ( 1.0, results[ 0 ].speedup );
+  EXPECT_DOUBLE_EQ( 1.0, results[ 0 ].efficiency );
+  EXPECT_DOUBLE_EQ( results[ 1 ].speedup / 2.0, results[ 1 ].efficiency );
+  EXPECT_GT( results[ 1 ].samplesPerSecond, 0.0 );
+
+}
+
+
+
+TEST( HostTuningUnitTests, TuningRoundTripsForThisHostOnly )
+{
+
+  light::HostScene    scene( light::buildBasicScene( ) );
+  light::HostRenderer renderer( scene, imageWidth, imageHeight );
+  setTestCamera( &renderer );
+
+  light::HostTuning tuning = light::tuneHostRendering( &renderer, light::HostRenderSettings( ), 2, 1 );
+
+  EXPECT_EQ( light::getHostName( ), tuning.host );
+  EXPECT_GE( tuning.numThreads, 1u );
+  EXPECT_LE( tuning.numThreads, 2u );
+  EXPECT_THAT( tuning.tileSize, ::testing::AnyOf( 8u, 16u, 32u, 64u, 128u ) );
+  EXPECT_TRUE( light::isSimdIsaSupported( tuning.simdIsa ) );
+
+  std::string filename = ::testing::TempDir( ) + "hostTuning.txt";
+  light::writeHostTuning( filename, tuning );
+
+  light::HostTuning read;
+  ASSERT_TRUE( light::readHostTuning( filename, &read ) );
+  std::remove( filename.c_str( ) );
+
+  light::HostRenderSettings settings;
+  ASSERT_TRUE( light::applyHostTuning( read, &settings ) );
+  EXPECT_EQ( tuning.numThreads, settings.numThreads );
+  EXPECT_EQ( tuning.tileSize,   settings.tileSize );
+  EXPECT_EQ( tuning.simdIsa,    read.simdIsa );
+
+  if ( !std::getenv( "LIGHT_SIMD" ) )
+  {
+    EXPECT_EQ( tuning.simdIsa, light::getSimdIsa( ) );
+  }
+
+  light::clearPreferredSimdIsa( );
+
+  read.host += "-elsewhere";
+  EXPECT_FALSE( light::applyHostTuning( read, &settings ) );
+
+  EXPECT_FALSE( light::readHostTuning( filename, &read ) );
+
+}
+
+
+} // namespace
@@ -0,0 +1,216 @@
+#include <cstdio>
+#include <string>
+#include <fstream>
+#include <stdexcept>
+#include "gmock/gmock.h"
+#include "ImageIO.hpp"
+#include "ImageMetrics.hpp"
+
+
+namespace
+{
+
+
+constexpr unsigned imageWidth  = 48;
+constexpr unsigned imageHeight = 32;
+
+
+///
+/// \brief makeImage
+/// \return smooth gradients with a few sharp edges, plus
+///         'noise' times a fixed pseudo random pattern
+///
+light::Image
+makeImage( float noise = 0.0f )
+{
+
+  light::Image image;
+  image.width  = imageWidth;
+  image.height = imageHeight;
+
+  std::uint32_t state = 12345u;
+
+  for ( unsigned y = 0; y < imageHeight; ++y )
+  {
+
+    for ( unsigned x = 0; x < imageWidth; ++x )
+    {
+
+      state = state * 1664525u + 1013904223u;
+      float random = static_cast< float >( state >> 8 ) / 16777216.0f - 0.5f;
+
+      float edge = ( ( x / 8 + y / 8 ) & 1u ) ? 0.2f : 0.0f;
+
+      image.rgba.push_back( 0.2f + 0.5f * x / imageWidth + edge + noise * random );
+      image.rgba.push_back( 0.3f + 0.4f * y / imageHeight + noise * random );
+      image.rgba.push_back( 0.5f - edge + noise * random );
+      image.rgba.push_back( 1.0f );
+
+    }
+
+  }
+
+  return image;
+
+}
+
+
+
+TEST( ImageMetricsUnitTests, FloatFormatsRoundTripExactly )
+{
+
+  light::Image image = makeImage( 0.3f );
+  image.rgba[ 0 ] = 12.5f; // HDR values survive
+
+  std::string pfm = ::testing::TempDir( ) + "metrics.pfm";
+  std::string exr = ::testing::TempDir( ) + "metrics.exr";
+
+  light::writePFM( pfm, image.width, image.height, image.rgba );
+  light::writeEXR( exr, image.width, image.height, image.rgba );
+
+  light::Image fromPfm = light::readImage( pfm );
+  light::Image fromExr = light::readImage( exr );
+  std::remove( pfm.c_str( ) );
+  std::remove( exr.c_str( ) );
+
+  EXPECT_EQ( image.width,  fromPfm.width );
+  EXPECT_EQ( image.height, fromPfm.height );
+  EXPECT_EQ( image.rgba,   fromPfm.rgba );
+
+  EXPECT_EQ( image.width,  fromExr.width );
+  EXPECT_EQ( image.height, fromExr.height );
+  EXPECT_EQ( image.rgba,   fromExr.rgba );
+
+}
+
+
+
+TEST( ImageMetricsUnitTests, ReadsPpmVariants )
+{
+
+  light::Image image = makeImage( );
+
+  std::string ppm = ::testing::TempDir( ) + "metrics.ppm";
+  light::writePPM( ppm, image.width, image.height, image.rgba );
+
+  light::Image fromPpm = light::readImage( ppm );
+  std::remove( ppm.c_str( ) );
+
+  ASSERT_EQ( image.rgba.size( ), fromPpm.rgba.size( ) );
+
+  for ( std::size_t i = 0; i < image.rgba.size( ); ++i )
+  {
+    EXPECT_NEAR( std::min( image.rgba[ i ], 1.0f ), fromPpm.rgba[ i ], 1.0f / 255.0f );
+  }
+
+  // ASCII with a comment, top row first
+  std::string ascii = ::testing::TempDir( ) + "ascii.ppm";
+
+  {
+    std::ofstream file( ascii );
+    file << "P3\n# comment\n2 2\n10\n10 0 0  0 10 0\n0 0 10  5 5 5";
+  }
+
+  light::Image fromAscii = light::readImage( ascii );
+  std::remove( ascii.c_str( ) );
+
+  ASSERT_EQ( 2u, fromAscii.width );
+  ASSERT_EQ( 2u, fromAscii.height );
+
+  // bottom-up: the last file row comes first
+  EXPECT_THAT( fromAscii.rgba, ::testing::ElementsAre(
+                                                      0.0f, 0.0f, 1.0f, 1.0f,  0.5f, 0.5f, 0.5f, 1.0f,
+                                                      1.0f, 0.0f, 0.0f, 1.0f,  0.0f, 1.0f, 0.0f, 1.0f
+                                                      ) );
+
+  EXPECT_THROW( light::readImage( "image.png" ),                   std::runtime_error );
+  EXPECT_THROW( light::readImage( ::testing::TempDir( ) + "missing.pfm" ), std::runtime_error );
+
+}
+
+
+
+TEST( ImageMetricsUnitTests, IdenticalImagesHaveNoError )
+{
+
+  light::Image        image   = makeImage( 0.1f );
+  light::ImageMetrics metrics = light::compareImages( image, image );
+
+  EXPECT_DOUBLE_EQ( 0.0, metrics.mse );
+  EXPECT_DOUBLE_EQ( 0.0, metrics.relMse );
+  EXPECT_NEAR( 1.0, metrics.ssim, 1e-5 );
+  EXPECT_DOUBLE_EQ( 0.0, metrics.flip );
+
+}
+
+
+
+TEST( ImageMetricsUnitTests, SquaredErrorsMatchAConstantOffset )
+{
+
+  light::Image reference = makeImage( );
+  light::Image test      = reference;
+
+  for ( std::size_t i = 0; i < test.rgba.size( ); i += 4 )
+  {
+
+    test.rgba[ i + 0 ] += 0.1f;
+    test.rgba[ i + 1 ] += 0.1f;
+    test.rgba[ i + 2 ] += 0.1f;
+    test.rgba[ i + 3 ]  = 0.0f; // alpha is ignored
+
+  }
+
+  light::ImageCompareOptions options;
+  options.ssim = false;
+  options.flip = false;
+
+  light::ImageMetrics metrics = light::compareImages( test, reference, options );
+
+  EXPECT_NEAR( 0.01, metrics.mse, 1e-6 );
+  EXPECT_GT( metrics.relMse, 0.0 );
+  EXPECT_LT( metrics.relMse, 0.01 / 0.01 );
+
+  light::Image smaller = reference;
+  smaller.width -= 1;
+
+  EXPECT_THROW( light::compareImages( smaller, reference ), std::runtime_error );
+
+}
+
+
+
+TEST( ImageMetricsUnitTests, MoreNoiseScoresWorseOnEveryMetric )
+{
+
+  light::ImageCompareOptions options;
+  options.numThreads = 1;
+
+  light::ImageComparer comparer( makeImage( ), options );
+
+  light::ImageMetrics low  = comparer.compare( makeImage( 0.05f ) );
+  light::ImageMetrics high = comparer.compare( makeImage( 0.3f ) );
+
+  EXPECT_GT( low.mse,    0.0 );
+  EXPECT_GT( high.mse,   low.mse );
+  EXPECT_GT( high.relMse, low.relMse );
+  EXPECT_LT( high.ssim,  low.ssim );
+  EXPECT_LT( low.ssim,   1.0 );
+  EXPECT_GT( low.flip,   0.0 );
+  EXPECT_GT( high.flip,  low.flip );
+  EXPECT_LE( high.flip,  1.0 );
+
+  // row sums are added in order, so threads don't change results
+  options.numThreads = 5;
+
+  light::ImageMetrics threaded = light::ImageComparer( makeImage( ), options ).compare( makeImage( 0.3f ) );
+
+  EXPECT_EQ( high.mse,    threaded.mse );
+  EXPECT_EQ( high.relMse, threaded.relMse );
+  EXPECT_EQ( high.ssim,   threaded.ssim );
+  EXPECT_EQ( high.flip,   threaded.flip );
+
+}
+
+
+} // namespace
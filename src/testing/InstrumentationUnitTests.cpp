@@ -0,0 +1,129 @@
+#include <string>
+#include <thread>
+#include <vector>
+#include "gmock/gmock.h"
+#include "Instrumentation.hpp"
+
+
+namespace
+{
+
+
+std::uint64_t
+getCounter(
+           const light::ProfileSnapshot &snapshot,
+           light::ProfileCounter         counter
+           )
+{
+
+  return snapshot.counters[ static_cast< unsigned >( counter ) ];
+
+}
+
+
+
+TEST( InstrumentationUnitTests, MergesEveryThread )
+{
+
+  light::resetProfile( );
+
+  std::vector< std::thread > threads;
+
+  // some threads exit before the snapshot, their totals must stay
+  for ( unsigned t = 0; t < 4; ++t )
+  {
+
+    threads.emplace_back( [ ]( )
+                          {
+
+                            for ( unsigned i = 0; i < 1000; ++i )
+                            {
+                              light::addProfileCount( light::ProfileCounter::RAYS, 2 );
+                            }
+
+                            light::addProfileTime( light::ProfileStage::LAUNCH, 1000000 );
+
+                          } );
+
+  }
+
+  for ( std::thread &thread : threads )
+  {
+    thread.join( );
+  }
+
+  light::addProfileCount( light::ProfileCounter::SHADOW_RAYS, 7 );
+
+  light::ProfileSnapshot snapshot = light::getProfileSnapshot( );
+
+  EXPECT_EQ( 8000u, getCounter( snapshot, light::ProfileCounter::RAYS ) );
+  EXPECT_EQ( 7u,    getCounter( snapshot, light::ProfileCounter::SHADOW_RAYS ) );
+  EXPECT_EQ( 4u,    snapshot.stageCalls[ static_cast< unsigned >( light::ProfileStage::LAUNCH ) ] );
+  EXPECT_DOUBLE_EQ( 0.004, snapshot.getStageSeconds( light::ProfileStage::LAUNCH ) );
+  EXPECT_GT( snapshot.seconds, 0.0 );
+
+}
+
+
+
+TEST( InstrumentationUnitTests, ResetStartsFromZero )
+{
+
+  light::addProfileCount( light::ProfileCounter::FRAMES, 5 );
+  light::resetProfile( );
+
+  light::ProfileSnapshot snapshot = light::getProfileSnapshot( );
+  EXPECT_EQ( 0u, getCounter( snapshot, light::ProfileCounter::FRAMES ) );
+
+  light::addProfileCount( light::ProfileCounter::FRAMES, 3 );
+  snapshot = light::getProfileSnapshot( );
+  EXPECT_EQ( 3u, getCounter( snapshot, light::ProfileCounter::FRAMES ) );
+
+}
+
+
+
+TEST( InstrumentationUnitTests, ScopedTimerAddsOneCall )
+{
+
+  light::resetProfile( );
+
+  {
+
+    light::ScopedTimer timer( light::ProfileStage::OUTPUT );
+    std::this_thread::sleep_for( std::chrono::milliseconds( 2 ) );
+
+  }
+
+  light::ProfileSnapshot snapshot = light::getProfileSnapshot( );
+
+  EXPECT_EQ( 1u, snapshot.stageCalls[ static_cast< unsigned >( light::ProfileStage::OUTPUT ) ] );
+  EXPECT_GE( snapshot.getStageSeconds( light::ProfileStage::OUTPUT ), 0.002 );
+  EXPECT_LE( snapshot.getStageSeconds( light::ProfileStage::OUTPUT ), snapshot.seconds );
+
+}
+
+
+
+TEST( InstrumentationUnitTests, JsonNamesEveryStageAndCounter )
+{
+
+  light::resetProfile( );
+  light::addProfileCount( light::ProfileCounter::SAMPLES, 42 );
+
+  std::string json = light::toProfileJson( light::getProfileSnapshot( ) );
+
+  for ( unsigned i = 0; i < light::profileStageCount; ++i )
+  {
+    EXPECT_THAT( json, ::testing::HasSubstr( std::string( "\"" ) + light::getProfileName( static_cast< light::ProfileStage >( i ) ) + "\": {" ) );
+  }
+
+  EXPECT_THAT( json, ::testing::HasSubstr( "\"samples\": 42" ) );
+  EXPECT_THAT( json, ::testing::HasSubstr( "\"perSecond\"" ) );
+  EXPECT_EQ( '{', json.front( ) );
+  EXPECT_EQ( "}\n", json.substr( json.size( ) - 2 ) );
+
+}
+
+
+} // namespace
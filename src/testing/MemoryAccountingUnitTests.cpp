@@ -0,0 +1,146 @@
+#include <string>
+#include <utility>
+#include "gmock/gmock.h"
+#include "MemoryAccounting.hpp"
+#include "TiledFramebuffer.hpp"
+#include "HostScene.hpp"
+#include "BuiltinScenes.hpp"
+
+
+namespace
+{
+
+
+std::int64_t
+currentBytes( light::MemoryCategory category )
+{
+
+  return light::getMemorySnapshot( ).current[ static_cast< unsigned >( category ) ];
+
+}
+
+
+
+//////////////////////////////////////////////////////////
+// counts follow the owner's lifetime, copies and moves
+//////////////////////////////////////////////////////////
+TEST( MemoryAccountingUnitTests, TrackedMemoryFollowsOwner )
+{
+
+  std::int64_t before = currentBytes( light::MemoryCategory::SCRATCH );
+
+  {
+
+    light::TrackedMemory memory( light::MemoryCategory::SCRATCH, 1000 );
+    EXPECT_EQ( before + 1000, currentBytes( light::MemoryCategory::SCRATCH ) );
+
+    memory.set( 400 );
+    EXPECT_EQ( before + 400, currentBytes( light::MemoryCategory::SCRATCH ) );
+
+    light::TrackedMemory copy( memory );
+    EXPECT_EQ( before + 800, currentBytes( light::MemoryCategory::SCRATCH ) );
+
+    light::TrackedMemory moved( std::move( copy ) );
+    EXPECT_EQ( 0u, copy.getBytes( ) );
+    EXPECT_EQ( before + 800, currentBytes( light::MemoryCategory::SCRATCH ) );
+
+  }
+
+  EXPECT_EQ( before, currentBytes( light::MemoryCategory::SCRATCH ) );
+
+}
+
+
+
+//////////////////////////////////////////////////////////
+// peaks stay after frees until they are reset
+//////////////////////////////////////////////////////////
+TEST( MemoryAccountingUnitTests, PeaksHoldUntilReset )
+{
+
+  light::resetMemoryPeaks( );
+
+  light::MemorySnapshot start = light::getMemorySnapshot( );
+
+  unsigned textures = static_cast< unsigned >( light::MemoryCategory::TEXTURES );
+
+  {
+
+    light::TrackedMemory memory( light::MemoryCategory::TEXTURES, 1 << 20 );
+
+  }
+
+  light::MemorySnapshot after = light::getMemorySnapshot( );
+
+  EXPECT_EQ( start.current[ textures ], after.current[ textures ] );
+  EXPECT_EQ( start.current[ textures ] + ( 1 << 20 ), after.peak[ textures ] );
+  EXPECT_EQ( start.totalCurrent + ( 1 << 20 ), after.totalPeak );
+
+  light::resetMemoryPeaks( );
+
+  EXPECT_EQ( after.current[ textures ], light::getMemorySnapshot( ).peak[ textures ] );
+
+}
+
+
+
+//////////////////////////////////////////////////////////
+// framebuffers and scenes report what they hold
+//////////////////////////////////////////////////////////
+TEST( MemoryAccountingUnitTests, SubsystemsReportTheirBuffers )
+{
+
+  std::int64_t framebuffers = currentBytes( light::MemoryCategory::FRAMEBUFFERS );
+  std::int64_t geometry     = currentBytes( light::MemoryCategory::GEOMETRY );
+  std::int64_t acceleration = currentBytes( light::MemoryCategory::ACCELERATION );
+
+  {
+
+    // two 16 x 16 tiles of 4 channels
+    light::TiledFramebuffer framebuffer( 20, 10, 16, 4 );
+    EXPECT_EQ( framebuffers + 2 * 16 * 16 * 4 * 4, currentBytes( light::MemoryCategory::FRAMEBUFFERS ) );
+
+    light::HostScene scene( light::buildBasicScene( ) );
+
+    EXPECT_EQ(
+              geometry + static_cast< std::int64_t >( scene.getSceneDescription( ).getMemoryBytes( ) ),
+              currentBytes( light::MemoryCategory::GEOMETRY )
+              );
+
+    EXPECT_EQ(
+              acceleration + static_cast< std::int64_t >( scene.getAccelerationBytes( ) ),
+              currentBytes( light::MemoryCategory::ACCELERATION )
+              );
+
+  }
+
+  EXPECT_EQ( framebuffers, currentBytes( light::MemoryCategory::FRAMEBUFFERS ) );
+  EXPECT_EQ( geometry,     currentBytes( light::MemoryCategory::GEOMETRY ) );
+  EXPECT_EQ( acceleration, currentBytes( light::MemoryCategory::ACCELERATION ) );
+
+}
+
+
+
+TEST( MemoryAccountingUnitTests, JsonListsEveryCategory )
+{
+
+  light::MemorySnapshot snapshot;
+  snapshot.current[ static_cast< unsigned >( light::MemoryCategory::GEOMETRY ) ] = 12;
+  snapshot.peak[ static_cast< unsigned >( light::MemoryCategory::GEOMETRY ) ]    = 34;
+  snapshot.totalCurrent = 12;
+  snapshot.totalPeak    = 34;
+
+  std::string json = light::toMemoryJson( snapshot );
+
+  EXPECT_THAT( json, ::testing::HasSubstr( "\"geometry\": { \"currentBytes\": 12, \"peakBytes\": 34 }" ) );
+  EXPECT_THAT( json, ::testing::HasSubstr( "\"acceleration\": " ) );
+  EXPECT_THAT( json, ::testing::HasSubstr( "\"textures\": " ) );
+  EXPECT_THAT( json, ::testing::HasSubstr( "\"framebuffers\": " ) );
+  EXPECT_THAT( json, ::testing::HasSubstr( "\"scratch\": " ) );
+  EXPECT_THAT( json, ::testing::HasSubstr( "\"total\": { \"currentBytes\": 12, \"peakBytes\": 34 }" ) );
+
+}
+
+
+} // namespace
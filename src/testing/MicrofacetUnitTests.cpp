@@ -0,0 +1,321 @@
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include "gmock/gmock.h"
+#include "Microfacet.hpp"
+#include "Bsdf.hpp"
+
+
+namespace
+{
+
+
+constexpr double pi = 3.14159265358979323846;
+
+
+struct Vector
+{
+  float x, y, z;
+};
+
+
+Vector
+viewAt( float cosNV )
+{
+
+  return Vector{ std::sqrt( 1.0f - cosNV * cosNV ), 0.0f, cosNV };
+
+}
+
+
+float
+cosHalf(
+        const Vector &v,
+        const Vector &l
+        )
+{
+
+  Vector h      = { v.x + l.x, v.y + l.y, v.z + l.z };
+  float  length = std::sqrt( h.x * h.x + h.y * h.y + h.z * h.z );
+
+  return h.z / length;
+
+}
+
+
+///
+/// \brief integrateHemisphere
+/// \return the integral of f( l ) over the upper hemisphere on a
+///         fine midpoint grid in ( cos( theta ), phi )
+///
+template< typename Function >
+double
+integrateHemisphere( Function f )
+{
+
+  constexpr int heightSteps = 2000;
+  constexpr int angleSteps  = 512;
+
+  double sum = 0.0;
+
+  for ( int i = 0; i < heightSteps; ++i )
+  {
+
+    double cosTheta = ( i + 0.5 ) / heightSteps;
+    double sinTheta = std::sqrt( 1.0 - cosTheta * cosTheta );
+
+    for ( int j = 0; j < angleSteps; ++j )
+    {
+
+      double phi = 2.0 * pi * ( j + 0.5 ) / angleSteps;
+
+      Vector l = {
+        static_cast< float >( sinTheta * std::cos( phi ) ),
+        static_cast< float >( sinTheta * std::sin( phi ) ),
+        static_cast< float >( cosTheta )
+      };
+
+      sum += f( l );
+
+    }
+
+  }
+
+  return sum * ( 1.0 / heightSteps ) * ( 2.0 * pi / angleSteps );
+
+}
+
+
+///
+/// \brief The Estimate struct
+///
+///        Mean and variance of a Monte Carlo estimator's samples
+///
+struct Estimate
+{
+  double mean     = 0.0;
+  double variance = 0.0;
+};
+
+
+template< typename Sample >
+Estimate
+estimate(
+         int    grid,
+         Sample sample
+         )
+{
+
+  double sum        = 0.0;
+  double sumSquares = 0.0;
+
+  for ( int i = 0; i < grid; ++i )
+  {
+
+    for ( int j = 0; j < grid; ++j )
+    {
+
+      double value = sample( ( i + 0.5f ) / grid, ( j + 0.5f ) / grid );
+
+      sum        += value;
+      sumSquares += value * value;
+
+    }
+
+  }
+
+  double count = static_cast< double >( grid ) * grid;
+
+  Estimate result;
+  result.mean     = sum / count;
+  result.variance = sumSquares / count - result.mean * result.mean;
+
+  return result;
+
+}
+
+
+
+TEST( MicrofacetUnitTests, ReflectionIsReciprocalAndConservesEnergy )
+{
+
+  for ( float alpha : { 0.05f, 0.2f, 0.5f, 1.0f } )
+  {
+
+    for ( float cosNV : { 0.95f, 0.6f, 0.2f } )
+    {
+
+      Vector v = viewAt( cosNV );
+
+      double albedo = integrateHemisphere( [ &v, alpha ]( const Vector &l )
+      {
+        return ggxReflection( v.z, l.z, cosHalf( v, l ), alpha ) * l.z;
+      } );
+
+      // single scattering loses energy with roughness, never gains it
+      EXPECT_LE( albedo, 1.0 + 2e-3 ) << "alpha " << alpha << " cosNV " << cosNV;
+      EXPECT_GT( albedo, alpha <= 0.05f ? 0.95 : 0.25 ) << "alpha " << alpha << " cosNV " << cosNV;
+
+      Vector l = { -0.3f, 0.4f, std::sqrt( 1.0f - 0.25f ) };
+
+      EXPECT_FLOAT_EQ(
+                      ggxReflection( v.z, l.z, cosHalf( v, l ), alpha ),
+                      ggxReflection( l.z, v.z, cosHalf( l, v ), alpha )
+                      );
+
+    }
+
+  }
+
+  EXPECT_EQ( 0.0f, ggxReflection( 0.5f, -0.1f, 0.8f, 0.3f ) );
+  EXPECT_EQ( 0.0f, ggxReflectionWeight( 0.5f, -0.1f, 0.3f ) );
+  EXPECT_EQ( GGX_MIN_ALPHA, ggxAlpha( 0.0f ) );
+
+}
+
+
+
+TEST( MicrofacetUnitTests, SampledWeightsAndPdfMatchTheLobe )
+{
+
+  constexpr int grid = 300;
+
+  for ( float alpha : { 0.1f, 0.3f, 0.7f } )
+  {
+
+    for ( float cosNV : { 0.9f, 0.5f, 0.2f } )
+    {
+
+      Vector v = viewAt( cosNV );
+
+      double albedo = integrateHemisphere( [ &v, alpha ]( const Vector &l )
+      {
+        return ggxReflection( v.z, l.z, cosHalf( v, l ), alpha ) * l.z;
+      } );
+
+      double pdfMass = integrateHemisphere( [ &v, alpha ]( const Vector &l )
+      {
+        return ggxReflectionPdf( v.z, cosHalf( v, l ), alpha );
+      } );
+
+      double above = 0.0;
+
+      Estimate weights = estimate( grid, [ &v, alpha, &above ]( float u1, float u2 )
+      {
+
+        Vector l = sampleGgxReflection( v, alpha, u1, u2 );
+
+        EXPECT_NEAR( 1.0f, l.x * l.x + l.y * l.y + l.z * l.z, 1e-4f );
+
+        if ( l.z > 0.0f )
+        {
+
+          above += 1.0 / ( grid * grid );
+
+          // the weight is f cos / pdf evaluated explicitly
+          float pdf = ggxReflectionPdf( v.z, cosHalf( v, l ), alpha );
+          float f   = ggxReflection( v.z, l.z, cosHalf( v, l ), alpha );
+
+          EXPECT_NEAR( f * l.z / pdf, ggxReflectionWeight( v.z, l.z, alpha ), 1e-3f * ( 1.0f + f * l.z / pdf ) );
+
+        }
+
+        return ggxReflectionWeight( v.z, l.z, alpha );
+
+      } );
+
+      EXPECT_NEAR( albedo, weights.mean, 0.01 ) << "alpha " << alpha << " cosNV " << cosNV;
+      EXPECT_NEAR( above,  pdfMass,      0.01 ) << "alpha " << alpha << " cosNV " << cosNV;
+
+    }
+
+  }
+
+}
+
+
+
+TEST( MicrofacetUnitTests, VisibleNormalSamplingBeatsCosineSampling )
+{
+
+  constexpr int grid = 300;
+
+  for ( float alpha : { 0.1f, 0.3f } )
+  {
+
+    Vector v = viewAt( 0.7f );
+
+    Estimate visible = estimate( grid, [ &v, alpha ]( float u1, float u2 )
+    {
+
+      Vector l = sampleGgxReflection( v, alpha, u1, u2 );
+
+      return ggxReflectionWeight( v.z, l.z, alpha );
+
+    } );
+
+    Estimate cosine = estimate( grid, [ &v, alpha ]( float u1, float u2 )
+    {
+
+      Vector l = sampleCosineHemisphere< Vector >( u1, u2 );
+
+      return ggxReflection( v.z, l.z, cosHalf( v, l ), alpha ) * l.z / cosineHemispherePdf( l.z );
+
+    } );
+
+    EXPECT_NEAR( cosine.mean, visible.mean, 0.02 ) << "alpha " << alpha;
+
+    // samples needed for a given error scale with the variance
+    EXPECT_LT( visible.variance * 10.0, cosine.variance ) << "alpha " << alpha;
+
+  }
+
+}
+
+
+
+TEST( MicrofacetUnitTests, CoatingAndDiffuseTermsHaveTheirLimits )
+{
+
+  // ( ( n - 1 ) / ( n + 1 ) )^2 head on, total reflection at grazing
+  for ( float ior : { 1.33f, 1.5f, 2.4f } )
+  {
+
+    float normal = ( ior - 1.0f ) / ( ior + 1.0f );
+
+    EXPECT_NEAR( normal * normal, dielectricFresnel( 1.0f, ior ), 1e-6f ) << "ior " << ior;
+    EXPECT_GT( dielectricFresnel( 1e-3f, ior ), 0.99f ) << "ior " << ior;
+
+  }
+
+  // smooth Oren-Nayar is lambertian, and every lobe conserves energy
+  for ( float roughness : { 0.0f, 0.5f, 1.0f } )
+  {
+
+    for ( float cosNV : { 1.0f, 0.7f, 0.2f } )
+    {
+
+      Vector v = viewAt( cosNV );
+
+      double albedo = integrateHemisphere( [ &v, roughness ]( const Vector &l )
+      {
+
+        return orenNayarDiffuse( 1.0f, roughness, l.z, v.z, l.x * v.x + l.y * v.y + l.z * v.z ) * l.z;
+
+      } );
+
+      if ( roughness == 0.0f )
+      {
+        EXPECT_NEAR( 1.0, albedo, 1e-3 ) << "cosNV " << cosNV;
+      }
+
+      EXPECT_LE( albedo, 1.0 + 1e-3 ) << "roughness " << roughness << ", cosNV " << cosNV;
+
+    }
+
+  }
+
+}
+
+
+} // namespace
@@ -0,0 +1,121 @@
+#include <string>
+#include <vector>
+#include "gmock/gmock.h"
+#include "PathStatistics.hpp"
+
+
+namespace
+{
+
+
+std::vector< std::uint64_t >
+emptySlots( )
+{
+
+  return std::vector< std::uint64_t >( PATH_STATS_SLOTS * PATH_STATS_FIELDS, 0 );
+
+}
+
+
+
+TEST( PathStatisticsUnitTests, StartsEmpty )
+{
+
+  light::PathStatistics statistics;
+
+  EXPECT_EQ( 0u, statistics.getPathCount( ) );
+  EXPECT_DOUBLE_EQ( 0.0, statistics.getMeanLength( ) );
+  EXPECT_DOUBLE_EQ( 0.0, statistics.getMeanThroughput( ) );
+  EXPECT_DOUBLE_EQ( 0.0, statistics.getOcclusionRate( ) );
+  EXPECT_DOUBLE_EQ( 0.0, statistics.getFraction( light::PathTermination::MISSED ) );
+
+}
+
+
+
+TEST( PathStatisticsUnitTests, SumsEverySlot )
+{
+
+  std::vector< std::uint64_t > slots = emptySlots( );
+
+  // three one segment misses in slot 0, one three segment emission in the last slot
+  std::uint64_t *pFirst = slots.data( );
+  std::uint64_t *pLast  = slots.data( ) + ( PATH_STATS_SLOTS - 1 ) * PATH_STATS_FIELDS;
+
+  pFirst[ 0 ]                          = 3;
+  pFirst[ PATH_STATS_MISSED ]          = 3;
+  pFirst[ PATH_STATS_THROUGHPUT ]      = static_cast< std::uint64_t >( 3 * PATH_STATS_FIXED_ONE );
+  pFirst[ PATH_STATS_SHADOW_RAYS ]     = 4;
+  pFirst[ PATH_STATS_SHADOW_OCCLUDED ] = 1;
+
+  pLast[ 2 ]                     = 1;
+  pLast[ PATH_STATS_EMITTED ]    = 1;
+  pLast[ PATH_STATS_THROUGHPUT ] = static_cast< std::uint64_t >( 0.5f * PATH_STATS_FIXED_ONE );
+
+  light::PathStatistics statistics;
+  statistics.addSlots( slots.data( ) );
+
+  EXPECT_EQ( 4u, statistics.getPathCount( ) );
+  EXPECT_DOUBLE_EQ( 1.5, statistics.getMeanLength( ) );
+  EXPECT_DOUBLE_EQ( 0.75, statistics.getFraction( light::PathTermination::MISSED ) );
+  EXPECT_DOUBLE_EQ( 0.25, statistics.getFraction( light::PathTermination::EMITTED ) );
+  EXPECT_DOUBLE_EQ( 0.0,  statistics.getFraction( light::PathTermination::ABSORBED ) );
+  EXPECT_DOUBLE_EQ( 0.875, statistics.getMeanThroughput( ) );
+  EXPECT_DOUBLE_EQ( 0.25, statistics.getOcclusionRate( ) );
+
+}
+
+
+
+TEST( PathStatisticsUnitTests, MergeAddsCounts )
+{
+
+  std::vector< std::uint64_t > slots = emptySlots( );
+
+  slots[ 1 ]                          = 2;
+  slots[ PATH_STATS_MAX_BOUNCES ]     = 2;
+  slots[ PATH_STATS_SHADOW_RAYS ]     = 2;
+  slots[ PATH_STATS_SHADOW_OCCLUDED ] = 2;
+
+  light::PathStatistics first, second;
+  first.addSlots( slots.data( ) );
+  second.addSlots( slots.data( ) );
+
+  first.merge( second );
+
+  EXPECT_EQ( 4u, first.getPathCount( ) );
+  EXPECT_EQ( 4u, first.lengths[ 1 ] );
+  EXPECT_EQ( 4u, first.terminations[ static_cast< unsigned >( light::PathTermination::MAX_BOUNCES ) ] );
+  EXPECT_DOUBLE_EQ( 1.0, first.getOcclusionRate( ) );
+
+}
+
+
+
+TEST( PathStatisticsUnitTests, JsonNamesEveryTermination )
+{
+
+  std::vector< std::uint64_t > slots = emptySlots( );
+
+  slots[ 0 ]                   = 1;
+  slots[ PATH_STATS_ABSORBED ] = 1;
+
+  light::PathStatistics statistics;
+  statistics.addSlots( slots.data( ) );
+
+  std::string json = light::toJson( statistics );
+
+  for ( unsigned i = 0; i < light::pathTerminationCount; ++i )
+  {
+    EXPECT_THAT( json, ::testing::HasSubstr( std::string( "\"" ) + light::getPathTerminationName( static_cast< light::PathTermination >( i ) ) + "\": {" ) );
+  }
+
+  EXPECT_THAT( json, ::testing::HasSubstr( "\"paths\": 1," ) );
+  EXPECT_THAT( json, ::testing::HasSubstr( "\"lengthHistogram\": [ 1, 0," ) );
+  EXPECT_EQ( '{', json.front( ) );
+  EXPECT_EQ( "}\n", json.substr( json.size( ) - 2 ) );
+
+}
+
+
+} // namespace
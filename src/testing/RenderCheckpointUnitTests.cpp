@@ -0,0 +1,366 @@
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include "gmock/gmock.h"
+#include "RenderCheckpoint.hpp"
+#include "Hash.hpp"
+#include "Roulette.hpp"
+
+
+namespace
+{
+
+
+///
+/// \brief The ProgressiveRender struct
+///
+///        Stand-in for the path tracing cameras: each frame
+///        traces paths ended by efficiency roulette, scaled by
+///        the pixel's moments, then accumulates the mean and the
+///        moments the way writeFrame does
+///
+struct ProgressiveRender
+{
+
+  static constexpr unsigned width   = 6;
+  static constexpr unsigned height  = 4;
+  static constexpr unsigned samples = 4;
+
+  std::vector< float > output  = std::vector< float >( width * height * 4, 0.0f );
+  std::vector< float > moments = std::vector< float >( width * height * 2, 0.0f );
+
+  unsigned frame = 1;
+
+
+  void
+  renderFrame( )
+  {
+
+    for ( unsigned i = 0; i < width * height; ++i )
+    {
+
+      std::uint32_t seed = i * 2654435761u + frame * 40503u;
+
+      auto rand = [ &seed ]( )
+      {
+
+        seed = seed * 1664525u + 1013904223u;
+
+        return static_cast< float >( seed >> 8 ) / 16777216.0f;
+
+      };
+
+      float scale = rouletteMomentScale( moments[ i * 2 ], moments[ i * 2 + 1 ], frame - 1, samples );
+      float value = 0.0f;
+
+      for ( unsigned s = 0; s < samples; ++s )
+      {
+
+        float throughput = 1.0f;
+
+        for ( int depth = 0; depth < 16; ++depth )
+        {
+
+          value      += throughput * rand( ) * ( 0.2f + 0.1f * ( i % 5 ) );
+          throughput *= 0.6f;
+
+          float survival = survivalProbability( ROULETTE_EFFICIENCY, throughput, scale, depth, 1 );
+
+          if ( rand( ) >= survival )
+          {
+            break;
+          }
+
+          throughput /= survival;
+
+        }
+
+      }
+
+      value /= samples;
+
+      for ( unsigned c = 0; c < 4; ++c )
+      {
+        output[ i * 4 + c ] += ( value - output[ i * 4 + c ] ) / frame;
+      }
+
+      accumulateRouletteMoments( moments[ i * 2 ], moments[ i * 2 + 1 ], value, frame );
+
+    }
+
+    ++frame;
+
+  }
+
+};
+
+
+class RenderCheckpointUnitTests : public ::testing::Test
+{
+
+protected:
+
+  RenderCheckpointUnitTests( )
+    : filename_( "lightBenderCheckpointTest.lbckpt" )
+  {}
+
+  virtual
+  ~RenderCheckpointUnitTests( )
+  {
+
+    std::remove( filename_.c_str( ) );
+
+  }
+
+
+  ///
+  /// \brief makeCheckpoint
+  /// \return a small two layer checkpoint with recognizable values
+  ///
+  static
+  light::RenderCheckpoint
+  makeCheckpoint( )
+  {
+
+    light::RenderCheckpoint checkpoint;
+    checkpoint.resize( 5, 3, 2 );
+
+    for ( unsigned layer = 0; layer < 2; ++layer )
+    {
+
+      float *pLayer = checkpoint.getLayer( layer );
+
+      for ( unsigned i = 0; i < 5 * 3 * 4; ++i )
+      {
+        pLayer[ i ] = static_cast< float >( layer * 1000 + i ) * 0.125f;
+      }
+
+    }
+
+    light::CheckpointHeader &header = checkpoint.getHeader( );
+    header.rouletteLayer   = 1;
+    header.frameNumber     = 17;
+    header.frameOffset     = 4;
+    header.globalSeed      = 0x1234abcd;
+    header.sqrtSamples     = 2;
+    header.samplesPerPixel = 64;
+    header.sceneHash       = light::hashString( "scene" );
+    header.cameraHash      = light::hashString( "camera" );
+
+    return checkpoint;
+
+  }
+
+
+  std::string filename_;
+
+};
+
+
+
+//////////////////////////////////////////////////////////
+// everything written comes back through the mapping
+//////////////////////////////////////////////////////////
+TEST_F( RenderCheckpointUnitTests, WriteAndMapRoundTrip )
+{
+
+  light::RenderCheckpoint checkpoint = makeCheckpoint( );
+  checkpoint.write( filename_ );
+
+  light::MappedCheckpoint mapped( filename_ );
+
+  const light::CheckpointHeader &header = mapped.getHeader( );
+
+  EXPECT_EQ( 5u,          header.width );
+  EXPECT_EQ( 3u,          header.height );
+  EXPECT_EQ( 2u,          header.layerCount );
+  EXPECT_EQ( 1u,          header.rouletteLayer );
+  EXPECT_EQ( 17u,         header.frameNumber );
+  EXPECT_EQ( 4u,          header.frameOffset );
+  EXPECT_EQ( 0x1234abcdu, header.globalSeed );
+  EXPECT_EQ( 64u,         header.samplesPerPixel );
+  EXPECT_EQ( light::hashString( "scene" ),  header.sceneHash );
+  EXPECT_EQ( light::hashString( "camera" ), header.cameraHash );
+
+  // pixel data is page aligned for mapping
+  EXPECT_EQ( 0u, header.dataOffset % 4096 );
+
+  for ( unsigned layer = 0; layer < 2; ++layer )
+  {
+
+    std::vector< float > expected( checkpoint.getLayer( layer ), checkpoint.getLayer( layer ) + 5 * 3 * 4 );
+    std::vector< float > actual  ( mapped.getLayer( layer ),     mapped.getLayer( layer )     + 5 * 3 * 4 );
+
+    EXPECT_THAT( actual, ::testing::ContainerEq( expected ) );
+
+  }
+
+}
+
+
+
+//////////////////////////////////////////////////////////
+// flipped bits in the pixel data are caught on open
+//////////////////////////////////////////////////////////
+TEST_F( RenderCheckpointUnitTests, CorruptDataIsRejected )
+{
+
+  makeCheckpoint( ).write( filename_ );
+
+  {
+
+    std::fstream file( filename_, std::ios::in | std::ios::out | std::ios::binary );
+    file.seekp( 4096 + 10 );
+    file.put( 0x7f );
+
+  }
+
+  EXPECT_THROW( light::MappedCheckpoint mapped( filename_ ), std::runtime_error );
+
+  // layer flags that don't add up to the layer count
+  light::RenderCheckpoint checkpoint = makeCheckpoint( );
+  checkpoint.getHeader( ).bounceLayers = 1;
+  checkpoint.write( filename_ );
+
+  EXPECT_THROW( light::MappedCheckpoint mapped( filename_ ), std::runtime_error );
+
+}
+
+
+
+//////////////////////////////////////////////////////////
+// files that aren't checkpoints are rejected
+//////////////////////////////////////////////////////////
+TEST_F( RenderCheckpointUnitTests, ForeignFileIsRejected )
+{
+
+  {
+
+    std::ofstream file( filename_, std::ios::binary );
+    file << std::string( 8192, 'x' );
+
+  }
+
+  EXPECT_THROW( light::MappedCheckpoint mapped( filename_ ), std::runtime_error );
+  EXPECT_THROW( light::MappedCheckpoint missing( filename_ + ".missing" ), std::runtime_error );
+
+}
+
+
+
+//////////////////////////////////////////////////////////
+// a render with efficiency roulette resumed from its
+// checkpoint matches one that never stopped, bit for bit
+//////////////////////////////////////////////////////////
+TEST_F( RenderCheckpointUnitTests, EfficiencyRouletteResumesBitIdentical )
+{
+
+  const unsigned pixels = ProgressiveRender::width * ProgressiveRender::height;
+
+  ProgressiveRender straight;
+
+  for ( unsigned frame = 0; frame < 8; ++frame )
+  {
+    straight.renderFrame( );
+  }
+
+  {
+
+    ProgressiveRender first;
+
+    for ( unsigned frame = 0; frame < 4; ++frame )
+    {
+      first.renderFrame( );
+    }
+
+    light::RenderCheckpoint checkpoint;
+    checkpoint.resize( ProgressiveRender::width, ProgressiveRender::height, 2 );
+
+    std::copy( first.output.begin( ), first.output.end( ), checkpoint.getLayer( 0 ) );
+
+    for ( unsigned i = 0; i < pixels; ++i )
+    {
+
+      checkpoint.getLayer( 1 )[ i * 4 + 0 ] = first.moments[ i * 2 + 0 ];
+      checkpoint.getLayer( 1 )[ i * 4 + 1 ] = first.moments[ i * 2 + 1 ];
+
+    }
+
+    checkpoint.getHeader( ).rouletteLayer = 1;
+    checkpoint.getHeader( ).frameNumber   = first.frame;
+    checkpoint.write( filename_ );
+
+  }
+
+  light::MappedCheckpoint mapped( filename_ );
+
+  ProgressiveRender resumed;
+  ProgressiveRender withoutMoments;
+
+  for ( ProgressiveRender *pRender : { &resumed, &withoutMoments } )
+  {
+
+    std::copy( mapped.getLayer( 0 ), mapped.getLayer( 0 ) + pixels * 4, pRender->output.begin( ) );
+    pRender->frame = mapped.getHeader( ).frameNumber;
+
+  }
+
+  for ( unsigned i = 0; i < pixels; ++i )
+  {
+
+    resumed.moments[ i * 2 + 0 ] = mapped.getLayer( 1 )[ i * 4 + 0 ];
+    resumed.moments[ i * 2 + 1 ] = mapped.getLayer( 1 )[ i * 4 + 1 ];
+
+  }
+
+  for ( unsigned frame = 0; frame < 4; ++frame )
+  {
+
+    resumed.renderFrame( );
+    withoutMoments.renderFrame( );
+
+  }
+
+  EXPECT_THAT( resumed.output,  ::testing::ContainerEq( straight.output ) );
+  EXPECT_THAT( resumed.moments, ::testing::ContainerEq( straight.moments ) );
+
+  // paths end differently once the moments are lost
+  EXPECT_THAT( withoutMoments.output, ::testing::Not( ::testing::ContainerEq( straight.output ) ) );
+
+}
+
+
+
+//////////////////////////////////////////////////////////
+// the background writer leaves only the newest checkpoint
+// and no temporary file behind
+//////////////////////////////////////////////////////////
+TEST_F( RenderCheckpointUnitTests, AsyncWriterKeepsLatest )
+{
+
+  light::CheckpointWriter writer;
+
+  for ( unsigned frame = 1; frame <= 8; ++frame )
+  {
+
+    light::RenderCheckpoint checkpoint = makeCheckpoint( );
+    checkpoint.getHeader( ).frameNumber = frame;
+
+    writer.submit( std::move( checkpoint ), filename_ );
+
+  }
+
+  writer.wait( );
+
+  EXPECT_TRUE( writer.getLastError( ).empty( ) );
+  EXPECT_EQ( 8u, light::MappedCheckpoint( filename_ ).getHeader( ).frameNumber );
+  EXPECT_FALSE( std::ifstream( filename_ + ".tmp" ).good( ) );
+
+}
+
+
+
+} // namespace
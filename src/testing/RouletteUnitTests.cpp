@@ -0,0 +1,267 @@
+#include <cmath>
+#include <cstdint>
+#include "gmock/gmock.h"
+#include "Roulette.hpp"
+
+
+namespace
+{
+
+
+constexpr int maxDepth = 15;
+
+
+///
+/// \brief The Material struct
+///
+///        A surface of the walk below: diffuse albedo, mean
+///        Fresnel and how often the walk lands on it
+///
+struct Material
+{
+  float albedo[ 3 ];
+  float fresnel;
+  float share;
+};
+
+
+// the advanced scene's ground, mirror box, glossy sphere, walls
+// and colored walls, with the Fresnel of their indices
+const Material materials[] = {
+  { { 0.71f, 0.62f, 0.53f }, 0.18f, 0.3f },
+  { { 0.71f, 0.62f, 0.53f }, 0.96f, 0.1f },
+  { { 0.71f, 0.62f, 0.53f }, 0.67f, 0.1f },
+  { { 0.71f, 0.62f, 0.53f }, 0.04f, 0.3f },
+  { { 0.80f, 0.20f, 0.30f }, 0.00f, 0.1f },
+  { { 0.20f, 0.80f, 0.30f }, 0.00f, 0.1f },
+};
+
+
+///
+/// \brief The Estimate struct
+///
+///        Mean and variance of a sample and the rays it traced
+///
+struct Estimate
+{
+  double mean     = 0.0;
+  double variance = 0.0;
+  double cost     = 0.0;
+
+  double efficiency( ) const { return 1.0 / ( variance * cost ); }
+};
+
+
+///
+/// \brief walk
+///
+///        Paths through a random sequence of surfaces, picking
+///        lobes and ending the way closest_hit_bsdf does. Each
+///        vertex sees the light 30% of the time and costs a
+///        shadow ray plus the ray that found it.
+///
+Estimate
+walk(
+     RoulettePolicy policy,
+     int            minDepth,
+     float          scale,
+     int            paths
+     )
+{
+
+  std::uint32_t seed = 7u;
+
+  auto rand = [ &seed ]( )
+  {
+
+    seed = seed * 1664525u + 1013904223u;
+
+    return static_cast< float >( seed >> 8 ) / 16777216.0f;
+
+  };
+
+  double sum        = 0.0;
+  double sumSquares = 0.0;
+  double rays       = 0.0;
+
+  for ( int i = 0; i < paths; ++i )
+  {
+
+    float  throughput[ 3 ] = { 1.0f, 1.0f, 1.0f };
+    double radiance        = 0.0;
+
+    for ( int depth = 0; ; ++depth )
+    {
+
+      rays += 2.0;
+
+      float u = rand( );
+      int   m = 0;
+
+      while ( m < 5 && ( u -= materials[ m ].share ) > 0.0f )
+      {
+        ++m;
+      }
+
+      const Material &material = materials[ m ];
+
+      if ( rand( ) < 0.3f )
+      {
+
+        for ( int c = 0; c < 3; ++c )
+        {
+          radiance += throughput[ c ] * material.albedo[ c ] * ( 1.0f - material.fresnel ) / 3.0f;
+        }
+
+      }
+
+      if ( depth == maxDepth )
+      {
+        break;
+      }
+
+      float scatterProb;
+      float reflectProb;
+
+      lobeProbabilities(
+                        policy,
+                        ( material.albedo[ 0 ] + material.albedo[ 1 ] + material.albedo[ 2 ] ) / 3.0f
+                        * ( 1.0f - material.fresnel ),
+                        material.fresnel,
+                        scatterProb,
+                        reflectProb
+                        );
+
+      float lobe = rand( );
+
+      if ( lobe < scatterProb )
+      {
+
+        for ( int c = 0; c < 3; ++c )
+        {
+          throughput[ c ] *= material.albedo[ c ] * ( 1.0f - material.fresnel ) / scatterProb;
+        }
+
+      }
+      else if ( lobe < scatterProb + reflectProb )
+      {
+
+        for ( int c = 0; c < 3; ++c )
+        {
+          throughput[ c ] *= 0.9f * material.fresnel / reflectProb; // G2 / G1 of a glossy lobe
+        }
+
+      }
+      else
+      {
+        break; // absorbed, only ROULETTE_ALBEDO ends paths here
+      }
+
+      float survival = survivalProbability(
+                                           policy,
+                                           std::fmax( throughput[ 0 ], std::fmax( throughput[ 1 ], throughput[ 2 ] ) ),
+                                           scale,
+                                           depth,
+                                           minDepth
+                                           );
+
+      if ( rand( ) >= survival )
+      {
+        break;
+      }
+
+      for ( int c = 0; c < 3; ++c )
+      {
+        throughput[ c ] /= survival;
+      }
+
+    }
+
+    sum        += radiance;
+    sumSquares += radiance * radiance;
+
+  }
+
+  Estimate result;
+  result.mean     = sum / paths;
+  result.variance = sumSquares / paths - result.mean * result.mean;
+  result.cost     = rays / paths;
+
+  return result;
+
+}
+
+
+
+TEST( RouletteUnitTests, SurvivalFollowsThePolicy )
+{
+
+  EXPECT_EQ( 1.0f, survivalProbability( ROULETTE_ALBEDO, 0.01f, 1.0f, 5, 0 ) );
+  EXPECT_EQ( 1.0f, survivalProbability( ROULETTE_THROUGHPUT, 0.01f, 1.0f, 1, 2 ) );
+
+  EXPECT_FLOAT_EQ( 0.25f, survivalProbability( ROULETTE_THROUGHPUT, 0.25f, 3.0f, 2, 2 ) );
+  EXPECT_FLOAT_EQ( 0.75f, survivalProbability( ROULETTE_EFFICIENCY, 0.25f, 3.0f, 2, 2 ) );
+
+  EXPECT_EQ( 1.0f, survivalProbability( ROULETTE_THROUGHPUT, 4.0f, 1.0f, 3, 0 ) );
+  EXPECT_EQ( 0.0f, survivalProbability( ROULETTE_EFFICIENCY, 0.0f, 2.0f, 3, 0 ) );
+
+  // noisy pixels fall back to throughput roulette, smooth ones keep paths longer
+  EXPECT_EQ( 1.0f, rouletteEfficiencyScale( 0.0f, 0.0f ) );
+  EXPECT_NEAR( 1.0f, rouletteEfficiencyScale( 0.1f, 100.0f ), 1e-4f );
+  EXPECT_FLOAT_EQ( std::sqrt( 2.0f ), rouletteEfficiencyScale( 0.5f, 0.25f ) );
+  EXPECT_EQ( ROULETTE_MAX_SCALE, rouletteEfficiencyScale( 0.5f, 0.0f ) );
+
+}
+
+
+
+TEST( RouletteUnitTests, PoliciesAreUnbiasedAndEfficiencyWins )
+{
+
+  constexpr int paths = 400000;
+
+  Estimate full       = walk( ROULETTE_THROUGHPUT, maxDepth + 1, 1.0f, paths );
+  Estimate throughput = walk( ROULETTE_THROUGHPUT, 2, 1.0f, paths );
+
+  // the pixel statistics of earlier frames set the scale
+  float    scale      = rouletteEfficiencyScale(
+                                                static_cast< float >( throughput.mean ),
+                                                static_cast< float >( throughput.variance )
+                                                );
+  Estimate efficiency = walk( ROULETTE_EFFICIENCY, 2, scale, paths );
+  Estimate albedo     = walk( ROULETTE_ALBEDO, 2, 1.0f, paths );
+
+  for ( const Estimate &estimate : { throughput, efficiency, albedo } )
+  {
+
+    double standardError = std::sqrt( ( estimate.variance + full.variance ) / paths );
+
+    EXPECT_NEAR( full.mean, estimate.mean, 4.0 * standardError );
+
+  }
+
+  EXPECT_GT( scale, 1.0f );
+  EXPECT_GT( throughput.efficiency( ), 2.0 * full.efficiency( ) );
+  EXPECT_GT( efficiency.efficiency( ), throughput.efficiency( ) );
+
+}
+
+
+
+TEST( RouletteUnitTests, AlbedoRouletteEndsPathsWithTheLobeWeights )
+{
+
+  float scatterProb, reflectProb;
+
+  lobeProbabilities( ROULETTE_ALBEDO, 0.3f, 0.5f, scatterProb, reflectProb );
+  EXPECT_FLOAT_EQ( 0.3f, scatterProb );
+  EXPECT_FLOAT_EQ( 0.5f, reflectProb );
+
+  lobeProbabilities( ROULETTE_THROUGHPUT, 0.3f, 0.5f, scatterProb, reflectProb );
+  EXPECT_FLOAT_EQ( 0.375f, scatterProb );
+  EXPECT_FLOAT_EQ( 0.625f, reflectProb );
+
+}
+
+
+} // namespace
@@ -0,0 +1,692 @@
+#include <cmath>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include "gmock/gmock.h"
+#include "Sampling.hpp"
+#include "SimdSampling.hpp"
+#include "SimdKernels.hpp"
+
+
+namespace
+{
+
+
+namespace simd = light::LIGHT_SIMD_NAMESPACE;
+
+
+constexpr double pi = 3.14159265358979323846;
+
+
+struct Vector
+{
+  float x, y, z;
+};
+
+
+double
+dot(
+    const Vector &a,
+    const Vector &b
+    )
+{
+
+  return static_cast< double >( a.x ) * b.x + static_cast< double >( a.y ) * b.y + static_cast< double >( a.z ) * b.z;
+
+}
+
+
+Vector
+normalized(
+           double x,
+           double y,
+           double z
+           )
+{
+
+  double length = std::sqrt( x * x + y * y + z * z );
+
+  return Vector{ static_cast< float >( x / length ), static_cast< float >( y / length ), static_cast< float >( z / length ) };
+
+}
+
+
+///
+/// \brief The Uniform class
+///
+///        Reproducible uniform numbers in [0, 1), in place of
+///        MATLAB's rand( )
+///
+class Uniform
+{
+
+public:
+
+  explicit
+  Uniform( std::uint32_t seed ) : state_( seed ) {}
+
+  float
+  operator()( )
+  {
+
+    state_ = state_ * 1664525u + 1013904223u;
+
+    return static_cast< float >( state_ >> 8 ) / 16777216.0f;
+
+  }
+
+
+private:
+
+  std::uint32_t state_;
+
+};
+
+
+//
+// Ports of the MATLAB sampling references in src/testing/matlab
+//
+
+// sampleSphere.m
+Vector
+referenceSphere( Uniform &rand )
+{
+
+  double theta = rand( ) * 2.0 * pi;
+  double u     = rand( ) * 2.0 - 1.0;
+
+  double xyCoeff = std::sqrt( 1.0 - u * u );
+
+  return Vector{
+    static_cast< float >( xyCoeff * std::cos( theta ) ),
+    static_cast< float >( xyCoeff * std::sin( theta ) ),
+    static_cast< float >( u )
+  };
+
+}
+
+
+// sampleHalfSphere.m
+Vector
+referenceHalfSphere(
+                    Uniform      &rand,
+                    const Vector &normal
+                    )
+{
+
+  Vector sample = referenceSphere( rand );
+
+  if ( dot( sample, normal ) < 0.0 )
+  {
+    sample = Vector{ -sample.x, -sample.y, -sample.z };
+  }
+
+  return sample;
+
+}
+
+
+// sampleSolidAngle.m, rejecting directions outside the cone the
+// unit sphere around the origin subtends from 'point'
+Vector
+referenceSolidAngle(
+                    Uniform      &rand,
+                    const Vector &point
+                    )
+{
+
+  double d      = std::sqrt( dot( point, point ) );
+  double cosA   = std::cos( std::asin( 1.0 / d ) );
+  Vector normal = normalized( -point.x, -point.y, -point.z );
+
+  Vector sample;
+
+  do
+  {
+    sample = referenceHalfSphere( rand, normal );
+  }
+  while ( dot( sample, normal ) <= cosA );
+
+  return sample;
+
+}
+
+
+///
+/// \brief binFractions
+/// \return the fraction of 'values' in each of 'bins' equal bins
+///         over [low, high]
+///
+std::vector< double >
+binFractions(
+             const std::vector< double > &values,
+             int                          bins,
+             double                       low,
+             double                       high
+             )
+{
+
+  std::vector< double > fractions( bins, 0.0 );
+
+  for ( double value : values )
+  {
+
+    int bin = static_cast< int >( ( value - low ) / ( high - low ) * bins );
+    fractions[ std::min( std::max( bin, 0 ), bins - 1 ) ] += 1.0 / values.size( );
+
+  }
+
+  return fractions;
+
+}
+
+
+std::vector< light::SimdIsa >
+supportedIsas( )
+{
+
+  std::vector< light::SimdIsa > isas;
+
+  for ( int i = 0; i <= static_cast< int >( light::SimdIsa::AVX512 ); ++i )
+  {
+
+    if ( light::isSimdIsaSupported( static_cast< light::SimdIsa >( i ) ) )
+    {
+      isas.push_back( static_cast< light::SimdIsa >( i ) );
+    }
+
+  }
+
+  return isas;
+
+}
+
+
+
+TEST( SamplingUnitTests, TurnSinCosMatchesTheLibrary )
+{
+
+  double worst = 0.0;
+
+  for ( int i = 0; i <= 100000; ++i )
+  {
+
+    float u = i / 100000.0f;
+
+    float s, c;
+    turnSinCos( u, s, c );
+
+    worst = std::max( worst, std::abs( s - std::sin( 2.0 * pi * u ) ) );
+    worst = std::max( worst, std::abs( c - std::cos( 2.0 * pi * u ) ) );
+
+  }
+
+  EXPECT_LT( worst, 5e-7 );
+
+}
+
+
+
+TEST( SamplingUnitTests, OrthonormalBasisIsOrthonormalEverywhere )
+{
+
+  std::vector< Vector > normals = {
+    Vector{ 0.0f, 0.0f, 1.0f },
+    Vector{ 0.0f, 0.0f, -1.0f },
+    Vector{ 1.0f, 0.0f, 0.0f },
+    Vector{ 0.0f, -1.0f, 0.0f },
+    normalized( 1e-4, 0.0, -1.0 ), // where the old basis switched axes
+    normalized( 0.0, 1.0, 1e-4 ),
+  };
+
+  Uniform rand( 7u );
+
+  for ( int i = 0; i < 10000; ++i )
+  {
+    normals.push_back( referenceSphere( rand ) );
+  }
+
+  for ( const Vector &n : normals )
+  {
+
+    Vector b1, b2;
+    orthonormalBasis( n, b1, b2 );
+
+    ASSERT_NEAR( 1.0, dot( b1, b1 ), 2e-5 ) << n.x << " " << n.y << " " << n.z;
+    ASSERT_NEAR( 1.0, dot( b2, b2 ), 2e-5 ) << n.x << " " << n.y << " " << n.z;
+    ASSERT_NEAR( 0.0, dot( b1, b2 ), 2e-5 ) << n.x << " " << n.y << " " << n.z;
+    ASSERT_NEAR( 0.0, dot( b1, n ),  2e-5 ) << n.x << " " << n.y << " " << n.z;
+    ASSERT_NEAR( 0.0, dot( b2, n ),  2e-5 ) << n.x << " " << n.y << " " << n.z;
+
+    // right handed, so +z samples land on the normal
+    Vector cross = { b1.y * b2.z - b1.z * b2.y, b1.z * b2.x - b1.x * b2.z, b1.x * b2.y - b1.y * b2.x };
+    ASSERT_NEAR( 1.0, dot( cross, n ), 2e-5 );
+
+    Vector up = alignToNormal( Vector{ 0.0f, 0.0f, 1.0f }, n );
+    ASSERT_NEAR( 1.0, dot( up, n ), 1e-6 );
+
+  }
+
+}
+
+
+
+TEST( SamplingUnitTests, UniformSphereFollowsTheMatlabMapping )
+{
+
+  Uniform reference( 3u );
+  Uniform ours( 3u );
+
+  for ( int i = 0; i < 100000; ++i )
+  {
+
+    Vector expected = referenceSphere( reference );
+
+    float  u1     = ours( );
+    float  u2     = ours( );
+    Vector sample = sampleUniformSphere< Vector >( u1, u2 );
+
+    ASSERT_NEAR( expected.x, sample.x, 1e-6f ) << u1 << " " << u2;
+    ASSERT_NEAR( expected.y, sample.y, 1e-6f ) << u1 << " " << u2;
+    ASSERT_NEAR( expected.z, sample.z, 1e-6f ) << u1 << " " << u2;
+
+  }
+
+  EXPECT_FLOAT_EQ( static_cast< float >( 0.25 / pi ), uniformSpherePdf( ) );
+
+}
+
+
+
+TEST( SamplingUnitTests, ConeMatchesRejectionSamplingOfTheReference )
+{
+
+  constexpr int samples = 200000;
+  constexpr int bins    = 10;
+
+  // the setup of sampleTests.m
+  Vector point  = { 1.5f, 0.0f, 0.0f };
+  Vector axis   = normalized( -point.x, -point.y, -point.z );
+  float  cosMax = static_cast< float >( std::cos( std::asin( 1.0 / 1.5 ) ) );
+
+  Vector b1, b2;
+  orthonormalBasis( axis, b1, b2 );
+
+  std::vector< double > referenceCos, referenceAngle, cos, angle;
+
+  Uniform rand( 11u );
+
+  for ( int i = 0; i < samples; ++i )
+  {
+
+    Vector expected = referenceSolidAngle( rand, point );
+    Vector sample   = alignToNormal( sampleUniformCone< Vector >( rand( ), rand( ), cosMax ), axis );
+
+    referenceCos.push_back( dot( expected, axis ) );
+    referenceAngle.push_back( std::atan2( dot( expected, b2 ), dot( expected, b1 ) ) );
+
+    cos.push_back( dot( sample, axis ) );
+    angle.push_back( std::atan2( dot( sample, b2 ), dot( sample, b1 ) ) );
+
+  }
+
+  std::vector< double > expectedCos   = binFractions( referenceCos, bins, cosMax, 1.0 );
+  std::vector< double > expectedAngle = binFractions( referenceAngle, bins, -pi, pi );
+  std::vector< double > actualCos     = binFractions( cos, bins, cosMax, 1.0 );
+  std::vector< double > actualAngle   = binFractions( angle, bins, -pi, pi );
+
+  // about five standard deviations of the difference of two bins
+  for ( int bin = 0; bin < bins; ++bin )
+  {
+
+    EXPECT_NEAR( expectedCos[ bin ],   actualCos[ bin ],   0.005 ) << "height bin " << bin;
+    EXPECT_NEAR( expectedAngle[ bin ], actualAngle[ bin ], 0.005 ) << "angle bin " << bin;
+
+  }
+
+  EXPECT_NEAR( 1.0 / ( 2.0 * pi * ( 1.0 - cosMax ) ), uniformConePdf( cosMax ), 1e-6 );
+
+}
+
+
+
+TEST( SamplingUnitTests, CosineHemisphereIntegratesLikeTheHalfSphereReference )
+{
+
+  constexpr int samples = 200000;
+
+  // the normal of sampleTests.m
+  Vector normal = normalized( 1.0, 1.0, 1.0 );
+
+  Vector tangent, bitangent;
+  orthonormalBasis( normal, tangent, bitangent );
+
+  // integral of ( w . tangent )^2 cos( theta ) over the hemisphere
+  const double expected = pi / 4.0;
+
+  double cosineSum    = 0.0;
+  double referenceSum = 0.0;
+
+  Uniform rand( 5u );
+
+  for ( int i = 0; i < samples; ++i )
+  {
+
+    Vector local = sampleCosineHemisphere< Vector >( rand( ), rand( ) );
+    Vector w     = alignToNormal( local, normal );
+
+    ASSERT_NEAR( 1.0, dot( w, w ), 1e-5 );
+    ASSERT_GE( dot( w, normal ), -1e-6 );
+
+    cosineSum += dot( w, tangent ) * dot( w, tangent ) * local.z / cosineHemispherePdf( local.z );
+
+    Vector r = referenceHalfSphere( rand, normal );
+    referenceSum += dot( r, tangent ) * dot( r, tangent ) * dot( r, normal ) * 2.0 * pi;
+
+  }
+
+  EXPECT_NEAR( expected, referenceSum / samples, 0.01 );
+  EXPECT_NEAR( expected, cosineSum / samples,    0.005 ); // lower variance than the reference
+
+  // area preserving disk: cos^2( theta ) is uniform, which a
+  // stratified grid shows almost exactly
+  constexpr int grid = 512;
+  constexpr int bins = 10;
+
+  std::vector< double > cos2;
+
+  for ( int i = 0; i < grid; ++i )
+  {
+
+    for ( int j = 0; j < grid; ++j )
+    {
+
+      Vector v = sampleCosineHemisphere< Vector >( ( i + 0.5f ) / grid, ( j + 0.5f ) / grid );
+      cos2.push_back( static_cast< double >( v.z ) * v.z );
+
+    }
+
+  }
+
+  for ( double fraction : binFractions( cos2, bins, 0.0, 1.0 ) )
+  {
+    EXPECT_NEAR( 1.0 / bins, fraction, 0.002 );
+  }
+
+}
+
+
+
+TEST( SamplingUnitTests, GgxVndfFollowsItsPdf )
+{
+
+  constexpr int grid = 400;
+  constexpr int bins = 8;
+
+  for ( float alpha : { 0.1f, 0.5f, 1.0f } )
+  {
+
+    // D is normalized over projected solid angle; check with the
+    // half sphere reference where it isn't too peaked
+    if ( alpha >= 0.5f )
+    {
+
+      Uniform rand( 13u );
+      Vector  up  = { 0.0f, 0.0f, 1.0f };
+      double  sum = 0.0;
+
+      for ( int i = 0; i < 200000; ++i )
+      {
+
+        Vector h = referenceHalfSphere( rand, up );
+        sum += ggxD( h.z, alpha ) * h.z * 2.0 * pi;
+
+      }
+
+      EXPECT_NEAR( 1.0, sum / 200000, 0.02 ) << "alpha " << alpha;
+
+    }
+
+    for ( float cosNV : { 0.95f, 0.4f } )
+    {
+
+      Vector v = { std::sqrt( 1.0f - cosNV * cosNV ), 0.0f, cosNV };
+
+      // sampled heights of h from a stratified grid
+      std::vector< double > heights;
+
+      for ( int i = 0; i < grid; ++i )
+      {
+
+        for ( int j = 0; j < grid; ++j )
+        {
+
+          Vector h = sampleGgxVndf( v, alpha, ( i + 0.5f ) / grid, ( j + 0.5f ) / grid );
+
+          ASSERT_NEAR( 1.0, dot( h, h ), 1e-5 );
+          heights.push_back( h.z );
+
+        }
+
+      }
+
+      // the pdf integrated over the same bins in ( cos( theta ), phi )
+      std::vector< double > expected( bins, 0.0 );
+      double                total = 0.0;
+
+      constexpr int heightSteps = 4000;
+      constexpr int angleSteps  = 256;
+
+      for ( int i = 0; i < heightSteps; ++i )
+      {
+
+        double cosTheta = ( i + 0.5 ) / heightSteps;
+        double sinTheta = std::sqrt( 1.0 - cosTheta * cosTheta );
+
+        for ( int j = 0; j < angleSteps; ++j )
+        {
+
+          double phi = 2.0 * pi * ( j + 0.5 ) / angleSteps;
+          Vector h   = { static_cast< float >( sinTheta * std::cos( phi ) ), static_cast< float >( sinTheta * std::sin( phi ) ), static_cast< float >( cosTheta ) };
+
+          double mass = ggxVndfPdf( cosNV, h.z, static_cast< float >( dot( v, h ) ), alpha )
+                        * ( 1.0 / heightSteps ) * ( 2.0 * pi / angleSteps );
+
+          expected[ std::min( static_cast< int >( cosTheta * bins ), bins - 1 ) ] += mass;
+          total += mass;
+
+        }
+
+      }
+
+      EXPECT_NEAR( 1.0, total, 0.01 ) << "alpha " << alpha << " cosNV " << cosNV;
+
+      std::vector< double > actual = binFractions( heights, bins, 0.0, 1.0 );
+
+      for ( int bin = 0; bin < bins; ++bin )
+      {
+        EXPECT_NEAR( expected[ bin ], actual[ bin ], 0.005 ) << "alpha " << alpha << " cosNV " << cosNV << " bin " << bin;
+      }
+
+    }
+
+  }
+
+}
+
+
+
+TEST( SamplingUnitTests, LaneVersionsMatchScalar )
+{
+
+  constexpr int N = 4;
+
+  Uniform rand( 17u );
+
+  for ( int round = 0; round < 1000; ++round )
+  {
+
+    float u1[ N ], u2[ N ], alpha[ N ], nx[ N ], ny[ N ], nz[ N ];
+
+    for ( int i = 0; i < N; ++i )
+    {
+
+      u1[ i ]    = rand( );
+      u2[ i ]    = rand( );
+      alpha[ i ] = 0.05f + rand( );
+
+      Vector n = referenceSphere( rand );
+      nx[ i ]  = n.x;
+      ny[ i ]  = n.y;
+      nz[ i ]  = std::abs( n.z ) + 0.1f; // views above the surface
+
+    }
+
+    simd::VFloat< N > vu1    = simd::VFloat< N >::load( u1 );
+    simd::VFloat< N > vu2    = simd::VFloat< N >::load( u2 );
+    simd::VFloat< N > valpha = simd::VFloat< N >::load( alpha );
+
+    simd::VVector3< N > n = { simd::VFloat< N >::load( nx ), simd::VFloat< N >::load( ny ), simd::VFloat< N >::load( nz ) };
+
+    simd::VVector3< N > cosine = simd::sampleCosineHemisphere( vu1, vu2 );
+    simd::VVector3< N > sphere = simd::sampleUniformSphere( vu1, vu2 );
+    simd::VVector3< N > ggx    = simd::sampleGgxVndf( n, valpha, vu1, vu2 );
+
+    for ( int i = 0; i < N; ++i )
+    {
+
+      Vector expectedCosine = sampleCosineHemisphere< Vector >( u1[ i ], u2[ i ] );
+      Vector expectedSphere = sampleUniformSphere< Vector >( u1[ i ], u2[ i ] );
+      Vector expectedGgx    = sampleGgxVndf( Vector{ nx[ i ], ny[ i ], nz[ i ] }, alpha[ i ], u1[ i ], u2[ i ] );
+
+      // fused multiply-adds round differently
+      ASSERT_NEAR( expectedCosine.x, cosine.x[ i ], 1e-5f );
+      ASSERT_NEAR( expectedCosine.z, cosine.z[ i ], 1e-5f );
+      ASSERT_NEAR( expectedSphere.y, sphere.y[ i ], 1e-5f );
+      ASSERT_NEAR( expectedGgx.x,    ggx.x[ i ],    5e-5f );
+      ASSERT_NEAR( expectedGgx.z,    ggx.z[ i ],    5e-5f );
+
+    }
+
+  }
+
+}
+
+
+
+TEST( SamplingUnitTests, EveryIsaBatchMatchesScalarSampling )
+{
+
+  // not a multiple of any width, so the partial vectors run
+  constexpr std::size_t count = 1003;
+
+  Uniform rand( 19u );
+
+  std::vector< float > u1( count ), u2( count ), cosMax( count ), alpha( count );
+  std::vector< float > nx( count ), ny( count ), nz( count ), vx( count ), vy( count ), vz( count );
+
+  for ( std::size_t i = 0; i < count; ++i )
+  {
+
+    u1[ i ]     = rand( );
+    u2[ i ]     = rand( );
+    cosMax[ i ] = rand( ) * 1.8f - 0.9f;
+    alpha[ i ]  = 0.02f + rand( );
+
+    Vector n = referenceSphere( rand );
+    Vector v = referenceHalfSphere( rand, n );
+
+    nx[ i ] = n.x; ny[ i ] = n.y; nz[ i ] = n.z;
+    vx[ i ] = v.x; vy[ i ] = v.y; vz[ i ] = v.z;
+
+  }
+
+  light::SimdConstVectors normals = { nx.data( ), ny.data( ), nz.data( ) };
+  light::SimdConstVectors views   = { vx.data( ), vy.data( ), vz.data( ) };
+
+  for ( light::SimdIsa isa : supportedIsas( ) )
+  {
+
+    const light::SimdKernels &kernels = light::getSimdKernels( isa );
+
+    std::vector< float > x( count ), y( count ), z( count ), pdf( count );
+    light::SimdVectors   out = { x.data( ), y.data( ), z.data( ) };
+
+    auto expectVectors = [ & ]( const char *pKernel, std::size_t i, const Vector &expected, float expectedPdf )
+    {
+
+      ASSERT_NEAR( expected.x, x[ i ], 1e-4f ) << light::toString( isa ) << " " << pKernel << " " << i;
+      ASSERT_NEAR( expected.y, y[ i ], 1e-4f ) << light::toString( isa ) << " " << pKernel << " " << i;
+      ASSERT_NEAR( expected.z, z[ i ], 1e-4f ) << light::toString( isa ) << " " << pKernel << " " << i;
+      // sharp GGX peaks magnify the rounding of the local frame
+      ASSERT_NEAR( expectedPdf, pdf[ i ], 1e-3f * std::max( 1.0f, expectedPdf ) ) << light::toString( isa ) << " " << pKernel << " " << i;
+
+    };
+
+    kernels.sampleCosineHemisphere( u1.data( ), u2.data( ), normals, count, out, pdf.data( ) );
+
+    for ( std::size_t i = 0; i < count; ++i )
+    {
+
+      Vector n     = { nx[ i ], ny[ i ], nz[ i ] };
+      Vector local = sampleCosineHemisphere< Vector >( u1[ i ], u2[ i ] );
+
+      expectVectors( "cosine", i, alignToNormal( local, n ), cosineHemispherePdf( local.z ) );
+
+    }
+
+    kernels.sampleUniformSphere( u1.data( ), u2.data( ), count, out );
+
+    for ( std::size_t i = 0; i < count; ++i )
+    {
+
+      pdf[ i ] = uniformSpherePdf( );
+      expectVectors( "sphere", i, sampleUniformSphere< Vector >( u1[ i ], u2[ i ] ), uniformSpherePdf( ) );
+
+    }
+
+    kernels.sampleUniformCone( u1.data( ), u2.data( ), cosMax.data( ), normals, count, out, pdf.data( ) );
+
+    for ( std::size_t i = 0; i < count; ++i )
+    {
+
+      Vector n = { nx[ i ], ny[ i ], nz[ i ] };
+
+      expectVectors(
+                    "cone",
+                    i,
+                    alignToNormal( sampleUniformCone< Vector >( u1[ i ], u2[ i ], cosMax[ i ] ), n ),
+                    uniformConePdf( cosMax[ i ] )
+                    );
+
+    }
+
+    kernels.sampleGgxVndf( u1.data( ), u2.data( ), alpha.data( ), normals, views, count, out, pdf.data( ) );
+
+    for ( std::size_t i = 0; i < count; ++i )
+    {
+
+      Vector n = { nx[ i ], ny[ i ], nz[ i ] };
+      Vector v = { vx[ i ], vy[ i ], vz[ i ] };
+
+      Vector b1, b2;
+      orthonormalBasis( n, b1, b2 );
+
+      Vector local = { static_cast< float >( dot( b1, v ) ), static_cast< float >( dot( b2, v ) ), static_cast< float >( dot( n, v ) ) };
+      Vector h     = sampleGgxVndf( local, alpha[ i ], u1[ i ], u2[ i ] );
+
+      expectVectors(
+                    "ggx",
+                    i,
+                    alignToNormal( h, n ),
+                    ggxVndfPdf( local.z, h.z, static_cast< float >( dot( local, h ) ), alpha[ i ] )
+                    );
+
+    }
+
+  }
+
+}
+
+
+} // namespace
@@ -0,0 +1,240 @@
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "gmock/gmock.h"
+#include "SceneDescription.hpp"
+#include "BuiltinScenes.hpp"
+#include "ObjLoader.hpp"
+
+
+namespace
+{
+
+
+///
+/// \brief expectNear
+///
+void
+expectNear(
+           light::Float3 expected,
+           light::Float3 actual
+           )
+{
+
+  EXPECT_NEAR( expected.x, actual.x, 1e-5f );
+  EXPECT_NEAR( expected.y, actual.y, 1e-5f );
+  EXPECT_NEAR( expected.z, actual.z, 1e-5f );
+
+}
+
+
+
+//////////////////////////////////////////////////////////
+// built in scenes are internally consistent and shapes
+// share the primitives they were built from
+//////////////////////////////////////////////////////////
+TEST( SceneDescriptionUnitTests, BuiltinScenesValidate )
+{
+
+  light::SceneDescription basic    = light::buildBasicScene( );
+  light::SceneDescription advanced = light::buildAdvancedScene( );
+
+  EXPECT_NO_THROW( basic.validate( ) );
+  EXPECT_NO_THROW( advanced.validate( ) );
+
+  EXPECT_EQ( 3u,  basic.getPrimitives( ).size( ) );
+  EXPECT_EQ( 4u,  basic.getShapes( ).size( ) );
+  EXPECT_EQ( 1u,  basic.getIlluminators( ).size( ) );
+  EXPECT_EQ( 3u,  advanced.getPrimitives( ).size( ) );
+  EXPECT_EQ( 11u, advanced.getShapes( ).size( ) );
+  EXPECT_EQ( 2u,  advanced.getIlluminators( ).size( ) );
+
+  EXPECT_NE( basic.getHash( ), advanced.getHash( ) );
+  EXPECT_EQ( basic.getHash( ), light::buildBasicScene( ).getHash( ) );
+
+}
+
+
+
+//////////////////////////////////////////////////////////
+// everything written comes back and matches the hash
+//////////////////////////////////////////////////////////
+TEST( SceneDescriptionUnitTests, SerializeRoundTrip )
+{
+
+  light::SceneDescription scene = light::buildAdvancedScene( );
+
+  scene.addShape(
+                 "triangle",
+                 {
+                   scene.addMesh(
+                                 { { 0.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f } },
+                                 { },
+                                 { 0, 1, 2 }
+                                 )
+                 },
+                 0,
+                 light::makeTransform( ),
+                 light::AccelHint::BVH
+                 );
+
+  light::SceneDescription copy = light::SceneDescription::deserialize( scene.serialize( ) );
+
+  EXPECT_EQ( scene.getHash( ), copy.getHash( ) );
+  EXPECT_THAT( copy.getShapeNames( ), ::testing::ContainerEq( scene.getShapeNames( ) ) );
+  EXPECT_EQ( scene.getTriangles( ), copy.getTriangles( ) );
+
+  std::string filename = "lightBenderSceneTest.lbscene";
+  scene.write( filename );
+
+  EXPECT_EQ( scene.getHash( ), light::SceneDescription::read( filename ).getHash( ) );
+
+  std::remove( filename.c_str( ) );
+
+}
+
+
+
+//////////////////////////////////////////////////////////
+// edits change the hash, corruption is rejected
+//////////////////////////////////////////////////////////
+TEST( SceneDescriptionUnitTests, HashTracksEditsAndCorruption )
+{
+
+  light::SceneDescription scene = light::buildBasicScene( );
+
+  std::uint64_t before = scene.getHash( );
+  scene.getMaterials( )[ 0 ].roughness = 0.9f;
+
+  EXPECT_NE( before, scene.getHash( ) );
+
+  std::vector< unsigned char > bytes = scene.serialize( );
+  bytes[ bytes.size( ) / 2 ] ^= 0x40;
+
+  EXPECT_THROW( light::SceneDescription::deserialize( bytes ), std::runtime_error );
+
+  bytes.resize( bytes.size( ) / 3 );
+  EXPECT_THROW( light::SceneDescription::deserialize( bytes ), std::runtime_error );
+
+  EXPECT_THROW( light::SceneDescription::deserialize( std::vector< unsigned char >( 64, 'x' ) ), std::runtime_error );
+
+}
+
+
+
+//////////////////////////////////////////////////////////
+// bad references and duplicate names are caught
+//////////////////////////////////////////////////////////
+TEST( SceneDescriptionUnitTests, ValidateRejectsBadIndices )
+{
+
+  light::SceneDescription badPrimitive;
+  badPrimitive.addMaterial( { 1.0f, 1.0f, 1.0f }, 0.5f, { 1.0f, 1.0f, 1.0f } );
+  badPrimitive.addShape( "shape", { 7 }, 0, light::makeTransform( ) );
+
+  EXPECT_THROW( badPrimitive.validate( ), std::runtime_error );
+
+  light::SceneDescription duplicate;
+  std::uint32_t sphere   = duplicate.addSphere( );
+  std::uint32_t material = duplicate.addMaterial( { 1.0f, 1.0f, 1.0f }, 0.5f, { 1.0f, 1.0f, 1.0f } );
+  duplicate.addShape( "shape", { sphere }, material, light::makeTransform( ) );
+  duplicate.addShape( "shape", { sphere }, material, light::makeTransform( ) );
+
+  EXPECT_THROW( duplicate.validate( ), std::runtime_error );
+
+  light::SceneDescription mesh;
+  EXPECT_THROW( mesh.addMesh( { { 0.0f, 0.0f, 0.0f } }, { }, { 0, 0, 1 } ), std::runtime_error );
+
+}
+
+
+
+//////////////////////////////////////////////////////////
+// transforms apply scale, then rotation, then translation
+//////////////////////////////////////////////////////////
+TEST( SceneDescriptionUnitTests, TransformOrder )
+{
+
+  light::Transform transform = light::makeTransform(
+                                                    { 1.0f, 2.0f, 3.0f },
+                                                    { 2.0f, 2.0f, 2.0f },
+                                                    3.14159265f * 0.5f,
+                                                    { 0.0f, 0.0f, 1.0f }
+                                                    );
+
+  // x axis scaled to 2 then rotated onto y
+  expectNear( { 1.0f, 4.0f, 3.0f }, light::transformPoint( transform, { 1.0f, 0.0f, 0.0f } ) );
+  expectNear( { 1.0f, 2.0f, 3.0f }, light::transformPoint( transform, { 0.0f, 0.0f, 0.0f } ) );
+
+}
+
+
+
+//////////////////////////////////////////////////////////
+// sphere lights get an emitting material sized to the light
+//////////////////////////////////////////////////////////
+TEST( SceneDescriptionUnitTests, SphereIlluminatorEmission )
+{
+
+  light::SceneDescription scene;
+  std::uint32_t sphere = scene.addSphere( );
+
+  light::IlluminatorRecord illuminator = { { 0.0f, 5.0f, 0.0f }, { 100.0f, 100.0f, 100.0f }, 0, 2.0f };
+  std::uint32_t shape = scene.addSphereIlluminator( "light", illuminator, sphere );
+
+  const light::ShapeRecord &record = scene.getShapes( )[ shape ];
+  const light::MaterialRecord &material = scene.getMaterials( )[ record.material ];
+
+  float area = 3.14159265f * 4.0f * 4.0f;
+
+  EXPECT_EQ( 0, record.illuminator );
+  EXPECT_TRUE( light::isEmissive( material ) );
+  EXPECT_NEAR( 100.0f / ( 3.14159265f * area ), material.emission.x, 1e-5f );
+
+  // unit sphere scaled to the light radius around its center
+  expectNear(
+             { 2.0f, 5.0f, 0.0f },
+             light::transformPoint( scene.getTransforms( )[ record.transform ], { 1.0f, 0.0f, 0.0f } )
+             );
+
+}
+
+
+
+//////////////////////////////////////////////////////////
+// OBJ faces are triangulated and corners are shared
+//////////////////////////////////////////////////////////
+TEST( SceneDescriptionUnitTests, ObjQuadWithNormals )
+{
+
+  light::ObjMesh mesh = light::parseObjMesh(
+                                            "# unit quad\n"
+                                            "v 0 0 0\n"
+                                            "v 1 0 0\n"
+                                            "v 1 1 0\n"
+                                            "v 0 1 0\n"
+                                            "vt 0 0\n"
+                                            "vn 0 0 1\n"
+                                            "usemtl ignored\n"
+                                            "f 1/1/1 2/1/1 3/1/1 -1/1/-1\n"
+                                            );
+
+  EXPECT_EQ( 4u, mesh.vertices.size( ) );
+  EXPECT_EQ( 4u, mesh.normals.size( ) );
+  EXPECT_THAT( mesh.triangles, ::testing::ElementsAre( 0, 1, 2, 0, 2, 3 ) );
+
+  expectNear( { 0.0f, 1.0f, 0.0f }, mesh.vertices[ 3 ] );
+
+  light::ObjMesh noNormals = light::parseObjMesh( "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 3\n" );
+
+  EXPECT_TRUE( noNormals.normals.empty( ) );
+  EXPECT_THAT( noNormals.triangles, ::testing::ElementsAre( 0, 1, 2 ) );
+
+  EXPECT_THROW( light::parseObjMesh( "v 0 0 0\nf 1 2 3\n" ), std::runtime_error );
+
+}
+
+
+
+} // namespace
@@ -0,0 +1,134 @@
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "gmock/gmock.h"
+#include "SceneEditor.hpp"
+#include "BuiltinScenes.hpp"
+
+
+namespace
+{
+
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+
+
+
+//////////////////////////////////////////////////////////
+// only edited records are reported, once, in index order
+//////////////////////////////////////////////////////////
+TEST( SceneEditorUnitTests, MarksOnlyEditedRecords )
+{
+
+  light::SceneDescription scene = light::buildAdvancedScene( );
+  light::SceneEditor editor( &scene );
+
+  EXPECT_FALSE( editor.hasChanges( ) );
+
+  light::MaterialRecord material = scene.getMaterials( )[ 3 ];
+  material.roughness = 0.75f;
+
+  editor.setMaterial( 3, material );
+  editor.setMaterial( 3, material ); // marked once
+  editor.setMaterial( 1, scene.getMaterials( )[ 1 ] ); // unchanged, not marked
+
+  light::Transform moved = light::makeTransform( { 1.0f, 2.0f, 3.0f } );
+
+  editor.setTransform( 5, moved );
+  editor.setTransform( 2, moved );
+
+  ASSERT_TRUE( editor.hasChanges( ) );
+
+  light::SceneChanges changes = editor.takeChanges( );
+
+  EXPECT_THAT( changes.materials,    ElementsAre( 3u ) );
+  EXPECT_THAT( changes.transforms,   ElementsAre( 2u, 5u ) );
+  EXPECT_THAT( changes.illuminators, IsEmpty( ) );
+
+  EXPECT_FLOAT_EQ( 0.75f, scene.getMaterials( )[ 3 ].roughness );
+  EXPECT_FLOAT_EQ( 3.0f,  scene.getTransforms( )[ 5 ].m[ 11 ] );
+
+  // taking clears the batch but not the edits
+  EXPECT_FALSE( editor.hasChanges( ) );
+  EXPECT_TRUE( editor.takeChanges( ).empty( ) );
+
+  editor.setMaterial( 3, material );
+  EXPECT_FALSE( editor.hasChanges( ) );
+
+  material.roughness = 0.5f;
+  editor.setMaterial( 3, material );
+  EXPECT_THAT( editor.takeChanges( ).materials, ElementsAre( 3u ) );
+
+}
+
+
+
+//////////////////////////////////////////////////////////
+// light edits keep the emitting shape's material and
+// transform in step
+//////////////////////////////////////////////////////////
+TEST( SceneEditorUnitTests, IlluminatorEditsFollowShape )
+{
+
+  light::SceneDescription scene = light::buildBasicScene( );
+  light::SceneEditor editor( &scene );
+
+  const light::ShapeRecord &shape = scene.getShapes( ).back( );
+  ASSERT_EQ( 0, shape.illuminator );
+
+  light::IlluminatorRecord illuminator = scene.getIlluminators( )[ 0 ];
+  illuminator.radiantFlux = light::Float3 { 500.0f, 250.0f, 100.0f };
+
+  editor.setIlluminator( 0, illuminator );
+
+  light::SceneChanges changes = editor.takeChanges( );
+
+  EXPECT_THAT( changes.illuminators, ElementsAre( 0u ) );
+  EXPECT_THAT( changes.materials,    ElementsAre( shape.material ) );
+  EXPECT_THAT( changes.transforms,   IsEmpty( ) ); // size and position didn't move
+
+  light::Float3 emission = light::getSphereEmission( illuminator );
+
+  EXPECT_FLOAT_EQ( emission.x, scene.getMaterials( )[ shape.material ].emission.x );
+  EXPECT_FLOAT_EQ( emission.z, scene.getMaterials( )[ shape.material ].emission.z );
+
+  illuminator.center = light::Float3 { 0.0f, 8.0f, 0.0f };
+  editor.setIlluminator( 0, illuminator );
+
+  changes = editor.takeChanges( );
+
+  EXPECT_THAT( changes.transforms, ElementsAre( shape.transform ) );
+  EXPECT_THAT( changes.materials,  IsEmpty( ) );
+  EXPECT_FLOAT_EQ( 8.0f, scene.getTransforms( )[ shape.transform ].m[ 7 ] );
+
+  // the edited description is still consistent
+  EXPECT_NO_THROW( scene.validate( ) );
+
+}
+
+
+
+//////////////////////////////////////////////////////////
+// bad indices are rejected without marking anything
+//////////////////////////////////////////////////////////
+TEST( SceneEditorUnitTests, RejectsBadIndices )
+{
+
+  light::SceneDescription scene = light::buildBasicScene( );
+  light::SceneEditor editor( &scene );
+
+  std::uint32_t materialCount = static_cast< std::uint32_t >( scene.getMaterials( ).size( ) );
+
+  EXPECT_THROW( editor.setMaterial( materialCount, light::MaterialRecord( ) ), std::runtime_error );
+  EXPECT_THROW( editor.setIlluminator( 1, light::IlluminatorRecord( ) ),       std::runtime_error );
+  EXPECT_THROW( editor.setTransform( 100, light::makeTransform( ) ),           std::runtime_error );
+  EXPECT_THROW( light::SceneEditor( nullptr ),                                 std::runtime_error );
+
+  EXPECT_FALSE( editor.hasChanges( ) );
+
+}
+
+
+
+} // namespace
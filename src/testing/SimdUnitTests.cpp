@@ -0,0 +1,249 @@
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <cstdlib>
+#include <cstdint>
+#include <stdexcept>
+#include "gmock/gmock.h"
+#include "Simd.hpp"
+#include "SimdKernels.hpp"
+
+
+namespace
+{
+
+
+namespace simd = light::LIGHT_SIMD_NAMESPACE;
+
+
+///
+/// \brief makeValues
+/// \return RGBA values in about [-0.5, 1.5], so conversions
+///         clamp at both ends
+///
+std::vector< float >
+makeValues(
+           std::size_t   count,
+           std::uint32_t seed
+           )
+{
+
+  std::vector< float > values( count );
+
+  for ( float &value : values )
+  {
+
+    seed  = seed * 1664525u + 1013904223u;
+    value = static_cast< float >( seed >> 8 ) / 16777216.0f * 2.0f - 0.5f;
+
+  }
+
+  return values;
+
+}
+
+
+std::vector< light::SimdIsa >
+supportedIsas( )
+{
+
+  std::vector< light::SimdIsa > isas;
+
+  for ( int i = 0; i <= static_cast< int >( light::SimdIsa::AVX512 ); ++i )
+  {
+
+    if ( light::isSimdIsaSupported( static_cast< light::SimdIsa >( i ) ) )
+    {
+      isas.push_back( static_cast< light::SimdIsa >( i ) );
+    }
+
+  }
+
+  return isas;
+
+}
+
+
+///
+/// \brief checkVectorOperations
+///
+///        Lane semantics every width has to share
+///
+template< int N >
+void
+checkVectorOperations( )
+{
+
+  typedef simd::VFloat< N > F;
+  typedef simd::VInt< N >   I;
+
+  float a[ N ], b[ N ];
+
+  for ( int i = 0; i < N; ++i )
+  {
+
+    a[ i ] = static_cast< float >( i ) - 2.75f;
+    b[ i ] = static_cast< float >( N - i ) * 0.5f;
+
+  }
+
+  a[ N - 1 ] = std::numeric_limits< float >::quiet_NaN( );
+
+  F x = F::load( a );
+  F y = F::load( b );
+
+  F  sum     = x + y;
+  F  product = simd::fmadd( x, y, F( 1.0f ) );
+  F  low     = simd::min( x, y );
+  F  picked  = simd::select( x < y, x, y );
+  I  rounded = simd::toInt( x );
+  I  floors  = simd::toInt( simd::floor( x ) );
+  F  root    = simd::sqrt( simd::abs( y ) );
+  I  shifted = ( I::sequence( ) - I( 1 ) ) >> 28;
+
+  for ( int i = 0; i < N - 1; ++i )
+  {
+
+    EXPECT_FLOAT_EQ( a[ i ] + b[ i ], sum[ i ] );
+    EXPECT_FLOAT_EQ( a[ i ] * b[ i ] + 1.0f, product[ i ] );
+    EXPECT_FLOAT_EQ( std::min( a[ i ], b[ i ] ), low[ i ] );
+    EXPECT_FLOAT_EQ( std::min( a[ i ], b[ i ] ), picked[ i ] );
+    EXPECT_EQ      ( static_cast< std::int32_t >( a[ i ] ), rounded[ i ] );
+    EXPECT_EQ      ( static_cast< std::int32_t >( std::floor( a[ i ] ) ), floors[ i ] );
+    EXPECT_FLOAT_EQ( std::sqrt( b[ i ] ), root[ i ] );
+
+  }
+
+  // NaN picks the second argument, like minps
+  EXPECT_FLOAT_EQ( b[ N - 1 ], low[ N - 1 ] );
+
+  // shifts are logical: -1 >> 28 is 15
+  EXPECT_EQ( 15, shifted[ 0 ] );
+  EXPECT_EQ( 0,  shifted[ 1 ] );
+
+  simd::VMask< N > negative = x < F( 0.0f );
+
+  EXPECT_EQ( 0x7u, simd::bits( negative ) );
+  EXPECT_TRUE( simd::any( negative ) );
+  EXPECT_FALSE( simd::all( negative ) );
+  EXPECT_TRUE( simd::all( negative | !negative ) );
+  EXPECT_TRUE( simd::none( negative & !negative ) );
+
+  // bit casts round trip and expose the sign bit
+  I bitsOfY = simd::asInt( -y );
+
+  EXPECT_FLOAT_EQ( b[ 0 ], simd::asFloat( bitsOfY ^ I( static_cast< std::int32_t >( 0x80000000u ) ) )[ 0 ] );
+
+  float partial[ N ];
+  simd::storePartial( simd::loadPartial< N >( b, 1, 7.0f ), partial, N );
+
+  EXPECT_FLOAT_EQ( b[ 0 ], partial[ 0 ] );
+  EXPECT_FLOAT_EQ( 7.0f, partial[ N - 1 ] );
+
+}
+
+
+
+TEST( SimdUnitTests, VectorOperationsAgreeAcrossWidths )
+{
+
+  checkVectorOperations< 4 >( );
+  checkVectorOperations< 8 >( );
+  checkVectorOperations< 16 >( );
+
+}
+
+
+
+TEST( SimdUnitTests, IsaNamesAndForcing )
+{
+
+  for ( int i = 0; i <= static_cast< int >( light::SimdIsa::AVX512 ); ++i )
+  {
+
+    light::SimdIsa isa = static_cast< light::SimdIsa >( i );
+    EXPECT_EQ( isa, light::parseSimdIsa( light::toString( isa ) ) );
+
+  }
+
+  EXPECT_THROW( light::parseSimdIsa( "neon" ), std::runtime_error );
+  EXPECT_EQ( 8u, light::getSimdWidth( light::SimdIsa::AVX2 ) );
+  EXPECT_TRUE( light::isSimdIsaSupported( light::SimdIsa::SCALAR ) );
+
+  light::forceSimdIsa( light::SimdIsa::SCALAR );
+  EXPECT_EQ( light::SimdIsa::SCALAR, light::getSimdIsa( ) );
+  EXPECT_EQ( light::SimdIsa::SCALAR, light::getSimdKernels( ).isa );
+
+  light::clearForcedSimdIsa( );
+
+  // a preference gives way to forcing and to LIGHT_SIMD
+  light::preferSimdIsa( light::SimdIsa::SCALAR );
+  light::forceSimdIsa( light::detectSimdIsa( ) );
+  EXPECT_EQ( light::detectSimdIsa( ), light::getSimdIsa( ) );
+
+  light::clearForcedSimdIsa( );
+
+  if ( !std::getenv( "LIGHT_SIMD" ) )
+  {
+    EXPECT_EQ( light::SimdIsa::SCALAR, light::getSimdIsa( ) );
+  }
+
+  light::clearPreferredSimdIsa( );
+
+  if ( light::detectSimdIsa( ) != light::SimdIsa::AVX512 )
+  {
+
+    EXPECT_THROW( light::forceSimdIsa( light::SimdIsa::AVX512 ),    std::runtime_error );
+    EXPECT_THROW( light::getSimdKernels( light::SimdIsa::AVX512 ), std::runtime_error );
+
+  }
+
+}
+
+
+
+TEST( SimdUnitTests, EverySupportedIsaMatchesTheScalarKernels )
+{
+
+  const light::SimdKernels &scalar = light::getSimdKernels( light::SimdIsa::SCALAR );
+
+  // odd pixel counts exercise the partial vectors at row ends
+  for ( std::size_t pixels : { std::size_t( 1 ), std::size_t( 3 ), std::size_t( 5 ), std::size_t( 37 ), std::size_t( 640 ) } )
+  {
+
+    std::vector< float > test      = makeValues( pixels * 4, 7u );
+    std::vector< float > reference = makeValues( pixels * 4, 11u );
+
+    std::vector< std::uint8_t > expectedBytes( pixels * 3 );
+    scalar.rgbaToRgb8( test.data( ), pixels, expectedBytes.data( ) );
+
+    float expectedSquared, expectedRelative;
+    scalar.squaredErrors( test.data( ), reference.data( ), pixels, 0.01f, &expectedSquared, &expectedRelative );
+
+    for ( light::SimdIsa isa : supportedIsas( ) )
+    {
+
+      const light::SimdKernels &kernels = light::getSimdKernels( isa );
+      EXPECT_EQ( isa, kernels.isa );
+
+      std::vector< std::uint8_t > bytes( pixels * 3 + 1, 42u );
+      kernels.rgbaToRgb8( test.data( ), pixels, bytes.data( ) );
+
+      EXPECT_EQ( 42u, bytes.back( ) ) << light::toString( isa ) << " wrote past the end";
+      bytes.pop_back( );
+      EXPECT_EQ( expectedBytes, bytes ) << light::toString( isa ) << ", " << pixels << " pixels";
+
+      float squared, relative;
+      kernels.squaredErrors( test.data( ), reference.data( ), pixels, 0.01f, &squared, &relative );
+
+      EXPECT_NEAR( expectedSquared,  squared,  expectedSquared * 1e-5f )  << light::toString( isa );
+      EXPECT_NEAR( expectedRelative, relative, expectedRelative * 1e-5f ) << light::toString( isa );
+
+    }
+
+  }
+
+}
+
+
+} // namespace
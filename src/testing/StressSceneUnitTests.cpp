@@ -0,0 +1,105 @@
+#include <stdexcept>
+#include "gmock/gmock.h"
+#include "StressScene.hpp"
+#include "HostScene.hpp"
+
+
+namespace
+{
+
+
+light::StressSceneOptions
+smallOptions( )
+{
+
+  light::StressSceneOptions options;
+
+  options.spheres       = 30;
+  options.boxes         = 20;
+  options.quads         = 10;
+  options.meshInstances = 5;
+  options.meshRings     = 4;
+  options.illuminators  = 3;
+  options.materials     = 4;
+  options.seed          = 11;
+
+  return options;
+
+}
+
+
+
+TEST( StressSceneUnitTests, SameSeedGivesSameScene )
+{
+
+  light::StressSceneOptions options = smallOptions( );
+
+  std::uint64_t hash = light::buildStressScene( options ).getHash( );
+
+  EXPECT_EQ( hash, light::buildStressScene( options ).getHash( ) );
+
+  options.seed += 1;
+  EXPECT_NE( hash, light::buildStressScene( options ).getHash( ) );
+
+}
+
+
+
+TEST( StressSceneUnitTests, SceneHasTheRequestedObjects )
+{
+
+  light::StressSceneOptions options = smallOptions( );
+  light::SceneDescription   scene   = light::buildStressScene( options );
+
+  EXPECT_NO_THROW( scene.validate( ) );
+  EXPECT_EQ( options.illuminators, scene.getIlluminators( ).size( ) );
+
+  unsigned primitives = 0;
+  unsigned lights     = 0;
+
+  for ( const light::ShapeRecord &shape : scene.getShapes( ) )
+  {
+
+    if ( shape.illuminator >= 0 )
+    {
+      ++lights;
+    }
+    else
+    {
+      primitives += shape.primitiveCount;
+    }
+
+  }
+
+  // every instance references the one mesh, plus the ground
+  EXPECT_EQ( options.illuminators, lights );
+  EXPECT_EQ( options.spheres + options.boxes + options.quads + options.meshInstances + 1, primitives );
+
+  light::HostScene hostScene( scene );
+  EXPECT_GT( hostScene.getAccelerationBytes( ), 0u );
+
+}
+
+
+
+TEST( StressSceneUnitTests, ParsesOptionSpecs )
+{
+
+  light::StressSceneOptions options = light::parseStressSceneOptions( "spheres=1000,illuminators=16,seed=7,mesh=ship.obj" );
+
+  EXPECT_EQ( 1000u, options.spheres );
+  EXPECT_EQ( 16u,   options.illuminators );
+  EXPECT_EQ( 7u,    options.seed );
+  EXPECT_EQ( "ship.obj", options.meshFile );
+  EXPECT_EQ( light::StressSceneOptions( ).boxes, options.boxes );
+
+  EXPECT_EQ( light::StressSceneOptions( ).spheres, light::parseStressSceneOptions( "" ).spheres );
+
+  EXPECT_THROW( light::parseStressSceneOptions( "spheres" ),      std::runtime_error );
+  EXPECT_THROW( light::parseStressSceneOptions( "teapots=3" ),    std::runtime_error );
+  EXPECT_THROW( light::parseStressSceneOptions( "spheres=many" ), std::runtime_error );
+
+}
+
+
+} // namespace
@@ -0,0 +1,193 @@
+#include <vector>
+#include <cstdlib>
+#include <atomic>
+#include "gmock/gmock.h"
+#include "TileScheduler.hpp"
+#include "TiledFramebuffer.hpp"
+
+
+namespace
+{
+
+
+class TileSchedulerUnitTests : public ::testing::TestWithParam< light::TileOrder >
+{
+
+protected:
+
+  ///
+  /// \brief countPixelVisits
+  /// \return number of times each pixel is covered by a tile
+  ///
+  static
+  std::vector< unsigned >
+  countPixelVisits( const light::TileScheduler &scheduler )
+  {
+
+    std::vector< unsigned > visits( scheduler.getWidth( ) * scheduler.getHeight( ), 0 );
+
+    for ( const light::Tile &tile : scheduler.getTiles( ) )
+    {
+
+      for ( unsigned y = tile.y; y < tile.y + tile.height; ++y )
+      {
+
+        for ( unsigned x = tile.x; x < tile.x + tile.width; ++x )
+        {
+
+          ++visits[ y * scheduler.getWidth( ) + x ];
+
+        }
+
+      }
+
+    }
+
+    return visits;
+
+  }
+
+};
+
+
+
+//////////////////////////////////////////////////////////
+// every pixel belongs to exactly one tile for any order,
+// including images that aren't a multiple of the tile size
+//////////////////////////////////////////////////////////
+TEST_P( TileSchedulerUnitTests, TilesCoverImageOnce )
+{
+
+  using namespace ::testing;
+
+  light::TileScheduler scheduler( 37, 21, 8, GetParam( ), 7 );
+
+  EXPECT_EQ( 5u * 3u, scheduler.getTiles( ).size( ) );
+  EXPECT_THAT( countPixelVisits( scheduler ), Each( 1u ) );
+
+}
+
+
+
+//////////////////////////////////////////////////////////
+// nextTile hands out each tile once, even from several threads
+//////////////////////////////////////////////////////////
+TEST_P( TileSchedulerUnitTests, RunVisitsEveryTileOnce )
+{
+
+  using namespace ::testing;
+
+  light::TileScheduler scheduler( 64, 48, 16, GetParam( ) );
+
+  std::vector< std::atomic< unsigned > > counts( scheduler.getTiles( ).size( ) );
+
+  for ( std::atomic< unsigned > &count : counts )
+  {
+    count = 0;
+  }
+
+  scheduler.run( 4, [ &counts ]( const light::Tile &tile ) { ++counts[ tile.index ]; } );
+
+  for ( const std::atomic< unsigned > &count : counts )
+  {
+    EXPECT_EQ( 1u, count.load( ) );
+  }
+
+  EXPECT_GT( scheduler.getSecondsPerPixel( ), 0.0 );
+
+}
+
+
+INSTANTIATE_TEST_CASE_P(
+                        AllOrders,
+                        TileSchedulerUnitTests,
+                        ::testing::Values(
+                                          light::TileOrder::SCANLINE,
+                                          light::TileOrder::RANDOM,
+                                          light::TileOrder::MORTON,
+                                          light::TileOrder::HILBERT
+                                          )
+                        );
+
+
+
+//////////////////////////////////////////////////////////
+// consecutive tiles on a square power of two grid always
+// share an edge when following the Hilbert curve
+//////////////////////////////////////////////////////////
+TEST( TileSchedulerOrderTests, HilbertNeighboursShareEdge )
+{
+
+  light::TileScheduler scheduler( 128, 128, 8, light::TileOrder::HILBERT );
+
+  const std::vector< light::Tile > &tiles = scheduler.getTiles( );
+
+  for ( std::size_t i = 1; i < tiles.size( ); ++i )
+  {
+
+    int dx = std::abs( static_cast< int >( tiles[ i ].x ) - static_cast< int >( tiles[ i - 1 ].x ) );
+    int dy = std::abs( static_cast< int >( tiles[ i ].y ) - static_cast< int >( tiles[ i - 1 ].y ) );
+
+    EXPECT_EQ( 8, dx + dy ) << "tiles " << i - 1 << " and " << i << " are not adjacent";
+
+  }
+
+}
+
+
+
+//////////////////////////////////////////////////////////
+// tile size respects cache size and thread count
+//////////////////////////////////////////////////////////
+TEST( TileSchedulerOrderTests, ChooseTileSize )
+{
+
+  // 16 bytes per pixel: 32x32 tile = 16KB, fits in half of 64KB
+  EXPECT_EQ( 32u, light::TileScheduler::chooseTileSize( 4096, 4096, 1, 16, 64 * 1024 ) );
+
+  // many threads on a small image forces smaller tiles
+  EXPECT_EQ( 8u, light::TileScheduler::chooseTileSize( 64, 64, 64, 16, 64 * 1024 ) );
+
+  // very cheap pixels never grow past the cache limit
+  EXPECT_EQ( 32u, light::TileScheduler::chooseTileSize( 4096, 4096, 1, 16, 64 * 1024, 1.0e-9 ) );
+
+  // very expensive pixels shrink the tile
+  EXPECT_EQ( 8u, light::TileScheduler::chooseTileSize( 4096, 4096, 1, 16, 64 * 1024, 1.0e-3 ) );
+
+}
+
+
+
+//////////////////////////////////////////////////////////
+// tiled storage round trips through scanline order
+//////////////////////////////////////////////////////////
+TEST( TiledFramebufferTests, ScanlineRoundTrip )
+{
+
+  using namespace ::testing;
+
+  constexpr unsigned width  = 19;
+  constexpr unsigned height = 11;
+
+  std::vector< float > scanline( width * height * 2 );
+
+  for ( std::size_t i = 0; i < scanline.size( ); ++i )
+  {
+    scanline[ i ] = static_cast< float >( i );
+  }
+
+  light::TiledFramebuffer framebuffer( width, height, 4, 2 );
+  framebuffer.fromScanline( scanline );
+
+  EXPECT_EQ( scanline[ ( 5 * width + 13 ) * 2 + 1 ], framebuffer.getPixel( 13, 5 )[ 1 ] );
+
+  std::vector< float > result;
+  framebuffer.toScanline( &result );
+
+  EXPECT_THAT( result, ContainerEq( scanline ) );
+
+}
+
+
+
+} // namespace
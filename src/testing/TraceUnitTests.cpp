@@ -0,0 +1,123 @@
+#include <string>
+#include <thread>
+#include <vector>
+#include "gmock/gmock.h"
+#include "Trace.hpp"
+
+
+namespace
+{
+
+
+TEST( TraceUnitTests, ScopesPairUpPerThread )
+{
+
+  light::startTrace( );
+
+  std::thread worker( [ ]( )
+                      {
+
+                        light::TraceScope outer( "tile", "render" );
+                        light::TraceScope inner( "shade", "render" );
+
+                      } );
+
+  worker.join( );
+
+  {
+
+    light::TraceScope scope( "frame", "render" );
+
+  }
+
+  light::stopTrace( );
+
+  std::vector< light::TraceEvent > events = light::getTraceEvents( );
+
+  ASSERT_EQ( 6u, events.size( ) );
+
+  // the finished worker's events come first, each thread's in order
+  EXPECT_STREQ( "tile",  events[ 0 ].name );
+  EXPECT_EQ( 'B',        events[ 0 ].phase );
+  EXPECT_STREQ( "shade", events[ 1 ].name );
+  EXPECT_STREQ( "shade", events[ 2 ].name );
+  EXPECT_EQ( 'E',        events[ 2 ].phase );
+  EXPECT_STREQ( "tile",  events[ 3 ].name );
+  EXPECT_EQ( 'E',        events[ 3 ].phase );
+
+  EXPECT_EQ( events[ 0 ].thread, events[ 3 ].thread );
+  EXPECT_NE( events[ 0 ].thread, events[ 4 ].thread );
+  EXPECT_LE( events[ 0 ].nanoseconds, events[ 3 ].nanoseconds );
+  EXPECT_LE( events[ 4 ].nanoseconds, events[ 5 ].nanoseconds );
+
+}
+
+
+
+TEST( TraceUnitTests, NothingRecordedWhileStopped )
+{
+
+  light::startTrace( );
+  light::stopTrace( );
+
+  {
+
+    light::TraceScope scope( "frame", "render" );
+
+  }
+
+  EXPECT_TRUE( light::getTraceEvents( ).empty( ) );
+
+}
+
+
+
+TEST( TraceUnitTests, ScopeOpenAtStopStillEnds )
+{
+
+  light::startTrace( );
+
+  {
+
+    light::TraceScope scope( "setScene", "scene" );
+    light::stopTrace( );
+
+  }
+
+  std::vector< light::TraceEvent > events = light::getTraceEvents( );
+
+  ASSERT_EQ( 2u, events.size( ) );
+  EXPECT_EQ( 'B', events[ 0 ].phase );
+  EXPECT_EQ( 'E', events[ 1 ].phase );
+
+}
+
+
+
+TEST( TraceUnitTests, JsonUsesTraceEventFormat )
+{
+
+  light::setTraceThreadName( "main \"thread\"" );
+  light::startTrace( );
+
+  {
+
+    light::TraceScope scope( "meshLoad", "load" );
+
+  }
+
+  light::stopTrace( );
+
+  std::string json = light::toTraceJson( );
+
+  EXPECT_THAT( json, ::testing::HasSubstr( "\"traceEvents\": [" ) );
+  EXPECT_THAT( json, ::testing::HasSubstr( "\"name\": \"meshLoad\", \"cat\": \"load\", \"ph\": \"B\", \"ts\": " ) );
+  EXPECT_THAT( json, ::testing::HasSubstr( "\"ph\": \"E\"" ) );
+  EXPECT_THAT( json, ::testing::HasSubstr( "\"args\": { \"name\": \"main \\\"thread\\\"\" }" ) );
+  EXPECT_EQ( '{', json.front( ) );
+  EXPECT_EQ( "}\n", json.substr( json.size( ) - 2 ) );
+
+}
+
+
+} // namespace